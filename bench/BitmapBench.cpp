@@ -79,7 +79,6 @@ static void convertToIndex666(const SkBitmap& src, SkBitmap* dst) {
 
 class BitmapBench : public SkBenchmark {
     SkBitmap    fBitmap;
-    SkPaint     fPaint;
     bool        fIsOpaque;
     bool        fForceUpdate; //bitmap marked as dirty before each draw. forces bitmap to be updated on device cache
     int         fTileX, fTileY; // -1 means don't use shader
@@ -89,6 +88,8 @@ class BitmapBench : public SkBenchmark {
     enum { N = SkBENCHLOOP(300) };
     enum { W = 128 };
     enum { H = 128 };
+protected:
+    SkPaint     fPaint;
 public:
     BitmapBench(void* param, bool isOpaque, SkBitmap::Config c,
                 bool forceUpdate = false, bool bitmapVolatile = false,
@@ -200,16 +201,21 @@ class FilterBitmapBench : public BitmapBench {
     bool        fScale;
     bool        fRotate;
     bool        fFilter;
+    bool        fPerspective;
+    bool        fHighQuality;
     SkString    fFullName;
     enum { N = SkBENCHLOOP(300) };
 public:
     FilterBitmapBench(void* param, bool isOpaque, SkBitmap::Config c,
                 bool forceUpdate = false, bool bitmapVolatile = false,
                 int tx = -1, int ty = -1, bool addScale = false,
-                bool addRotate = false, bool addFilter = false)
+                bool addRotate = false, bool addFilter = false,
+                bool addPerspective = false, bool addHighQuality = false)
         : INHERITED(param, isOpaque, c, forceUpdate, bitmapVolatile, tx, ty)
-        , fScale(addScale), fRotate(addRotate), fFilter(addFilter) {
+        , fScale(addScale), fRotate(addRotate), fFilter(addFilter)
+        , fPerspective(addPerspective), fHighQuality(addHighQuality) {
 
+        fPaint.setHighQualityFilterBitmap(fHighQuality);
     }
 
 protected:
@@ -221,6 +227,10 @@ protected:
             fFullName.append("_rotate");
         if (fFilter)
             fFullName.append("_filter");
+        if (fPerspective)
+            fFullName.append("_persp");
+        if (fHighQuality)
+            fFullName.append("_highquality");
 
         return fFullName.c_str();
     }
@@ -244,6 +254,19 @@ protected:
             canvas->rotate(SkIntToScalar(35));
             canvas->translate(-x, -y);
         }
+        if (fPerspective) {
+            const SkScalar x = SkIntToScalar(dim.fWidth) / 2;
+            const SkScalar y = SkIntToScalar(dim.fHeight) / 2;
+
+            SkMatrix persp;
+            persp.setIdentity();
+            persp.setPerspX(SkScalarToPersp(SK_Scalar1 / 1000));
+            persp.setPerspY(SkScalarToPersp(SK_Scalar1 / 1500));
+
+            canvas->translate(x, y);
+            canvas->concat(persp);
+            canvas->translate(-x, -y);
+        }
 
         this->setForceFilter(fFilter);
         INHERITED::onDraw(canvas);
@@ -370,6 +393,14 @@ static SkBenchmark* Fact18(void* p) { return new SourceAlphaBitmapBench(p, Sourc
 static SkBenchmark* Fact19(void* p) { return new SourceAlphaBitmapBench(p, SourceAlphaBitmapBench::kTwoStripes_SourceAlpha, SkBitmap::kARGB_8888_Config); }
 static SkBenchmark* Fact20(void* p) { return new SourceAlphaBitmapBench(p, SourceAlphaBitmapBench::kThreeStripes_SourceAlpha, SkBitmap::kARGB_8888_Config); }
 
+// perspective -> ClampX_ClampY_{nofilter,filter}_persp_SSE2
+static SkBenchmark* Fact21(void* p) { return new FilterBitmapBench(p, true, SkBitmap::kARGB_8888_Config, false, false, -1, -1, false, false, false, true); }
+static SkBenchmark* Fact22(void* p) { return new FilterBitmapBench(p, true, SkBitmap::kARGB_8888_Config, false, false, -1, -1, false, false, true, true); }
+
+// high quality filter -> S32_D32_bicubic_shaderproc
+static SkBenchmark* Fact23(void* p) { return new FilterBitmapBench(p, true, SkBitmap::kARGB_8888_Config, false, false, -1, -1, true, false, true, false, true); }
+static SkBenchmark* Fact24(void* p) { return new FilterBitmapBench(p, true, SkBitmap::kARGB_8888_Config, false, false, -1, -1, true, true, true, false, true); }
+
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
 static BenchRegistry gReg2(Fact2);
@@ -394,3 +425,9 @@ static BenchRegistry gReg17(Fact17);
 static BenchRegistry gReg18(Fact18);
 static BenchRegistry gReg19(Fact19);
 static BenchRegistry gReg20(Fact20);
+
+static BenchRegistry gReg21(Fact21);
+static BenchRegistry gReg22(Fact22);
+
+static BenchRegistry gReg23(Fact23);
+static BenchRegistry gReg24(Fact24);
@@ -8,6 +8,7 @@
 #include "SkBenchmark.h"
 #include "SkBitmap.h"
 #include "SkImageDecoder.h"
+#include "SkStream.h"
 #include "SkString.h"
 
 static const char* gConfigName[] = {
@@ -53,6 +54,63 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+// Decodes the center quarter of the image through the tile index, which is
+// what a viewer does when it only needs the visible part of a large image.
+class DecodeRegionBench : public SkBenchmark {
+    const char* fFilename;
+    SkBitmap::Config fPrefConfig;
+    SkString fName;
+    enum { N = SkBENCHLOOP(10) };
+public:
+    DecodeRegionBench(void* param, SkBitmap::Config c) : SkBenchmark(param) {
+        fFilename = this->findDefine("decode-filename");
+        fPrefConfig = c;
+
+        const char* fname = NULL;
+        if (fFilename) {
+            fname = strrchr(fFilename, '/');
+            if (fname) {
+                fname += 1; // skip the slash
+            }
+        }
+        fName.printf("decode_region_%s_%s", gConfigName[c], fname);
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        if (NULL == fFilename) {
+            return;
+        }
+        SkFILEStream stream(fFilename);
+        if (!stream.isValid()) {
+            return;
+        }
+        SkImageDecoder* codec = SkImageDecoder::Factory(&stream);
+        if (NULL == codec) {
+            return;
+        }
+        SkAutoTDelete<SkImageDecoder> ad(codec);
+
+        int width, height;
+        if (!codec->buildTileIndex(&stream, &width, &height)) {
+            return;
+        }
+        SkIRect rect = SkIRect::MakeXYWH(width / 4, height / 4,
+                                         width / 2, height / 2);
+        for (int i = 0; i < N; i++) {
+            SkBitmap bm;
+            codec->decodeRegion(&bm, rect, fPrefConfig);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 static SkBenchmark* Fact0(void* p) { return new DecodeBench(p, SkBitmap::kARGB_8888_Config); }
 static SkBenchmark* Fact1(void* p) { return new DecodeBench(p, SkBitmap::kRGB_565_Config); }
 static SkBenchmark* Fact2(void* p) { return new DecodeBench(p, SkBitmap::kARGB_4444_Config); }
@@ -60,3 +118,9 @@ static SkBenchmark* Fact2(void* p) { return new DecodeBench(p, SkBitmap::kARGB_4
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
 static BenchRegistry gReg2(Fact2);
+
+static SkBenchmark* RegionFact0(void* p) { return new DecodeRegionBench(p, SkBitmap::kARGB_8888_Config); }
+static SkBenchmark* RegionFact1(void* p) { return new DecodeRegionBench(p, SkBitmap::kRGB_565_Config); }
+
+static BenchRegistry gRegionReg0(RegionFact0);
+static BenchRegistry gRegionReg1(RegionFact1);
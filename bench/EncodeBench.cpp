@@ -0,0 +1,89 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkBenchmark.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkGradientShader.h"
+#include "SkImageEncoder.h"
+#include "SkStream.h"
+#include "SkString.h"
+
+// something photo-like: smooth gradients with some detail drawn over them
+static void make_bitmap(SkBitmap* bm, int size) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, size, size);
+    bm->allocPixels();
+    bm->setIsOpaque(true);
+
+    SkCanvas canvas(*bm);
+    SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(size), SkIntToScalar(size) } };
+    SkColor colors[] = { SK_ColorRED, SK_ColorYELLOW, SK_ColorBLUE };
+    SkPaint paint;
+    paint.setShader(SkGradientShader::CreateLinear(pts, colors, NULL, 3,
+                                            SkShader::kClamp_TileMode))->unref();
+    canvas.drawPaint(paint);
+
+    paint.setShader(NULL);
+    paint.setAntiAlias(true);
+    paint.setColor(SK_ColorBLACK);
+    paint.setTextSize(SkIntToScalar(size / 16));
+    for (int y = size / 16; y < size; y += size / 16) {
+        canvas.drawText("Encode me, please!", 18, 0, SkIntToScalar(y), paint);
+    }
+}
+
+/*  Encode a large image with the given number of threads. Compare the
+    threaded and single threaded versions of each type to see the speedup.
+ */
+class EncodeBench : public SkBenchmark {
+    SkBitmap                fBitmap;
+    SkImageEncoder::Type    fType;
+    int                     fThreadCount;
+    SkString                fName;
+    enum { N = SkBENCHLOOP(2), kSize = 1024 };
+public:
+    EncodeBench(void* param, SkImageEncoder::Type type, int threadCount)
+        : INHERITED(param), fType(type), fThreadCount(threadCount) {
+        make_bitmap(&fBitmap, kSize);
+        fName.printf("encode_%s_%dthread",
+                     SkImageEncoder::kPNG_Type == type ? "png" : "jpeg",
+                     threadCount);
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkImageEncoder* encoder = SkImageEncoder::Create(fType);
+        if (NULL == encoder) {
+            return;
+        }
+        SkAutoTDelete<SkImageEncoder> ad(encoder);
+        encoder->setThreadCount(fThreadCount);
+
+        for (int i = 0; i < N; i++) {
+            SkDynamicMemoryWStream stream;
+            encoder->encodeStream(&stream, fBitmap,
+                                  SkImageEncoder::kDefaultQuality);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+static SkBenchmark* Fact0(void* p) { return new EncodeBench(p, SkImageEncoder::kPNG_Type, 1); }
+static SkBenchmark* Fact1(void* p) { return new EncodeBench(p, SkImageEncoder::kPNG_Type, 4); }
+static SkBenchmark* Fact2(void* p) { return new EncodeBench(p, SkImageEncoder::kJPEG_Type, 1); }
+static SkBenchmark* Fact3(void* p) { return new EncodeBench(p, SkImageEncoder::kJPEG_Type, 4); }
+
+static BenchRegistry gReg0(Fact0);
+static BenchRegistry gReg1(Fact1);
+static BenchRegistry gReg2(Fact2);
+static BenchRegistry gReg3(Fact3);
@@ -6,11 +6,14 @@
  */
 
 #include "SkBenchmark.h"
+#include "SkBitmap.h"
 #include "SkCanvas.h"
 #include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
+#include "SkRunnable.h"
 #include "SkString.h"
+#include "SkThreadPool.h"
 
 extern bool gSkSuppressFontCachePurgeSpew;
 
@@ -51,6 +54,80 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+/*  Rasterize one font at many sizes from a number of threads, with a cold
+    font cache. The work is the same for every thread count, so the times
+    show how well the scaler scales across threads.
+ */
+class FontScalerThreadsBench : public SkBenchmark {
+    enum {
+        kSizeCount = 32,
+        kMinSize = 8,
+    };
+
+    class DrawSizeJob : public SkRunnable {
+    public:
+        DrawSizeJob() : fSize(0) {}
+
+        void init(const SkPaint& paint, const SkString& text, int size) {
+            fPaint = paint;
+            fPaint.setTextSize(SkIntToScalar(size));
+            fText = &text;
+            fSize = size;
+        }
+
+        virtual void run() SK_OVERRIDE {
+            if (fBitmap.isNull()) {
+                fBitmap.setConfig(SkBitmap::kARGB_8888_Config, 640,
+                                  kMinSize + kSizeCount);
+                fBitmap.allocPixels();
+            }
+            SkCanvas canvas(fBitmap);
+            canvas.drawText(fText->c_str(), fText->size(), 0,
+                            SkIntToScalar(fSize), fPaint);
+        }
+
+    private:
+        SkPaint         fPaint;
+        const SkString* fText;
+        int             fSize;
+        SkBitmap        fBitmap;
+    };
+
+    SkString        fName;
+    SkString        fText;
+    DrawSizeJob     fJobs[kSizeCount];
+    SkThreadPool    fPool;
+public:
+    FontScalerThreadsBench(void* param, int threadCount)
+        : INHERITED(param)
+        , fPool(threadCount) {
+        fName.printf("fontscaler_threads_%d", threadCount);
+        fText.set("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789");
+    }
+
+protected:
+    virtual const char* onGetName() { return fName.c_str(); }
+    virtual void onDraw(SkCanvas*) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+
+        bool prev = gSkSuppressFontCachePurgeSpew;
+        gSkSuppressFontCachePurgeSpew = true;
+
+        SkGraphics::PurgeFontCache();
+
+        for (int i = 0; i < kSizeCount; i++) {
+            fJobs[i].init(paint, fText, kMinSize + i);
+            fPool.add(&fJobs[i]);
+        }
+        fPool.wait();
+
+        gSkSuppressFontCachePurgeSpew = prev;
+    }
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static SkBenchmark* Fact0(void* p) { return SkNEW_ARGS(FontScalerBench, (p, false)); }
@@ -58,3 +135,13 @@ static SkBenchmark* Fact1(void* p) { return SkNEW_ARGS(FontScalerBench, (p, true
 
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
+
+static SkBenchmark* Fact2(void* p) {
+    return SkNEW_ARGS(FontScalerThreadsBench, (p, 1));
+}
+static SkBenchmark* Fact3(void* p) {
+    return SkNEW_ARGS(FontScalerThreadsBench, (p, 4));
+}
+
+static BenchRegistry gReg2(Fact2);
+static BenchRegistry gReg3(Fact3);
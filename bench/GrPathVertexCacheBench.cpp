@@ -0,0 +1,145 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// This tests a Gr class
+#if SK_SUPPORT_GPU
+
+#include "GrClipData.h"
+#include "GrContext.h"
+#include "GrTexture.h"
+#include "gl/GrGLInterface.h"
+#include "SkBenchmark.h"
+#include "SkClipStack.h"
+#include "SkPath.h"
+#include "SkRandom.h"
+#include "SkString.h"
+
+/**
+ * Draws the same curved paths over and over at random translations, as
+ * animated content does, with the path vertex cache on or off. The context
+ * runs on the null GL interface, so only the CPU work of drawing is timed.
+ */
+class GrPathVertexCacheBench : public SkBenchmark {
+    enum {
+        N = SkBENCHLOOP(1000),
+        kSize = 256,
+    };
+public:
+    GrPathVertexCacheBench(void* param, bool antiAlias, bool cached)
+        : INHERITED(param)
+        , fContext(NULL)
+        , fAntiAlias(antiAlias)
+        , fCached(cached) {
+        fName.printf("grpathvertexcache_%s_%s", antiAlias ? "aa" : "bw",
+                     cached ? "cached" : "uncached");
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkAutoTUnref<const GrGLInterface> interface(GrGLCreateNullInterface());
+        fContext = GrContext::Create(kOpenGL_Shaders_GrEngine,
+                                     (GrPlatform3DContext) interface.get());
+        if (NULL == fContext) {
+            return;
+        }
+        if (!fCached) {
+            fContext->setPathVertexCacheLimit(0);
+        }
+        GrTextureDesc desc;
+        desc.fFlags = kRenderTarget_GrTextureFlagBit;
+        desc.fConfig = kSkia8888_PM_GrPixelConfig;
+        desc.fWidth = kSize;
+        desc.fHeight = kSize;
+        fTarget.reset(fContext->createUncachedTexture(desc, NULL, 0));
+        if (NULL != fTarget.get()) {
+            fContext->setRenderTarget(fTarget->asRenderTarget());
+        }
+        fClipData.fClipStack = &fClipStack;
+        fContext->setClip(&fClipData);
+
+        // convex, so the AA convex renderer takes it when anti-aliasing
+        fPaths[0].moveTo(0, 20);
+        fPaths[0].quadTo(0, 0, 20, 0);
+        fPaths[0].cubicTo(60, 0, 80, 20, 80, 40);
+        fPaths[0].quadTo(80, 80, 40, 80);
+        fPaths[0].close();
+        fPaths[1].addRoundRect(SkRect::MakeWH(60, 40), 8, 8);
+        fPaths[2].moveTo(10, 10);
+        fPaths[2].cubicTo(70, 0, 0, 70, 70, 70);
+        fPaths[2].quadTo(40, 40, 10, 70);
+        fPaths[2].close();
+    }
+
+    virtual void onPostDraw() SK_OVERRIDE {
+        if (NULL != fContext) {
+            fContext->setRenderTarget(NULL);
+            fContext->setClip(NULL);
+        }
+        fTarget.reset(NULL);
+        SkSafeUnref(fContext);
+        fContext = NULL;
+    }
+
+    virtual void onDraw(SkCanvas* canvas) SK_OVERRIDE {
+        if (NULL == fContext || NULL == fTarget.get()) {
+            return;
+        }
+        GrPaint paint;
+        paint.reset();
+        paint.fAntiAlias = fAntiAlias;
+        SkRandom r;
+        for (int i = 0; i < N; ++i) {
+            for (size_t j = 0; j < SK_ARRAY_COUNT(fPaths); ++j) {
+                GrPoint translate = {
+                    SkIntToScalar(r.nextULessThan(kSize / 2)),
+                    SkIntToScalar(r.nextULessThan(kSize / 2))
+                };
+                fContext->drawPath(paint, fPaths[j], kWinding_GrPathFill,
+                                   &translate);
+            }
+        }
+        fContext->flush();
+    }
+
+private:
+    GrContext*                  fContext;
+    SkAutoTUnref<GrTexture>     fTarget;
+    SkClipStack                 fClipStack;
+    GrClipData                  fClipData;
+    SkPath                      fPaths[3];
+    bool                        fAntiAlias;
+    bool                        fCached;
+    SkString                    fName;
+
+    typedef SkBenchmark INHERITED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+static SkBenchmark* Fact0(void* p) {
+    return new GrPathVertexCacheBench(p, false, false);
+}
+static SkBenchmark* Fact1(void* p) {
+    return new GrPathVertexCacheBench(p, false, true);
+}
+static SkBenchmark* Fact2(void* p) {
+    return new GrPathVertexCacheBench(p, true, false);
+}
+static SkBenchmark* Fact3(void* p) {
+    return new GrPathVertexCacheBench(p, true, true);
+}
+
+static BenchRegistry gReg0(Fact0);
+static BenchRegistry gReg1(Fact1);
+static BenchRegistry gReg2(Fact2);
+static BenchRegistry gReg3(Fact3);
+
+#endif
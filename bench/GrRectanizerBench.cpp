@@ -0,0 +1,92 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// This tests a Gr class
+#if SK_SUPPORT_GPU
+
+#include "GrRectanizer.h"
+#include "SkBenchmark.h"
+#include "SkRandom.h"
+#include "SkString.h"
+#include "SkTScopedPtr.h"
+
+/**
+ * Packs glyph-sized rects of mixed sizes into an atlas-sized rectanizer,
+ * starting a new one whenever it fills up, as GrAtlasMgr starts a new plot.
+ * (GrRectanizerTest checks how full each kind packs.)
+ */
+class GrRectanizerBench : public SkBenchmark {
+    enum {
+        N = SkBENCHLOOP(20000),
+        kWidth = 340,
+        kHeight = 340,
+    };
+public:
+    GrRectanizerBench(void* param, GrRectanizer::Type type, const char name[],
+                      int minSize, int maxSize)
+        : INHERITED(param)
+        , fType(type)
+        , fMinSize(minSize)
+        , fMaxSize(maxSize) {
+        fName.printf("grrectanizer_%s_%d_%d", name, minSize, maxSize);
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas* canvas) SK_OVERRIDE {
+        SkRandom r;
+        SkTScopedPtr<GrRectanizer> rectanizer(
+            GrRectanizer::Factory(kWidth, kHeight, fType));
+        for (int i = 0; i < N; ++i) {
+            int w = r.nextRangeU(fMinSize, fMaxSize);
+            int h = r.nextRangeU(fMinSize, fMaxSize);
+            GrIPoint16 loc;
+            if (!rectanizer->addRect(w, h, &loc)) {
+                rectanizer.reset(GrRectanizer::Factory(kWidth, kHeight,
+                                                       fType));
+                rectanizer->addRect(w, h, &loc);
+            }
+        }
+    }
+
+private:
+    GrRectanizer::Type  fType;
+    int                 fMinSize;
+    int                 fMaxSize;
+    SkString            fName;
+
+    typedef SkBenchmark INHERITED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Latin text: small glyphs of similar heights
+static SkBenchmark* Fact0(void* p) {
+    return new GrRectanizerBench(p, GrRectanizer::kPow2_Type, "pow2", 4, 16);
+}
+static SkBenchmark* Fact1(void* p) {
+    return new GrRectanizerBench(p, GrRectanizer::kSkyline_Type, "skyline",
+                                 4, 16);
+}
+// CJK text and mixed sizes: larger glyphs, widely varying
+static SkBenchmark* Fact2(void* p) {
+    return new GrRectanizerBench(p, GrRectanizer::kPow2_Type, "pow2", 8, 48);
+}
+static SkBenchmark* Fact3(void* p) {
+    return new GrRectanizerBench(p, GrRectanizer::kSkyline_Type, "skyline",
+                                 8, 48);
+}
+
+static BenchRegistry gReg0(Fact0);
+static BenchRegistry gReg1(Fact1);
+static BenchRegistry gReg2(Fact2);
+static BenchRegistry gReg3(Fact3);
+
+#endif
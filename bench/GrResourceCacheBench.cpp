@@ -0,0 +1,158 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// This tests a Gr class
+#if SK_SUPPORT_GPU
+
+#include "GrContext.h"
+#include "GrTexture.h"
+#include "gl/GrGLInterface.h"
+#include "SkBenchmark.h"
+#include "SkRandom.h"
+
+/**
+ * Base class for benchmarks of the resource cache. They run against a context
+ * on the null GL interface, so only the cache's own work is timed.
+ */
+class GrResourceCacheBench : public SkBenchmark {
+public:
+    GrResourceCacheBench(void* param) : INHERITED(param), fContext(NULL) {
+    }
+
+protected:
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkAutoTUnref<const GrGLInterface> interface(GrGLCreateNullInterface());
+        fContext = GrContext::Create(kOpenGL_Shaders_GrEngine,
+                                     (GrPlatform3DContext) interface.get());
+    }
+
+    virtual void onPostDraw() SK_OVERRIDE {
+        SkSafeUnref(fContext);
+        fContext = NULL;
+    }
+
+    static void MakeDesc(GrTextureDesc* desc, int width, int height) {
+        desc->fFlags = kNone_GrTextureFlags;
+        desc->fConfig = kSkia8888_PM_GrPixelConfig;
+        desc->fWidth = width;
+        desc->fHeight = height;
+    }
+
+    GrContext* fContext;
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+/**
+ * Finds and locks randomly chosen content textures out of a full cache.
+ */
+class GrResourceCacheBenchFind : public GrResourceCacheBench {
+    enum {
+        N = SkBENCHLOOP(100000),
+        kTextureCount = 200,
+    };
+public:
+    GrResourceCacheBenchFind(void* param) : INHERITED(param) {
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return "grresourcecache_find";
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        this->INHERITED::onPreDraw();
+        if (NULL == fContext) {
+            return;
+        }
+        for (int i = 0; i < kTextureCount; ++i) {
+            GrTextureDesc desc;
+            MakeDesc(&desc, 16 + (i % 4) * 16, 16);
+            GrTexture* texture = fContext->createAndLockTexture(
+                                    NULL, desc, GrCacheData(i), NULL, 0);
+            if (NULL != texture) {
+                fContext->unlockTexture(texture);
+            }
+        }
+    }
+
+    virtual void onDraw(SkCanvas* canvas) SK_OVERRIDE {
+        if (NULL == fContext) {
+            return;
+        }
+        SkRandom r;
+        for (int i = 0; i < N; ++i) {
+            int id = r.nextULessThan(kTextureCount);
+            GrTextureDesc desc;
+            MakeDesc(&desc, 16 + (id % 4) * 16, 16);
+            GrTexture* texture = fContext->findAndLockTexture(desc,
+                                                              GrCacheData(id),
+                                                              NULL);
+            if (NULL != texture) {
+                fContext->unlockTexture(texture);
+            }
+        }
+    }
+
+private:
+    typedef GrResourceCacheBench INHERITED;
+};
+
+/**
+ * Locks and unlocks scratch textures of varied sizes, as drawing with
+ * temporary render targets does.
+ */
+class GrResourceCacheBenchScratch : public GrResourceCacheBench {
+    enum {
+        N = SkBENCHLOOP(20000),
+        kMaxLocked = 8,
+    };
+public:
+    GrResourceCacheBenchScratch(void* param) : INHERITED(param) {
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return "grresourcecache_scratch";
+    }
+
+    virtual void onDraw(SkCanvas* canvas) SK_OVERRIDE {
+        if (NULL == fContext) {
+            return;
+        }
+        SkRandom r;
+        GrTexture* locked[kMaxLocked];
+        for (int i = 0; i < N; ++i) {
+            int count = r.nextRangeU(1, kMaxLocked);
+            for (int j = 0; j < count; ++j) {
+                GrTextureDesc desc;
+                MakeDesc(&desc, r.nextRangeU(16, 256), r.nextRangeU(16, 256));
+                locked[j] = fContext->lockScratchTexture(
+                                desc, GrContext::kApprox_ScratchTexMatch);
+            }
+            for (int j = 0; j < count; ++j) {
+                if (NULL != locked[j]) {
+                    fContext->unlockTexture(locked[j]);
+                }
+            }
+        }
+    }
+
+private:
+    typedef GrResourceCacheBench INHERITED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+static SkBenchmark* Fact1(void* p) { return new GrResourceCacheBenchFind(p); }
+static SkBenchmark* Fact2(void* p) { return new GrResourceCacheBenchScratch(p); }
+
+static BenchRegistry gReg01(Fact1);
+static BenchRegistry gReg02(Fact2);
+
+#endif
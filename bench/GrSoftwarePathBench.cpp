@@ -0,0 +1,142 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+// This tests a Gr class
+#if SK_SUPPORT_GPU
+
+#include "GrClipData.h"
+#include "GrContext.h"
+#include "GrTexture.h"
+#include "gl/GrGLInterface.h"
+#include "SkBenchmark.h"
+#include "SkClipStack.h"
+#include "SkPath.h"
+#include "SkRandom.h"
+#include "SkString.h"
+
+/**
+ * Draws anti-aliased concave paths, which only the software path renderer
+ * draws, a frame at a time. The paths are either drawn at whole pixel
+ * offsets, so their masks are found in the cache, or at random subpixel
+ * offsets, so every mask is rasterized (on as many threads as there are
+ * cores). The context runs on the null GL interface, so only the CPU work of
+ * drawing is timed.
+ */
+class GrSoftwarePathBench : public SkBenchmark {
+    enum {
+        N = SkBENCHLOOP(10),
+        kPathsPerFrame = 32,
+        kSize = 512,
+    };
+public:
+    GrSoftwarePathBench(void* param, bool subpixel)
+        : INHERITED(param)
+        , fContext(NULL)
+        , fSubpixel(subpixel) {
+        fName.printf("grswpath_%s", subpixel ? "subpixel" : "whole_pixel");
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkAutoTUnref<const GrGLInterface> interface(GrGLCreateNullInterface());
+        fContext = GrContext::Create(kOpenGL_Shaders_GrEngine,
+                                     (GrPlatform3DContext) interface.get());
+        if (NULL == fContext) {
+            return;
+        }
+        GrTextureDesc desc;
+        desc.fFlags = kRenderTarget_GrTextureFlagBit;
+        desc.fConfig = kSkia8888_PM_GrPixelConfig;
+        desc.fWidth = kSize;
+        desc.fHeight = kSize;
+        fTarget.reset(fContext->createUncachedTexture(desc, NULL, 0));
+        if (NULL != fTarget.get()) {
+            fContext->setRenderTarget(fTarget->asRenderTarget());
+        }
+        fClipData.fClipStack = &fClipStack;
+        fContext->setClip(&fClipData);
+
+        SkRandom r;
+        for (size_t i = 0; i < SK_ARRAY_COUNT(fPaths); ++i) {
+            SkScalar radius = SkIntToScalar(40 + r.nextULessThan(60));
+            fPaths[i].moveTo(radius, 0);
+            for (int j = 1; j < 7; ++j) {
+                SkScalar angle = SkIntToScalar(j * 6) * SK_ScalarPI / 7;
+                fPaths[i].quadTo(radius, radius,
+                                 radius + SkScalarMul(radius,
+                                                      SkScalarCos(angle)),
+                                 radius + SkScalarMul(radius,
+                                                      SkScalarSin(angle)));
+            }
+            fPaths[i].close();
+        }
+    }
+
+    virtual void onPostDraw() SK_OVERRIDE {
+        if (NULL != fContext) {
+            fContext->setRenderTarget(NULL);
+            fContext->setClip(NULL);
+        }
+        fTarget.reset(NULL);
+        SkSafeUnref(fContext);
+        fContext = NULL;
+    }
+
+    virtual void onDraw(SkCanvas* canvas) SK_OVERRIDE {
+        if (NULL == fContext || NULL == fTarget.get()) {
+            return;
+        }
+        GrPaint paint;
+        paint.reset();
+        paint.fAntiAlias = true;
+        // the same positions every time, unless they're subpixel
+        SkRandom wholePixelRandom;
+        SkRandom& r = fSubpixel ? fRandom : wholePixelRandom;
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < kPathsPerFrame; ++j) {
+                GrPoint translate = {
+                    SkIntToScalar(r.nextULessThan(kSize / 2)),
+                    SkIntToScalar(r.nextULessThan(kSize / 2))
+                };
+                if (fSubpixel) {
+                    translate.fX += r.nextUScalar1();
+                    translate.fY += r.nextUScalar1();
+                }
+                fContext->drawPath(paint,
+                                   fPaths[j % SK_ARRAY_COUNT(fPaths)],
+                                   kWinding_GrPathFill, &translate);
+            }
+            fContext->flush();
+        }
+    }
+
+private:
+    GrContext*                  fContext;
+    SkAutoTUnref<GrTexture>     fTarget;
+    SkClipStack                 fClipStack;
+    GrClipData                  fClipData;
+    SkPath                      fPaths[8];
+    SkRandom                    fRandom;
+    bool                        fSubpixel;
+    SkString                    fName;
+
+    typedef SkBenchmark INHERITED;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+static SkBenchmark* Fact0(void* p) { return new GrSoftwarePathBench(p, false); }
+static SkBenchmark* Fact1(void* p) { return new GrSoftwarePathBench(p, true); }
+
+static BenchRegistry gReg0(Fact0);
+static BenchRegistry gReg1(Fact1);
+
+#endif
@@ -221,12 +221,16 @@ private:
 };
 
 class Gradient2Bench : public SkBenchmark {
+    bool fShareColors;
 public:
-    Gradient2Bench(void* param) : INHERITED(param) {}
+    // If shareColors is true, every shader we create has the same colors, so
+    // all but the first can reuse their color table from the gradient cache.
+    Gradient2Bench(void* param, bool shareColors = false)
+        : INHERITED(param), fShareColors(shareColors) {}
 
 protected:
     virtual const char* onGetName() {
-        return "gradient_create";
+        return fShareColors ? "gradient_create_shared" : "gradient_create";
     }
 
     virtual void onDraw(SkCanvas* canvas) {
@@ -240,7 +244,7 @@ protected:
         };
 
         for (int i = 0; i < SkBENCHLOOP(1000); i++) {
-            const int a = i % 256;
+            const int a = fShareColors ? 0x80 : i % 256;
             SkColor colors[] = {
                 SK_ColorBLACK,
                 SkColorSetARGB(a, a, a, a),
@@ -275,6 +279,7 @@ static SkBenchmark* Fact31(void* p) { return new GradientBench(p, kRadial2_GradT
 static SkBenchmark* Fact5(void* p) { return new GradientBench(p, kConical_GradType); }
 
 static SkBenchmark* Fact4(void* p) { return new Gradient2Bench(p); }
+static SkBenchmark* Fact4s(void* p) { return new Gradient2Bench(p, true); }
 
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg01(Fact01);
@@ -287,4 +292,5 @@ static BenchRegistry gReg31(Fact31);
 static BenchRegistry gReg5(Fact5);
 
 static BenchRegistry gReg4(Fact4);
+static BenchRegistry gReg4s(Fact4s);
 
@@ -0,0 +1,97 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkBenchmark.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkMipMap.h"
+#include "SkRandom.h"
+#include "SkString.h"
+
+static void make_bitmap(SkBitmap* bm, int size) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, size, size);
+    bm->allocPixels();
+
+    SkRandom rand;
+    SkAutoLockPixels alp(*bm);
+    for (int y = 0; y < size; ++y) {
+        uint32_t* row = bm->getAddr32(0, y);
+        for (int x = 0; x < size; ++x) {
+            row[x] = rand.nextU() | 0xFF000000;
+        }
+    }
+    bm->setIsOpaque(true);
+}
+
+/*  Draw a large bitmap at a small size with filtering. With mipmaps, only the
+    first draw pays to build the levels (they're cached), and every draw reads
+    a small level. Without (the bitmap is marked volatile), every draw reads
+    scattered pixels from the full sized bitmap.
+ */
+class MipMapDrawBench : public SkBenchmark {
+    SkBitmap    fBitmap;
+    SkString    fName;
+    enum { N = SkBENCHLOOP(20), kSize = 1024 };
+public:
+    MipMapDrawBench(void* param, bool useMipMap) : INHERITED(param) {
+        make_bitmap(&fBitmap, kSize);
+        fBitmap.setIsVolatile(!useMipMap);
+        fName.printf("mipmap_draw_%s", useMipMap ? "mip" : "nomip");
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setFilterBitmap(true);
+
+        // about the size of a thumbnail
+        canvas->scale(SkFloatToScalar(0.15f), SkFloatToScalar(0.15f));
+        for (int i = 0; i < N; i++) {
+            canvas->drawBitmap(fBitmap, 0, 0, &paint);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+// Measures the downsampling, i.e. the cost of a cache miss.
+class MipMapBuildBench : public SkBenchmark {
+    SkBitmap    fBitmap;
+    enum { N = SkBENCHLOOP(5), kSize = 1024 };
+public:
+    MipMapBuildBench(void* param) : INHERITED(param) {
+        make_bitmap(&fBitmap, kSize);
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return "mipmap_build";
+    }
+
+    virtual void onDraw(SkCanvas*) {
+        for (int i = 0; i < N; i++) {
+            SkSafeUnref(SkMipMap::Build(fBitmap));
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+static SkBenchmark* Fact0(void* p) { return new MipMapDrawBench(p, true); }
+static SkBenchmark* Fact1(void* p) { return new MipMapDrawBench(p, false); }
+static SkBenchmark* Fact2(void* p) { return new MipMapBuildBench(p); }
+
+static BenchRegistry gReg0(Fact0);
+static BenchRegistry gReg1(Fact1);
+static BenchRegistry gReg2(Fact2);
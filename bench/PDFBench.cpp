@@ -0,0 +1,190 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkBenchmark.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkGradientShader.h"
+#include "SkPDFDevice.h"
+#include "SkPDFDocument.h"
+#include "SkPicture.h"
+#include "SkStream.h"
+#include "SkString.h"
+
+// something photo-like, which compresses reasonably but not trivially
+static void make_bitmap(SkBitmap* bm, int size, SkColor color) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, size, size);
+    bm->allocPixels();
+    bm->setIsOpaque(true);
+
+    SkCanvas canvas(*bm);
+    SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(size), SkIntToScalar(size) } };
+    SkColor colors[] = { color, SK_ColorWHITE, SK_ColorBLACK };
+    SkPaint paint;
+    paint.setShader(SkGradientShader::CreateLinear(pts, colors, NULL, 3,
+                                            SkShader::kMirror_TileMode))->unref();
+    canvas.drawPaint(paint);
+
+    paint.setShader(NULL);
+    paint.setAntiAlias(true);
+    paint.setColor(SK_ColorBLACK);
+    paint.setTextSize(SkIntToScalar(size / 8));
+    for (int y = size / 8; y < size; y += size / 8) {
+        canvas.drawText("Compress me!", 12, 0, SkIntToScalar(y), paint);
+    }
+}
+
+enum {
+    kPageCount = 200,
+    kImagesPerPage = 3,
+    kImageSize = 128,
+    kPageSize = 612,
+};
+
+static void make_bitmaps(SkBitmap bitmaps[kImagesPerPage]) {
+    static const SkColor gColors[] = {
+        SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE
+    };
+    for (int i = 0; i < kImagesPerPage; i++) {
+        make_bitmap(&bitmaps[i], kImageSize, gColors[i]);
+    }
+}
+
+static void draw_page(SkCanvas* canvas, const SkBitmap bitmaps[kImagesPerPage],
+                      int pageIndex) {
+    for (int i = 0; i < kImagesPerPage; i++) {
+        canvas->drawBitmap(bitmaps[(pageIndex + i) % kImagesPerPage],
+                           SkIntToScalar(i * kImageSize),
+                           SkIntToScalar(i * kImageSize));
+    }
+    SkPaint paint;
+    SkString text;
+    text.printf("Page %d", pageIndex + 1);
+    canvas->drawText(text.c_str(), text.size(), 20, kPageSize - 20, paint);
+}
+
+/*  Export a synthetic, image-heavy, multi-page document, compressing its
+    streams on the given number of threads. Compare the threaded and single
+    threaded versions to see the speedup.
+ */
+class PDFExportBench : public SkBenchmark {
+    SkBitmap    fBitmaps[3];
+    int         fThreadCount;
+    bool        fStreaming;
+    SkString    fName;
+    enum {
+        N = SkBENCHLOOP(1),
+    };
+public:
+    PDFExportBench(void* param, int threadCount, bool streaming)
+        : INHERITED(param), fThreadCount(threadCount), fStreaming(streaming) {
+        make_bitmaps(fBitmaps);
+        fName.printf("pdf_export_%dpages_%s_%dthread", kPageCount,
+                     streaming ? "stream" : "emit", threadCount);
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    void addPage(SkPDFDocument* doc, int pageIndex) {
+        SkISize size = SkISize::Make(kPageSize, kPageSize);
+        SkPDFDevice* dev = SkNEW_ARGS(SkPDFDevice, (size, size,
+                                                    SkMatrix::I()));
+        SkAutoUnref aur(dev);
+
+        SkCanvas canvas(dev);
+        draw_page(&canvas, fBitmaps, pageIndex);
+        doc->appendPage(dev);
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        for (int i = 0; i < N; i++) {
+            SkPDFDocument doc;
+            doc.setThreadCount(fThreadCount);
+            SkDynamicMemoryWStream stream;
+            if (fStreaming) {
+                doc.beginStream(&stream);
+            }
+            for (int page = 0; page < kPageCount; page++) {
+                this->addPage(&doc, page);
+            }
+            if (fStreaming) {
+                doc.endStream();
+            } else {
+                doc.emitPDF(&stream);
+            }
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+/*  Export the same document from pictures, drawing the pages on the given
+    number of threads (and compressing on as many).
+ */
+class PDFPicturesBench : public SkBenchmark {
+    SkPicture   fPictures[kPageCount];
+    int         fThreadCount;
+    SkString    fName;
+    enum {
+        N = SkBENCHLOOP(1),
+    };
+public:
+    PDFPicturesBench(void* param, int threadCount)
+        : INHERITED(param), fThreadCount(threadCount) {
+        SkBitmap bitmaps[kImagesPerPage];
+        make_bitmaps(bitmaps);
+        for (int i = 0; i < kPageCount; i++) {
+            SkCanvas* canvas = fPictures[i].beginRecording(kPageSize,
+                                                           kPageSize);
+            draw_page(canvas, bitmaps, i);
+            fPictures[i].endRecording();
+        }
+        fName.printf("pdf_pictures_%dpages_%dthread", kPageCount,
+                     threadCount);
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPicture* pictures[kPageCount];
+        for (int i = 0; i < kPageCount; i++) {
+            pictures[i] = &fPictures[i];
+        }
+        for (int i = 0; i < N; i++) {
+            SkPDFDocument doc;
+            doc.setThreadCount(fThreadCount);
+            SkDynamicMemoryWStream stream;
+            doc.appendPictures(pictures, kPageCount);
+            doc.emitPDF(&stream);
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+static SkBenchmark* Fact0(void* p) { return new PDFExportBench(p, 1, false); }
+static SkBenchmark* Fact1(void* p) { return new PDFExportBench(p, 4, false); }
+static SkBenchmark* Fact2(void* p) { return new PDFExportBench(p, 1, true); }
+static SkBenchmark* Fact3(void* p) { return new PDFExportBench(p, 4, true); }
+
+static SkBenchmark* Fact4(void* p) { return new PDFPicturesBench(p, 1); }
+static SkBenchmark* Fact5(void* p) { return new PDFPicturesBench(p, 4); }
+
+static BenchRegistry gReg0(Fact0);
+static BenchRegistry gReg1(Fact1);
+static BenchRegistry gReg2(Fact2);
+static BenchRegistry gReg3(Fact3);
+static BenchRegistry gReg4(Fact4);
+static BenchRegistry gReg5(Fact5);
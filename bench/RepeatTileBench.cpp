@@ -85,10 +85,14 @@ static void convertToIndex666(const SkBitmap& src, SkBitmap* dst) {
 
 class RepeatTileBench : public SkBenchmark {
     SkPaint     fPaint;
+    bool        fFilter;
     SkString    fName;
     enum { N = SkBENCHLOOP(20) };
 public:
-    RepeatTileBench(void* param, SkBitmap::Config c) : INHERITED(param) {
+    RepeatTileBench(void* param, SkBitmap::Config c,
+                    SkShader::TileMode mode = SkShader::kRepeat_TileMode,
+                    bool scale = false, bool filter = false)
+            : INHERITED(param), fFilter(filter) {
         const int w = 50;
         const int h = 50;
         SkBitmap bm;
@@ -109,11 +113,22 @@ public:
             bm = tmp;
         }
 
-        SkShader* s = SkShader::CreateBitmapShader(bm,
-                                                   SkShader::kRepeat_TileMode,
-                                                   SkShader::kRepeat_TileMode);
+        SkShader* s = SkShader::CreateBitmapShader(bm, mode, mode);
+        if (scale) {
+            SkMatrix m;
+            m.setScale(SkIntToScalar(3) / 2, SkIntToScalar(3) / 2);
+            s->setLocalMatrix(m);
+        }
         fPaint.setShader(s)->unref();
-        fName.printf("repeatTile_%s", gConfigName[bm.config()]);
+        fName.printf("%sTile_%s",
+                     SkShader::kMirror_TileMode == mode ? "mirror" : "repeat",
+                     gConfigName[bm.config()]);
+        if (scale) {
+            fName.append("_scale");
+        }
+        if (filter) {
+            fName.append("_filter");
+        }
     }
 
 protected:
@@ -124,6 +139,9 @@ protected:
     virtual void onDraw(SkCanvas* canvas) {
         SkPaint paint(fPaint);
         this->setupPaint(&paint);
+        if (fFilter) {
+            paint.setFilterBitmap(true);
+        }
 
         for (int i = 0; i < N; i++) {
             canvas->drawPaint(paint);
@@ -139,7 +157,19 @@ static SkBenchmark* Fact1(void* p) { return new RepeatTileBench(p, SkBitmap::kRG
 static SkBenchmark* Fact2(void* p) { return new RepeatTileBench(p, SkBitmap::kARGB_4444_Config); }
 static SkBenchmark* Fact3(void* p) { return new RepeatTileBench(p, SkBitmap::kIndex8_Config); }
 
+// RepeatX_RepeatY_{nofilter,filter}_scale_SSE2
+static SkBenchmark* Fact4(void* p) { return new RepeatTileBench(p, SkBitmap::kARGB_8888_Config, SkShader::kRepeat_TileMode, true); }
+static SkBenchmark* Fact5(void* p) { return new RepeatTileBench(p, SkBitmap::kARGB_8888_Config, SkShader::kRepeat_TileMode, true, true); }
+
+// MirrorX_MirrorY_{nofilter,filter}_scale_SSE2
+static SkBenchmark* Fact6(void* p) { return new RepeatTileBench(p, SkBitmap::kARGB_8888_Config, SkShader::kMirror_TileMode, true); }
+static SkBenchmark* Fact7(void* p) { return new RepeatTileBench(p, SkBitmap::kARGB_8888_Config, SkShader::kMirror_TileMode, true, true); }
+
 static BenchRegistry gReg0(Fact0);
 static BenchRegistry gReg1(Fact1);
 static BenchRegistry gReg2(Fact2);
 static BenchRegistry gReg3(Fact3);
+static BenchRegistry gReg4(Fact4);
+static BenchRegistry gReg5(Fact5);
+static BenchRegistry gReg6(Fact6);
+static BenchRegistry gReg7(Fact7);
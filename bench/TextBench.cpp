@@ -16,7 +16,8 @@
 enum FontQuality {
     kBW,
     kAA,
-    kLCD
+    kLCD,
+    kDF     // antialiased, from distance fields
 };
 
 static const char* fontQualityName(const SkPaint& paint) {
@@ -26,9 +27,18 @@ static const char* fontQualityName(const SkPaint& paint) {
     if (paint.isLCDRenderText()) {
         return "LCD";
     }
+    if (paint.isDistanceFieldText()) {
+        return "DF";
+    }
     return "AA";
 }
 
+static void setFontQuality(SkPaint* paint, FontQuality fq) {
+    paint->setAntiAlias(kBW != fq);
+    paint->setLCDRenderText(kLCD == fq);
+    paint->setDistanceFieldText(kDF == fq);
+}
+
 /*  Some considerations for performance:
         short -vs- long strings (measuring overhead)
         tiny -vs- large pointsize (measure blit -vs- overhead)
@@ -54,8 +64,7 @@ public:
         fDoPos = doPos;
         fText.set(text);
 
-        fPaint.setAntiAlias(kBW != fq);
-        fPaint.setLCDRenderText(kLCD == fq);
+        setFontQuality(&fPaint, fq);
         fPaint.setTextSize(SkIntToScalar(ps));
         fPaint.setColor(color);
 
@@ -100,8 +109,7 @@ protected:
         this->setupPaint(&paint);
         // explicitly need these
         paint.setColor(fPaint.getColor());
-        paint.setAntiAlias(kBW != fFQ);
-        paint.setLCDRenderText(kLCD == fFQ);
+        setFontQuality(&paint, fFQ);
 
         const SkScalar x0 = SkIntToScalar(-10);
         const SkScalar y0 = SkIntToScalar(-10);
@@ -127,6 +135,103 @@ private:
     typedef SkBenchmark INHERITED;
 };
 
+/*  Draw text at a different set of sizes every time, the way a zoom animation
+    does, so that normal text needs new strikes for each frame while distance
+    field text reuses its one strike.
+ */
+class TextZoomBench : public SkBenchmark {
+    SkString    fName;
+    FontQuality fFQ;
+    int         fFrame;
+    enum {
+        kLineCount = 24,
+        N = SkBENCHLOOP(4)
+    };
+public:
+    TextZoomBench(void* param, FontQuality fq) : INHERITED(param) {
+        fFQ = fq;
+        fFrame = 0;
+        SkPaint paint;
+        setFontQuality(&paint, fq);
+        fName.printf("text_zoom_%s", fontQualityName(paint));
+    }
+
+protected:
+    virtual const char* onGetName() { return fName.c_str(); }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        setFontQuality(&paint, fFQ);
+
+        static const char gText[] = "The quick brown fox jumps over the lazy dog";
+        for (int i = 0; i < N; i++) {
+            // each frame's sizes are a little bigger than the last's
+            SkScalar zoom = SK_Scalar1 + SkIntToScalar(fFrame++) / 256;
+            SkScalar y = 0;
+            for (int line = 0; line < kLineCount; line++) {
+                SkScalar size = SkScalarMul(SkIntToScalar(8 + line), zoom);
+                paint.setTextSize(size);
+                y += size;
+                canvas->drawText(gText, sizeof(gText) - 1, 0, y, paint);
+            }
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
+/*  Draw a paragraph a word at a time, as layout code does, so that each text
+    draw is short and the cost of each draw dominates.
+ */
+class TextWordsBench : public SkBenchmark {
+    SkString    fName;
+    FontQuality fFQ;
+    enum { N = SkBENCHLOOP(20) };
+public:
+    TextWordsBench(void* param, FontQuality fq) : INHERITED(param) {
+        fFQ = fq;
+        SkPaint paint;
+        setFontQuality(&paint, fq);
+        fName.printf("text_words_%s", fontQualityName(paint));
+    }
+
+protected:
+    virtual const char* onGetName() { return fName.c_str(); }
+
+    virtual void onDraw(SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        setFontQuality(&paint, fFQ);
+        paint.setTextSize(SkIntToScalar(12));
+
+        static const char* gWords[] = {
+            "The", "quick", "brown", "fox", "jumps", "over", "the", "lazy", "dog"
+        };
+        const SkScalar space = paint.measureText(" ", 1);
+        const SkIPoint dim = this->getSize();
+        for (int i = 0; i < N; i++) {
+            SkScalar x = 0;
+            SkScalar y = paint.getTextSize();
+            for (int w = 0; y < dim.fY; w++) {
+                const char* word = gWords[w % SK_ARRAY_COUNT(gWords)];
+                size_t len = strlen(word);
+                SkScalar width = paint.measureText(word, len);
+                if (x + width > dim.fX) {
+                    x = 0;
+                    y += paint.getTextSize();
+                }
+                canvas->drawText(word, len, x, y, paint);
+                x += width + space;
+            }
+        }
+    }
+
+private:
+    typedef SkBenchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #define STR     "Hamburgefons"
@@ -143,7 +248,16 @@ static SkBenchmark* Fact21(void* p) { return new TextBench(p, STR, 16, 0xFF00000
 static SkBenchmark* Fact22(void* p) { return new TextBench(p, STR, 16, 0xFFFF0000, kLCD); }
 static SkBenchmark* Fact23(void* p) { return new TextBench(p, STR, 16, 0x88FF0000, kLCD); }
 
+static SkBenchmark* Fact31(void* p) { return new TextBench(p, STR, 16, 0xFF000000, kDF); }
+
 static SkBenchmark* Fact111(void* p) { return new TextBench(p, STR, 16, 0xFF000000, kAA, true); }
+static SkBenchmark* Fact131(void* p) { return new TextBench(p, STR, 16, 0xFF000000, kDF, true); }
+
+static SkBenchmark* Fact201(void* p) { return new TextZoomBench(p, kAA); }
+static SkBenchmark* Fact231(void* p) { return new TextZoomBench(p, kDF); }
+
+static SkBenchmark* Fact301(void* p) { return new TextWordsBench(p, kBW); }
+static SkBenchmark* Fact311(void* p) { return new TextWordsBench(p, kAA); }
 
 static BenchRegistry gReg01(Fact01);
 static BenchRegistry gReg02(Fact02);
@@ -157,4 +271,13 @@ static BenchRegistry gReg21(Fact21);
 static BenchRegistry gReg22(Fact22);
 static BenchRegistry gReg23(Fact23);
 
+static BenchRegistry gReg31(Fact31);
+
 static BenchRegistry gReg111(Fact111);
+static BenchRegistry gReg131(Fact131);
+
+static BenchRegistry gReg201(Fact201);
+static BenchRegistry gReg231(Fact231);
+
+static BenchRegistry gReg301(Fact301);
+static BenchRegistry gReg311(Fact311);
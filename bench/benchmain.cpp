@@ -244,7 +244,7 @@ public:
     GLHelper() {
     }
 
-    bool init(SkGLContext* glCtx, int width, int height) {
+    bool init(SkGLContext* glCtx, int width, int height, bool ringBuffers) {
         GrContext* grCtx;
         if (!glCtx->init(width, height)) {
             return false;
@@ -253,6 +253,7 @@ public:
             reinterpret_cast<GrPlatform3DContext>(glCtx->gl());
         grCtx = GrContext::Create(kOpenGL_Shaders_GrEngine, ctx);
         if (NULL != grCtx) {
+            grCtx->setGeometryRingBuffers(ringBuffers);
             GrPlatformRenderTargetDesc desc;
             desc.fConfig = kSkia8888_PM_GrPixelConfig;
             desc.fWidth = width;
@@ -398,7 +399,8 @@ static void help() {
     SkDebugf("Usage: bench [-o outDir] [-repeat nr] [-logPerIter 1|0] "
                           "[-timers [wcgWC]*] [-rotate]\n"
              "    [-scale] [-clip] [-min] [-forceAA 1|0] [-forceFilter 1|0]\n"
-             "    [-forceDither 1|0] [-forceBlend 1|0] [-strokeWidth width]\n"
+             "    [-forceDither 1|0] [-forceBlend 1|0] [-ringBuffers 1|0]\n"
+             "    [-strokeWidth width]\n"
              "    [-match name] [-mode normal|deferred|record|picturerecord]\n"
              "    [-config 8888|565|GPU|ANGLE|NULLGPU] [-Dfoo bar]\n"
              "    [-h|--help]");
@@ -421,6 +423,8 @@ static void help() {
              "Enable/disable dithering, default is disabled.\n");
     SkDebugf("    -forceBlend 1|0 : "
              "Enable/disable dithering, default is disabled.\n");
+    SkDebugf("    -ringBuffers 1|0 : "
+             "Enable/disable GPU geometry ring buffers, default is disabled.\n");
     SkDebugf("    -strokeWidth width : The width for path stroke.\n");
     SkDebugf("    -match name : Only run bench whose name is matched.\n");
     SkDebugf("    -mode normal|deferred|record|picturerecord : Run in the corresponding mode\n"
@@ -463,6 +467,7 @@ int main (int argc, char * const argv[]) {
     bool doRotate = false;
     bool doClip = false;
     bool printMin = false;
+    bool ringBuffers = false;
     bool hasStrokeWidth = false;
     float strokeWidth;
     SkTDArray<const char*> fMatches;
@@ -585,6 +590,12 @@ int main (int argc, char * const argv[]) {
                 help();
                 return -1;
             }
+        } else if (strcmp(*argv, "-ringBuffers") == 0) {
+            if (!parse_bool_arg(++argv, stop, &ringBuffers)) {
+                logger.logError("missing arg for -ringBuffers\n");
+                help();
+                return -1;
+            }
         } else if (strcmp(*argv, "-strokeWidth") == 0) {
             argv++;
             if (argv < stop) {
@@ -685,8 +696,8 @@ int main (int argc, char * const argv[]) {
                    "deferred=%d logperiter=%d",
                    forceAlpha, forceAA, forceFilter, benchMode == kDeferred_benchModes,
                    logPerIter);
-        str.appendf(" rotate=%d scale=%d clip=%d min=%d",
-                   doRotate, doScale, doClip, printMin);
+        str.appendf(" rotate=%d scale=%d clip=%d min=%d ringbuffers=%d",
+                   doRotate, doScale, doClip, printMin, ringBuffers);
         str.appendf(" record=%d picturerecord=%d",
                     benchMode == kRecord_benchModes,
                     benchMode == kPictureRecord_benchModes);
@@ -739,12 +750,16 @@ int main (int argc, char * const argv[]) {
     SkAutoTUnref<SkGLContext> realGLCtx(new SkNativeGLContext);
     SkAutoTUnref<SkGLContext> nullGLCtx(new SkNullGLContext);
     SkAutoTUnref<SkGLContext> debugGLCtx(new SkDebugGLContext);
-    gRealGLHelper.init(realGLCtx.get(), contextWidth, contextHeight);
-    gNullGLHelper.init(nullGLCtx.get(), contextWidth, contextHeight);
-    gDebugGLHelper.init(debugGLCtx.get(), contextWidth, contextHeight);
+    gRealGLHelper.init(realGLCtx.get(), contextWidth, contextHeight,
+                       ringBuffers);
+    gNullGLHelper.init(nullGLCtx.get(), contextWidth, contextHeight,
+                       ringBuffers);
+    gDebugGLHelper.init(debugGLCtx.get(), contextWidth, contextHeight,
+                        ringBuffers);
 #if SK_ANGLE
     SkAutoTUnref<SkGLContext> angleGLCtx(new SkANGLEGLContext);
-    gANGLEGLHelper.init(angleGLCtx.get(), contextWidth, contextHeight);
+    gANGLEGLHelper.init(angleGLCtx.get(), contextWidth, contextHeight,
+                        ringBuffers);
 #endif // SK_ANGLE
     timerCtx = gRealGLHelper.glContext();
 #endif // !defined(SK_SCALAR_IS_FIXED) && SK_SUPPORT_GPU
@@ -18,6 +18,7 @@
         'core.gyp:core',
         'effects.gyp:effects',
         'images.gyp:images',
+        'pdf.gyp:pdf',
         'ports.gyp:ports',
         'utils.gyp:utils',
         'bench_timer',
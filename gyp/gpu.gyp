@@ -170,6 +170,7 @@
       ],
       'dependencies': [
         'angle.gyp:*',
+        'utils.gyp:utils', # SkThreadPool.h
       ],
       'export_dependent_settings': [
         'angle.gyp:*',
@@ -101,6 +101,7 @@
             ],
             'libraries': [
               '-lpng',
+              '-lz',
             ],
           },
           # end libpng stuff
@@ -27,6 +27,8 @@
         '../src/pdf/SkPDFFont.cpp',
         '../src/pdf/SkPDFFont.h',
         '../src/pdf/SkPDFFontImpl.h',
+        '../src/pdf/SkPDFFontSubsetter.cpp',
+        '../src/pdf/SkPDFFontSubsetter.h',
         '../src/pdf/SkPDFFormXObject.cpp',
         '../src/pdf/SkPDFFormXObject.h',
         '../src/pdf/SkPDFGraphicState.cpp',
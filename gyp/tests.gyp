@@ -20,10 +20,12 @@
         '../tests/AnnotationTest.cpp',
         '../tests/AtomicTest.cpp',
         '../tests/BitmapCopyTest.cpp',
+        '../tests/BitmapProcStateTest.cpp',
         '../tests/BitmapGetColorTest.cpp',
         '../tests/BitSetTest.cpp',
         '../tests/BlitRowTest.cpp',
         '../tests/BlurTest.cpp',
+        '../tests/BufferAllocPoolTest.cpp',
         '../tests/CanvasTest.cpp',
         '../tests/ClampRangeTest.cpp',
         '../tests/ClipCacheTest.cpp',
@@ -33,8 +35,11 @@
         '../tests/ColorFilterTest.cpp',
         '../tests/ColorTest.cpp',
         '../tests/DataRefTest.cpp',
+        '../tests/DebugGLCanvas.cpp',
+        '../tests/DebugGLCanvas.h',
         '../tests/DeferredCanvasTest.cpp',
         '../tests/DequeTest.cpp',
+        '../tests/DistanceFieldTextTest.cpp',
         '../tests/DrawBitmapRectTest.cpp',
         '../tests/DrawPathTest.cpp',
         '../tests/DrawTextTest.cpp',
@@ -46,24 +51,39 @@
         '../tests/FontHostTest.cpp',
         '../tests/GeometryTest.cpp',
         '../tests/GLInterfaceValidation.cpp',
+        '../tests/GLProgramStoreTest.cpp',
         '../tests/GLProgramsTest.cpp',
+        '../tests/GLStateTest.cpp',
+        '../tests/GlyphStoreTest.cpp',
         '../tests/GpuBitmapCopyTest.cpp',
         '../tests/GrContextFactoryTest.cpp',
         '../tests/GradientTest.cpp',
         '../tests/GrMemoryPoolTest.cpp',
+        '../tests/GrRectanizerTest.cpp',
+        '../tests/ImageDecodingTest.cpp',
+        '../tests/ImageEncoderTest.cpp',
+        '../tests/InOrderDrawBufferTest.cpp',
         '../tests/InfRectTest.cpp',
         '../tests/MathTest.cpp',
         '../tests/MatrixTest.cpp',
         '../tests/Matrix44Test.cpp',
         '../tests/MemsetTest.cpp',
         '../tests/MetaDataTest.cpp',
+        '../tests/MipMapTest.cpp',
         '../tests/PackBitsTest.cpp',
         '../tests/PaintTest.cpp',
         '../tests/ParsePathTest.cpp',
         '../tests/PathCoverageTest.cpp',
         '../tests/PathMeasureTest.cpp',
         '../tests/PathTest.cpp',
+        '../tests/PathVertexCacheTest.cpp',
+        '../tests/PDFCompressionTest.cpp',
+        '../tests/PDFContentStreamTest.cpp',
+        '../tests/PDFFontSubsetTest.cpp',
+        '../tests/PDFImageTest.cpp',
+        '../tests/PDFPicturesTest.cpp',
         '../tests/PDFPrimitivesTest.cpp',
+        '../tests/PDFStreamTest.cpp',
         '../tests/PipeTest.cpp',
         '../tests/PictureUtilsTest.cpp',
         '../tests/PointTest.cpp',
@@ -75,10 +95,12 @@
         '../tests/RefCntTest.cpp',
         '../tests/RefDictTest.cpp',
         '../tests/RegionTest.cpp',
+        '../tests/ResourceCacheTest.cpp',
         '../tests/ScalarTest.cpp',
         '../tests/ShaderOpacityTest.cpp',
         '../tests/Sk64Test.cpp',
         '../tests/skia_test.cpp',
+        '../tests/SoftwarePathRendererTest.cpp',
         '../tests/SortTest.cpp',
         '../tests/SrcOverTest.cpp',
         '../tests/StreamTest.cpp',
@@ -87,6 +109,7 @@
         '../tests/Test.cpp',
         '../tests/Test.h',
         '../tests/TestSize.cpp',
+        '../tests/TextBatchTest.cpp',
         '../tests/TLSTest.cpp',
         '../tests/ToUnicode.cpp',
         '../tests/UnicodeTest.cpp',
@@ -34,6 +34,8 @@
         '../include/utils/SkParsePaint.h',
         '../include/utils/SkParsePath.h',
         '../include/utils/SkProxyCanvas.h',
+        '../include/utils/SkRunnable.h',
+        '../include/utils/SkThreadPool.h',
         '../include/utils/SkUnitMappers.h',
         '../include/utils/SkWGL.h',
 
@@ -60,6 +62,7 @@
         '../src/utils/SkParseColor.cpp',
         '../src/utils/SkParsePath.cpp',
         '../src/utils/SkProxyCanvas.cpp',
+        '../src/utils/SkThreadPool.cpp',
         '../src/utils/SkThreadUtils.h',
         '../src/utils/SkThreadUtils_pthread.cpp',
         '../src/utils/SkThreadUtils_pthread.h',
@@ -101,6 +101,13 @@ public:
 private:
     void    drawText_asPaths(const char text[], size_t byteLength,
                              SkScalar x, SkScalar y, const SkPaint&) const;
+    void    drawText_asDistanceFields(const char text[], size_t byteLength,
+                                      SkScalar x, SkScalar y,
+                                      const SkPaint&) const;
+    void    drawPosText_asDistanceFields(const char text[], size_t byteLength,
+                                         const SkScalar pos[], SkScalar constY,
+                                         int scalarsPerPosition,
+                                         const SkPaint&) const;
     void    drawDevMask(const SkMask& mask, const SkPaint&) const;
     void    drawBitmapAsMask(const SkBitmap&, const SkPaint&) const;
 
@@ -21,6 +21,15 @@ class SkStream;
 */
 class SkFlate {
 public:
+    /** The compression levels accepted by Deflate: 0 (no compression) to
+        9 (best compression), or kDefault_CompressionLevel.
+     */
+    enum {
+        kDefault_CompressionLevel = -1,  //!< zlib's default, currently 6.
+        kMin_CompressionLevel     = 0,
+        kMax_CompressionLevel     = 9,
+    };
+
     /** Indicates if the flate algorithm is available.
      */
     static bool HaveFlate();
@@ -29,19 +38,22 @@ public:
      *  Use the flate compression algorithm to compress the data in src,
      *  putting the result into dst.  Returns false if an error occurs.
      */
-    static bool Deflate(SkStream* src, SkWStream* dst);
+    static bool Deflate(SkStream* src, SkWStream* dst,
+                        int level = kDefault_CompressionLevel);
 
     /**
      *  Use the flate compression algorithm to compress the data in src,
      *  putting the result into dst.  Returns false if an error occurs.
      */
-    static bool Deflate(const void* src, size_t len, SkWStream* dst);
+    static bool Deflate(const void* src, size_t len, SkWStream* dst,
+                        int level = kDefault_CompressionLevel);
 
     /**
      *  Use the flate compression algorithm to compress the data,
      *  putting the result into dst.  Returns false if an error occurs.
      */
-    static bool Deflate(const SkData*, SkWStream* dst);
+    static bool Deflate(const SkData*, SkWStream* dst,
+                        int level = kDefault_CompressionLevel);
 
     /** Use the flate compression algorithm to decompress the data in src,
         putting the result into dst.  Returns false if an error occurs.
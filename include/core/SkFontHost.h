@@ -170,6 +170,15 @@ public:
      */
     static void FilterRec(SkScalerContextRec* rec);
 
+    /** Return a non-zero value that identifies how this fonthost's scaler
+        contexts turn a rec into glyphs, for settings that can change without
+        a rebuild (e.g. the version of a system font library, or which of its
+        features are available). Glyphs saved by one process are only reused
+        by another that returns the same value. Return 0 if that can't be
+        told, in which case glyphs are never saved.
+     */
+    static uint32_t GetScalerID();
+
     ///////////////////////////////////////////////////////////////////////////
 
     /** Retrieve detailed typeface metrics.  Used by the PDF backend.
@@ -60,10 +60,63 @@ public:
      */
     static void PurgeFontCache();
 
+    /**
+     *  Look up glyphs in the glyph store at path, before generating them, so
+     *  that processes can reuse the glyphs earlier ones generated. Glyphs are
+     *  only added to the store by FlushGlyphStore(), and only for strikes
+     *  created after this is called, so call it before drawing any text.
+     *  Passing NULL stops using a store.
+     *
+     *  Returns true if path holds a valid store, and false if it is missing
+     *  (e.g. the first time), or was written by a different version of the
+     *  library, or with a different font rasterizer or rasterizer settings
+     *  (see SkFontHost::GetScalerID()), or is corrupt. In those cases glyphs
+     *  are generated as usual, and the next flush replaces the file.
+     */
+    static bool SetGlyphStorePath(const char path[]);
+
+    /**
+     *  Add the glyphs in the font cache to the glyph store set by
+     *  SetGlyphStorePath(), replacing its file. The new file is written
+     *  to a temporary file of its own and then renamed over the old one, so
+     *  other processes reading or flushing the store never see a partial
+     *  file. Term() calls this too.
+     *
+     *  Returns false if there is no glyph store, or it couldn't be written.
+     */
+    static bool FlushGlyphStore();
+
+    /**
+     *  Return the max number of bytes that should be used by the cache of
+     *  mipmaps the raster backend builds for minified bitmap draws. If the
+     *  cache needs to allocate more, it will purge previous entries.
+     */
+    static size_t GetMipMapCacheLimit();
+
+    /**
+     *  Specify the max number of bytes that should be used by the mipmap
+     *  cache. Passing 0 disables automatic mipmapping.
+     *
+     *  This function returns the previous setting, as if
+     *  GetMipMapCacheLimit() had be called before the new limit was set.
+     */
+    static size_t SetMipMapCacheLimit(size_t bytes);
+
+    /**
+     *  Return the number of bytes currently used by the mipmap cache.
+     */
+    static size_t GetMipMapCacheUsed();
+
+    /**
+     *  Release all of the mipmaps held by the cache. Mipmaps still in use by a
+     *  draw stay alive until that draw is done with them.
+     */
+    static void PurgeMipMapCache();
+
     /**
      *  Applications with command line options may pass optional state, such
      *  as cache sizes, here, for instance:
-     *  font-cache-limit=12345678
+     *  font-cache-limit=12345678;mipmap-cache-limit=12345678
      *
      *  The flags format is name=value[;name=value...] with no spaces.
      *  This format is subject to change.
@@ -39,6 +39,11 @@ void    sk_fflush(SkFILE*);
 int     sk_fseek( SkFILE*, size_t, int );
 size_t  sk_ftell( SkFILE* );
 
+/** Sets tmpPath to a path next to path that no other thread or process will
+    choose, for writing a file that is then renamed over path.
+*/
+void    sk_make_temp_path(const char path[], SkString* tmpPath);
+
 class SkOSFile {
 public:
     class Iter {
@@ -104,11 +104,13 @@ public:
         kAutoHinting_Flag     = 0x800,  //!< mask to force Freetype's autohinter
         kVerticalText_Flag    = 0x1000,
         kGenA8FromLCD_Flag    = 0x2000, // hack for GDI -- do not use if you can help it
+        kHighQualityFilterBitmap_Flag = 0x4000, //!< mask to enable bicubic bitmap filtering
+        kDistanceFieldText_Flag = 0x8000, //!< mask to draw text from scalable distance fields
 
         // when adding extra flags, note that the fFlags member is specified
         // with a bit-width and you'll have to expand it.
 
-        kAllFlags = 0x3FFF
+        kAllFlags = 0xFFFF
     };
 
     /** Return the paint's flags. Use the Flag enum to test flag values.
@@ -277,6 +279,32 @@ public:
 
     void setFilterBitmap(bool filterBitmap);
 
+    /** Helper for getFlags(), returning true if kHighQualityFilterBitmap_Flag
+        bit is set. When set, scaled 32bit bitmaps are resampled with a
+        bicubic filter on the raster backend, which is slower than
+        kFilterBitmap_Flag but keeps detail (and avoids aliasing) when the
+        bitmap is drawn much smaller than its natural size.
+    */
+    bool isHighQualityFilterBitmap() const {
+        return SkToBool(this->getFlags() & kHighQualityFilterBitmap_Flag);
+    }
+
+    void setHighQualityFilterBitmap(bool highQualityFilterBitmap);
+
+    /** Helper for getFlags(), returning true if kDistanceFieldText_Flag bit is
+        set. When set, the raster backend draws text by scaling glyphs from
+        signed distance fields, which are generated once at a single size, so
+        text drawn at many sizes or rotations (e.g. while zooming) shares one
+        font cache strike. Hinting, LCD and subpixel text are ignored, and
+        the glyphs are slightly softer than normal ones. Text with a path
+        effect, mask filter, rasterizer or stroke is drawn normally.
+    */
+    bool isDistanceFieldText() const {
+        return SkToBool(this->getFlags() & kDistanceFieldText_Flag);
+    }
+
+    void setDistanceFieldText(bool distanceFieldText);
+
     /** Styles apply to rect, oval, path, and text.
         Bitmaps are always drawn in "fill", and lines are always drawn in
         "stroke".
@@ -936,6 +964,8 @@ private:
 
     enum PrivFlags {
         kNoDrawAnnotation_PrivFlag  = 1 << 0,
+        // the font cache strike holds distance fields (see SkDraw)
+        kDistanceFieldGlyphs_PrivFlag = 1 << 1,
     };
 
     SkDrawCacheProc    getDrawCacheProc() const;
@@ -952,10 +982,12 @@ private:
                         void* context, bool ignoreGamma = false) const;
 
     enum {
-        kCanonicalTextSizeForPaths = 64
+        kCanonicalTextSizeForPaths = 64,
+        kCanonicalTextSizeForDistanceFields = 48
     };
     friend class SkAutoGlyphCache;
     friend class SkCanvas;
+    friend class SkDistanceFieldText;
     friend class SkDraw;
     friend class SkPDFDevice;
     friend class SkTextToPathIter;
@@ -16,6 +16,7 @@
 #include "SkFlattenable.h"
 
 class SkColorTable;
+class SkData;
 struct SkIRect;
 class SkMutex;
 
@@ -119,6 +120,13 @@ public:
 
     bool readPixels(SkBitmap* dst, const SkIRect* subset = NULL);
 
+    /** If the pixels were decoded from an encoded image (e.g. a JPEG) that the
+        pixelref still has, return the encoded data with its ref count
+        incremented, so that it can be passed through instead of re-encoding
+        the pixels. Otherwise return NULL.
+    */
+    SkData* refEncodedData() { return this->onRefEncodedData(); }
+
     /** Makes a deep copy of this PixelRef, respecting the requested config.
         Returns NULL if either there is an error (e.g. the destination could
         not be created with the given config), or this PixelRef does not
@@ -163,6 +171,10 @@ protected:
      */
     virtual bool onReadPixels(SkBitmap* dst, const SkIRect* subsetOrNull);
 
+    /** The base class implementation returns NULL.
+     */
+    virtual SkData* onRefEncodedData();
+
     /** Return the mutex associated with this pixelref. This value is assigned
         in the constructor, and cannot change during the lifetime of the object.
     */
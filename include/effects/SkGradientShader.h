@@ -129,6 +129,41 @@ public:
                                  const SkColor colors[], const SkScalar pos[],
                                  int count, SkUnitMapper* mapper = NULL);
 
+    /**
+     *  Gradients with the same colors, positions and mapper share their color
+     *  tables through a process-wide cache, regardless of their geometry.
+     *  These report on and tune that cache.
+     */
+    struct CacheStats {
+        size_t  fBytesUsed;     // memory held by the cached tables
+        size_t  fByteLimit;     // see SetCacheLimit()
+        int     fEntryCount;    // number of tables in the cache
+        int     fHitCount;      // lookups that found an existing table
+        int     fMissCount;     // lookups that had to build a new table
+        int     fPurgeCount;    // tables evicted to stay within the limit
+    };
+
+    static void GetCacheStats(CacheStats*);
+
+    /**
+     *  Return the max number of bytes that should be used by the gradient
+     *  table cache. If the cache needs to allocate more, it will purge the
+     *  least recently used tables.
+     */
+    static size_t GetCacheLimit();
+
+    /**
+     *  Specify the max number of bytes that should be used by the gradient
+     *  table cache. Passing 0 disables sharing. Returns the previous setting.
+     */
+    static size_t SetCacheLimit(size_t bytes);
+
+    /**
+     *  Release all the tables held by the cache. Tables still in use by a
+     *  shader stay alive until that shader is done with them.
+     */
+    static void PurgeCache();
+
     SK_DECLARE_FLATTENABLE_REGISTRAR_GROUP()
 };
 
@@ -30,9 +30,11 @@ class GrIndexBufferAllocPool;
 class GrInOrderDrawBuffer;
 class GrPathRenderer;
 class GrPathRendererChain;
+class GrPathVertexCache;
 class GrResourceEntry;
 class GrResourceCache;
 class GrStencilBuffer;
+class GrTextBatch;
 class GrVertexBuffer;
 class GrVertexBufferAllocPool;
 class GrSoftwarePathRenderer;
@@ -52,6 +54,14 @@ public:
      */
     static int GetThreadInstanceCount();
 
+    /**
+     * Sets the file in which contexts created after this call keep the
+     * shader programs they build, so that later processes can load them
+     * rather than compile them again. Programs that were saved are built
+     * when the context is created. NULL (the default) turns this off.
+     */
+    static void SetProgramCachePath(const char path[]);
+
     virtual ~GrContext();
 
     /**
@@ -93,6 +103,44 @@ public:
      */
     size_t getGpuTextureCacheBytes() const;
 
+    /**
+     * Counts of the drawing done through the context since the last call to
+     * resetDrawStats(). Reset them at the start of each frame to get per-frame
+     * counts.
+     */
+    struct DrawStats {
+        int fRecordedDraws;     //!< draws recorded by the draw buffer
+        int fMergedDraws;       //!< recorded draws appended to the previous
+                                //!< draw rather than issued separately
+        int fIssuedDraws;       //!< draws issued to the 3D API
+        int fStateChanges;      //!< draw state and clip changes played back
+                                //!< from the draw buffer
+        int fClipMasksRendered; //!< clip masks drawn into the stencil buffer
+                                //!< or an alpha texture
+        int fClipMasksFound;    //!< alpha clip masks found in the texture
+                                //!< cache rather than drawn again
+        int fPathMasksRendered; //!< path masks rasterized in software
+        int fPathMasksFound;    //!< software path masks found in the
+                                //!< texture cache rather than rasterized
+        int fGeometryBytesUploaded;     //!< vertex and index bytes written
+                                        //!< to buffers
+        int fGeometryBuffersCreated;    //!< vertex and index buffers created
+                                        //!< to hold geometry
+        int fGeometryBufferLocks;       //!< vertex and index buffers locked
+                                        //!< (mapped) to write geometry
+    };
+
+    void getDrawStats(DrawStats* stats) const;
+    void resetDrawStats();
+
+    /**
+     * Saves the shader programs built so far to the file set with
+     * SetProgramCachePath() when the context was created. Returns false if
+     * there is no such file, the backend can't save programs, or writing
+     * failed.
+     */
+    bool flushProgramCache();
+
     ///////////////////////////////////////////////////////////////////////////
     // Textures
 
@@ -230,6 +278,73 @@ public:
      */
     void setTextureCacheLimits(int maxTextures, size_t maxTextureBytes);
 
+    /**
+     *  Return the limits a category of cached resources is held to on top of
+     *  the texture cache limits. By default scratch textures may use at most
+     *  half of the cache's bytes (as set by setTextureCacheLimits()), so that
+     *  bursts of them can't push out all the content textures; the other
+     *  categories have no limits of their own.
+     */
+    void getResourceCacheCategoryLimits(GrResourceCategory category,
+                                        int* maxResources,
+                                        size_t* maxResourceBytes) const;
+
+    /**
+     *  Specify the limits a category of cached resources is held to. When a
+     *  category exceeds either of these its own resources are purged (LRU),
+     *  even if the cache as a whole is within its limits. Once set, the
+     *  scratch texture limits no longer follow setTextureCacheLimits().
+     */
+    void setResourceCacheCategoryLimits(GrResourceCategory category,
+                                        int maxResources,
+                                        size_t maxResourceBytes);
+
+    /**
+     *  What the resource cache holds of a category of resources, and how
+     *  lookups for them have fared since the context was created.
+     */
+    struct ResourceCacheStats {
+        int     fCount;     //!< resources currently cached
+        size_t  fBytes;     //!< bytes used by those resources
+        int     fHits;      //!< lookups that found a resource
+        int     fMisses;    //!< lookups that found nothing
+        int     fPurges;    //!< resources purged to stay within the limits
+    };
+
+    void getResourceCacheStats(GrResourceCategory category,
+                               ResourceCacheStats* stats) const;
+
+    /**
+     *  Return and specify the most memory the path renderers may use to keep
+     *  the geometry they generate for paths, so that paths drawn again
+     *  (possibly translated) needn't be tessellated again.
+     */
+    size_t getPathVertexCacheLimit() const;
+    void setPathVertexCacheLimit(size_t maxBytes);
+
+    /**
+     *  What the path vertex cache holds, and how lookups in it have fared,
+     *  in the same terms as the resource cache.
+     */
+    void getPathVertexCacheStats(ResourceCacheStats* stats) const;
+
+    /**
+     *  Return and specify whether the vertices and indices of draws are put in
+     *  a few buffers that are reused across flushes, each filled a little at
+     *  a time, rather than in buffers whose contents are replaced at each
+     *  flush. Appending to a buffer that earlier draws may still be reading
+     *  leaves the driver to synchronize the write, with no fence to tell
+     *  whether it will stall, so this is off by default.
+     *
+     *  This is an experimental opt-in. It is meant to be turned on by an
+     *  embedder that flushes about once a frame, on a driver where it has
+     *  measured glBufferSubData to a buffer in use as cheap (bench's
+     *  -ringBuffers flag compares the two on a given device). Nothing in Skia
+     *  turns it on.
+     */
+    bool getGeometryRingBuffers() const;
+    void setGeometryRingBuffers(bool ringBuffers);
+
     /**
      *  Return the max width or height of a texture supported by the current gpu
      */
@@ -755,7 +870,12 @@ public:
     GrGpu* getGpu() { return fGpu; }
     const GrGpu* getGpu() const { return fGpu; }
     GrFontCache* getFontCache() { return fFontCache; }
+    GrPathVertexCache* getPathVertexCache() { return fPathVertexCache; }
+    GrTextBatch* getTextBatch() { return fTextBatch; }
+    // Like prepareToDraw(), but leaves the glyphs in the text batch waiting.
     GrDrawTarget* getTextTarget(const GrPaint& paint);
+    // Whether draws to target wait in the draw buffer until the next flush.
+    bool isBuffered(const GrDrawTarget* target) const;
     const GrIndexBuffer* getQuadIndexBuffer() const;
 
     /**
@@ -792,7 +912,12 @@ private:
     GrDrawState*        fDrawState;
 
     GrResourceCache*    fTextureCache;
+    // true until the scratch texture category limits are set explicitly;
+    // until then they follow the texture cache limits
+    bool                fDefaultScratchLimits;
     GrFontCache*        fFontCache;
+    GrPathVertexCache*  fPathVertexCache;
+    GrTextBatch*        fTextBatch;
 
     GrPathRendererChain*        fPathRendererChain;
     GrSoftwarePathRenderer*     fSoftwarePathRenderer;
@@ -816,8 +941,9 @@ private:
     void setPaint(const GrPaint& paint);
 
     /// Sets the paint and returns the target to draw into. The paint can be NULL in which case the
-    /// draw state is left unmodified.
+    /// draw state is left unmodified. Glyphs waiting in the text batch are drawn first.
     GrDrawTarget* prepareToDraw(const GrPaint*, BufferedDraw);
+    GrDrawTarget* internalPrepareToDraw(const GrPaint*, BufferedDraw);
 
     void internalDrawPath(const GrPaint& paint, const SkPath& path,
                           GrPathFill fill, const GrPoint* translate);
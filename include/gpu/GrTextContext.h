@@ -15,12 +15,17 @@
 #include "GrPaint.h"
 #include "GrMatrix.h"
 
-struct GrGpuTextVertex;
 class GrContext;
+class GrTextBatch;
 class GrTextStrike;
 class GrFontScaler;
-class GrDrawTarget;
 
+/**
+ *  Draws the glyphs of one text draw. Glyphs are added to the context's
+ *  GrTextBatch, which draws consecutive text draws with the same paint,
+ *  matrix and clip together, so they may not be drawn until the context
+ *  draws something else or is flushed.
+ */
 class GrTextContext {
 public:
     GrTextContext(GrContext*,
@@ -31,37 +36,20 @@ public:
     void drawPackedGlyph(GrGlyph::PackedID, GrFixed left, GrFixed top,
                          GrFontScaler*);
 
-    void flush();   // optional; automatically called by destructor
+    void flush();   // optional; draws the glyphs added so far
 
 private:
     GrPaint         fPaint;
-    GrVertexLayout  fVertexLayout;
     GrContext*      fContext;
-    GrDrawTarget*   fDrawTarget;
+    GrTextBatch*    fBatch;
+    bool            fBatchBegun;
 
     GrMatrix        fExtMatrix;
     GrFontScaler*   fScaler;
     GrTextStrike*   fStrike;
 
-    inline void flushGlyphs();
-    void setupDrawTarget();
-
-    enum {
-        kMinRequestedGlyphs      = 1,
-        kDefaultRequestedGlyphs  = 64,
-        kMinRequestedVerts       = kMinRequestedGlyphs * 4,
-        kDefaultRequestedVerts   = kDefaultRequestedGlyphs * 4,
-    };
-
-    GrGpuTextVertex* fVertices;
-
-    int32_t     fMaxVertices;
-    GrTexture*  fCurrTexture;
-    int         fCurrVertex;
-
     GrIRect     fClipRect;
     GrMatrix    fOrigViewMatrix;    // restore previous viewmatrix
 };
 
 #endif
-
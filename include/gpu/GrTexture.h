@@ -139,6 +139,8 @@ public:
 
     static bool NeedsResizing(const GrResourceKey& key);
     static bool IsScratchTexture(const GrResourceKey& key);
+    // true for render targets created with a key of their own (not scratch)
+    static bool IsRenderTargetTexture(const GrResourceKey& key);
     static bool NeedsFiltering(const GrResourceKey& key);
 
 protected:
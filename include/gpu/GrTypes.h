@@ -504,6 +504,28 @@ struct GrCacheData {
     uint8_t                fResourceDomain;
 };
 
+/**
+ * The kinds of resources GrContext's resource cache budgets separately.
+ */
+enum GrResourceCategory {
+    /**
+     * Textures that are reused for any content, e.g. offscreen render targets,
+     * and other render target textures, e.g. cached clip masks
+     */
+    kScratchTexture_GrResourceCategory,
+    /**
+     * Textures holding particular content, e.g. uploaded bitmaps
+     */
+    kContentTexture_GrResourceCategory,
+    kStencilBuffer_GrResourceCategory,
+    /**
+     * Vertex and index buffers, and any other resources
+     */
+    kOther_GrResourceCategory,
+
+    kGrResourceCategoryCount
+};
+
 /**
  * Clips are composed from these objects.
  */
@@ -197,6 +197,7 @@ public:
     GLPtr<GrGLGetQueryObjectui64vProc> fGetQueryObjectui64v;
     GLPtr<GrGLGetQueryObjectuivProc> fGetQueryObjectuiv;
     GLPtr<GrGLGetQueryivProc> fGetQueryiv;
+    GLPtr<GrGLGetProgramBinaryProc> fGetProgramBinary;
     GLPtr<GrGLGetProgramInfoLogProc> fGetProgramInfoLog;
     GLPtr<GrGLGetProgramivProc> fGetProgramiv;
     GLPtr<GrGLGetRenderbufferParameterivProc> fGetRenderbufferParameteriv;
@@ -209,6 +210,8 @@ public:
     GLPtr<GrGLLinkProgramProc> fLinkProgram;
     GLPtr<GrGLMapBufferProc> fMapBuffer;
     GLPtr<GrGLPixelStoreiProc> fPixelStorei;
+    GLPtr<GrGLProgramBinaryProc> fProgramBinary;
+    GLPtr<GrGLProgramParameteriProc> fProgramParameteri;
     GLPtr<GrGLQueryCounterProc> fQueryCounter;
     GLPtr<GrGLReadBufferProc> fReadBuffer;
     GLPtr<GrGLReadPixelsProc> fReadPixels;
@@ -11,6 +11,7 @@
 #define SkImageDecoder_DEFINED
 
 #include "SkBitmap.h"
+#include "SkRect.h"
 #include "SkRefCnt.h"
 
 class SkStream;
@@ -91,6 +92,30 @@ public:
     Chooser* getChooser() const { return fChooser; }
     Chooser* setChooser(Chooser*);
 
+    /** \class RowListener
+
+        Optional callback that is told as rows of the destination bitmap are
+        completed, so that a caller can consume a large image progressively
+        (e.g. display or upload it) while the rest is still being decoded. The
+        rows are written straight into the pixels returned by the Allocator.
+    */
+    class RowListener : public SkRefCnt {
+    public:
+        SK_DECLARE_INST_COUNT(RowListener)
+
+        /** Rows [startY, startY + count) of bitmap are now final. Return true
+            to continue decoding, or false to cancel the decode.
+        */
+        virtual bool onRowsDecoded(const SkBitmap& bitmap, int startY,
+                                   int count) = 0;
+
+    private:
+        typedef SkRefCnt INHERITED;
+    };
+
+    RowListener* getRowListener() const { return fRowListener; }
+    RowListener* setRowListener(RowListener*);
+
     /** This optional table describes the caller's preferred config based on
         information about the src data. For this table, the src attributes are
         described in terms of depth (index (8), 16, 32/24) and if there is
@@ -178,6 +203,28 @@ public:
         return this->decode(stream, bitmap, SkBitmap::kNo_Config, mode);
     }
 
+    /** Prepare to decode arbitrary regions of the image in stream, without
+        decoding (or allocating memory for) the rest of it. On success, width
+        and height are set to the dimensions of the whole image.
+
+        The decoder refs the stream, which must support rewind(), and keeps it
+        until the decoder is deleted or another index is built.
+
+        Returns false if the stream can't be read, or if this format does not
+        support region decoding (currently only JPEG and PNG do).
+    */
+    bool buildTileIndex(SkStream*, int* width, int* height);
+
+    /** Decode the part of the image inside rect (in the coordinates of the
+        whole image, and clipped to it) into bitmap, after a successful call to
+        buildTileIndex(). The sample size, Allocator and RowListener are
+        honored as they are by decode(). Only the rows up to the bottom of rect
+        are read from the stream, and only one row of the image (rather than
+        all of it) is buffered at a time.
+    */
+    bool decodeRegion(SkBitmap* bitmap, const SkIRect& rect,
+                      SkBitmap::Config pref);
+
     /** Given a stream, this will try to find an appropriate decoder object.
         If none is found, the method returns NULL.
     */
@@ -266,6 +313,16 @@ protected:
     // must be overridden in subclasses. This guy is called by decode(...)
     virtual bool onDecode(SkStream*, SkBitmap* bitmap, Mode) = 0;
 
+    // override both of these to support region decoding. onDecodeRegion is
+    // only called after onBuildTileIndex succeeded, with rect already clipped
+    // to the image (and not empty).
+    virtual bool onBuildTileIndex(SkStream*, int* width, int* height) {
+        return false;
+    }
+    virtual bool onDecodeRegion(SkBitmap* bitmap, const SkIRect& rect) {
+        return false;
+    }
+
     /** Can be queried from within onDecode, to see if the user (possibly in
         a different thread) has requested the decode to cancel. If this returns
         true, your onDecode() should stop and return false.
@@ -291,6 +348,13 @@ protected:
     */
     bool allocPixelRef(SkBitmap*, SkColorTable*) const;
 
+    /*  Helper for subclasses. Call this as rows of bitmap are completed, to
+        pass them on to the RowListener (if any). Returns false if the decode
+        should be cancelled.
+    */
+    bool notifyRowsDecoded(const SkBitmap& bitmap, int startY,
+                           int count) const;
+
     enum SrcDepth {
         kIndex_SrcDepth,
         k16Bit_SrcDepth,
@@ -309,6 +373,7 @@ protected:
 private:
     Peeker*                 fPeeker;
     Chooser*                fChooser;
+    RowListener*            fRowListener;
     SkBitmap::Allocator*    fAllocator;
     int                     fSampleSize;
     SkBitmap::Config        fDefaultPref;   // use if fUsePrefTable is false
@@ -316,6 +381,8 @@ private:
     bool                    fDitherImage;
     bool                    fUsePrefTable;
     mutable bool            fShouldCancelDecode;
+    int                     fIndexWidth;    // set by buildTileIndex()
+    int                     fIndexHeight;
 
     // illegal
     SkImageDecoder(const SkImageDecoder&);
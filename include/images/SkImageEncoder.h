@@ -21,6 +21,7 @@ public:
     };
     static SkImageEncoder* Create(Type);
 
+    SkImageEncoder();
     virtual ~SkImageEncoder();
 
     /*  Quality ranges from 0..100 */
@@ -28,6 +29,16 @@ public:
         kDefaultQuality = 80
     };
 
+    /**
+     *  Allow the encoder to use up to count threads for a single image. Large
+     *  PNGs are deflated in independent bands, and large JPEGs are encoded in
+     *  strips separated by restart markers, so the output is still a single
+     *  valid file (though not byte-identical to a single threaded encode).
+     *  The default is 1, which encodes on the calling thread.
+     */
+    void setThreadCount(int count);
+    int getThreadCount() const { return fThreadCount; }
+
     bool encodeFile(const char file[], const SkBitmap&, int quality);
     bool encodeStream(SkWStream*, const SkBitmap&, int quality);
 
@@ -38,6 +49,9 @@ public:
 
 protected:
     virtual bool onEncode(SkWStream*, const SkBitmap&, int quality) = 0;
+
+private:
+    int fThreadCount;
 };
 
 // This macro declares a global (i.e., non-class owned) creation entry point
@@ -75,6 +75,8 @@ protected:
     // override this in your subclass to clean up when we're unlocking pixels
     virtual void onUnlockPixels();
 
+    virtual SkData* onRefEncodedData() SK_OVERRIDE;
+
     SkImageRef(SkFlattenableReadBuffer&);
     virtual void flatten(SkFlattenableWriteBuffer&) const SK_OVERRIDE;
 
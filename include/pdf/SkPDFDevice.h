@@ -26,6 +26,7 @@ class SkPDFFont;
 class SkPDFFormXObject;
 class SkPDFGlyphSetMap;
 class SkPDFGraphicState;
+class SkPDFImage;
 class SkPDFObject;
 class SkPDFShader;
 class SkPDFStream;
@@ -139,6 +140,13 @@ public:
      */
     SK_API const SkTDArray<SkPDFFont*>& getFontResources() const;
 
+    /** Get the images drawn on this device, including those drawn on the
+     *  devices drawn into it.
+     */
+    SK_API const SkTDArray<SkPDFImage*>& getImageResources() const {
+        return fImageResources;
+    }
+
     /** Returns the media box for this device.
      */
     SK_API SkRefPtr<SkPDFArray> getMediaBox() const;
@@ -192,6 +200,8 @@ private:
     SkTDArray<SkPDFObject*> fXObjectResources;
     SkTDArray<SkPDFFont*> fFontResources;
     SkTDArray<SkPDFObject*> fShaderResources;
+    // Every image in fXObjectResources or in the form xobjects there.
+    SkTDArray<SkPDFImage*> fImageResources;
 
     SkTScopedPtr<ContentEntry> fContentEntries;
     ContentEntry* fLastContentEntry;
@@ -219,7 +229,7 @@ private:
                                                Usage usage) SK_OVERRIDE;
 
     void init();
-    void cleanUp(bool clearFontUsage);
+    void cleanUp(bool clearUsage);
     void createFormXObjectFromDevice(SkRefPtr<SkPDFFormXObject>* xobject);
 
     // Clear the passed clip from all existing content entries.
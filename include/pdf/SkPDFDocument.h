@@ -18,8 +18,10 @@
 class SkPDFCatalog;
 class SkPDFDevice;
 class SkPDFDict;
+class SkPDFImage;
 class SkPDFPage;
 class SkPDFObject;
+class SkPicture;
 class SkWStream;
 
 /** \class SkPDFDocument
@@ -64,6 +66,53 @@ public:
      */
     SK_API bool appendPage(SkPDFDevice* pdfDevice);
 
+    /** Draw each of the passed pictures into a new page the size of the
+     *  picture and append the pages to the document, in order.  The pages
+     *  are drawn concurrently, on up to getThreadCount() threads, but the
+     *  document is the same as if each picture had been drawn into an
+     *  SkPDFDevice and passed to appendPage() in turn.  A picture may be
+     *  passed more than once.  Returns true if successful.
+     *
+     *  @param pictures The pages to add to this document.
+     *  @param count    The number of pictures.
+     */
+    SK_API bool appendPictures(SkPicture* const pictures[], int count);
+
+    /** Start writing the document to the passed stream as pages are
+     *  appended, instead of holding every page in memory until emitPDF().
+     *  Each page and its content are written (and released) by appendPage(),
+     *  as are the resources it uses that no earlier page used; resources are
+     *  kept until the document is finished, so each is written once.  Fonts
+     *  are written by endStream(), once the glyphs used by the whole document
+     *  are known.  Must be called before
+     *  any pages are added.  While streaming, setPage() and emitPDF() fail.
+     *  Returns true if successful.
+     *
+     *  @param stream    The writable output stream to send the PDF to.  It
+     *                   must remain valid until endStream() is called.
+     */
+    SK_API bool beginStream(SkWStream* stream);
+
+    /** Finish a document started with beginStream(): write the fonts, the
+     *  page tree, the cross reference table and the trailer.  It is an error
+     *  to call this (it will return false) if no pages have been appended.
+     */
+    SK_API bool endStream();
+
+    /** Set the flate compression level (0 to 9, or -1 for zlib's default)
+     *  used for the document's streams.  Has no effect if the document was
+     *  created with kNoCompression_Flags.
+     */
+    SK_API void setCompressionLevel(int level);
+
+    /** Set the number of threads used to draw pictures (appendPictures())
+     *  and to compress the document's streams before they are written.  The
+     *  output doesn't depend on the thread count.  The default is 1
+     *  (everything is done on the calling thread).
+     */
+    SK_API void setThreadCount(int count);
+    SK_API int getThreadCount() const { return fThreadCount; }
+
     /** Get the count of unique font types used in the document.
      */
     SK_API void getCountOfFontTypes(
@@ -79,9 +128,37 @@ private:
     SkTDArray<SkPDFObject*> fPageResources;
     SkTDArray<SkPDFObject*> fSubstitutes;
     int fSecondPageFirstResourceIndex;
+    int fThreadCount;
+
+    // The images written (or to be written) so far, one for each distinct
+    // image; see canonicalizeImages().
+    SkTDArray<SkPDFImage*> fImages;
 
     SkRefPtr<SkPDFDict> fTrailerDict;
 
+    // State for a document being written by beginStream()/endStream().
+    struct StreamState;
+    SkTScopedPtr<StreamState> fStreamState;
+
+    /** Write the passed page and its resources to the stream state.
+     */
+    void streamPage(SkPDFPage* page);
+
+    /** Make each image on the passed page that is the same as an image
+     *  used by an earlier page (or earlier on this page) an alias of it
+     *  in the catalog, and remove the alias and its resources from
+     *  resourceList.  Other images are added to fImages.  Pages are done in
+     *  order, on the document's thread, so which image is written doesn't
+     *  depend on how the pages were drawn.
+     *  @param page          The page whose images to look at.
+     *  @param resourceList  The page's resources, from finalizePage().
+     *  @param aliases       Output: the page's images that were made
+     *                       aliases.  Not ref'd.
+     */
+    void canonicalizeImages(SkPDFPage* page,
+                            SkTDArray<SkPDFObject*>* resourceList,
+                            SkTDArray<SkPDFImage*>* aliases);
+
     /** Output the PDF header to the passed stream.
      *  @param stream    The writable output stream to send the header to.
      */
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkThreadPool_DEFINED
+#define SkThreadPool_DEFINED
+
+#include "SkTDArray.h"
+
+class SkRunnable;
+class SkThread;
+
+/**
+ *  Runs batches of independent jobs on up to count threads. Jobs are queued
+ *  with add(), and started by wait(), which returns once all of them have
+ *  run. The pool does not own the jobs.
+ */
+class SkThreadPool : SkNoncopyable {
+public:
+    /**
+     *  Use up to count threads. If count is 0 or 1, wait() runs the jobs
+     *  on the calling thread, in the order they were added.
+     */
+    explicit SkThreadPool(int count);
+    ~SkThreadPool();
+
+    int threadCount() const { return fThreadCount; }
+
+    /**
+     *  Queue a job, to be run by the next call to wait().
+     */
+    void add(SkRunnable*);
+
+    /**
+     *  Run every queued job, and return when they have all finished. Jobs may
+     *  run in any order, and concurrently with each other.
+     */
+    void wait();
+
+    /**
+     *  Return the number of processors the system says are online, or 1 if
+     *  we can't tell.
+     */
+    static int NumCores();
+
+private:
+    SkTDArray<SkRunnable*>  fQueue;
+    int32_t                 fNext;
+    int                     fThreadCount;
+
+    static void Loop(void*);
+};
+
+#endif
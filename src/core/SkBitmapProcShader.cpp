@@ -129,6 +129,11 @@ bool SkBitmapProcShader::setContext(const SkBitmap& device,
             break;
     }
 
+    if (fState.fDoHighQualityFilter) {
+        // only the 32bit path knows how to resample with the bicubic filter
+        flags &= ~kHasSpan16_Flag;
+    }
+
     if (paint.isDither() && bitmap.config() != SkBitmap::kRGB_565_Config) {
         // gradients can auto-dither in their 16bit sampler, but we don't so
         // we clear the flag here.
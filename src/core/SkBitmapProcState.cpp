@@ -8,6 +8,7 @@
 #include "SkBitmapProcState.h"
 #include "SkColorPriv.h"
 #include "SkFilterProc.h"
+#include "SkMipMap.h"
 #include "SkPaint.h"
 #include "SkShader.h"   // for tilemodes
 #include "SkUtilsArm.h"
@@ -38,6 +39,54 @@ static bool valid_for_filtering(unsigned dimension) {
     return (dimension & ~0x3FFF) == 0;
 }
 
+SkBitmapProcState::SkBitmapProcState() : fCurrMip(NULL) {}
+
+SkBitmapProcState::~SkBitmapProcState() {
+    SkSafeUnref(fCurrMip);
+}
+
+/*  When a filtered draw minifies the bitmap, sample from a mip level that is
+    close to the destination size instead: it aliases far less, and touches
+    far less memory. Returns true if fMipBitmap was set up to be used.
+ */
+bool SkBitmapProcState::chooseAutoMipLevel(const SkMatrix& inv,
+                                           const SkPaint& paint) {
+    if (!(paint.isFilterBitmap() || paint.isHighQualityFilterBitmap()) ||
+            inv.hasPerspective() || NULL == fOrigBitmap.pixelRef() ||
+            fOrigBitmap.isVolatile() || fOrigBitmap.getTexture()) {
+        return false;
+    }
+
+    // the length of one device pixel step, measured in the bitmap
+    SkScalar scale = SkMaxScalar(
+            SkPoint::Length(inv.getScaleX(), inv.getSkewY()),
+            SkPoint::Length(inv.getSkewX(), inv.getScaleY()));
+
+    // bicubic widens its kernel for residual scales up to 2, so round down
+    // for it; bilinear does best with the nearest level
+    const bool roundDown = paint.isHighQualityFilterBitmap();
+    if (SkMipMap::ComputeLevel(scale, roundDown) <= 0) {
+        return false;
+    }
+
+    SkMipMap* mip = SkMipMap::FindOrBuildAndRef(fOrigBitmap);
+    SkMipMap::Level level;
+    if (NULL == mip || !mip->extractLevel(scale, roundDown, &level)) {
+        SkSafeUnref(mip);
+        return false;
+    }
+
+    // fMipBitmap doesn't own its pixels, so hang on to the mipmap that does
+    SkRefCnt_SafeAssign(fCurrMip, mip);
+    mip->unref();
+
+    fMipBitmap.setConfig(fOrigBitmap.config(), level.fWidth, level.fHeight,
+                         level.fRowBytes);
+    fMipBitmap.setPixels(level.fPixels);
+    fMipBitmap.setIsOpaque(fOrigBitmap.isOpaque());
+    return true;
+}
+
 bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
     if (fOrigBitmap.width() == 0 || fOrigBitmap.height() == 0) {
         return false;
@@ -58,22 +107,28 @@ bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
 
     fBitmap = &fOrigBitmap;
     if (fOrigBitmap.hasMipMap()) {
+        // note: we measure inv, since m may be in unit space
         int shift = fOrigBitmap.extractMipLevel(&fMipBitmap,
-                                                SkScalarToFixed(m->getScaleX()),
-                                                SkScalarToFixed(m->getSkewY()));
-
+                                                SkScalarToFixed(inv.getScaleX()),
+                                                SkScalarToFixed(inv.getSkewY()));
         if (shift > 0) {
-            if (m != &fUnitInvMatrix) {
-                fUnitInvMatrix = *m;
-                m = &fUnitInvMatrix;
-            }
-
-            SkScalar scale = SkFixedToScalar(SK_Fixed1 >> shift);
-            fUnitInvMatrix.postScale(scale, scale);
-
             // now point here instead of fOrigBitmap
             fBitmap = &fMipBitmap;
         }
+    } else if (this->chooseAutoMipLevel(inv, paint)) {
+        fBitmap = &fMipBitmap;
+    }
+
+    // The unit space matrix is independent of the bitmap's size, so only a
+    // pixel space matrix needs to be rescaled to address the mip level.
+    if (fBitmap != &fOrigBitmap && m != &fUnitInvMatrix) {
+        fUnitInvMatrix = inv;
+        fUnitInvMatrix.postScale(
+                SkScalarDiv(SkIntToScalar(fBitmap->width()),
+                            SkIntToScalar(fOrigBitmap.width())),
+                SkScalarDiv(SkIntToScalar(fBitmap->height()),
+                            SkIntToScalar(fOrigBitmap.height())));
+        m = &fUnitInvMatrix;
     }
 
     fInvMatrix      = m;
@@ -91,9 +146,12 @@ bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
     // of filtering if we're not scaled etc.).
     // note: we explicitly check inv, since m might be scaled due to unitinv
     //       trickery, but we don't want to see that for this test
-    fDoFilter = paint.isFilterBitmap() &&
+    // note: high quality filtering falls back to bilinear whenever the
+    //       bicubic shaderproc can't handle the bitmap or destination
+    fDoFilter = (paint.isFilterBitmap() || paint.isHighQualityFilterBitmap()) &&
                 (inv.getType() > SkMatrix::kTranslate_Mask &&
                  valid_for_filtering(fBitmap->width() | fBitmap->height()));
+    fDoHighQualityFilter = false;
 
     fShaderProc32 = NULL;
     fShaderProc16 = NULL;
@@ -227,6 +285,10 @@ bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
         fShaderProc32 = SK_ARM_NEON_WRAP(Clamp_SI8_opaque_D32_filter_DX_shaderproc);
     }
 
+    if (fDoFilter && this->setupHighQualityFilter(inv, paint)) {
+        fShaderProc32 = S32_D32_bicubic_shaderproc;
+    }
+
     // see if our platform has any accelerated overrides
     this->platformProcs();
     return true;
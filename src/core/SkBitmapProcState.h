@@ -29,10 +29,14 @@
     #define SkFractionalIntToInt(x)     ((x) >> 16)
 #endif
 
+class SkMipMap;
 class SkPaint;
 
 struct SkBitmapProcState {
 
+    SkBitmapProcState();
+    ~SkBitmapProcState();
+
     typedef void (*ShaderProc32)(const SkBitmapProcState&, int x, int y,
                                  SkPMColor[], int count);
 
@@ -81,6 +85,13 @@ struct SkBitmapProcState {
     uint8_t             fTileModeX;         // CONSTRUCTOR
     uint8_t             fTileModeY;         // CONSTRUCTOR
     SkBool8             fDoFilter;          // chooseProcs
+    SkBool8             fDoHighQualityFilter; // chooseProcs
+
+    // Only used by the high quality (bicubic) shaderproc, which samples in
+    // bitmap pixel space rather than the unit space of fInvMatrix.
+    SkMatrix            fHighQualityInvMatrix;  // chooseProcs
+    float               fHighQualityScaleX;     // chooseProcs
+    float               fHighQualityScaleY;     // chooseProcs
 
     /** Platforms implement this, and can optionally overwrite only the
         following fields:
@@ -134,9 +145,12 @@ private:
     SkMatrix            fUnitInvMatrix;     // chooseProcs
     SkBitmap            fOrigBitmap;        // CONSTRUCTOR
     SkBitmap            fMipBitmap;
+    SkMipMap*           fCurrMip;           // owns fMipBitmap's pixels, if any
 
     MatrixProc chooseMatrixProc(bool trivial_matrix);
     bool chooseProcs(const SkMatrix& inv, const SkPaint&);
+    bool chooseAutoMipLevel(const SkMatrix& inv, const SkPaint&);
+    bool setupHighQualityFilter(const SkMatrix& inv, const SkPaint&);
 
 #ifdef SK_DEBUG
     static void DebugMatrixProc(const SkBitmapProcState&,
@@ -188,5 +202,22 @@ void ClampX_ClampY_nofilter_affine(const SkBitmapProcState& s,
                                    uint32_t xy[], int count, int x, int y);
 void S32_D16_filter_DX(const SkBitmapProcState& s,
                                    const uint32_t* xy, int count, uint16_t* colors);
+void ClampX_ClampY_filter_persp(const SkBitmapProcState& s,
+                                uint32_t xy[], int count, int x, int y);
+void ClampX_ClampY_nofilter_persp(const SkBitmapProcState& s,
+                                  uint32_t xy[], int count, int x, int y);
+void RepeatX_RepeatY_filter_scale(const SkBitmapProcState& s, uint32_t xy[],
+                                  int count, int x, int y);
+void RepeatX_RepeatY_nofilter_scale(const SkBitmapProcState& s, uint32_t xy[],
+                                    int count, int x, int y);
+void GeneralXY_filter_scale(const SkBitmapProcState& s, uint32_t xy[],
+                            int count, int x, int y);
+void GeneralXY_nofilter_scale(const SkBitmapProcState& s, uint32_t xy[],
+                              int count, int x, int y);
+
+// Bicubic resampler selected by SkPaint::kHighQualityFilterBitmap_Flag,
+// defined in SkBitmapProcState_bicubic.cpp.
+void S32_D32_bicubic_shaderproc(const SkBitmapProcState& s, int x, int y,
+                                SkPMColor colors[], int count);
 
 #endif
@@ -0,0 +1,220 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkBitmapProcState.h"
+#include "SkColorPriv.h"
+#include "SkPaint.h"
+#include "SkShader.h"   // for tilemodes
+#include <math.h>
+
+/*  High quality resampling for 32bit bitmaps, selected by
+    SkPaint::kHighQualityFilterBitmap_Flag.
+
+    This is a shaderproc rather than a sampleproc: the matrixprocs hand the
+    sampleprocs 4 bits of subpixel position and 2 taps per axis, which is
+    fine for bilinear but not enough for a 4x4 (or wider, when minifying)
+    kernel. Instead we walk the span in float, and filter directly from the
+    bitmap.
+
+    The kernel is the Mitchell-Netravali cubic with B = C = 1/3, which is a
+    good compromise between blurring and ringing. When the bitmap is drawn
+    smaller than its natural size, the kernel is stretched by the
+    minification factor (up to kMaxFilterScale) so that every source pixel
+    still contributes. Beyond that a mipmap is a better answer.
+ */
+
+// filter support is [-2, 2], so at the max scale we need 2 * 2 * 2 + 1 taps
+#define kMaxFilterScale     2
+#define kMaxTaps            (4 * kMaxFilterScale + 1)
+
+// keep integer tap positions well away from overflow
+#define kMaxCoordinate      (1 << 22)
+
+static inline float mitchell(float x) {
+    x = fabsf(x);
+    if (x < 1) {
+        return (7 * x * x * x - 12 * x * x + 16.0f / 3) * (1.0f / 6);
+    }
+    if (x < 2) {
+        return ((-7.0f / 3) * x * x * x + 12 * x * x - 20 * x + 32.0f / 3) *
+               (1.0f / 6);
+    }
+    return 0;
+}
+
+static inline int tile(int i, int n, unsigned mode) {
+    if ((unsigned)i < (unsigned)n) {
+        return i;
+    }
+    switch (mode) {
+        case SkShader::kClamp_TileMode:
+            return i < 0 ? 0 : n - 1;
+        case SkShader::kRepeat_TileMode:
+            i %= n;
+            return i < 0 ? i + n : i;
+        default: {
+            SkASSERT(SkShader::kMirror_TileMode == mode);
+            int n2 = n << 1;
+            i %= n2;
+            if (i < 0) {
+                i += n2;
+            }
+            return i < n ? i : n2 - 1 - i;
+        }
+    }
+}
+
+/*  Compute the taps (tiled pixel indices and normalized weights) for the
+    kernel centered at the pixel-space coordinate c. Pixel centers are at
+    i + 0.5. Returns the number of taps.
+ */
+static int compute_taps(float c, float scale, int n, unsigned mode,
+                        int indices[kMaxTaps], float weights[kMaxTaps]) {
+    if (c < -kMaxCoordinate) {
+        c = -kMaxCoordinate;
+    } else if (c > kMaxCoordinate) {
+        c = kMaxCoordinate;
+    }
+
+    const float radius = 2 * scale;
+    int first = (int)ceilf(c - 0.5f - radius);
+    int count = (int)floorf(c - 0.5f + radius) - first + 1;
+    if (count > kMaxTaps) {
+        count = kMaxTaps;
+    }
+
+    const float invScale = 1 / scale;
+    float sum = 0;
+    for (int i = 0; i < count; i++) {
+        float w = mitchell((first + i + 0.5f - c) * invScale);
+        indices[i] = tile(first + i, n, mode);
+        weights[i] = w;
+        sum += w;
+    }
+    // the weights sum to ~scale, so this also undoes the stretching
+    const float invSum = 1 / sum;
+    for (int i = 0; i < count; i++) {
+        weights[i] *= invSum;
+    }
+    return count;
+}
+
+static inline unsigned pin_component(float v, unsigned max) {
+    int i = (int)(v + 0.5f);
+    if (i < 0) {
+        return 0;
+    }
+    return (unsigned)i > max ? max : i;
+}
+
+static SkPMColor sample(const SkBitmapProcState& s, float fx, float fy,
+                        float alphaScale) {
+    const SkBitmap& bm = *s.fBitmap;
+
+    int xi[kMaxTaps], yi[kMaxTaps];
+    float xw[kMaxTaps], yw[kMaxTaps];
+    int nx = compute_taps(fx, s.fHighQualityScaleX, bm.width(), s.fTileModeX,
+                          xi, xw);
+    int ny = compute_taps(fy, s.fHighQualityScaleY, bm.height(), s.fTileModeY,
+                          yi, yw);
+
+    float a = 0, r = 0, g = 0, b = 0;
+    for (int j = 0; j < ny; j++) {
+        const SkPMColor* row = bm.getAddr32(0, yi[j]);
+        float ra = 0, rr = 0, rg = 0, rb = 0;
+        for (int i = 0; i < nx; i++) {
+            SkPMColor c = row[xi[i]];
+            float w = xw[i];
+            ra += SkGetPackedA32(c) * w;
+            rr += SkGetPackedR32(c) * w;
+            rg += SkGetPackedG32(c) * w;
+            rb += SkGetPackedB32(c) * w;
+        }
+        float w = yw[j] * alphaScale;
+        a += ra * w;
+        r += rr * w;
+        g += rg * w;
+        b += rb * w;
+    }
+
+    // the negative lobes can overshoot, so pin back to a valid premul color
+    unsigned pa = pin_component(a, 255);
+    return SkPackARGB32(pa, pin_component(r, pa), pin_component(g, pa),
+                        pin_component(b, pa));
+}
+
+void S32_D32_bicubic_shaderproc(const SkBitmapProcState& s, int x, int y,
+                                SkPMColor colors[], int count) {
+    SkASSERT(s.fDoHighQualityFilter);
+    SkASSERT(s.fBitmap->config() == SkBitmap::kARGB_8888_Config);
+    SkASSERT(count > 0);
+
+    const SkMatrix& m = s.fHighQualityInvMatrix;
+    const float alphaScale = s.fAlphaScale * (1.0f / 256);
+
+    SkPoint pt;
+    if (m.hasPerspective()) {
+        SkScalar dstY = SkIntToScalar(y) + SK_ScalarHalf;
+        for (int i = 0; i < count; i++) {
+            m.mapXY(SkIntToScalar(x + i) + SK_ScalarHalf, dstY, &pt);
+            colors[i] = sample(s, SkScalarToFloat(pt.fX),
+                               SkScalarToFloat(pt.fY), alphaScale);
+        }
+        return;
+    }
+
+    m.mapXY(SkIntToScalar(x) + SK_ScalarHalf,
+            SkIntToScalar(y) + SK_ScalarHalf, &pt);
+    float fx = SkScalarToFloat(pt.fX);
+    float fy = SkScalarToFloat(pt.fY);
+    const float dx = SkScalarToFloat(m.getScaleX());
+    const float dy = SkScalarToFloat(m.getSkewY());
+    for (int i = 0; i < count; i++) {
+        colors[i] = sample(s, fx, fy, alphaScale);
+        fx += dx;
+        fy += dy;
+    }
+}
+
+static float filter_scale(SkScalar a, SkScalar b) {
+    // length of the step in source space for one step in device space
+    float scale = sqrtf(SkScalarToFloat(SkScalarMul(a, a) + SkScalarMul(b, b)));
+    if (scale < 1) {
+        return 1;
+    }
+    return scale > kMaxFilterScale ? kMaxFilterScale : scale;
+}
+
+bool SkBitmapProcState::setupHighQualityFilter(const SkMatrix& inv,
+                                               const SkPaint& paint) {
+    if (!paint.isHighQualityFilterBitmap() ||
+            fBitmap->config() != SkBitmap::kARGB_8888_Config) {
+        return false;
+    }
+
+    // work in the pixel space of the bitmap we're actually sampling
+    fHighQualityInvMatrix = inv;
+    if (fBitmap != &fOrigBitmap) {
+        fHighQualityInvMatrix.postScale(
+                SkScalarDiv(SkIntToScalar(fBitmap->width()),
+                            SkIntToScalar(fOrigBitmap.width())),
+                SkScalarDiv(SkIntToScalar(fBitmap->height()),
+                            SkIntToScalar(fOrigBitmap.height())));
+    }
+
+    const SkMatrix& m = fHighQualityInvMatrix;
+    if (m.hasPerspective()) {
+        // the footprint varies across the span; don't guess, just interpolate
+        fHighQualityScaleX = 1;
+        fHighQualityScaleY = 1;
+    } else {
+        fHighQualityScaleX = filter_scale(m.getScaleX(), m.getSkewX());
+        fHighQualityScaleY = filter_scale(m.getSkewY(), m.getScaleY());
+    }
+    fDoHighQualityFilter = true;
+    return true;
+}
@@ -12,6 +12,9 @@
 #include "SkColor.h"
 #include "SkMask.h"
 
+class SkBlitter;
+class SkMatrix;
+
 class SkBlitMask {
 public:
     /**
@@ -85,6 +88,16 @@ public:
      *  or NULL if no optimized routine is available.
      */
     static RowProc PlatformRowProcs(SkBitmap::Config, SkMask::Format, RowFlags);
+
+    /**
+     *  Draws a glyph's signed distance field (see SkDistanceField.h) through
+     *  blitter, as antialiased coverage, limited to clip. field.fBounds is in
+     *  the field's own space, which fieldToDevice maps to the device. The
+     *  matrix may scale, rotate or skew, but not have perspective.
+     */
+    static void BlitDistanceField(SkBlitter* blitter, const SkIRect& clip,
+                                  const SkMask& field,
+                                  const SkMatrix& fieldToDevice);
 };
 
 #endif
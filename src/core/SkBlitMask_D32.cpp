@@ -1,6 +1,11 @@
 #include "SkBlitMask.h"
+#include "SkBlitter.h"
 #include "SkColor.h"
 #include "SkColorPriv.h"
+#include "SkDistanceField.h"
+#include "SkFloatingPoint.h"
+#include "SkMatrix.h"
+#include "SkTemplates.h"
 
 static void D32_A8_Color(void* SK_RESTRICT dst, size_t dstRB,
                          const void* SK_RESTRICT maskPtr, size_t maskRB,
@@ -595,3 +600,102 @@ SkBlitMask::RowProc SkBlitMask::RowFactory(SkBitmap::Config config,
     return NULL;
 }
 
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Bilinearly samples the field at (u, v), where texel centers are on integers.
+// Texels outside the field are taken to be far outside the glyph.
+static float sample_distance_field(const SkMask& field, float u, float v) {
+    const int width = field.fBounds.width();
+    const int height = field.fBounds.height();
+
+    int x = sk_float_floor2int(u);
+    int y = sk_float_floor2int(v);
+    float fx = u - x;
+    float fy = v - y;
+
+    unsigned t[4];
+    if (x >= 0 && y >= 0 && x + 1 < width && y + 1 < height) {
+        const uint8_t* row = field.fImage + y * field.fRowBytes + x;
+        t[0] = row[0];
+        t[1] = row[1];
+        t[2] = row[field.fRowBytes];
+        t[3] = row[field.fRowBytes + 1];
+    } else {
+        for (int i = 0; i < 4; i++) {
+            int tx = x + (i & 1);
+            int ty = y + (i >> 1);
+            if (tx >= 0 && ty >= 0 && tx < width && ty < height) {
+                t[i] = field.fImage[ty * field.fRowBytes + tx];
+            } else {
+                t[i] = 0;
+            }
+        }
+    }
+
+    float top = t[0] + (t[1] - (float)t[0]) * fx;
+    float bottom = t[2] + (t[3] - (float)t[2]) * fx;
+    return top + (bottom - top) * fy;
+}
+
+void SkBlitMask::BlitDistanceField(SkBlitter* blitter, const SkIRect& clip,
+                                   const SkMask& field,
+                                   const SkMatrix& fieldToDevice) {
+    SkASSERT(SkMask::kA8_Format == field.fFormat);
+    SkASSERT(!fieldToDevice.hasPerspective());
+
+    SkRect devRect;
+    devRect.set(field.fBounds);
+    fieldToDevice.mapRect(&devRect);
+    SkIRect bounds;
+    devRect.roundOut(&bounds);
+    if (!bounds.intersect(clip)) {
+        return;
+    }
+
+    SkMatrix inverse;
+    if (!fieldToDevice.invert(&inverse)) {
+        return;
+    }
+    // sample relative to the first texel's center
+    inverse.postTranslate(-(SkIntToScalar(field.fBounds.fLeft) + SK_ScalarHalf),
+                          -(SkIntToScalar(field.fBounds.fTop) + SK_ScalarHalf));
+
+    // Distances in the field are in texels, so scale them by the size of a
+    // texel on the device to get the coverage of each pixel.
+    float det = SkScalarToFloat(fieldToDevice.getScaleX()) *
+                SkScalarToFloat(fieldToDevice.getScaleY()) -
+                SkScalarToFloat(fieldToDevice.getSkewX()) *
+                SkScalarToFloat(fieldToDevice.getSkewY());
+    const float texelScale = sk_float_sqrt(sk_float_abs(det)) * 255 /
+                             SK_DistanceFieldMultiplier;
+
+    SkMask mask;
+    mask.fBounds = bounds;
+    mask.fFormat = SkMask::kA8_Format;
+    mask.fRowBytes = bounds.width();
+    SkAutoSMalloc<2048> storage(mask.computeImageSize());
+    mask.fImage = (uint8_t*)storage.get();
+
+    const float dudx = SkScalarToFloat(inverse.getScaleX());
+    const float dvdx = SkScalarToFloat(inverse.getSkewY());
+    uint8_t* dst = mask.fImage;
+    for (int y = bounds.fTop; y < bounds.fBottom; y++) {
+        SkPoint start;
+        inverse.mapXY(SkIntToScalar(bounds.fLeft) + SK_ScalarHalf,
+                      SkIntToScalar(y) + SK_ScalarHalf, &start);
+        float u = SkScalarToFloat(start.fX);
+        float v = SkScalarToFloat(start.fY);
+        for (int x = 0; x < bounds.width(); x++) {
+            float dist = sample_distance_field(field, u, v) -
+                         SK_DistanceFieldOutline;
+            int coverage = sk_float_round2int(127.5f + dist * texelScale);
+            dst[x] = SkToU8(SkPin32(coverage, 0, 255));
+            u += dudx;
+            v += dvdx;
+        }
+        dst += mask.fRowBytes;
+    }
+
+    blitter->blitMask(mask, bounds);
+}
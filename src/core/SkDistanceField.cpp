@@ -0,0 +1,78 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkDistanceField.h"
+#include "SkFloatingPoint.h"
+#include "SkTemplates.h"
+
+// Texels further than this (in x or y) can't have the outline within the
+// range of the field.
+#define kSearchRadius   (SK_DistanceFieldPad + 1)
+#define kSearchSize     (2 * kSearchRadius + 1)
+
+/*  Texels the outline crosses have partial coverage c, and we take their
+    distance to be c - 1/2 (which is exact for a straight edge through the
+    middle of the texel). Every other texel searches its neighborhood for the
+    texels on the other side of the outline (or on it), and takes the nearest
+    of those, less how far past their center the outline is.
+ */
+void SkGenerateDistanceFieldFromA8(uint8_t image[], int width, int height,
+                                   size_t rowBytes) {
+    SkAutoSMalloc<4096> storage(width * height);
+    uint8_t* coverage = (uint8_t*)storage.get();
+    for (int y = 0; y < height; y++) {
+        memcpy(coverage + y * width, image + y * rowBytes, width);
+    }
+
+    float offsets[kSearchSize][kSearchSize];
+    for (int dy = 0; dy < kSearchSize; dy++) {
+        for (int dx = 0; dx < kSearchSize; dx++) {
+            int x = dx - kSearchRadius;
+            int y = dy - kSearchRadius;
+            offsets[dy][dx] = sk_float_sqrt((float)(x * x + y * y));
+        }
+    }
+
+    const float kInvCoverage = 1.0f / 255;
+    for (int y = 0; y < height; y++) {
+        uint8_t* dst = image + y * rowBytes;
+        for (int x = 0; x < width; x++) {
+            unsigned c = coverage[y * width + x];
+            float dist;
+            if (c > 0 && c < 255) {
+                dist = c * kInvCoverage - 0.5f;
+            } else {
+                const bool inside = (255 == c);
+                float nearest = (float)kSearchRadius;
+                int top = SkMax32(y - kSearchRadius, 0);
+                int bottom = SkMin32(y + kSearchRadius, height - 1);
+                int left = SkMax32(x - kSearchRadius, 0);
+                int right = SkMin32(x + kSearchRadius, width - 1);
+                for (int sy = top; sy <= bottom; sy++) {
+                    const uint8_t* row = coverage + sy * width;
+                    const float* offsetRow = offsets[sy - y + kSearchRadius];
+                    for (int sx = left; sx <= right; sx++) {
+                        unsigned other = row[sx];
+                        if (other == c) {
+                            continue;
+                        }
+                        float past = other * kInvCoverage - 0.5f;
+                        float d = offsetRow[sx - x + kSearchRadius] +
+                                  (inside ? past : -past);
+                        if (d < nearest) {
+                            nearest = d;
+                        }
+                    }
+                }
+                dist = inside ? nearest : -nearest;
+            }
+            int value = SK_DistanceFieldOutline +
+                        sk_float_round2int(dist * SK_DistanceFieldMultiplier);
+            dst[x] = SkToU8(SkPin32(value, 0, 255));
+        }
+    }
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkDistanceField_DEFINED
+#define SkDistanceField_DEFINED
+
+#include "SkTypes.h"
+
+/*  Glyphs drawn with SkPaint::kDistanceFieldText_Flag are generated once, as
+    signed distance fields: each A8 texel holds the distance from its center
+    to the glyph's outline, which SkBlitMask::BlitDistanceField turns back into
+    coverage at whatever scale the glyph is drawn.
+ */
+
+// Texels of padding around each glyph, which is also the furthest distance
+// the field holds.
+#define SK_DistanceFieldPad         4
+
+// The texel value on the outline. Each texel of distance inside the glyph adds
+// SK_DistanceFieldMultiplier to it, and each texel outside subtracts it.
+#define SK_DistanceFieldOutline     128
+#define SK_DistanceFieldMultiplier  32
+
+/** Replaces an A8 coverage mask with its signed distance field. The outline
+    should be at least SK_DistanceFieldPad texels from the edges of the mask.
+*/
+void SkGenerateDistanceFieldFromA8(uint8_t image[], int width, int height,
+                                   size_t rowBytes);
+
+#endif
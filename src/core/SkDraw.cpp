@@ -8,6 +8,7 @@
 
 
 #include "SkDraw.h"
+#include "SkBlitMask.h"
 #include "SkBlitter.h"
 #include "SkBounder.h"
 #include "SkCanvas.h"
@@ -1527,6 +1528,157 @@ SkDraw1Glyph::Proc SkDraw1Glyph::init(const SkDraw* draw, SkBlitter* blitter,
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static bool ShouldDrawTextAsDistanceFields(const SkDraw& draw,
+                                           const SkPaint& paint) {
+    return paint.isDistanceFieldText() &&
+           needsRasterTextBlit(draw) &&
+           NULL == draw.fBounder &&
+           !draw.fMatrix->hasPerspective() &&
+           SkPaint::kFill_Style == paint.getStyle() &&
+           NULL == paint.getPathEffect() &&
+           NULL == paint.getMaskFilter() &&
+           NULL == paint.getRasterizer();
+}
+
+/*  Draws glyphs from a strike of distance fields made at the canonical size,
+    scaled to the paint's text size and then by the draw's matrix. Every size
+    and matrix shares the same strike.
+ */
+class SkDistanceFieldText {
+public:
+    SkDistanceFieldText(const SkDraw& draw, const SkPaint& paint)
+        : fDraw(draw)
+        , fCachePaint(MakeCachePaint(paint))
+        , fAutoCache(fCachePaint, NULL)
+        , fBlitterChooser(*draw.fBitmap, *draw.fMatrix, paint) {
+        fWrapper.init(*draw.fRC, fBlitterChooser.get());
+        fScale = SkScalarDiv(paint.getTextSize(), fCachePaint.getTextSize());
+    }
+
+    SkGlyphCache* getCache() const { return fAutoCache.getCache(); }
+
+    // Returns the scale from the strike's units to the paint's.
+    SkScalar getScale() const { return fScale; }
+
+    // Draws glyph with its origin at (x, y), before the draw's matrix.
+    void drawGlyph(const SkGlyph& glyph, SkScalar x, SkScalar y) {
+        if (0 == glyph.fWidth) {
+            return;
+        }
+        SkMask field;
+        glyph.toMask(&field);
+        field.fImage = (uint8_t*)this->getCache()->findImage(glyph);
+        if (NULL == field.fImage) {
+            return;
+        }
+
+        SkMatrix fieldToDevice(*fDraw.fMatrix);
+        fieldToDevice.preTranslate(x, y);
+        fieldToDevice.preScale(fScale, fScale);
+
+        SkBlitter* blitter = fWrapper.getBlitter();
+        const SkRegion& clip = fWrapper.getRgn();
+        if (clip.isRect()) {
+            SkBlitMask::BlitDistanceField(blitter, clip.getBounds(), field,
+                                          fieldToDevice);
+        } else {
+            SkRect r;
+            SkIRect ir;
+            r.set(field.fBounds);
+            fieldToDevice.mapRect(&r);
+            r.roundOut(&ir);
+            SkRegion::Cliperator iter(clip, ir);
+            for (; !iter.done(); iter.next()) {
+                SkBlitMask::BlitDistanceField(blitter, iter.rect(), field,
+                                              fieldToDevice);
+            }
+        }
+    }
+
+private:
+    static SkPaint MakeCachePaint(const SkPaint& paint) {
+        SkPaint dfPaint(paint);
+        dfPaint.setTextSize(SkIntToScalar(
+                                SkPaint::kCanonicalTextSizeForDistanceFields));
+        // the glyphs are scaled, so they can't be hinted or subpixel positioned
+        dfPaint.setLinearText(true);
+        dfPaint.setHinting(SkPaint::kNo_Hinting);
+        dfPaint.setSubpixelText(false);
+        dfPaint.setLCDRenderText(false);
+        dfPaint.setDevKernText(false);
+        dfPaint.setEmbeddedBitmapText(false);
+        dfPaint.fPrivFlags |= SkPaint::kDistanceFieldGlyphs_PrivFlag;
+        return dfPaint;
+    }
+
+    const SkDraw&           fDraw;
+    SkPaint                 fCachePaint;
+    SkAutoGlyphCache        fAutoCache;
+    SkAutoBlitterChoose     fBlitterChooser;
+    SkAAClipBlitterWrapper  fWrapper;
+    SkScalar                fScale;
+};
+
+void SkDraw::drawText_asDistanceFields(const char text[], size_t byteLength,
+                                       SkScalar x, SkScalar y,
+                                       const SkPaint& paint) const {
+    SkDistanceFieldText dfText(*this, paint);
+    SkGlyphCache*       cache = dfText.getCache();
+    SkDrawCacheProc     glyphCacheProc = paint.getDrawCacheProc();
+    const SkScalar      scale = dfText.getScale();
+
+    if (paint.getTextAlign() != SkPaint::kLeft_Align) {
+        SkVector    stop;
+
+        measure_text(cache, glyphCacheProc, text, byteLength, &stop);
+        stop.scale(scale);
+        if (paint.getTextAlign() == SkPaint::kCenter_Align) {
+            stop.scale(SK_ScalarHalf);
+        }
+        x -= stop.fX;
+        y -= stop.fY;
+    }
+
+    const char* stop = text + byteLength;
+    while (text < stop) {
+        const SkGlyph& glyph = glyphCacheProc(cache, &text, 0, 0);
+        dfText.drawGlyph(glyph, x, y);
+        x += SkScalarMul(SkFixedToScalar(glyph.fAdvanceX), scale);
+        y += SkScalarMul(SkFixedToScalar(glyph.fAdvanceY), scale);
+    }
+}
+
+void SkDraw::drawPosText_asDistanceFields(const char text[], size_t byteLength,
+                                          const SkScalar pos[], SkScalar constY,
+                                          int scalarsPerPosition,
+                                          const SkPaint& paint) const {
+    SkDistanceFieldText dfText(*this, paint);
+    SkGlyphCache*       cache = dfText.getCache();
+    SkDrawCacheProc     glyphCacheProc = paint.getDrawCacheProc();
+    const SkScalar      scale = dfText.getScale();
+
+    // the fraction of each (scaled) advance to move its glyph back by
+    SkScalar alignScale = 0;
+    if (SkPaint::kCenter_Align == paint.getTextAlign()) {
+        alignScale = SkScalarHalf(scale);
+    } else if (SkPaint::kRight_Align == paint.getTextAlign()) {
+        alignScale = scale;
+    }
+
+    const char* stop = text + byteLength;
+    while (text < stop) {
+        const SkGlyph& glyph = glyphCacheProc(cache, &text, 0, 0);
+        SkScalar x = pos[0];
+        SkScalar y = (2 == scalarsPerPosition) ? pos[1] : constY;
+        x -= SkScalarMul(SkFixedToScalar(glyph.fAdvanceX), alignScale);
+        y -= SkScalarMul(SkFixedToScalar(glyph.fAdvanceY), alignScale);
+        dfText.drawGlyph(glyph, x, y);
+        pos += scalarsPerPosition;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void SkDraw::drawText(const char text[], size_t byteLength,
                       SkScalar x, SkScalar y, const SkPaint& paint) const {
     SkASSERT(byteLength == 0 || text != NULL);
@@ -1544,6 +1696,11 @@ void SkDraw::drawText(const char text[], size_t byteLength,
         return;
     }
 
+    if (ShouldDrawTextAsDistanceFields(*this, paint)) {
+        this->drawText_asDistanceFields(text, byteLength, x, y, paint);
+        return;
+    }
+
     SkDrawCacheProc glyphCacheProc = paint.getDrawCacheProc();
 
     const SkMatrix* matrix = fMatrix;
@@ -1746,6 +1903,12 @@ void SkDraw::drawPosText(const char text[], size_t byteLength,
         return;
     }
 
+    if (ShouldDrawTextAsDistanceFields(*this, paint)) {
+        this->drawPosText_asDistanceFields(text, byteLength, pos, constY,
+                                           scalarsPerPosition, paint);
+        return;
+    }
+
     const SkMatrix* matrix = fMatrix;
     if (hasCustomD1GProc(*this)) {
         // only support the fMVMatrix (for now) for the GPU case, which also
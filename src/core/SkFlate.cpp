@@ -13,9 +13,9 @@
 
 #ifndef SK_HAS_ZLIB
 bool SkFlate::HaveFlate() { return false; }
-bool SkFlate::Deflate(SkStream*, SkWStream*) { return false; }
-bool SkFlate::Deflate(const void*, size_t, SkWStream*) { return false; }
-bool SkFlate::Deflate(const SkData*, SkWStream*) { return false; }
+bool SkFlate::Deflate(SkStream*, SkWStream*, int) { return false; }
+bool SkFlate::Deflate(const void*, size_t, SkWStream*, int) { return false; }
+bool SkFlate::Deflate(const SkData*, SkWStream*, int) { return false; }
 bool SkFlate::Inflate(SkStream*, SkWStream*) { return false; }
 #else
 
@@ -33,9 +33,9 @@ namespace {
 #endif
 
 // static
-const size_t kBufferSize = 1024;
+const size_t kBufferSize = 16 * 1024;
 
-bool doFlate(bool compress, SkStream* src, SkWStream* dst) {
+bool doFlate(bool compress, int level, SkStream* src, SkWStream* dst) {
     uint8_t inputBuffer[kBufferSize];
     uint8_t outputBuffer[kBufferSize];
     z_stream flateData;
@@ -47,7 +47,7 @@ bool doFlate(bool compress, SkStream* src, SkWStream* dst) {
     flateData.avail_out = kBufferSize;
     int rc;
     if (compress)
-        rc = deflateInit(&flateData, Z_DEFAULT_COMPRESSION);
+        rc = deflateInit(&flateData, level);
     else
         rc = inflateInit(&flateData);
     if (rc != Z_OK)
@@ -115,26 +115,27 @@ bool doFlate(bool compress, SkStream* src, SkWStream* dst) {
 }
 
 // static
-bool SkFlate::Deflate(SkStream* src, SkWStream* dst) {
-    return doFlate(true, src, dst);
+bool SkFlate::Deflate(SkStream* src, SkWStream* dst, int level) {
+    return doFlate(true, level, src, dst);
 }
 
-bool SkFlate::Deflate(const void* ptr, size_t len, SkWStream* dst) {
+bool SkFlate::Deflate(const void* ptr, size_t len, SkWStream* dst,
+                      int level) {
     SkMemoryStream stream(ptr, len);
-    return doFlate(true, &stream, dst);
+    return doFlate(true, level, &stream, dst);
 }
 
-bool SkFlate::Deflate(const SkData* data, SkWStream* dst) {
+bool SkFlate::Deflate(const SkData* data, SkWStream* dst, int level) {
     if (data) {
         SkMemoryStream stream(data->data(), data->size());
-        return doFlate(true, &stream, dst);
+        return doFlate(true, level, &stream, dst);
     }
     return false;
 }
 
 // static
 bool SkFlate::Inflate(SkStream* src, SkWStream* dst) {
-    return doFlate(false, src, dst);
+    return doFlate(false, 0, src, dst);
 }
 
 #endif
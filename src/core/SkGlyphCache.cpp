@@ -12,6 +12,7 @@
 #include "SkPaint.h"
 #include "SkPath.h"
 #include "SkTemplates.h"
+#include "SkThread.h"
 #include "SkTLS.h"
 
 //#define SPEW_PURGE_STATUS
@@ -52,6 +53,17 @@ bool gSkSuppressFontCachePurgeSpew;
 
 #define METRICS_RESERVE_COUNT  128  // so we don't grow this array a lot
 
+SK_DECLARE_STATIC_MUTEX(gGlyphStoreMutex);
+SK_DECLARE_STATIC_MUTEX(gGlyphStoreFlushMutex);
+static SkGlyphStore* gGlyphStore;
+
+// Returns the glyph store in use, ref'd, or NULL if there isn't one.
+static SkGlyphStore* ref_glyph_store() {
+    SkAutoMutexAcquire lock(gGlyphStoreMutex);
+    SkSafeRef(gGlyphStore);
+    return gGlyphStore;
+}
+
 SkGlyphCache::SkGlyphCache(const SkDescriptor* desc)
         : fGlyphAlloc(kMinGlphAlloc), fImageAlloc(kMinImageAlloc) {
     fPrev = fNext = NULL;
@@ -60,6 +72,17 @@ SkGlyphCache::SkGlyphCache(const SkDescriptor* desc)
     fScalerContext = SkScalerContext::Create(desc);
     fScalerContext->getFontMetrics(NULL, &fFontMetricsY);
 
+    fStore = ref_glyph_store();
+    fStoreStrike = NULL;
+    if (fStore) {
+        if (SkGlyphStore::MakeKey(*desc, &fStoreKey)) {
+            fStoreStrike = fStore->findStrike(fStoreKey);
+        } else {
+            fStore->unref();
+            fStore = NULL;
+        }
+    }
+
     // init to 0 so that all of the pointers will be null
     memset(fGlyphHash, 0, sizeof(fGlyphHash));
     // init with 0xFF so that the charCode field will be -1, which is invalid
@@ -86,6 +109,7 @@ SkGlyphCache::~SkGlyphCache() {
     }
     SkDescriptor::Free(fDesc);
     SkDELETE(fScalerContext);
+    SkSafeUnref(fStore);
     this->invokeAndRemoveAuxProcs();
 }
 
@@ -164,7 +188,7 @@ const SkGlyph& SkGlyphCache::getUnicharMetrics(SkUnichar charCode) {
     } else {
         RecordHashSuccess();
         if (rec->fGlyph->isJustAdvance()) {
-            fScalerContext->getMetrics(rec->fGlyph);
+            this->generateMetrics(rec->fGlyph);
         }
     }
     SkASSERT(rec->fGlyph->isFullMetrics());
@@ -187,7 +211,7 @@ const SkGlyph& SkGlyphCache::getUnicharMetrics(SkUnichar charCode,
     } else {
         RecordHashSuccess();
         if (rec->fGlyph->isJustAdvance()) {
-            fScalerContext->getMetrics(rec->fGlyph);
+            this->generateMetrics(rec->fGlyph);
         }
     }
     SkASSERT(rec->fGlyph->isFullMetrics());
@@ -207,7 +231,7 @@ const SkGlyph& SkGlyphCache::getGlyphIDMetrics(uint16_t glyphID) {
     } else {
         RecordHashSuccess();
         if (glyph->isJustAdvance()) {
-            fScalerContext->getMetrics(glyph);
+            this->generateMetrics(glyph);
         }
     }
     SkASSERT(glyph->isFullMetrics());
@@ -228,7 +252,7 @@ const SkGlyph& SkGlyphCache::getGlyphIDMetrics(uint16_t glyphID,
     } else {
         RecordHashSuccess();
         if (glyph->isJustAdvance()) {
-            fScalerContext->getMetrics(glyph);
+            this->generateMetrics(glyph);
         }
     }
     SkASSERT(glyph->isFullMetrics());
@@ -257,7 +281,7 @@ SkGlyph* SkGlyphCache::lookupMetrics(uint32_t id, MetricsType mtype) {
         glyph = gptr[hi];
         if (glyph->fID == id) {
             if (kFull_MetricsType == mtype && glyph->isJustAdvance()) {
-                fScalerContext->getMetrics(glyph);
+                this->generateMetrics(glyph);
             }
             return glyph;
         }
@@ -277,17 +301,35 @@ SkGlyph* SkGlyphCache::lookupMetrics(uint32_t id, MetricsType mtype) {
     *fGlyphArray.insert(hi) = glyph;
 
     if (kJustAdvance_MetricsType == mtype) {
-        fScalerContext->getAdvance(glyph);
+        this->generateAdvance(glyph);
         fAdvanceCount += 1;
     } else {
         SkASSERT(kFull_MetricsType == mtype);
-        fScalerContext->getMetrics(glyph);
+        this->generateMetrics(glyph);
         fMetricsCount += 1;
     }
 
     return glyph;
 }
 
+void SkGlyphCache::generateAdvance(SkGlyph* glyph) {
+    if (NULL == fStoreStrike || !fStoreStrike->getMetrics(glyph)) {
+        fScalerContext->getAdvance(glyph);
+    }
+}
+
+void SkGlyphCache::generateMetrics(SkGlyph* glyph) {
+    if (NULL == fStoreStrike || !fStoreStrike->getMetrics(glyph)) {
+        fScalerContext->getMetrics(glyph);
+    }
+}
+
+void SkGlyphCache::generateImage(const SkGlyph& glyph) {
+    if (NULL == fStoreStrike || !fStoreStrike->getImage(glyph)) {
+        fScalerContext->getImage(glyph);
+    }
+}
+
 const void* SkGlyphCache::findImage(const SkGlyph& glyph) {
     if (glyph.fWidth > 0 && glyph.fWidth < kMaxGlyphWidth) {
         if (glyph.fImage == NULL) {
@@ -296,7 +338,7 @@ const void* SkGlyphCache::findImage(const SkGlyph& glyph) {
                                         SkChunkAlloc::kReturnNil_AllocFailType);
             // check that alloc() actually succeeded
             if (glyph.fImage) {
-                fScalerContext->getImage(glyph);
+                this->generateImage(glyph);
                 // TODO: the scaler may have changed the maskformat during
                 // getImage (e.g. from AA or LCD to BW) which means we may have
                 // overallocated the buffer. Check if the new computedImageSize
@@ -320,6 +362,12 @@ const SkPath* SkGlyphCache::findPath(const SkGlyph& glyph) {
     return glyph.fPath;
 }
 
+void SkGlyphCache::addToGlyphStore(SkGlyphStoreWriter* writer) const {
+    if (fStore) {
+        writer->addGlyphs(fStoreKey, fGlyphArray.begin(), fGlyphArray.count());
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 bool SkGlyphCache::getAuxProcData(void (*proc)(void*), void** dataPtr) const {
@@ -393,8 +441,6 @@ void SkGlyphCache::invokeAndRemoveAuxProcs() {
     }
 #endif
 
-#include "SkThread.h"
-
 class SkGlyphCache_Globals {
 public:
     enum UseMutex {
@@ -740,3 +786,47 @@ void SkGraphics::SetTLSFontCacheLimit(size_t bytes) {
     }
 }
 
+
+static bool add_to_store_writer(SkGlyphCache* cache, void* writer) {
+    cache->addToGlyphStore((SkGlyphStoreWriter*)writer);
+    return false;
+}
+
+bool SkGraphics::SetGlyphStorePath(const char path[]) {
+    SkGlyphStore* store = path ? SkNEW_ARGS(SkGlyphStore, (path)) : NULL;
+    bool found = store && store->countStrikes() > 0;
+
+    SkAutoMutexAcquire lock(gGlyphStoreMutex);
+    SkRefCnt_SafeAssign(gGlyphStore, store);
+    SkSafeUnref(store);
+    return found;
+}
+
+bool SkGraphics::FlushGlyphStore() {
+    SkAutoMutexAcquire flushLock(gGlyphStoreFlushMutex);
+
+    SkAutoTUnref<SkGlyphStore> store(ref_glyph_store());
+    if (NULL == store.get()) {
+        return false;
+    }
+
+    // The glyphs in the cache are added first, so they take precedence over
+    // stored copies of the same glyphs.
+    SkGlyphStoreWriter writer;
+    SkGlyphCache::VisitAllCaches(add_to_store_writer, &writer);
+    writer.addStore(*store.get());
+    const char* path = store->path().c_str();
+    if (!writer.write(path)) {
+        return false;
+    }
+
+    // Switch to what was just written, so that the next flush keeps the
+    // glyphs of strikes that are purged before then.
+    SkGlyphStore* newStore = SkNEW_ARGS(SkGlyphStore, (path));
+    SkAutoMutexAcquire lock(gGlyphStoreMutex);
+    if (gGlyphStore == store.get()) {
+        SkRefCnt_SafeAssign(gGlyphStore, newStore);
+    }
+    newStore->unref();
+    return true;
+}
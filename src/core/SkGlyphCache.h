@@ -14,6 +14,7 @@
 #include "SkChunkAlloc.h"
 #include "SkDescriptor.h"
 #include "SkGlyph.h"
+#include "SkGlyphStore.h"
 #include "SkScalerContext.h"
 #include "SkTemplates.h"
 #include "SkTDArray.h"
@@ -124,6 +125,11 @@ public:
 
     SkScalerContext* getScalerContext() const { return fScalerContext; }
 
+    /** If this strike can be saved to the glyph store, add its glyphs to
+        writer.
+    */
+    void addToGlyphStore(SkGlyphStoreWriter* writer) const;
+
     /** Call proc on all cache entries, stopping early if proc returns true.
         The proc should not create or delete caches, since it could produce
         deadlock.
@@ -192,6 +198,13 @@ private:
     };
 
     SkGlyph* lookupMetrics(uint32_t id, MetricsType);
+
+    // These get the glyph from the glyph store if it has it, and from
+    // fScalerContext otherwise.
+    void generateAdvance(SkGlyph*);
+    void generateMetrics(SkGlyph*);
+    void generateImage(const SkGlyph&);
+
     static bool DetachProc(const SkGlyphCache*, void*) { return true; }
 
     void detach(SkGlyphCache** head) {
@@ -220,6 +233,13 @@ private:
     SkScalerContext*    fScalerContext;
     SkPaint::FontMetrics fFontMetricsY;
 
+    // The glyph store that was in use when this strike was created, or NULL
+    // if there was none or this strike can't be stored. fStoreStrike is this
+    // strike's glyphs in it, if it has any.
+    SkGlyphStore*               fStore;
+    const SkGlyphStore::Strike* fStoreStrike;
+    SkGlyphStore::Key           fStoreKey;
+
     enum {
         kHashBits   = 12,
         kHashCount  = 1 << kHashBits,
@@ -0,0 +1,498 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGlyphStore.h"
+#include "SkChecksum.h"
+#include "SkDescriptor.h"
+#include "SkFontHost.h"
+#include "SkOSFile.h"
+#include "SkStream.h"
+#include "SkTemplates.h"
+#include "SkThread.h"
+
+#ifndef SK_BUILD_FOR_WIN
+    #include "SkMMapStream.h"
+#endif
+
+#include <stdio.h>
+
+SK_DEFINE_INST_COUNT(SkGlyphStore)
+
+#define kStoreMagic     SkSetFourByteTag('s', 'k', 'g', 's')
+
+// Bump this whenever the layout of the file, or the glyphs that the scalers
+// generate, change. Changes to the scalers that don't need a rebuild are
+// caught by the scaler ID instead.
+static const uint32_t kStoreVersion = 2;
+
+namespace {
+
+struct StoreHeader {
+    uint32_t    fMagic;
+    uint32_t    fVersion;
+    uint32_t    fScalerID;  // SkFontHost::GetScalerID() of the writer
+    uint32_t    fKeySize;
+    uint32_t    fStrikeCount;
+    uint32_t    fLength;    // of the whole store
+    uint32_t    fChecksum;  // of everything after the header
+};
+
+// Each strike is a StrikeHeader, then its GlyphRecs sorted by fID, and then
+// their images, each padded to a multiple of 4 bytes.
+struct StrikeHeader {
+    SkGlyphStore::Key   fKey;
+    uint32_t            fGlyphCount;
+    uint32_t            fLength;    // of the strike, including its images
+};
+
+struct GlyphRec {
+    uint32_t    fID;
+    SkFixed     fAdvanceX, fAdvanceY;
+    uint16_t    fWidth, fHeight;
+    int16_t     fTop, fLeft;
+    uint8_t     fMaskFormat;
+    int8_t      fRsbDelta, fLsbDelta;
+    uint8_t     fReserved;
+    uint32_t    fImageOffset;   // from the start of the store
+    uint32_t    fImageSize;     // 0 if the glyph has no image
+
+    void set(const SkGlyph& glyph) {
+        sk_bzero(this, sizeof(*this));
+        fID = glyph.fID;
+        fAdvanceX = glyph.fAdvanceX;
+        fAdvanceY = glyph.fAdvanceY;
+        fWidth = glyph.fWidth;
+        fHeight = glyph.fHeight;
+        fTop = glyph.fTop;
+        fLeft = glyph.fLeft;
+        fMaskFormat = glyph.fMaskFormat;
+        fRsbDelta = glyph.fRsbDelta;
+        fLsbDelta = glyph.fLsbDelta;
+    }
+
+    void getMetrics(SkGlyph* glyph) const {
+        glyph->fAdvanceX = fAdvanceX;
+        glyph->fAdvanceY = fAdvanceY;
+        glyph->fWidth = fWidth;
+        glyph->fHeight = fHeight;
+        glyph->fTop = fTop;
+        glyph->fLeft = fLeft;
+        glyph->fMaskFormat = fMaskFormat;
+        glyph->fRsbDelta = fRsbDelta;
+        glyph->fLsbDelta = fLsbDelta;
+    }
+};
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// The font IDs in a rec are only unique to a process, so keys use a checksum
+// of the font's 'head' table instead. That holds the checksum of the whole
+// font file, and its creation and modification dates.
+#define kHeadTableTag   SkSetFourByteTag('h', 'e', 'a', 'd')
+static const size_t kHeadTableSize = 54;
+
+struct FontChecksumRec {
+    SkFontID    fFontID;
+    uint32_t    fChecksum;
+};
+
+SK_DECLARE_STATIC_MUTEX(gFontChecksumMutex);
+
+// Returns 0 if the font doesn't have a 'head' table.
+static uint32_t font_checksum(SkFontID fontID) {
+    SkAutoMutexAcquire lock(gFontChecksumMutex);
+    static SkTDArray<FontChecksumRec> gFontChecksums;
+
+    for (int i = 0; i < gFontChecksums.count(); i++) {
+        if (gFontChecksums[i].fFontID == fontID) {
+            return gFontChecksums[i].fChecksum;
+        }
+    }
+
+    uint32_t head[SkAlign4(kHeadTableSize) >> 2];
+    sk_bzero(head, sizeof(head));
+    uint32_t checksum = 0;
+    if (SkFontHost::GetTableData(fontID, kHeadTableTag, 0, kHeadTableSize,
+                                 head) == kHeadTableSize) {
+        checksum = SkChecksum::Compute(head, sizeof(head));
+        // 0 means there is no checksum
+        checksum = checksum ? checksum : 1;
+    }
+    FontChecksumRec* rec = gFontChecksums.append();
+    rec->fFontID = fontID;
+    rec->fChecksum = checksum;
+    return checksum;
+}
+
+bool SkGlyphStore::MakeKey(const SkDescriptor& desc, Key* key) {
+    uint32_t length;
+    const void* rec = desc.findEntry(kRec_SkDescriptorTag, &length);
+    if (NULL == rec || sizeof(Key) != length ||
+            desc.findEntry(kPathEffect_SkDescriptorTag, NULL) ||
+            desc.findEntry(kMaskFilter_SkDescriptorTag, NULL) ||
+            desc.findEntry(kRasterizer_SkDescriptorTag, NULL)) {
+        return false;
+    }
+    memcpy(key, rec, sizeof(Key));
+
+    // Glyphs from fallback fonts depend on which fonts are installed.
+    if (SkFontHost::NextLogicalFont(key->fFontID, key->fOrigFontID)) {
+        return false;
+    }
+    uint32_t fontChecksum = font_checksum(key->fFontID);
+    uint32_t origFontChecksum = key->fOrigFontID == key->fFontID ?
+            fontChecksum : font_checksum(key->fOrigFontID);
+    if (0 == fontChecksum || 0 == origFontChecksum) {
+        return false;
+    }
+    key->fFontID = fontChecksum;
+    key->fOrigFontID = origFontChecksum;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const void* SkGlyphStore::Strike::find(uint32_t id) const {
+    const GlyphRec* glyphs = (const GlyphRec*)fGlyphs;
+    int lo = 0;
+    int hi = fCount - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) >> 1;
+        if (glyphs[mid].fID < id) {
+            lo = mid + 1;
+        } else if (glyphs[mid].fID > id) {
+            hi = mid - 1;
+        } else {
+            return &glyphs[mid];
+        }
+    }
+    return NULL;
+}
+
+bool SkGlyphStore::Strike::getMetrics(SkGlyph* glyph) const {
+    const GlyphRec* rec = (const GlyphRec*)this->find(glyph->fID);
+    if (NULL == rec) {
+        return false;
+    }
+    rec->getMetrics(glyph);
+    return true;
+}
+
+bool SkGlyphStore::Strike::getImage(const SkGlyph& glyph) const {
+    const GlyphRec* rec = (const GlyphRec*)this->find(glyph.fID);
+    // The glyph's metrics may have come from the scaler, so check that the
+    // image is the one it expects.
+    if (NULL == rec || 0 == rec->fImageSize || rec->fWidth != glyph.fWidth ||
+            rec->fHeight != glyph.fHeight ||
+            rec->fMaskFormat != glyph.fMaskFormat ||
+            rec->fImageSize != glyph.computeImageSize()) {
+        return false;
+    }
+    memcpy(glyph.fImage, fBase + rec->fImageOffset, rec->fImageSize);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static SkStream* open_store(const char path[]) {
+#ifdef SK_BUILD_FOR_WIN
+    SkFILEStream file(path);
+    if (!file.isValid()) {
+        return SkNEW(SkMemoryStream);
+    }
+    size_t length = file.getLength();
+    SkMemoryStream* stream = SkNEW_ARGS(SkMemoryStream, (length));
+    if (file.read(const_cast<void*>(stream->getMemoryBase()), length) !=
+            length) {
+        stream->setMemory(NULL, 0);
+    }
+    return stream;
+#else
+    return SkNEW_ARGS(SkMMAPStream, (path));
+#endif
+}
+
+SkGlyphStore::SkGlyphStore(const char path[]) : fPath(path) {
+    fStream = open_store(path);
+    this->parse();
+}
+
+SkGlyphStore::SkGlyphStore(SkStream* stream) : fStream(stream) {
+    fStream->ref();
+    this->parse();
+}
+
+SkGlyphStore::~SkGlyphStore() {
+    fStream->unref();
+}
+
+const SkGlyphStore::Strike* SkGlyphStore::findStrike(const Key& key) const {
+    for (int i = 0; i < fStrikes.count(); i++) {
+        if (0 == memcmp(fStrikes[i].fKey, &key, sizeof(Key))) {
+            return &fStrikes[i];
+        }
+    }
+    return NULL;
+}
+
+// Checks that the strike at offset, and all of its glyphs and images, are
+// within length.
+static bool valid_strike(const char* base, size_t offset, size_t length) {
+    if (length - offset < sizeof(StrikeHeader)) {
+        return false;
+    }
+    const StrikeHeader* strike = (const StrikeHeader*)(base + offset);
+    size_t strikeLength = strike->fLength;
+    if (strikeLength > length - offset || !SkIsAlign4(strikeLength) ||
+            strikeLength < sizeof(StrikeHeader) ||
+            strike->fGlyphCount > (strikeLength - sizeof(StrikeHeader)) /
+                                  sizeof(GlyphRec)) {
+        return false;
+    }
+
+    size_t imagesStart = offset + sizeof(StrikeHeader) +
+                         strike->fGlyphCount * sizeof(GlyphRec);
+    size_t strikeEnd = offset + strikeLength;
+    const GlyphRec* glyphs = (const GlyphRec*)(strike + 1);
+    for (uint32_t i = 0; i < strike->fGlyphCount; i++) {
+        const GlyphRec& rec = glyphs[i];
+        if ((i > 0 && rec.fID <= glyphs[i - 1].fID) ||
+                rec.fMaskFormat >= SkMask::kCountMaskFormats ||
+                rec.fWidth >= kMaxGlyphWidth) {
+            return false;
+        }
+        if (rec.fImageSize) {
+            SkGlyph glyph;
+            glyph.init(rec.fID);
+            rec.getMetrics(&glyph);
+            size_t imageOffset = rec.fImageOffset;
+            if (rec.fImageSize != glyph.computeImageSize() ||
+                    !SkIsAlign4(imageOffset) || imageOffset < imagesStart ||
+                    imageOffset > strikeEnd ||
+                    rec.fImageSize > strikeEnd - imageOffset) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void SkGlyphStore::parse() {
+    const char* base = (const char*)fStream->getMemoryBase();
+    size_t length = fStream->getLength();
+    if (NULL == base || length < sizeof(StoreHeader)) {
+        return;
+    }
+
+    const StoreHeader* header = (const StoreHeader*)base;
+    if (header->fMagic != kStoreMagic || header->fVersion != kStoreVersion ||
+            header->fKeySize != sizeof(Key) || header->fLength != length ||
+            !SkIsAlign4(length)) {
+        SkDEBUGF(("---- glyph store %s is from a different version\n",
+                  fPath.c_str()));
+        return;
+    }
+    // The glyphs of a different scaler, e.g. another FreeType, are stale.
+    uint32_t scalerID = SkFontHost::GetScalerID();
+    if (0 == scalerID || header->fScalerID != scalerID) {
+        SkDEBUGF(("---- glyph store %s is from a different scaler\n",
+                  fPath.c_str()));
+        return;
+    }
+    if (SkChecksum::Compute((const uint32_t*)(header + 1),
+                            length - sizeof(StoreHeader)) !=
+            header->fChecksum) {
+        SkDEBUGF(("---- glyph store %s is corrupt\n", fPath.c_str()));
+        return;
+    }
+
+    size_t offset = sizeof(StoreHeader);
+    for (uint32_t i = 0; i < header->fStrikeCount; i++) {
+        if (!valid_strike(base, offset, length)) {
+            break;
+        }
+        const StrikeHeader* strikeHeader = (const StrikeHeader*)(base + offset);
+        Strike* strike = fStrikes.append();
+        strike->fKey = &strikeHeader->fKey;
+        strike->fGlyphs = strikeHeader + 1;
+        strike->fCount = strikeHeader->fGlyphCount;
+        strike->fBase = base;
+        offset += strikeHeader->fLength;
+    }
+    if (offset != length || fStrikes.count() != (int)header->fStrikeCount) {
+        SkDEBUGF(("---- glyph store %s is corrupt\n", fPath.c_str()));
+        fStrikes.reset();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct SkGlyphStoreWriter::PendingStrike {
+    SkGlyphStore::Key   fKey;
+    // sorted by fID, and fImageOffset is into fImages
+    SkTDArray<GlyphRec> fGlyphs;
+    SkTDArray<char>     fImages;
+
+    void add(const GlyphRec& rec, const void* image) {
+        int lo = 0;
+        int hi = fGlyphs.count();
+        while (lo < hi) {
+            int mid = (lo + hi) >> 1;
+            if (fGlyphs[mid].fID < rec.fID) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo < fGlyphs.count() && fGlyphs[lo].fID == rec.fID) {
+            return;
+        }
+        GlyphRec* added = fGlyphs.insert(lo);
+        *added = rec;
+        if (image && rec.fImageSize) {
+            added->fImageOffset = fImages.count();
+            memcpy(fImages.append(SkAlign4(rec.fImageSize)), image,
+                   rec.fImageSize);
+        } else {
+            added->fImageOffset = 0;
+            added->fImageSize = 0;
+        }
+    }
+};
+
+SkGlyphStoreWriter::SkGlyphStoreWriter() {}
+
+SkGlyphStoreWriter::~SkGlyphStoreWriter() {
+    for (int i = 0; i < fStrikes.count(); i++) {
+        SkDELETE(fStrikes[i]);
+    }
+}
+
+SkGlyphStoreWriter::PendingStrike* SkGlyphStoreWriter::findOrAddStrike(
+        const SkGlyphStore::Key& key) {
+    for (int i = 0; i < fStrikes.count(); i++) {
+        if (0 == memcmp(&fStrikes[i]->fKey, &key, sizeof(key))) {
+            return fStrikes[i];
+        }
+    }
+    PendingStrike* strike = SkNEW(PendingStrike);
+    memcpy(&strike->fKey, &key, sizeof(key));
+    *fStrikes.append() = strike;
+    return strike;
+}
+
+void SkGlyphStoreWriter::addGlyphs(const SkGlyphStore::Key& key,
+                                   const SkGlyph* const glyphs[], int count) {
+    PendingStrike* strike = this->findOrAddStrike(key);
+    for (int i = 0; i < count; i++) {
+        const SkGlyph& glyph = *glyphs[i];
+        if (!glyph.isFullMetrics()) {
+            continue;
+        }
+        GlyphRec rec;
+        rec.set(glyph);
+        if (glyph.fImage) {
+            rec.fImageSize = glyph.computeImageSize();
+        }
+        strike->add(rec, glyph.fImage);
+    }
+}
+
+void SkGlyphStoreWriter::addStore(const SkGlyphStore& store) {
+    for (int i = 0; i < store.fStrikes.count(); i++) {
+        const SkGlyphStore::Strike& strike = store.fStrikes[i];
+        PendingStrike* pending = this->findOrAddStrike(*strike.fKey);
+        const GlyphRec* glyphs = (const GlyphRec*)strike.fGlyphs;
+        for (int j = 0; j < strike.fCount; j++) {
+            pending->add(glyphs[j], strike.fBase + glyphs[j].fImageOffset);
+        }
+    }
+}
+
+bool SkGlyphStoreWriter::write(SkWStream* stream) const {
+    uint32_t scalerID = SkFontHost::GetScalerID();
+    if (0 == scalerID) {
+        return false;
+    }
+
+    size_t length = sizeof(StoreHeader);
+    for (int i = 0; i < fStrikes.count(); i++) {
+        length += sizeof(StrikeHeader) +
+                  fStrikes[i]->fGlyphs.count() * sizeof(GlyphRec) +
+                  fStrikes[i]->fImages.count();
+    }
+    if (length > SK_MaxU32) {
+        return false;
+    }
+
+    SkAutoMalloc storage(length);
+    char* base = (char*)storage.get();
+    size_t offset = sizeof(StoreHeader);
+    for (int i = 0; i < fStrikes.count(); i++) {
+        const PendingStrike& strike = *fStrikes[i];
+        size_t glyphsSize = strike.fGlyphs.count() * sizeof(GlyphRec);
+        size_t imagesStart = offset + sizeof(StrikeHeader) + glyphsSize;
+
+        StrikeHeader* header = (StrikeHeader*)(base + offset);
+        memcpy(&header->fKey, &strike.fKey, sizeof(header->fKey));
+        header->fGlyphCount = strike.fGlyphs.count();
+        header->fLength = SkToU32(sizeof(StrikeHeader) + glyphsSize +
+                                  strike.fImages.count());
+
+        GlyphRec* glyphs = (GlyphRec*)(header + 1);
+        memcpy(glyphs, strike.fGlyphs.begin(), glyphsSize);
+        for (int j = 0; j < strike.fGlyphs.count(); j++) {
+            if (glyphs[j].fImageSize) {
+                glyphs[j].fImageOffset += SkToU32(imagesStart);
+            }
+        }
+        memcpy(base + imagesStart, strike.fImages.begin(),
+               strike.fImages.count());
+        offset += header->fLength;
+    }
+    SkASSERT(offset == length);
+
+    StoreHeader* header = (StoreHeader*)base;
+    header->fMagic = kStoreMagic;
+    header->fVersion = kStoreVersion;
+    header->fScalerID = scalerID;
+    header->fKeySize = sizeof(SkGlyphStore::Key);
+    header->fStrikeCount = fStrikes.count();
+    header->fLength = SkToU32(length);
+    header->fChecksum = SkChecksum::Compute((const uint32_t*)(header + 1),
+                                            length - sizeof(StoreHeader));
+    return stream->write(base, length);
+}
+
+bool SkGlyphStoreWriter::write(const char path[]) const {
+    // Other processes may be writing the same store, so each write goes to
+    // a file of its own.
+    SkString tmpPath;
+    sk_make_temp_path(path, &tmpPath);
+    {
+        SkFILEWStream stream(tmpPath.c_str());
+        if (!stream.isValid()) {
+            return false;
+        }
+        if (!this->write(&stream)) {
+            remove(tmpPath.c_str());
+            return false;
+        }
+    }
+#ifdef SK_BUILD_FOR_WIN
+    // rename() won't replace an existing file on Windows.
+    remove(path);
+#endif
+    if (rename(tmpPath.c_str(), path) != 0) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
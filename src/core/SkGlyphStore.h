@@ -0,0 +1,145 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGlyphStore_DEFINED
+#define SkGlyphStore_DEFINED
+
+#include "SkGlyph.h"
+#include "SkRefCnt.h"
+#include "SkScalerContext.h"
+#include "SkString.h"
+#include "SkTDArray.h"
+
+class SkDescriptor;
+class SkStream;
+class SkWStream;
+
+/** \class SkGlyphStore
+
+    A read-only set of glyph metrics and images, saved by an earlier process,
+    which SkGlyphCache consults before asking the scaler context for a glyph.
+    This lets short-lived processes skip rasterizing the glyphs they draw
+    every time.
+
+    The store is a single file, which is memory-mapped where that is
+    available. A file that is missing, was written by a different version or
+    by a scaler with a different SkFontHost::GetScalerID(), or is corrupt
+    gives an empty store, so the glyphs are just generated as usual.
+
+    Strikes are keyed by their SkScalerContextRec, with the font IDs (which
+    are only unique to a process) replaced by a checksum of the font's 'head'
+    table. Strikes with a path effect, mask filter or rasterizer, strikes of
+    fonts that aren't sfnts, and strikes that can fall back on other fonts
+    aren't stored.
+*/
+class SkGlyphStore : public SkRefCnt {
+public:
+    SK_DECLARE_INST_COUNT(SkGlyphStore)
+
+    /** Reads the store from the file at path. */
+    explicit SkGlyphStore(const char path[]);
+
+    /** Reads the store from stream, which is ref'd. The stream must be a
+        memory stream (e.g. SkMemoryStream or SkMMAPStream).
+    */
+    explicit SkGlyphStore(SkStream* stream);
+
+    virtual ~SkGlyphStore();
+
+    /** Returns the file this store was read from, or the empty string. */
+    const SkString& path() const { return fPath; }
+
+    /** Returns the number of strikes in the store. */
+    int countStrikes() const { return fStrikes.count(); }
+
+    typedef SkScalerContextRec Key;
+
+    /** Sets key to identify the strike for desc across processes. Returns
+        false if the strike can't be stored.
+    */
+    static bool MakeKey(const SkDescriptor& desc, Key* key);
+
+    /** The stored glyphs of one strike. */
+    class Strike {
+    public:
+        /** If the strike has the glyph with glyph->fID, sets all of its
+            metrics and returns true. fID, fImage and fPath are not changed.
+        */
+        bool getMetrics(SkGlyph* glyph) const;
+
+        /** If the strike has the image for the glyph, copies it into
+            glyph.fImage and returns true.
+        */
+        bool getImage(const SkGlyph& glyph) const;
+
+    private:
+        const Key*      fKey;
+        const void*     fGlyphs;
+        int             fCount;
+        const char*     fBase;
+
+        const void* find(uint32_t id) const;
+
+        friend class SkGlyphStore;
+        friend class SkGlyphStoreWriter;
+    };
+
+    /** Returns the strike for key, or NULL if it isn't in the store. */
+    const Strike* findStrike(const Key& key) const;
+
+private:
+    SkString            fPath;
+    SkStream*           fStream;
+    SkTDArray<Strike>   fStrikes;
+
+    void parse();
+
+    friend class SkGlyphStoreWriter;
+
+    typedef SkRefCnt INHERITED;
+};
+
+/** \class SkGlyphStoreWriter
+
+    Collects strikes and writes them out in the format read by SkGlyphStore.
+*/
+class SkGlyphStoreWriter : SkNoncopyable {
+public:
+    SkGlyphStoreWriter();
+    ~SkGlyphStoreWriter();
+
+    /** Adds the glyphs of a strike. Only glyphs with full metrics are added,
+        along with their images if they have them. Adding glyphs to the same
+        strike more than once keeps the first copy of each glyph.
+    */
+    void addGlyphs(const SkGlyphStore::Key& key, const SkGlyph* const glyphs[],
+                   int count);
+
+    /** Adds all of the strikes in store. */
+    void addStore(const SkGlyphStore& store);
+
+    /** Writes the strikes to stream. Returns false if writing failed, or if
+        the scaler can't be identified (SkFontHost::GetScalerID() is 0).
+    */
+    bool write(SkWStream* stream) const;
+
+    /** Writes the strikes to a temporary file next to path, unique to this
+        call, and then renames that over path, so readers never see a partly
+        written store. Returns false if writing failed, in which case path is
+        left alone.
+    */
+    bool write(const char path[]) const;
+
+private:
+    struct PendingStrike;
+    SkTDArray<PendingStrike*> fStrikes;
+
+    PendingStrike* findOrAddStrike(const SkGlyphStore::Key& key);
+};
+
+#endif
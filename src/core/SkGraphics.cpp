@@ -121,20 +121,26 @@ void SkGraphics::Init() {
 }
 
 void SkGraphics::Term() {
+    FlushGlyphStore();
     PurgeFontCache();
+    PurgeMipMapCache();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 static const char kFontCacheLimitStr[] = "font-cache-limit";
 static const size_t kFontCacheLimitLen = sizeof(kFontCacheLimitStr) - 1;
+static const char kMipMapCacheLimitStr[] = "mipmap-cache-limit";
+static const size_t kMipMapCacheLimitLen = sizeof(kMipMapCacheLimitStr) - 1;
 
 static const struct {
     const char* fStr;
     size_t fLen;
     size_t (*fFunc)(size_t);
 } gFlags[] = {
-    { kFontCacheLimitStr, kFontCacheLimitLen, SkGraphics::SetFontCacheLimit }
+    { kFontCacheLimitStr, kFontCacheLimitLen, SkGraphics::SetFontCacheLimit },
+    { kMipMapCacheLimitStr, kMipMapCacheLimitLen,
+      SkGraphics::SetMipMapCacheLimit }
 };
 
 /* flags are of the form param; or param=value; */
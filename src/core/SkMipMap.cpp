@@ -0,0 +1,415 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMipMap.h"
+#include "SkBitmap.h"
+#include "SkColorPriv.h"
+#include "SkGraphics.h"
+#include "SkPixelRef.h"
+#include "SkThread.h"
+#include <math.h>
+
+#ifndef SK_DEFAULT_MIPMAP_CACHE_LIMIT
+    // enough for the levels of a 4000x3000 8888 photo
+    #define SK_DEFAULT_MIPMAP_CACHE_LIMIT   (16 * 1024 * 1024)
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Each dst pixel is the average of a 2x2 block of src pixels. Since each level
+// is exactly half (rounded down) the size of the previous, the block is always
+// entirely inside src.
+
+static void downsample32(uint32_t dst[], const uint32_t src0[],
+                         const uint32_t src1[], int count) {
+    for (int i = 0; i < count; i++) {
+        SkPMColor c, ag, rb;
+
+        c = src0[0]; ag = (c >> 8) & 0xFF00FF; rb = c & 0xFF00FF;
+        c = src0[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = src1[0]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = src1[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+
+        dst[i] = ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+        src0 += 2;
+        src1 += 2;
+    }
+}
+
+static inline uint32_t expand16(U16CPU c) {
+    return (c & ~SK_G16_MASK_IN_PLACE) | ((c & SK_G16_MASK_IN_PLACE) << 16);
+}
+
+// returns dirt in the top 16bits, but we don't care, since we only
+// store the low 16bits.
+static inline U16CPU pack16(uint32_t c) {
+    return (c & ~SK_G16_MASK_IN_PLACE) | ((c >> 16) & SK_G16_MASK_IN_PLACE);
+}
+
+static void downsample16(uint16_t dst[], const uint16_t src0[],
+                         const uint16_t src1[], int count) {
+    for (int i = 0; i < count; i++) {
+        uint32_t c = expand16(src0[0]) + expand16(src0[1]) +
+                     expand16(src1[0]) + expand16(src1[1]);
+        dst[i] = (uint16_t)pack16(c >> 2);
+        src0 += 2;
+        src1 += 2;
+    }
+}
+
+static inline uint32_t expand4444(U16CPU c) {
+    return (c & 0xF0F) | ((c & ~0xF0F) << 12);
+}
+
+static inline U16CPU collaps4444(uint32_t c) {
+    return (c & 0xF0F) | ((c >> 12) & ~0xF0F);
+}
+
+static void downsample4444(uint16_t dst[], const uint16_t src0[],
+                           const uint16_t src1[], int count) {
+    for (int i = 0; i < count; i++) {
+        uint32_t c = expand4444(src0[0]) + expand4444(src0[1]) +
+                     expand4444(src1[0]) + expand4444(src1[1]);
+        dst[i] = (uint16_t)collaps4444(c >> 2);
+        src0 += 2;
+        src1 += 2;
+    }
+}
+
+typedef void (*Downsample16Proc)(uint16_t dst[], const uint16_t src0[],
+                                 const uint16_t src1[], int count);
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkMipMap::SkMipMap(Level* levels, int count, size_t size)
+        : fLevels(levels), fCount(count), fSize(size) {
+    SkASSERT(levels);
+    SkASSERT(count > 0);
+}
+
+SkMipMap::~SkMipMap() {
+    sk_free(fLevels);
+}
+
+SkMipMap* SkMipMap::Build(const SkBitmap& src) {
+    const SkBitmap::Config config = src.getConfig();
+    Downsample32Proc proc32 = NULL;
+    Downsample16Proc proc16 = NULL;
+
+    switch (config) {
+        case SkBitmap::kARGB_8888_Config:
+            proc32 = PlatformDownsample32Proc();
+            if (NULL == proc32) {
+                proc32 = downsample32;
+            }
+            break;
+        case SkBitmap::kRGB_565_Config:
+            proc16 = downsample16;
+            break;
+        case SkBitmap::kARGB_4444_Config:
+            proc16 = downsample4444;
+            break;
+        default:
+            return NULL; // don't build mipmaps for these configs
+    }
+
+    SkAutoLockPixels alp(src);
+    if (!src.readyToDraw()) {
+        return NULL;
+    }
+
+    // whip through our loop to compute the exact size needed
+    size_t  size = 0;
+    int     countLevels = 0;
+    {
+        int width = src.width();
+        int height = src.height();
+        for (;;) {
+            width >>= 1;
+            height >>= 1;
+            if (0 == width || 0 == height) {
+                break;
+            }
+            size += SkBitmap::ComputeRowBytes(config, width) * height;
+            countLevels += 1;
+        }
+    }
+    if (0 == countLevels) {
+        return NULL;
+    }
+
+    Level* levels = (Level*)sk_malloc_flags(countLevels * sizeof(Level) + size,
+                                            0);
+    if (NULL == levels) {
+        return NULL;
+    }
+
+    uint8_t*        addr = (uint8_t*)(levels + countLevels);
+    const uint8_t*  srcAddr = (const uint8_t*)src.getPixels();
+    size_t          srcRowBytes = src.rowBytes();
+    int             width = src.width();
+    int             height = src.height();
+
+    for (int i = 0; i < countLevels; i++) {
+        width >>= 1;
+        height >>= 1;
+        const size_t rowBytes = SkBitmap::ComputeRowBytes(config, width);
+
+        levels[i].fPixels   = addr;
+        levels[i].fWidth    = width;
+        levels[i].fHeight   = height;
+        levels[i].fRowBytes = rowBytes;
+
+        for (int y = 0; y < height; y++) {
+            const uint8_t* src0 = srcAddr + 2 * y * srcRowBytes;
+            const uint8_t* src1 = src0 + srcRowBytes;
+            uint8_t* dst = addr + y * rowBytes;
+            if (proc32) {
+                proc32((uint32_t*)dst, (const uint32_t*)src0,
+                       (const uint32_t*)src1, width);
+            } else {
+                proc16((uint16_t*)dst, (const uint16_t*)src0,
+                       (const uint16_t*)src1, width);
+            }
+        }
+
+        srcAddr = addr;
+        srcRowBytes = rowBytes;
+        addr += height * rowBytes;
+    }
+    SkASSERT(addr == (uint8_t*)(levels + countLevels) + size);
+
+    return SkNEW_ARGS(SkMipMap, (levels, countLevels, size));
+}
+
+int SkMipMap::ComputeLevel(SkScalar scale, bool roundDown) {
+    if (scale <= SK_Scalar1) {
+        return 0;
+    }
+    float level = logf(SkScalarToFloat(scale)) * 1.44269504f;  // log2
+    if (!roundDown) {
+        level += 0.5f;
+    }
+    // pin before converting, since scale may be huge
+    return level < 30 ? (int)level : 30;
+}
+
+bool SkMipMap::extractLevel(SkScalar scale, bool roundDown,
+                            Level* levelPtr) const {
+    int level = ComputeLevel(scale, roundDown);
+    if (level <= 0) {
+        return false;
+    }
+    if (level > fCount) {
+        level = fCount;
+    }
+    if (levelPtr) {
+        *levelPtr = fLevels[level - 1];
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The cache is a simple LRU list: we expect at most a few dozen entries, each
+// of which is expensive to build, so a linear search is not a concern.
+
+namespace {
+
+struct Key {
+    uint32_t    fGenID;
+    uint32_t    fOffset;    // the bitmap may be a subset of its pixelref
+    uint32_t    fWidth;
+    uint32_t    fHeight;
+    uint32_t    fConfig;
+
+    bool operator==(const Key& other) const {
+        return 0 == memcmp(this, &other, sizeof(Key));
+    }
+};
+
+struct Entry {
+    Entry*      fPrev;      // most recently used at the head
+    Entry*      fNext;
+    Key         fKey;
+    SkMipMap*   fMipMap;
+};
+
+class MipMapCache {
+public:
+    MipMapCache() : fHead(NULL), fTail(NULL), fBytesUsed(0),
+                    fByteLimit(SK_DEFAULT_MIPMAP_CACHE_LIMIT) {}
+
+    SkMipMap* findAndRef(const Key& key) {
+        for (Entry* entry = fHead; entry; entry = entry->fNext) {
+            if (entry->fKey == key) {
+                // move to the head of our list, so we purge it last
+                this->detach(entry);
+                this->attachToHead(entry);
+                entry->fMipMap->ref();
+                return entry->fMipMap;
+            }
+        }
+        return NULL;
+    }
+
+    // returns the mipmap the caller should use, with its ref count bumped
+    SkMipMap* addAndRef(const Key& key, SkMipMap* mipMap) {
+        SkMipMap* existing = this->findAndRef(key);
+        if (existing) {
+            // someone else built the same mipmap while we were building ours
+            return existing;
+        }
+
+        size_t bytes = mipMap->getSize();
+        if (bytes > fByteLimit) {
+            return NULL;
+        }
+        this->purgeToFit(fByteLimit - bytes);
+
+        Entry* entry = SkNEW(Entry);
+        entry->fKey = key;
+        entry->fMipMap = mipMap;
+        mipMap->ref();
+        this->attachToHead(entry);
+        fBytesUsed += bytes;
+
+        mipMap->ref();
+        return mipMap;
+    }
+
+    size_t bytesUsed() const { return fBytesUsed; }
+    size_t byteLimit() const { return fByteLimit; }
+
+    size_t setByteLimit(size_t bytes) {
+        size_t prev = fByteLimit;
+        fByteLimit = bytes;
+        this->purgeToFit(bytes);
+        return prev;
+    }
+
+    void purgeToFit(size_t bytes) {
+        while (fBytesUsed > bytes) {
+            Entry* entry = fTail;
+            SkASSERT(entry);
+            this->detach(entry);
+            fBytesUsed -= entry->fMipMap->getSize();
+            entry->fMipMap->unref();
+            SkDELETE(entry);
+        }
+    }
+
+private:
+    Entry*  fHead;
+    Entry*  fTail;
+    size_t  fBytesUsed;
+    size_t  fByteLimit;
+
+    void detach(Entry* entry) {
+        if (entry->fPrev) {
+            entry->fPrev->fNext = entry->fNext;
+        } else {
+            SkASSERT(fHead == entry);
+            fHead = entry->fNext;
+        }
+        if (entry->fNext) {
+            entry->fNext->fPrev = entry->fPrev;
+        } else {
+            SkASSERT(fTail == entry);
+            fTail = entry->fPrev;
+        }
+    }
+
+    void attachToHead(Entry* entry) {
+        entry->fPrev = NULL;
+        entry->fNext = fHead;
+        if (fHead) {
+            fHead->fPrev = entry;
+        } else {
+            fTail = entry;
+        }
+        fHead = entry;
+    }
+};
+
+}
+
+SK_DECLARE_STATIC_MUTEX(gMipMapCacheMutex);
+
+// must be called with gMipMapCacheMutex held
+static MipMapCache& get_cache() {
+    static MipMapCache* gCache;
+    if (NULL == gCache) {
+        gCache = SkNEW(MipMapCache);
+    }
+    return *gCache;
+}
+
+SkMipMap* SkMipMap::FindOrBuildAndRef(const SkBitmap& src) {
+    SkPixelRef* pr = src.pixelRef();
+    if (NULL == pr) {
+        return NULL;
+    }
+
+    Key key;
+    key.fGenID = src.getGenerationID();
+    key.fOffset = SkToU32(src.pixelRefOffset());
+    key.fWidth = src.width();
+    key.fHeight = src.height();
+    key.fConfig = src.config();
+
+    size_t limit;
+    {
+        SkAutoMutexAcquire ac(gMipMapCacheMutex);
+        SkMipMap* mipMap = get_cache().findAndRef(key);
+        if (mipMap) {
+            return mipMap;
+        }
+        limit = get_cache().byteLimit();
+    }
+
+    // The levels take about a third of the original's size. Don't bother
+    // building them if they can't be kept around.
+    if (src.getSize() / 3 > limit) {
+        return NULL;
+    }
+
+    // build outside of the lock, since this can take a while
+    SkMipMap* mipMap = Build(src);
+    if (NULL == mipMap) {
+        return NULL;
+    }
+
+    SkMipMap* result;
+    {
+        SkAutoMutexAcquire ac(gMipMapCacheMutex);
+        result = get_cache().addAndRef(key, mipMap);
+    }
+    mipMap->unref();
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+size_t SkGraphics::GetMipMapCacheLimit() {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    return get_cache().byteLimit();
+}
+
+size_t SkGraphics::SetMipMapCacheLimit(size_t bytes) {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    return get_cache().setByteLimit(bytes);
+}
+
+size_t SkGraphics::GetMipMapCacheUsed() {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    return get_cache().bytesUsed();
+}
+
+void SkGraphics::PurgeMipMapCache() {
+    SkAutoMutexAcquire ac(gMipMapCacheMutex);
+    get_cache().purgeToFit(0);
+}
@@ -0,0 +1,95 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMipMap_DEFINED
+#define SkMipMap_DEFINED
+
+#include "SkRefCnt.h"
+#include "SkScalar.h"
+
+class SkBitmap;
+
+/**
+ *  An immutable chain of box-filtered, half-sized copies of a bitmap, used by
+ *  the raster backend to sample minified bitmaps from a level that is close
+ *  to the destination size (which both looks better and touches far less
+ *  memory than filtering the full-sized bitmap).
+ *
+ *  Mipmaps are built on demand and kept in a process-wide, budgeted cache,
+ *  keyed by the pixelref's generation ID (plus the bitmap's subset), so they
+ *  are automatically invalidated when the pixels change.
+ */
+class SkMipMap : public SkRefCnt {
+public:
+    struct Level {
+        void*       fPixels;
+        uint32_t    fRowBytes;
+        uint32_t    fWidth, fHeight;
+    };
+
+    /**
+     *  Build all of the levels for src. Returns NULL if the config is not
+     *  supported (8888, 565 and 4444 are) or src is too small to have any.
+     */
+    static SkMipMap* Build(const SkBitmap& src);
+
+    /**
+     *  Return the cached mipmap for src with its ref count incremented,
+     *  building and caching it first if needed. Returns NULL if src can't be
+     *  mipmapped, or if its mipmap would not fit in the cache's budget.
+     */
+    static SkMipMap* FindOrBuildAndRef(const SkBitmap& src);
+
+    int levelCount() const { return fCount; }
+
+    /**
+     *  Find the level to use when the bitmap is drawn scaled down by 1/scale
+     *  (i.e. scale > 1 means minification), or return false if the original
+     *  bitmap should be used. By default this picks the nearest level, so
+     *  bilinear filtering sees a residual scale between 0.7 and 1.4. If
+     *  roundDown is true, it picks the next larger level instead, so the
+     *  residual scale is always between 1 and 2.
+     */
+    bool extractLevel(SkScalar scale, bool roundDown, Level*) const;
+
+    /**
+     *  Return the level extractLevel() would pick for scale, ignoring how many
+     *  levels there are, where 0 means the original bitmap. Callers can use
+     *  this to avoid building a mipmap they won't use.
+     */
+    static int ComputeLevel(SkScalar scale, bool roundDown);
+
+    size_t getSize() const { return fSize; }
+
+    /**
+     *  Box filter one row of 8888 pixels: each dst pixel is the average of
+     *  two horizontally adjacent pixels in each of src0 and src1.
+     */
+    typedef void (*Downsample32Proc)(uint32_t dst[], const uint32_t src0[],
+                                     const uint32_t src1[], int dstCount);
+
+    /**
+     *  Platforms implement this, returning NULL if they have no accelerated
+     *  version (see SkBitmapProcState_opts_none.cpp).
+     */
+    static Downsample32Proc PlatformDownsample32Proc();
+
+    virtual ~SkMipMap();
+
+private:
+    Level*  fLevels;
+    int     fCount;
+    size_t  fSize;
+
+    // we take ownership of levels, and will free it with sk_free()
+    SkMipMap(Level* levels, int count, size_t size);
+
+    typedef SkRefCnt INHERITED;
+};
+
+#endif
@@ -240,6 +240,16 @@ void SkPaint::setFilterBitmap(bool doFilter) {
     this->setFlags(SkSetClearMask(fFlags, doFilter, kFilterBitmap_Flag));
 }
 
+void SkPaint::setHighQualityFilterBitmap(bool doFilter) {
+    this->setFlags(SkSetClearMask(fFlags, doFilter,
+                                  kHighQualityFilterBitmap_Flag));
+}
+
+void SkPaint::setDistanceFieldText(bool doDistanceField) {
+    this->setFlags(SkSetClearMask(fFlags, doDistanceField,
+                                  kDistanceFieldText_Flag));
+}
+
 void SkPaint::setStyle(Style style) {
     if ((unsigned)style < kStyleCount) {
         GEN_ID_INC_EVAL((unsigned)style != fStyle);
@@ -1749,6 +1759,11 @@ void SkPaint::descriptorProc(const SkMatrix* deviceMatrix,
     if (ignoreGamma) {
         rec.setLuminanceColor(0);
     }
+    if (fPrivFlags & kDistanceFieldGlyphs_PrivFlag) {
+        rec.fFlags |= SkScalerContext::kDistanceField_Flag;
+        rec.fMaskFormat = SkMask::kA8_Format;   // the field is made from an A8 mask
+        rec.setLuminanceColor(0);               // and isn't gamma corrected
+    }
 
     size_t          descSize = sizeof(rec);
     int             entryCount = 1;
@@ -10,6 +10,7 @@
 #include "SkScalerContext.h"
 #include "SkColorPriv.h"
 #include "SkDescriptor.h"
+#include "SkDistanceField.h"
 #include "SkDraw.h"
 #include "SkFontHost.h"
 #include "SkGlyph.h"
@@ -82,7 +83,8 @@ SkScalerContext::SkScalerContext(const SkDescriptor* desc)
     , fMaskFilter(static_cast<SkMaskFilter*>(load_flattenable(desc, kMaskFilter_SkDescriptorTag)))
     , fRasterizer(static_cast<SkRasterizer*>(load_flattenable(desc, kRasterizer_SkDescriptorTag)))
       // initialize based on our settings. subclasses can also force this
-    , fGenerateImageFromPath(fRec.fFrameWidth > 0 || fPathEffect != NULL || fRasterizer != NULL)
+    , fGenerateImageFromPath(fRec.fFrameWidth > 0 || fPathEffect != NULL || fRasterizer != NULL ||
+                             SkToBool(fRec.fFlags & kDistanceField_Flag))
     , fNextContext(NULL)
     , fMaskPreBlend(SkScalerContext::GetMaskPreBlend(fRec))
 {
@@ -291,6 +293,10 @@ void SkScalerContext::getMetrics(SkGlyph* glyph) {
             // just use devPath
             SkIRect ir;
             devPath.getBounds().roundOut(&ir);
+            if (fRec.fFlags & kDistanceField_Flag) {
+                // room for the field to fall off outside the outline
+                ir.outset(SK_DistanceFieldPad, SK_DistanceFieldPad);
+            }
 
             if (ir.isEmpty() || !ir.is16Bit()) {
                 goto SK_ERROR;
@@ -532,6 +538,11 @@ void SkScalerContext::getImage(const SkGlyph& origGlyph) {
             if (maskPreBlend) {
               applyLUTToA8Glyph(*glyph, maskPreBlend->fG);
             }
+        } else if (fRec.fFlags & kDistanceField_Flag) {
+            SkASSERT(SkMask::kA8_Format == mask.fFormat);
+            generateMask(mask, devPath, NULL);
+            SkGenerateDistanceFieldFromA8((uint8_t*)glyph->fImage, glyph->fWidth,
+                                          glyph->fHeight, glyph->rowBytes());
         } else {
             generateMask(mask, devPath, maskPreBlend);
             //apply maskPreBlend to a8 (if not NULL) -- already applied to lcd.
@@ -138,6 +138,10 @@ public:
         // Generate A8 from LCD source (for GDI), only meaningful if fMaskFormat is kA8
         // Perhaps we can store this (instead) in fMaskFormat, in hight bit?
         kGenA8FromLCD_Flag        = 0x0800,
+
+        // Generate signed distance fields from the glyph paths, for drawing
+        // at any scale (see SkDistanceField.h). Only used with kA8 fMaskFormat.
+        kDistanceField_Flag       = 0x1000,
     };
 
     // computed values
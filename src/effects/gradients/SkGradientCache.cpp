@@ -0,0 +1,265 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGradientCache.h"
+#include "SkChecksum.h"
+#include "SkMallocPixelRef.h"
+#include "SkThread.h"
+#include "SkUnitMapper.h"
+
+#ifndef SK_DEFAULT_GRADIENT_CACHE_LIMIT
+    // a 32bit table (plain + dither) is about 2K, so this holds ~256 of them
+    #define SK_DEFAULT_GRADIENT_CACHE_LIMIT     (512 * 1024)
+#endif
+
+#define HASH_BITCOUNT   8
+#define HASH_COUNT      (1 << HASH_BITCOUNT)
+#define HASH_MASK       (HASH_COUNT - 1)
+
+namespace {
+
+struct Entry {
+    Entry*              fPrev;      // LRU list, most recently used at the head
+    Entry*              fNext;
+    Entry*              fHashNext;  // bucket chain
+
+    uint32_t            fHash;
+    int                 fKeyCount;
+    int32_t*            fKey;
+    SkUnitMapper*       fMapper;
+    SkMallocPixelRef*   fTable;
+
+    Entry(const int32_t key[], int keyCount, uint32_t hash,
+          SkUnitMapper* mapper, SkMallocPixelRef* table)
+            : fPrev(NULL), fNext(NULL), fHashNext(NULL)
+            , fHash(hash), fKeyCount(keyCount) {
+        fKey = (int32_t*)sk_malloc_throw(keyCount * sizeof(int32_t));
+        memcpy(fKey, key, keyCount * sizeof(int32_t));
+        fMapper = mapper;
+        SkSafeRef(mapper);
+        fTable = table;
+        table->ref();
+    }
+
+    ~Entry() {
+        fTable->unref();
+        SkSafeUnref(fMapper);
+        sk_free(fKey);
+    }
+
+    size_t bytesUsed() const {
+        return fTable->getSize() + fKeyCount * sizeof(int32_t) + sizeof(Entry);
+    }
+
+    bool equals(const int32_t key[], int keyCount, uint32_t hash,
+                SkUnitMapper* mapper) const {
+        return fHash == hash && fKeyCount == keyCount && fMapper == mapper &&
+               !memcmp(fKey, key, keyCount * sizeof(int32_t));
+    }
+};
+
+class GradientCache {
+public:
+    GradientCache() : fHead(NULL), fTail(NULL) {
+        sk_bzero(fHash, sizeof(fHash));
+        sk_bzero(&fStats, sizeof(fStats));
+        fStats.fByteLimit = SK_DEFAULT_GRADIENT_CACHE_LIMIT;
+    }
+
+    SkMallocPixelRef* findAndRef(const int32_t key[], int keyCount,
+                                 uint32_t hash, SkUnitMapper* mapper) {
+        Entry* entry = this->find(key, keyCount, hash, mapper);
+        if (NULL == entry) {
+            fStats.fMissCount += 1;
+            return NULL;
+        }
+        fStats.fHitCount += 1;
+        // move to the head of our list, so we purge it last
+        this->detach(entry);
+        this->attachToHead(entry);
+        entry->fTable->ref();
+        return entry->fTable;
+    }
+
+    SkMallocPixelRef* addAndRef(const int32_t key[], int keyCount,
+                                uint32_t hash, SkUnitMapper* mapper,
+                                SkMallocPixelRef* table) {
+        Entry* entry = this->find(key, keyCount, hash, mapper);
+        if (entry) {
+            // someone else built the same table while we were building ours
+            entry->fTable->ref();
+            return entry->fTable;
+        }
+
+        table->ref();
+        entry = SkNEW_ARGS(Entry, (key, keyCount, hash, mapper, table));
+        size_t bytes = entry->bytesUsed();
+        if (bytes > fStats.fByteLimit) {
+            // too big to ever fit in the cache, so don't even try
+            SkDELETE(entry);
+            return table;
+        }
+        this->purgeToFit(fStats.fByteLimit - bytes);
+
+        this->attachToHead(entry);
+        Entry** bucket = &fHash[hash & HASH_MASK];
+        entry->fHashNext = *bucket;
+        *bucket = entry;
+        fStats.fBytesUsed += bytes;
+        fStats.fEntryCount += 1;
+        this->validate();
+        return table;
+    }
+
+    size_t setLimit(size_t bytes) {
+        size_t prev = fStats.fByteLimit;
+        fStats.fByteLimit = bytes;
+        this->purgeToFit(bytes);
+        return prev;
+    }
+
+    void purgeToFit(size_t bytes) {
+        while (fStats.fBytesUsed > bytes) {
+            SkASSERT(fTail);
+            this->remove(fTail);
+            fStats.fPurgeCount += 1;
+        }
+        this->validate();
+    }
+
+    SkGradientShader::CacheStats fStats;
+
+private:
+    Entry*  fHead;
+    Entry*  fTail;
+    Entry*  fHash[HASH_COUNT];
+
+    Entry* find(const int32_t key[], int keyCount, uint32_t hash,
+                SkUnitMapper* mapper) const {
+        Entry* entry = fHash[hash & HASH_MASK];
+        while (entry) {
+            if (entry->equals(key, keyCount, hash, mapper)) {
+                return entry;
+            }
+            entry = entry->fHashNext;
+        }
+        return NULL;
+    }
+
+    void remove(Entry* entry) {
+        Entry** link = &fHash[entry->fHash & HASH_MASK];
+        while (*link != entry) {
+            SkASSERT(*link);
+            link = &(*link)->fHashNext;
+        }
+        *link = entry->fHashNext;
+
+        this->detach(entry);
+        fStats.fBytesUsed -= entry->bytesUsed();
+        fStats.fEntryCount -= 1;
+        SkDELETE(entry);
+    }
+
+    void detach(Entry* entry) {
+        if (entry->fPrev) {
+            entry->fPrev->fNext = entry->fNext;
+        } else {
+            SkASSERT(fHead == entry);
+            fHead = entry->fNext;
+        }
+        if (entry->fNext) {
+            entry->fNext->fPrev = entry->fPrev;
+        } else {
+            SkASSERT(fTail == entry);
+            fTail = entry->fPrev;
+        }
+    }
+
+    void attachToHead(Entry* entry) {
+        entry->fPrev = NULL;
+        entry->fNext = fHead;
+        if (fHead) {
+            fHead->fPrev = entry;
+        } else {
+            fTail = entry;
+        }
+        fHead = entry;
+    }
+
+#ifdef SK_DEBUG
+    void validate() const {
+        int count = 0;
+        size_t bytes = 0;
+        for (const Entry* entry = fHead; entry; entry = entry->fNext) {
+            SkASSERT(entry->fNext || fTail == entry);
+            SkASSERT(this->find(entry->fKey, entry->fKeyCount, entry->fHash,
+                                entry->fMapper) == entry);
+            count += 1;
+            bytes += entry->bytesUsed();
+        }
+        SkASSERT(count == fStats.fEntryCount);
+        SkASSERT(bytes == fStats.fBytesUsed);
+        SkASSERT(bytes <= fStats.fByteLimit);
+    }
+#else
+    void validate() const {}
+#endif
+};
+
+}
+
+SK_DECLARE_STATIC_MUTEX(gGradientCacheMutex);
+
+// must be called with gGradientCacheMutex held
+static GradientCache& get_cache() {
+    static GradientCache* gCache;
+    if (NULL == gCache) {
+        gCache = SkNEW(GradientCache);
+    }
+    return *gCache;
+}
+
+static uint32_t hash_key(const int32_t key[], int keyCount) {
+    return SkChecksum::Compute(reinterpret_cast<const uint32_t*>(key),
+                               keyCount * sizeof(int32_t));
+}
+
+SkMallocPixelRef* SkGradientCache::FindAndRef(const int32_t key[], int keyCount,
+                                              SkUnitMapper* mapper) {
+    uint32_t hash = hash_key(key, keyCount);
+    SkAutoMutexAcquire ama(gGradientCacheMutex);
+    return get_cache().findAndRef(key, keyCount, hash, mapper);
+}
+
+SkMallocPixelRef* SkGradientCache::AddAndRef(const int32_t key[], int keyCount,
+                                             SkUnitMapper* mapper,
+                                             SkMallocPixelRef* table) {
+    uint32_t hash = hash_key(key, keyCount);
+    SkAutoMutexAcquire ama(gGradientCacheMutex);
+    return get_cache().addAndRef(key, keyCount, hash, mapper, table);
+}
+
+size_t SkGradientCache::GetLimit() {
+    SkAutoMutexAcquire ama(gGradientCacheMutex);
+    return get_cache().fStats.fByteLimit;
+}
+
+size_t SkGradientCache::SetLimit(size_t bytes) {
+    SkAutoMutexAcquire ama(gGradientCacheMutex);
+    return get_cache().setLimit(bytes);
+}
+
+void SkGradientCache::PurgeAll() {
+    SkAutoMutexAcquire ama(gGradientCacheMutex);
+    get_cache().purgeToFit(0);
+}
+
+void SkGradientCache::GetStats(SkGradientShader::CacheStats* stats) {
+    SkAutoMutexAcquire ama(gGradientCacheMutex);
+    *stats = get_cache().fStats;
+}
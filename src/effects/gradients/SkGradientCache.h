@@ -0,0 +1,54 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradientCache_DEFINED
+#define SkGradientCache_DEFINED
+
+#include "SkGradientShader.h"
+
+class SkMallocPixelRef;
+class SkUnitMapper;
+
+/**
+ *  Process-wide, budgeted pool of gradient color tables. Gradients that share
+ *  the same colors, positions, mapper and table format (16 or 32 bit, plus the
+ *  paint alpha for 32 bit tables) share a single immutable table, no matter
+ *  how many shader instances (or threads) ask for it. Each table holds both
+ *  the plain and the dithered halves, so the dither mode is part of the table
+ *  format rather than the key.
+ *
+ *  The key is an opaque array of 32bit values built by the caller; the mapper
+ *  is passed separately so that the cache can hold a ref on it, guaranteeing
+ *  that its address is not reused by another mapper while the entry lives.
+ */
+class SkGradientCache {
+public:
+    /**
+     *  Returns the table stored under the given key, with its ref count
+     *  incremented, or NULL if there is no such table.
+     */
+    static SkMallocPixelRef* FindAndRef(const int32_t key[], int keyCount,
+                                        SkUnitMapper* mapper);
+
+    /**
+     *  Offers a newly built table to the cache and returns the table the
+     *  caller should use, with its ref count incremented. This is normally
+     *  the table that was passed in, but if another thread won the race to
+     *  add the same key, the table already in the cache is returned instead.
+     */
+    static SkMallocPixelRef* AddAndRef(const int32_t key[], int keyCount,
+                                       SkUnitMapper* mapper,
+                                       SkMallocPixelRef* table);
+
+    static size_t GetLimit();
+    static size_t SetLimit(size_t bytes);
+    static void PurgeAll();
+    static void GetStats(SkGradientShader::CacheStats*);
+};
+
+#endif
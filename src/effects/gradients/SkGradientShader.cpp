@@ -7,6 +7,7 @@
  */
 
 #include "SkGradientShaderPriv.h"
+#include "SkGradientCache.h"
 #include "SkLinearGradient.h"
 #include "SkRadialGradient.h"
 #include "SkTwoPointRadialGradient.h"
@@ -27,8 +28,9 @@ SkGradientShaderBase::SkGradientShaderBase(const SkColor colors[], const SkScala
     fTileMode = mode;
     fTileProc = gTileProcs[mode];
 
-    fCache16 = fCache16Storage = NULL;
+    fCache16 = NULL;
     fCache32 = NULL;
+    fCache16PixelRef = NULL;
     fCache32PixelRef = NULL;
 
     /*  Note: we let the caller skip the first and/or last position.
@@ -136,8 +138,9 @@ SkGradientShaderBase::SkGradientShaderBase(SkFlattenableReadBuffer& buffer) :
 
     fMapper = buffer.readFlattenableT<SkUnitMapper>();
 
-    fCache16 = fCache16Storage = NULL;
+    fCache16 = NULL;
     fCache32 = NULL;
+    fCache16PixelRef = NULL;
     fCache32PixelRef = NULL;
 
     int colorCount = fColorCount = buffer.getArrayCount();
@@ -165,9 +168,7 @@ SkGradientShaderBase::SkGradientShaderBase(SkFlattenableReadBuffer& buffer) :
 }
 
 SkGradientShaderBase::~SkGradientShaderBase() {
-    if (fCache16Storage) {
-        sk_free(fCache16Storage);
-    }
+    SkSafeUnref(fCache16PixelRef);
     SkSafeUnref(fCache32PixelRef);
     if (fOrigColors != fStorage) {
         sk_free(fOrigColors);
@@ -238,16 +239,12 @@ bool SkGradientShaderBase::setContext(const SkBitmap& device,
 
 void SkGradientShaderBase::setCacheAlpha(U8CPU alpha) const {
     // if the new alpha differs from the previous time we were called, inval our cache
-    // this will trigger the cache to be rebuilt.
+    // this will trigger the cache to be looked up (or rebuilt) again.
     // we don't care about the first time, since the cache ptrs will already be NULL
+    // The 16bit cache doesn't depend on alpha, so it stays valid.
     if (fCacheAlpha != alpha) {
-        fCache16 = NULL;            // inval the cache
         fCache32 = NULL;            // inval the cache
         fCacheAlpha = alpha;        // record the new alpha
-        // inform our subclasses
-        if (fCache32PixelRef) {
-            fCache32PixelRef->notifyPixelsChanged();
-        }
     }
 }
 
@@ -370,48 +367,65 @@ static void complete_16bit_cache(uint16_t* cache, int stride) {
     cache[2 * stride - 1] = cache[2 * stride - 2];
 }
 
-const uint16_t* SkGradientShaderBase::getCache16() const {
-    if (fCache16 == NULL) {
-        // double the count for dither entries
-        const int entryCount = kCache16Count * 2;
-        const size_t allocSize = sizeof(uint16_t) * entryCount;
+SkMallocPixelRef* SkGradientShaderBase::build16bitTable() const {
+    // double the count for dither entries
+    const int entryCount = kCache16Count * 2;
+    const size_t allocSize = sizeof(uint16_t) * entryCount;
+
+    SkMallocPixelRef* table = SkNEW_ARGS(SkMallocPixelRef,
+                                         (NULL, allocSize, NULL));
+    uint16_t* cache = (uint16_t*)table->getAddr();
 
-        if (fCache16Storage == NULL) { // set the storage and our working ptr
-            fCache16Storage = (uint16_t*)sk_malloc_throw(allocSize);
+    // if we have a mapper, build the linear data off to the side first
+    SkAutoMalloc linearStorage(fMapper ? allocSize : 0);
+    uint16_t* linear = fMapper ? (uint16_t*)linearStorage.get() : cache;
+
+    if (fColorCount == 2) {
+        Build16bitCache(linear, fOrigColors[0], fOrigColors[1],
+                        kGradient16Length);
+    } else {
+        Rec* rec = fRecs;
+        int prevIndex = 0;
+        for (int i = 1; i < fColorCount; i++) {
+            int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache16Shift;
+            SkASSERT(nextIndex < kCache16Count);
+
+            if (nextIndex > prevIndex)
+                Build16bitCache(linear + prevIndex, fOrigColors[i-1], fOrigColors[i], nextIndex - prevIndex + 1);
+            prevIndex = nextIndex;
         }
-        fCache16 = fCache16Storage;
-        if (fColorCount == 2) {
-            Build16bitCache(fCache16, fOrigColors[0], fOrigColors[1],
-                            kGradient16Length);
-        } else {
-            Rec* rec = fRecs;
-            int prevIndex = 0;
-            for (int i = 1; i < fColorCount; i++) {
-                int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache16Shift;
-                SkASSERT(nextIndex < kCache16Count);
-
-                if (nextIndex > prevIndex)
-                    Build16bitCache(fCache16 + prevIndex, fOrigColors[i-1], fOrigColors[i], nextIndex - prevIndex + 1);
-                prevIndex = nextIndex;
-            }
-            // one extra space left over at the end for complete_16bit_cache()
-            SkASSERT(prevIndex == kGradient16Length - 1);
+        // one extra space left over at the end for complete_16bit_cache()
+        SkASSERT(prevIndex == kGradient16Length - 1);
+    }
+
+    if (fMapper) {
+        uint16_t* mapped = cache;  // storage for mapped data
+        SkUnitMapper* map = fMapper;
+        for (int i = 0; i < kGradient16Length; i++) {
+            int index = map->mapUnit16(bitsTo16(i, kCache16Bits)) >> kCache16Shift;
+            mapped[i] = linear[index];
+            mapped[i + kCache16Count] = linear[index + kCache16Count];
         }
+    }
+    complete_16bit_cache(cache, kCache16Count);
+    return table;
+}
 
-        if (fMapper) {
-            fCache16Storage = (uint16_t*)sk_malloc_throw(allocSize);
-            uint16_t* linear = fCache16;         // just computed linear data
-            uint16_t* mapped = fCache16Storage;  // storage for mapped data
-            SkUnitMapper* map = fMapper;
-            for (int i = 0; i < kGradient16Length; i++) {
-                int index = map->mapUnit16(bitsTo16(i, kCache16Bits)) >> kCache16Shift;
-                mapped[i] = linear[index];
-                mapped[i + kCache16Count] = linear[index + kCache16Count];
-            }
-            sk_free(fCache16);
-            fCache16 = fCache16Storage;
+const uint16_t* SkGradientShaderBase::getCache16() const {
+    if (fCache16 == NULL) {
+        const int keyCount = this->getCacheKeyCount();
+        SkAutoSTMalloc<16, int32_t> key(keyCount);
+        this->buildCacheKey(k16bit_TableType, key.get());
+
+        SkSafeUnref(fCache16PixelRef);
+        fCache16PixelRef = SkGradientCache::FindAndRef(key.get(), keyCount,
+                                                       fMapper);
+        if (NULL == fCache16PixelRef) {
+            SkAutoTUnref<SkMallocPixelRef> table(this->build16bitTable());
+            fCache16PixelRef = SkGradientCache::AddAndRef(key.get(), keyCount,
+                                                          fMapper, table);
         }
-        complete_16bit_cache(fCache16, kCache16Count);
+        fCache16 = (uint16_t*)fCache16PixelRef->getAddr();
     }
     return fCache16;
 }
@@ -424,87 +438,85 @@ static void complete_32bit_cache(SkPMColor* cache, int stride) {
     cache[2 * stride - 1] = cache[2 * stride - 2];
 }
 
-const SkPMColor* SkGradientShaderBase::getCache32() const {
-    if (fCache32 == NULL) {
-        // double the count for dither entries
-        const int entryCount = kCache32Count * 2;
-        const size_t allocSize = sizeof(SkPMColor) * entryCount;
+SkMallocPixelRef* SkGradientShaderBase::build32bitTable() const {
+    // double the count for dither entries
+    const int entryCount = kCache32Count * 2;
+    const size_t allocSize = sizeof(SkPMColor) * entryCount;
 
-        if (NULL == fCache32PixelRef) {
-            fCache32PixelRef = SkNEW_ARGS(SkMallocPixelRef,
-                                          (NULL, allocSize, NULL));
-        }
-        fCache32 = (SkPMColor*)fCache32PixelRef->getAddr();
-        if (fColorCount == 2) {
-            Build32bitCache(fCache32, fOrigColors[0], fOrigColors[1],
-                            kGradient32Length, fCacheAlpha);
-        } else {
-            Rec* rec = fRecs;
-            int prevIndex = 0;
-            for (int i = 1; i < fColorCount; i++) {
-                int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache32Shift;
-                SkASSERT(nextIndex < kGradient32Length);
-
-                if (nextIndex > prevIndex)
-                    Build32bitCache(fCache32 + prevIndex, fOrigColors[i-1],
-                                    fOrigColors[i],
-                                    nextIndex - prevIndex + 1, fCacheAlpha);
-                prevIndex = nextIndex;
-            }
-            SkASSERT(prevIndex == kGradient32Length - 1);
+    SkMallocPixelRef* table = SkNEW_ARGS(SkMallocPixelRef,
+                                         (NULL, allocSize, NULL));
+    SkPMColor* cache = (SkPMColor*)table->getAddr();
+
+    // if we have a mapper, build the linear data off to the side first
+    SkAutoMalloc linearStorage(fMapper ? allocSize : 0);
+    SkPMColor* linear = fMapper ? (SkPMColor*)linearStorage.get() : cache;
+
+    if (fColorCount == 2) {
+        Build32bitCache(linear, fOrigColors[0], fOrigColors[1],
+                        kGradient32Length, fCacheAlpha);
+    } else {
+        Rec* rec = fRecs;
+        int prevIndex = 0;
+        for (int i = 1; i < fColorCount; i++) {
+            int nextIndex = SkFixedToFFFF(rec[i].fPos) >> kCache32Shift;
+            SkASSERT(nextIndex < kGradient32Length);
+
+            if (nextIndex > prevIndex)
+                Build32bitCache(linear + prevIndex, fOrigColors[i-1],
+                                fOrigColors[i],
+                                nextIndex - prevIndex + 1, fCacheAlpha);
+            prevIndex = nextIndex;
         }
+        SkASSERT(prevIndex == kGradient32Length - 1);
+    }
 
-        if (fMapper) {
-            SkMallocPixelRef* newPR = SkNEW_ARGS(SkMallocPixelRef,
-                                                 (NULL, allocSize, NULL));
-            SkPMColor* linear = fCache32;           // just computed linear data
-            SkPMColor* mapped = (SkPMColor*)newPR->getAddr();    // storage for mapped data
-            SkUnitMapper* map = fMapper;
-            for (int i = 0; i < kGradient32Length; i++) {
-                int index = map->mapUnit16((i << 8) | i) >> 8;
-                mapped[i] = linear[index];
-                mapped[i + kCache32Count] = linear[index + kCache32Count];
-            }
-            fCache32PixelRef->unref();
-            fCache32PixelRef = newPR;
-            fCache32 = (SkPMColor*)newPR->getAddr();
+    if (fMapper) {
+        SkPMColor* mapped = cache;    // storage for mapped data
+        SkUnitMapper* map = fMapper;
+        for (int i = 0; i < kGradient32Length; i++) {
+            int index = map->mapUnit16((i << 8) | i) >> 8;
+            mapped[i] = linear[index];
+            mapped[i + kCache32Count] = linear[index + kCache32Count];
         }
-        complete_32bit_cache(fCache32, kCache32Count);
     }
-    return fCache32;
+    complete_32bit_cache(cache, kCache32Count);
+    return table;
 }
 
-/*
- *  Because our caller might rebuild the same (logically the same) gradient
- *  over and over, we'd like to return exactly the same "bitmap" if possible,
- *  allowing the client to utilize a cache of our bitmap (e.g. with a GPU).
- *  To do that, we maintain a private cache of built-bitmaps, based on our
- *  colors and positions. Note: we don't try to flatten the fMapper, so if one
- *  is present, we skip the cache for now.
- */
-void SkGradientShaderBase::getGradientTableBitmap(SkBitmap* bitmap) const {
-    // our caller assumes no external alpha, so we ensure that our cache is
-    // built with 0xFF
-    this->setCacheAlpha(0xFF);
+const SkPMColor* SkGradientShaderBase::getCache32() const {
+    if (fCache32 == NULL) {
+        const int keyCount = this->getCacheKeyCount();
+        SkAutoSTMalloc<16, int32_t> key(keyCount);
+        this->buildCacheKey(k32bit_TableType, key.get());
 
-    // don't have a way to put the mapper into our cache-key yet
-    if (fMapper) {
-        // force our cahce32pixelref to be built
-        (void)this->getCache32();
-        bitmap->setConfig(SkBitmap::kARGB_8888_Config, kGradient32Length, 1);
-        bitmap->setPixelRef(fCache32PixelRef);
-        return;
+        SkSafeUnref(fCache32PixelRef);
+        fCache32PixelRef = SkGradientCache::FindAndRef(key.get(), keyCount,
+                                                       fMapper);
+        if (NULL == fCache32PixelRef) {
+            SkAutoTUnref<SkMallocPixelRef> table(this->build32bitTable());
+            fCache32PixelRef = SkGradientCache::AddAndRef(key.get(), keyCount,
+                                                          fMapper, table);
+        }
+        fCache32 = (SkPMColor*)fCache32PixelRef->getAddr();
     }
+    return fCache32;
+}
 
-    // build our key: [numColors + colors[] + {positions[]} ]
-    int count = 1 + fColorCount;
+int SkGradientShaderBase::getCacheKeyCount() const {
+    // [type + alpha + numColors + colors[] + {positions[]} ]
+    int count = 3 + fColorCount;
     if (fColorCount > 2) {
         count += fColorCount - 1;    // fRecs[].fPos
     }
+    return count;
+}
 
-    SkAutoSTMalloc<16, int32_t> storage(count);
-    int32_t* buffer = storage.get();
+void SkGradientShaderBase::buildCacheKey(TableType type, int32_t key[]) const {
+    int32_t* buffer = key;
 
+    *buffer++ = type;
+    // the 16bit table ignores the paint's alpha
+    *buffer++ = (k32bit_TableType == type) ? fCacheAlpha : 0;
     *buffer++ = fColorCount;
     memcpy(buffer, fOrigColors, fColorCount * sizeof(SkColor));
     buffer += fColorCount;
@@ -513,31 +525,28 @@ void SkGradientShaderBase::getGradientTableBitmap(SkBitmap* bitmap) const {
             *buffer++ = fRecs[i].fPos;
         }
     }
-    SkASSERT(buffer - storage.get() == count);
-
-    ///////////////////////////////////
-
-    SK_DECLARE_STATIC_MUTEX(gMutex);
-    static SkBitmapCache* gCache;
-    // each cache cost 1K of RAM, since each bitmap will be 1x256 at 32bpp
-    static const int MAX_NUM_CACHED_GRADIENT_BITMAPS = 32;
-    SkAutoMutexAcquire ama(gMutex);
-
-    if (NULL == gCache) {
-        gCache = SkNEW_ARGS(SkBitmapCache, (MAX_NUM_CACHED_GRADIENT_BITMAPS));
-    }
-    size_t size = count * sizeof(int32_t);
+    SkASSERT(buffer - key == this->getCacheKeyCount());
+}
 
-    if (!gCache->find(storage.get(), size, bitmap)) {
-        // force our cahce32pixelref to be built
-        (void)this->getCache32();
-        // Only expose the linear section of the cache; don't let the caller
-        // know about the padding at the end to make interpolation faster.
-        bitmap->setConfig(SkBitmap::kARGB_8888_Config, kGradient32Length, 1);
-        bitmap->setPixelRef(fCache32PixelRef);
+/*
+ *  Because our caller might rebuild the same (logically the same) gradient
+ *  over and over, we'd like to return exactly the same "bitmap" if possible,
+ *  allowing the client to utilize a cache of our bitmap (e.g. with a GPU).
+ *  Since our tables come from SkGradientCache, every gradient with the same
+ *  colors, positions and mapper hands out the same pixelref (as long as it is
+ *  still in the cache).
+ */
+void SkGradientShaderBase::getGradientTableBitmap(SkBitmap* bitmap) const {
+    // our caller assumes no external alpha, so we ensure that our cache is
+    // built with 0xFF
+    this->setCacheAlpha(0xFF);
 
-        gCache->add(storage.get(), size, *bitmap);
-    }
+    // force our cache32pixelref to be looked up or built
+    (void)this->getCache32();
+    // Only expose the linear section of the cache; don't let the caller
+    // know about the padding at the end to make interpolation faster.
+    bitmap->setConfig(SkBitmap::kARGB_8888_Config, kGradient32Length, 1);
+    bitmap->setPixelRef(fCache32PixelRef);
 }
 
 void SkGradientShaderBase::commonAsAGradient(GradientInfo* info) const {
@@ -660,6 +669,22 @@ SkShader* SkGradientShader::CreateSweep(SkScalar cx, SkScalar cy,
     return SkNEW_ARGS(SkSweepGradient, (cx, cy, colors, pos, count, mapper));
 }
 
+void SkGradientShader::GetCacheStats(CacheStats* stats) {
+    SkGradientCache::GetStats(stats);
+}
+
+size_t SkGradientShader::GetCacheLimit() {
+    return SkGradientCache::GetLimit();
+}
+
+size_t SkGradientShader::SetCacheLimit(size_t bytes) {
+    return SkGradientCache::SetLimit(bytes);
+}
+
+void SkGradientShader::PurgeCache() {
+    SkGradientCache::PurgeAll();
+}
+
 SK_DEFINE_FLATTENABLE_REGISTRAR_GROUP_START(SkGradientShader)
     SK_DEFINE_FLATTENABLE_REGISTRAR_ENTRY(SkLinearGradient)
     SK_DEFINE_FLATTENABLE_REGISTRAR_ENTRY(SkRadialGradient)
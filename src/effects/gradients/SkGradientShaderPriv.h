@@ -17,7 +17,6 @@
 #include "SkUnitMapper.h"
 #include "SkUtils.h"
 #include "SkTemplates.h"
-#include "SkBitmapCache.h"
 #include "SkShader.h"
 
 #ifndef SK_DISABLE_DITHER_32BIT_GRADIENT
@@ -175,13 +174,24 @@ private:
     mutable uint16_t*   fCache16;   // working ptr. If this is NULL, we need to recompute the cache values
     mutable SkPMColor*  fCache32;   // working ptr. If this is NULL, we need to recompute the cache values
 
-    mutable uint16_t*   fCache16Storage;    // storage for fCache16, allocated on demand
+    // The tables are immutable once built, and shared (through SkGradientCache)
+    // with every other gradient that has the same colors, positions and mapper.
+    mutable SkMallocPixelRef* fCache16PixelRef;
     mutable SkMallocPixelRef* fCache32PixelRef;
     mutable unsigned    fCacheAlpha;        // the alpha value we used when we computed the cache. larger than 8bits so we can store uninitialized value
 
+    enum TableType {
+        k16bit_TableType,
+        k32bit_TableType
+    };
+
     static void Build16bitCache(uint16_t[], SkColor c0, SkColor c1, int count);
     static void Build32bitCache(SkPMColor[], SkColor c0, SkColor c1, int count,
                                 U8CPU alpha);
+    SkMallocPixelRef* build16bitTable() const;
+    SkMallocPixelRef* build32bitTable() const;
+    int getCacheKeyCount() const;
+    void buildCacheKey(TableType, int32_t key[]) const;
     void setCacheAlpha(U8CPU alpha) const;
     void initCommon();
 
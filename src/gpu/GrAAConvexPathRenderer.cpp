@@ -11,11 +11,13 @@
 #include "GrContext.h"
 #include "GrDrawState.h"
 #include "GrPathUtils.h"
+#include "GrPathVertexCache.h"
 #include "SkString.h"
 #include "SkTrace.h"
 
 
-GrAAConvexPathRenderer::GrAAConvexPathRenderer() {
+GrAAConvexPathRenderer::GrAAConvexPathRenderer(GrPathVertexCache* vertexCache)
+    : fVertexCache(vertexCache) {
 }
 
 namespace {
@@ -482,6 +484,49 @@ bool GrAAConvexPathRenderer::onDrawPath(const SkPath& origPath,
     QuadVertex *verts;
     uint16_t* idxs;
 
+    // The vertices are in device space, but their edge distances and uvs
+    // don't change when the path is translated. So they can be reused for any
+    // view matrix with the same scale and skew by offsetting the positions.
+    GrPathVertexCache::Key key;
+    if (NULL != fVertexCache && !vm.hasPerspective()) {
+        memset(&key, 0, sizeof(key));
+        key.fTag = SkSetFourByteTag('a', 'a', 'c', 'v');
+        key.fMatrix[0] = vm.getScaleX();
+        key.fMatrix[1] = vm.getSkewX();
+        key.fMatrix[2] = vm.getSkewY();
+        key.fMatrix[3] = vm.getScaleY();
+        const GrPathVertexCache::Geometry* geom = fVertexCache->find(*path,
+                                                                     key);
+        if (NULL != geom) {
+            GrDrawTarget::AutoReleaseGeometry arg(target, layout,
+                                                  geom->fVertexCount,
+                                                  geom->fIndexCount);
+            if (!arg.succeeded()) {
+                return false;
+            }
+            verts = reinterpret_cast<QuadVertex*>(arg.vertices());
+            memcpy(verts, geom->vertices(),
+                   geom->fVertexCount * sizeof(QuadVertex));
+            memcpy(arg.indices(), geom->indices(),
+                   geom->fIndexCount * sizeof(uint16_t));
+            GrScalar dx = vm.getTranslateX() - geom->fOrigin.fX;
+            GrScalar dy = vm.getTranslateY() - geom->fOrigin.fY;
+            if (dx || dy) {
+                for (int v = 0; v < geom->fVertexCount; ++v) {
+                    verts[v].fPos.offset(dx, dy);
+                }
+            }
+
+            drawState->setVertexEdgeType(GrDrawState::kQuad_EdgeType);
+            target->drawIndexed(kTriangles_GrPrimitiveType,
+                                0,        // start vertex
+                                0,        // start index
+                                geom->fVertexCount,
+                                geom->fIndexCount);
+            return true;
+        }
+    }
+
     int vCount;
     int iCount;
     enum {
@@ -503,6 +548,13 @@ bool GrAAConvexPathRenderer::onDrawPath(const SkPath& origPath,
 
     create_vertices(segments, fanPt, verts, idxs);
 
+    if (NULL != fVertexCache && !vm.hasPerspective()) {
+        GrVec origin = { vm.getTranslateX(), vm.getTranslateY() };
+        fVertexCache->add(*path, key, kTriangles_GrPrimitiveType,
+                          verts, sizeof(QuadVertex), vCount,
+                          idxs, iCount, origin);
+    }
+
     drawState->setVertexEdgeType(GrDrawState::kQuad_EdgeType);
     target->drawIndexed(kTriangles_GrPrimitiveType,
                         0,        // start vertex
@@ -8,10 +8,16 @@
 
 #include "GrPathRenderer.h"
 
+class GrPathVertexCache;
 
 class GrAAConvexPathRenderer : public GrPathRenderer {
 public:
-    GrAAConvexPathRenderer();
+    /**
+     *  If vertexCache isn't NULL, the geometry generated for paths is kept in
+     *  it and reused while the path is drawn with the same scale and skew.
+     *  The cache must outlive the renderer.
+     */
+    GrAAConvexPathRenderer(GrPathVertexCache* vertexCache = NULL);
 
     virtual bool canDrawPath(const SkPath& path,
                              GrPathFill fill,
@@ -24,4 +30,7 @@ protected:
                             const GrVec* translate,
                             GrDrawTarget* target,
                             bool antiAlias) SK_OVERRIDE;
+
+private:
+    GrPathVertexCache*  fVertexCache;
 };
@@ -7,6 +7,7 @@
  */
 
 
+#include "GrContext.h"
 #include "GrStencilAndCoverPathRenderer.h"
 #include "GrAAHairLinePathRenderer.h"
 #include "GrAAConvexPathRenderer.h"
@@ -23,6 +24,7 @@ void GrPathRenderer::AddPathRenderers(GrContext* ctx,
         if (GrPathRenderer* pr = GrAAHairLinePathRenderer::Create(ctx)) {
             chain->addPathRenderer(pr)->unref();
         }
-        chain->addPathRenderer(SkNEW(GrAAConvexPathRenderer))->unref();
+        chain->addPathRenderer(SkNEW_ARGS(GrAAConvexPathRenderer,
+                                          (ctx->getPathVertexCache())))->unref();
     }
 }
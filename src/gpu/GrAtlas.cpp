@@ -204,4 +204,8 @@ void GrAtlasMgr::freePlot(int x, int y) {
     fPlotMgr->freePlot(x, y);
 }
 
+bool GrAtlasMgr::hasFreePlot() const {
+    return fPlotMgr->hasFreePlot();
+}
+
 
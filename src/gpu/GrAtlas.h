@@ -73,6 +73,9 @@ public:
     // to be called by ~GrAtlas()
     void freePlot(int x, int y);
 
+    // returns true if addToAtlas() could start a new atlas
+    bool hasFreePlot() const;
+
 private:
     GrGpu*      fGpu;
     GrTexture*  fTexture[kCount_GrMaskFormats];
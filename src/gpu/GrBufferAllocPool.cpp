@@ -41,6 +41,10 @@ GrBufferAllocPool::GrBufferAllocPool(GrGpu* gpu,
 
     fBytesInUse = 0;
 
+    fRingMode = false;
+    fRingOffset = 0;
+    this->resetCounts();
+
     fPreallocBuffersInUse = 0;
     fPreallocBufferStartIdx = 0;
     for (int i = 0; i < preallocBufferCnt; ++i) {
@@ -84,10 +88,30 @@ void GrBufferAllocPool::reset() {
     }
     // fPreallocBuffersInUse will be decremented down to zero in the while loop
     int preallocBuffersInUse = fPreallocBuffersInUse;
+    int lastPreallocBuffer = 0;
+    size_t lastPreallocBytes = 0;
+    if (fRingMode && preallocBuffersInUse > 0) {
+        lastPreallocBuffer = (fPreallocBufferStartIdx +
+                              preallocBuffersInUse - 1) %
+                             fPreallocBuffers.count();
+        const GrGeometryBuffer* last = fPreallocBuffers[lastPreallocBuffer];
+        for (int i = fBlocks.count() - 1; i >= 0; --i) {
+            if (fBlocks[i].fBuffer == last) {
+                lastPreallocBytes = last->sizeInBytes() - fBlocks[i].fBytesFree;
+                break;
+            }
+        }
+    }
     while (!fBlocks.empty()) {
         this->destroyBlock();
     }
-    if (fPreallocBuffers.count()) {
+    if (fRingMode) {
+        // carry on in the last preallocated buffer used
+        if (preallocBuffersInUse > 0) {
+            fPreallocBufferStartIdx = lastPreallocBuffer;
+            fRingOffset = lastPreallocBytes;
+        }
+    } else if (fPreallocBuffers.count()) {
         // must set this after above loop.
         fPreallocBufferStartIdx = (fPreallocBufferStartIdx +
                                    preallocBuffersInUse) %
@@ -104,18 +128,21 @@ void GrBufferAllocPool::unlock() {
     VALIDATE();
 
     if (NULL != fBufferPtr) {
-        BufferBlock& block = fBlocks.back();
-        if (block.fBuffer->isLocked()) {
-            block.fBuffer->unlock();
-        } else {
-            size_t flushSize = block.fBuffer->sizeInBytes() - block.fBytesFree;
-            flushCpuData(fBlocks.back().fBuffer, flushSize);
+        this->flushBlock(&fBlocks.back());
+        // in ring mode later makeSpace calls keep filling the block
+        if (!fRingMode) {
+            fBufferPtr = NULL;
         }
-        fBufferPtr = NULL;
     }
     VALIDATE();
 }
 
+void GrBufferAllocPool::setRingMode(bool ringMode) {
+    this->reset();
+    fRingMode = ringMode;
+    fRingOffset = 0;
+}
+
 #if GR_DEBUG
 void GrBufferAllocPool::validate(bool unusedBlockAllowed) const {
     if (NULL != fBufferPtr) {
@@ -134,7 +161,10 @@ void GrBufferAllocPool::validate(bool unusedBlockAllowed) const {
         GrAssert(!fBlocks[i].fBuffer->isLocked());
     }
     for (int i = 0; i < fBlocks.count(); ++i) {
-        size_t bytes = fBlocks[i].fBuffer->sizeInBytes() - fBlocks[i].fBytesFree;
+        const BufferBlock& block = fBlocks[i];
+        GrAssert(fRingMode || 0 == block.fStartOffset);
+        size_t bytes = block.fBuffer->sizeInBytes() - block.fBytesFree -
+                       block.fStartOffset;
         bytesInUse += bytes;
         GrAssert(bytes || unusedBlockAllowed);
     }
@@ -174,26 +204,32 @@ void* GrBufferAllocPool::makeSpace(size_t size,
         }
     }
 
-    // We could honor the space request using by a partial update of the current
-    // VB (if there is room). But we don't currently use draw calls to GL that
-    // allow the driver to know that previously issued draws won't read from
-    // the part of the buffer we update. Also, the GL buffer implementation
-    // may be cheating on the actual buffer size by shrinking the buffer on
-    // updateData() if the amount of data passed is less than the full buffer
-    // size.
+    // Outside ring mode we could honor the space request using by a partial
+    // update of the current VB (if there is room). But we don't currently use
+    // draw calls to GL that allow the driver to know that previously issued
+    // draws won't read from the part of the buffer we update. Also, the GL
+    // buffer implementation may be cheating on the actual buffer size by
+    // shrinking the buffer on updateData() if the amount of data passed is
+    // less than the full buffer size.
 
-    if (!createBlock(size)) {
+    if (!createBlock(size, alignment)) {
         return NULL;
     }
     GrAssert(NULL != fBufferPtr);
 
-    *offset = 0;
+    // in ring mode the block may start after data written before the last
+    // reset
     BufferBlock& back = fBlocks.back();
+    size_t usedBytes = back.fBuffer->sizeInBytes() - back.fBytesFree;
+    size_t pad = GrSizeAlignUpPad(usedBytes, alignment);
+    GrAssert(size + pad <= back.fBytesFree);
+    usedBytes += pad;
+    *offset = usedBytes;
     *buffer = back.fBuffer;
-    back.fBytesFree -= size;
-    fBytesInUse += size;
+    back.fBytesFree -= size + pad;
+    fBytesInUse += size + pad;
     VALIDATE();
-    return fBufferPtr;
+    return (void*)(reinterpret_cast<intptr_t>(fBufferPtr) + usedBytes);
 }
 
 int GrBufferAllocPool::currentBufferItems(size_t itemSize) const {
@@ -230,7 +266,19 @@ void GrBufferAllocPool::putBack(size_t bytes) {
         // caller shouldnt try to put back more than they've taken
         GrAssert(!fBlocks.empty());
         BufferBlock& block = fBlocks.back();
-        size_t bytesUsed = block.fBuffer->sizeInBytes() - block.fBytesFree;
+        size_t bytesUsed = block.fBuffer->sizeInBytes() - block.fBytesFree -
+                           block.fStartOffset;
+        if (fRingMode && block.fBytesUploaded > block.fStartOffset) {
+            // Draws may have read the data already written to the buffer, so
+            // its space is not handed out again before the next reset. Only
+            // what was never written is given back.
+            size_t unwritten = block.fBuffer->sizeInBytes() -
+                               block.fBytesFree - block.fBytesUploaded;
+            size_t given = GrMin(bytes, unwritten);
+            block.fBytesFree += given;
+            fBytesInUse -= given;
+            break;
+        }
         if (bytes >= bytesUsed) {
             bytes -= bytesUsed;
             fBytesInUse -= bytesUsed;
@@ -247,7 +295,7 @@ void GrBufferAllocPool::putBack(size_t bytes) {
             break;
         }
     }
-    if (!fPreallocBuffersInUse && fPreallocBuffers.count()) {
+    if (!fRingMode && !fPreallocBuffersInUse && fPreallocBuffers.count()) {
             fPreallocBufferStartIdx = (fPreallocBufferStartIdx +
                                        preallocBuffersInUse) %
                                       fPreallocBuffers.count();
@@ -255,7 +303,7 @@ void GrBufferAllocPool::putBack(size_t bytes) {
     VALIDATE();
 }
 
-bool GrBufferAllocPool::createBlock(size_t requestSize) {
+bool GrBufferAllocPool::createBlock(size_t requestSize, size_t alignment) {
 
     size_t size = GrMax(requestSize, fMinBlockSize);
     GrAssert(size >= GrBufferAllocPool_MIN_BLOCK_SIZE);
@@ -263,10 +311,26 @@ bool GrBufferAllocPool::createBlock(size_t requestSize) {
     VALIDATE();
 
     BufferBlock& block = fBlocks.push_back();
+    block.fStartOffset = 0;
+    block.fBytesUploaded = 0;
 
     if (size == fMinBlockSize &&
         fPreallocBuffersInUse < fPreallocBuffers.count()) {
 
+        if (fRingMode && 0 == fPreallocBuffersInUse) {
+            // Carry on after the data written before the last reset if the
+            // request fits, otherwise move on to the next buffer. Buffers used
+            // since the last reset are never next.
+            size_t pad = GrSizeAlignUpPad(fRingOffset, alignment);
+            if (fRingOffset > 0 &&
+                fRingOffset + pad + requestSize > fMinBlockSize) {
+                fPreallocBufferStartIdx = (fPreallocBufferStartIdx + 1) %
+                                          fPreallocBuffers.count();
+                fRingOffset = 0;
+            }
+            block.fStartOffset = fRingOffset;
+            block.fBytesUploaded = fRingOffset;
+        }
         uint32_t nextBuffer = (fPreallocBuffersInUse +
                                fPreallocBufferStartIdx) %
                               fPreallocBuffers.count();
@@ -281,25 +345,23 @@ bool GrBufferAllocPool::createBlock(size_t requestSize) {
         }
     }
 
-    block.fBytesFree = size;
+    block.fBytesFree = size - block.fStartOffset;
     if (NULL != fBufferPtr) {
         GrAssert(fBlocks.count() > 1);
-        BufferBlock& prev = fBlocks.fromBack(1);
-        if (prev.fBuffer->isLocked()) {
-            prev.fBuffer->unlock();
-        } else {
-            flushCpuData(prev.fBuffer,
-                         prev.fBuffer->sizeInBytes() - prev.fBytesFree);
-        }
+        this->flushBlock(&fBlocks.fromBack(1));
         fBufferPtr = NULL;
     }
 
     GrAssert(NULL == fBufferPtr);
 
-    if (fGpu->getCaps().bufferLockSupport() &&
+    // locking discards the whole buffer, so ring mode always writes through
+    // the CPU copy
+    if (!fRingMode &&
+        fGpu->getCaps().bufferLockSupport() &&
         size > GR_GEOM_BUFFER_LOCK_THRESHOLD &&
         (!fFrequentResetHint || requestSize > GR_GEOM_BUFFER_LOCK_THRESHOLD)) {
         fBufferPtr = block.fBuffer->lock();
+        ++fLockCount;
     }
 
     if (NULL == fBufferPtr) {
@@ -322,6 +384,11 @@ void GrBufferAllocPool::destroyBlock() {
                                       fPreallocBuffers.count();
         if (block.fBuffer == fPreallocBuffers[prevPreallocBuffer]) {
             --fPreallocBuffersInUse;
+            // Blocks holding written data are not put back in ring mode, so
+            // the next block in this buffer starts where this one did.
+            if (fRingMode && 0 == fPreallocBuffersInUse) {
+                fRingOffset = block.fStartOffset;
+            }
         }
     }
     GrAssert(!block.fBuffer->isLocked());
@@ -330,6 +397,43 @@ void GrBufferAllocPool::destroyBlock() {
     fBufferPtr = NULL;
 }
 
+void GrBufferAllocPool::flushBlock(BufferBlock* block) {
+    GrAssert(NULL != block);
+    size_t flushSize = block->fBuffer->sizeInBytes() - block->fBytesFree;
+    if (fRingMode) {
+        this->flushRingData(block);
+    } else if (block->fBuffer->isLocked()) {
+        block->fBuffer->unlock();
+        fBytesUploaded += flushSize;
+    } else {
+        this->flushCpuData(block->fBuffer, flushSize);
+    }
+}
+
+void GrBufferAllocPool::flushRingData(BufferBlock* block) {
+    GrAssert(fRingMode);
+    GrAssert(!block->fBuffer->isLocked());
+    GrAssert(fCpuData.get() == fBufferPtr);
+
+    // write what was added since the last flush, keeping the data before it
+    size_t start = block->fBytesUploaded;
+    size_t end = block->fBuffer->sizeInBytes() - block->fBytesFree;
+    if (end > start) {
+        const void* src = reinterpret_cast<const void*>(
+                            reinterpret_cast<intptr_t>(fBufferPtr) + start);
+        if (!block->fBuffer->updateSubData(src, end - start, start)) {
+            // The buffer's storage shrank when it was last written outside
+            // ring mode. Write the block from the start of the buffer, which
+            // grows it again. The bytes before the block are not read by draws
+            // made since the last reset.
+            block->fBuffer->updateSubData(fBufferPtr, end, 0);
+            start = 0;
+        }
+        fBytesUploaded += end - start;
+        block->fBytesUploaded = end;
+    }
+}
+
 void GrBufferAllocPool::flushCpuData(GrGeometryBuffer* buffer,
                                      size_t flushSize) {
     GrAssert(NULL != buffer);
@@ -338,9 +442,11 @@ void GrBufferAllocPool::flushCpuData(GrGeometryBuffer* buffer,
     GrAssert(flushSize <= buffer->sizeInBytes());
     VALIDATE(true);
 
+    fBytesUploaded += flushSize;
     if (fGpu->getCaps().bufferLockSupport() &&
         flushSize > GR_GEOM_BUFFER_LOCK_THRESHOLD) {
         void* data = buffer->lock();
+        ++fLockCount;
         if (NULL != data) {
             memcpy(data, fBufferPtr, flushSize);
             buffer->unlock();
@@ -352,12 +458,17 @@ void GrBufferAllocPool::flushCpuData(GrGeometryBuffer* buffer,
 }
 
 GrGeometryBuffer* GrBufferAllocPool::createBuffer(size_t size) {
+    GrGeometryBuffer* buffer;
     if (kIndex_BufferType == fBufferType) {
-        return fGpu->createIndexBuffer(size, true);
+        buffer = fGpu->createIndexBuffer(size, true);
     } else {
         GrAssert(kVertex_BufferType == fBufferType);
-        return fGpu->createVertexBuffer(size, true);
+        buffer = fGpu->createVertexBuffer(size, true);
+    }
+    if (NULL != buffer) {
+        ++fBuffersCreated;
     }
+    return buffer;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +30,18 @@ class GrGpu;
  * At creation time a minimum per-buffer size can be specified. Additionally,
  * a number of buffers to preallocate can be specified. These will
  * be allocated at the min size and kept around until the pool is destroyed.
+ *
+ * In ring mode the preallocated buffers are used as a ring: space is handed
+ * out from the last one used, after the data written before the previous
+ * reset, and only when that buffer is full does the pool move on to the next.
+ * Data is staged on the CPU and unlock() writes just the part added since the
+ * last unlock, with one partial update, rather than rewriting the buffer.
+ * Moving on to a buffer discards its old contents, so the driver can give it
+ * new storage instead of waiting for draws still reading them. Data written
+ * since the last reset is never written over, even if it is put back.
+ * Appending to a buffer relies on the driver to keep the write from racing
+ * draws that may still read the buffer, so GrGpu leaves ring mode off unless
+ * asked.
  */
 class GrBufferAllocPool : GrNoncopyable {
 
@@ -65,6 +77,25 @@ public:
      */
     GrGpu* getGpu() { return fGpu; }
 
+    /**
+     * Turns ring mode (see above) on or off. Resets the pool.
+     */
+    void setRingMode(bool ringMode);
+    bool ringMode() const { return fRingMode; }
+
+    /**
+     * The bytes written to buffers, the buffers created and the number of
+     * times a buffer was locked since the last resetCounts().
+     */
+    int bytesUploaded() const { return fBytesUploaded; }
+    int buffersCreated() const { return fBuffersCreated; }
+    int lockCount() const { return fLockCount; }
+    void resetCounts() {
+        fBytesUploaded = 0;
+        fBuffersCreated = 0;
+        fLockCount = 0;
+    }
+
 protected:
     /**
      * Used to determine what type of buffers to create. We could make the
@@ -156,11 +187,18 @@ private:
     struct BufferBlock {
         size_t              fBytesFree;
         GrGeometryBuffer*   fBuffer;
+        // In ring mode, the bytes at the start of the buffer that were
+        // written before the block was created, and the bytes of the buffer
+        // holding the block's data so far. Both are zero otherwise.
+        size_t              fStartOffset;
+        size_t              fBytesUploaded;
     };
 
-    bool createBlock(size_t requestSize);
+    bool createBlock(size_t requestSize, size_t alignment);
     void destroyBlock();
+    void flushBlock(BufferBlock* block);
     void flushCpuData(GrGeometryBuffer* buffer, size_t flushSize);
+    void flushRingData(BufferBlock* block);
 #if GR_DEBUG
     void validate(bool unusedBlockAllowed = false) const;
 #endif
@@ -181,6 +219,15 @@ private:
     int                             fPreallocBufferStartIdx;
     SkAutoMalloc                    fCpuData;
     void*                           fBufferPtr;
+
+    bool                            fRingMode;
+    // bytes of the preallocated buffer at fPreallocBufferStartIdx written
+    // before the last reset
+    size_t                          fRingOffset;
+
+    int                             fBytesUploaded;
+    int                             fBuffersCreated;
+    int                             fLockCount;
 };
 
 class GrVertexBuffer;
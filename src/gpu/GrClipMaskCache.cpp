@@ -7,6 +7,52 @@
  */
 
 #include "GrClipMaskCache.h"
+#include "GrClipMaskManager.h"
+#include "SkThread.h"
+
+namespace {
+
+uint32_t mix(uint32_t hash, uint32_t value) {
+    hash = ((hash << 5) | (hash >> 27)) ^ value;
+    return hash * 0x9E3779B1;
+}
+
+uint32_t mix_data(uint32_t hash, const void* data, size_t size) {
+    GrAssert(SkIsAlign4(size));
+    const uint32_t* values = static_cast<const uint32_t*>(data);
+    for (size_t i = 0; i < size / sizeof(uint32_t); ++i) {
+        hash = mix(hash, values[i]);
+    }
+    return hash;
+}
+
+// Only used to tell clips apart quickly: entries with an equal hash still
+// compare the whole clip stack. Paths contribute their bounds, point and verb
+// counts and fill type rather than all of their points.
+uint32_t hash_clip(const SkClipStack& clip,
+                   const SkIPoint& origin,
+                   const GrIRect& bound) {
+    uint32_t hash = mix(0, clip.getSaveCount());
+    hash = mix_data(hash, &origin, sizeof(origin));
+    hash = mix_data(hash, &bound, sizeof(bound));
+
+    SkClipStack::Iter iter(clip, SkClipStack::Iter::kBottom_IterStart);
+    for (const SkClipStack::Iter::Clip* c = iter.next(); NULL != c;
+         c = iter.next()) {
+        hash = mix(hash, (c->fOp << 1) | c->fDoAA);
+        if (NULL != c->fRect) {
+            hash = mix_data(hash, c->fRect, sizeof(SkRect));
+        } else if (NULL != c->fPath) {
+            hash = mix_data(hash, &c->fPath->getBounds(), sizeof(SkRect));
+            hash = mix(hash, (c->fPath->countPoints() << 8) ^
+                             c->fPath->countVerbs() ^
+                             (c->fPath->getFillType() << 28));
+        }
+    }
+    return hash ^ (hash >> 16);
+}
+
+}
 
 GrClipMaskCache::GrClipMaskCache()
     : fContext(NULL)
@@ -16,7 +62,205 @@ GrClipMaskCache::GrClipMaskCache()
     SkNEW_PLACEMENT(fStack.push_back(), GrClipStackFrame);
 }
 
+GrClipMaskCache::~GrClipMaskCache() {
+
+    while (!fStack.empty()) {
+        GrClipStackFrame* temp = (GrClipStackFrame*) fStack.back();
+        temp->~GrClipStackFrame();
+        fStack.pop_back();
+    }
+    fMaskEntries.deleteAll();
+}
+
 void GrClipMaskCache::push() {
     SkNEW_PLACEMENT(fStack.push_back(), GrClipStackFrame);
 }
 
+uint64_t GrClipMaskCache::NextCacheID() {
+    // Masks never share a key, so one can't be found for another's clip even
+    // if they hash alike or come from different caches on one context.
+    static int32_t gNextID;
+    return (uint32_t) sk_atomic_inc(&gNextID) + 1;
+}
+
+void GrClipMaskCache::acquireMask(const SkClipStack& clip,
+                                  const SkIPoint& origin,
+                                  const GrTextureDesc& desc,
+                                  const GrIRect& bound) {
+
+    if (fStack.empty()) {
+        GrAssert(false);
+        return;
+    }
+
+    GrClipStackFrame* back = (GrClipStackFrame*) fStack.back();
+
+    uint32_t hash = hash_clip(clip, origin, bound);
+    MaskEntry* entry = NULL;
+    for (int i = 0; i < fMaskEntries.count(); ++i) {
+        MaskEntry* e = fMaskEntries[i];
+        if (hash == e->fHash && origin == e->fOrigin &&
+            bound == e->fBound && clip == e->fClip) {
+            entry = e;
+            fMaskEntries.remove(i);
+            break;
+        }
+    }
+
+    // Clips that change every frame (e.g. animated ones) would fill the
+    // texture cache with masks that are never used again, so a mask only
+    // gets its own texture once its clip comes back.
+    uint64_t cacheID = NULL != entry ? NextCacheID() : 0;
+    back->acquireMask(fContext, clip, desc, bound, cacheID);
+    if (NULL == back->fLastMask) {
+        SkDELETE(entry);
+        return;
+    }
+
+    if (NULL == entry) {
+        if (fMaskEntries.count() >= kMaxMaskEntries) {
+            // its texture, if any, is left to the texture cache to purge
+            SkDELETE(fMaskEntries.top());
+            fMaskEntries.pop();
+        }
+        entry = SkNEW(MaskEntry);
+        entry->fHash = hash;
+        entry->fClip = clip;
+        entry->fOrigin = origin;
+        entry->fBound = bound;
+    }
+    entry->fDesc = desc;
+    entry->fCacheID = cacheID;
+    *fMaskEntries.insert(0) = entry;
+}
+
+bool GrClipMaskCache::findMask(const SkClipStack& clip,
+                               const SkIPoint& origin,
+                               const GrIRect& bound) {
+
+    if (fStack.empty()) {
+        GrAssert(false);
+        return false;
+    }
+
+    GrClipStackFrame* back = (GrClipStackFrame*) fStack.back();
+
+    uint32_t hash = hash_clip(clip, origin, bound);
+    for (int i = 0; i < fMaskEntries.count(); ++i) {
+        MaskEntry* entry = fMaskEntries[i];
+        if (hash != entry->fHash || origin != entry->fOrigin ||
+            bound != entry->fBound || !(clip == entry->fClip)) {
+            continue;
+        }
+        if (i > 0) {
+            fMaskEntries.remove(i);
+            *fMaskEntries.insert(0) = entry;
+        }
+        if (0 == entry->fCacheID ||
+            !back->findMask(fContext, clip, entry->fDesc, bound,
+                            entry->fCacheID)) {
+            // only drawn into a scratch texture, or purged from the texture
+            // cache: the next acquireMask() gives it a texture of its own
+            entry->fCacheID = 0;
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+void GrClipMaskCache::forgetLastMask() {
+
+    if (fStack.empty()) {
+        GrAssert(false);
+        return;
+    }
+
+    GrClipStackFrame* back = (GrClipStackFrame*) fStack.back();
+
+    for (int i = 0; 0 != back->fLastCacheID && i < fMaskEntries.count();
+         ++i) {
+        if (back->fLastCacheID == fMaskEntries[i]->fCacheID) {
+            SkDELETE(fMaskEntries[i]);
+            fMaskEntries.remove(i);
+            break;
+        }
+    }
+    back->reset();
+}
+
+void GrClipMaskCache::releaseResources() {
+
+    SkDeque::F2BIter iter(fStack);
+    for (GrClipStackFrame* frame = (GrClipStackFrame*) iter.next();
+            frame != NULL;
+            frame = (GrClipStackFrame*) iter.next()) {
+        frame->reset();
+    }
+    fMaskEntries.deleteAll();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GrClipMaskCache::GrClipStackFrame::acquireMask(GrContext* context,
+                                                    const SkClipStack& clip,
+                                                    const GrTextureDesc& desc,
+                                                    const GrIRect& bound,
+                                                    uint64_t cacheID) {
+    this->reset();
+
+    if (0 == cacheID) {
+        fLastMask = context->lockScratchTexture(desc,
+                                        GrContext::kApprox_ScratchTexMatch);
+    } else {
+        GrCacheData cacheData(cacheID);
+        cacheData.fResourceDomain = GrClipMaskManager::GetAlphaMaskDomain();
+        fLastMask = context->createAndLockTexture(NULL, desc, cacheData,
+                                                  NULL, 0);
+    }
+    if (NULL == fLastMask) {
+        return;
+    }
+
+    fContext = context;
+    fLastClip = clip;
+    fLastCacheID = cacheID;
+    fLastBound = bound;
+}
+
+bool GrClipMaskCache::GrClipStackFrame::findMask(GrContext* context,
+                                                 const SkClipStack& clip,
+                                                 const GrTextureDesc& desc,
+                                                 const GrIRect& bound,
+                                                 uint64_t cacheID) {
+    if (NULL != fLastMask && cacheID == fLastCacheID) {
+        return true;
+    }
+
+    GrCacheData cacheData(cacheID);
+    cacheData.fResourceDomain = GrClipMaskManager::GetAlphaMaskDomain();
+    GrTexture* mask = context->findAndLockTexture(desc, cacheData, NULL);
+    if (NULL == mask) {
+        return false;
+    }
+
+    this->reset();
+    fContext = context;
+    fLastMask = mask;
+    fLastClip = clip;
+    fLastCacheID = cacheID;
+    fLastBound = bound;
+    return true;
+}
+
+void GrClipMaskCache::GrClipStackFrame::reset() {
+    fLastClip.reset();
+
+    if (NULL != fLastMask) {
+        fContext->unlockTexture(fLastMask);
+        fLastMask = NULL;
+    }
+    fContext = NULL;
+    fLastCacheID = 0;
+    fLastBound.setEmpty();
+}
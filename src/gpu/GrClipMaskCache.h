@@ -11,25 +11,30 @@
 #include "GrContext.h"
 #include "GrNoncopyable.h"
 #include "SkClipStack.h"
+#include "SkTDArray.h"
 
 class GrTexture;
 
 /**
  * The stencil buffer stores the last clip path - providing a single entry
- * "cache". This class provides similar functionality for AA clip paths
+ * "cache". This class provides similar functionality for AA clip paths.
+ *
+ * Each level of the stack holds the mask of its last clip. The cache also
+ * remembers the clips of the most recently rendered masks. A mask is drawn
+ * into a scratch texture the first time its clip is seen; a clip that comes
+ * back gets its mask drawn into a texture with its own key, so returning to
+ * it again can find the mask for as long as GrContext's texture cache keeps
+ * it. Both kinds are budgeted as scratch textures (see GrResourceCategory).
+ *
+ * The stencil buffer can only hold one clip, so stencil clips (the default
+ * when neither GR_AA_CLIP nor GR_SW_CLIP is defined) are still rendered
+ * again whenever the clip changes.
  */
 class GrClipMaskCache : public GrNoncopyable {
 public:
     GrClipMaskCache();
 
-    ~GrClipMaskCache() {
-
-        while (!fStack.empty()) {
-            GrClipStackFrame* temp = (GrClipStackFrame*) fStack.back();
-            temp->~GrClipStackFrame();
-            fStack.pop_back();
-        }
-    }
+    ~GrClipMaskCache();
 
     bool canReuse(const SkClipStack& clip, int width, int height) {
 
@@ -40,9 +45,9 @@ public:
 
         GrClipStackFrame* back = (GrClipStackFrame*) fStack.back();
 
-        if (back->fLastMask.texture() &&
-            back->fLastMask.texture()->width() >= width &&
-            back->fLastMask.texture()->height() >= height &&
+        if (back->fLastMask &&
+            back->fLastMask->width() >= width &&
+            back->fLastMask->height() >= height &&
             clip == back->fLastClip) {
             return true;
         }
@@ -102,7 +107,7 @@ public:
 
         GrClipStackFrame* back = (GrClipStackFrame*) fStack.back();
 
-        return back->fLastMask.texture();
+        return back->fLastMask;
     }
 
     const GrTexture* getLastMask() const {
@@ -114,9 +119,13 @@ public:
 
         GrClipStackFrame* back = (GrClipStackFrame*) fStack.back();
 
-        return back->fLastMask.texture();
+        return back->fLastMask;
     }
 
+    /**
+     * Locks a scratch texture for the mask of clip and makes it the current
+     * mask. findMask() won't find it.
+     */
     void acquireMask(const SkClipStack& clip,
                      const GrTextureDesc& desc,
                      const GrIRect& bound) {
@@ -128,9 +137,36 @@ public:
 
         GrClipStackFrame* back = (GrClipStackFrame*) fStack.back();
 
-        back->acquireMask(fContext, clip, desc, bound);
+        back->acquireMask(fContext, clip, desc, bound, 0);
     }
 
+    /**
+     * Locks a texture for the mask of clip (drawn at origin) and makes it the
+     * current mask. The first time a clip is seen the texture is a scratch
+     * texture. If the clip's mask was acquired before (and not found), the
+     * texture gets its own key so that, unless the mask isn't drawn into it
+     * after all (see forgetLastMask()), findMask() can find it again later.
+     */
+    void acquireMask(const SkClipStack& clip,
+                     const SkIPoint& origin,
+                     const GrTextureDesc& desc,
+                     const GrIRect& bound);
+
+    /**
+     * Looks for a mask acquired earlier for the same clip, origin and bound
+     * that is still in the texture cache. If there is one it becomes the
+     * current mask and true is returned.
+     */
+    bool findMask(const SkClipStack& clip,
+                  const SkIPoint& origin,
+                  const GrIRect& bound);
+
+    /**
+     * Resets the current state and makes sure findMask() won't return its
+     * mask, e.g. because drawing the mask failed.
+     */
+    void forgetLastMask();
+
     int getLastMaskWidth() const {
 
         if (fStack.empty()) {
@@ -140,11 +176,11 @@ public:
 
         GrClipStackFrame* back = (GrClipStackFrame*) fStack.back();
 
-        if (NULL == back->fLastMask.texture()) {
+        if (NULL == back->fLastMask) {
             return -1;
         }
 
-        return back->fLastMask.texture()->width();
+        return back->fLastMask->width();
     }
 
     int getLastMaskHeight() const {
@@ -156,11 +192,11 @@ public:
 
         GrClipStackFrame* back = (GrClipStackFrame*) fStack.back();
 
-        if (NULL == back->fLastMask.texture()) {
+        if (NULL == back->fLastMask) {
             return -1;
         }
 
-        return back->fLastMask.texture()->height();
+        return back->fLastMask->height();
     }
 
     void getLastBound(GrIRect* bound) const {
@@ -184,57 +220,74 @@ public:
         return fContext;
     }
 
-    void releaseResources() {
-
-        SkDeque::F2BIter iter(fStack);
-        for (GrClipStackFrame* frame = (GrClipStackFrame*) iter.next();
-                frame != NULL;
-                frame = (GrClipStackFrame*) iter.next()) {
-            frame->reset();
-        }
-    }
+    void releaseResources();
 
 protected:
 private:
     struct GrClipStackFrame {
 
-        GrClipStackFrame() {
+        GrClipStackFrame()
+            : fContext(NULL)
+            , fLastMask(NULL)
+            , fLastCacheID(0) {
             reset();
         }
 
+        ~GrClipStackFrame() {
+            reset();
+        }
+
+        // A cacheID of 0 locks a scratch texture
         void acquireMask(GrContext* context,
                          const SkClipStack& clip,
                          const GrTextureDesc& desc,
-                         const GrIRect& bound) {
-
-            fLastClip = clip;
-
-            fLastMask.set(context, desc);
+                         const GrIRect& bound,
+                         uint64_t cacheID);
 
-            fLastBound = bound;
-        }
-
-        void reset () {
-            fLastClip.reset();
+        bool findMask(GrContext* context,
+                      const SkClipStack& clip,
+                      const GrTextureDesc& desc,
+                      const GrIRect& bound,
+                      uint64_t cacheID);
 
-            GrTextureDesc desc;
-
-            fLastMask.set(NULL, desc);
-            fLastBound.setEmpty();
-        }
+        void reset();
 
         SkClipStack             fLastClip;
+        GrContext*              fContext;
         // The mask's width & height values are used in setupDrawStateAAClip to
-        // correctly scale the uvs for geometry drawn with this mask
-        GrAutoScratchTexture    fLastMask;
+        // correctly scale the uvs for geometry drawn with this mask. It is
+        // locked in the texture cache while it is the frame's mask.
+        GrTexture*              fLastMask;
+        // the key of fLastMask, or 0 if it is a scratch texture
+        uint64_t                fLastCacheID;
         // fLastBound stores the bounding box of the clip mask in canvas
         // space. The left and top fields are used to offset the uvs for
         // geometry drawn with this mask (in setupDrawStateAAClip)
         GrIRect                 fLastBound;
     };
 
+    // A mask acquired earlier, by the clip it was acquired for. fCacheID is
+    // 0 until the clip is seen again, as the mask is in a scratch texture.
+    struct MaskEntry {
+        uint32_t        fHash;
+        SkClipStack     fClip;
+        SkIPoint        fOrigin;
+        GrIRect         fBound;
+        GrTextureDesc   fDesc;
+        uint64_t        fCacheID;
+    };
+
+    enum {
+        // the number of masks findMask() can find
+        kMaxMaskEntries = 16,
+    };
+
+    static uint64_t NextCacheID();
+
     GrContext*   fContext;
     SkDeque      fStack;
+    // most recently used first
+    SkTDArray<MaskEntry*> fMaskEntries;
 
     typedef GrNoncopyable INHERITED;
 };
@@ -525,7 +525,7 @@ void GrClipMaskManager::getTemp(const GrIRect& bounds,
 }
 
 
-void GrClipMaskManager::setupCache(const SkClipStack& clipIn,
+void GrClipMaskManager::setupCache(const GrClipData& clipDataIn,
                                    const GrIRect& bounds) {
     // Since we are setting up the cache we know the last lookup was a miss
     // Free up the currently cached mask so it can be reused
@@ -537,7 +537,9 @@ void GrClipMaskManager::setupCache(const SkClipStack& clipIn,
     desc.fHeight = bounds.height();
     desc.fConfig = kAlpha_8_GrPixelConfig;
 
-    fAACache.acquireMask(clipIn, desc, bounds);
+    fAACache.acquireMask(*clipDataIn.fClipStack, clipDataIn.fOrigin,
+                         desc, bounds);
+    ++fMasksRendered;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -573,7 +575,16 @@ bool GrClipMaskManager::clipMaskPreamble(const GrClipData& clipDataIn,
         return true;
     }
 
-    this->setupCache(*clipDataIn.fClipStack, *devResultBounds);
+    // the mask may have been drawn for this clip before, e.g. when drawing
+    // alternates between clips
+    if (fAACache.findMask(*clipDataIn.fClipStack, clipDataIn.fOrigin,
+                          *devResultBounds)) {
+        *result = fAACache.getLastMask();
+        ++fMasksFound;
+        return true;
+    }
+
+    this->setupCache(clipDataIn, *devResultBounds);
     return false;
 }
 
@@ -655,7 +666,7 @@ bool GrClipMaskManager::createAlphaClipMask(const GrClipData& clipDataIn,
 
             getTemp(*devResultBounds, &temp);
             if (NULL == temp.texture()) {
-                fAACache.reset();
+                fAACache.forgetLastMask();
                 return false;
             }
 
@@ -723,6 +734,7 @@ bool GrClipMaskManager::createStencilClipMask(const GrClipData& clipDataIn,
     if (stencilBuffer->mustRenderClip(clipDataIn, rt->width(), rt->height())) {
 
         stencilBuffer->setLastClip(clipDataIn, rt->width(), rt->height());
+        ++fMasksRendered;
 
         // we set the current clip to the bounds so that our recursive
         // draws are scissored to them. We use the copy of the complex clip
@@ -1118,6 +1130,7 @@ bool GrClipMaskManager::createSoftwareClipMask(const GrClipData& clipDataIn,
     GrAssert(kNone_ClipMaskType == fCurrClipMaskType);
 
     if (this->clipMaskPreamble(clipDataIn, result, devResultBounds)) {
+        fCurrClipMaskType = kAlpha_ClipMaskType;
         return true;
     }
 
@@ -1208,7 +1221,7 @@ bool GrClipMaskManager::createSoftwareClipMask(const GrClipData& clipDataIn,
         }
     }
 
-    // Because we are using the scratch texture cache, "accum" may be
+    // Because we may be using the scratch texture cache, "accum" may be
     // larger than expected and have some cruft in the areas we aren't using.
     // Clear it out.
 
@@ -43,7 +43,9 @@ public:
 
     GrClipMaskManager()
         : fGpu(NULL)
-        , fCurrClipMaskType(kNone_ClipMaskType) {
+        , fCurrClipMaskType(kNone_ClipMaskType)
+        , fMasksRendered(0)
+        , fMasksFound(0) {
     }
 
     /**
@@ -80,6 +82,18 @@ public:
         fGpu = gpu;
     }
 
+    /**
+     * The number of clip masks rendered into the stencil buffer or an alpha
+     * texture, and of alpha masks found in the cache instead of being rendered
+     * again, since the last resetCounts().
+     */
+    int masksRendered() const { return fMasksRendered; }
+    int masksFound() const { return fMasksFound; }
+    void resetCounts() {
+        fMasksRendered = 0;
+        fMasksFound = 0;
+    }
+
 private:
     /**
      * Informs the helper function adjustStencilParams() about how the stencil
@@ -110,6 +124,9 @@ private:
 
     GrClipMaskCache fAACache;       // cache for the AA path
 
+    int fMasksRendered;
+    int fMasksFound;
+
     bool createStencilClipMask(const GrClipData& clipDataIn,
                                const GrIRect& devClipBounds);
     bool createAlphaClipMask(const GrClipData& clipDataIn,
@@ -133,7 +150,7 @@ private:
 
     void getTemp(const GrIRect& bounds, GrAutoScratchTexture* temp);
 
-    void setupCache(const SkClipStack& clip,
+    void setupCache(const GrClipData& clipDataIn,
                     const GrIRect& bounds);
 
     /**
@@ -19,9 +19,11 @@
 #include "GrInOrderDrawBuffer.h"
 #include "GrPathRenderer.h"
 #include "GrPathUtils.h"
+#include "GrPathVertexCache.h"
 #include "GrResourceCache.h"
 #include "GrSoftwarePathRenderer.h"
 #include "GrStencilBuffer.h"
+#include "GrTextBatch.h"
 #include "GrTextStrike.h"
 #include "SkTLazy.h"
 #include "SkTLS.h"
@@ -87,8 +89,13 @@ int GrContext::GetThreadInstanceCount() {
     return THREAD_INSTANCE_COUNT;
 }
 
+void GrContext::SetProgramCachePath(const char path[]) {
+    GrGpu::SetProgramCachePath(path);
+}
+
 GrContext::~GrContext() {
     this->flush();
+    delete fTextBatch;
 
     // Since the gpu can hold scratch textures, give it a chance to let go
     // of them before freeing the texture cache
@@ -105,6 +112,7 @@ GrContext::~GrContext() {
     fGpu->unref();
     GrSafeUnref(fPathRendererChain);
     GrSafeUnref(fSoftwarePathRenderer);
+    delete fPathVertexCache;
     fDrawState->unref();
 
     --THREAD_INSTANCE_COUNT;
@@ -125,6 +133,8 @@ void GrContext::contextDestroyed() {
     GrSafeSetNull(fPathRendererChain);
     GrSafeSetNull(fSoftwarePathRenderer);
 
+    fTextBatch->discard();
+
     delete fDrawBuffer;
     fDrawBuffer = NULL;
 
@@ -154,6 +164,7 @@ void GrContext::freeGpuResources() {
 
     fTextureCache->purgeAllUnlocked();
     fFontCache->freeAll();
+    fPathVertexCache->purgeAll();
     // a path renderer may be holding onto resources
     GrSafeSetNull(fPathRendererChain);
     GrSafeSetNull(fSoftwarePathRenderer);
@@ -163,6 +174,63 @@ size_t GrContext::getGpuTextureCacheBytes() const {
   return fTextureCache->getCachedResourceBytes();
 }
 
+void GrContext::getDrawStats(DrawStats* stats) const {
+    GrAssert(NULL != stats);
+    stats->fRecordedDraws = 0;
+    stats->fMergedDraws = 0;
+    stats->fStateChanges = 0;
+    if (NULL != fDrawBuffer) {
+        stats->fRecordedDraws = fDrawBuffer->drawCount();
+        stats->fMergedDraws = fDrawBuffer->mergedDrawCount();
+        stats->fStateChanges = fDrawBuffer->stateChangeCount();
+    }
+    stats->fIssuedDraws = fGpu->drawCount();
+    stats->fClipMasksRendered = fGpu->clipMasksRendered();
+    stats->fClipMasksFound = fGpu->clipMasksFound();
+    stats->fPathMasksRendered = 0;
+    stats->fPathMasksFound = 0;
+    if (NULL != fSoftwarePathRenderer) {
+        stats->fPathMasksRendered = fSoftwarePathRenderer->masksRendered();
+        stats->fPathMasksFound = fSoftwarePathRenderer->masksFound();
+    }
+    stats->fGeometryBytesUploaded = 0;
+    stats->fGeometryBuffersCreated = 0;
+    stats->fGeometryBufferLocks = 0;
+    const GrBufferAllocPool* pools[] = {
+        fDrawBufferVBAllocPool, fDrawBufferIBAllocPool
+    };
+    for (size_t i = 0; i < GR_ARRAY_COUNT(pools); ++i) {
+        if (NULL != pools[i]) {
+            stats->fGeometryBytesUploaded += pools[i]->bytesUploaded();
+            stats->fGeometryBuffersCreated += pools[i]->buffersCreated();
+            stats->fGeometryBufferLocks += pools[i]->lockCount();
+        }
+    }
+    fGpu->addGeometryPoolCounts(&stats->fGeometryBytesUploaded,
+                                &stats->fGeometryBuffersCreated,
+                                &stats->fGeometryBufferLocks);
+}
+
+bool GrContext::flushProgramCache() {
+    return fGpu->flushProgramCache();
+}
+
+void GrContext::resetDrawStats() {
+    if (NULL != fDrawBuffer) {
+        fDrawBuffer->resetCounts();
+    }
+    fGpu->resetDrawCount();
+    if (NULL != fSoftwarePathRenderer) {
+        fSoftwarePathRenderer->resetCounts();
+    }
+    if (NULL != fDrawBufferVBAllocPool) {
+        fDrawBufferVBAllocPool->resetCounts();
+    }
+    if (NULL != fDrawBufferIBAllocPool) {
+        fDrawBufferIBAllocPool->resetCounts();
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace {
@@ -528,6 +596,69 @@ void GrContext::getTextureCacheLimits(int* maxTextures,
 
 void GrContext::setTextureCacheLimits(int maxTextures, size_t maxTextureBytes) {
     fTextureCache->setLimits(maxTextures, maxTextureBytes);
+    if (fDefaultScratchLimits) {
+        fTextureCache->setCategoryLimits(kScratchTexture_GrResourceCategory,
+                                         maxTextures, maxTextureBytes / 2);
+    }
+}
+
+void GrContext::getResourceCacheCategoryLimits(GrResourceCategory category,
+                                               int* maxResources,
+                                               size_t* maxResourceBytes) const {
+    fTextureCache->getCategoryLimits(category, maxResources, maxResourceBytes);
+}
+
+void GrContext::setResourceCacheCategoryLimits(GrResourceCategory category,
+                                               int maxResources,
+                                               size_t maxResourceBytes) {
+    if (kScratchTexture_GrResourceCategory == category) {
+        fDefaultScratchLimits = false;
+    }
+    fTextureCache->setCategoryLimits(category, maxResources, maxResourceBytes);
+}
+
+size_t GrContext::getPathVertexCacheLimit() const {
+    return fPathVertexCache->getMaxBytes();
+}
+
+void GrContext::setPathVertexCacheLimit(size_t maxBytes) {
+    fPathVertexCache->setMaxBytes(maxBytes);
+}
+
+bool GrContext::getGeometryRingBuffers() const {
+    return fGpu->geometryRingBuffers();
+}
+
+void GrContext::setGeometryRingBuffers(bool ringBuffers) {
+    // the pools can only change mode while nothing is reserved from them
+    this->flush();
+    fGpu->setGeometryRingBuffers(ringBuffers);
+    if (NULL != fDrawBufferVBAllocPool) {
+        fDrawBufferVBAllocPool->setRingMode(ringBuffers);
+    }
+    if (NULL != fDrawBufferIBAllocPool) {
+        fDrawBufferIBAllocPool->setRingMode(ringBuffers);
+    }
+}
+
+void GrContext::getPathVertexCacheStats(ResourceCacheStats* stats) const {
+    const GrPathVertexCache::Stats& cacheStats = fPathVertexCache->stats();
+    stats->fCount = cacheStats.fCount;
+    stats->fBytes = cacheStats.fBytes;
+    stats->fHits = cacheStats.fHits;
+    stats->fMisses = cacheStats.fMisses;
+    stats->fPurges = cacheStats.fPurges;
+}
+
+void GrContext::getResourceCacheStats(GrResourceCategory category,
+                                      ResourceCacheStats* stats) const {
+    const GrResourceCache::CategoryStats& cacheStats =
+        fTextureCache->getCategoryStats(category);
+    stats->fCount = cacheStats.fCount;
+    stats->fBytes = cacheStats.fBytes;
+    stats->fHits = cacheStats.fHits;
+    stats->fMisses = cacheStats.fMisses;
+    stats->fPurges = cacheStats.fPurges;
 }
 
 int GrContext::getMaxTextureSize() const {
@@ -1123,11 +1254,10 @@ void GrContext::drawPath(const GrPaint& paint, const SkPath& path,
 void GrContext::internalDrawPath(const GrPaint& paint, const SkPath& path,
                                  GrPathFill fill, const GrPoint* translate) {
 
-    // Note that below we may sw-rasterize the path into a scratch texture.
-    // Scratch textures can be recycled after they are returned to the texture
-    // cache. This presents a potential hazard for buffered drawing. However,
-    // the writePixels that uploads to the scratch will perform a flush so we're
-    // OK.
+    // Note that below we may sw-rasterize the path into a texture. The
+    // software path renderer keeps the texture out of the texture cache
+    // until the buffered draw is done with it, and rasterizes and uploads
+    // the masks of buffered draws when the draw buffer is flushed.
     GrDrawTarget* target = this->prepareToDraw(&paint, DEFAULT_BUFFERING);
     GrDrawState::AutoStageDisable atr(fDrawState);
 
@@ -1159,8 +1289,14 @@ void GrContext::internalDrawPath(const GrPaint& paint, const SkPath& path,
 
 void GrContext::flush(int flagsBitfield) {
     if (kDiscard_FlushBit & flagsBitfield) {
+        fTextBatch->discard();
+        // later draws can still find the masks of the discarded ones
+        if (NULL != fSoftwarePathRenderer) {
+            fSoftwarePathRenderer->prepareMasks();
+        }
         fDrawBuffer->reset();
     } else {
+        fTextBatch->flush();
         this->flushDrawBuffer();
     }
     if (kForceCurrentRenderTarget_FlushBit & flagsBitfield) {
@@ -1178,6 +1314,9 @@ void GrContext::flushDrawBuffer() {
         GrInOrderDrawBuffer* temp = fDrawBuffer;
         fDrawBuffer = NULL;
 
+        if (NULL != fSoftwarePathRenderer) {
+            fSoftwarePathRenderer->prepareMasks();
+        }
         temp->flushTo(fGpu);
 
         fDrawBuffer = temp;
@@ -1645,6 +1784,12 @@ void GrContext::setPaint(const GrPaint& paint) {
 }
 
 GrDrawTarget* GrContext::prepareToDraw(const GrPaint* paint, BufferedDraw buffered) {
+    fTextBatch->flush();
+    return this->internalPrepareToDraw(paint, buffered);
+}
+
+GrDrawTarget* GrContext::internalPrepareToDraw(const GrPaint* paint,
+                                               BufferedDraw buffered) {
     if (kNo_BufferedDraw == buffered && kYes_BufferedDraw == fLastDrawWasBuffered) {
         this->flushDrawBuffer();
         fLastDrawWasBuffered = kNo_BufferedDraw;
@@ -1662,6 +1807,10 @@ GrDrawTarget* GrContext::prepareToDraw(const GrPaint* paint, BufferedDraw buffer
     }
 }
 
+bool GrContext::isBuffered(const GrDrawTarget* target) const {
+    return NULL != fDrawBuffer && target == fDrawBuffer;
+}
+
 /*
  * This method finds a path renderer that can draw the specified path on
  * the provided target.
@@ -1751,7 +1900,12 @@ GrContext::GrContext(GrGpu* gpu) {
     fTextureCache = SkNEW_ARGS(GrResourceCache,
                                (MAX_TEXTURE_CACHE_COUNT,
                                 MAX_TEXTURE_CACHE_BYTES));
+    fDefaultScratchLimits = true;
+    this->setTextureCacheLimits(MAX_TEXTURE_CACHE_COUNT,
+                                MAX_TEXTURE_CACHE_BYTES);
     fFontCache = SkNEW_ARGS(GrFontCache, (fGpu));
+    fPathVertexCache = SkNEW(GrPathVertexCache);
+    fTextBatch = SkNEW_ARGS(GrTextBatch, (this));
 
     fLastDrawWasBuffered = kNo_BufferedDraw;
 
@@ -1780,6 +1934,8 @@ void GrContext::setupDrawBuffer() {
         SkNEW_ARGS(GrIndexBufferAllocPool, (fGpu, false,
                                    DRAW_BUFFER_IBPOOL_BUFFER_SIZE,
                                    DRAW_BUFFER_IBPOOL_PREALLOC_BUFFERS));
+    fDrawBufferVBAllocPool->setRingMode(fGpu->geometryRingBuffers());
+    fDrawBufferIBAllocPool->setRingMode(fGpu->geometryRingBuffers());
 
     fDrawBuffer = SkNEW_ARGS(GrInOrderDrawBuffer, (fGpu,
                                           fDrawBufferVBAllocPool,
@@ -1793,7 +1949,7 @@ void GrContext::setupDrawBuffer() {
 }
 
 GrDrawTarget* GrContext::getTextTarget(const GrPaint& paint) {
-    return prepareToDraw(&paint, DEFAULT_BUFFERING);
+    return this->internalPrepareToDraw(&paint, DEFAULT_BUFFERING);
 }
 
 const GrIndexBuffer* GrContext::getQuadIndexBuffer() const {
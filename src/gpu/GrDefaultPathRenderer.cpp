@@ -16,9 +16,11 @@
 
 
 GrDefaultPathRenderer::GrDefaultPathRenderer(bool separateStencilSupport,
-                                             bool stencilWrapOpsSupport)
+                                             bool stencilWrapOpsSupport,
+                                             GrPathVertexCache* vertexCache)
     : fSeparateStencil(separateStencilSupport)
-    , fStencilWrapOps(stencilWrapOpsSupport) {
+    , fStencilWrapOps(stencilWrapOpsSupport)
+    , fVertexCache(vertexCache) {
 }
 
 
@@ -181,10 +183,20 @@ static inline void append_countour_edge_indices(GrPathFill fillType,
     *((*indices)++) = edgeV0Idx + 1;
 }
 
+static void translate_points(GrPoint* pts, int count, const GrVec* translate) {
+    if (NULL != translate &&
+        (translate->fX || translate->fY)) {
+        for (int i = 0; i < count; i++) {
+            pts[i].offset(translate->fX, translate->fY);
+        }
+    }
+}
+
 bool GrDefaultPathRenderer::createGeom(const SkPath& path,
                                        GrPathFill fill,
                                        const GrVec* translate,
                                        GrScalar srcSpaceTol,
+                                       const GrPathVertexCache::Key* cacheKey,
                                        GrDrawTarget* target,
                                        GrPrimitiveType* primType,
                                        int* vertexCnt,
@@ -193,6 +205,28 @@ bool GrDefaultPathRenderer::createGeom(const SkPath& path,
     {
     SK_TRACE_EVENT0("GrDefaultPathRenderer::createGeom");
 
+    if (NULL != cacheKey) {
+        const GrPathVertexCache::Geometry* geom =
+            fVertexCache->find(path, *cacheKey);
+        if (NULL != geom) {
+            if (!arg->set(target, 0, geom->fVertexCount, geom->fIndexCount)) {
+                return false;
+            }
+            memcpy(arg->vertices(), geom->vertices(),
+                   geom->fVertexCount * sizeof(GrPoint));
+            if (geom->fIndexCount) {
+                memcpy(arg->indices(), geom->indices(),
+                       geom->fIndexCount * sizeof(uint16_t));
+            }
+            *primType = geom->fPrimitiveType;
+            *vertexCnt = geom->fVertexCount;
+            *indexCnt = geom->fIndexCount;
+            translate_points(reinterpret_cast<GrPoint*>(arg->vertices()),
+                             *vertexCnt, translate);
+            return true;
+        }
+    }
+
     GrScalar srcSpaceTolSqd = GrMul(srcSpaceTol, srcSpaceTol);
     int contourCnt;
     int maxPts = GrPathUtils::worstCasePointCount(path, &contourCnt,
@@ -312,13 +346,14 @@ FINISHED:
     *vertexCnt = vert - base;
     *indexCnt = idx - idxBase;
 
-    if (NULL != translate &&
-        (translate->fX || translate->fY)) {
-        int count = vert - base;
-        for (int i = 0; i < count; i++) {
-            base[i].offset(translate->fX, translate->fY);
-        }
+    if (NULL != cacheKey) {
+        GrVec origin = { 0, 0 };
+        fVertexCache->add(path, *cacheKey, *primType,
+                          base, sizeof(GrPoint), *vertexCnt,
+                          idxBase, *indexCnt, origin);
     }
+
+    translate_points(base, *vertexCnt, translate);
     }
     return true;
 }
@@ -331,7 +366,34 @@ bool GrDefaultPathRenderer::internalDrawPath(const SkPath& path,
 
     GrMatrix viewM = target->getDrawState().getViewMatrix();
     GrScalar tol = GR_Scalar1;
-    tol = GrPathUtils::scaleToleranceToSrc(tol, viewM, path.getBounds());
+
+    // Subdividing curves is the expensive part; paths made of lines aren't
+    // worth keeping.
+    GrPathVertexCache::Key key;
+    GrPathVertexCache::Key* cacheKey = NULL;
+    if (NULL != fVertexCache && !viewM.hasPerspective() &&
+        (path.getSegmentMasks() & (SkPath::kQuad_SegmentMask |
+                                   SkPath::kCubic_SegmentMask))) {
+        GrScalar stretch = viewM.getMaxStretch();
+        if (stretch > 0) {
+            // Round the scale up to the next quarter octave and tessellate
+            // for that, so the vertices are fine enough to be reused while
+            // the scale stays within it.
+            float scaleClass = sk_float_ceil(4 * sk_float_log(stretch) /
+                                             sk_float_log(2));
+            tol = GrScalarDiv(tol, sk_float_pow(2, scaleClass / 4));
+
+            memset(&key, 0, sizeof(key));
+            key.fTag = (kHairLine_GrPathFill == fill) ?
+                            SkSetFourByteTag('d', 'f', 'h', 'l') :
+                            SkSetFourByteTag('d', 'f', 'l', 't');
+            key.fMatrix[0] = scaleClass;
+            cacheKey = &key;
+        }
+    }
+    if (NULL == cacheKey) {
+        tol = GrPathUtils::scaleToleranceToSrc(tol, viewM, path.getBounds());
+    }
 
     int vertexCnt;
     int indexCnt;
@@ -341,6 +403,7 @@ bool GrDefaultPathRenderer::internalDrawPath(const SkPath& path,
                           fill,
                           translate,
                           tol,
+                          cacheKey,
                           target,
                           &primType,
                           &vertexCnt,
@@ -9,6 +9,7 @@
 #define GrDefaultPathRenderer_DEFINED
 
 #include "GrPathRenderer.h"
+#include "GrPathVertexCache.h"
 #include "SkTemplates.h"
 
 /**
@@ -17,8 +18,14 @@
  */
 class GR_API GrDefaultPathRenderer : public GrPathRenderer {
 public:
+    /**
+     *  If vertexCache isn't NULL, the vertices generated for paths with curves
+     *  are kept in it and reused for as long as the path is drawn at a similar
+     *  scale. The cache must outlive the renderer.
+     */
     GrDefaultPathRenderer(bool separateStencilSupport,
-                          bool stencilWrapOpsSupport);
+                          bool stencilWrapOpsSupport,
+                          GrPathVertexCache* vertexCache = NULL);
 
 
     virtual bool requiresStencilPass(const SkPath& path,
@@ -52,14 +59,16 @@ private:
                     GrPathFill fill,
                     const GrVec* translate,
                     GrScalar srcSpaceTol,
+                    const GrPathVertexCache::Key* cacheKey,
                     GrDrawTarget* target,
                     GrPrimitiveType* primType,
                     int* vertexCnt,
                     int* indexCnt,
                     GrDrawTarget::AutoReleaseGeometry* arg);
 
-    bool    fSeparateStencil;
-    bool    fStencilWrapOps;
+    bool                fSeparateStencil;
+    bool                fStencilWrapOps;
+    GrPathVertexCache*  fVertexCache;
 
     typedef GrPathRenderer INHERITED;
 };
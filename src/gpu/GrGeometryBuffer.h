@@ -71,6 +71,21 @@ public:
      */
     virtual bool updateData(const void* src, size_t srcSizeInBytes) = 0;
 
+    /**
+     * Updates part of the buffer data.
+     *
+     * The src data is placed at offset. The contents of the buffer before
+     * offset are preserved and any contents after the src data will be
+     * undefined. After updateData() the buffer may not be able to take data
+     * past the end of that update at a non-zero offset, in which case this
+     * fails. An update at offset 0 always fits.
+     *
+     * @return returns true if the update succeeds, false otherwise.
+     */
+    virtual bool updateSubData(const void* src,
+                               size_t srcSizeInBytes,
+                               size_t offset) = 0;
+
     // GrResource overrides
     virtual size_t sizeInBytes() const { return fSizeInBytes; }
 
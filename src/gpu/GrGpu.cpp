@@ -14,6 +14,8 @@
 #include "GrIndexBuffer.h"
 #include "GrStencilBuffer.h"
 #include "GrVertexBuffer.h"
+#include "SkString.h"
+#include "SkThread.h"
 
 // probably makes no sense for this to be less than a page
 static const size_t VERTEX_POOL_VB_SIZE = 1 << 18;
@@ -35,9 +37,11 @@ GrGpu::GrGpu()
     , fIndexPool(NULL)
     , fVertexPoolUseCnt(0)
     , fIndexPoolUseCnt(0)
+    , fGeometryRingBuffers(false)
     , fQuadIndexBuffer(NULL)
     , fUnitSquareVertexBuffer(NULL)
     , fContextIsDirty(true)
+    , fDrawCount(0)
     , fResourceHead(NULL) {
 
     fClipMaskManager.setGpu(this);
@@ -60,6 +64,26 @@ GrGpu::GrGpu()
     };
 }
 
+SK_DECLARE_STATIC_MUTEX(gProgramCachePathMutex);
+static SkString* gProgramCachePath;
+
+void GrGpu::SetProgramCachePath(const char path[]) {
+    SkAutoMutexAcquire lock(gProgramCachePathMutex);
+    if (NULL == gProgramCachePath) {
+        gProgramCachePath = SkNEW(SkString);
+    }
+    gProgramCachePath->set(path);
+}
+
+void GrGpu::GetProgramCachePath(SkString* path) {
+    SkAutoMutexAcquire lock(gProgramCachePathMutex);
+    if (NULL != gProgramCachePath) {
+        *path = *gProgramCachePath;
+    } else {
+        path->reset();
+    }
+}
+
 GrGpu::~GrGpu() {
     this->releaseResources();
 }
@@ -102,6 +126,41 @@ void GrGpu::releaseResources() {
     fIndexPool = NULL;
 }
 
+void GrGpu::resetDrawCount() {
+    fDrawCount = 0;
+    fClipMaskManager.resetCounts();
+    if (NULL != fVertexPool) {
+        fVertexPool->resetCounts();
+    }
+    if (NULL != fIndexPool) {
+        fIndexPool->resetCounts();
+    }
+}
+
+void GrGpu::addGeometryPoolCounts(int* bytesUploaded,
+                                  int* buffersCreated,
+                                  int* lockCount) const {
+    const GrBufferAllocPool* pools[] = { fVertexPool, fIndexPool };
+    for (size_t i = 0; i < GR_ARRAY_COUNT(pools); ++i) {
+        if (NULL != pools[i]) {
+            *bytesUploaded += pools[i]->bytesUploaded();
+            *buffersCreated += pools[i]->buffersCreated();
+            *lockCount += pools[i]->lockCount();
+        }
+    }
+}
+
+void GrGpu::setGeometryRingBuffers(bool ringBuffers) {
+    GrAssert(0 == fVertexPoolUseCnt && 0 == fIndexPoolUseCnt);
+    fGeometryRingBuffers = ringBuffers;
+    if (NULL != fVertexPool) {
+        fVertexPool->setRingMode(ringBuffers);
+    }
+    if (NULL != fIndexPool) {
+        fIndexPool->setRingMode(ringBuffers);
+    }
+}
+
 void GrGpu::insertResource(GrResource* resource) {
     GrAssert(NULL != resource);
     GrAssert(this == resource->getGpu());
@@ -418,6 +477,7 @@ void GrGpu::onDrawIndexed(GrPrimitiveType type,
 
     this->onGpuDrawIndexed(type, sVertex, sIndex,
                            vertexCount, indexCount);
+    ++fDrawCount;
 }
 
 void GrGpu::onDrawNonIndexed(GrPrimitiveType type,
@@ -433,6 +493,7 @@ void GrGpu::onDrawNonIndexed(GrPrimitiveType type,
     setupGeometry(&sVertex, NULL, vertexCount, 0);
 
     this->onGpuDrawNonIndexed(type, sVertex, vertexCount);
+    ++fDrawCount;
 }
 
 void GrGpu::onStencilPath(const GrPath* path, GrPathFill fill) {
@@ -466,6 +527,7 @@ void GrGpu::prepareVertexPool() {
                                                   VERTEX_POOL_VB_SIZE,
                                                   VERTEX_POOL_VB_COUNT));
         fVertexPool->releaseGpuRef();
+        fVertexPool->setRingMode(fGeometryRingBuffers);
     } else if (!fVertexPoolUseCnt) {
         // the client doesn't have valid data in the pool
         fVertexPool->reset();
@@ -479,6 +541,7 @@ void GrGpu::prepareIndexPool() {
                                                 INDEX_POOL_IB_SIZE,
                                                 INDEX_POOL_IB_COUNT));
         fIndexPool->releaseGpuRef();
+        fIndexPool->setRingMode(fGeometryRingBuffers);
     } else if (!fIndexPoolUseCnt) {
         // the client doesn't have valid data in the pool
         fIndexPool->reset();
@@ -23,6 +23,7 @@ class GrPathRendererChain;
 class GrResource;
 class GrStencilBuffer;
 class GrVertexBufferAllocPool;
+class SkString;
 
 class GrGpu : public GrDrawTarget {
 
@@ -50,6 +51,14 @@ public:
      */
     static GrGpu* Create(GrEngine, GrPlatform3DContext context3D);
 
+    /**
+     * The file in which GrGpus created afterwards keep the shader programs
+     * they build, if the backend supports that (see GrContext). Empty if
+     * there is none.
+     */
+    static void SetProgramCachePath(const char path[]);
+    static void GetProgramCachePath(SkString* path);
+
     ////////////////////////////////////////////////////////////////////////////
 
     GrGpu();
@@ -72,6 +81,37 @@ public:
      */
     void markContextDirty() { fContextIsDirty = true; }
 
+    /**
+     * The number of draws issued to the 3D API since the last call to
+     * resetDrawCount().
+     */
+    int drawCount() const { return fDrawCount; }
+    void resetDrawCount();
+
+    /**
+     * The number of clip masks rendered, and of alpha clip masks reused from
+     * the cache, since the last call to resetDrawCount().
+     */
+    int clipMasksRendered() const { return fClipMaskManager.masksRendered(); }
+    int clipMasksFound() const { return fClipMaskManager.masksFound(); }
+
+    /**
+     * Adds the bytes uploaded, buffers created and buffer locks of the pools
+     * holding the geometry of draws made straight to the 3D API since the
+     * last call to resetDrawCount().
+     */
+    void addGeometryPoolCounts(int* bytesUploaded,
+                               int* buffersCreated,
+                               int* lockCount) const;
+
+    /**
+     * Whether geometry pools run in ring mode (see GrBufferAllocPool). This
+     * applies to the pools of this object, and GrContext follows it for the
+     * pools of its draw buffer. Only change it while no geometry is reserved.
+     */
+    bool geometryRingBuffers() const { return fGeometryRingBuffers; }
+    void setGeometryRingBuffers(bool ringBuffers);
+
     void unimpl(const char[]);
 
     /**
@@ -259,6 +299,12 @@ public:
      */
     virtual void abandonResources();
 
+    /**
+     * Writes the shader programs built so far to the program cache file.
+     * Returns false if there is none, or writing failed.
+     */
+    virtual bool flushProgramCache() { return false; }
+
     /**
      * Called to tell Gpu object to release all GrResources. Overrides must call
      * INHERITED::releaseResources().
@@ -539,6 +585,7 @@ private:
     // counts number of uses of vertex/index pool in the geometry stack
     int                         fVertexPoolUseCnt;
     int                         fIndexPoolUseCnt;
+    bool                        fGeometryRingBuffers;
 
     enum {
         kPreallocGeomPoolStateStackCnt = 4,
@@ -554,6 +601,8 @@ private:
 
     bool                        fContextIsDirty;
 
+    int                         fDrawCount;
+
     GrResource*                 fResourceHead;
 
     // Given a rt, find or create a stencil buffer and attach it
@@ -23,7 +23,6 @@ GrInOrderDrawBuffer::GrInOrderDrawBuffer(const GrGpu* gpu,
     , fClipSet(true)
     , fVertexPool(*vertexPool)
     , fIndexPool(*indexPool)
-    , fLastRectVertexLayout(0)
     , fQuadIndexBuffer(NULL)
     , fMaxQuads(0)
     , fFlushing(false) {
@@ -42,6 +41,7 @@ GrInOrderDrawBuffer::GrInOrderDrawBuffer(const GrGpu* gpu,
     poolState.fPoolIndexBuffer = (GrIndexBuffer*)~0;
     poolState.fPoolStartIndex = ~0;
 #endif
+    this->resetCounts();
     this->reset();
 }
 
@@ -59,7 +59,6 @@ void GrInOrderDrawBuffer::setQuadIndexBuffer(const GrIndexBuffer* indexBuffer) {
         GrSafeUnref(fQuadIndexBuffer);
         fQuadIndexBuffer = indexBuffer;
         GrSafeRef(fQuadIndexBuffer);
-        fCurrQuad = 0;
         fMaxQuads = (NULL == indexBuffer) ? 0 : indexBuffer->maxQuads();
     } else {
         GrAssert((NULL == indexBuffer && 0 == fMaxQuads) ||
@@ -70,7 +69,6 @@ void GrInOrderDrawBuffer::setQuadIndexBuffer(const GrIndexBuffer* indexBuffer) {
 ////////////////////////////////////////////////////////////////////////////////
 
 void GrInOrderDrawBuffer::resetDrawTracking() {
-    fCurrQuad = 0;
     fInstancedDrawTracker.reset();
 }
 
@@ -79,17 +77,14 @@ void GrInOrderDrawBuffer::drawRect(const GrRect& rect,
                                    const GrRect* srcRects[],
                                    const GrMatrix* srcMatrices[]) {
 
-    GrAssert(!(NULL == fQuadIndexBuffer && fCurrQuad));
-    GrAssert(!(fDraws.empty() && fCurrQuad));
     GrAssert(!(0 != fMaxQuads && NULL == fQuadIndexBuffer));
 
     GrDrawState* drawState = this->drawState();
 
-    // if we have a quad IB then either append to the previous run of
-    // rects or start a new run
+    // if we have a quad IB then draw the rect as a quad in device space,
+    // which lets onDrawIndexed append it to the previous run of rects.
     if (fMaxQuads) {
 
-        bool appendToPreviousDraw = false;
         GrVertexLayout layout = GetRectVertexLayout(srcRects);
         AutoReleaseGeometry geo(this, layout, 4, 0);
         if (!geo.succeeded()) {
@@ -171,49 +166,11 @@ void GrInOrderDrawBuffer::drawRect(const GrRect& rect,
             }
         }
 
-        if (!this->needsNewClip() &&
-            !this->needsNewState() &&
-            fCurrQuad > 0 &&
-            fCurrQuad < fMaxQuads &&
-            layout == fLastRectVertexLayout) {
-
-            int vsize = VertexSize(layout);
-
-            Draw& lastDraw = fDraws.back();
-
-            GrAssert(lastDraw.fIndexBuffer == fQuadIndexBuffer);
-            GrAssert(kTriangles_GrPrimitiveType == lastDraw.fPrimitiveType);
-            GrAssert(0 == lastDraw.fVertexCount % 4);
-            GrAssert(0 == lastDraw.fIndexCount % 6);
-            GrAssert(0 == lastDraw.fStartIndex);
-
-            GeometryPoolState& poolState = fGeoPoolStateStack.back();
-
-            appendToPreviousDraw =
-                kDraw_Cmd != fCmds.back() &&
-                lastDraw.fVertexBuffer == poolState.fPoolVertexBuffer &&
-                (fCurrQuad * 4 + lastDraw.fStartVertex) == poolState.fPoolStartVertex;
-
-            if (appendToPreviousDraw) {
-                lastDraw.fVertexCount += 4;
-                lastDraw.fIndexCount += 6;
-                fCurrQuad += 1;
-                // we reserved above, so we should be the first
-                // use of this vertex reservation.
-                GrAssert(0 == poolState.fUsedPoolVertexBytes);
-                poolState.fUsedPoolVertexBytes = 4 * vsize;
-            }
-        }
-        if (!appendToPreviousDraw) {
-            this->setIndexSourceToBuffer(fQuadIndexBuffer);
-            this->drawIndexed(kTriangles_GrPrimitiveType, 0, 0, 4, 6);
-            fCurrQuad = 1;
-            fLastRectVertexLayout = layout;
-        }
+        this->setIndexSourceToBuffer(fQuadIndexBuffer);
+        this->drawIndexed(kTriangles_GrPrimitiveType, 0, 0, 4, 6);
         if (disabledClip) {
             drawState->enableState(GrDrawState::kClip_StateBit);
         }
-        fInstancedDrawTracker.reset();
     } else {
         INHERITED::drawRect(rect, matrix, srcRects, srcMatrices);
     }
@@ -240,6 +197,7 @@ void GrInOrderDrawBuffer::drawIndexedInstances(GrPrimitiveType type,
         if (this->needsNewState()) {
             this->recordState();
         }
+        ++fDrawCount;
 
         Draw* draw = NULL;
         // if the last draw used the same indices/vertices per shape then we
@@ -273,6 +231,7 @@ void GrInOrderDrawBuffer::drawIndexedInstances(GrPrimitiveType type,
             draw->fVertexCount = 0;
             draw->fVertexLayout = geomSrc.fVertexLayout;
         } else {
+            ++fMergedDrawCount;
             GrAssert(!(draw->fIndexCount % indicesPerInstance));
             GrAssert(!(draw->fVertexCount % verticesPerInstance));
             GrAssert(poolState.fPoolStartVertex == draw->fStartVertex +
@@ -323,7 +282,6 @@ void GrInOrderDrawBuffer::drawIndexedInstances(GrPrimitiveType type,
         }
 
         // update draw tracking for next draw
-        fCurrQuad = 0;
         fInstancedDrawTracker.fVerticesPerInstance = verticesPerInstance;
         fInstancedDrawTracker.fIndicesPerInstance = indicesPerInstance;
     } else {
@@ -356,51 +314,55 @@ void GrInOrderDrawBuffer::onDrawIndexed(GrPrimitiveType primitiveType,
         this->recordState();
     }
 
-    Draw* draw = this->recordDraw();
-
-    draw->fPrimitiveType = primitiveType;
-    draw->fStartVertex   = startVertex;
-    draw->fStartIndex    = startIndex;
-    draw->fVertexCount   = vertexCount;
-    draw->fIndexCount    = indexCount;
+    Draw draw;
+    draw.fPrimitiveType = primitiveType;
+    draw.fStartVertex   = startVertex;
+    draw.fStartIndex    = startIndex;
+    draw.fVertexCount   = vertexCount;
+    draw.fIndexCount    = indexCount;
 
-    draw->fVertexLayout = this->getVertexLayout();
+    draw.fVertexLayout = this->getVertexLayout();
     switch (this->getGeomSrc().fVertexSrc) {
     case kBuffer_GeometrySrcType:
-        draw->fVertexBuffer = this->getGeomSrc().fVertexBuffer;
+        draw.fVertexBuffer = this->getGeomSrc().fVertexBuffer;
         break;
     case kReserved_GeometrySrcType: // fallthrough
     case kArray_GeometrySrcType: {
         size_t vertexBytes = (vertexCount + startVertex) *
-                             VertexSize(draw->fVertexLayout);
+                             VertexSize(draw.fVertexLayout);
         poolState.fUsedPoolVertexBytes =
                             GrMax(poolState.fUsedPoolVertexBytes, vertexBytes);
-        draw->fVertexBuffer = poolState.fPoolVertexBuffer;
-        draw->fStartVertex += poolState.fPoolStartVertex;
+        draw.fVertexBuffer = poolState.fPoolVertexBuffer;
+        draw.fStartVertex += poolState.fPoolStartVertex;
         break;
     }
     default:
         GrCrash("unknown geom src type");
     }
-    draw->fVertexBuffer->ref();
 
     switch (this->getGeomSrc().fIndexSrc) {
     case kBuffer_GeometrySrcType:
-        draw->fIndexBuffer = this->getGeomSrc().fIndexBuffer;
+        draw.fIndexBuffer = this->getGeomSrc().fIndexBuffer;
         break;
     case kReserved_GeometrySrcType: // fallthrough
     case kArray_GeometrySrcType: {
         size_t indexBytes = (indexCount + startIndex) * sizeof(uint16_t);
         poolState.fUsedPoolIndexBytes =
                             GrMax(poolState.fUsedPoolIndexBytes, indexBytes);
-        draw->fIndexBuffer = poolState.fPoolIndexBuffer;
-        draw->fStartIndex += poolState.fPoolStartIndex;
+        draw.fIndexBuffer = poolState.fPoolIndexBuffer;
+        draw.fStartIndex += poolState.fPoolStartIndex;
         break;
     }
     default:
         GrCrash("unknown geom src type");
     }
-    draw->fIndexBuffer->ref();
+
+    ++fDrawCount;
+    if (!this->appendToLastDraw(draw)) {
+        *this->recordDraw() = draw;
+        draw.fVertexBuffer->ref();
+        draw.fIndexBuffer->ref();
+    }
 }
 
 void GrInOrderDrawBuffer::onDrawNonIndexed(GrPrimitiveType primitiveType,
@@ -420,33 +382,97 @@ void GrInOrderDrawBuffer::onDrawNonIndexed(GrPrimitiveType primitiveType,
         this->recordState();
     }
 
-    Draw* draw = this->recordDraw();
-    draw->fPrimitiveType = primitiveType;
-    draw->fStartVertex   = startVertex;
-    draw->fStartIndex    = 0;
-    draw->fVertexCount   = vertexCount;
-    draw->fIndexCount    = 0;
+    Draw draw;
+    draw.fPrimitiveType = primitiveType;
+    draw.fStartVertex   = startVertex;
+    draw.fStartIndex    = 0;
+    draw.fVertexCount   = vertexCount;
+    draw.fIndexCount    = 0;
 
-    draw->fVertexLayout = this->getVertexLayout();
+    draw.fVertexLayout = this->getVertexLayout();
     switch (this->getGeomSrc().fVertexSrc) {
     case kBuffer_GeometrySrcType:
-        draw->fVertexBuffer = this->getGeomSrc().fVertexBuffer;
+        draw.fVertexBuffer = this->getGeomSrc().fVertexBuffer;
         break;
     case kReserved_GeometrySrcType: // fallthrough
     case kArray_GeometrySrcType: {
         size_t vertexBytes = (vertexCount + startVertex) *
-                             VertexSize(draw->fVertexLayout);
+                             VertexSize(draw.fVertexLayout);
         poolState.fUsedPoolVertexBytes =
                             GrMax(poolState.fUsedPoolVertexBytes, vertexBytes);
-        draw->fVertexBuffer = poolState.fPoolVertexBuffer;
-        draw->fStartVertex += poolState.fPoolStartVertex;
+        draw.fVertexBuffer = poolState.fPoolVertexBuffer;
+        draw.fStartVertex += poolState.fPoolStartVertex;
         break;
     }
     default:
         GrCrash("unknown geom src type");
     }
-    draw->fVertexBuffer->ref();
-    draw->fIndexBuffer = NULL;
+    draw.fIndexBuffer = NULL;
+
+    ++fDrawCount;
+    if (!this->appendToLastDraw(draw)) {
+        *this->recordDraw() = draw;
+        draw.fVertexBuffer->ref();
+    }
+}
+
+bool GrInOrderDrawBuffer::appendToLastDraw(const Draw& draw) {
+    // any state or clip change since the last draw was recorded after it
+    if (kDraw_Cmd != fCmds.back()) {
+        return false;
+    }
+    Draw& last = fDraws.back();
+    if (last.fPrimitiveType != draw.fPrimitiveType ||
+        last.fVertexLayout != draw.fVertexLayout ||
+        last.fVertexBuffer != draw.fVertexBuffer ||
+        last.fIndexBuffer != draw.fIndexBuffer ||
+        last.fStartVertex + last.fVertexCount != draw.fStartVertex) {
+        return false;
+    }
+
+    // Strips and fans share vertices between primitives, so only lists of
+    // independent primitives can be joined, and only when the last draw
+    // doesn't end partway through a primitive.
+    int verticesPerPrimitive;
+    switch (draw.fPrimitiveType) {
+        case kTriangles_GrPrimitiveType:
+            verticesPerPrimitive = 3;
+            break;
+        case kLines_GrPrimitiveType:
+            verticesPerPrimitive = 2;
+            break;
+        case kPoints_GrPrimitiveType:
+            verticesPerPrimitive = 1;
+            break;
+        default:
+            return false;
+    }
+
+    if (0 == draw.fIndexCount) {
+        GrAssert(0 == last.fIndexCount);
+        if (last.fVertexCount % verticesPerPrimitive) {
+            return false;
+        }
+    } else {
+        // Indices are relative to the draw's start vertex, so indexed draws
+        // can only be joined when both are whole quads drawn from the quad
+        // index buffer, whose indices for each quad are four more than the
+        // previous quad's.
+        if (NULL == fQuadIndexBuffer ||
+            draw.fIndexBuffer != fQuadIndexBuffer ||
+            0 != last.fStartIndex || 0 != draw.fStartIndex ||
+            last.fVertexCount % 4 || draw.fVertexCount % 4 ||
+            last.fIndexCount * 4 != last.fVertexCount * 6 ||
+            draw.fIndexCount * 4 != draw.fVertexCount * 6 ||
+            (last.fVertexCount + draw.fVertexCount) / 4 > fMaxQuads) {
+            return false;
+        }
+    }
+
+    last.fVertexCount += draw.fVertexCount;
+    last.fIndexCount += draw.fIndexCount;
+    ++fMergedDrawCount;
+    return true;
 }
 
 void GrInOrderDrawBuffer::onStencilPath(const GrPath* path, GrPathFill fill) {
@@ -579,12 +605,14 @@ bool GrInOrderDrawBuffer::playback(GrDrawTarget* target) {
             case kSetState_Cmd:
                 target->setDrawState(&fStates[currState]);
                 ++currState;
+                ++fStateChangeCount;
                 break;
             case kSetClip_Cmd:
                 clipData.fClipStack = &fClips[currClip];
                 clipData.fOrigin = fClipOrigins[currClip];
                 target->setClip(&clipData);
                 ++currClip;
+                ++fStateChangeCount;
                 break;
             case kClear_Cmd:
                 target->clear(&fClears[currClear].fRect,
@@ -606,6 +634,12 @@ bool GrInOrderDrawBuffer::playback(GrDrawTarget* target) {
     return true;
 }
 
+void GrInOrderDrawBuffer::resetCounts() {
+    fDrawCount = 0;
+    fMergedDrawCount = 0;
+    fStateChangeCount = 0;
+}
+
 void GrInOrderDrawBuffer::setAutoFlushTarget(GrDrawTarget* target) {
     GrSafeAssign(fAutoFlushTarget, target);
 }
@@ -57,7 +57,7 @@ public:
 
     /**
      * Provides the buffer with an index buffer that can be used for quad rendering.
-     * The buffer may be able to batch consecutive drawRects if this is provided.
+     * The buffer batches consecutive drawRects if this is provided.
      * @param indexBuffer   index buffer with quad indices.
      */
     void setQuadIndexBuffer(const GrIndexBuffer* indexBuffer);
@@ -112,6 +112,17 @@ public:
      */
     void setAutoFlushTarget(GrDrawTarget* target);
 
+    /**
+     * Counts of the draws made to the buffer, of those that were appended to
+     * the previous draw rather than recorded as a draw of their own, and of
+     * the draw state and clip changes played back, since the last call to
+     * resetCounts().
+     */
+    int drawCount() const { return fDrawCount; }
+    int mergedDrawCount() const { return fMergedDrawCount; }
+    int stateChangeCount() const { return fStateChangeCount; }
+    void resetCounts();
+
     // overrides from GrDrawTarget
     virtual void drawRect(const GrRect& rect,
                           const GrMatrix* matrix = NULL,
@@ -209,6 +220,9 @@ private:
     void            recordClip();
     void            recordDefaultClip();
     Draw*           recordDraw();
+    // appends draw to the last recorded draw if it directly follows it in
+    // the same buffers and can be drawn with it in a single call.
+    bool            appendToLastDraw(const Draw& draw);
     StencilPath*    recordStencilPath();
     Clear*          recordClear();
 
@@ -243,11 +257,9 @@ private:
 
     GrIndexBufferAllocPool&         fIndexPool;
 
-    // these are used to attempt to concatenate drawRect calls
-    GrVertexLayout                  fLastRectVertexLayout;
+    // drawRect draws with this, so that consecutive rects can be merged
     const GrIndexBuffer*            fQuadIndexBuffer;
     int                             fMaxQuads;
-    int                             fCurrQuad;
 
     // bookkeeping to attempt to concantenate drawIndexedInstances calls
     struct {
@@ -274,6 +286,10 @@ private:
 
     bool                            fFlushing;
 
+    int                             fDrawCount;
+    int                             fMergedDrawCount;
+    int                             fStateChangeCount;
+
     typedef GrDrawTarget INHERITED;
 };
 
@@ -55,6 +55,7 @@ void GrPathRendererChain::init() {
     bool wrapOp = gpu->getCaps().stencilWrapOpsSupport();
     GrPathRenderer::AddPathRenderers(fOwner, fFlags, this);
     this->addPathRenderer(SkNEW_ARGS(GrDefaultPathRenderer,
-                                     (twoSided, wrapOp)))->unref();
+                                     (twoSided, wrapOp,
+                                      fOwner->getPathVertexCache())))->unref();
     fInit = true;
 }
@@ -0,0 +1,194 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "GrPathVertexCache.h"
+
+namespace {
+
+// The table is searched by a hash of the path together with the renderer's
+// Key; the full path is compared only once an entry is found. A path whose
+// hash and key collide with another's just replaces it.
+struct HashData {
+    uint32_t    fPathHash;
+    uint32_t    fTag;
+    GrScalar    fMatrix[4];
+};
+
+// Cheap to compute for any size of path: the bounds, the number of points
+// and verbs and the end points tell most paths apart.
+uint32_t hash_path(const SkPath& path) {
+    int pointCount = path.countPoints();
+    uint32_t data[9];
+    const SkRect& bounds = path.getBounds();
+    memcpy(data, &bounds, sizeof(SkRect));
+    data[4] = (pointCount << 8) ^ path.countVerbs() ^ (path.getFillType() << 28);
+    SkPoint first = { 0, 0 };
+    SkPoint last = { 0, 0 };
+    if (pointCount > 0) {
+        first = path.getPoint(0);
+        last = path.getPoint(pointCount - 1);
+    }
+    memcpy(&data[5], &first, sizeof(SkPoint));
+    memcpy(&data[7], &last, sizeof(SkPoint));
+
+    uint32_t hash = 0;
+    for (size_t i = 0; i < SK_ARRAY_COUNT(data); ++i) {
+        hash = ((hash << 5) | (hash >> 27)) ^ data[i];
+        hash *= 0x9E3779B1;
+    }
+    return hash ^ (hash >> 16);
+}
+
+}
+
+class GrPathVertexCache::Entry {
+public:
+    Entry(const HashData& data, const SkPath& path, size_t geometrySize)
+        : fPath(path) {
+        fData = data;
+        fGeometry = (Geometry*) sk_malloc_throw(geometrySize);
+        fBytes = sizeof(Entry) + geometrySize +
+                 path.countPoints() * sizeof(SkPoint) + path.countVerbs();
+    }
+    ~Entry() {
+        sk_free(fGeometry);
+    }
+
+    HashData    fData;
+    SkPath      fPath;
+    Geometry*   fGeometry;
+    size_t      fBytes;
+
+private:
+    SK_DEFINE_DLINKEDLIST_INTERFACE(Entry);
+};
+
+class GrPathVertexCache::HashKey {
+public:
+    HashKey(const HashData& data) : fData(data) {}
+
+    uint32_t getHash() const { return fData.fPathHash; }
+
+    static bool LT(const Entry& entry, const HashKey& key) {
+        return memcmp(&entry.fData, &key.fData, sizeof(HashData)) < 0;
+    }
+    static bool EQ(const Entry& entry, const HashKey& key) {
+        return 0 == memcmp(&entry.fData, &key.fData, sizeof(HashData));
+    }
+
+private:
+    const HashData& fData;
+};
+
+static void make_hash_data(const SkPath& path,
+                           const GrPathVertexCache::Key& key,
+                           HashData* data) {
+    data->fPathHash = hash_path(path);
+    data->fTag = key.fTag;
+    memcpy(data->fMatrix, key.fMatrix, sizeof(data->fMatrix));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GrPathVertexCache::GrPathVertexCache(size_t maxBytes) : fMaxBytes(maxBytes) {
+    memset(&fStats, 0, sizeof(fStats));
+}
+
+GrPathVertexCache::~GrPathVertexCache() {
+    this->purgeAll();
+}
+
+const GrPathVertexCache::Geometry* GrPathVertexCache::find(
+                                                    const SkPath& path,
+                                                    const Key& key) {
+    HashData data;
+    make_hash_data(path, key, &data);
+
+    Entry* entry = fHash.find(HashKey(data));
+    if (NULL == entry || entry->fPath != path) {
+        ++fStats.fMisses;
+        return NULL;
+    }
+    ++fStats.fHits;
+
+    fList.remove(entry);
+    fList.addToHead(entry);
+    return entry->fGeometry;
+}
+
+void GrPathVertexCache::add(const SkPath& path, const Key& key,
+                            GrPrimitiveType type,
+                            const void* vertices, size_t vertexSize,
+                            int vertexCount,
+                            const uint16_t* indices, int indexCount,
+                            const GrVec& origin) {
+    HashData data;
+    make_hash_data(path, key, &data);
+
+    Entry* entry = fHash.find(HashKey(data));
+    if (NULL != entry) {
+        this->remove(entry);
+    }
+
+    size_t vertexBytes = vertexSize * vertexCount;
+    size_t indexBytes = sizeof(uint16_t) * indexCount;
+    size_t geometrySize = sizeof(Geometry) + vertexBytes + indexBytes;
+    // don't let one path push out everything else
+    if (geometrySize > fMaxBytes / 4) {
+        return;
+    }
+
+    entry = SkNEW_ARGS(Entry, (data, path, geometrySize));
+    Geometry* geometry = entry->fGeometry;
+    geometry->fPrimitiveType = type;
+    geometry->fVertexSize = vertexSize;
+    geometry->fVertexCount = vertexCount;
+    geometry->fIndexCount = indexCount;
+    geometry->fOrigin = origin;
+    memcpy(geometry + 1, vertices, vertexBytes);
+    if (indexCount > 0) {
+        memcpy((char*)(geometry + 1) + vertexBytes, indices, indexBytes);
+    }
+
+    fHash.insert(HashKey(data), entry);
+    fList.addToHead(entry);
+    fStats.fCount += 1;
+    fStats.fBytes += entry->fBytes;
+
+    this->purgeAsNeeded();
+}
+
+void GrPathVertexCache::setMaxBytes(size_t maxBytes) {
+    fMaxBytes = maxBytes;
+    this->purgeAsNeeded();
+}
+
+void GrPathVertexCache::purgeAll() {
+    while (Entry* entry = fList.tail()) {
+        this->remove(entry);
+    }
+    GrAssert(0 == fStats.fCount);
+    GrAssert(0 == fStats.fBytes);
+}
+
+void GrPathVertexCache::remove(Entry* entry) {
+    fHash.remove(HashKey(entry->fData), entry);
+    fList.remove(entry);
+    fStats.fCount -= 1;
+    fStats.fBytes -= entry->fBytes;
+    SkDELETE(entry);
+}
+
+void GrPathVertexCache::purgeAsNeeded() {
+    while (fStats.fBytes > fMaxBytes) {
+        Entry* entry = fList.tail();
+        GrAssert(NULL != entry);
+        this->remove(entry);
+        ++fStats.fPurges;
+    }
+}
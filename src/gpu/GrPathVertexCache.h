@@ -0,0 +1,107 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef GrPathVertexCache_DEFINED
+#define GrPathVertexCache_DEFINED
+
+#include "GrNoncopyable.h"
+#include "GrPoint.h"
+#include "GrTHashCache.h"
+#include "GrTypes.h"
+#include "SkPath.h"
+#include "SkTDLinkedList.h"
+
+/**
+ *  Keeps the vertices and indices path renderers generate for paths, so that
+ *  a path drawn again (typically every frame, perhaps moved) skips curve
+ *  subdivision and edge setup and just copies its geometry into the draw.
+ *
+ *  Geometry is found by the path's contents and a Key the renderer fills in
+ *  with whatever else it was generated for: the renderer and its mode, and
+ *  the part of the view matrix the vertices depend on. Renderers leave the
+ *  translation out of the key and apply it when they copy the vertices, which
+ *  is why geometry records the origin it was generated at.
+ *
+ *  The cache is budgeted in bytes, and purges the least recently used
+ *  geometry to stay within it.
+ */
+class GrPathVertexCache : public GrNoncopyable {
+public:
+    enum {
+        kDefaultMaxBytes = 1 << 20
+    };
+
+    GrPathVertexCache(size_t maxBytes = kDefaultMaxBytes);
+    ~GrPathVertexCache();
+
+    /**
+     *  What geometry was generated for, besides the path. Fields a renderer
+     *  doesn't need must be zero.
+     */
+    struct Key {
+        uint32_t    fTag;       // the renderer and its settings
+        GrScalar    fMatrix[4]; // e.g. the view matrix's scale and skew
+    };
+
+    struct Geometry {
+        GrPrimitiveType fPrimitiveType;
+        size_t          fVertexSize;
+        int             fVertexCount;
+        int             fIndexCount;
+        GrVec           fOrigin;    // translation the vertices include
+
+        const void* vertices() const { return this + 1; }
+        const uint16_t* indices() const {
+            return reinterpret_cast<const uint16_t*>(
+                (const char*) this->vertices() + fVertexSize * fVertexCount);
+        }
+    };
+
+    /**
+     *  Returns the geometry generated for path and key, or NULL if there is
+     *  none. The geometry stays valid until the next call to add().
+     */
+    const Geometry* find(const SkPath& path, const Key& key);
+
+    /**
+     *  Keeps a copy of geometry generated for path and key, replacing any
+     *  already kept. Geometry too large for the budget isn't kept.
+     */
+    void add(const SkPath& path, const Key& key, GrPrimitiveType type,
+             const void* vertices, size_t vertexSize, int vertexCount,
+             const uint16_t* indices, int indexCount, const GrVec& origin);
+
+    size_t getMaxBytes() const { return fMaxBytes; }
+    void setMaxBytes(size_t maxBytes);
+
+    void purgeAll();
+
+    struct Stats {
+        int     fCount;     // paths whose geometry is kept
+        size_t  fBytes;     // bytes used by them
+        int     fHits;      // find() calls that returned geometry
+        int     fMisses;    // find() calls that didn't
+        int     fPurges;    // geometry purged to stay within budget
+    };
+    const Stats& stats() const { return fStats; }
+
+private:
+    class Entry;
+    class HashKey;
+
+    GrTHashTable<Entry, HashKey, 8>  fHash;
+    SkTDLinkedList<Entry>           fList;     // most recently used first
+
+    size_t  fMaxBytes;
+    Stats   fStats;
+
+    void remove(Entry* entry);
+    void purgeAsNeeded();
+};
+
+#endif
@@ -52,6 +52,16 @@ public:
         return false;
     }
 
+    bool hasFreePlot() const {
+        int count = fDim.fX * fDim.fY;
+        for (int i = 0; i < count; i++) {
+            if (!fBusy[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool isBusy(int x, int y) const {
         GrAssert((unsigned)x < (unsigned)fDim.fX);
         GrAssert((unsigned)y < (unsigned)fDim.fY);
@@ -9,6 +9,7 @@
 
 
 #include "GrRectanizer.h"
+#include "GrRectanizer_skyline.h"
 #include "GrTBSearch.h"
 
 #define MIN_HEIGHT_POW2     2
@@ -116,8 +117,15 @@ bool GrRectanizerPow2::addRect(int width, int height, GrIPoint16* loc) {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-GrRectanizer* GrRectanizer::Factory(int width, int height) {
-    return SkNEW_ARGS(GrRectanizerPow2, (width, height));
+GrRectanizer* GrRectanizer::Factory(int width, int height, Type type) {
+    switch (type) {
+        case kPow2_Type:
+            return SkNEW_ARGS(GrRectanizerPow2, (width, height));
+        case kSkyline_Type:
+            return SkNEW_ARGS(GrRectanizerSkyline, (width, height));
+    }
+    GrAssert(!"unknown rectanizer type");
+    return NULL;
 }
 
 
@@ -42,10 +42,23 @@ public:
     virtual int stripToPurge(int height) const = 0;
     virtual void purgeStripAtY(int yCoord) = 0;
 
+    enum Type {
+        // Packs rects into rows whose heights are powers of two. Fast, but
+        // a rect can waste up to half its row, and short rows are never
+        // reused for other heights.
+        kPow2_Type,
+        // Places each rect at the lowest spot along the top edge (skyline)
+        // of the rects placed so far, so mixed sizes pack tightly.
+        kSkyline_Type,
+
+        kDefault_Type = kSkyline_Type
+    };
+
     /**
      *  Our factory, which returns the subclass du jour
      */
-    static GrRectanizer* Factory(int width, int height);
+    static GrRectanizer* Factory(int width, int height,
+                                 Type type = kDefault_Type);
 
 private:
     int fWidth;
@@ -0,0 +1,144 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "GrRectanizer_skyline.h"
+
+GrRectanizerSkyline::GrRectanizerSkyline(int w, int h) : GrRectanizer(w, h) {
+    fAreaSoFar = 0;
+    fAreaWasted = 0;
+
+    // the skyline starts out as one segment along the whole (empty) top
+    Segment* segment = fSkyline.append();
+    segment->fX = 0;
+    segment->fY = 0;
+    segment->fWidth = w;
+}
+
+bool GrRectanizerSkyline::addRect(int width, int height, GrIPoint16* loc) {
+    if ((unsigned)width > (unsigned)this->width() ||
+        (unsigned)height > (unsigned)this->height()) {
+        return false;
+    }
+
+    // find the position that leaves the top of the rect lowest, and among
+    // those the one on the narrowest segment, which leaves wider gaps open
+    // for wider rects
+    int bestWidth = this->width() + 1;
+    int bestX = 0;
+    int bestY = this->height() + 1;
+    int bestIndex = -1;
+    for (int i = 0; i < fSkyline.count(); ++i) {
+        int y;
+        if (this->rectangleFits(i, width, height, &y)) {
+            if (y < bestY || (y == bestY && fSkyline[i].fWidth < bestWidth)) {
+                bestIndex = i;
+                bestWidth = fSkyline[i].fWidth;
+                bestX = fSkyline[i].fX;
+                bestY = y;
+            }
+        }
+    }
+
+    if (-1 == bestIndex) {
+        return false;
+    }
+
+    this->addSkylineLevel(bestIndex, bestX, bestY, width, height);
+    loc->set(bestX, bestY);
+    fAreaSoFar += width * height;
+#if GR_DEBUG
+    this->validate();
+#endif
+    return true;
+}
+
+bool GrRectanizerSkyline::rectangleFits(int index, int width, int height,
+                                        int* ypos) const {
+    int x = fSkyline[index].fX;
+    if (x + width > this->width()) {
+        return false;
+    }
+
+    int widthLeft = width;
+    int i = index;
+    int y = fSkyline[index].fY;
+    while (widthLeft > 0) {
+        GrAssert(i < fSkyline.count());
+        y = GrMax(y, fSkyline[i].fY);
+        if (y + height > this->height()) {
+            return false;
+        }
+        widthLeft -= fSkyline[i].fWidth;
+        ++i;
+    }
+
+    *ypos = y;
+    return true;
+}
+
+void GrRectanizerSkyline::addSkylineLevel(int index, int x, int y,
+                                          int width, int height) {
+    // the segments the rect covers are raised to its top; whatever lay
+    // between them and its bottom can't be reached any more
+    int right = x + width;
+    for (int i = index; i < fSkyline.count() && fSkyline[i].fX < right; ++i) {
+        int covered = GrMin(fSkyline[i].fX + fSkyline[i].fWidth, right) -
+                      GrMax(fSkyline[i].fX, x);
+        fAreaWasted += (y - fSkyline[i].fY) * covered;
+    }
+
+    Segment newSegment;
+    newSegment.fX = x;
+    newSegment.fY = y + height;
+    newSegment.fWidth = width;
+    fSkyline.insert(index, 1, &newSegment);
+
+    GrAssert(newSegment.fX + newSegment.fWidth <= this->width());
+    GrAssert(newSegment.fY <= this->height());
+
+    // delete width of the new segment from the ones after it
+    for (int i = index + 1; i < fSkyline.count(); ++i) {
+        int prevRight = fSkyline[i-1].fX + fSkyline[i-1].fWidth;
+        if (fSkyline[i].fX >= prevRight) {
+            break;
+        }
+        int shrink = prevRight - fSkyline[i].fX;
+        fSkyline[i].fX += shrink;
+        fSkyline[i].fWidth -= shrink;
+        if (fSkyline[i].fWidth > 0) {
+            break;
+        }
+        fSkyline.remove(i);
+        --i;
+    }
+
+    // merge segments at the same height
+    for (int i = 0; i < fSkyline.count() - 1; ++i) {
+        if (fSkyline[i].fY == fSkyline[i+1].fY) {
+            fSkyline[i].fWidth += fSkyline[i+1].fWidth;
+            fSkyline.remove(i+1);
+            --i;
+        }
+    }
+}
+
+#if GR_DEBUG
+void GrRectanizerSkyline::validate() const {
+    GrAssert(fSkyline.count() > 0);
+    int x = 0;
+    for (int i = 0; i < fSkyline.count(); ++i) {
+        GrAssert(fSkyline[i].fX == x);
+        GrAssert(fSkyline[i].fWidth > 0);
+        GrAssert(fSkyline[i].fY >= 0 && fSkyline[i].fY <= this->height());
+        GrAssert(0 == i || fSkyline[i].fY != fSkyline[i-1].fY);
+        x += fSkyline[i].fWidth;
+    }
+    GrAssert(x == this->width());
+    GrAssert(fAreaSoFar + fAreaWasted <= this->width() * this->height());
+}
+#endif
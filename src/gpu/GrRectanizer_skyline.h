@@ -0,0 +1,68 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef GrRectanizer_skyline_DEFINED
+#define GrRectanizer_skyline_DEFINED
+
+#include "GrRectanizer.h"
+#include "SkTDArray.h"
+
+/**
+ *  Packs rects bottom-left along a skyline: the top edge of everything placed
+ *  so far, kept as a list of horizontal segments. Each rect goes where its
+ *  top would be lowest, so rects of mixed sizes fill each other's gaps rather
+ *  than each size starting a row of its own.
+ *
+ *  Space that ends up under a rect but above the skyline (because the rect
+ *  straddled segments of different heights) can't be reached again; it is
+ *  counted as wasted.
+ */
+class GrRectanizerSkyline : public GrRectanizer {
+public:
+    GrRectanizerSkyline(int w, int h);
+
+    virtual bool addRect(int w, int h, GrIPoint16* loc) SK_OVERRIDE;
+
+    virtual float percentFull() const SK_OVERRIDE {
+        return fAreaSoFar / ((float)this->width() * this->height());
+    }
+
+    /**
+     *  The fraction of the area that lies below the skyline without a rect in
+     *  it, and so can't be used any more.
+     */
+    float percentWasted() const {
+        return fAreaWasted / ((float)this->width() * this->height());
+    }
+
+    virtual int stripToPurge(int height) const SK_OVERRIDE { return -1; }
+    virtual void purgeStripAtY(int yCoord) SK_OVERRIDE { }
+
+#if GR_DEBUG
+    void validate() const;
+#endif
+
+private:
+    struct Segment {
+        int fX;
+        int fY;
+        int fWidth;
+    };
+
+    SkTDArray<Segment> fSkyline;
+
+    int32_t fAreaSoFar;
+    int32_t fAreaWasted;
+
+    // Returns true if a w x h rect fits with its left edge at segment index,
+    // and sets *y to the lowest y it can go at there.
+    bool rectangleFits(int index, int w, int h, int* y) const;
+    void addSkylineLevel(int index, int x, int y, int w, int h);
+};
+
+#endif
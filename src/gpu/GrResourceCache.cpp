@@ -10,10 +10,14 @@
 
 #include "GrResourceCache.h"
 #include "GrResource.h"
+#include "GrStencilBuffer.h"
+#include "GrTexture.h"
 
 GrResourceEntry::GrResourceEntry(const GrResourceKey& key, GrResource* resource)
         : fKey(key), fResource(resource) {
     fLockCount = 0;
+    fCategory = GrResourceCache::CategoryForKey(key);
+    fHashNext = NULL;
 
     // we assume ownership of the resource, and will unref it when we die
     GrAssert(resource);
@@ -29,45 +33,31 @@ void GrResourceEntry::validate() const {
     GrAssert(fLockCount >= 0);
     GrAssert(fResource);
     GrAssert(fResource->getCacheEntry() == this);
+    GrAssert(GrResourceCache::CategoryForKey(fKey) == fCategory);
     fResource->validate();
 }
 #endif
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class GrResourceCache::Key {
-    typedef GrResourceEntry T;
-
-    const GrResourceKey& fKey;
-public:
-    Key(const GrResourceKey& key) : fKey(key) {}
-
-    uint32_t getHash() const { return fKey.hashIndex(); }
-
-    static bool LT(const T& entry, const Key& key) {
-        return entry.key() < key.fKey;
-    }
-    static bool EQ(const T& entry, const Key& key) {
-        return entry.key() == key.fKey;
-    }
-#if GR_DEBUG
-    static uint32_t GetHash(const T& entry) {
-        return entry.key().hashIndex();
-    }
-    static bool LT(const T& a, const T& b) {
-        return a.key() < b.key();
-    }
-    static bool EQ(const T& a, const T& b) {
-        return a.key() == b.key();
-    }
-#endif
-};
-
-///////////////////////////////////////////////////////////////////////////////
+// The hash table starts with this many buckets, and doubles whenever it has
+// more entries than buckets.
+static const int kInitialBucketCount = 64;
 
 GrResourceCache::GrResourceCache(int maxCount, size_t maxBytes) :
         fMaxCount(maxCount),
         fMaxBytes(maxBytes) {
+    fBucketCount = kInitialBucketCount;
+    fBuckets = SkNEW_ARRAY(GrResourceEntry*, fBucketCount);
+    memset(fBuckets, 0, fBucketCount * sizeof(GrResourceEntry*));
+    fHashCount = 0;
+
+    for (int i = 0; i < kGrResourceCategoryCount; ++i) {
+        fCategories[i].fMaxCount = SK_MaxS32;
+        fCategories[i].fMaxBytes = (size_t) -1;
+        memset(&fCategories[i].fStats, 0, sizeof(CategoryStats));
+    }
+
 #if GR_CACHE_STATS
     fHighWaterEntryCount          = 0;
     fHighWaterUnlockedEntryCount  = 0;
@@ -95,13 +85,18 @@ GrResourceCache::~GrResourceCache() {
         GrAutoResourceCacheValidate atcv(this);
 
         // remove from our cache
-        fCache.remove(entry->fKey, entry);
+        this->hashRemove(entry);
 
         // remove from our llist
         this->internalDetach(entry, false);
 
         delete entry;
     }
+
+    // the validation on the way out still walks the (now empty) table
+    SkDELETE_ARRAY(fBuckets);
+    fBuckets = NULL;
+    fBucketCount = 0;
 }
 
 void GrResourceCache::getLimits(int* maxResources, size_t* maxResourceBytes) const{
@@ -124,6 +119,111 @@ void GrResourceCache::setLimits(int maxResources, size_t maxResourceBytes) {
     }
 }
 
+void GrResourceCache::getCategoryLimits(GrResourceCategory category,
+                                        int* maxResources,
+                                        size_t* maxResourceBytes) const {
+    if (maxResources) {
+        *maxResources = fCategories[category].fMaxCount;
+    }
+    if (maxResourceBytes) {
+        *maxResourceBytes = fCategories[category].fMaxBytes;
+    }
+}
+
+void GrResourceCache::setCategoryLimits(GrResourceCategory category,
+                                        int maxResources,
+                                        size_t maxResourceBytes) {
+    fCategories[category].fMaxCount = maxResources;
+    fCategories[category].fMaxBytes = maxResourceBytes;
+
+    this->purgeAsNeeded();
+}
+
+GrResourceCategory GrResourceCache::CategoryForKey(const GrResourceKey& key) {
+    uint8_t type = key.getResourceType();
+    if ((uint8_t) GrTexture::GetResourceType() == type) {
+        // Render targets with their own key, e.g. clip masks, are redrawn
+        // rather than uploaded, so they share the scratch textures' budget
+        // instead of evicting uploaded content.
+        return GrTexture::IsScratchTexture(key) ||
+               GrTexture::IsRenderTargetTexture(key) ?
+                    kScratchTexture_GrResourceCategory :
+                    kContentTexture_GrResourceCategory;
+    }
+    if ((uint8_t) GrStencilBuffer::GetResourceType() == type) {
+        return kStencilBuffer_GrResourceCategory;
+    }
+    return kOther_GrResourceCategory;
+}
+
+void GrResourceCache::updateCategory(const GrResourceEntry* entry, int sign) {
+    CategoryStats& stats = fCategories[entry->fCategory].fStats;
+    size_t bytes = entry->resource()->sizeInBytes();
+    if (sign > 0) {
+        stats.fCount += 1;
+        stats.fBytes += bytes;
+    } else {
+        stats.fCount -= 1;
+        stats.fBytes -= bytes;
+    }
+}
+
+bool GrResourceCache::overBudget() const {
+    return fEntryCount > fMaxCount || fEntryBytes > fMaxBytes;
+}
+
+bool GrResourceCache::overBudget(GrResourceCategory category) const {
+    const Category& c = fCategories[category];
+    return c.fStats.fCount > c.fMaxCount || c.fStats.fBytes > c.fMaxBytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GrResourceEntry* GrResourceCache::hashFind(const GrResourceKey& key) const {
+    GrResourceEntry* entry = fBuckets[key.getHash() & (fBucketCount - 1)];
+    while (NULL != entry && entry->key() != key) {
+        entry = entry->fHashNext;
+    }
+    return entry;
+}
+
+void GrResourceCache::hashInsert(GrResourceEntry* entry) {
+    if (fHashCount >= fBucketCount) {
+        int bucketCount = fBucketCount * 2;
+        GrResourceEntry** buckets = SkNEW_ARRAY(GrResourceEntry*, bucketCount);
+        memset(buckets, 0, bucketCount * sizeof(GrResourceEntry*));
+        for (int i = 0; i < fBucketCount; ++i) {
+            GrResourceEntry* next;
+            for (GrResourceEntry* e = fBuckets[i]; NULL != e; e = next) {
+                next = e->fHashNext;
+                int index = e->key().getHash() & (bucketCount - 1);
+                e->fHashNext = buckets[index];
+                buckets[index] = e;
+            }
+        }
+        SkDELETE_ARRAY(fBuckets);
+        fBuckets = buckets;
+        fBucketCount = bucketCount;
+    }
+
+    int index = entry->key().getHash() & (fBucketCount - 1);
+    entry->fHashNext = fBuckets[index];
+    fBuckets[index] = entry;
+    ++fHashCount;
+}
+
+void GrResourceCache::hashRemove(GrResourceEntry* entry) {
+    GrResourceEntry** prev = &fBuckets[entry->key().getHash() &
+                                       (fBucketCount - 1)];
+    while (*prev != entry) {
+        GrAssert(NULL != *prev);
+        prev = &(*prev)->fHashNext;
+    }
+    *prev = entry->fHashNext;
+    entry->fHashNext = NULL;
+    --fHashCount;
+}
+
 void GrResourceCache::internalDetach(GrResourceEntry* entry,
                                     bool clientDetach) {
     fList.remove(entry);
@@ -149,6 +249,7 @@ void GrResourceCache::internalDetach(GrResourceEntry* entry,
     } else {
         fEntryCount -= 1;
         fEntryBytes -= entry->resource()->sizeInBytes();
+        this->updateCategory(entry, -1);
     }
 }
 
@@ -172,6 +273,7 @@ void GrResourceCache::attachToHead(GrResourceEntry* entry,
     } else {
         fEntryCount += 1;
         fEntryBytes += entry->resource()->sizeInBytes();
+        this->updateCategory(entry, 1);
 
 #if GR_CACHE_STATS
         if (fHighWaterEntryCount < fEntryCount) {
@@ -187,10 +289,13 @@ void GrResourceCache::attachToHead(GrResourceEntry* entry,
 GrResource* GrResourceCache::find(const GrResourceKey& key) {
     GrAutoResourceCacheValidate atcv(this);
 
-    GrResourceEntry* entry = fCache.find(key);
+    GrResourceEntry* entry = this->hashFind(key);
+    CategoryStats& stats = fCategories[CategoryForKey(key)].fStats;
     if (NULL == entry) {
+        ++stats.fMisses;
         return NULL;
     }
+    ++stats.fHits;
 
     return entry->fResource;
 }
@@ -198,10 +303,13 @@ GrResource* GrResourceCache::find(const GrResourceKey& key) {
 GrResource* GrResourceCache::findAndLock(const GrResourceKey& key, LockType type) {
     GrAutoResourceCacheValidate atcv(this);
 
-    GrResourceEntry* entry = fCache.find(key);
+    GrResourceEntry* entry = this->hashFind(key);
+    CategoryStats& stats = fCategories[CategoryForKey(key)].fStats;
     if (NULL == entry) {
+        ++stats.fMisses;
         return NULL;
     }
+    ++stats.fHits;
 
     this->internalDetach(entry, false);
     this->attachToHead(entry, false);
@@ -214,7 +322,7 @@ GrResource* GrResourceCache::findAndLock(const GrResourceKey& key, LockType type
 }
 
 bool GrResourceCache::hasKey(const GrResourceKey& key) const {
-    return NULL != fCache.find(key);
+    return NULL != this->hashFind(key);
 }
 
 void GrResourceCache::create(const GrResourceKey& key, GrResource* resource) {
@@ -230,7 +338,7 @@ void GrResourceCache::create(const GrResourceKey& key, GrResource* resource) {
     resource->setCacheEntry(entry);
 
     this->attachToHead(entry, false);
-    fCache.insert(key, entry);
+    this->hashInsert(entry);
 
 #if GR_DUMP_TEXTURE_UPLOAD
     GrPrintf("--- add resource to cache %p, count=%d bytes= %d %d\n",
@@ -250,7 +358,7 @@ void GrResourceCache::makeExclusive(GrResourceEntry* entry) {
     GrAutoResourceCacheValidate atcv(this);
 
     this->internalDetach(entry, true);
-    fCache.remove(entry->key(), entry);
+    this->hashRemove(entry);
 
 #if GR_DEBUG
     fExclusiveList.addToHead(entry);
@@ -268,6 +376,7 @@ void GrResourceCache::removeInvalidResource(GrResourceEntry* entry) {
     size_t size = entry->resource()->sizeInBytes();
     fClientDetachedBytes -= size;
     fEntryBytes -= size;
+    this->updateCategory(entry, -1);
 }
 
 void GrResourceCache::makeNonExclusive(GrResourceEntry* entry) {
@@ -279,7 +388,7 @@ void GrResourceCache::makeNonExclusive(GrResourceEntry* entry) {
 
     if (entry->resource()->isValid()) {
         attachToHead(entry, true);
-        fCache.insert(entry->key(), entry);
+        this->hashInsert(entry);
     } else {
         this->removeInvalidResource(entry);
     }
@@ -289,7 +398,7 @@ void GrResourceCache::lock(GrResourceEntry* entry) {
     GrAutoResourceCacheValidate atcv(this);
 
     GrAssert(entry);
-    GrAssert(fCache.find(entry->key()));
+    GrAssert(this->hashFind(entry->key()));
 
     if (!entry->isLocked()) {
         --fUnlockedEntryCount;
@@ -303,7 +412,7 @@ void GrResourceCache::unlock(GrResourceEntry* entry) {
 
     GrAssert(entry);
     GrAssert(entry->isLocked());
-    GrAssert(fCache.find(entry->key()));
+    GrAssert(this->hashFind(entry->key()));
 
     entry->unlock();
     if (!entry->isLocked()) {
@@ -327,12 +436,19 @@ void GrResourceCache::unlock(GrResourceEntry* entry) {
  * resource's destructor inserting new resources into the cache. If these
  * new resources were unlocked before purgeAsNeeded completed it could
  * potentially make purgeAsNeeded loop infinitely.
+ *
+ * While the cache as a whole is over budget any unlocked resource may be
+ * purged; while only a category is over its own budget just that category's
+ * resources are. If a pass purges nothing (the rest of an over-budget
+ * category is locked) we give up until the next unlock.
  */
 void GrResourceCache::purgeAsNeeded() {
     if (!fPurging) {
         fPurging = true;
         bool withinBudget = false;
+        bool purged;
         do {
+            purged = false;
             EntryList::Iter iter;
 
             // Note: the following code relies on the fact that the
@@ -343,15 +459,28 @@ void GrResourceCache::purgeAsNeeded() {
 
             while (entry && fUnlockedEntryCount) {
                 GrAutoResourceCacheValidate atcv(this);
-                if (fEntryCount <= fMaxCount && fEntryBytes <= fMaxBytes) {
+                bool overBudget = this->overBudget();
+                if (!overBudget) {
                     withinBudget = true;
-                    break;
+                    for (int i = 0; i < kGrResourceCategoryCount; ++i) {
+                        if (this->overBudget((GrResourceCategory) i)) {
+                            withinBudget = false;
+                            break;
+                        }
+                    }
+                    if (withinBudget) {
+                        break;
+                    }
                 }
 
                 GrResourceEntry* prev = iter.prev();
-                if (!entry->isLocked()) {
+                if (!entry->isLocked() &&
+                    (overBudget || this->overBudget(entry->category()))) {
+                    ++fCategories[entry->category()].fStats.fPurges;
+                    purged = true;
+
                     // remove from our cache
-                    fCache.remove(entry->key(), entry);
+                    this->hashRemove(entry);
 
                     // remove from our llist
                     this->internalDetach(entry, false);
@@ -367,7 +496,7 @@ void GrResourceCache::purgeAsNeeded() {
                 }
                 entry = prev;
             }
-        } while (!withinBudget && fUnlockedEntryCount);
+        } while (!withinBudget && purged && fUnlockedEntryCount);
         fPurging = false;
     }
 }
@@ -389,7 +518,7 @@ void GrResourceCache::purgeAllUnlocked() {
     GrAssert(fExclusiveList.countEntries() == fClientDetachedCount);
     GrAssert(countBytes(fExclusiveList) == fClientDetachedBytes);
     GrAssert(!fUnlockedEntryCount);
-    if (!fCache.count()) {
+    if (!fHashCount) {
         // Items may have been detached from the cache (such as the backing
         // texture for an SkGpuDevice). The above purge would not have removed
         // them.
@@ -431,10 +560,26 @@ void GrResourceCache::validate() const {
     GrAssert(both_zero_or_nonzero(fClientDetachedCount, fClientDetachedBytes));
     GrAssert(fClientDetachedBytes <= fEntryBytes);
     GrAssert(fClientDetachedCount <= fEntryCount);
-    GrAssert((fEntryCount - fClientDetachedCount) == fCache.count());
-
-    fCache.validate();
+    GrAssert((fEntryCount - fClientDetachedCount) == fHashCount);
+
+    int hashCount = 0;
+    for (int i = 0; i < fBucketCount; ++i) {
+        for (const GrResourceEntry* e = fBuckets[i]; NULL != e;
+             e = e->fHashNext) {
+            GrAssert((int) (e->key().getHash() & (fBucketCount - 1)) == i);
+            hashCount += 1;
+        }
+    }
+    GrAssert(hashCount == fHashCount);
 
+    int categoryCount = 0;
+    size_t categoryBytes = 0;
+    for (int i = 0; i < kGrResourceCategoryCount; ++i) {
+        categoryCount += fCategories[i].fStats.fCount;
+        categoryBytes += fCategories[i].fStats.fBytes;
+    }
+    GrAssert(categoryCount == fEntryCount);
+    GrAssert(categoryBytes == fEntryBytes);
 
     EntryList::Iter iter;
 
@@ -452,7 +597,7 @@ void GrResourceCache::validate() const {
     int unlockCount = 0;
     for ( ; NULL != entry; entry = iter.next()) {
         entry->validate();
-        GrAssert(fCache.find(entry->key()));
+        GrAssert(this->hashFind(entry->key()));
         count += 1;
         if (!entry->isLocked()) {
             unlockCount += 1;
@@ -488,6 +633,17 @@ void GrResourceCache::printStats() const {
                 fClientDetachedCount, fHighWaterClientDetachedCount);
     SkDebugf("\t\tDetached Bytes: current %d high %d\n",
                 fClientDetachedBytes, fHighWaterClientDetachedBytes);
+
+    static const char* gCategoryNames[] = {
+        "Scratch Textures", "Content Textures", "Stencil Buffers", "Other"
+    };
+    GR_STATIC_ASSERT(SK_ARRAY_COUNT(gCategoryNames) == kGrResourceCategoryCount);
+    for (int i = 0; i < kGrResourceCategoryCount; ++i) {
+        const CategoryStats& stats = fCategories[i].fStats;
+        SkDebugf("\t\t%s: %d items %d bytes, hits %d misses %d purges %d\n",
+                    gCategoryNames[i], stats.fCount, stats.fBytes,
+                    stats.fHits, stats.fMisses, stats.fPurges);
+    }
 }
 
 #endif
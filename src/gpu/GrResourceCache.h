@@ -13,7 +13,6 @@
 
 #include "GrConfig.h"
 #include "GrTypes.h"
-#include "GrTHashCache.h"
 #include "SkTDLinkedList.h"
 
 class GrResource;
@@ -37,44 +36,37 @@ class GrResource;
  */
 class GrResourceKey {
 public:
-    enum {
-        kHashBits   = 7,
-        kHashCount  = 1 << kHashBits,
-        kHashMask   = kHashCount - 1
-    };
-
     GrResourceKey(uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3) {
         fP[0] = p0;
         fP[1] = p1;
         fP[2] = p2;
         fP[3] = p3;
-        this->computeHashIndex();
+        this->computeHash();
     }
 
     GrResourceKey(uint32_t v[4]) {
         memcpy(fP, v, 4 * sizeof(uint32_t));
-        this->computeHashIndex();
+        this->computeHash();
     }
 
     GrResourceKey(const GrResourceKey& src) {
         memcpy(fP, src.fP, 4 * sizeof(uint32_t));
 #if GR_DEBUG
-        this->computeHashIndex();
-        GrAssert(fHashIndex == src.fHashIndex);
+        this->computeHash();
+        GrAssert(fHash == src.fHash);
 #endif
-        fHashIndex = src.fHashIndex;
+        fHash = src.fHash;
     }
 
-    //!< returns hash value [0..kHashMask] for the key
-    int hashIndex() const { return fHashIndex; }
+    //!< returns the 32 bit hash of the key
+    uint32_t getHash() const { return fHash; }
 
     friend bool operator==(const GrResourceKey& a, const GrResourceKey& b) {
-        GR_DEBUGASSERT(-1 != a.fHashIndex && -1 != b.fHashIndex);
-        return 0 == memcmp(a.fP, b.fP, 4 * sizeof(uint32_t));
+        return a.fHash == b.fHash &&
+               0 == memcmp(a.fP, b.fP, 4 * sizeof(uint32_t));
     }
 
     friend bool operator!=(const GrResourceKey& a, const GrResourceKey& b) {
-        GR_DEBUGASSERT(-1 != a.fHashIndex && -1 != b.fHashIndex);
         return !(a == b);
     }
 
@@ -89,6 +81,9 @@ public:
         GrAssert(i >=0 && i < 4);
         return fP[i];
     }
+
+    //!< returns the resource type the key was made with (see GrCacheID)
+    uint8_t getResourceType() const { return (fP[3] >> 16) & 0xff; }
 private:
 
     static uint32_t rol(uint32_t x) {
@@ -101,19 +96,20 @@ private:
         return (x >> 16) | (x << 16);
     }
 
-    void computeHashIndex() {
+    void computeHash() {
         uint32_t hash = fP[0] ^ rol(fP[1]) ^ ror(fP[2]) ^ rohalf(fP[3]);
-        // this way to mix and reduce hash to its index may have to change
-        // depending on how many bits we allocate to the index
+        // mix all the bits down, since the cache indexes its table with the
+        // low bits
         hash ^= hash >> 16;
-        hash ^= hash >> 8;
-        fHashIndex = hash & kHashMask;
+        hash *= 0x85EBCA6B;
+        hash ^= hash >> 13;
+        fHash = hash;
     }
 
     uint32_t    fP[4];
 
     // this is computed from the fP... fields
-    int         fHashIndex;
+    uint32_t    fHash;
 
     friend class GrContext;
 };
@@ -145,6 +141,7 @@ class GrResourceEntry {
 public:
     GrResource* resource() const { return fResource; }
     const GrResourceKey& key() const { return fKey; }
+    GrResourceCategory category() const { return fCategory; }
 
 #if GR_DEBUG
     void validate() const;
@@ -170,6 +167,11 @@ private:
     // we only purge unlocked entries
     int fLockCount;
 
+    GrResourceCategory fCategory;
+
+    // the next entry in our bucket of the cache's hash table
+    GrResourceEntry* fHashNext;
+
     // we're a dlinklist
     SK_DEFINE_DLINKEDLIST_INTERFACE(GrResourceEntry);
 
@@ -179,8 +181,6 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 
-#include "GrTHashCache.h"
-
 /**
  *  Cache of GrResource objects.
  *
@@ -192,13 +192,15 @@ private:
  *  head of the list. If/when we must purge some of the entries, we walk the
  *  list backwards from the tail, since those are the least recently used.
  *
- *  For fast searches, we maintain a sorted array (based on the GrResourceKey)
- *  which we can bsearch. When a new entry is added, it is inserted into this
- *  array.
+ *  Searches go through a hash table of the keys, which grows with the cache,
+ *  so finding a key (including each size that lockScratchTexture() tries) is
+ *  constant time. Entries with the same key (e.g. scratch textures with the
+ *  same description) share a bucket, and a search returns any of them.
  *
- *  For even faster searches, a hash is computed from the Key. If there is
- *  a collision between two keys with the same hash, we fall back on the
- *  bsearch, and update the hash to reflect the most recent Key requested.
+ *  Each entry belongs to a GrResourceCategory, computed from its key, and
+ *  each category has a budget of its own besides the cache's overall one. A
+ *  category over its budget only purges its own entries, so (for instance) a
+ *  burst of large scratch textures can't push out all the content textures.
  */
 class GrResourceCache {
 public:
@@ -226,6 +228,37 @@ public:
      */
     void setLimits(int maxResource, size_t maxResourceBytes);
 
+    /**
+     *  Return and specify the limits for the resources of one category, which
+     *  apply on top of the overall limits. If the category exceeds them, its
+     *  own resources will be purged (LRU) to keep it within them.
+     */
+    void getCategoryLimits(GrResourceCategory category, int* maxResources,
+                           size_t* maxBytes) const;
+    void setCategoryLimits(GrResourceCategory category, int maxResources,
+                           size_t maxBytes);
+
+    /**
+     *  Usage counts for the resources of one category. fCount and fBytes are
+     *  the current totals; the rest count since the cache was created.
+     */
+    struct CategoryStats {
+        int     fCount;
+        size_t  fBytes;
+        int     fHits;          //!< searches that found a resource
+        int     fMisses;        //!< searches that didn't
+        int     fPurges;        //!< resources purged to meet a budget
+    };
+
+    const CategoryStats& getCategoryStats(GrResourceCategory category) const {
+        return fCategories[category].fStats;
+    }
+
+    /**
+     * Returns the category that resources with key belong to.
+     */
+    static GrResourceCategory CategoryForKey(const GrResourceKey& key);
+
     /**
      * Returns the number of bytes consumed by cached resources.
      */
@@ -312,9 +345,18 @@ private:
     void purgeAsNeeded();
 
     void removeInvalidResource(GrResourceEntry* entry);
+    void updateCategory(const GrResourceEntry* entry, int sign);
+    bool overBudget(GrResourceCategory category) const;
+    bool overBudget() const;
+
+    // the hash table of the entries that can be found
+    GrResourceEntry* hashFind(const GrResourceKey& key) const;
+    void hashInsert(GrResourceEntry* entry);
+    void hashRemove(GrResourceEntry* entry);
 
-    class Key;
-    GrTHashTable<GrResourceEntry, Key, 8> fCache;
+    GrResourceEntry** fBuckets;
+    int fBucketCount;   // a power of two
+    int fHashCount;
 
     // manage the dlink list
     typedef SkTDLinkedList<GrResourceEntry> EntryList;
@@ -329,6 +371,13 @@ private:
     int fMaxCount;
     size_t fMaxBytes;
 
+    struct Category {
+        int             fMaxCount;
+        size_t          fMaxBytes;
+        CategoryStats   fStats;
+    };
+    Category fCategories[kGrResourceCategoryCount];
+
     // our current stats, related to our budget
 #if GR_CACHE_STATS
     int fHighWaterEntryCount;
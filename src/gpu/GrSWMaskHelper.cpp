@@ -166,6 +166,15 @@ void GrSWMaskHelper::toTexture(GrTexture *texture, uint8_t alpha) {
                          fBM.getPixels(), fBM.rowBytes());
 }
 
+void GrSWMaskHelper::upload(GrTexture* texture) {
+    SkAutoLockPixels alp(fBM);
+
+    texture->writePixels(0, 0, fBM.width(), fBM.height(),
+                         kAlpha_8_GrPixelConfig,
+                         fBM.getPixels(), fBM.rowBytes(),
+                         GrContext::kDontFlush_PixelOpsFlag);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /**
  * Software rasterizes path to A8 mask (possibly using the context's matrix)
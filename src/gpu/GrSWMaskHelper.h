@@ -65,6 +65,10 @@ public:
     // The space outside of the mask is cleared using "alpha"
     void toTexture(GrTexture* texture, uint8_t alpha);
 
+    // Move the mask to the upper left of "texture" without flushing the
+    // context (the draws that use the mask may still be in the draw buffer)
+    void upload(GrTexture* texture);
+
     // Reset the internal bitmap
     void clear(uint8_t alpha) {
         fBM.eraseColor(SkColorSetARGB(alpha, alpha, alpha, alpha));
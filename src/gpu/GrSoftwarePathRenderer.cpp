@@ -9,6 +9,69 @@
 #include "GrSoftwarePathRenderer.h"
 #include "GrContext.h"
 #include "GrSWMaskHelper.h"
+#include "SkRunnable.h"
+#include "SkThread.h"
+#include "SkThreadPool.h"
+
+GR_DEFINE_RESOURCE_CACHE_DOMAIN(GrSoftwarePathRenderer, GetMaskDomain)
+
+// A mask in the texture cache, by what was drawn into it. The matrix is the
+// one the mask was rasterized with: the draw's, less whole pixels of
+// translation.
+struct GrSoftwarePathRenderer::MaskEntry {
+    uint32_t    fHash;
+    SkPath      fPath;
+    GrPathFill  fFill;
+    bool        fAntiAlias;
+    GrMatrix    fMatrix;
+    GrIRect     fBounds;
+    uint64_t    fCacheID;   // 0 until the mask is kept
+};
+
+// Rasterizes the mask of a buffered draw, possibly on another thread. The
+// upload is left to prepareMasks(), on the context's thread.
+class GrSoftwarePathRenderer::MaskJob : public SkRunnable {
+public:
+    MaskJob(GrContext* context)
+        : fHelper(context)
+        , fTexture(NULL)
+        , fCacheID(0)
+        , fSucceeded(false) {
+    }
+
+    virtual ~MaskJob() {
+        GrSafeUnref(fTexture);
+    }
+
+    virtual void run() SK_OVERRIDE {
+        fSucceeded = fHelper.init(fBounds, &fMatrix);
+        if (fSucceeded) {
+            fHelper.draw(fPath, SkRegion::kReplace_Op, fFill, fAntiAlias, 0xFF);
+        }
+    }
+
+    GrSWMaskHelper  fHelper;
+    SkPath          fPath;
+    GrPathFill      fFill;
+    bool            fAntiAlias;
+    GrMatrix        fMatrix;
+    GrIRect         fBounds;
+    GrTexture*      fTexture;
+    uint64_t        fCacheID;   // 0 if the mask isn't cached
+    bool            fSucceeded;
+};
+
+GrSoftwarePathRenderer::GrSoftwarePathRenderer(GrContext* context)
+    : fContext(context)
+    , fMasksRendered(0)
+    , fMasksFound(0) {
+}
+
+GrSoftwarePathRenderer::~GrSoftwarePathRenderer() {
+    // the context flushes before letting go of us, unless it was lost
+    fJobs.deleteAll();
+    fMaskEntries.deleteAll();
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 bool GrSoftwarePathRenderer::canDrawPath(const SkPath& path,
@@ -71,6 +134,41 @@ bool get_path_and_clip_bounds(const GrDrawTarget* target,
     return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Only used to tell paths apart quickly: entries with an equal hash still
+// compare the whole path.
+uint32_t hash_mask(const SkPath& path, const GrMatrix& matrix) {
+    uint32_t data[8];
+    memcpy(data, &path.getBounds(), sizeof(SkRect));
+    data[4] = (path.countPoints() << 8) ^ path.countVerbs();
+    GrScalar scale[3] = {
+        matrix.getScaleX() + matrix.getSkewY(),
+        matrix.getSkewX() + matrix.getScaleY(),
+        matrix.getTranslateX() + matrix.getTranslateY(),
+    };
+    memcpy(&data[5], scale, sizeof(scale));
+
+    uint32_t hash = 0;
+    for (size_t i = 0; i < SK_ARRAY_COUNT(data); ++i) {
+        hash = ((hash << 5) | (hash >> 27)) ^ data[i];
+        hash *= 0x9E3779B1;
+    }
+    return hash ^ (hash >> 16);
+}
+
+uint64_t next_mask_cache_id() {
+    static int32_t gNextID;
+    return (uint32_t) sk_atomic_inc(&gNextID) + 1;
+}
+
+GrTextureDesc mask_desc(const GrIRect& bounds) {
+    GrTextureDesc desc;
+    desc.fWidth = bounds.width();
+    desc.fHeight = bounds.height();
+    desc.fConfig = kAlpha_8_GrPixelConfig;
+    return desc;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void draw_around_inv_path(GrDrawTarget* target,
                           const GrIRect& devClipBounds,
@@ -104,6 +202,156 @@ void draw_around_inv_path(GrDrawTarget* target,
 
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Returns the locked mask texture for the path, drawn with matrix into bounds,
+// and its cacheID. If the mask was found in the cache "found" is set,
+// otherwise the texture is a new one that the mask still has to be rendered
+// into. Masks are only kept from the second time they're drawn, so NULL is
+// returned the first time.
+GrTexture* GrSoftwarePathRenderer::findCachedMask(const SkPath& path,
+                                                  GrPathFill fill,
+                                                  bool antiAlias,
+                                                  const GrMatrix& matrix,
+                                                  const GrIRect& bounds,
+                                                  uint64_t* cacheID,
+                                                  bool* found) {
+    GrTextureDesc desc = mask_desc(bounds);
+    uint32_t hash = hash_mask(path, matrix);
+
+    *found = false;
+    for (int i = 0; i < fMaskEntries.count(); ++i) {
+        MaskEntry* entry = fMaskEntries[i];
+        if (hash != entry->fHash || fill != entry->fFill ||
+            antiAlias != entry->fAntiAlias || matrix != entry->fMatrix ||
+            bounds != entry->fBounds || path != entry->fPath) {
+            continue;
+        }
+        fMaskEntries.remove(i);
+        *fMaskEntries.insert(0) = entry;
+
+        GrCacheData cacheData(entry->fCacheID);
+        cacheData.fResourceDomain = GetMaskDomain();
+        if (0 != entry->fCacheID) {
+            GrTexture* texture = fContext->findAndLockTexture(desc, cacheData,
+                                                              NULL);
+            if (NULL != texture) {
+                *cacheID = entry->fCacheID;
+                *found = true;
+                return texture;
+            }
+            // purged from the texture cache
+        }
+
+        entry->fCacheID = next_mask_cache_id();
+        cacheData.fClientCacheID = entry->fCacheID;
+        GrTexture* texture = fContext->createAndLockTexture(NULL, desc,
+                                                            cacheData,
+                                                            NULL, 0);
+        if (NULL == texture) {
+            entry->fCacheID = 0;
+            return NULL;
+        }
+        *cacheID = entry->fCacheID;
+        return texture;
+    }
+
+    // Paths animated by fractions of a pixel would fill the texture cache
+    // with masks that are never drawn again
+    if (fMaskEntries.count() >= kMaxMaskEntries) {
+        // its texture is left to the texture cache to purge
+        SkDELETE(fMaskEntries.top());
+        fMaskEntries.pop();
+    }
+    MaskEntry* entry = SkNEW(MaskEntry);
+    entry->fHash = hash;
+    entry->fPath = path;
+    entry->fFill = fill;
+    entry->fAntiAlias = antiAlias;
+    entry->fMatrix = matrix;
+    entry->fBounds = bounds;
+    entry->fCacheID = 0;
+    *fMaskEntries.insert(0) = entry;
+    return NULL;
+}
+
+void GrSoftwarePathRenderer::forgetMask(uint64_t cacheID) {
+    for (int i = 0; i < fMaskEntries.count(); ++i) {
+        if (cacheID == fMaskEntries[i]->fCacheID) {
+            fMaskEntries[i]->fCacheID = 0;
+            return;
+        }
+    }
+}
+
+// Rasterizes the path into texture, now or (if deferred) when the masks are
+// next prepared. Returns false if it can't. cacheID is that of the texture's
+// cache entry, or 0.
+bool GrSoftwarePathRenderer::renderMask(GrTexture* texture,
+                                        const SkPath& path,
+                                        GrPathFill fill,
+                                        bool antiAlias,
+                                        const GrMatrix& matrix,
+                                        const GrIRect& bounds,
+                                        uint64_t cacheID,
+                                        bool deferred) {
+    ++fMasksRendered;
+    if (deferred) {
+        MaskJob* job = SkNEW_ARGS(MaskJob, (fContext));
+        job->fPath = path;
+        job->fFill = fill;
+        job->fAntiAlias = antiAlias;
+        job->fMatrix = matrix;
+        job->fBounds = bounds;
+        job->fTexture = texture;
+        texture->ref();
+        job->fCacheID = cacheID;
+        *fJobs.append() = job;
+        return true;
+    }
+
+    GrSWMaskHelper helper(fContext);
+    if (!helper.init(bounds, &matrix)) {
+        return false;
+    }
+    helper.draw(path, SkRegion::kReplace_Op, fill, antiAlias, 0xFF);
+    helper.upload(texture);
+    return true;
+}
+
+void GrSoftwarePathRenderer::prepareMasks() {
+    if (0 == fJobs.count()) {
+        return;
+    }
+
+    // Starting threads costs about as much as rasterizing a small mask
+    static const int kMinParallelPixels = 128 * 128;
+    int pixels = 0;
+    for (int i = 0; i < fJobs.count(); ++i) {
+        pixels += fJobs[i]->fBounds.width() * fJobs[i]->fBounds.height();
+    }
+    int threadCount = 1;
+    if (pixels >= kMinParallelPixels) {
+        threadCount = SkMin32(SkThreadPool::NumCores(), fJobs.count());
+    }
+
+    SkThreadPool pool(threadCount);
+    for (int i = 0; i < fJobs.count(); ++i) {
+        pool.add(fJobs[i]);
+    }
+    pool.wait();
+
+    for (int i = 0; i < fJobs.count(); ++i) {
+        MaskJob* job = fJobs[i];
+        if (job->fSucceeded) {
+            job->fHelper.upload(job->fTexture);
+        } else if (0 != job->fCacheID) {
+            this->forgetMask(job->fCacheID);
+        }
+        SkDELETE(job);
+    }
+    fJobs.rewind();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // return true on success; false on failure
 bool GrSoftwarePathRenderer::onDrawPath(const SkPath& path,
@@ -123,6 +371,54 @@ bool GrSoftwarePathRenderer::onDrawPath(const SkPath& path,
         vm.postTranslate(translate->fX, translate->fY);
     }
 
+    // draws straight to the gpu need their masks now
+    bool deferred = fContext->isBuffered(target);
+    if (!deferred) {
+        this->prepareMasks();
+    }
+
+    if (!GrIsFillInverted(fill) && !vm.hasPerspective() &&
+        !path.getBounds().isEmpty()) {
+        // the mask is the same wherever the path is drawn, to the pixel
+        GrScalar left = SkScalarFloorToScalar(vm.getTranslateX());
+        GrScalar top = SkScalarFloorToScalar(vm.getTranslateY());
+        GrMatrix maskMatrix = vm;
+        maskMatrix.setTranslateX(vm.getTranslateX() - left);
+        maskMatrix.setTranslateY(vm.getTranslateY() - top);
+        GrRect maskSBounds;
+        maskMatrix.mapRect(&maskSBounds, path.getBounds());
+        GrIRect maskBounds;
+        maskSBounds.roundOut(&maskBounds);
+
+        if (!maskBounds.isEmpty() &&
+            maskBounds.width() <= kMaxCachedMaskSize &&
+            maskBounds.height() <= kMaxCachedMaskSize) {
+            uint64_t cacheID;
+            bool found;
+            GrTexture* texture = this->findCachedMask(path, fill, antiAlias,
+                                                      maskMatrix, maskBounds,
+                                                      &cacheID, &found);
+            if (NULL != texture) {
+                if (found) {
+                    ++fMasksFound;
+                } else if (!this->renderMask(texture, path, fill, antiAlias,
+                                             maskMatrix, maskBounds,
+                                             cacheID, deferred)) {
+                    this->forgetMask(cacheID);
+                    fContext->unlockTexture(texture);
+                    return false;
+                }
+                GrIRect devBounds = maskBounds;
+                devBounds.offset(SkScalarRoundToInt(left),
+                                 SkScalarRoundToInt(top));
+                GrSWMaskHelper::DrawToTargetWithPathMask(texture, target,
+                                                         devBounds);
+                fContext->unlockTexture(texture);
+                return true;
+            }
+        }
+    }
+
     GrIRect devPathBounds, devClipBounds;
     if (!get_path_and_clip_bounds(target, path, vm,
                                   &devPathBounds, &devClipBounds)) {
@@ -132,11 +428,15 @@ bool GrSoftwarePathRenderer::onDrawPath(const SkPath& path,
         return true;
     }
 
-    SkAutoTUnref<GrTexture> texture(
-            GrSWMaskHelper::DrawPathMaskToTexture(fContext, path,
-                                                  devPathBounds, fill,
-                                                  antiAlias, &vm));
-    if (NULL == texture) {
+    // Detached, the texture isn't returned to the cache (for another mask)
+    // until the draw is done with it
+    GrAutoScratchTexture ast(fContext, mask_desc(devPathBounds));
+    if (NULL == ast.texture()) {
+        return false;
+    }
+    SkAutoTUnref<GrTexture> texture(ast.detach());
+    if (!this->renderMask(texture, path, fill, antiAlias, vm, devPathBounds,
+                          0, deferred)) {
         return false;
     }
 
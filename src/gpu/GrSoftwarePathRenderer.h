@@ -9,25 +9,62 @@
 #ifndef GrSoftwarePathRenderer_DEFINED
 #define GrSoftwarePathRenderer_DEFINED
 
+#include "GrCacheID.h"
 #include "GrPathRenderer.h"
+#include "SkTDArray.h"
 
 class GrContext;
 class GrAutoScratchTexture;
+class GrTexture;
 
 /**
  * This class uses the software side to render a path to an SkBitmap and
  * then uploads the result to the gpu
+ *
+ * Masks of paths no bigger than kMaxCachedMaskSize that are drawn more than
+ * once are kept in the texture cache, keyed on the path and the matrix (less
+ * its whole pixel translation), so drawing the path again, e.g. as it
+ * scrolls, skips rasterizing it.
+ *
+ * Masks of draws that wait in the context's draw buffer are rasterized when
+ * the buffer is flushed, all together on as many threads as there are cores,
+ * and uploaded just before the draws are issued.
  */
 class GrSoftwarePathRenderer : public GrPathRenderer {
 public:
-    GrSoftwarePathRenderer(GrContext* context)
-        : fContext(context) {
-    }
+    GR_DECLARE_RESOURCE_CACHE_DOMAIN(GetMaskDomain)
+
+    GrSoftwarePathRenderer(GrContext* context);
+    virtual ~GrSoftwarePathRenderer();
 
     virtual bool canDrawPath(const SkPath& path,
                             GrPathFill fill,
                             const GrDrawTarget* target,
                             bool antiAlias) const SK_OVERRIDE;
+
+    /**
+     * Rasterizes and uploads the masks of the draws made since the last call.
+     * GrContext calls this before it flushes its draw buffer.
+     */
+    void prepareMasks();
+
+    /**
+     * The number of masks rasterized, and of masks found in the texture cache
+     * instead, since the last resetCounts().
+     */
+    int masksRendered() const { return fMasksRendered; }
+    int masksFound() const { return fMasksFound; }
+    void resetCounts() {
+        fMasksRendered = 0;
+        fMasksFound = 0;
+    }
+
+    enum {
+        kMaxCachedMaskSize = 256,
+        // the number of masks that can be found in the cache
+        kMaxMaskEntries = 64,
+    };
+
 protected:
     virtual bool onDrawPath(const SkPath& path,
                             GrPathFill fill,
@@ -36,7 +73,25 @@ protected:
                             bool antiAlias) SK_OVERRIDE;
 
 private:
-    GrContext*     fContext;
+    struct MaskEntry;
+    class MaskJob;
+
+    GrContext*              fContext;
+    // most recently used first
+    SkTDArray<MaskEntry*>   fMaskEntries;
+    // masks of buffered draws, waiting for prepareMasks()
+    SkTDArray<MaskJob*>     fJobs;
+    int                     fMasksRendered;
+    int                     fMasksFound;
+
+    GrTexture* findCachedMask(const SkPath& path, GrPathFill fill,
+                              bool antiAlias, const GrMatrix& matrix,
+                              const GrIRect& bounds, uint64_t* cacheID,
+                              bool* found);
+    bool renderMask(GrTexture* texture, const SkPath& path, GrPathFill fill,
+                    bool antiAlias, const GrMatrix& matrix,
+                    const GrIRect& bounds, uint64_t cacheID, bool deferred);
+    void forgetMask(uint64_t cacheID);
 
     typedef GrPathRenderer INHERITED;
 };
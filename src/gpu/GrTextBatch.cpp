@@ -0,0 +1,219 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "GrTextBatch.h"
+#include "GrContext.h"
+#include "GrDrawTarget.h"
+#include "GrGpuVertex.h"
+#include "GrIndexBuffer.h"
+#include "GrTexture.h"
+
+enum {
+    kGlyphMaskStage = GrPaint::kTotalStages,
+};
+
+enum {
+    kMinRequestedGlyphs      = 1,
+    kDefaultRequestedGlyphs  = 64,
+    kMinRequestedVerts       = kMinRequestedGlyphs * 4,
+    kDefaultRequestedVerts   = kDefaultRequestedGlyphs * 4,
+};
+
+GrTextBatch::GrTextBatch(GrContext* context)
+    : fContext(context)
+    , fDrawTarget(NULL)
+    , fActive(false)
+    , fHasState(false)
+    , fFlushing(false)
+    , fHasTextures(false)
+    , fVertices(NULL)
+    , fMaxVertices(0)
+    , fCurrVertex(0)
+    , fCurrTexture(NULL) {
+    fClipData.fClipStack = &fClipStack;
+    fVertexLayout =
+        GrDrawTarget::kTextFormat_VertexLayoutBit |
+        GrDrawTarget::StageTexCoordVertexLayoutBit(kGlyphMaskStage, 0);
+}
+
+GrTextBatch::~GrTextBatch() {
+    GrAssert(!fActive);
+    this->discard();
+}
+
+void GrTextBatch::begin(const GrPaint& paint) {
+    GrAssert(!fActive);
+    fActive = true;
+
+    GrDrawTarget* target = fContext->getTextTarget(paint);
+    GrDrawState* drawState = target->drawState();
+    const GrClipData* clipData = fContext->getClip();
+    GrAssert(NULL != clipData);
+
+    if (fHasState && (target != fDrawTarget ||
+                      fState != *drawState ||
+                      fClipData != *clipData)) {
+        this->flush();
+        this->releaseState();
+    }
+    if (!fHasState) {
+        fDrawTarget = target;
+        // assignment only copies enabled stages
+        fState.disableStages();
+        fState = *drawState;
+        if (NULL != clipData->fClipStack) {
+            fClipStack = *clipData->fClipStack;
+        } else {
+            fClipStack.reset();
+        }
+        fClipData.fOrigin = clipData->fOrigin;
+        fHasTextures = paint.hasTextureOrMask();
+        fHasState = true;
+    }
+
+    // the glyphs are drawn with fState when the batch is flushed
+    drawState->disableStages();
+}
+
+void GrTextBatch::end() {
+    GrAssert(fActive);
+    fActive = false;
+    // the paint's textures are only locked in the cache during the text draw
+    if (0 == fCurrVertex || fHasTextures) {
+        this->flush();
+    }
+}
+
+GrGpuTextVertex* GrTextBatch::reserveGlyph(GrTexture* texture) {
+    GrAssert(fActive && fHasState);
+    GrAssert(NULL != texture);
+
+    if (fCurrTexture != texture || fCurrVertex + 4 > fMaxVertices) {
+        this->flush();
+    }
+    if (NULL == fVertices) {
+        // reserving can flush the context, and so this batch
+        this->reserveVertices();
+        fCurrTexture = texture;
+        fCurrTexture->ref();
+    }
+
+    GrGpuTextVertex* vertices = &fVertices[2 * fCurrVertex];
+    fCurrVertex += 4;
+    return vertices;
+}
+
+void GrTextBatch::reserveVertices() {
+    // If we need to reserve vertices allow the draw target to suggest
+    // a number of verts to reserve and whether to perform a flush.
+    fMaxVertices = kMinRequestedVerts;
+    if (fDrawTarget->geometryHints(fVertexLayout, &fMaxVertices, NULL)) {
+        fContext->flush();
+    }
+    fMaxVertices = kDefaultRequestedVerts;
+    // ignore return, no point in flushing again.
+    fDrawTarget->geometryHints(fVertexLayout, &fMaxVertices, NULL);
+
+    int maxQuadVertices = 4 * fContext->getQuadIndexBuffer()->maxQuads();
+    if (fMaxVertices < kMinRequestedVerts) {
+        fMaxVertices = kDefaultRequestedVerts;
+    } else if (fMaxVertices > maxQuadVertices) {
+        // don't exceed the limit of the index buffer
+        fMaxVertices = maxQuadVertices;
+    }
+    bool success = fDrawTarget->reserveVertexAndIndexSpace(
+                                               fVertexLayout,
+                                               fMaxVertices,
+                                               0,
+                                               GrTCast<void**>(&fVertices),
+                                               NULL);
+    GrAlwaysAssert(success);
+}
+
+void GrTextBatch::flush() {
+    // drawing straight to the GPU can generate a clip mask, which flushes
+    // the context again
+    if (fFlushing) {
+        return;
+    }
+    if (fCurrVertex > 0) {
+        fFlushing = true;
+        GrAssert(fHasState);
+        GrAssert(GrIsALIGN4(fCurrVertex));
+        GrAssert(fCurrTexture);
+
+        GrDrawTarget::AutoStateRestore asr(fDrawTarget,
+                                           GrDrawTarget::kPreserve_ASRInit);
+        GrDrawTarget::AutoClipRestore acr(fDrawTarget);
+        fDrawTarget->setClip(&fClipData);
+
+        GrDrawState* drawState = fDrawTarget->drawState();
+        drawState->disableStages();
+        *drawState = fState;
+
+        // setup our sampler state for our text texture/atlas
+        drawState->sampler(kGlyphMaskStage)->reset(
+                                    SkShader::kRepeat_TileMode,
+                                    !fState.getViewMatrix().isIdentity());
+        drawState->createTextureEffect(kGlyphMaskStage, fCurrTexture);
+
+        if (!GrPixelConfigIsAlphaOnly(fCurrTexture->config())) {
+            bool hasTexture = false;
+            for (int t = 0; t < GrPaint::kMaxTextures; ++t) {
+                hasTexture |= fState.isStageEnabled(
+                                            GrPaint::kFirstTextureStage + t);
+            }
+            if (kOne_GrBlendCoeff != fState.getSrcBlendCoeff() ||
+                kISA_GrBlendCoeff != fState.getDstBlendCoeff() ||
+                hasTexture) {
+                GrPrintf("LCD Text will not draw correctly.\n");
+            }
+            // setup blend so that we get mask * paintColor + (1-mask)*dstColor
+            drawState->setBlendConstant(fState.getColor());
+            drawState->setBlendFunc(kConstC_GrBlendCoeff, kISC_GrBlendCoeff);
+            // don't modulate by the paint's color in the frag since we're
+            // already doing it via the blend const.
+            drawState->setColor(0xffffffff);
+        }
+
+        int nGlyphs = fCurrVertex / 4;
+        fDrawTarget->setIndexSourceToBuffer(fContext->getQuadIndexBuffer());
+        fDrawTarget->drawIndexedInstances(kTriangles_GrPrimitiveType,
+                                          nGlyphs,
+                                          4, 6);
+        drawState->disableStages();
+        fFlushing = false;
+    }
+    this->releaseVertices();
+    if (!fActive) {
+        this->releaseState();
+    }
+}
+
+void GrTextBatch::discard() {
+    this->releaseVertices();
+    this->releaseState();
+}
+
+void GrTextBatch::releaseVertices() {
+    if (NULL != fVertices) {
+        fDrawTarget->resetVertexSource();
+    }
+    fVertices = NULL;
+    fMaxVertices = 0;
+    fCurrVertex = 0;
+    GrSafeSetNull(fCurrTexture);
+}
+
+void GrTextBatch::releaseState() {
+    if (fHasState) {
+        fState.reset();
+        fClipStack.reset();
+        fHasState = false;
+    }
+}
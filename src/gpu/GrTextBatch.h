@@ -0,0 +1,95 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef GrTextBatch_DEFINED
+#define GrTextBatch_DEFINED
+
+#include "GrClipData.h"
+#include "GrDrawState.h"
+#include "GrNoncopyable.h"
+#include "SkClipStack.h"
+
+struct GrGpuTextVertex;
+class GrContext;
+class GrDrawTarget;
+class GrPaint;
+class GrTexture;
+
+/**
+ *  Collects the glyph quads of text draws into one vertex stream, so that a
+ *  run of text draws sharing a paint, matrix, clip and atlas texture is drawn
+ *  all at once. Each GrContext owns one; GrTextContext adds its glyphs to it.
+ *
+ *  Glyphs stay in the batch after the text draw that added them returns. The
+ *  batch keeps copies of the draw state and clip they were added under and
+ *  draws with those, so the context's state may change in between. The
+ *  context flushes the batch before any other draw and when it flushes.
+ */
+class GrTextBatch : public GrNoncopyable {
+public:
+    GrTextBatch(GrContext* context);
+    ~GrTextBatch();
+
+    /**
+     *  Starts adding the glyphs of a text draw with paint, under the
+     *  context's current matrix, render target and clip. If the glyphs
+     *  already in the batch were added under a different state they are
+     *  flushed first.
+     */
+    void begin(const GrPaint& paint);
+
+    /**
+     *  Ends the text draw started by begin(). Its glyphs remain in the batch,
+     *  unless its paint has textures (which may be reused once the draw is
+     *  done).
+     */
+    void end();
+
+    /**
+     *  Returns space for the four vertices (positions interleaved with atlas
+     *  coordinates) of a glyph drawn from texture. Only valid between begin()
+     *  and end().
+     */
+    GrGpuTextVertex* reserveGlyph(GrTexture* texture);
+
+    /**
+     *  Draws the glyphs in the batch.
+     */
+    void flush();
+
+    /**
+     *  Drops the glyphs in the batch without drawing them.
+     */
+    void discard();
+
+    int glyphCount() const { return fCurrVertex / 4; }
+
+private:
+    GrContext*          fContext;
+    GrDrawTarget*       fDrawTarget;
+    GrVertexLayout      fVertexLayout;
+
+    bool                fActive;    // between begin() and end()
+    bool                fHasState;  // fState and fClipData are set
+    bool                fFlushing;
+    bool                fHasTextures;   // the paint uses textures or masks
+    GrDrawState         fState;
+    SkClipStack         fClipStack;
+    GrClipData          fClipData;
+
+    GrGpuTextVertex*    fVertices;
+    int                 fMaxVertices;
+    int                 fCurrVertex;
+    GrTexture*          fCurrTexture;
+
+    void reserveVertices();
+    void releaseVertices();
+    void releaseState();
+};
+
+#endif
@@ -10,75 +10,21 @@
 #include "GrTextContext.h"
 #include "GrAtlas.h"
 #include "GrContext.h"
-#include "GrDrawTarget.h"
 #include "GrFontScaler.h"
 #include "GrGpuVertex.h"
-#include "GrIndexBuffer.h"
+#include "GrTextBatch.h"
 #include "GrTextStrike.h"
 #include "GrTextStrike_impl.h"
 #include "SkPath.h"
 
-enum {
-    kGlyphMaskStage = GrPaint::kTotalStages,
-};
-
-void GrTextContext::flushGlyphs() {
-    if (NULL == fDrawTarget) {
-        return;
-    }
-    GrDrawState* drawState = fDrawTarget->drawState();
-    if (fCurrVertex > 0) {
-        // setup our sampler state for our text texture/atlas
-        drawState->sampler(kGlyphMaskStage)->reset(SkShader::kRepeat_TileMode,
-                                                   !fExtMatrix.isIdentity());
-
-        GrAssert(GrIsALIGN4(fCurrVertex));
-        GrAssert(fCurrTexture);
-        drawState->createTextureEffect(kGlyphMaskStage, fCurrTexture);
-
-        if (!GrPixelConfigIsAlphaOnly(fCurrTexture->config())) {
-            if (kOne_GrBlendCoeff != fPaint.fSrcBlendCoeff ||
-                kISA_GrBlendCoeff != fPaint.fDstBlendCoeff ||
-                fPaint.hasTexture()) {
-                GrPrintf("LCD Text will not draw correctly.\n");
-            }
-            // setup blend so that we get mask * paintColor + (1-mask)*dstColor
-            drawState->setBlendConstant(fPaint.fColor);
-            drawState->setBlendFunc(kConstC_GrBlendCoeff, kISC_GrBlendCoeff);
-            // don't modulate by the paint's color in the frag since we're
-            // already doing it via the blend const.
-            drawState->setColor(0xffffffff);
-        } else {
-            // set back to normal in case we took LCD path previously.
-            drawState->setBlendFunc(fPaint.fSrcBlendCoeff,
-                                    fPaint.fDstBlendCoeff);
-            drawState->setColor(fPaint.fColor);
-        }
-
-        int nGlyphs = fCurrVertex / 4;
-        fDrawTarget->setIndexSourceToBuffer(fContext->getQuadIndexBuffer());
-        fDrawTarget->drawIndexedInstances(kTriangles_GrPrimitiveType,
-                                          nGlyphs,
-                                          4, 6);
-        fDrawTarget->resetVertexSource();
-        fVertices = NULL;
-        fMaxVertices = 0;
-        fCurrVertex = 0;
-        GrSafeSetNull(fCurrTexture);
-    }
-    drawState->disableStages();
-    fDrawTarget = NULL;
-}
-
 GrTextContext::GrTextContext(GrContext* context,
                              const GrPaint& paint,
                              const GrMatrix* extMatrix) : fPaint(paint) {
     fContext = context;
+    fBatch = context->getTextBatch();
+    fBatchBegun = false;
     fStrike = NULL;
 
-    fCurrTexture = NULL;
-    fCurrVertex = 0;
-
     if (NULL != extMatrix) {
         fExtMatrix = *extMatrix;
     } else {
@@ -136,27 +82,17 @@ GrTextContext::GrTextContext(GrContext* context,
             }
         }
     }
-
-    fDrawTarget = NULL;
-
-    fVertices = NULL;
-    fMaxVertices = 0;
-
-    fVertexLayout =
-        GrDrawTarget::kTextFormat_VertexLayoutBit |
-        GrDrawTarget::StageTexCoordVertexLayoutBit(kGlyphMaskStage, 0);
 }
 
 GrTextContext::~GrTextContext() {
-    this->flushGlyphs();
-    if (fDrawTarget) {
-        fDrawTarget->drawState()->disableStages();
+    if (fBatchBegun) {
+        fBatch->end();
     }
     fContext->setMatrix(fOrigViewMatrix);
 }
 
 void GrTextContext::flush() {
-    this->flushGlyphs();
+    fBatch->flush();
 }
 
 static inline void setRectFan(GrGpuTextVertex v[4], int l, int t, int r, int b,
@@ -202,7 +138,6 @@ void GrTextContext::drawPackedGlyph(GrGlyph::PackedID packed,
         }
 
         // before we purge the cache, we must flush any accumulated draws
-        this->flushGlyphs();
         fContext->flush();
 
         // try to purge
@@ -239,46 +174,11 @@ HAS_ATLAS:
     GrTexture* texture = glyph->fAtlas->texture();
     GrAssert(texture);
 
-    if (fCurrTexture != texture || fCurrVertex + 4 > fMaxVertices) {
-        this->flushGlyphs();
-        fCurrTexture = texture;
-        fCurrTexture->ref();
-    }
-
-    if (NULL == fVertices) {
-        // If we need to reserve vertices allow the draw target to suggest
-        // a number of verts to reserve and whether to perform a flush.
-        fMaxVertices = kMinRequestedVerts;
-        bool flush = (NULL != fDrawTarget) &&
-                     fDrawTarget->geometryHints(fVertexLayout,
-                                                &fMaxVertices,
-                                                NULL);
-        if (flush) {
-            this->flushGlyphs();
-            fContext->flush();
-        }
-        fDrawTarget = fContext->getTextTarget(fPaint);
-        fMaxVertices = kDefaultRequestedVerts;
-        // ignore return, no point in flushing again.
-        fDrawTarget->geometryHints(fVertexLayout,
-                                   &fMaxVertices,
-                                   NULL);
-
-        int maxQuadVertices = 4 * fContext->getQuadIndexBuffer()->maxQuads();
-        if (fMaxVertices < kMinRequestedVerts) {
-            fMaxVertices = kDefaultRequestedVerts;
-        } else if (fMaxVertices > maxQuadVertices) {
-            // don't exceed the limit of the index buffer
-            fMaxVertices = maxQuadVertices;
-        }
-        bool success = fDrawTarget->reserveVertexAndIndexSpace(
-                                                   fVertexLayout,
-                                                   fMaxVertices,
-                                                   0,
-                                                   GrTCast<void**>(&fVertices),
-                                                   NULL);
-        GrAlwaysAssert(success);
+    if (!fBatchBegun) {
+        fBatch->begin(fPaint);
+        fBatchBegun = true;
     }
+    GrGpuTextVertex* vertices = fBatch->reserveGlyph(texture);
 
     GrFixed tx = GrIntToFixed(glyph->fAtlasLocation.fX);
     GrFixed ty = GrIntToFixed(glyph->fAtlasLocation.fY);
@@ -289,22 +189,21 @@ HAS_ATLAS:
     int w = width >> 16;
     int h = height >> 16;
 
-    setRectFan(&fVertices[2*fCurrVertex], x, y, x + w, y + h, 2);
-    setRectFan(&fVertices[2*fCurrVertex+1],
+    setRectFan(&vertices[0], x, y, x + w, y + h, 2);
+    setRectFan(&vertices[1],
                texture->normalizeFixedX(tx),
                texture->normalizeFixedY(ty),
                texture->normalizeFixedX(tx + width),
                texture->normalizeFixedY(ty + height),
                2);
 #else
-    fVertices[2*fCurrVertex].setXRectFan(vx, vy, vx + width, vy + height,
-                                        2 * sizeof(GrGpuTextVertex));
-    fVertices[2*fCurrVertex+1].setXRectFan(texture->normalizeFixedX(tx),
-                                          texture->normalizeFixedY(ty),
-                                          texture->normalizeFixedX(tx + width),
-                                          texture->normalizeFixedY(ty + height),
-                                          2 * sizeof(GrGpuTextVertex));
+    vertices[0].setXRectFan(vx, vy, vx + width, vy + height,
+                            2 * sizeof(GrGpuTextVertex));
+    vertices[1].setXRectFan(texture->normalizeFixedX(tx),
+                            texture->normalizeFixedY(ty),
+                            texture->normalizeFixedX(tx + width),
+                            texture->normalizeFixedY(ty + height),
+                            2 * sizeof(GrGpuTextVertex));
 #endif
-    fCurrVertex += 4;
 }
 
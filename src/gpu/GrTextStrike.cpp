@@ -65,6 +65,7 @@ void GrFontCache::freeAll() {
 }
 
 void GrFontCache::purgeExceptFor(GrTextStrike* preserveStrike) {
+    bool freedAtlas = false;
     GrTextStrike* strike = fTail;
     while (strike) {
         if (strike == preserveStrike) {
@@ -73,13 +74,23 @@ void GrFontCache::purgeExceptFor(GrTextStrike* preserveStrike) {
         }
         GrTextStrike* strikeToPurge = strike;
         // keep going if we won't free up any atlases with this strike.
-        strike = (NULL == strikeToPurge->fAtlas) ? strikeToPurge->fPrev : NULL;
+        freedAtlas = (NULL != strikeToPurge->fAtlas);
+        strike = freedAtlas ? NULL : strikeToPurge->fPrev;
         int index = fCache.slowFindIndex(strikeToPurge);
         GrAssert(index >= 0);
         fCache.removeAt(index, strikeToPurge->fFontScalerKey->getHash());
         this->detachStrikeFromList(strikeToPurge);
         delete strikeToPurge;
     }
+
+    // If no other strike had any atlases and there are no plots left, the
+    // preserved strike holds every plot, most likely filled with glyphs it no
+    // longer draws (e.g. CJK text). Defragment it: drop its atlases, so that
+    // the glyphs it still uses are packed afresh as they are drawn.
+    if (!freedAtlas && NULL != preserveStrike && NULL != fAtlasMgr &&
+        !fAtlasMgr->hasFreePlot()) {
+        preserveStrike->purgeAtlases();
+    }
 }
 
 #if GR_DEBUG
@@ -157,6 +168,14 @@ GrTextStrike::~GrTextStrike() {
 #endif
 }
 
+static void ClearGlyphAtlas(GrGlyph*& glyph) { glyph->fAtlas = NULL; }
+
+void GrTextStrike::purgeAtlases() {
+    GrAtlas::FreeLList(fAtlas);
+    fAtlas = NULL;
+    fCache.getArray().visit(ClearGlyphAtlas);
+}
+
 GrGlyph* GrTextStrike::generateGlyph(GrGlyph::PackedID packed,
                                      GrFontScaler* scaler) {
     GrIRect bounds;
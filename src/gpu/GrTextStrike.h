@@ -66,6 +66,8 @@ private:
     GrGlyph* generateGlyph(GrGlyph::PackedID packed, GrFontScaler* scaler);
     // returns true if after the purge, the strike is empty
     bool purgeAtlasAtY(GrAtlas* atlas, int yCoord);
+    // frees all our atlases; glyphs are uploaded again when next drawn
+    void purgeAtlases();
 
     friend class GrFontCache;
 };
@@ -51,6 +51,12 @@ void GrFontCache::detachStrikeFromList(GrTextStrike* strike) {
 GrTextStrike* GrFontCache::getStrike(GrFontScaler* scaler) {
     this->validate();
 
+    // consecutive text draws are usually in the same font, whose strike is
+    // then already at the head of the list
+    if (NULL != fHead && *fHead->getFontScalerKey() == *scaler->getKey()) {
+        return fHead;
+    }
+
     Key key(scaler);
     GrTextStrike* strike = fCache.find(key);
     if (NULL == strike) {
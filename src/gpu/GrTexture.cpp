@@ -132,6 +132,12 @@ enum TextureBits {
      * texture.
      */
     kScratch_TextureBit         = 0x4,
+    /*
+     * The kRenderTarget bit is set if a texture that isn't a scratch texture
+     * is a render target, i.e. its contents are drawn by the GPU rather than
+     * uploaded.
+     */
+    kRenderTarget_TextureBit    = 0x8,
 };
 
 namespace {
@@ -178,6 +184,8 @@ void gen_texture_key_values(const GrGpu* gpu,
 
     if (scratch) {
         cacheID->fResourceSpecific16 |= kScratch_TextureBit;
+    } else if (desc.fFlags & kRenderTarget_GrTextureFlagBit) {
+        cacheID->fResourceSpecific16 |= kRenderTarget_TextureBit;
     }
 }
 }
@@ -203,6 +211,10 @@ bool GrTexture::IsScratchTexture(const GrResourceKey& key) {
     return 0 != (key.getValue32(3) & kScratch_TextureBit);
 }
 
+bool GrTexture::IsRenderTargetTexture(const GrResourceKey& key) {
+    return 0 != (key.getValue32(3) & kRenderTarget_TextureBit);
+}
+
 bool GrTexture::NeedsFiltering(const GrResourceKey& key) {
     return 0 != (key.getValue32(3) & kFilter_TextureBit);
 }
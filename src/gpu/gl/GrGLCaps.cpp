@@ -35,6 +35,7 @@ void GrGLCaps::reset() {
     fTexStorageSupport = false;
     fTextureRedSupport = false;
     fImagingSupport = false;
+    fProgramBinarySupport = false;
     fTwoFormatLimit = false;
 }
 
@@ -64,6 +65,7 @@ GrGLCaps& GrGLCaps::operator = (const GrGLCaps& caps) {
     fTexStorageSupport = caps.fTexStorageSupport;
     fTextureRedSupport = caps.fTextureRedSupport;
     fImagingSupport = caps.fImagingSupport;
+    fProgramBinarySupport = caps.fProgramBinarySupport;
     fTwoFormatLimit = caps.fTwoFormatLimit;
 
     return *this;
@@ -153,6 +155,17 @@ void GrGLCaps::init(const GrGLContextInfo& ctxInfo) {
     fImagingSupport = kDesktop_GrGLBinding == binding &&
                       ctxInfo.hasExtension("GL_ARB_imaging");
 
+    // ARB_get_program_binary is part of OpenGL 4.1. Drivers may support it
+    // and yet offer no binary formats.
+    if (NULL != gli->fGetProgramBinary && NULL != gli->fProgramBinary &&
+        ((kDesktop_GrGLBinding == binding && version >= GR_GL_VER(4,1)) ||
+         ctxInfo.hasExtension("GL_ARB_get_program_binary") ||
+         ctxInfo.hasExtension("GL_OES_get_program_binary"))) {
+        GrGLint formatCount = 0;
+        GR_GL_GetIntegerv(gli, GR_GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        fProgramBinarySupport = formatCount > 0;
+    }
+
     // ES 2 only guarantees RGBA/uchar + one other format/type combo for
     // ReadPixels. The other format has to checked at run-time since it
     // can change based on which render target is bound
@@ -414,6 +427,8 @@ void GrGLCaps::print() const {
              (fPackRowLengthSupport ? "YES": "NO"));
     GrPrintf("Pack Flip Y support: %s\n",
              (fPackFlipYSupport ? "YES": "NO"));
+    GrPrintf("Program binary support: %s\n",
+             (fProgramBinarySupport ? "YES": "NO"));
     GrPrintf("Two Format Limit: %s\n", (fTwoFormatLimit ? "YES": "NO"));
 }
 
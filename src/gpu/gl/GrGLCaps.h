@@ -216,6 +216,10 @@ public:
     /// Is GL_ARB_IMAGING supported
     bool imagingSupport() const { return fImagingSupport; }
 
+    /// Can linked programs be saved and reloaded with glGetProgramBinary and
+    /// glProgramBinary?
+    bool programBinarySupport() const { return fProgramBinarySupport; }
+
     // Does ReadPixels support the provided format/type combo?
     bool readPixelsSupported(const GrGLInterface* intf,
                              GrGLenum format,
@@ -292,6 +296,7 @@ private:
     bool fTexStorageSupport : 1;
     bool fTextureRedSupport : 1;
     bool fImagingSupport  : 1;
+    bool fProgramBinarySupport : 1;
     bool fTwoFormatLimit : 1;
 };
 
@@ -603,6 +603,12 @@
 #define GR_GL_SHADER_BINARY_FORMATS          0x8DF8
 #define GR_GL_NUM_SHADER_BINARY_FORMATS      0x8DF9
 
+/* Program Binary */
+#define GR_GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GR_GL_PROGRAM_BINARY_LENGTH          0x8741
+#define GR_GL_NUM_PROGRAM_BINARY_FORMATS     0x87FE
+#define GR_GL_PROGRAM_BINARY_FORMATS         0x87FF
+
 /* Shader Precision-Specified Types */
 #define GR_GL_LOW_FLOAT                      0x8DF0
 #define GR_GL_MEDIUM_FLOAT                   0x8DF1
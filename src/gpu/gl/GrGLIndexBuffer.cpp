@@ -20,7 +20,8 @@ GrGLIndexBuffer::GrGLIndexBuffer(GrGpuGL* gpu,
                                  bool dynamic)
     : INHERITED(gpu, sizeInBytes, dynamic)
     , fBufferID(id)
-    , fLockPtr(NULL) {
+    , fLockPtr(NULL)
+    , fGLSizeInBytes(sizeInBytes) {
 
 }
 
@@ -58,6 +59,7 @@ void* GrGLIndexBuffer::lock() {
                            NULL,
                            this->dynamic() ? GR_GL_DYNAMIC_DRAW :
                                              GR_GL_STATIC_DRAW));
+        fGLSizeInBytes = this->sizeInBytes();
         GR_GL_CALL_RET(GPUGL->glInterface(),
                        fLockPtr,
                        MapBuffer(GR_GL_ELEMENT_ARRAY_BUFFER,
@@ -127,7 +129,48 @@ bool GrGLIndexBuffer::updateData(const void* src, size_t srcSizeInBytes) {
     // portions of the buffer (lock() does a glBufferData(..size, NULL..))
     GL_CALL(BufferData(GR_GL_ELEMENT_ARRAY_BUFFER,
                        srcSizeInBytes, src, usage));
+    fGLSizeInBytes = srcSizeInBytes;
 #endif
     return true;
 }
 
+bool GrGLIndexBuffer::updateSubData(const void* src,
+                                    size_t srcSizeInBytes,
+                                    size_t offset) {
+    GrAssert(fBufferID);
+    GrAssert(!isLocked());
+    if (offset + srcSizeInBytes > this->sizeInBytes()) {
+        return false;
+    }
+    this->bind();
+    if (0 == offset) {
+        // Nothing before the data has to be kept. Let the driver drop the old
+        // contents, as updateData() does, but keep the size of the buffer.
+        GrGLenum usage = dynamic() ? GR_GL_DYNAMIC_DRAW : GR_GL_STATIC_DRAW;
+        if (this->sizeInBytes() == srcSizeInBytes) {
+            GL_CALL(BufferData(GR_GL_ELEMENT_ARRAY_BUFFER,
+                               srcSizeInBytes, src, usage));
+            fGLSizeInBytes = srcSizeInBytes;
+            return true;
+        }
+#if GR_GL_USE_BUFFER_DATA_NULL_HINT
+        bool discard = true;
+#else
+        // updateData() may have shrunk the storage. Growing it back loses
+        // nothing here.
+        bool discard = fGLSizeInBytes < srcSizeInBytes;
+#endif
+        if (discard) {
+            GL_CALL(BufferData(GR_GL_ELEMENT_ARRAY_BUFFER,
+                               this->sizeInBytes(), NULL, usage));
+            fGLSizeInBytes = this->sizeInBytes();
+        }
+    } else if (offset + srcSizeInBytes > fGLSizeInBytes) {
+        // updateData() shrank the storage. Growing it would drop the data
+        // before the offset, which the caller wants kept.
+        return false;
+    }
+    GL_CALL(BufferSubData(GR_GL_ELEMENT_ARRAY_BUFFER,
+                          offset, srcSizeInBytes, src));
+    return true;
+}
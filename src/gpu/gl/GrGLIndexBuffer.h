@@ -29,6 +29,9 @@ public:
     virtual void unlock();
     virtual bool isLocked() const;
     virtual bool updateData(const void* src, size_t srcSizeInBytes);
+    virtual bool updateSubData(const void* src,
+                               size_t srcSizeInBytes,
+                               size_t offset);
 
 protected:
     GrGLIndexBuffer(GrGpuGL* gpu,
@@ -45,6 +48,9 @@ private:
 
     GrGLuint     fBufferID;
     void*        fLockPtr;
+    // The size of the GL buffer's storage. Without
+    // GR_GL_USE_BUFFER_DATA_NULL_HINT updateData() shrinks it to the data.
+    size_t       fGLSizeInBytes;
 
     friend class GrGpuGL;
 
@@ -13,7 +13,6 @@
 #include "gl/GrGLShaderBuilder.h"
 #include "GrGLShaderVar.h"
 #include "GrProgramStageFactory.h"
-#include "SkTrace.h"
 #include "SkXfermode.h"
 
 SK_DEFINE_INST_COUNT(GrGLProgram)
@@ -21,8 +20,6 @@ SK_DEFINE_INST_COUNT(GrGLProgram)
 #define GL_CALL(X) GR_GL_CALL(fContextInfo.interface(), X)
 #define GL_CALL_RET(R, X) GR_GL_CALL_RET(fContextInfo.interface(), R, X)
 
-#define PRINT_SHADERS 0
-
 typedef GrGLProgram::Desc::StageDesc StageDesc;
 
 #define POS_ATTR_NAME "aPosition"
@@ -53,8 +50,9 @@ inline const char* dual_source_output_name() { return "dualSourceOut"; }
 
 GrGLProgram* GrGLProgram::Create(const GrGLContextInfo& gl,
                                  const Desc& desc,
-                                 const GrCustomStage** customStages) {
-    GrGLProgram* program = SkNEW_ARGS(GrGLProgram, (gl, desc, customStages));
+                                 const GrCustomStage** customStages,
+                                 GrGLProgramStore* store) {
+    GrGLProgram* program = SkNEW_ARGS(GrGLProgram, (gl, desc, customStages, store));
     if (!program->succeeded()) {
         delete program;
         program = NULL;
@@ -64,13 +62,11 @@ GrGLProgram* GrGLProgram::Create(const GrGLContextInfo& gl,
 
 GrGLProgram::GrGLProgram(const GrGLContextInfo& gl,
                          const Desc& desc,
-                         const GrCustomStage** customStages)
+                         const GrCustomStage** customStages,
+                         GrGLProgramStore* store)
 : fContextInfo(gl)
 , fUniformManager(gl) {
     fDesc = desc;
-    fVShaderID = 0;
-    fGShaderID = 0;
-    fFShaderID = 0;
     fProgramID = 0;
 
     fViewMatrix = GrMatrix::InvalidMatrix();
@@ -85,19 +81,10 @@ GrGLProgram::GrGLProgram(const GrGLContextInfo& gl,
         fTextureOrientation[s] = GrGLTexture::kBottomUp_Orientation;
     }
 
-    this->genProgram(customStages);
+    this->genProgram(customStages, store);
 }
 
 GrGLProgram::~GrGLProgram() {
-    if (fVShaderID) {
-        GL_CALL(DeleteShader(fVShaderID));
-    }
-    if (fGShaderID) {
-        GL_CALL(DeleteShader(fGShaderID));
-    }
-    if (fFShaderID) {
-        GL_CALL(DeleteShader(fFShaderID));
-    }
     if (fProgramID) {
         GL_CALL(DeleteProgram(fProgramID));
     }
@@ -108,9 +95,6 @@ GrGLProgram::~GrGLProgram() {
 }
 
 void GrGLProgram::abandon() {
-    fVShaderID = 0;
-    fGShaderID = 0;
-    fFShaderID = 0;
     fProgramID = 0;
 }
 
@@ -397,110 +381,8 @@ const char* GrGLProgram::adjustInColor(const SkString& inColor) const {
     }
 }
 
-namespace {
-// prints a shader using params similar to glShaderSource
-void print_shader(GrGLint stringCnt,
-                  const GrGLchar** strings,
-                  GrGLint* stringLengths) {
-    for (int i = 0; i < stringCnt; ++i) {
-        if (NULL == stringLengths || stringLengths[i] < 0) {
-            GrPrintf(strings[i]);
-        } else {
-            GrPrintf("%.*s", stringLengths[i], strings[i]);
-        }
-    }
-}
-
-// Compiles a GL shader, returns shader ID or 0 if failed params have same meaning as glShaderSource
-GrGLuint compile_shader(const GrGLContextInfo& gl,
-                        GrGLenum type,
-                        int stringCnt,
-                        const char** strings,
-                        int* stringLengths) {
-    SK_TRACE_EVENT1("GrGLProgram::CompileShader",
-                    "stringCount", SkStringPrintf("%i", stringCnt).c_str());
-
-    GrGLuint shader;
-    GR_GL_CALL_RET(gl.interface(), shader, CreateShader(type));
-    if (0 == shader) {
-        return 0;
-    }
-
-    const GrGLInterface* gli = gl.interface();
-    GrGLint compiled = GR_GL_INIT_ZERO;
-    GR_GL_CALL(gli, ShaderSource(shader, stringCnt, strings, stringLengths));
-    GR_GL_CALL(gli, CompileShader(shader));
-    GR_GL_CALL(gli, GetShaderiv(shader, GR_GL_COMPILE_STATUS, &compiled));
-
-    if (!compiled) {
-        GrGLint infoLen = GR_GL_INIT_ZERO;
-        GR_GL_CALL(gli, GetShaderiv(shader, GR_GL_INFO_LOG_LENGTH, &infoLen));
-        SkAutoMalloc log(sizeof(char)*(infoLen+1)); // outside if for debugger
-        if (infoLen > 0) {
-            // retrieve length even though we don't need it to workaround bug in chrome cmd buffer
-            // param validation.
-            GrGLsizei length = GR_GL_INIT_ZERO;
-            GR_GL_CALL(gli, GetShaderInfoLog(shader, infoLen+1,
-                                             &length, (char*)log.get()));
-            print_shader(stringCnt, strings, stringLengths);
-            GrPrintf("\n%s", log.get());
-        }
-        GrAssert(!"Shader compilation failed!");
-        GR_GL_CALL(gli, DeleteShader(shader));
-        return 0;
-    }
-    return shader;
-}
-
-// helper version of above for when shader is already flattened into a single SkString
-GrGLuint compile_shader(const GrGLContextInfo& gl, GrGLenum type, const SkString& shader) {
-    const GrGLchar* str = shader.c_str();
-    int length = shader.size();
-    return compile_shader(gl, type, 1, &str, &length);
-}
-
-}
-
-// compiles all the shaders from builder and stores the shader IDs
-bool GrGLProgram::compileShaders(const GrGLShaderBuilder& builder) {
-
-    SkString shader;
-
-    builder.getShader(GrGLShaderBuilder::kVertex_ShaderType, &shader);
-#if PRINT_SHADERS
-    GrPrintf(shader.c_str());
-    GrPrintf("\n");
-#endif
-    if (!(fVShaderID = compile_shader(fContextInfo, GR_GL_VERTEX_SHADER, shader))) {
-        return false;
-    }
-
-    if (builder.fUsesGS) {
-        builder.getShader(GrGLShaderBuilder::kGeometry_ShaderType, &shader);
-#if PRINT_SHADERS
-        GrPrintf(shader.c_str());
-        GrPrintf("\n");
-#endif
-        if (!(fGShaderID = compile_shader(fContextInfo, GR_GL_GEOMETRY_SHADER, shader))) {
-            return false;
-        }
-    } else {
-        fGShaderID = 0;
-    }
-
-    builder.getShader(GrGLShaderBuilder::kFragment_ShaderType, &shader);
-#if PRINT_SHADERS
-    GrPrintf(shader.c_str());
-    GrPrintf("\n");
-#endif
-    if (!(fFShaderID = compile_shader(fContextInfo, GR_GL_FRAGMENT_SHADER, shader))) {
-        return false;
-    }
-
-    return true;
-}
-
-bool GrGLProgram::genProgram(const GrCustomStage** customStages) {
+bool GrGLProgram::genProgram(const GrCustomStage** customStages,
+                             GrGLProgramStore* store) {
     GrAssert(0 == fProgramID);
 
     GrGLShaderBuilder builder(fContextInfo, fUniformManager);
@@ -823,13 +705,14 @@ bool GrGLProgram::genProgram(const GrCustomStage** customStages) {
     ///////////////////////////////////////////////////////////////////////////
     // compile and setup attribs and unis
 
-    if (!this->compileShaders(builder)) {
-        return false;
+    GrGLProgramStore::Source source;
+    this->getSource(builder, texCoordAttrs, isColorDeclared, dualSourceOutputWritten, &source);
+    if (NULL != store) {
+        fProgramID = store->createProgram(source);
+    } else {
+        fProgramID = GrGLProgramStore::CompileAndLink(fContextInfo, source);
     }
-
-    if (!this->bindOutputsAttribsAndLinkProgram(texCoordAttrs,
-                                                isColorDeclared,
-                                                dualSourceOutputWritten)) {
+    if (!fProgramID) {
         return false;
     }
 
@@ -839,65 +722,34 @@ bool GrGLProgram::genProgram(const GrCustomStage** customStages) {
     return true;
 }
 
-bool GrGLProgram::bindOutputsAttribsAndLinkProgram(SkString texCoordAttrNames[],
-                                                   bool bindColorOut,
-                                                   bool bindDualSrcOut) {
-    GL_CALL_RET(fProgramID, CreateProgram());
-    if (!fProgramID) {
-        return false;
-    }
-
-    GL_CALL(AttachShader(fProgramID, fVShaderID));
-    if (fGShaderID) {
-        GL_CALL(AttachShader(fProgramID, fGShaderID));
+void GrGLProgram::getSource(const GrGLShaderBuilder& builder,
+                            const SkString texCoordAttrNames[],
+                            bool bindColorOut,
+                            bool bindDualSrcOut,
+                            GrGLProgramStore::Source* source) const {
+    builder.getShader(GrGLShaderBuilder::kVertex_ShaderType, &source->fVertexShader);
+    if (builder.fUsesGS) {
+        builder.getShader(GrGLShaderBuilder::kGeometry_ShaderType, &source->fGeometryShader);
     }
-    GL_CALL(AttachShader(fProgramID, fFShaderID));
+    builder.getShader(GrGLShaderBuilder::kFragment_ShaderType, &source->fFragmentShader);
 
     if (bindColorOut) {
-        GL_CALL(BindFragDataLocation(fProgramID, 0, declared_color_output_name()));
+        source->fColorOutputName = declared_color_output_name();
     }
     if (bindDualSrcOut) {
-        GL_CALL(BindFragDataLocationIndexed(fProgramID, 0, 1, dual_source_output_name()));
+        source->fDualSourceOutputName = dual_source_output_name();
     }
 
     // Bind the attrib locations to same values for all shaders
-    GL_CALL(BindAttribLocation(fProgramID, PositionAttributeIdx(), POS_ATTR_NAME));
+    SkTArray<SkString>& attribNames = source->fAttribNames;
+    attribNames.push_back_n(EdgeAttributeIdx() + 1);
+    attribNames[PositionAttributeIdx()] = POS_ATTR_NAME;
     for (int t = 0; t < GrDrawState::kMaxTexCoords; ++t) {
-        if (texCoordAttrNames[t].size()) {
-            GL_CALL(BindAttribLocation(fProgramID,
-                                       TexCoordAttributeIdx(t),
-                                       texCoordAttrNames[t].c_str()));
-        }
+        attribNames[TexCoordAttributeIdx(t)] = texCoordAttrNames[t];
     }
-
-    GL_CALL(BindAttribLocation(fProgramID, ColorAttributeIdx(), COL_ATTR_NAME));
-    GL_CALL(BindAttribLocation(fProgramID, CoverageAttributeIdx(), COV_ATTR_NAME));
-    GL_CALL(BindAttribLocation(fProgramID, EdgeAttributeIdx(), EDGE_ATTR_NAME));
-
-    GL_CALL(LinkProgram(fProgramID));
-
-    GrGLint linked = GR_GL_INIT_ZERO;
-    GL_CALL(GetProgramiv(fProgramID, GR_GL_LINK_STATUS, &linked));
-    if (!linked) {
-        GrGLint infoLen = GR_GL_INIT_ZERO;
-        GL_CALL(GetProgramiv(fProgramID, GR_GL_INFO_LOG_LENGTH, &infoLen));
-        SkAutoMalloc log(sizeof(char)*(infoLen+1));  // outside if for debugger
-        if (infoLen > 0) {
-            // retrieve length even though we don't need it to workaround
-            // bug in chrome cmd buffer param validation.
-            GrGLsizei length = GR_GL_INIT_ZERO;
-            GL_CALL(GetProgramInfoLog(fProgramID,
-                                      infoLen+1,
-                                      &length,
-                                      (char*)log.get()));
-            GrPrintf((char*)log.get());
-        }
-        GrAssert(!"Error linking program");
-        GL_CALL(DeleteProgram(fProgramID));
-        fProgramID = 0;
-        return false;
-    }
-    return true;
+    attribNames[ColorAttributeIdx()] = COL_ATTR_NAME;
+    attribNames[CoverageAttributeIdx()] = COV_ATTR_NAME;
+    attribNames[EdgeAttributeIdx()] = EDGE_ATTR_NAME;
 }
 
 void GrGLProgram::initSamplerUniforms() {
@@ -11,6 +11,7 @@
 
 #include "GrDrawState.h"
 #include "GrGLContextInfo.h"
+#include "GrGLProgramStore.h"
 #include "GrGLSL.h"
 #include "GrGLTexture.h"
 #include "GrGLUniformManager.h"
@@ -41,9 +42,14 @@ public:
 
     struct Desc;
 
+    /**
+     * Builds the program for desc. If store is not NULL the GL program is
+     * taken from it, rather than compiled, when it has a match.
+     */
     static GrGLProgram* Create(const GrGLContextInfo& gl,
                                const Desc& desc,
-                               const GrCustomStage** customStages);
+                               const GrCustomStage** customStages,
+                               GrGLProgramStore* store = NULL);
 
     virtual ~GrGLProgram();
 
@@ -198,14 +204,16 @@ public:
 private:
     GrGLProgram(const GrGLContextInfo& gl,
                 const Desc& desc,
-                const GrCustomStage** customStages);
+                const GrCustomStage** customStages,
+                GrGLProgramStore* store);
 
     bool succeeded() const { return 0 != fProgramID; }
 
     /**
      *  This is the heavy initilization routine for building a GLProgram.
      */
-    bool genProgram(const GrCustomStage** customStages);
+    bool genProgram(const GrCustomStage** customStages,
+                    GrGLProgramStore* store);
 
     void genInputColor(GrGLShaderBuilder* builder, SkString* inColor);
 
@@ -227,16 +235,16 @@ private:
     // coverageVar is set to an empty string.
     bool genEdgeCoverage(SkString* coverageVar, GrGLShaderBuilder* builder) const;
 
-    // Creates a GL program ID, binds shader attributes to GL vertex attrs, and links the program
-    bool bindOutputsAttribsAndLinkProgram(SkString texCoordAttrNames[GrDrawState::kMaxTexCoords],
-                                          bool bindColorOut,
-                                          bool bindDualSrcOut);
+    // Gets the shaders from builder, and the names to bind to the attribute and output locations
+    void getSource(const GrGLShaderBuilder& builder,
+                   const SkString texCoordAttrNames[GrDrawState::kMaxTexCoords],
+                   bool bindColorOut,
+                   bool bindDualSrcOut,
+                   GrGLProgramStore::Source* source) const;
 
     // Sets the texture units for samplers
     void initSamplerUniforms();
 
-    bool compileShaders(const GrGLShaderBuilder& builder);
-
     const char* adjustInColor(const SkString& inColor) const;
 
     struct StageUniforms {
@@ -266,9 +274,6 @@ private:
     };
 
     // IDs
-    GrGLuint    fVShaderID;
-    GrGLuint    fGShaderID;
-    GrGLuint    fFShaderID;
     GrGLuint    fProgramID;
 
     // The matrix sent to GL is determined by both the client's matrix and
@@ -0,0 +1,646 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "GrGLProgramStore.h"
+
+#include "GrGLUtil.h"
+#include "SkChecksum.h"
+#include "SkOSFile.h"
+#include "SkStream.h"
+#include "SkTemplates.h"
+#include "SkTrace.h"
+
+#include <stdio.h>
+
+#define GL_CALL(X) GR_GL_CALL(fGL.interface(), X)
+#define GL_CALL_RET(R, X) GR_GL_CALL_RET(fGL.interface(), R, X)
+
+#define PRINT_SHADERS 0
+
+/*  The file is a header followed by its payload, all in 32 bit words:
+
+        driver string
+        for each program:
+            hash, binary format, binary length
+            vertex, geometry and fragment shaders
+            color output name, dual source output name
+            attribute count, attribute names
+            binary
+
+    Strings are a length followed by their characters, and strings and
+    binaries are padded to a multiple of 4 bytes.
+ */
+static const uint32_t kMagic = 0x47725053;  // 'GrPS'
+static const uint32_t kVersion = 1;
+
+struct StoreHeader {
+    uint32_t    fMagic;
+    uint32_t    fVersion;
+    uint32_t    fLength;        // of the payload
+    uint32_t    fChecksum;      // of the payload
+    uint32_t    fCount;         // of programs
+};
+
+// Shaders and binaries larger than this, or programs with more attributes,
+// are taken to be corrupt.
+static const uint32_t kMaxFieldLength = 16 * 1024 * 1024;
+static const uint32_t kMaxAttribCount = 256;
+
+namespace {
+
+// Reads the payload of a store, failing (rather than reading past the end)
+// if it is shorter than it claims.
+class StoreReader {
+public:
+    StoreReader(const void* data, size_t length)
+        : fCurr((const uint8_t*)data)
+        , fStop((const uint8_t*)data + length)
+        , fOK(true) {}
+
+    bool ok() const { return fOK; }
+    bool eof() const { return fCurr == fStop; }
+
+    uint32_t readU32() {
+        uint32_t value = 0;
+        const void* src = this->skip(sizeof(value));
+        if (src) {
+            memcpy(&value, src, sizeof(value));
+        }
+        return value;
+    }
+
+    const void* readBytes(uint32_t length) {
+        if (length > kMaxFieldLength) {
+            fOK = false;
+            return NULL;
+        }
+        return this->skip(SkAlign4(length));
+    }
+
+    void readString(SkString* str) {
+        uint32_t length = this->readU32();
+        const void* chars = this->readBytes(length);
+        if (chars) {
+            str->set((const char*)chars, length);
+        }
+    }
+
+private:
+    const uint8_t*  fCurr;
+    const uint8_t*  fStop;
+    bool            fOK;
+
+    const void* skip(size_t length) {
+        if (!fOK || (size_t)(fStop - fCurr) < length) {
+            fOK = false;
+            return NULL;
+        }
+        const void* result = fCurr;
+        fCurr += length;
+        return result;
+    }
+};
+
+void write_bytes(SkWStream* stream, const void* data, uint32_t length) {
+    static const uint8_t kPad[4] = { 0, 0, 0, 0 };
+    stream->write(data, length);
+    stream->write(kPad, SkAlign4(length) - length);
+}
+
+void write_string(SkWStream* stream, const SkString& str) {
+    stream->write32(str.size());
+    write_bytes(stream, str.c_str(), str.size());
+}
+
+// Identifies the driver, whose binaries (and maybe compiler) only work with
+// itself.
+void get_driver(const GrGLContextInfo& gl, SkString* driver) {
+    static const GrGLenum kStrings[] = {
+        GR_GL_VENDOR, GR_GL_RENDERER, GR_GL_VERSION
+    };
+    for (size_t i = 0; i < GR_ARRAY_COUNT(kStrings); ++i) {
+        const GrGLubyte* str;
+        GR_GL_CALL_RET(gl.interface(), str, GetString(kStrings[i]));
+        if (i > 0) {
+            driver->append("\n");
+        }
+        if (NULL != str) {
+            driver->append((const char*)str);
+        }
+    }
+}
+
+// prints a shader using params similar to glShaderSource
+void print_shader(GrGLint stringCnt,
+                  const GrGLchar** strings,
+                  GrGLint* stringLengths) {
+    for (int i = 0; i < stringCnt; ++i) {
+        if (NULL == stringLengths || stringLengths[i] < 0) {
+            GrPrintf(strings[i]);
+        } else {
+            GrPrintf("%.*s", stringLengths[i], strings[i]);
+        }
+    }
+}
+
+// Compiles a GL shader, returns shader ID or 0 if failed params have same meaning as glShaderSource
+GrGLuint compile_shader(const GrGLContextInfo& gl,
+                        GrGLenum type,
+                        int stringCnt,
+                        const char** strings,
+                        int* stringLengths) {
+    SK_TRACE_EVENT1("GrGLProgram::CompileShader",
+                    "stringCount", SkStringPrintf("%i", stringCnt).c_str());
+
+    GrGLuint shader;
+    GR_GL_CALL_RET(gl.interface(), shader, CreateShader(type));
+    if (0 == shader) {
+        return 0;
+    }
+
+    const GrGLInterface* gli = gl.interface();
+    GrGLint compiled = GR_GL_INIT_ZERO;
+    GR_GL_CALL(gli, ShaderSource(shader, stringCnt, strings, stringLengths));
+    GR_GL_CALL(gli, CompileShader(shader));
+    GR_GL_CALL(gli, GetShaderiv(shader, GR_GL_COMPILE_STATUS, &compiled));
+
+    if (!compiled) {
+        GrGLint infoLen = GR_GL_INIT_ZERO;
+        GR_GL_CALL(gli, GetShaderiv(shader, GR_GL_INFO_LOG_LENGTH, &infoLen));
+        SkAutoMalloc log(sizeof(char)*(infoLen+1)); // outside if for debugger
+        if (infoLen > 0) {
+            // retrieve length even though we don't need it to workaround bug in chrome cmd buffer
+            // param validation.
+            GrGLsizei length = GR_GL_INIT_ZERO;
+            GR_GL_CALL(gli, GetShaderInfoLog(shader, infoLen+1,
+                                             &length, (char*)log.get()));
+            print_shader(stringCnt, strings, stringLengths);
+            GrPrintf("\n%s", log.get());
+        }
+        GrAssert(!"Shader compilation failed!");
+        GR_GL_CALL(gli, DeleteShader(shader));
+        return 0;
+    }
+    return shader;
+}
+
+// helper version of above for when shader is already flattened into a single SkString
+GrGLuint compile_shader(const GrGLContextInfo& gl, GrGLenum type, const SkString& shader) {
+#if PRINT_SHADERS
+    GrPrintf(shader.c_str());
+    GrPrintf("\n");
+#endif
+    const GrGLchar* str = shader.c_str();
+    int length = shader.size();
+    return compile_shader(gl, type, 1, &str, &length);
+}
+
+// Returns whether programID linked, printing the log if it didn't.
+bool check_link_status(const GrGLContextInfo& gl, GrGLuint programID) {
+    const GrGLInterface* gli = gl.interface();
+    GrGLint linked = GR_GL_INIT_ZERO;
+    GR_GL_CALL(gli, GetProgramiv(programID, GR_GL_LINK_STATUS, &linked));
+    if (!linked) {
+        GrGLint infoLen = GR_GL_INIT_ZERO;
+        GR_GL_CALL(gli, GetProgramiv(programID, GR_GL_INFO_LOG_LENGTH, &infoLen));
+        SkAutoMalloc log(sizeof(char)*(infoLen+1));  // outside if for debugger
+        if (infoLen > 0) {
+            // retrieve length even though we don't need it to workaround
+            // bug in chrome cmd buffer param validation.
+            GrGLsizei length = GR_GL_INIT_ZERO;
+            GR_GL_CALL(gli, GetProgramInfoLog(programID,
+                                              infoLen+1,
+                                              &length,
+                                              (char*)log.get()));
+            GrPrintf((char*)log.get());
+        }
+    }
+    return SkToBool(linked);
+}
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GrGLProgramStore::Source::operator ==(const Source& source) const {
+    if (fAttribNames.count() != source.fAttribNames.count()) {
+        return false;
+    }
+    for (int i = 0; i < fAttribNames.count(); ++i) {
+        if (fAttribNames[i] != source.fAttribNames[i]) {
+            return false;
+        }
+    }
+    return fVertexShader == source.fVertexShader &&
+           fGeometryShader == source.fGeometryShader &&
+           fFragmentShader == source.fFragmentShader &&
+           fColorOutputName == source.fColorOutputName &&
+           fDualSourceOutputName == source.fDualSourceOutputName;
+}
+
+// One-at-a-time hash of the strings, each followed by a 0.
+static uint32_t hash_string(uint32_t hash, const SkString& str) {
+    const char* chars = str.c_str();
+    for (size_t i = 0; i <= str.size(); ++i) {
+        hash += (uint8_t)chars[i];
+        hash += hash << 10;
+        hash ^= hash >> 6;
+    }
+    return hash;
+}
+
+uint32_t GrGLProgramStore::Source::hash() const {
+    uint32_t hash = 0;
+    hash = hash_string(hash, fVertexShader);
+    hash = hash_string(hash, fGeometryShader);
+    hash = hash_string(hash, fFragmentShader);
+    hash = hash_string(hash, fColorOutputName);
+    hash = hash_string(hash, fDualSourceOutputName);
+    for (int i = 0; i < fAttribNames.count(); ++i) {
+        hash = hash_string(hash, fAttribNames[i]);
+    }
+    hash += hash << 3;
+    hash ^= hash >> 11;
+    hash += hash << 15;
+    return hash;
+}
+
+GrGLuint GrGLProgramStore::CompileAndLink(const GrGLContextInfo& gl,
+                                          const Source& source,
+                                          bool retrievable) {
+    const GrGLInterface* gli = gl.interface();
+
+    static const GrGLenum kTypes[] = {
+        GR_GL_VERTEX_SHADER, GR_GL_GEOMETRY_SHADER, GR_GL_FRAGMENT_SHADER
+    };
+    const SkString* shaders[] = {
+        &source.fVertexShader, &source.fGeometryShader, &source.fFragmentShader
+    };
+    GrGLuint shaderIDs[GR_ARRAY_COUNT(kTypes)];
+    int shaderCount = 0;
+    bool compiled = true;
+    for (size_t i = 0; i < GR_ARRAY_COUNT(kTypes) && compiled; ++i) {
+        if (GR_GL_GEOMETRY_SHADER == kTypes[i] && shaders[i]->isEmpty()) {
+            continue;
+        }
+        GrGLuint shaderID = compile_shader(gl, kTypes[i], *shaders[i]);
+        if (shaderID) {
+            shaderIDs[shaderCount++] = shaderID;
+        } else {
+            compiled = false;
+        }
+    }
+
+    GrGLuint programID = 0;
+    if (compiled) {
+        GR_GL_CALL_RET(gli, programID, CreateProgram());
+    }
+    if (programID) {
+        for (int i = 0; i < shaderCount; ++i) {
+            GR_GL_CALL(gli, AttachShader(programID, shaderIDs[i]));
+        }
+
+        if (source.fColorOutputName.size()) {
+            GR_GL_CALL(gli, BindFragDataLocation(programID, 0,
+                                                 source.fColorOutputName.c_str()));
+        }
+        if (source.fDualSourceOutputName.size()) {
+            GR_GL_CALL(gli, BindFragDataLocationIndexed(programID, 0, 1,
+                                        source.fDualSourceOutputName.c_str()));
+        }
+        for (int i = 0; i < source.fAttribNames.count(); ++i) {
+            if (source.fAttribNames[i].size()) {
+                GR_GL_CALL(gli, BindAttribLocation(programID, i,
+                                                   source.fAttribNames[i].c_str()));
+            }
+        }
+
+        if (retrievable && NULL != gli->fProgramParameteri) {
+            GR_GL_CALL(gli, ProgramParameteri(programID,
+                                              GR_GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                              GR_GL_TRUE));
+        }
+        GR_GL_CALL(gli, LinkProgram(programID));
+
+        if (!check_link_status(gl, programID)) {
+            GrAssert(!"Error linking program");
+            GR_GL_CALL(gli, DeleteProgram(programID));
+            programID = 0;
+        }
+    }
+
+    // The shaders are only needed for linking. Once deleted they're freed
+    // along with the program.
+    for (int i = 0; i < shaderCount; ++i) {
+        GR_GL_CALL(gli, DeleteShader(shaderIDs[i]));
+    }
+    return programID;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+GrGLProgramStore::GrGLProgramStore(const GrGLContextInfo& gl,
+                                   const char path[])
+    : fGL(gl)
+    , fPath(path)
+    , fCurrLRUStamp(0) {
+    memset(&fStats, 0, sizeof(fStats));
+    get_driver(gl, &fDriver);
+    this->read();
+
+    SK_TRACE_EVENT0("GrGLProgramStore::prewarm");
+    bool binarySupport = fGL.caps().programBinarySupport();
+    for (int i = 0; i < fEntries.count(); ++i) {
+        Entry* entry = fEntries[i];
+        if (entry->fBinary.count()) {
+            entry->fProgramID = this->linkBinary(*entry);
+        }
+        if (0 == entry->fProgramID) {
+            entry->fProgramID = CompileAndLink(fGL, entry->fSource,
+                                               binarySupport);
+            if (entry->fProgramID) {
+                this->retrieveBinary(entry->fProgramID, entry);
+            }
+        }
+        if (entry->fProgramID) {
+            ++fStats.fPrewarmed;
+        }
+    }
+}
+
+GrGLProgramStore::~GrGLProgramStore() {
+    for (int i = 0; i < fEntries.count(); ++i) {
+        if (fEntries[i]->fProgramID) {
+            GL_CALL(DeleteProgram(fEntries[i]->fProgramID));
+        }
+    }
+    fEntries.deleteAll();
+}
+
+void GrGLProgramStore::abandon() {
+    for (int i = 0; i < fEntries.count(); ++i) {
+        fEntries[i]->fProgramID = 0;
+    }
+}
+
+void GrGLProgramStore::read() {
+    SkFILEStream file(fPath.c_str());
+    if (!file.isValid()) {
+        return;
+    }
+    size_t length = file.getLength();
+    SkAutoMalloc storage(length);
+    if (file.read(storage.get(), length) != length ||
+        !this->parse(storage.get(), length)) {
+        fEntries.deleteAll();
+        fEntries.reset();
+    }
+    fStats.fLoaded = fEntries.count();
+}
+
+bool GrGLProgramStore::parse(const void* data, size_t length) {
+    StoreHeader header;
+    if (length < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    const uint32_t* payload = (const uint32_t*)((const char*)data +
+                                                sizeof(header));
+    if (kMagic != header.fMagic || kVersion != header.fVersion ||
+        length - sizeof(header) != header.fLength ||
+        !SkIsAlign4(header.fLength) ||
+        SkChecksum::Compute(payload, header.fLength) != header.fChecksum ||
+        header.fCount > kMaxEntries) {
+        return false;
+    }
+
+    StoreReader reader(payload, header.fLength);
+    SkString driver;
+    reader.readString(&driver);
+    if (!reader.ok() || driver != fDriver) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.fCount; ++i) {
+        Entry* entry = SkNEW(Entry);
+        *fEntries.append() = entry;
+        entry->fHash = reader.readU32();
+        entry->fBinaryFormat = reader.readU32();
+        uint32_t binaryLength = reader.readU32();
+        Source& source = entry->fSource;
+        reader.readString(&source.fVertexShader);
+        reader.readString(&source.fGeometryShader);
+        reader.readString(&source.fFragmentShader);
+        reader.readString(&source.fColorOutputName);
+        reader.readString(&source.fDualSourceOutputName);
+        uint32_t attribCount = reader.readU32();
+        if (attribCount > kMaxAttribCount) {
+            return false;
+        }
+        for (uint32_t a = 0; a < attribCount; ++a) {
+            reader.readString(&source.fAttribNames.push_back());
+        }
+        const void* binary = reader.readBytes(binaryLength);
+        if (!reader.ok() || source.hash() != entry->fHash) {
+            return false;
+        }
+        entry->fBinary.append(binaryLength, (const uint8_t*)binary);
+        entry->fProgramID = 0;
+        entry->fLRUStamp = 0;
+    }
+    return reader.eof();
+}
+
+GrGLuint GrGLProgramStore::linkBinary(const Entry& entry) {
+    if (!fGL.caps().programBinarySupport()) {
+        return 0;
+    }
+    GrGLuint programID;
+    GL_CALL_RET(programID, CreateProgram());
+    if (0 == programID) {
+        return 0;
+    }
+    // Drivers may reject binaries (e.g. after an update that didn't change
+    // the version string), in which case we compile the source instead.
+    GR_GL_CALL_NOERRCHECK(fGL.interface(),
+                          ProgramBinary(programID, entry.fBinaryFormat,
+                                        entry.fBinary.begin(),
+                                        entry.fBinary.count()));
+    GrGLint linked = GR_GL_INIT_ZERO;
+    GR_GL_CALL_NOERRCHECK(fGL.interface(),
+                          GetProgramiv(programID, GR_GL_LINK_STATUS, &linked));
+    if (!linked) {
+        GL_CALL(DeleteProgram(programID));
+        return 0;
+    }
+    ++fStats.fBinaryLinks;
+    return programID;
+}
+
+void GrGLProgramStore::retrieveBinary(GrGLuint programID, Entry* entry) const {
+    entry->fBinary.reset();
+    if (!fGL.caps().programBinarySupport()) {
+        return;
+    }
+    GrGLint length = 0;
+    GL_CALL(GetProgramiv(programID, GR_GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0 || (uint32_t)length > kMaxFieldLength) {
+        return;
+    }
+    entry->fBinary.setCount(length);
+    GrGLsizei written = 0;
+    GrGLenum format = 0;
+    GL_CALL(GetProgramBinary(programID, length, &written, &format,
+                             entry->fBinary.begin()));
+    entry->fBinary.setCount(SkMin32(written, length));
+    entry->fBinaryFormat = format;
+}
+
+GrGLProgramStore::Entry* GrGLProgramStore::find(const Source& source,
+                                                uint32_t hash) const {
+    for (int i = 0; i < fEntries.count(); ++i) {
+        Entry* entry = fEntries[i];
+        if (entry->fHash == hash && entry->fSource == source) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+GrGLuint GrGLProgramStore::createProgram(const Source& source) {
+    uint32_t hash = source.hash();
+    Entry* entry = this->find(source, hash);
+    GrGLuint programID = 0;
+    if (NULL != entry) {
+        // Hand out the program linked from the file. If it has been handed
+        // out already, link another.
+        programID = entry->fProgramID;
+        entry->fProgramID = 0;
+        if (0 == programID && entry->fBinary.count()) {
+            programID = this->linkBinary(*entry);
+        }
+        if (programID) {
+            ++fStats.fHits;
+        }
+    }
+    if (0 == programID) {
+        bool binarySupport = fGL.caps().programBinarySupport();
+        programID = CompileAndLink(fGL, source, binarySupport);
+        if (0 == programID) {
+            return 0;
+        }
+        ++fStats.fMisses;
+        if (NULL == entry) {
+            if (fEntries.count() >= kMaxEntries) {
+                this->evict();
+            }
+            entry = SkNEW(Entry);
+            *fEntries.append() = entry;
+            entry->fHash = hash;
+            entry->fSource = source;
+            entry->fBinaryFormat = 0;
+            entry->fProgramID = 0;
+        }
+        this->retrieveBinary(programID, entry);
+    }
+    entry->fLRUStamp = ++fCurrLRUStamp;
+    return programID;
+}
+
+void GrGLProgramStore::evict() {
+    // The least recently used entry goes. Entries only read from the file
+    // count as older than any used, and the file lists them most recent
+    // first, so the last of them goes.
+    int victim = 0;
+    for (int i = 1; i < fEntries.count(); ++i) {
+        if (fEntries[i]->fLRUStamp <= fEntries[victim]->fLRUStamp) {
+            victim = i;
+        }
+    }
+    Entry* entry = fEntries[victim];
+    if (entry->fProgramID) {
+        GL_CALL(DeleteProgram(entry->fProgramID));
+    }
+    SkDELETE(entry);
+    fEntries.remove(victim);
+}
+
+bool GrGLProgramStore::write(SkWStream* stream) const {
+    // Programs used by this process come first, most recent first, followed
+    // by the ones only read from the file in their order there.
+    SkTDArray<const Entry*> entries;
+    entries.setReserve(fEntries.count());
+    for (int i = 0; i < fEntries.count(); ++i) {
+        const Entry* entry = fEntries[i];
+        int j = entries.count();
+        while (j > 0 && entries[j - 1]->fLRUStamp < entry->fLRUStamp) {
+            --j;
+        }
+        *entries.insert(j) = entry;
+    }
+    int count = entries.count();
+    SkASSERT(count <= kMaxEntries);
+
+    SkDynamicMemoryWStream payload;
+    write_string(&payload, fDriver);
+    for (int i = 0; i < count; ++i) {
+        const Entry* entry = entries[i];
+        const Source& source = entry->fSource;
+        payload.write32(entry->fHash);
+        payload.write32(entry->fBinaryFormat);
+        payload.write32(entry->fBinary.count());
+        write_string(&payload, source.fVertexShader);
+        write_string(&payload, source.fGeometryShader);
+        write_string(&payload, source.fFragmentShader);
+        write_string(&payload, source.fColorOutputName);
+        write_string(&payload, source.fDualSourceOutputName);
+        payload.write32(source.fAttribNames.count());
+        for (int a = 0; a < source.fAttribNames.count(); ++a) {
+            write_string(&payload, source.fAttribNames[a]);
+        }
+        write_bytes(&payload, entry->fBinary.begin(), entry->fBinary.count());
+    }
+
+    StoreHeader header;
+    header.fMagic = kMagic;
+    header.fVersion = kVersion;
+    header.fLength = payload.bytesWritten();
+    header.fCount = count;
+    SkAutoMalloc storage(header.fLength);
+    payload.copyTo(storage.get());
+    header.fChecksum = SkChecksum::Compute((const uint32_t*)storage.get(),
+                                           header.fLength);
+    return stream->write(&header, sizeof(header)) &&
+           stream->write(storage.get(), header.fLength);
+}
+
+bool GrGLProgramStore::flush() const {
+    if (fPath.isEmpty()) {
+        return false;
+    }
+    SkString tmpPath;
+    sk_make_temp_path(fPath.c_str(), &tmpPath);
+    {
+        SkFILEWStream stream(tmpPath.c_str());
+        if (!stream.isValid()) {
+            return false;
+        }
+        if (!this->write(&stream)) {
+            remove(tmpPath.c_str());
+            return false;
+        }
+    }
+#ifdef SK_BUILD_FOR_WIN
+    // rename() won't replace an existing file on Windows.
+    remove(fPath.c_str());
+#endif
+    if (rename(tmpPath.c_str(), fPath.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef GrGLProgramStore_DEFINED
+#define GrGLProgramStore_DEFINED
+
+#include "GrGLContextInfo.h"
+#include "GrNoncopyable.h"
+#include "SkString.h"
+#include "SkTArray.h"
+#include "SkTDArray.h"
+
+class SkWStream;
+
+/**
+ * Keeps the GL programs a context links in a file, so that later processes
+ * using the same driver can load them back rather than compiling them again.
+ *
+ * Programs are keyed by their shader source and the names bound to their
+ * attribute and output locations. (GrGLProgram::Desc can't be used, as the
+ * custom stage keys in it are only unique to a process.) Where the driver
+ * supports GL_ARB_get_program_binary the store also keeps the linked binary,
+ * which skips compiling altogether; otherwise it keeps the source alone.
+ *
+ * The stored programs are linked when the store is created, so they are
+ * ready before they are first drawn with. A file that is missing, corrupt or
+ * was written for a different driver gives an empty store.
+ */
+class GrGLProgramStore : public GrNoncopyable {
+public:
+    /**
+     * What it takes to link a program.
+     */
+    struct Source {
+        SkString            fVertexShader;
+        SkString            fGeometryShader;    // empty if there is none
+        SkString            fFragmentShader;
+        // The names of the attributes, indexed by location. Empty names
+        // aren't bound.
+        SkTArray<SkString>  fAttribNames;
+        // Bound to fragment data location 0 if not empty.
+        SkString            fColorOutputName;
+        // Bound to fragment data location 0, index 1 if not empty.
+        SkString            fDualSourceOutputName;
+
+        bool operator ==(const Source& source) const;
+        uint32_t hash() const;
+    };
+
+    /**
+     * Compiles and links source. Returns the program, or 0 if compiling or
+     * linking failed. If retrievable is true, asks the driver to keep the
+     * program's binary.
+     */
+    static GrGLuint CompileAndLink(const GrGLContextInfo& gl,
+                                   const Source& source,
+                                   bool retrievable = false);
+
+    /**
+     * Reads the programs stored in the file at path and links them. The GL
+     * context must be current.
+     */
+    GrGLProgramStore(const GrGLContextInfo& gl, const char path[]);
+    ~GrGLProgramStore();
+
+    const SkString& path() const { return fPath; }
+
+    /**
+     * Returns the number of programs that would be written, at most
+     * kMaxEntries.
+     */
+    int count() const { return fEntries.count(); }
+
+    /**
+     * Returns a linked program for source, which the caller owns. Programs
+     * read from the file are used if they match; anything else is compiled
+     * and added to the store. Returns 0 if linking failed.
+     */
+    GrGLuint createProgram(const Source& source);
+
+    /**
+     * Writes the most recently used programs to stream. Returns false if
+     * writing failed.
+     */
+    bool write(SkWStream* stream) const;
+
+    /**
+     * Writes the store to a temporary file next to path() and renames that
+     * over path(). Returns false if writing failed.
+     */
+    bool flush() const;
+
+    /**
+     * Forgets the programs linked from the file without deleting them, for
+     * when the GL context has been lost.
+     */
+    void abandon();
+
+    struct Stats {
+        int fLoaded;        // programs read from the file
+        int fPrewarmed;     // of those, the ones linked when the store was made
+        int fBinaryLinks;   // programs linked from a binary
+        int fHits;          // createProgram() calls that didn't compile
+        int fMisses;        // createProgram() calls that compiled
+    };
+    const Stats& stats() const { return fStats; }
+
+    enum {
+        // The most programs kept, and so written to the file. Past this
+        // the least recently used is forgotten.
+        kMaxEntries = 256
+    };
+
+private:
+    struct Entry {
+        uint32_t            fHash;
+        Source              fSource;
+        GrGLenum            fBinaryFormat;
+        SkTDArray<uint8_t>  fBinary;        // empty if there's no binary
+        GrGLuint            fProgramID;     // linked from the file, not handed out
+        unsigned int        fLRUStamp;
+    };
+
+    const GrGLContextInfo&  fGL;
+    SkString                fPath;
+    SkString                fDriver;
+    SkTDArray<Entry*>       fEntries;
+    unsigned int            fCurrLRUStamp;
+    Stats                   fStats;
+
+    void read();
+    bool parse(const void* data, size_t length);
+    GrGLuint linkBinary(const Entry& entry);
+    void retrieveBinary(GrGLuint programID, Entry* entry) const;
+    Entry* find(const Source& source, uint32_t hash) const;
+    void evict();
+};
+
+#endif
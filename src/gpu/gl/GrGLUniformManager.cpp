@@ -13,6 +13,30 @@
          GrAssert(offset + arrayCount <= uni.fArrayCount || \
                   (0 == offset && 1 == arrayCount && GrGLShaderVar::kNonArray == uni.fArrayCount))
 
+namespace {
+// the number of GrGLfloats that hold one element of a uniform of the type
+int type_value_count(GrSLType type) {
+    switch (type) {
+        case kFloat_GrSLType:
+        case kSampler2D_GrSLType:
+            return 1;
+        case kVec2f_GrSLType:
+            return 2;
+        case kVec3f_GrSLType:
+            return 3;
+        case kVec4f_GrSLType:
+            return 4;
+        case kMat33f_GrSLType:
+            return 9;
+        case kMat44f_GrSLType:
+            return 16;
+        default:
+            GrCrash("Unexpected uniform type.");
+            return 0;
+    }
+}
+}
+
 GrGLUniformManager::UniformHandle GrGLUniformManager::appendUniform(GrSLType type, int arrayCount) {
     int idx = fUniforms.count();
     Uniform& uni = fUniforms.push_back();
@@ -21,9 +45,41 @@ GrGLUniformManager::UniformHandle GrGLUniformManager::appendUniform(GrSLType typ
     uni.fType = type;
     uni.fVSLocation = kUnusedUniform;
     uni.fFSLocation = kUnusedUniform;
+
+    int elementCount = GrGLShaderVar::kNonArray == arrayCount ? 1 : arrayCount;
+    uni.fElementIdx = fElementSet.count();
+    uni.fValueIdx = fValues.count();
+    memset(fElementSet.append(elementCount), 0, elementCount * sizeof(bool));
+    fValues.append(elementCount * type_value_count(type));
     return index_to_handle(idx);
 }
 
+bool GrGLUniformManager::valuesChanged(const Uniform& uni,
+                                       int offset,
+                                       int arrayCount,
+                                       const void* values) const {
+    GR_STATIC_ASSERT(sizeof(GrGLint) == sizeof(GrGLfloat));
+    int elementCount = GrGLShaderVar::kNonArray == uni.fArrayCount ? 1 : uni.fArrayCount;
+    if (offset + arrayCount > elementCount) {
+        // not all setters check their bounds, so don't write past the uniform's values
+        return true;
+    }
+    // compare bits rather than floats so that, e.g., -0 replaces 0
+    size_t size = arrayCount * type_value_count(uni.fType) * sizeof(GrGLfloat);
+    GrGLfloat* cached = &fValues[uni.fValueIdx + offset * type_value_count(uni.fType)];
+    bool* set = &fElementSet[uni.fElementIdx + offset];
+
+    bool changed = 0 != memcmp(cached, values, size);
+    for (int i = 0; i < arrayCount && !changed; ++i) {
+        changed = !set[i];
+    }
+    if (changed) {
+        memcpy(cached, values, size);
+        memset(set, true, arrayCount * sizeof(bool));
+    }
+    return changed;
+}
+
 void GrGLUniformManager::setSampler(UniformHandle u, GrGLint texUnit) const {
     const Uniform& uni = fUniforms[handle_to_index(u)];
     GrAssert(uni.fType == kSampler2D_GrSLType);
@@ -32,6 +88,9 @@ void GrGLUniformManager::setSampler(UniformHandle u, GrGLint texUnit) const {
     // reference the sampler then the compiler may have optimized it out. Uncomment this assert
     // once stages insert their own samplers.
     // GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, 0, 1, &texUnit)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), Uniform1i(uni.fFSLocation, texUnit));
     }
@@ -45,6 +104,9 @@ void GrGLUniformManager::set1f(UniformHandle u, GrGLfloat v0) const {
     GrAssert(uni.fType == kFloat_GrSLType);
     GrAssert(GrGLShaderVar::kNonArray == uni.fArrayCount);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, 0, 1, &v0)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), Uniform1f(uni.fFSLocation, v0));
     }
@@ -65,6 +127,9 @@ void GrGLUniformManager::set1fv(UniformHandle u,
     // Once the uniform manager is responsible for inserting the duplicate uniform
     // arrays in VS and FS driver bug workaround, this can be enabled.
     //GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, offset, arrayCount, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), Uniform1fv(uni.fFSLocation + offset, arrayCount, v));
     }
@@ -78,6 +143,10 @@ void GrGLUniformManager::set2f(UniformHandle u, GrGLfloat v0, GrGLfloat v1) cons
     GrAssert(uni.fType == kVec2f_GrSLType);
     GrAssert(GrGLShaderVar::kNonArray == uni.fArrayCount);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    GrGLfloat v[] = { v0, v1 };
+    if (!this->valuesChanged(uni, 0, 1, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), Uniform2f(uni.fFSLocation, v0, v1));
     }
@@ -95,6 +164,9 @@ void GrGLUniformManager::set2fv(UniformHandle u,
     GrAssert(arrayCount > 0);
     ASSERT_ARRAY_UPLOAD_IN_BOUNDS(uni, offset, arrayCount);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, offset, arrayCount, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), Uniform2fv(uni.fFSLocation + offset, arrayCount, v));
     }
@@ -108,6 +180,10 @@ void GrGLUniformManager::set3f(UniformHandle u, GrGLfloat v0, GrGLfloat v1, GrGL
     GrAssert(uni.fType == kVec3f_GrSLType);
     GrAssert(GrGLShaderVar::kNonArray == uni.fArrayCount);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    GrGLfloat v[] = { v0, v1, v2 };
+    if (!this->valuesChanged(uni, 0, 1, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), Uniform3f(uni.fFSLocation, v0, v1, v2));
     }
@@ -125,6 +201,9 @@ void GrGLUniformManager::set3fv(UniformHandle u,
     GrAssert(arrayCount > 0);
     ASSERT_ARRAY_UPLOAD_IN_BOUNDS(uni, offset, arrayCount);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, offset, arrayCount, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), Uniform3fv(uni.fFSLocation + offset, arrayCount, v));
     }
@@ -142,6 +221,10 @@ void GrGLUniformManager::set4f(UniformHandle u,
     GrAssert(uni.fType == kVec4f_GrSLType);
     GrAssert(GrGLShaderVar::kNonArray == uni.fArrayCount);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    GrGLfloat v[] = { v0, v1, v2, v3 };
+    if (!this->valuesChanged(uni, 0, 1, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), Uniform4f(uni.fFSLocation, v0, v1, v2, v3));
     }
@@ -158,6 +241,9 @@ void GrGLUniformManager::set4fv(UniformHandle u,
     GrAssert(uni.fType == kVec4f_GrSLType);
     GrAssert(arrayCount > 0);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, offset, arrayCount, v)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), Uniform4fv(uni.fFSLocation + offset, arrayCount, v));
     }
@@ -172,6 +258,9 @@ void GrGLUniformManager::setMatrix3f(UniformHandle u, const GrGLfloat matrix[])
     GrAssert(GrGLShaderVar::kNonArray == uni.fArrayCount);
     // TODO: Re-enable this assert once texture matrices aren't forced on all custom effects
     // GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, 0, 1, matrix)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), UniformMatrix3fv(uni.fFSLocation, 1, false, matrix));
     }
@@ -185,6 +274,9 @@ void GrGLUniformManager::setMatrix4f(UniformHandle u, const GrGLfloat matrix[])
     GrAssert(uni.fType == kMat44f_GrSLType);
     GrAssert(GrGLShaderVar::kNonArray == uni.fArrayCount);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, 0, 1, matrix)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(), UniformMatrix4fv(uni.fFSLocation, 1, false, matrix));
     }
@@ -202,6 +294,9 @@ void GrGLUniformManager::setMatrix3fv(UniformHandle u,
     GrAssert(arrayCount > 0);
     ASSERT_ARRAY_UPLOAD_IN_BOUNDS(uni, offset, arrayCount);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, offset, arrayCount, matrices)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(),
                    UniformMatrix3fv(uni.fFSLocation + offset, arrayCount, false, matrices));
@@ -221,6 +316,9 @@ void GrGLUniformManager::setMatrix4fv(UniformHandle u,
     GrAssert(arrayCount > 0);
     ASSERT_ARRAY_UPLOAD_IN_BOUNDS(uni, offset, arrayCount);
     GrAssert(kUnusedUniform != uni.fFSLocation || kUnusedUniform != uni.fVSLocation);
+    if (!this->valuesChanged(uni, offset, arrayCount, matrices)) {
+        return;
+    }
     if (kUnusedUniform != uni.fFSLocation) {
         GR_GL_CALL(fContext.interface(),
                    UniformMatrix4fv(uni.fFSLocation + offset, arrayCount, false, matrices));
@@ -13,10 +13,14 @@
 #include "GrAllocator.h"
 
 #include "SkTArray.h"
+#include "SkTDArray.h"
 
 class GrGLContextInfo;
 
 /** Manages a program's uniforms.
+
+    The values last uploaded to each uniform are remembered, as they belong to the program, and
+    setting a uniform to the value it already has makes no GL call.
 */
 class GrGLUniformManager {
 public:
@@ -71,10 +75,21 @@ private:
         GrGLint     fFSLocation;
         GrSLType    fType;
         int         fArrayCount;
+        // index of the uniform's first element in fElementSet, and of its first value in fValues
+        int         fElementIdx;
+        int         fValueIdx;
     };
 
+    // Records the values of elements [offset, offset + arrayCount) of the uniform and returns
+    // whether any differ from the values they were last set to.
+    bool valuesChanged(const Uniform&, int offset, int arrayCount, const void* values) const;
+
     SkTArray<Uniform, true> fUniforms;
     const GrGLContextInfo&  fContext;
+    // whether each element has been uploaded yet, and the values last uploaded. Samplers keep
+    // their texture unit in a GrGLfloat's bits.
+    mutable SkTDArray<bool>         fElementSet;
+    mutable SkTDArray<GrGLfloat>    fValues;
 };
 
 #endif
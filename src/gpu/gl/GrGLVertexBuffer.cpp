@@ -20,7 +20,8 @@ GrGLVertexBuffer::GrGLVertexBuffer(GrGpuGL* gpu,
                                    bool dynamic)
     : INHERITED(gpu, sizeInBytes, dynamic)
     , fBufferID(id)
-    , fLockPtr(NULL) {
+    , fLockPtr(NULL)
+    , fGLSizeInBytes(sizeInBytes) {
 }
 
 void GrGLVertexBuffer::onRelease() {
@@ -55,6 +56,7 @@ void* GrGLVertexBuffer::lock() {
         GL_CALL(BufferData(GR_GL_ARRAY_BUFFER, this->sizeInBytes(), NULL,
                            this->dynamic() ? GR_GL_DYNAMIC_DRAW :
                                              GR_GL_STATIC_DRAW));
+        fGLSizeInBytes = this->sizeInBytes();
         GR_GL_CALL_RET(GPUGL->glInterface(),
                        fLockPtr,
                        MapBuffer(GR_GL_ARRAY_BUFFER, GR_GL_WRITE_ONLY));
@@ -136,10 +138,52 @@ bool GrGLVertexBuffer::updateData(const void* src, size_t srcSizeInBytes) {
         GL_CALL(BufferData(GR_GL_ARRAY_BUFFER, srcSizeInBytes + 1,
                            NULL, usage));
         GL_CALL(BufferSubData(GR_GL_ARRAY_BUFFER, 0, srcSizeInBytes, src));
+        fGLSizeInBytes = srcSizeInBytes + 1;
     } else {
         GL_CALL(BufferData(GR_GL_ARRAY_BUFFER, srcSizeInBytes, src, usage));
+        fGLSizeInBytes = srcSizeInBytes;
     }
 #endif
     return true;
 }
 
+bool GrGLVertexBuffer::updateSubData(const void* src,
+                                     size_t srcSizeInBytes,
+                                     size_t offset) {
+    GrAssert(fBufferID);
+    GrAssert(!isLocked());
+    if (offset + srcSizeInBytes > this->sizeInBytes()) {
+        return false;
+    }
+    this->bind();
+    if (0 == offset) {
+        // Nothing before the data has to be kept. Let the driver drop the old
+        // contents, as updateData() does, but keep the size of the buffer.
+        GrGLenum usage = dynamic() ? GR_GL_DYNAMIC_DRAW : GR_GL_STATIC_DRAW;
+        if (this->sizeInBytes() == srcSizeInBytes) {
+            GL_CALL(BufferData(GR_GL_ARRAY_BUFFER,
+                               srcSizeInBytes, src, usage));
+            fGLSizeInBytes = srcSizeInBytes;
+            return true;
+        }
+#if GR_GL_USE_BUFFER_DATA_NULL_HINT
+        bool discard = true;
+#else
+        // updateData() may have shrunk the storage. Growing it back loses
+        // nothing here.
+        bool discard = fGLSizeInBytes < srcSizeInBytes;
+#endif
+        if (discard) {
+            GL_CALL(BufferData(GR_GL_ARRAY_BUFFER,
+                               this->sizeInBytes(), NULL, usage));
+            fGLSizeInBytes = this->sizeInBytes();
+        }
+    } else if (offset + srcSizeInBytes > fGLSizeInBytes) {
+        // updateData() shrank the storage. Growing it would drop the data
+        // before the offset, which the caller wants kept.
+        return false;
+    }
+    GL_CALL(BufferSubData(GR_GL_ARRAY_BUFFER,
+                          offset, srcSizeInBytes, src));
+    return true;
+}
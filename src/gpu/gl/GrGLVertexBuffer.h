@@ -25,6 +25,9 @@ public:
     virtual void unlock();
     virtual bool isLocked() const;
     virtual bool updateData(const void* src, size_t srcSizeInBytes);
+    virtual bool updateSubData(const void* src,
+                               size_t srcSizeInBytes,
+                               size_t offset);
     GrGLuint bufferID() const;
 
 protected:
@@ -42,6 +45,9 @@ private:
 
     GrGLuint     fBufferID;
     void*        fLockPtr;
+    // The size of the GL buffer's storage. Without
+    // GR_GL_USE_BUFFER_DATA_NULL_HINT updateData() shrinks it to the data.
+    size_t       fGLSizeInBytes;
 
     friend class GrGpuGL;
 
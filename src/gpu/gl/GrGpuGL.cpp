@@ -175,7 +175,15 @@ GrGpuGL::GrGpuGL(const GrGLContextInfo& ctxInfo) : fGLContextInfo(ctxInfo) {
 
     this->initCaps();
 
-    fProgramCache = SkNEW_ARGS(ProgramCache, (this->glContextInfo()));
+    fProgramStore = NULL;
+    SkString programCachePath;
+    GetProgramCachePath(&programCachePath);
+    if (!programCachePath.isEmpty()) {
+        fProgramStore = SkNEW_ARGS(GrGLProgramStore, (this->glContextInfo(),
+                                                      programCachePath.c_str()));
+    }
+    fProgramCache = SkNEW_ARGS(ProgramCache, (this->glContextInfo(),
+                                              fProgramStore));
 
     fLastSuccessfulStencilFmtIdx = 0;
     if (false) { // avoid bit rot, suppress warning
@@ -192,6 +200,7 @@ GrGpuGL::~GrGpuGL() {
     }
 
     delete fProgramCache;
+    delete fProgramStore;
 
     // This must be called by before the GrDrawTarget destructor
     this->releaseGeometry();
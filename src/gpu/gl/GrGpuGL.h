@@ -51,6 +51,12 @@ public:
 
     virtual void abandonResources() SK_OVERRIDE;
 
+    virtual bool flushProgramCache() SK_OVERRIDE;
+
+    // The store of programs linked by earlier processes, or NULL if there
+    // is no program cache file.
+    const GrGLProgramStore* programStore() const { return fProgramStore; }
+
     bool programUnitTest();
 
 
@@ -165,7 +171,7 @@ private:
 
     class ProgramCache : public ::GrNoncopyable {
     public:
-        ProgramCache(const GrGLContextInfo& gl);
+        ProgramCache(const GrGLContextInfo& gl, GrGLProgramStore* store);
 
         void abandon();
         GrGLProgram* getProgram(const GrGLProgram::Desc& desc, const GrCustomStage** stages);
@@ -207,6 +213,7 @@ private:
         int                         fCount;
         unsigned int                fCurrLRUStamp;
         const GrGLContextInfo&      fGL;
+        GrGLProgramStore*           fStore;
     };
 
     // binds the texture and sets its texture params
@@ -306,6 +313,7 @@ private:
 
     // GL program-related state
     ProgramCache*               fProgramCache;
+    GrGLProgramStore*           fProgramStore;
     SkAutoTUnref<GrGLProgram>   fCurrentProgram;
 
     ///////////////////////////////////////////////////////////////////////////
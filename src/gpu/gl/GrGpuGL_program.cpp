@@ -17,10 +17,12 @@ static const UniformHandle kInvalidUniformHandle = GrGLUniformManager::kInvalidU
 #define SKIP_CACHE_CHECK    true
 #define GR_UINT32_MAX   static_cast<uint32_t>(-1)
 
-GrGpuGL::ProgramCache::ProgramCache(const GrGLContextInfo& gl)
+GrGpuGL::ProgramCache::ProgramCache(const GrGLContextInfo& gl,
+                                    GrGLProgramStore* store)
     : fCount(0)
     , fCurrLRUStamp(0)
-    , fGL(gl) {
+    , fGL(gl)
+    , fStore(store) {
 }
 
 void GrGpuGL::ProgramCache::abandon() {
@@ -39,7 +41,7 @@ GrGLProgram* GrGpuGL::ProgramCache::getProgram(const ProgramDesc& desc,
 
     Entry* entry = fHashCache.find(newEntry.fKey);
     if (NULL == entry) {
-        newEntry.fProgram.reset(GrGLProgram::Create(fGL, desc, stages));
+        newEntry.fProgram.reset(GrGLProgram::Create(fGL, desc, stages, fStore));
         if (NULL == newEntry.fProgram.get()) {
             return NULL;
         }
@@ -76,9 +78,16 @@ GrGLProgram* GrGpuGL::ProgramCache::getProgram(const ProgramDesc& desc,
 void GrGpuGL::abandonResources(){
     INHERITED::abandonResources();
     fProgramCache->abandon();
+    if (NULL != fProgramStore) {
+        fProgramStore->abandon();
+    }
     fHWProgramID = 0;
 }
 
+bool GrGpuGL::flushProgramCache() {
+    return NULL != fProgramStore && fProgramStore->flush();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #define GL_CALL(X) GR_GL_CALL(this->glInterface(), X)
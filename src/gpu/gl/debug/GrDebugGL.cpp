@@ -32,6 +32,8 @@ GrDebugGL::Create GrDebugGL::gFactoryFunc[kObjTypeCount] = {
 GrDebugGL::GrDebugGL()
     : fPackRowLength(0)
     , fUnPackRowLength(0)
+    , fUniformCallCount(0)
+    , fStateCallCount(0)
     , fCurTextureUnit(0)
     , fArrayBuffer(NULL)
     , fElementArrayBuffer(NULL)
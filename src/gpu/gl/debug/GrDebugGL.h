@@ -83,6 +83,19 @@ public:
     }
     GrGLint getUnPackRowLength() const { return fUnPackRowLength; }
 
+    // The number of calls that uploaded uniforms, and that changed other draw
+    // state (blending, stenciling, the scissor, texture bindings, ...), since
+    // the last resetCallCounts(). Tests use these to check that redundant calls
+    // are skipped.
+    void countUniformCall() { ++fUniformCallCount; }
+    void countStateCall() { ++fStateCallCount; }
+    int getUniformCallCount() const { return fUniformCallCount; }
+    int getStateCallCount() const { return fStateCallCount; }
+    void resetCallCounts() {
+        fUniformCallCount = 0;
+        fStateCallCount = 0;
+    }
+
     static GrDebugGL *getInstance() {
         // someone should admit to actually using this class
         GrAssert(0 < gStaticRefCount);
@@ -117,6 +130,8 @@ private:
 
     GrGLint         fPackRowLength;
     GrGLint         fUnPackRowLength;
+    int             fUniformCallCount;
+    int             fStateCallCount;
     GrGLuint        fMaxTextureUnits;
     GrGLuint        fCurTextureUnit;
     GrBufferObj *   fArrayBuffer;
@@ -30,10 +30,15 @@ static const GrGLint kDefaultMaxVertexAttribs = 8;
 // the OpenGLES 2.0 spec says this must be >= 8
 static const GrGLint kDefaultMaxVaryingVectors = 8;
 
+// the one program binary format, and the contents of every program binary
+static const GrGLenum kDebugProgramBinaryFormat = 0xDEB0;
+static const uint32_t kDebugProgramBinary = 0xDEB0B1A2;
+
 namespace { // suppress no previsous prototype warning
 
 ////////////////////////////////////////////////////////////////////////////////
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLActiveTexture(GrGLenum texture) {
+    GrDebugGL::getInstance()->countStateCall();
 
     // Ganesh offsets the texture unit indices
     texture -= GR_GL_TEXTURE0;
@@ -69,6 +74,7 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLBindAttribLocation(GrGLuint program,
 ////////////////////////////////////////////////////////////////////////////////
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLBindTexture(GrGLenum target,
                                                 GrGLuint textureID) {
+    GrDebugGL::getInstance()->countStateCall();
 
     // we don't use cube maps
     GrAlwaysAssert(target == GR_GL_TEXTURE_2D);
@@ -85,6 +91,7 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLBlendColor(GrGLclampf red,
                                                GrGLclampf green,
                                                GrGLclampf blue,
                                                GrGLclampf alpha) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLBindFragDataLocation(GrGLuint program,
@@ -94,6 +101,7 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLBindFragDataLocation(GrGLuint program,
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLBlendFunc(GrGLenum sfactor,
                                               GrGLenum dfactor) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -132,6 +140,30 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLBufferSubData(GrGLenum target,
                                                   GrGLintptr offset,
                                                   GrGLsizeiptr size,
                                                   const GrGLvoid* data) {
+    GrAlwaysAssert(GR_GL_ARRAY_BUFFER == target ||
+                   GR_GL_ELEMENT_ARRAY_BUFFER == target);
+    GrAlwaysAssert(offset >= 0 && size >= 0);
+
+    GrBufferObj *buffer = NULL;
+    switch (target) {
+        case GR_GL_ARRAY_BUFFER:
+            buffer = GrDebugGL::getInstance()->getArrayBuffer();
+            break;
+        case GR_GL_ELEMENT_ARRAY_BUFFER:
+            buffer = GrDebugGL::getInstance()->getElementArrayBuffer();
+            break;
+        default:
+            GrCrash("Unexpected target to glBufferSubData");
+            break;
+    }
+
+    GrAlwaysAssert(buffer);
+    GrAlwaysAssert(buffer->getBound());
+    GrAlwaysAssert(!buffer->getMapped());
+    // the data must fit in the storage given by the last glBufferData
+    GrAlwaysAssert(offset + size <= buffer->getSize());
+
+    memcpy(buffer->getDataPtr() + offset, data, size);
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLClear(GrGLbitfield mask) {
@@ -150,6 +182,7 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLColorMask(GrGLboolean red,
                                               GrGLboolean green,
                                               GrGLboolean blue,
                                               GrGLboolean alpha) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLCompileShader(GrGLuint shader) {
@@ -166,15 +199,18 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLCompressedTexImage2D(GrGLenum target,
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLCullFace(GrGLenum mode) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLDepthMask(GrGLboolean flag) {
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLDisable(GrGLenum cap) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLDisableVertexAttribArray(GrGLuint index) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLDrawArrays(GrGLenum mode,
@@ -196,9 +232,11 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLDrawElements(GrGLenum mode,
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLEnable(GrGLenum cap) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLEnableVertexAttribArray(GrGLuint index) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLEndQuery(GrGLenum target) {
@@ -211,9 +249,11 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLFlush() {
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLFrontFace(GrGLenum mode) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLLineWidth(GrGLfloat width) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLLinkProgram(GrGLuint program) {
@@ -314,6 +354,7 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLScissor(GrGLint x,
                                             GrGLint y,
                                             GrGLsizei width,
                                             GrGLsizei height) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLShaderSource(GrGLuint shader,
@@ -325,30 +366,36 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLShaderSource(GrGLuint shader,
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLStencilFunc(GrGLenum func,
                                                 GrGLint ref,
                                                 GrGLuint mask) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLStencilFuncSeparate(GrGLenum face,
                                                         GrGLenum func,
                                                         GrGLint ref,
                                                         GrGLuint mask) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLStencilMask(GrGLuint mask) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLStencilMaskSeparate(GrGLenum face,
                                                         GrGLuint mask) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLStencilOp(GrGLenum fail,
                                               GrGLenum zfail,
                                               GrGLenum zpass) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLStencilOpSeparate(GrGLenum face,
                                                       GrGLenum fail,
                                                       GrGLenum zfail,
                                                       GrGLenum zpass) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLTexImage2D(GrGLenum target,
@@ -365,11 +412,13 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLTexImage2D(GrGLenum target,
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLTexParameteri(GrGLenum target,
                                                   GrGLenum pname,
                                                   GrGLint param) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLTexParameteriv(GrGLenum target,
                                                    GrGLenum pname,
                                                    const GrGLint* params) {
+    GrDebugGL::getInstance()->countStateCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLTexStorage2D(GrGLenum target,
@@ -392,62 +441,74 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLTexSubImage2D(GrGLenum target,
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform1f(GrGLint location,
                                               GrGLfloat v0) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform1i(GrGLint location,
                                               GrGLint v0) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform1fv(GrGLint location,
                                                GrGLsizei count,
                                                const GrGLfloat* v) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform1iv(GrGLint location,
                                                GrGLsizei count,
                                                const GrGLint* v) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform2f(GrGLint location,
                                               GrGLfloat v0,
                                               GrGLfloat v1) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform2i(GrGLint location,
                                               GrGLint v0,
                                               GrGLint v1) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform2fv(GrGLint location,
                                                GrGLsizei count,
                                                const GrGLfloat* v) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform2iv(GrGLint location,
                                                GrGLsizei count,
                                                const GrGLint* v) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform3f(GrGLint location,
                                               GrGLfloat v0,
                                               GrGLfloat v1,
                                               GrGLfloat v2) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform3i(GrGLint location,
                                               GrGLint v0,
                                               GrGLint v1,
                                               GrGLint v2) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform3fv(GrGLint location,
                                                GrGLsizei count,
                                                const GrGLfloat* v) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform3iv(GrGLint location,
                                                GrGLsizei count,
                                                const GrGLint* v) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform4f(GrGLint location,
@@ -455,6 +516,7 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform4f(GrGLint location,
                                               GrGLfloat v1,
                                               GrGLfloat v2,
                                               GrGLfloat v3) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform4i(GrGLint location,
@@ -462,37 +524,44 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform4i(GrGLint location,
                                               GrGLint v1,
                                               GrGLint v2,
                                               GrGLint v3) {
+    GrDebugGL::getInstance()->countUniformCall();
 }
 
 GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform4fv(GrGLint location,
                                                GrGLsizei count,
                                                const GrGLfloat* v) {
+    GrDebugGL::getInstance()->countUniformCall();
  }
 
  GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform4iv(GrGLint location,
                                                 GrGLsizei count,
                                                 const GrGLint* v) {
+     GrDebugGL::getInstance()->countUniformCall();
  }
 
  GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniformMatrix2fv(GrGLint location,
                                                       GrGLsizei count,
                                                       GrGLboolean transpose,
                                                       const GrGLfloat* value) {
+     GrDebugGL::getInstance()->countUniformCall();
  }
 
  GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniformMatrix3fv(GrGLint location,
                                                       GrGLsizei count,
                                                       GrGLboolean transpose,
                                                       const GrGLfloat* value) {
+     GrDebugGL::getInstance()->countUniformCall();
  }
 
  GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniformMatrix4fv(GrGLint location,
                                                       GrGLsizei count,
                                                       GrGLboolean transpose,
                                                       const GrGLfloat* value) {
+     GrDebugGL::getInstance()->countUniformCall();
  }
 
  GrGLvoid GR_GL_FUNCTION_TYPE debugGLUseProgram(GrGLuint programID) {
+     GrDebugGL::getInstance()->countStateCall();
 
      // A programID of 0 is legal
      GrProgramObj *program = GR_FIND(programID,
@@ -504,6 +573,7 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform4fv(GrGLint location,
 
  GrGLvoid GR_GL_FUNCTION_TYPE debugGLVertexAttrib4fv(GrGLuint indx,
                                                      const GrGLfloat* values) {
+     GrDebugGL::getInstance()->countStateCall();
  }
 
  GrGLvoid GR_GL_FUNCTION_TYPE debugGLVertexAttribPointer(GrGLuint indx,
@@ -512,16 +582,19 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLUniform4fv(GrGLint location,
                                                          GrGLboolean normalized,
                                                          GrGLsizei stride,
                                                          const GrGLvoid* ptr) {
+     GrDebugGL::getInstance()->countStateCall();
  }
 
  GrGLvoid GR_GL_FUNCTION_TYPE debugGLViewport(GrGLint x,
                                               GrGLint y,
                                               GrGLsizei width,
                                               GrGLsizei height) {
+     GrDebugGL::getInstance()->countStateCall();
  }
 
  GrGLvoid GR_GL_FUNCTION_TYPE debugGLBindFramebuffer(GrGLenum target,
                                                      GrGLuint frameBufferID) {
+     GrDebugGL::getInstance()->countStateCall();
 
      GrAlwaysAssert(GR_GL_FRAMEBUFFER == target);
 
@@ -1143,6 +1216,12 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLGetIntegerv(GrGLenum pname,
         case GR_GL_MAX_VARYING_VECTORS:
             *params = kDefaultMaxVaryingVectors;
             break;
+        case GR_GL_NUM_PROGRAM_BINARY_FORMATS:
+            *params = 1;
+            break;
+        case GR_GL_PROGRAM_BINARY_FORMATS:
+            *params = kDebugProgramBinaryFormat;
+            break;
         default:
             GrCrash("Unexpected pname to GetIntegerv");
     }
@@ -1172,6 +1251,9 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLGetShaderOrProgramiv(GrGLuint program,
         case GR_GL_INFO_LOG_LENGTH:
             *params = 0;
             break;
+        case GR_GL_PROGRAM_BINARY_LENGTH:
+            *params = sizeof(kDebugProgramBinary);
+            break;
         // we don't expect any other pnames
         default:
             GrCrash("Unexpected pname to GetProgramiv");
@@ -1179,6 +1261,34 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLGetShaderOrProgramiv(GrGLuint program,
     }
 }
 
+// Program binaries are just a tag, since there is nothing to compile.
+GrGLvoid GR_GL_FUNCTION_TYPE debugGLGetProgramBinary(GrGLuint program,
+                                                     GrGLsizei bufSize,
+                                                     GrGLsizei* length,
+                                                     GrGLenum* binaryFormat,
+                                                     GrGLvoid* binary) {
+    GrAlwaysAssert(bufSize >= (GrGLsizei)sizeof(kDebugProgramBinary));
+    memcpy(binary, &kDebugProgramBinary, sizeof(kDebugProgramBinary));
+    if (length) {
+        *length = sizeof(kDebugProgramBinary);
+    }
+    *binaryFormat = kDebugProgramBinaryFormat;
+}
+
+GrGLvoid GR_GL_FUNCTION_TYPE debugGLProgramBinary(GrGLuint program,
+                                                  GrGLenum binaryFormat,
+                                                  const GrGLvoid* binary,
+                                                  GrGLsizei length) {
+    GrAlwaysAssert(kDebugProgramBinaryFormat == binaryFormat);
+    GrAlwaysAssert(sizeof(kDebugProgramBinary) == length);
+    GrAlwaysAssert(0 == memcmp(binary, &kDebugProgramBinary, length));
+}
+
+GrGLvoid GR_GL_FUNCTION_TYPE debugGLProgramParameteri(GrGLuint program,
+                                                      GrGLenum pname,
+                                                      GrGLint value) {
+}
+
 namespace {
 template <typename T>
 void query_result(GrGLenum GLtarget, GrGLenum pname, T *params) {
@@ -1240,7 +1350,7 @@ GrGLvoid GR_GL_FUNCTION_TYPE debugGLGetQueryObjectuiv(GrGLuint id,
 const GrGLubyte* GR_GL_FUNCTION_TYPE debugGLGetString(GrGLenum name) {
     switch (name) {
         case GR_GL_EXTENSIONS:
-            return (const GrGLubyte*)"GL_ARB_framebuffer_object GL_ARB_blend_func_extended GL_ARB_timer_query GL_ARB_draw_buffers GL_ARB_occlusion_query GL_EXT_blend_color GL_EXT_stencil_wrap";
+            return (const GrGLubyte*)"GL_ARB_framebuffer_object GL_ARB_blend_func_extended GL_ARB_timer_query GL_ARB_draw_buffers GL_ARB_occlusion_query GL_EXT_blend_color GL_EXT_stencil_wrap GL_ARB_get_program_binary";
         case GR_GL_VERSION:
             return (const GrGLubyte*)"4.0 Debug GL";
         case GR_GL_SHADING_LANGUAGE_VERSION:
@@ -1382,6 +1492,7 @@ const GrGLInterface* GrGLCreateDebugInterface() {
     interface->fGetQueryObjectuiv = debugGLGetQueryObjectuiv;
     interface->fGetQueryiv = debugGLGetQueryiv;
     interface->fGetProgramInfoLog = debugGLGetInfoLog;
+    interface->fGetProgramBinary = debugGLGetProgramBinary;
     interface->fGetProgramiv = debugGLGetShaderOrProgramiv;
     interface->fGetShaderInfoLog = debugGLGetInfoLog;
     interface->fGetShaderiv = debugGLGetShaderOrProgramiv;
@@ -1391,6 +1502,8 @@ const GrGLInterface* GrGLCreateDebugInterface() {
     interface->fLineWidth = debugGLLineWidth;
     interface->fLinkProgram = debugGLLinkProgram;
     interface->fPixelStorei = debugGLPixelStorei;
+    interface->fProgramBinary = debugGLProgramBinary;
+    interface->fProgramParameteri = debugGLProgramParameteri;
     interface->fQueryCounter = debugGLQueryCounter;
     interface->fReadBuffer = debugGLReadBuffer;
     interface->fReadPixels = debugGLReadPixels;
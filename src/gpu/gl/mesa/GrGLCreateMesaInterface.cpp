@@ -85,6 +85,12 @@ const GrGLInterface* GrGLCreateMesaInterface() {
         GR_GL_GET_PROC(GetIntegerv);
         GR_GL_GET_PROC(GetProgramInfoLog);
         GR_GL_GET_PROC(GetProgramiv);
+        if (glVer >= GR_GL_VER(4,1) ||
+            GrGLHasExtensionFromString("GL_ARB_get_program_binary", extString)) {
+            GR_GL_GET_PROC(GetProgramBinary);
+            GR_GL_GET_PROC(ProgramBinary);
+            GR_GL_GET_PROC(ProgramParameteri);
+        }
         if (glVer >= GR_GL_VER(3,3) ||
             GrGLHasExtensionFromString("GL_ARB_timer_query", extString)) {
             GR_GL_GET_PROC(GetQueryObjecti64v);
@@ -95,6 +95,12 @@ const GrGLInterface* GrGLCreateNativeInterface() {
         GR_GL_GET_PROC(GetQueryiv);
         GR_GL_GET_PROC(GetProgramInfoLog);
         GR_GL_GET_PROC(GetProgramiv);
+        if (glVer >= GR_GL_VER(4,1) ||
+            GrGLHasExtensionFromString("GL_ARB_get_program_binary", extString)) {
+            GR_GL_GET_PROC(GetProgramBinary);
+            GR_GL_GET_PROC(ProgramBinary);
+            GR_GL_GET_PROC(ProgramParameteri);
+        }
         GR_GL_GET_PROC(GetShaderInfoLog);
         GR_GL_GET_PROC(GetShaderiv);
         interface->fGetString = glGetString;
@@ -15,6 +15,7 @@
 
 SK_DEFINE_INST_COUNT(SkImageDecoder::Peeker)
 SK_DEFINE_INST_COUNT(SkImageDecoder::Chooser)
+SK_DEFINE_INST_COUNT(SkImageDecoder::RowListener)
 SK_DEFINE_INST_COUNT(SkImageDecoderFactory)
 
 static SkBitmap::Config gDeviceConfig = SkBitmap::kNo_Config;
@@ -32,14 +33,15 @@ void SkImageDecoder::SetDeviceConfig(SkBitmap::Config config)
 ///////////////////////////////////////////////////////////////////////////////
 
 SkImageDecoder::SkImageDecoder()
-    : fPeeker(NULL), fChooser(NULL), fAllocator(NULL), fSampleSize(1),
-      fDefaultPref(SkBitmap::kNo_Config), fDitherImage(true),
-      fUsePrefTable(false) {
+    : fPeeker(NULL), fChooser(NULL), fRowListener(NULL), fAllocator(NULL),
+      fSampleSize(1), fDefaultPref(SkBitmap::kNo_Config), fDitherImage(true),
+      fUsePrefTable(false), fIndexWidth(0), fIndexHeight(0) {
 }
 
 SkImageDecoder::~SkImageDecoder() {
     SkSafeUnref(fPeeker);
     SkSafeUnref(fChooser);
+    SkSafeUnref(fRowListener);
     SkSafeUnref(fAllocator);
 }
 
@@ -57,6 +59,12 @@ SkImageDecoder::Chooser* SkImageDecoder::setChooser(Chooser* chooser) {
     return chooser;
 }
 
+SkImageDecoder::RowListener* SkImageDecoder::setRowListener(
+                                                RowListener* listener) {
+    SkRefCnt_SafeAssign(fRowListener, listener);
+    return listener;
+}
+
 SkBitmap::Allocator* SkImageDecoder::setAllocator(SkBitmap::Allocator* alloc) {
     SkRefCnt_SafeAssign(fAllocator, alloc);
     return alloc;
@@ -86,6 +94,15 @@ bool SkImageDecoder::allocPixelRef(SkBitmap* bitmap,
     return bitmap->allocPixels(fAllocator, ctable);
 }
 
+bool SkImageDecoder::notifyRowsDecoded(const SkBitmap& bitmap, int startY,
+                                       int count) const {
+    SkASSERT(startY >= 0 && count > 0 && startY + count <= bitmap.height());
+    if (NULL == fRowListener) {
+        return true;
+    }
+    return fRowListener->onRowsDecoded(bitmap, startY, count);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void SkImageDecoder::setPrefConfigTable(const SkBitmap::Config pref[6]) {
@@ -146,6 +163,44 @@ bool SkImageDecoder::decode(SkStream* stream, SkBitmap* bm,
     return true;
 }
 
+bool SkImageDecoder::buildTileIndex(SkStream* stream, int* width,
+                                    int* height) {
+    SkASSERT(stream && width && height);
+
+    fShouldCancelDecode = false;
+    fIndexWidth = fIndexHeight = 0;
+    int w, h;
+    if (!stream->rewind() || !this->onBuildTileIndex(stream, &w, &h)) {
+        return false;
+    }
+    fIndexWidth = w;
+    fIndexHeight = h;
+    *width = w;
+    *height = h;
+    return true;
+}
+
+bool SkImageDecoder::decodeRegion(SkBitmap* bm, const SkIRect& rect,
+                                  SkBitmap::Config pref) {
+    SkIRect r = rect;
+    if (0 == fIndexWidth ||
+            !r.intersect(SkIRect::MakeWH(fIndexWidth, fIndexHeight))) {
+        return false;
+    }
+
+    // as in decode(), leave the caller's bitmap untouched if we fail
+    SkBitmap    tmp;
+
+    fShouldCancelDecode = false;
+    fDefaultPref = pref;
+
+    if (!this->onDecodeRegion(&tmp, r)) {
+        return false;
+    }
+    bm->swap(tmp);
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 bool SkImageDecoder::DecodeFile(const char file[], SkBitmap* bm,
@@ -11,10 +11,13 @@
 #include "SkImageEncoder.h"
 #include "SkJpegUtility.h"
 #include "SkColorPriv.h"
+#include "SkData.h"
 #include "SkDither.h"
+#include "SkRunnable.h"
 #include "SkScaledBitmapSampler.h"
 #include "SkStream.h"
 #include "SkTemplates.h"
+#include "SkThreadPool.h"
 #include "SkUtils.h"
 
 #include <stdio.h>
@@ -31,17 +34,37 @@ extern "C" {
 // disable for the moment, as we have some glitches when width != multiple of 4
 #define WE_CONVERT_TO_YUV
 
+// libjpeg-turbo can skip rows without running the IDCT or color conversion,
+// and decode just the columns we want. Older versions mishandle the merged
+// upsampler we get with do_fancy_upsampling turned off, so require 2.1.
+#if defined(LIBJPEG_TURBO_VERSION_NUMBER) && LIBJPEG_TURBO_VERSION_NUMBER >= 2001000
+    #define SK_JPEG_CAN_SKIP_SCANLINES
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
 class SkJPEGImageDecoder : public SkImageDecoder {
 public:
+    SkJPEGImageDecoder() : fIndexStream(NULL) {}
+    virtual ~SkJPEGImageDecoder() {
+        SkSafeUnref(fIndexStream);
+    }
+
     virtual Format getFormat() const {
         return kJPEG_Format;
     }
 
 protected:
     virtual bool onDecode(SkStream* stream, SkBitmap* bm, Mode);
+    virtual bool onBuildTileIndex(SkStream* stream, int* width, int* height);
+    virtual bool onDecodeRegion(SkBitmap* bm, const SkIRect& rect);
+
+private:
+    // the stream passed to buildTileIndex(), which we rewind for each region
+    SkStream*   fIndexStream;
+
+    SkBitmap::Config getBitmapConfig(jpeg_decompress_struct*);
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -121,6 +144,11 @@ static bool valid_output_dimensions(const jpeg_decompress_struct& cinfo) {
 
 static bool skip_src_rows(jpeg_decompress_struct* cinfo, void* buffer,
                           int count) {
+#ifdef SK_JPEG_CAN_SKIP_SCANLINES
+    if (count > 0) {
+        return jpeg_skip_scanlines(cinfo, count) == (JDIMENSION)count;
+    }
+#endif
     for (int i = 0; i < count; i++) {
         JSAMPLE* rowptr = (JSAMPLE*)buffer;
         int row_count = jpeg_read_scanlines(cinfo, &rowptr, 1);
@@ -166,6 +194,92 @@ static void convert_CMYK_to_RGB(uint8_t* scanline, unsigned int width) {
     }
 }
 
+/*  Shared setup for decoding the whole image or a region of it, called after
+    jpeg_read_header().
+ */
+static void set_decode_options(jpeg_decompress_struct* cinfo,
+                               int sampleSize) {
+    /*  Try to fulfill the requested sampleSize. Since jpeg can do it (when it
+        can) much faster that we, just use their num/denom api to approximate
+        the size.
+    */
+    cinfo->dct_method = JDCT_IFAST;
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = sampleSize;
+
+    /* this gives about 30% performance improvement. In theory it may
+       reduce the visual quality, in practice I'm not seeing a difference
+     */
+    cinfo->do_fancy_upsampling = 0;
+
+    /* this gives another few percents */
+    cinfo->do_block_smoothing = 0;
+
+    /* default format is RGB */
+    if (cinfo->jpeg_color_space == JCS_CMYK) {
+        // libjpeg cannot convert from CMYK to RGB - here we set up
+        // so libjpeg will give us CMYK samples back and we will
+        // later manually convert them to RGB
+        cinfo->out_color_space = JCS_CMYK;
+    } else {
+        cinfo->out_color_space = JCS_RGB;
+    }
+}
+
+SkBitmap::Config SkJPEGImageDecoder::getBitmapConfig(
+                                            jpeg_decompress_struct* cinfo) {
+    SkBitmap::Config config = this->getPrefConfig(k32Bit_SrcDepth, false);
+    // only these make sense for jpegs
+    if (config != SkBitmap::kARGB_8888_Config &&
+        config != SkBitmap::kARGB_4444_Config &&
+        config != SkBitmap::kRGB_565_Config) {
+        config = SkBitmap::kARGB_8888_Config;
+    }
+
+#ifdef ANDROID_RGB
+    cinfo->dither_mode = JDITHER_NONE;
+    if (SkBitmap::kARGB_8888_Config == config && JCS_CMYK != cinfo->out_color_space) {
+        cinfo->out_color_space = JCS_RGBA_8888;
+    } else if (SkBitmap::kRGB_565_Config == config && JCS_CMYK != cinfo->out_color_space) {
+        cinfo->out_color_space = JCS_RGB_565;
+        if (this->getDitherImage()) {
+            cinfo->dither_mode = JDITHER_ORDERED;
+        }
+    }
+#endif
+    return config;
+}
+
+// Returns false if we can't handle libjpeg's output, or sets the sampler's
+// src config and how many bytes each pixel takes in libjpeg's scanlines.
+static bool get_src_config(const jpeg_decompress_struct& cinfo,
+                           SkScaledBitmapSampler::SrcConfig* sc,
+                           int* srcBytesPerPixel) {
+    if (JCS_CMYK == cinfo.out_color_space) {
+        // In this case we will manually convert the CMYK values to RGB
+        *sc = SkScaledBitmapSampler::kRGBX;
+        *srcBytesPerPixel = 4;
+    } else if (3 == cinfo.out_color_components && JCS_RGB == cinfo.out_color_space) {
+        *sc = SkScaledBitmapSampler::kRGB;
+        *srcBytesPerPixel = 3;
+#ifdef ANDROID_RGB
+    } else if (JCS_RGBA_8888 == cinfo.out_color_space) {
+        *sc = SkScaledBitmapSampler::kRGBX;
+        *srcBytesPerPixel = 4;
+    } else if (JCS_RGB_565 == cinfo.out_color_space) {
+        *sc = SkScaledBitmapSampler::kRGB_565;
+        *srcBytesPerPixel = 2;
+#endif
+    } else if (1 == cinfo.out_color_components &&
+               JCS_GRAYSCALE == cinfo.out_color_space) {
+        *sc = SkScaledBitmapSampler::kGray;
+        *srcBytesPerPixel = 1;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
 #ifdef TIME_DECODE
     AutoTimeMillis atm("JPEG Decode");
@@ -202,53 +316,9 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
         return return_false(cinfo, *bm, "read_header");
     }
 
-    /*  Try to fulfill the requested sampleSize. Since jpeg can do it (when it
-        can) much faster that we, just use their num/denom api to approximate
-        the size.
-    */
     int sampleSize = this->getSampleSize();
-
-    cinfo.dct_method = JDCT_IFAST;
-    cinfo.scale_num = 1;
-    cinfo.scale_denom = sampleSize;
-
-    /* this gives about 30% performance improvement. In theory it may
-       reduce the visual quality, in practice I'm not seeing a difference
-     */
-    cinfo.do_fancy_upsampling = 0;
-
-    /* this gives another few percents */
-    cinfo.do_block_smoothing = 0;
-
-    /* default format is RGB */
-    if (cinfo.jpeg_color_space == JCS_CMYK) {
-        // libjpeg cannot convert from CMYK to RGB - here we set up
-        // so libjpeg will give us CMYK samples back and we will
-        // later manually convert them to RGB
-        cinfo.out_color_space = JCS_CMYK;
-    } else {
-        cinfo.out_color_space = JCS_RGB;
-    }
-
-    SkBitmap::Config config = this->getPrefConfig(k32Bit_SrcDepth, false);
-    // only these make sense for jpegs
-    if (config != SkBitmap::kARGB_8888_Config &&
-        config != SkBitmap::kARGB_4444_Config &&
-        config != SkBitmap::kRGB_565_Config) {
-        config = SkBitmap::kARGB_8888_Config;
-    }
-
-#ifdef ANDROID_RGB
-    cinfo.dither_mode = JDITHER_NONE;
-    if (SkBitmap::kARGB_8888_Config == config && JCS_CMYK != cinfo.out_color_space) {
-        cinfo.out_color_space = JCS_RGBA_8888;
-    } else if (SkBitmap::kRGB_565_Config == config && JCS_CMYK != cinfo.out_color_space) {
-        cinfo.out_color_space = JCS_RGB_565;
-        if (this->getDitherImage()) {
-            cinfo.dither_mode = JDITHER_ORDERED;
-        }
-    }
-#endif
+    set_decode_options(&cinfo, sampleSize);
+    SkBitmap::Config config = this->getBitmapConfig(&cinfo);
 
     if (sampleSize == 1 && mode == SkImageDecoder::kDecodeBounds_Mode) {
         bm->setConfig(config, cinfo.image_width, cinfo.image_height);
@@ -321,6 +391,9 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
             if (this->shouldCancelDecode()) {
                 return return_false(cinfo, *bm, "shouldCancelDecode");
             }
+            if (!this->notifyRowsDecoded(*bm, cinfo.output_scanline - 1, 1)) {
+                return return_false(cinfo, *bm, "notifyRowsDecoded");
+            }
             rowptr += bpr;
         }
         jpeg_finish_decompress(&cinfo);
@@ -330,21 +403,8 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
 
     // check for supported formats
     SkScaledBitmapSampler::SrcConfig sc;
-    if (JCS_CMYK == cinfo.out_color_space) {
-        // In this case we will manually convert the CMYK values to RGB
-        sc = SkScaledBitmapSampler::kRGBX;
-    } else if (3 == cinfo.out_color_components && JCS_RGB == cinfo.out_color_space) {
-        sc = SkScaledBitmapSampler::kRGB;
-#ifdef ANDROID_RGB
-    } else if (JCS_RGBA_8888 == cinfo.out_color_space) {
-        sc = SkScaledBitmapSampler::kRGBX;
-    } else if (JCS_RGB_565 == cinfo.out_color_space) {
-        sc = SkScaledBitmapSampler::kRGB_565;
-#endif
-    } else if (1 == cinfo.out_color_components &&
-               JCS_GRAYSCALE == cinfo.out_color_space) {
-        sc = SkScaledBitmapSampler::kGray;
-    } else {
+    int srcBytesPerPixel;
+    if (!get_src_config(cinfo, &sc, &srcBytesPerPixel)) {
         return return_false(cinfo, *bm, "jpeg colorspace");
     }
 
@@ -391,6 +451,9 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
         }
 
         sampler.next(srcRow);
+        if (!this->notifyRowsDecoded(*bm, y, 1)) {
+            return return_false(cinfo, *bm, "notifyRowsDecoded");
+        }
         if (bm->height() - 1 == y) {
             // we're done
             break;
@@ -412,6 +475,170 @@ bool SkJPEGImageDecoder::onDecode(SkStream* stream, SkBitmap* bm, Mode mode) {
     return true;
 }
 
+/*  Baseline JPEG has no random access into the entropy coded data (short of
+    patching libjpeg to index its huffman state), so the "index" is just the
+    stream and the header we checked. Each region decode restarts from the
+    top, but stops reading at the bottom of the region, and (when libjpeg can)
+    skips the IDCT and color conversion for the rows above it and for the
+    columns outside of it. Only one row is ever buffered.
+ */
+bool SkJPEGImageDecoder::onBuildTileIndex(SkStream* stream, int* width,
+                                          int* height) {
+    JPEGAutoClean autoClean;
+
+    jpeg_decompress_struct  cinfo;
+    skjpeg_error_mgr        sk_err;
+    skjpeg_source_mgr       sk_stream(stream, this, false);
+
+    cinfo.err = jpeg_std_error(&sk_err);
+    sk_err.error_exit = skjpeg_error_exit;
+
+    if (setjmp(sk_err.fJmpBuf)) {
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    autoClean.set(&cinfo);
+    cinfo.src = &sk_stream;
+
+    if (jpeg_read_header(&cinfo, true) != JPEG_HEADER_OK) {
+        return false;
+    }
+    *width = cinfo.image_width;
+    *height = cinfo.image_height;
+
+    SkRefCnt_SafeAssign(fIndexStream, stream);
+    return true;
+}
+
+bool SkJPEGImageDecoder::onDecodeRegion(SkBitmap* bm, const SkIRect& rect) {
+    SkASSERT(fIndexStream);
+
+    SkAutoMalloc  srcStorage;
+    JPEGAutoClean autoClean;
+
+    jpeg_decompress_struct  cinfo;
+    skjpeg_error_mgr        sk_err;
+    // this rewinds fIndexStream
+    skjpeg_source_mgr       sk_stream(fIndexStream, this, false);
+
+    cinfo.err = jpeg_std_error(&sk_err);
+    sk_err.error_exit = skjpeg_error_exit;
+
+    if (setjmp(sk_err.fJmpBuf)) {
+        return return_false(cinfo, *bm, "setjmp");
+    }
+
+    jpeg_create_decompress(&cinfo);
+    autoClean.set(&cinfo);
+
+#ifdef SK_BUILD_FOR_ANDROID
+    overwrite_mem_buffer_size(&cinfo);
+#endif
+
+    cinfo.src = &sk_stream;
+    if (jpeg_read_header(&cinfo, true) != JPEG_HEADER_OK) {
+        return return_false(cinfo, *bm, "read_header");
+    }
+
+    int sampleSize = this->getSampleSize();
+    set_decode_options(&cinfo, sampleSize);
+    SkBitmap::Config config = this->getBitmapConfig(&cinfo);
+
+    if (!jpeg_start_decompress(&cinfo)) {
+        return return_false(cinfo, *bm, "start_decompress");
+    }
+
+    // map rect into libjpeg's (possibly scaled down) output
+    const int imageW = cinfo.image_width;
+    const int imageH = cinfo.image_height;
+    const int outW = cinfo.output_width;
+    const int outH = cinfo.output_height;
+    int left = SkMulDiv(rect.fLeft, outW, imageW);
+    int top = SkMulDiv(rect.fTop, outH, imageH);
+    int width = SkMax32(SkMulDiv(rect.fRight, outW, imageW) - left, 1);
+    int height = SkMax32(SkMulDiv(rect.fBottom, outH, imageH) - top, 1);
+    width = SkMin32(width, outW - left);
+    height = SkMin32(height, outH - top);
+
+    sampleSize = recompute_sampleSize(sampleSize, cinfo);
+
+    if (!this->chooseFromOneChoice(config, width, height)) {
+        return return_false(cinfo, *bm, "chooseFromOneChoice");
+    }
+
+    SkScaledBitmapSampler::SrcConfig sc;
+    int srcBytesPerPixel;
+    if (!get_src_config(cinfo, &sc, &srcBytesPerPixel)) {
+        return return_false(cinfo, *bm, "jpeg colorspace");
+    }
+
+    SkScaledBitmapSampler sampler(width, height, sampleSize);
+
+    bm->setConfig(config, sampler.scaledWidth(), sampler.scaledHeight());
+    // jpegs are always opaque (i.e. have no per-pixel alpha)
+    bm->setIsOpaque(true);
+
+    if (!this->allocPixelRef(bm, NULL)) {
+        return return_false(cinfo, *bm, "allocPixelRef");
+    }
+
+    SkAutoLockPixels alp(*bm);
+    if (!sampler.begin(bm, sc, this->getDitherImage())) {
+        return return_false(cinfo, *bm, "sampler.begin");
+    }
+
+    // offset (in pixels) of the region within the scanlines libjpeg returns
+    int srcX = left;
+#ifdef SK_JPEG_CAN_SKIP_SCANLINES
+    {
+        // libjpeg widens this to whole iMCUs, and updates output_width
+        JDIMENSION cropX = left;
+        JDIMENSION cropWidth = width;
+        jpeg_crop_scanline(&cinfo, &cropX, &cropWidth);
+        srcX = left - cropX;
+    }
+#endif
+
+    // The CMYK work-around relies on 4 components per pixel here
+    uint8_t* srcRow = (uint8_t*)srcStorage.reset(cinfo.output_width * 4);
+    const uint8_t* regionRow = srcRow + srcX * srcBytesPerPixel;
+
+    if (!skip_src_rows(&cinfo, srcRow, top + sampler.srcY0())) {
+        return return_false(cinfo, *bm, "skip rows");
+    }
+
+    for (int y = 0;; y++) {
+        JSAMPLE* rowptr = (JSAMPLE*)srcRow;
+        int row_count = jpeg_read_scanlines(&cinfo, &rowptr, 1);
+        if (0 == row_count) {
+            return return_false(cinfo, *bm, "read_scanlines");
+        }
+        if (this->shouldCancelDecode()) {
+            return return_false(cinfo, *bm, "shouldCancelDecode");
+        }
+
+        if (JCS_CMYK == cinfo.out_color_space) {
+            convert_CMYK_to_RGB(srcRow, cinfo.output_width);
+        }
+
+        sampler.next(regionRow);
+        if (!this->notifyRowsDecoded(*bm, y, 1)) {
+            return return_false(cinfo, *bm, "notifyRowsDecoded");
+        }
+        if (bm->height() - 1 == y) {
+            break;
+        }
+
+        if (!skip_src_rows(&cinfo, srcRow, sampler.srcDY() - 1)) {
+            return return_false(cinfo, *bm, "skip rows");
+        }
+    }
+
+    // don't read the rest of the image; autoClean aborts the decompress
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SkColorPriv.h"
@@ -578,6 +805,214 @@ static WriteScanline ChooseWriter(const SkBitmap& bm) {
     }
 }
 
+// Everything but the height and restart interval, which the parallel encoder
+// chooses per strip
+static void set_encode_options(jpeg_compress_struct* cinfo, int width,
+                               int quality) {
+    cinfo->image_width = width;
+    cinfo->input_components = 3;
+#ifdef WE_CONVERT_TO_YUV
+    cinfo->in_color_space = JCS_YCbCr;
+#else
+    cinfo->in_color_space = JCS_RGB;
+#endif
+    cinfo->input_gamma = 1;
+
+    jpeg_set_defaults(cinfo);
+    jpeg_set_quality(cinfo, quality, TRUE /* limit to baseline-JPEG values */);
+    cinfo->dct_method = JDCT_IFAST;
+}
+
+/*  Encode rows [startY, stopY) of bm as a complete jpeg of that height. If
+    restartInterval is not 0, the strip is encoded as a single restart
+    interval (i.e. it must contain at most that many MCUs), so that its
+    entropy-coded data can be spliced into a larger image.
+ */
+static bool encode_rows(SkWStream* stream, const SkBitmap& bm,
+                        WriteScanline writer, const SkPMColor* colors,
+                        int quality, int startY, int stopY,
+                        unsigned restartInterval) {
+    jpeg_compress_struct    cinfo;
+    skjpeg_error_mgr        sk_err;
+    skjpeg_destination_mgr  sk_wstream(stream);
+
+    // allocate these before set call setjmp
+    SkAutoMalloc    oneRow;
+
+    cinfo.err = jpeg_std_error(&sk_err);
+    sk_err.error_exit = skjpeg_error_exit;
+    if (setjmp(sk_err.fJmpBuf)) {
+        return false;
+    }
+    jpeg_create_compress(&cinfo);
+
+    cinfo.dest = &sk_wstream;
+    cinfo.image_height = stopY - startY;
+    set_encode_options(&cinfo, bm.width(), quality);
+    cinfo.restart_interval = restartInterval;
+
+    jpeg_start_compress(&cinfo, TRUE);
+
+    const int       width = bm.width();
+    uint8_t*        oneRowP = (uint8_t*)oneRow.reset(width * 3);
+
+    const void*      srcRow = bm.getAddr(0, startY);
+
+    while (cinfo.next_scanline < cinfo.image_height) {
+        JSAMPROW row_pointer[1];    /* pointer to JSAMPLE row[s] */
+
+        writer(oneRowP, srcRow, width, colors);
+        row_pointer[0] = oneRowP;
+        (void) jpeg_write_scanlines(&cinfo, row_pointer, 1);
+        srcRow = (const void*)((const char*)srcRow + bm.rowBytes());
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/*  Parallel encoding: the image is cut into strips of whole MCU rows, and each
+    strip is encoded on its own as one restart interval. Since the DC
+    predictors are reset and the bit buffer is flushed at a restart marker,
+    the strips' entropy-coded data is exactly what a single encoder would have
+    written between restart markers, so we keep the first strip's headers
+    (patching in the full height), and splice in the rest after RSTn markers.
+ */
+
+// don't bother splitting images into strips with fewer MCU rows than this
+static const int kMinParallelStripMCURows = 4;
+
+class JPEGStripEncoder : public SkRunnable {
+public:
+    JPEGStripEncoder() : fOK(false) {}
+
+    void init(const SkBitmap* bm, WriteScanline writer,
+              const SkPMColor* colors, int quality, int startY, int stopY,
+              unsigned restartInterval) {
+        fBitmap = bm;
+        fWriter = writer;
+        fColors = colors;
+        fQuality = quality;
+        fStartY = startY;
+        fStopY = stopY;
+        fRestartInterval = restartInterval;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        fOK = encode_rows(&fData, *fBitmap, fWriter, fColors, fQuality,
+                          fStartY, fStopY, fRestartInterval);
+    }
+
+    SkDynamicMemoryWStream  fData;
+    bool                    fOK;
+
+private:
+    const SkBitmap*     fBitmap;
+    WriteScanline       fWriter;
+    const SkPMColor*    fColors;
+    int                 fQuality;
+    int                 fStartY, fStopY;
+    unsigned            fRestartInterval;
+};
+
+/*  Find where the entropy-coded data starts (just past the SOS segment), and
+    the offset of the frame's height. Returns false if the data doesn't look
+    like a baseline jpeg with a single scan, ending with EOI.
+ */
+static bool find_scan_data(const uint8_t* data, size_t size,
+                           size_t* heightOffset, size_t* scanOffset) {
+    if (size < 4 || 0xFF != data[0] || 0xD8 != data[1] ||
+            0xFF != data[size - 2] || 0xD9 != data[size - 1]) {
+        return false;
+    }
+    *heightOffset = 0;
+    size_t i = 2;
+    while (i + 4 <= size) {
+        if (0xFF != data[i]) {
+            return false;
+        }
+        const uint8_t marker = data[i + 1];
+        const size_t length = (data[i + 2] << 8) | data[i + 3];
+        if (0xC0 == marker || 0xC1 == marker) {
+            // SOFn: length, precision, height, width, ...
+            *heightOffset = i + 5;
+        } else if (0xDA == marker) {
+            *scanOffset = i + 2 + length;
+            return 0 != *heightOffset && *scanOffset <= size - 2;
+        }
+        i += 2 + length;
+    }
+    return false;
+}
+
+static bool write_strips(SkWStream* stream, JPEGStripEncoder* strips,
+                         int stripCount, int height) {
+    for (int i = 0; i < stripCount; ++i) {
+        SkAutoDataUnref data(strips[i].fData.copyToData());
+        const uint8_t* bytes = data->bytes();
+        size_t heightOffset, scanOffset;
+        if (!find_scan_data(bytes, data->size(), &heightOffset, &scanOffset)) {
+            return false;
+        }
+        // drop the EOI
+        const size_t end = data->size() - 2;
+        if (0 == i) {
+            // the first strip's headers (with the whole image's height)
+            uint8_t sizeBytes[2] = {
+                (uint8_t)(height >> 8), (uint8_t)height
+            };
+            if (!stream->write(bytes, heightOffset) ||
+                    !stream->write(sizeBytes, 2) ||
+                    !stream->write(bytes + heightOffset + 2,
+                                   end - heightOffset - 2)) {
+                return false;
+            }
+        } else {
+            uint8_t rst[2] = { 0xFF, (uint8_t)(0xD0 + ((i - 1) & 7)) };
+            if (!stream->write(rst, 2) ||
+                    !stream->write(bytes + scanOffset, end - scanOffset)) {
+                return false;
+            }
+        }
+    }
+    static const uint8_t gEOI[] = { 0xFF, 0xD9 };
+    return stream->write(gEOI, sizeof(gEOI));
+}
+
+/*  Return the height of an MCU row, and how many MCUs it contains, for images
+    of this width encoded with our options.
+ */
+static bool get_mcu_size(int width, int quality, int* mcuHeight,
+                         int* mcusPerRow) {
+    jpeg_compress_struct    cinfo;
+    skjpeg_error_mgr        sk_err;
+
+    cinfo.err = jpeg_std_error(&sk_err);
+    sk_err.error_exit = skjpeg_error_exit;
+    if (setjmp(sk_err.fJmpBuf)) {
+        return false;
+    }
+    jpeg_create_compress(&cinfo);
+    cinfo.image_height = 1;
+    set_encode_options(&cinfo, width, quality);
+
+    int maxH = 1, maxV = 1;
+    for (int i = 0; i < cinfo.num_components; ++i) {
+        maxH = SkMax32(maxH, cinfo.comp_info[i].h_samp_factor);
+        maxV = SkMax32(maxV, cinfo.comp_info[i].v_samp_factor);
+    }
+    jpeg_destroy_compress(&cinfo);
+
+    *mcuHeight = maxV * DCTSIZE;
+    const int mcuWidth = maxH * DCTSIZE;
+    *mcusPerRow = (width + mcuWidth - 1) / mcuWidth;
+    return true;
+}
+
 class SkJPEGImageEncoder : public SkImageEncoder {
 protected:
     virtual bool onEncode(SkWStream* stream, const SkBitmap& bm, int quality) {
@@ -595,57 +1030,57 @@ protected:
             return false;
         }
 
-        jpeg_compress_struct    cinfo;
-        skjpeg_error_mgr        sk_err;
-        skjpeg_destination_mgr  sk_wstream(stream);
-
-        // allocate these before set call setjmp
-        SkAutoMalloc    oneRow;
         SkAutoLockColors ctLocker;
+        const SkPMColor* colors = ctLocker.lockColors(bm);
 
-        cinfo.err = jpeg_std_error(&sk_err);
-        sk_err.error_exit = skjpeg_error_exit;
-        if (setjmp(sk_err.fJmpBuf)) {
-            return false;
+        if (this->getThreadCount() > 1) {
+            int mcuHeight, mcusPerRow;
+            if (get_mcu_size(bm.width(), quality, &mcuHeight, &mcusPerRow)) {
+                const int mcuRows = (bm.height() + mcuHeight - 1) / mcuHeight;
+                int stripCount = SkMin32(this->getThreadCount(),
+                                         mcuRows / kMinParallelStripMCURows);
+                // DRI can't describe intervals of more than 64K MCUs
+                const int maxRowsPerStrip = 0xFFFF / mcusPerRow;
+                if (stripCount > 1 && maxRowsPerStrip > 0) {
+                    int rowsPerStrip = (mcuRows + stripCount - 1) / stripCount;
+                    rowsPerStrip = SkMin32(rowsPerStrip, maxRowsPerStrip);
+                    stripCount = (mcuRows + rowsPerStrip - 1) / rowsPerStrip;
+                    return this->encodeStrips(stream, bm, writer, colors,
+                                              quality, stripCount,
+                                              rowsPerStrip * mcuHeight,
+                                              rowsPerStrip * mcusPerRow);
+                }
+            }
         }
-        jpeg_create_compress(&cinfo);
-
-        cinfo.dest = &sk_wstream;
-        cinfo.image_width = bm.width();
-        cinfo.image_height = bm.height();
-        cinfo.input_components = 3;
-#ifdef WE_CONVERT_TO_YUV
-        cinfo.in_color_space = JCS_YCbCr;
-#else
-        cinfo.in_color_space = JCS_RGB;
-#endif
-        cinfo.input_gamma = 1;
-
-        jpeg_set_defaults(&cinfo);
-        jpeg_set_quality(&cinfo, quality, TRUE /* limit to baseline-JPEG values */);
-        cinfo.dct_method = JDCT_IFAST;
-
-        jpeg_start_compress(&cinfo, TRUE);
 
-        const int       width = bm.width();
-        uint8_t*        oneRowP = (uint8_t*)oneRow.reset(width * 3);
-
-        const SkPMColor* colors = ctLocker.lockColors(bm);
-        const void*      srcRow = bm.getPixels();
-
-        while (cinfo.next_scanline < cinfo.image_height) {
-            JSAMPROW row_pointer[1];    /* pointer to JSAMPLE row[s] */
+        return encode_rows(stream, bm, writer, colors, quality, 0, bm.height(),
+                           0);
+    }
 
-            writer(oneRowP, srcRow, width, colors);
-            row_pointer[0] = oneRowP;
-            (void) jpeg_write_scanlines(&cinfo, row_pointer, 1);
-            srcRow = (const void*)((const char*)srcRow + bm.rowBytes());
+private:
+    bool encodeStrips(SkWStream* stream, const SkBitmap& bm,
+                      WriteScanline writer, const SkPMColor* colors,
+                      int quality, int stripCount, int stripHeight,
+                      unsigned restartInterval) {
+        SkAutoTDeleteArray<JPEGStripEncoder> ada(
+                                    SkNEW_ARRAY(JPEGStripEncoder, stripCount));
+        JPEGStripEncoder* strips = ada.get();
+
+        SkThreadPool pool(this->getThreadCount());
+        for (int i = 0; i < stripCount; ++i) {
+            strips[i].init(&bm, writer, colors, quality, i * stripHeight,
+                           SkMin32(bm.height(), (i + 1) * stripHeight),
+                           restartInterval);
+            pool.add(&strips[i]);
         }
+        pool.wait();
 
-        jpeg_finish_compress(&cinfo);
-        jpeg_destroy_compress(&cinfo);
-
-        return true;
+        for (int i = 0; i < stripCount; ++i) {
+            if (!strips[i].fOK) {
+                return false;
+            }
+        }
+        return write_strips(stream, strips, stripCount, bm.height());
     }
 };
 
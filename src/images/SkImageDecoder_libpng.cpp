@@ -20,16 +20,37 @@
 
 extern "C" {
 #include "png.h"
+#include "zlib.h"
 }
 
 class SkPNGImageDecoder : public SkImageDecoder {
 public:
+    SkPNGImageDecoder() : fIndexStream(NULL) {}
+    virtual ~SkPNGImageDecoder() {
+        SkSafeUnref(fIndexStream);
+    }
+
     virtual Format getFormat() const {
         return kPNG_Format;
     }
 
 protected:
     virtual bool onDecode(SkStream* stream, SkBitmap* bm, Mode);
+    virtual bool onBuildTileIndex(SkStream* stream, int* width, int* height);
+    virtual bool onDecodeRegion(SkBitmap* bm, const SkIRect& rect);
+
+private:
+    // the stream passed to buildTileIndex(), which we rewind for each region
+    SkStream*   fIndexStream;
+
+    bool onDecodeInit(SkStream* stream, png_structp* png_ptrp,
+                      png_infop* info_ptrp);
+    bool getBitmapConfig(png_structp png_ptr, png_infop info_ptr,
+                         SkBitmap::Config* config, bool* hasAlpha,
+                         bool* doDither, SkPMColor* theTranspColor);
+    bool decodePalette(png_structp png_ptr, png_infop info_ptr,
+                       bool* hasAlpha, bool* reallyHasAlpha,
+                       SkColorTable** colorTablep);
 };
 
 #ifndef png_jmpbuf
@@ -83,12 +104,13 @@ static bool pos_le(int value, int max) {
     return value > 0 && value <= max;
 }
 
-static bool substituteTranspColor(SkBitmap* bm, SkPMColor match) {
+static bool substituteTranspColor(SkBitmap* bm, SkPMColor match,
+                                  int startY, int count) {
     SkASSERT(bm->config() == SkBitmap::kARGB_8888_Config);
 
     bool reallyHasAlpha = false;
 
-    for (int y = bm->height() - 1; y >= 0; --y) {
+    for (int y = startY + count - 1; y >= startY; --y) {
         SkPMColor* p = bm->getAddr32(0, y);
         for (int x = bm->width() - 1; x >= 0; --x) {
             if (match == *p) {
@@ -127,10 +149,8 @@ static bool hasTransparencyInPalette(png_structp png_ptr, png_infop info_ptr) {
     return false;
 }
 
-bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
-                                 Mode mode) {
-//    SkAutoTrace    apr("SkPNGImageDecoder::onDecode");
-
+bool SkPNGImageDecoder::onDecodeInit(SkStream* sk_stream, png_structp* png_ptrp,
+                                     png_infop* info_ptrp) {
     /* Create and initialize the png_struct with the desired error handler
     * functions.  If you want to use the default stderr and longjump method,
     * you can supply NULL for the last three parameters.  We also supply the
@@ -142,6 +162,7 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
     if (png_ptr == NULL) {
         return false;
     }
+    *png_ptrp = png_ptr;
 
     /* Allocate/initialize the memory for image information. */
     png_infop info_ptr = png_create_info_struct(png_ptr);
@@ -149,14 +170,15 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
         png_destroy_read_struct(&png_ptr, NULL, NULL);
         return false;
     }
-
-    PNGAutoClean autoClean(png_ptr, info_ptr);
+    *info_ptrp = info_ptr;
 
     /* Set error handling if you are using the setjmp/longjmp method (this is
     * the normal method of doing things with libpng).  REQUIRED unless you
     * set up your own error handlers in the png_create_read_struct() earlier.
+    * Our callers set their own, once we return.
     */
     if (setjmp(png_jmpbuf(png_ptr))) {
+        png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
         return false;
     }
 
@@ -201,15 +223,21 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
         color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
         png_set_gray_to_rgb(png_ptr);
     }
+    return true;
+}
 
-    SkBitmap::Config    config;
-    bool                hasAlpha = false;
-    bool                doDither = this->getDitherImage();
-    SkPMColor           theTranspColor = 0; // 0 tells us not to try to match
+bool SkPNGImageDecoder::getBitmapConfig(png_structp png_ptr, png_infop info_ptr,
+                                        SkBitmap::Config* configp,
+                                        bool* hasAlphap, bool* doDitherp,
+                                        SkPMColor* theTranspColorp) {
+    png_uint_32 origWidth, origHeight;
+    int bit_depth, color_type;
+    png_get_IHDR(png_ptr, info_ptr, &origWidth, &origHeight, &bit_depth,
+                 &color_type, NULL, NULL, NULL);
 
     // check for sBIT chunk data, in case we should disable dithering because
     // our data is not truely 8bits per component
-    if (doDither) {
+    if (*doDitherp) {
         png_color_8p sig_bit = NULL;
         bool has_sbit = PNG_INFO_sBIT == png_get_sBIT(png_ptr, info_ptr,
                                                       &sig_bit);
@@ -223,16 +251,16 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
         if (has_sbit && pos_le(sig_bit->red, SK_R16_BITS) &&
                 pos_le(sig_bit->green, SK_G16_BITS) &&
                 pos_le(sig_bit->blue, SK_B16_BITS)) {
-            doDither = false;
+            *doDitherp = false;
         }
     }
 
     if (color_type == PNG_COLOR_TYPE_PALETTE) {
         bool paletteHasAlpha = hasTransparencyInPalette(png_ptr, info_ptr);
-        config = this->getPrefConfig(kIndex_SrcDepth, paletteHasAlpha);
+        *configp = this->getPrefConfig(kIndex_SrcDepth, paletteHasAlpha);
         // now see if we can upscale to their requested config
-        if (!canUpscalePaletteToConfig(config, paletteHasAlpha)) {
-            config = SkBitmap::kIndex8_Config;
+        if (!canUpscalePaletteToConfig(*configp, paletteHasAlpha)) {
+            *configp = SkBitmap::kIndex8_Config;
         }
     } else {
         png_color_16p   transpColor = NULL;
@@ -252,18 +280,18 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
             */
             if (color_type & PNG_COLOR_MASK_COLOR) {
                 if (16 == bit_depth) {
-                    theTranspColor = SkPackARGB32(0xFF, transpColor->red >> 8,
+                    *theTranspColorp = SkPackARGB32(0xFF, transpColor->red >> 8,
                               transpColor->green >> 8, transpColor->blue >> 8);
                 } else {
-                    theTranspColor = SkPackARGB32(0xFF, transpColor->red,
+                    *theTranspColorp = SkPackARGB32(0xFF, transpColor->red,
                                       transpColor->green, transpColor->blue);
                 }
             } else {    // gray
                 if (16 == bit_depth) {
-                    theTranspColor = SkPackARGB32(0xFF, transpColor->gray >> 8,
+                    *theTranspColorp = SkPackARGB32(0xFF, transpColor->gray >> 8,
                               transpColor->gray >> 8, transpColor->gray >> 8);
                 } else {
-                    theTranspColor = SkPackARGB32(0xFF, transpColor->gray,
+                    *theTranspColorp = SkPackARGB32(0xFF, transpColor->gray,
                                           transpColor->gray, transpColor->gray);
                 }
             }
@@ -272,18 +300,18 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
         if (valid ||
                 PNG_COLOR_TYPE_RGB_ALPHA == color_type ||
                 PNG_COLOR_TYPE_GRAY_ALPHA == color_type) {
-            hasAlpha = true;
+            *hasAlphap = true;
         }
-        config = this->getPrefConfig(k32Bit_SrcDepth, hasAlpha);
+        *configp = this->getPrefConfig(k32Bit_SrcDepth, *hasAlphap);
         // now match the request against our capabilities
-        if (hasAlpha) {
-            if (config != SkBitmap::kARGB_4444_Config) {
-                config = SkBitmap::kARGB_8888_Config;
+        if (*hasAlphap) {
+            if (*configp != SkBitmap::kARGB_4444_Config) {
+                *configp = SkBitmap::kARGB_8888_Config;
             }
         } else {
-            if (config != SkBitmap::kRGB_565_Config &&
-                config != SkBitmap::kARGB_4444_Config) {
-                config = SkBitmap::kARGB_8888_Config;
+            if (*configp != SkBitmap::kRGB_565_Config &&
+                *configp != SkBitmap::kARGB_4444_Config) {
+                *configp = SkBitmap::kARGB_8888_Config;
             }
         }
     }
@@ -300,90 +328,70 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
             return false;
         }
     }
+    return true;
+}
 
-    if (!this->chooseFromOneChoice(config, origWidth, origHeight)) {
-        return false;
-    }
-
-    const int sampleSize = this->getSampleSize();
-    SkScaledBitmapSampler sampler(origWidth, origHeight, sampleSize);
-
-    decodedBitmap->setConfig(config, sampler.scaledWidth(),
-                             sampler.scaledHeight(), 0);
-    if (SkImageDecoder::kDecodeBounds_Mode == mode) {
-        return true;
-    }
-
-    // from here down we are concerned with colortables and pixels
-
-    // we track if we actually see a non-opaque pixels, since sometimes a PNG sets its colortype
-    // to |= PNG_COLOR_MASK_ALPHA, but all of its pixels are in fact opaque. We care, since we
-    // draw lots faster if we can flag the bitmap has being opaque
-    bool reallyHasAlpha = false;
-    SkColorTable* colorTable = NULL;
-
-    if (color_type == PNG_COLOR_TYPE_PALETTE) {
-        int num_palette;
-        png_colorp palette;
-        png_bytep trans;
-        int num_trans;
-
-        png_get_PLTE(png_ptr, info_ptr, &palette, &num_palette);
-
-        /*  BUGGY IMAGE WORKAROUND
+bool SkPNGImageDecoder::decodePalette(png_structp png_ptr, png_infop info_ptr,
+                                      bool* hasAlphap, bool* reallyHasAlphap,
+                                      SkColorTable** colorTablep) {
+    int num_palette;
+    png_colorp palette;
+    png_bytep trans;
+    int num_trans;
 
-            We hit some images (e.g. fruit_.png) who contain bytes that are == colortable_count
-            which is a problem since we use the byte as an index. To work around this we grow
-            the colortable by 1 (if its < 256) and duplicate the last color into that slot.
-        */
-        int colorCount = num_palette + (num_palette < 256);
+    png_get_PLTE(png_ptr, info_ptr, &palette, &num_palette);
 
-        colorTable = SkNEW_ARGS(SkColorTable, (colorCount));
+    /*  BUGGY IMAGE WORKAROUND
 
-        SkPMColor* colorPtr = colorTable->lockColors();
-        if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
-            png_get_tRNS(png_ptr, info_ptr, &trans, &num_trans, NULL);
-            hasAlpha = (num_trans > 0);
-        } else {
-            num_trans = 0;
-            colorTable->setFlags(colorTable->getFlags() | SkColorTable::kColorsAreOpaque_Flag);
-        }
-        // check for bad images that might make us crash
-        if (num_trans > num_palette) {
-            num_trans = num_palette;
-        }
+        We hit some images (e.g. fruit_.png) who contain bytes that are == colortable_count
+        which is a problem since we use the byte as an index. To work around this we grow
+        the colortable by 1 (if its < 256) and duplicate the last color into that slot.
+    */
+    int colorCount = num_palette + (num_palette < 256);
 
-        int index = 0;
-        int transLessThanFF = 0;
+    SkColorTable* colorTable = SkNEW_ARGS(SkColorTable, (colorCount));
 
-        for (; index < num_trans; index++) {
-            transLessThanFF |= (int)*trans - 0xFF;
-            *colorPtr++ = SkPreMultiplyARGB(*trans++, palette->red, palette->green, palette->blue);
-            palette++;
-        }
-        reallyHasAlpha |= (transLessThanFF < 0);
+    SkPMColor* colorPtr = colorTable->lockColors();
+    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
+        png_get_tRNS(png_ptr, info_ptr, &trans, &num_trans, NULL);
+        *hasAlphap = (num_trans > 0);
+    } else {
+        num_trans = 0;
+        colorTable->setFlags(colorTable->getFlags() | SkColorTable::kColorsAreOpaque_Flag);
+    }
+    // check for bad images that might make us crash
+    if (num_trans > num_palette) {
+        num_trans = num_palette;
+    }
 
-        for (; index < num_palette; index++) {
-            *colorPtr++ = SkPackARGB32(0xFF, palette->red, palette->green, palette->blue);
-            palette++;
-        }
+    int index = 0;
+    int transLessThanFF = 0;
 
-        // see BUGGY IMAGE WORKAROUND comment above
-        if (num_palette < 256) {
-            *colorPtr = colorPtr[-1];
-        }
-        colorTable->unlockColors(true);
+    for (; index < num_trans; index++) {
+        transLessThanFF |= (int)*trans - 0xFF;
+        *colorPtr++ = SkPreMultiplyARGB(*trans++, palette->red, palette->green, palette->blue);
+        palette++;
     }
+    *reallyHasAlphap |= (transLessThanFF < 0);
 
-    SkAutoUnref aur(colorTable);
+    for (; index < num_palette; index++) {
+        *colorPtr++ = SkPackARGB32(0xFF, palette->red, palette->green, palette->blue);
+        palette++;
+    }
 
-    if (!this->allocPixelRef(decodedBitmap,
-                             SkBitmap::kIndex8_Config == config ?
-                                colorTable : NULL)) {
-        return false;
+    // see BUGGY IMAGE WORKAROUND comment above
+    if (num_palette < 256) {
+        *colorPtr = colorPtr[-1];
     }
+    colorTable->unlockColors(true);
+    *colorTablep = colorTable;
+    return true;
+}
 
-    SkAutoLockPixels alp(*decodedBitmap);
+// Finish setting up libpng's row transforms, returning the number of passes
+static int setup_row_transforms(png_structp png_ptr, png_infop info_ptr) {
+    int color_type = png_get_color_type(png_ptr, info_ptr);
+    int interlace_type = png_get_interlace_type(png_ptr, info_ptr);
 
     /* swap the RGBA or GA data to ARGB or AG (or BGRA to ABGR) */
 //  if (color_type == PNG_COLOR_TYPE_RGB_ALPHA)
@@ -409,26 +417,106 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
     * update the palette for you (ie you selected such a transform above).
     */
     png_read_update_info(png_ptr, info_ptr);
+    return number_passes;
+}
+
+static void get_src_config(const SkColorTable* colorTable, bool hasAlpha,
+                           SkScaledBitmapSampler::SrcConfig* sc,
+                           int* srcBytesPerPixel) {
+    *srcBytesPerPixel = 4;
+    if (colorTable != NULL) {
+        *sc = SkScaledBitmapSampler::kIndex;
+        *srcBytesPerPixel = 1;
+    } else if (hasAlpha) {
+        *sc = SkScaledBitmapSampler::kRGBA;
+    } else {
+        *sc = SkScaledBitmapSampler::kRGBX;
+    }
+}
+
+bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
+                                 Mode mode) {
+//    SkAutoTrace    apr("SkPNGImageDecoder::onDecode");
+
+    png_structp png_ptr;
+    png_infop info_ptr;
+    if (!this->onDecodeInit(sk_stream, &png_ptr, &info_ptr)) {
+        return false;
+    }
+
+    PNGAutoClean autoClean(png_ptr, info_ptr);
+
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        return false;
+    }
+
+    png_uint_32 origWidth, origHeight;
+    int bit_depth, color_type, interlace_type;
+    png_get_IHDR(png_ptr, info_ptr, &origWidth, &origHeight, &bit_depth, &color_type,
+        &interlace_type, NULL, NULL);
+
+    SkBitmap::Config    config;
+    bool                hasAlpha = false;
+    bool                doDither = this->getDitherImage();
+    SkPMColor           theTranspColor = 0; // 0 tells us not to try to match
+
+    if (!this->getBitmapConfig(png_ptr, info_ptr, &config, &hasAlpha,
+                               &doDither, &theTranspColor)) {
+        return false;
+    }
+
+    if (!this->chooseFromOneChoice(config, origWidth, origHeight)) {
+        return false;
+    }
+
+    const int sampleSize = this->getSampleSize();
+    SkScaledBitmapSampler sampler(origWidth, origHeight, sampleSize);
+
+    decodedBitmap->setConfig(config, sampler.scaledWidth(),
+                             sampler.scaledHeight(), 0);
+    if (SkImageDecoder::kDecodeBounds_Mode == mode) {
+        return true;
+    }
+
+    // from here down we are concerned with colortables and pixels
+
+    // we track if we actually see a non-opaque pixels, since sometimes a PNG sets its colortype
+    // to |= PNG_COLOR_MASK_ALPHA, but all of its pixels are in fact opaque. We care, since we
+    // draw lots faster if we can flag the bitmap has being opaque
+    bool reallyHasAlpha = false;
+    SkColorTable* colorTable = NULL;
+
+    if (color_type == PNG_COLOR_TYPE_PALETTE) {
+        decodePalette(png_ptr, info_ptr, &hasAlpha, &reallyHasAlpha, &colorTable);
+    }
+
+    SkAutoUnref aur(colorTable);
+
+    if (!this->allocPixelRef(decodedBitmap,
+                             SkBitmap::kIndex8_Config == config ?
+                                colorTable : NULL)) {
+        return false;
+    }
+
+    SkAutoLockPixels alp(*decodedBitmap);
+
+    const int number_passes = setup_row_transforms(png_ptr, info_ptr);
 
     if (SkBitmap::kIndex8_Config == config && 1 == sampleSize) {
         for (int i = 0; i < number_passes; i++) {
+            const bool lastPass = number_passes - 1 == i;
             for (png_uint_32 y = 0; y < origHeight; y++) {
                 uint8_t* bmRow = decodedBitmap->getAddr8(0, y);
                 png_read_rows(png_ptr, &bmRow, NULL, 1);
+                if (lastPass && !this->notifyRowsDecoded(*decodedBitmap, y, 1)) {
+                    return false;
+                }
             }
         }
     } else {
         SkScaledBitmapSampler::SrcConfig sc;
-        int srcBytesPerPixel = 4;
-
-        if (colorTable != NULL) {
-            sc = SkScaledBitmapSampler::kIndex;
-            srcBytesPerPixel = 1;
-        } else if (hasAlpha) {
-            sc = SkScaledBitmapSampler::kRGBA;
-        } else {
-            sc = SkScaledBitmapSampler::kRGBX;
-        }
+        int srcBytesPerPixel;
+        get_src_config(colorTable, hasAlpha, &sc, &srcBytesPerPixel);
 
         /*  We have to pass the colortable explicitly, since we may have one
             even if our decodedBitmap doesn't, due to the request that we
@@ -457,6 +545,13 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
             base += sampler.srcY0() * rb;
             for (int y = 0; y < height; y++) {
                 reallyHasAlpha |= sampler.next(base);
+                if (0 != theTranspColor) {
+                    reallyHasAlpha |= substituteTranspColor(decodedBitmap,
+                                                            theTranspColor, y, 1);
+                }
+                if (!this->notifyRowsDecoded(*decodedBitmap, y, 1)) {
+                    return false;
+                }
                 base += sampler.srcDY() * rb;
             }
         } else {
@@ -468,6 +563,13 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
                 uint8_t* tmp = srcRow;
                 png_read_rows(png_ptr, &tmp, NULL, 1);
                 reallyHasAlpha |= sampler.next(srcRow);
+                if (0 != theTranspColor) {
+                    reallyHasAlpha |= substituteTranspColor(decodedBitmap,
+                                                            theTranspColor, y, 1);
+                }
+                if (!this->notifyRowsDecoded(*decodedBitmap, y, 1)) {
+                    return false;
+                }
                 if (y < height - 1) {
                     skip_src_rows(png_ptr, srcRow, sampler.srcDY() - 1);
                 }
@@ -484,16 +586,180 @@ bool SkPNGImageDecoder::onDecode(SkStream* sk_stream, SkBitmap* decodedBitmap,
     /* read rest of file, and get additional chunks in info_ptr - REQUIRED */
     png_read_end(png_ptr, info_ptr);
 
-    if (0 != theTranspColor) {
-        reallyHasAlpha |= substituteTranspColor(decodedBitmap, theTranspColor);
-    }
     decodedBitmap->setIsOpaque(!reallyHasAlpha);
     return true;
 }
 
+/*  PNG rows are deflated as one stream, so the "index" is just the stream and
+    the header we checked. Each region decode restarts from the top and has to
+    inflate the rows above the region, but stops at its bottom. Only one row
+    is buffered, unless the image is interlaced: then every pass touches every
+    row, so we have to keep the rows down to the bottom of the region.
+ */
+bool SkPNGImageDecoder::onBuildTileIndex(SkStream* sk_stream, int* width,
+                                         int* height) {
+    png_structp png_ptr;
+    png_infop info_ptr;
+    if (!this->onDecodeInit(sk_stream, &png_ptr, &info_ptr)) {
+        return false;
+    }
+
+    PNGAutoClean autoClean(png_ptr, info_ptr);
+
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        return false;
+    }
+
+    png_uint_32 origWidth, origHeight;
+    int bit_depth, color_type;
+    png_get_IHDR(png_ptr, info_ptr, &origWidth, &origHeight, &bit_depth,
+                 &color_type, NULL, NULL, NULL);
+
+    *width = origWidth;
+    *height = origHeight;
+
+    SkRefCnt_SafeAssign(fIndexStream, sk_stream);
+    return true;
+}
+
+bool SkPNGImageDecoder::onDecodeRegion(SkBitmap* bm, const SkIRect& rect) {
+    SkASSERT(fIndexStream);
+
+    if (!fIndexStream->rewind()) {
+        return false;
+    }
+
+    png_structp png_ptr;
+    png_infop info_ptr;
+    if (!this->onDecodeInit(fIndexStream, &png_ptr, &info_ptr)) {
+        return false;
+    }
+
+    PNGAutoClean autoClean(png_ptr, info_ptr);
+
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        return false;
+    }
+
+    png_uint_32 origWidth, origHeight;
+    int bit_depth, color_type, interlace_type;
+    png_get_IHDR(png_ptr, info_ptr, &origWidth, &origHeight, &bit_depth, &color_type,
+        &interlace_type, NULL, NULL);
+
+    SkBitmap::Config    config;
+    bool                hasAlpha = false;
+    bool                doDither = this->getDitherImage();
+    SkPMColor           theTranspColor = 0; // 0 tells us not to try to match
+
+    if (!this->getBitmapConfig(png_ptr, info_ptr, &config, &hasAlpha,
+                               &doDither, &theTranspColor)) {
+        return false;
+    }
+
+    if (!this->chooseFromOneChoice(config, rect.width(), rect.height())) {
+        return false;
+    }
+
+    SkScaledBitmapSampler sampler(rect.width(), rect.height(),
+                                  this->getSampleSize());
+
+    bm->setConfig(config, sampler.scaledWidth(), sampler.scaledHeight(), 0);
+
+    bool reallyHasAlpha = false;
+    SkColorTable* colorTable = NULL;
+
+    if (color_type == PNG_COLOR_TYPE_PALETTE) {
+        decodePalette(png_ptr, info_ptr, &hasAlpha, &reallyHasAlpha, &colorTable);
+    }
+
+    SkAutoUnref aur(colorTable);
+
+    if (!this->allocPixelRef(bm, SkBitmap::kIndex8_Config == config ?
+                                    colorTable : NULL)) {
+        return false;
+    }
+
+    SkAutoLockPixels alp(*bm);
+
+    const int number_passes = setup_row_transforms(png_ptr, info_ptr);
+
+    SkScaledBitmapSampler::SrcConfig sc;
+    int srcBytesPerPixel;
+    get_src_config(colorTable, hasAlpha, &sc, &srcBytesPerPixel);
+
+    SkAutoLockColors ctLock(colorTable);
+    if (!sampler.begin(bm, sc, doDither, ctLock.colors())) {
+        return false;
+    }
+
+    const int height = bm->height();
+    const size_t rb = origWidth * srcBytesPerPixel;
+    const size_t srcOffset = rect.fLeft * srcBytesPerPixel;
+
+    if (number_passes > 1) {
+        const int rowsToKeep = rect.fBottom;
+        SkAutoMalloc storage(rb * (rowsToKeep + 1));
+        uint8_t* base = (uint8_t*)storage.get();
+        // rows below the region all go here, and are ignored
+        uint8_t* scratch = base + rb * rowsToKeep;
+
+        for (int i = 0; i < number_passes; i++) {
+            for (png_uint_32 y = 0; y < origHeight; y++) {
+                uint8_t* bmRow = (int)y < rowsToKeep ? base + y * rb : scratch;
+                png_read_rows(png_ptr, &bmRow, NULL, 1);
+            }
+            if (this->shouldCancelDecode()) {
+                return false;
+            }
+        }
+
+        const uint8_t* srcRow = base + (rect.fTop + sampler.srcY0()) * rb +
+                                srcOffset;
+        for (int y = 0; y < height; y++) {
+            reallyHasAlpha |= sampler.next(srcRow);
+            if (0 != theTranspColor) {
+                reallyHasAlpha |= substituteTranspColor(bm, theTranspColor, y, 1);
+            }
+            if (!this->notifyRowsDecoded(*bm, y, 1)) {
+                return false;
+            }
+            srcRow += sampler.srcDY() * rb;
+        }
+    } else {
+        SkAutoMalloc storage(rb);
+        uint8_t* srcRow = (uint8_t*)storage.get();
+        skip_src_rows(png_ptr, srcRow, rect.fTop + sampler.srcY0());
+
+        for (int y = 0; y < height; y++) {
+            uint8_t* tmp = srcRow;
+            png_read_rows(png_ptr, &tmp, NULL, 1);
+            if (this->shouldCancelDecode()) {
+                return false;
+            }
+            reallyHasAlpha |= sampler.next(srcRow + srcOffset);
+            if (0 != theTranspColor) {
+                reallyHasAlpha |= substituteTranspColor(bm, theTranspColor, y, 1);
+            }
+            if (!this->notifyRowsDecoded(*bm, y, 1)) {
+                return false;
+            }
+            if (y < height - 1) {
+                skip_src_rows(png_ptr, srcRow, sampler.srcDY() - 1);
+            }
+        }
+        // we don't need the rest of the image, so we stop here
+    }
+
+    bm->setIsOpaque(!reallyHasAlpha);
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SkColorPriv.h"
+#include "SkData.h"
+#include "SkRunnable.h"
+#include "SkThreadPool.h"
 #include "SkUnPreMultiply.h"
 
 static void sk_write_fn(png_structp png_ptr, png_bytep data, png_size_t len) {
@@ -699,6 +965,247 @@ static inline int pack_palette(SkColorTable* ctable,
     return num_trans;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+/*  Parallel IDAT encoding, in the style of pigz: the rows are split into
+    bands, and each band is filtered and deflated on its own. Every band but
+    the last ends with a sync flush, so the raw deflate streams can simply be
+    concatenated, and we wrap them in a single zlib header and adler32 (which
+    we can combine from the bands' checksums). Bands don't share a dictionary,
+    so the result is slightly larger than libpng's.
+ */
+
+// don't bother splitting images into bands shorter than this
+static const int kMinParallelBandRows = 32;
+
+static inline int paeth_predictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = SkAbs32(p - a);
+    int pb = SkAbs32(p - b);
+    int pc = SkAbs32(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+// libpng's heuristic cost: the sum of the bytes' absolute values, treating
+// them as signed
+static inline int filter_cost(int value) {
+    value &= 0xFF;
+    return value < 128 ? value : 256 - value;
+}
+
+/*  Filter one row with the given filter type, writing rb bytes to dst, and
+    return its cost. prev is the (unfiltered) row above, or zeros for the
+    first row.
+ */
+static int filter_row(int type, const uint8_t* SK_RESTRICT cur,
+                      const uint8_t* SK_RESTRICT prev, size_t rb, int bpp,
+                      uint8_t* SK_RESTRICT dst) {
+    int cost = 0;
+    size_t i;
+    switch (type) {
+        case PNG_FILTER_VALUE_NONE:
+            for (i = 0; i < rb; ++i) {
+                cost += filter_cost(dst[i] = cur[i]);
+            }
+            break;
+        case PNG_FILTER_VALUE_SUB:
+            for (i = 0; i < (size_t)bpp; ++i) {
+                cost += filter_cost(dst[i] = cur[i]);
+            }
+            for (; i < rb; ++i) {
+                cost += filter_cost(dst[i] = cur[i] - cur[i - bpp]);
+            }
+            break;
+        case PNG_FILTER_VALUE_UP:
+            for (i = 0; i < rb; ++i) {
+                cost += filter_cost(dst[i] = cur[i] - prev[i]);
+            }
+            break;
+        case PNG_FILTER_VALUE_AVG:
+            for (i = 0; i < (size_t)bpp; ++i) {
+                cost += filter_cost(dst[i] = cur[i] - (prev[i] >> 1));
+            }
+            for (; i < rb; ++i) {
+                cost += filter_cost(dst[i] = cur[i] -
+                                             ((cur[i - bpp] + prev[i]) >> 1));
+            }
+            break;
+        default:
+            SkASSERT(PNG_FILTER_VALUE_PAETH == type);
+            for (i = 0; i < (size_t)bpp; ++i) {
+                // with no left neighbors, paeth picks the one above
+                cost += filter_cost(dst[i] = cur[i] - prev[i]);
+            }
+            for (; i < rb; ++i) {
+                cost += filter_cost(dst[i] = cur[i] -
+                            paeth_predictor(cur[i - bpp], prev[i],
+                                            prev[i - bpp]));
+            }
+            break;
+    }
+    return cost;
+}
+
+/*  Write the filter type byte and the filtered row to dst, which must hold
+    rb + 1 bytes, trying each filter in scratch. Palette images are never
+    filtered, matching libpng's defaults.
+ */
+static void choose_and_filter_row(const uint8_t* cur, const uint8_t* prev,
+                                  size_t rb, int bpp, bool adaptive,
+                                  uint8_t* dst, uint8_t* scratch) {
+    dst[0] = PNG_FILTER_VALUE_NONE;
+    int bestCost = filter_row(PNG_FILTER_VALUE_NONE, cur, prev, rb, bpp,
+                              dst + 1);
+    if (!adaptive) {
+        return;
+    }
+    for (int type = PNG_FILTER_VALUE_SUB; type <= PNG_FILTER_VALUE_PAETH;
+         ++type) {
+        int cost = filter_row(type, cur, prev, rb, bpp, scratch);
+        if (cost < bestCost) {
+            bestCost = cost;
+            dst[0] = type;
+            memcpy(dst + 1, scratch, rb);
+        }
+    }
+}
+
+class PNGBandEncoder : public SkRunnable {
+public:
+    PNGBandEncoder() : fAdler(0), fRawSize(0), fOK(false) {}
+
+    void init(const SkBitmap* bitmap, transform_scanline_proc proc,
+              int bytesPerPixel, bool adaptive, int startY, int stopY,
+              bool isLast) {
+        fBitmap = bitmap;
+        fProc = proc;
+        fBytesPerPixel = bytesPerPixel;
+        fAdaptive = adaptive;
+        fStartY = startY;
+        fStopY = stopY;
+        fIsLast = isLast;
+    }
+
+    virtual void run() SK_OVERRIDE {
+        fOK = this->encode();
+    }
+
+    SkDynamicMemoryWStream  fData;
+    uLong                   fAdler;
+    uLong                   fRawSize;
+    bool                    fOK;
+
+private:
+    const SkBitmap*         fBitmap;
+    transform_scanline_proc fProc;
+    int                     fBytesPerPixel;
+    bool                    fAdaptive;
+    int                     fStartY, fStopY;
+    bool                    fIsLast;
+
+    bool encode();
+    bool deflateRows(z_stream* zs, const uint8_t* src, size_t size, int flush);
+};
+
+bool PNGBandEncoder::deflateRows(z_stream* zs, const uint8_t* src, size_t size,
+                                 int flush) {
+    uint8_t buffer[4096];
+    zs->next_in = (Bytef*)src;
+    zs->avail_in = size;
+    for (;;) {
+        zs->next_out = buffer;
+        zs->avail_out = sizeof(buffer);
+        int err = deflate(zs, flush);
+        if (Z_OK != err && Z_STREAM_END != err && Z_BUF_ERROR != err) {
+            return false;
+        }
+        size_t written = sizeof(buffer) - zs->avail_out;
+        if (written > 0 && !fData.write(buffer, written)) {
+            return false;
+        }
+        // keep going until deflate has consumed all of the input, and (when
+        // flushing) had room to spare for everything it wanted to write
+        if (0 == zs->avail_in && zs->avail_out > 0) {
+            return Z_FINISH != flush || Z_STREAM_END == err;
+        }
+    }
+}
+
+bool PNGBandEncoder::encode() {
+    const int width = fBitmap->width();
+    const size_t rb = width * fBytesPerPixel;
+
+    // rows: previous, current, filter scratch, and the filtered output
+    SkAutoMalloc storage(4 * rb + 1);
+    uint8_t* prev = (uint8_t*)storage.get();
+    uint8_t* cur = prev + rb;
+    uint8_t* scratch = cur + rb;
+    uint8_t* line = scratch + rb;
+
+    const char* src = (const char*)fBitmap->getPixels();
+    const size_t srcRB = fBitmap->rowBytes();
+    if (fStartY > 0) {
+        // we filter against the last row of the band above
+        fProc(src + (fStartY - 1) * srcRB, width, (char*)prev);
+    } else {
+        memset(prev, 0, rb);
+    }
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (Z_OK != deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                             -MAX_WBITS, 8, Z_DEFAULT_STRATEGY)) {
+        return false;
+    }
+
+    bool ok = true;
+    fAdler = adler32(0, NULL, 0);
+    for (int y = fStartY; y < fStopY && ok; ++y) {
+        fProc(src + y * srcRB, width, (char*)cur);
+        choose_and_filter_row(cur, prev, rb, fBytesPerPixel, fAdaptive, line,
+                              scratch);
+        fAdler = adler32(fAdler, line, rb + 1);
+        fRawSize += rb + 1;
+        ok = this->deflateRows(&zs, line, rb + 1, Z_NO_FLUSH);
+        SkTSwap(prev, cur);
+    }
+    if (ok) {
+        ok = this->deflateRows(&zs, NULL, 0, fIsLast ? Z_FINISH : Z_SYNC_FLUSH);
+    }
+    deflateEnd(&zs);
+    return ok;
+}
+
+static void write_idat(png_structp png_ptr, const void* data, size_t size) {
+    png_write_chunk(png_ptr, (png_bytep)"IDAT", (png_bytep)data, size);
+}
+
+static void write_bands_as_idat(png_structp png_ptr, PNGBandEncoder* bands,
+                                int bandCount) {
+    // CMF (deflate, 32K window) and FLG (default level, no dictionary)
+    static const uint8_t gZlibHeader[] = { 0x78, 0x9C };
+    write_idat(png_ptr, gZlibHeader, sizeof(gZlibHeader));
+
+    uLong adler = bands[0].fAdler;
+    for (int i = 0; i < bandCount; ++i) {
+        if (i > 0) {
+            adler = adler32_combine(adler, bands[i].fAdler, bands[i].fRawSize);
+        }
+        SkAutoDataUnref data(bands[i].fData.copyToData());
+        write_idat(png_ptr, data->data(), data->size());
+    }
+
+    uint8_t trailer[4];
+    trailer[0] = (uint8_t)(adler >> 24);
+    trailer[1] = (uint8_t)(adler >> 16);
+    trailer[2] = (uint8_t)(adler >> 8);
+    trailer[3] = (uint8_t)adler;
+    write_idat(png_ptr, trailer, sizeof(trailer));
+}
+
 class SkPNGImageEncoder : public SkImageEncoder {
 protected:
     virtual bool onEncode(SkWStream* stream, const SkBitmap& bm, int quality);
@@ -832,19 +1339,56 @@ bool SkPNGImageEncoder::doEncode(SkWStream* stream, const SkBitmap& bitmap,
     png_set_sBIT(png_ptr, info_ptr, &sig_bit);
     png_write_info(png_ptr, info_ptr);
 
-    const char* srcImage = (const char*)bitmap.getPixels();
-    SkAutoSMalloc<1024> rowStorage(bitmap.width() << 2);
-    char* storage = (char*)rowStorage.get();
     transform_scanline_proc proc = choose_proc(config, hasAlpha);
 
-    for (int y = 0; y < bitmap.height(); y++) {
-        png_bytep row_ptr = (png_bytep)storage;
-        proc(srcImage, bitmap.width(), storage);
-        png_write_rows(png_ptr, &row_ptr, 1);
-        srcImage += bitmap.rowBytes();
-    }
+    const int bandCount = SkMin32(this->getThreadCount(),
+                                  bitmap.height() / kMinParallelBandRows);
+    if (bandCount > 1) {
+        int bytesPerPixel;
+        if (SkBitmap::kIndex8_Config == config) {
+            bytesPerPixel = 1;
+        } else {
+            bytesPerPixel = (colorType & PNG_COLOR_MASK_ALPHA) ? 4 : 3;
+        }
+
+        SkAutoTDeleteArray<PNGBandEncoder> ada(
+                                        SkNEW_ARRAY(PNGBandEncoder, bandCount));
+        PNGBandEncoder* bands = ada.get();
+        SkThreadPool pool(bandCount);
+        for (int i = 0; i < bandCount; ++i) {
+            bands[i].init(&bitmap, proc, bytesPerPixel,
+                          SkBitmap::kIndex8_Config != config,
+                          bitmap.height() * i / bandCount,
+                          bitmap.height() * (i + 1) / bandCount,
+                          bandCount - 1 == i);
+            pool.add(&bands[i]);
+        }
+        pool.wait();
 
-    png_write_end(png_ptr, info_ptr);
+        for (int i = 0; i < bandCount; ++i) {
+            if (!bands[i].fOK) {
+                png_destroy_write_struct(&png_ptr, &info_ptr);
+                return false;
+            }
+        }
+        write_bands_as_idat(png_ptr, bands, bandCount);
+        // png_write_end() insists on IDATs that libpng wrote itself, and we
+        // have nothing else to write after them
+        png_write_chunk(png_ptr, (png_bytep)"IEND", NULL, 0);
+    } else {
+        const char* srcImage = (const char*)bitmap.getPixels();
+        SkAutoSMalloc<1024> rowStorage(bitmap.width() << 2);
+        char* storage = (char*)rowStorage.get();
+
+        for (int y = 0; y < bitmap.height(); y++) {
+            png_bytep row_ptr = (png_bytep)storage;
+            proc(srcImage, bitmap.width(), storage);
+            png_write_rows(png_ptr, &row_ptr, 1);
+            srcImage += bitmap.rowBytes();
+        }
+
+        png_write_end(png_ptr, info_ptr);
+    }
 
     /* clean up after the write, and free any memory allocated */
     png_destroy_write_struct(&png_ptr, &info_ptr);
@@ -12,8 +12,14 @@
 #include "SkStream.h"
 #include "SkTemplates.h"
 
+SkImageEncoder::SkImageEncoder() : fThreadCount(1) {}
+
 SkImageEncoder::~SkImageEncoder() {}
 
+void SkImageEncoder::setThreadCount(int count) {
+    fThreadCount = SkMax32(1, count);
+}
+
 bool SkImageEncoder::encodeStream(SkWStream* stream, const SkBitmap& bm,
                                   int quality) {
     quality = SkMin32(100, SkMax32(0, quality));
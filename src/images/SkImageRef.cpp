@@ -7,6 +7,7 @@
  */
 #include "SkImageRef.h"
 #include "SkBitmap.h"
+#include "SkData.h"
 #include "SkFlattenableBuffers.h"
 #include "SkImageDecoder.h"
 #include "SkStream.h"
@@ -161,6 +162,26 @@ void SkImageRef::onUnlockPixels() {
     SkASSERT(&gImageRefMutex == this->mutex());
 }
 
+SkData* SkImageRef::onRefEncodedData() {
+    // the decoder reads the same stream with the mutex held
+    SkAutoMutexAcquire ac(gImageRefMutex);
+
+    size_t length = fStream->getLength();
+    if (0 == length || !fStream->rewind()) {
+        return NULL;
+    }
+    const void* base = fStream->getMemoryBase();
+    if (base) {
+        return SkData::NewWithCopy(base, length);
+    }
+    void* buffer = sk_malloc_throw(length);
+    if (fStream->read(buffer, length) != length) {
+        sk_free(buffer);
+        return NULL;
+    }
+    return SkData::NewFromMalloc(buffer, length);
+}
+
 size_t SkImageRef::ramUsed() const {
     size_t size = 0;
 
@@ -9,6 +9,7 @@
 
 #include <emmintrin.h>
 #include "SkBitmapProcState_opts_SSE2.h"
+#include "SkPerspIter.h"
 #include "SkUtils.h"
 
 void S32_opaque_D32_filter_DX_SSE2(const SkBitmapProcState& s,
@@ -633,6 +634,343 @@ void ClampX_ClampY_nofilter_affine_SSE2(const SkBitmapProcState& s,
     }
 }
 
+/*  SSE version of ClampX_ClampY_filter_persp()
+ *  portable version is in core/SkBitmapProcState_matrix.h
+ */
+void ClampX_ClampY_filter_persp_SSE2(const SkBitmapProcState& s,
+                                     uint32_t xy[], int count, int x, int y) {
+    SkASSERT(s.fInvType & SkMatrix::kPerspective_Mask);
+
+    unsigned maxX = s.fBitmap->width() - 1;
+    unsigned maxY = s.fBitmap->height() - 1;
+    SkFixed oneX = s.fFilterOneX;
+    SkFixed oneY = s.fFilterOneY;
+    // filtering already limits us to 14bit dimensions
+    SkASSERT(maxX <= 0x3FFF && maxY <= 0x3FFF);
+
+    __m128i wide_half = _mm_set_epi32(oneX >> 1, oneY >> 1,
+                                      oneX >> 1, oneY >> 1);
+    __m128i wide_one  = _mm_set_epi32(oneX, oneY, oneX, oneY);
+    __m128i wide_max  = _mm_set_epi32(maxX, maxY, maxX, maxY);
+    __m128i wide_mask = _mm_set1_epi32(0xF);
+
+    SkPerspIter   iter(*s.fInvMatrix,
+                       SkIntToScalar(x) + SK_ScalarHalf,
+                       SkIntToScalar(y) + SK_ScalarHalf, count);
+
+    while ((count = iter.next()) != 0) {
+        const SkFixed* SK_RESTRICT srcXY = iter.getXY();
+
+        while (count >= 2) {
+            // the iterator gives us (x0, y0, x1, y1), but we store Y first
+            __m128i wide_f = _mm_loadu_si128(
+                                reinterpret_cast<const __m128i*>(srcXY));
+            wide_f = _mm_shuffle_epi32(wide_f, _MM_SHUFFLE(2, 3, 0, 1));
+            wide_f = _mm_sub_epi32(wide_f, wide_half);
+
+            // i = SkClampMax(f>>16,max)
+            __m128i wide_i = _mm_max_epi16(_mm_srli_epi32(wide_f, 16),
+                                           _mm_setzero_si128());
+            wide_i = _mm_min_epi16(wide_i, wide_max);
+
+            // i<<4 | TILEX_LOW_BITS(f)
+            __m128i wide_lo = _mm_srli_epi32(wide_f, 12);
+            wide_lo = _mm_and_si128(wide_lo, wide_mask);
+            wide_i  = _mm_slli_epi32(wide_i, 4);
+            wide_i  = _mm_or_si128(wide_i, wide_lo);
+
+            // i<<14
+            wide_i = _mm_slli_epi32(wide_i, 14);
+
+            // SkClampMax(((f+one))>>16,max)
+            __m128i wide_f1 = _mm_add_epi32(wide_f, wide_one);
+            wide_f1 = _mm_max_epi16(_mm_srli_epi32(wide_f1, 16),
+                                                   _mm_setzero_si128());
+            wide_f1 = _mm_min_epi16(wide_f1, wide_max);
+
+            // final combination
+            wide_i = _mm_or_si128(wide_i, wide_f1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(xy), wide_i);
+
+            srcXY += 4;
+            xy += 4;
+            count -= 2;
+        } // while count >= 2
+
+        if (count > 0) {
+            *xy++ = ClampX_ClampY_pack_filter(srcXY[1] - (oneY >> 1), maxY,
+                                              oneY);
+            *xy++ = ClampX_ClampY_pack_filter(srcXY[0] - (oneX >> 1), maxX,
+                                              oneX);
+        }
+    }
+}
+
+/*  SSE version of ClampX_ClampY_nofilter_persp()
+ *  portable version is in core/SkBitmapProcState_matrix.h
+ */
+void ClampX_ClampY_nofilter_persp_SSE2(const SkBitmapProcState& s,
+                                       uint32_t xy[], int count, int x, int y) {
+    SkASSERT(s.fInvType & SkMatrix::kPerspective_Mask);
+
+    int maxX = s.fBitmap->width() - 1;
+    int maxY = s.fBitmap->height() - 1;
+
+    // _mm_packs_epi32 saturates to signed 16bit values, so the SSE loop is
+    // only valid if our max values fit in 15bits.
+    const bool useSSE = (maxX | maxY) <= 0x7FFF;
+    __m128i wide_max = _mm_set_epi32(maxY, maxX, maxY, maxX);
+
+    SkPerspIter   iter(*s.fInvMatrix,
+                       SkIntToScalar(x) + SK_ScalarHalf,
+                       SkIntToScalar(y) + SK_ScalarHalf, count);
+
+    while ((count = iter.next()) != 0) {
+        const SkFixed* SK_RESTRICT srcXY = iter.getXY();
+
+        if (useSSE) {
+            while (count >= 4) {
+                // (x0, y0, x1, y1) and (x2, y2, x3, y3)
+                __m128i wide_a = _mm_loadu_si128(
+                                    reinterpret_cast<const __m128i*>(srcXY));
+                __m128i wide_b = _mm_loadu_si128(
+                                    reinterpret_cast<const __m128i*>(srcXY + 4));
+
+                // SkClampMax(f>>16,max)
+                wide_a = _mm_max_epi16(_mm_srli_epi32(wide_a, 16),
+                                       _mm_setzero_si128());
+                wide_a = _mm_min_epi16(wide_a, wide_max);
+                wide_b = _mm_max_epi16(_mm_srli_epi32(wide_b, 16),
+                                       _mm_setzero_si128());
+                wide_b = _mm_min_epi16(wide_b, wide_max);
+
+                // narrowing (x, y) pairs to 16bits gives us (y << 16) | x
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(xy),
+                                 _mm_packs_epi32(wide_a, wide_b));
+
+                srcXY += 8;
+                xy += 4;
+                count -= 4;
+            } // while count >= 4
+        }
+
+        while (--count >= 0) {
+            *xy++ = (SkClampMax(srcXY[1] >> 16, maxY) << 16) |
+                     SkClampMax(srcXY[0] >> 16, maxX);
+            srcXY += 2;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Repeat and mirror tiling for scale+translate matrices. These run in the
+// unit space of fUnitInvMatrix, where the low 16bits of the fixed point
+// coordinate are the position within the current tile.
+
+// Matches fixed_repeat() or fixed_mirror(), followed by the scale to [0, max]
+static inline unsigned repeat_or_mirror_tile(SkFixed f, unsigned max,
+                                             bool mirror) {
+    if (mirror) {
+        f ^= f << 15 >> 31;
+    }
+    return ((f & 0xFFFF) * (max + 1)) >> 16;
+}
+
+// mirror and repeat have the same behavior for the low bits.
+static inline unsigned repeat_or_mirror_low_bits(SkFixed f, unsigned max) {
+    return (((f & 0xFFFF) * (max + 1)) >> 12) & 0xF;
+}
+
+static inline uint32_t repeat_or_mirror_pack_filter(SkFixed f, unsigned max,
+                                                    SkFixed one, bool mirror) {
+    unsigned i = repeat_or_mirror_tile(f, max, mirror);
+    i = (i << 4) | repeat_or_mirror_low_bits(f, max);
+    return (i << 14) | repeat_or_mirror_tile(f + one, max, mirror);
+}
+
+// wide_scale holds (max + 1) in the low 16bits of each lane
+static inline __m128i repeat_or_mirror_tile_SSE2(__m128i wide_f,
+                                                 __m128i wide_scale,
+                                                 bool mirror) {
+    if (mirror) {
+        // s is FFFFFFFF if we're on an odd interval, or 0 if an even interval
+        __m128i wide_s = _mm_srai_epi32(_mm_slli_epi32(wide_f, 15), 31);
+        wide_f = _mm_xor_si128(wide_f, wide_s);
+    }
+    wide_f = _mm_and_si128(wide_f, _mm_set1_epi32(0xFFFF));
+    return _mm_mulhi_epu16(wide_f, wide_scale);
+}
+
+static inline __m128i repeat_or_mirror_low_bits_SSE2(__m128i wide_f,
+                                                     __m128i wide_scale) {
+    wide_f = _mm_and_si128(wide_f, _mm_set1_epi32(0xFFFF));
+    __m128i wide_lo = _mm_srli_epi32(_mm_mullo_epi16(wide_f, wide_scale), 12);
+    return _mm_and_si128(wide_lo, _mm_set1_epi32(0xF));
+}
+
+// Offsets of the next 4 pixels from the current one. We recompute the start
+// of each group from the 48bit fx, so that the 32bit steps don't drift.
+static inline __m128i fractional_steps_SSE2(SkFractionalInt dx, int first) {
+    return _mm_set_epi32(SkFractionalIntToFixed(dx * (first + 3)),
+                         SkFractionalIntToFixed(dx * (first + 2)),
+                         SkFractionalIntToFixed(dx * (first + 1)),
+                         SkFractionalIntToFixed(dx * first));
+}
+
+static void repeat_or_mirror_nofilter_scale_SSE2(const SkBitmapProcState& s,
+                                                 uint32_t xy[], int count,
+                                                 int x, int y, bool mirror) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+
+    // we store y, x, x, x, x, x
+    const unsigned maxX = s.fBitmap->width() - 1;
+    SkFractionalInt fx;
+    {
+        SkPoint pt;
+        s.fInvProc(*s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+                                  SkIntToScalar(y) + SK_ScalarHalf, &pt);
+        fx = SkScalarToFractionalInt(pt.fY);
+        const unsigned maxY = s.fBitmap->height() - 1;
+        *xy++ = repeat_or_mirror_tile(SkFractionalIntToFixed(fx), maxY, mirror);
+        fx = SkScalarToFractionalInt(pt.fX);
+    }
+
+    if (0 == maxX) {
+        // all of the following X values must be 0
+        memset(xy, 0, count * sizeof(uint16_t));
+        return;
+    }
+
+    const SkFractionalInt dx = s.fInvSxFractionalInt;
+
+    // _mm_packs_epi32 saturates to signed 16bit values
+    if (count >= 8 && maxX <= 0x7FFF) {
+        __m128i wide_scale = _mm_set1_epi32(maxX + 1);
+        __m128i wide_steps_low = fractional_steps_SSE2(dx, 0);
+        __m128i wide_steps_high = fractional_steps_SSE2(dx, 4);
+        const SkFractionalInt dx8 = dx * 8;
+
+        while (count >= 8) {
+            __m128i wide_fx = _mm_set1_epi32(SkFractionalIntToFixed(fx));
+            __m128i wide_low = _mm_add_epi32(wide_fx, wide_steps_low);
+            __m128i wide_high = _mm_add_epi32(wide_fx, wide_steps_high);
+
+            wide_low = repeat_or_mirror_tile_SSE2(wide_low, wide_scale, mirror);
+            wide_high = repeat_or_mirror_tile_SSE2(wide_high, wide_scale,
+                                                   mirror);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(xy),
+                             _mm_packs_epi32(wide_low, wide_high));
+
+            xy += 4;
+            fx += dx8;
+            count -= 8;
+        }
+    }
+
+    uint16_t* xx = reinterpret_cast<uint16_t*>(xy);
+    while (count-- > 0) {
+        *xx++ = repeat_or_mirror_tile(SkFractionalIntToFixed(fx), maxX, mirror);
+        fx += dx;
+    }
+}
+
+static void repeat_or_mirror_filter_scale_SSE2(const SkBitmapProcState& s,
+                                               uint32_t xy[], int count,
+                                               int x, int y, bool mirror) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(s.fInvKy == 0);
+
+    const unsigned maxX = s.fBitmap->width() - 1;
+    const SkFixed one = s.fFilterOneX;
+    const SkFractionalInt dx = s.fInvSxFractionalInt;
+    SkFractionalInt fx;
+
+    {
+        SkPoint pt;
+        s.fInvProc(*s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+                                  SkIntToScalar(y) + SK_ScalarHalf, &pt);
+        const SkFixed fy = SkScalarToFixed(pt.fY) - (s.fFilterOneY >> 1);
+        const unsigned maxY = s.fBitmap->height() - 1;
+        // compute our two Y values up front
+        *xy++ = repeat_or_mirror_pack_filter(fy, maxY, s.fFilterOneY, mirror);
+        // now initialize fx
+        fx = SkScalarToFractionalInt(pt.fX) - (SkFixedToFractionalInt(one) >> 1);
+    }
+
+    if (count >= 4) {
+        __m128i wide_scale = _mm_set1_epi32(maxX + 1);
+        __m128i wide_one = _mm_set1_epi32(one);
+        __m128i wide_steps = fractional_steps_SSE2(dx, 0);
+        const SkFractionalInt dx4 = dx * 4;
+
+        while (count >= 4) {
+            __m128i wide_fx = _mm_set1_epi32(SkFractionalIntToFixed(fx));
+            wide_fx = _mm_add_epi32(wide_fx, wide_steps);
+
+            // i<<4 | TILEX_LOW_BITS(fx)
+            __m128i wide_i = repeat_or_mirror_tile_SSE2(wide_fx, wide_scale,
+                                                        mirror);
+            wide_i = _mm_slli_epi32(wide_i, 4);
+            wide_i = _mm_or_si128(wide_i,
+                        repeat_or_mirror_low_bits_SSE2(wide_fx, wide_scale));
+
+            // i<<14
+            wide_i = _mm_slli_epi32(wide_i, 14);
+
+            // TILEX_PROCF(fx + one)
+            __m128i wide_fx1 = _mm_add_epi32(wide_fx, wide_one);
+            wide_fx1 = repeat_or_mirror_tile_SSE2(wide_fx1, wide_scale, mirror);
+
+            // final combination
+            wide_i = _mm_or_si128(wide_i, wide_fx1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(xy), wide_i);
+
+            xy += 4;
+            fx += dx4;
+            count -= 4;
+        } // while count >= 4
+    }
+
+    while (count-- > 0) {
+        *xy++ = repeat_or_mirror_pack_filter(SkFractionalIntToFixed(fx), maxX,
+                                             one, mirror);
+        fx += dx;
+    }
+}
+
+/*  SSE versions of RepeatX_RepeatY_filter_scale() and
+ *  RepeatX_RepeatY_nofilter_scale()
+ *  portable versions are in core/SkBitmapProcState_matrix.h
+ */
+void RepeatX_RepeatY_filter_scale_SSE2(const SkBitmapProcState& s,
+                                       uint32_t xy[], int count, int x, int y) {
+    repeat_or_mirror_filter_scale_SSE2(s, xy, count, x, y, false);
+}
+
+void RepeatX_RepeatY_nofilter_scale_SSE2(const SkBitmapProcState& s,
+                                         uint32_t xy[], int count,
+                                         int x, int y) {
+    repeat_or_mirror_nofilter_scale_SSE2(s, xy, count, x, y, false);
+}
+
+/*  SSE versions of GeneralXY_filter_scale() and GeneralXY_nofilter_scale(),
+ *  specialized for mirror tiling in both X and Y.
+ *  portable versions are in core/SkBitmapProcState_matrix.h
+ */
+void MirrorX_MirrorY_filter_scale_SSE2(const SkBitmapProcState& s,
+                                       uint32_t xy[], int count, int x, int y) {
+    repeat_or_mirror_filter_scale_SSE2(s, xy, count, x, y, true);
+}
+
+void MirrorX_MirrorY_nofilter_scale_SSE2(const SkBitmapProcState& s,
+                                         uint32_t xy[], int count,
+                                         int x, int y) {
+    repeat_or_mirror_nofilter_scale_SSE2(s, xy, count, x, y, true);
+}
+
 /*  SSE version of S32_D16_filter_DX_SSE2
  *  Definition is in section of "D16 functions for SRC == 8888" in SkBitmapProcState.cpp
  *  It combines S32_opaque_D32_filter_DX_SSE2 and SkPixel32ToPixel16
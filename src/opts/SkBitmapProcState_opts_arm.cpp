@@ -8,6 +8,7 @@
 
 
 #include "SkBitmapProcState.h"
+#include "SkMipMap.h"
 #include "SkColorPriv.h"
 #include "SkUtils.h"
 
@@ -219,3 +220,6 @@ void SkBitmapProcState::platformProcs() {
     }
 }
 
+SkMipMap::Downsample32Proc SkMipMap::PlatformDownsample32Proc() {
+    return NULL;
+}
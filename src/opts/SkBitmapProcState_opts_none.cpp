@@ -6,6 +6,7 @@
  * found in the LICENSE file.
  */
 #include "SkBitmapProcState.h"
+#include "SkMipMap.h"
 
 /*  A platform may optionally overwrite any of these with accelerated
     versions. On input, these will already have valid function pointers,
@@ -22,4 +23,6 @@
 // empty implementation just uses default supplied function pointers
 void SkBitmapProcState::platformProcs() {}
 
-
+SkMipMap::Downsample32Proc SkMipMap::PlatformDownsample32Proc() {
+    return NULL;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkMipMap_opts_SSE2.h"
+
+// Produces exactly the same results as the portable version in SkMipMap.cpp:
+// the channels are summed in 16bit lanes (the same ag/rb split), and then
+// shifted and repacked.
+void Downsample32_SSE2(uint32_t dst[], const uint32_t src0[],
+                       const uint32_t src1[], int count) {
+    const __m128i mask = _mm_set1_epi32(0x00FF00FF);
+
+    while (count >= 4) {
+        // 8 source pixels from each row: [0 1 2 3] [4 5 6 7]
+        __m128i a0 = _mm_loadu_si128((const __m128i*)src0);
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(src0 + 4));
+        __m128i b0 = _mm_loadu_si128((const __m128i*)src1);
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(src1 + 4));
+
+        // regroup as [0 2 1 3] [4 6 5 7], then split into evens and odds
+        a0 = _mm_shuffle_epi32(a0, _MM_SHUFFLE(3, 1, 2, 0));
+        a1 = _mm_shuffle_epi32(a1, _MM_SHUFFLE(3, 1, 2, 0));
+        b0 = _mm_shuffle_epi32(b0, _MM_SHUFFLE(3, 1, 2, 0));
+        b1 = _mm_shuffle_epi32(b1, _MM_SHUFFLE(3, 1, 2, 0));
+        __m128i aEven = _mm_unpacklo_epi64(a0, a1);
+        __m128i aOdd  = _mm_unpackhi_epi64(a0, a1);
+        __m128i bEven = _mm_unpacklo_epi64(b0, b1);
+        __m128i bOdd  = _mm_unpackhi_epi64(b0, b1);
+
+        __m128i rb = _mm_add_epi32(
+                _mm_add_epi32(_mm_and_si128(aEven, mask),
+                              _mm_and_si128(aOdd, mask)),
+                _mm_add_epi32(_mm_and_si128(bEven, mask),
+                              _mm_and_si128(bOdd, mask)));
+        __m128i ag = _mm_add_epi32(
+                _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(aEven, 8), mask),
+                              _mm_and_si128(_mm_srli_epi32(aOdd, 8), mask)),
+                _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(bEven, 8), mask),
+                              _mm_and_si128(_mm_srli_epi32(bOdd, 8), mask)));
+
+        // ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00)
+        rb = _mm_and_si128(_mm_srli_epi32(rb, 2), mask);
+        ag = _mm_andnot_si128(mask, _mm_slli_epi32(ag, 6));
+        _mm_storeu_si128((__m128i*)dst, _mm_or_si128(rb, ag));
+
+        src0 += 8;
+        src1 += 8;
+        dst += 4;
+        count -= 4;
+    }
+
+    for (int i = 0; i < count; i++) {
+        uint32_t c, ag, rb;
+
+        c = src0[0]; ag = (c >> 8) & 0xFF00FF; rb = c & 0xFF00FF;
+        c = src0[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = src1[0]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+        c = src1[1]; ag += (c >> 8) & 0xFF00FF; rb += c & 0xFF00FF;
+
+        dst[i] = ((rb >> 2) & 0xFF00FF) | ((ag << 6) & 0xFF00FF00);
+        src0 += 2;
+        src1 += 2;
+    }
+}
@@ -0,0 +1,16 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMipMap_opts_SSE2_DEFINED
+#define SkMipMap_opts_SSE2_DEFINED
+
+#include "SkTypes.h"
+
+void Downsample32_SSE2(uint32_t dst[], const uint32_t src0[],
+                       const uint32_t src1[], int count);
+
+#endif
@@ -11,6 +11,9 @@
 #include "SkBlitRow.h"
 #include "SkBlitRect_opts_SSE2.h"
 #include "SkBlitRow_opts_SSE2.h"
+#include "SkMipMap.h"
+#include "SkMipMap_opts_SSE2.h"
+#include "SkShader.h"
 #include "SkUtils_opts_SSE2.h"
 #include "SkUtils.h"
 
@@ -142,9 +145,37 @@ void SkBitmapProcState::platformProcs() {
         } else if (fMatrixProc == ClampX_ClampY_nofilter_affine) {
             fMatrixProc = ClampX_ClampY_nofilter_affine_SSE2;
         }
+
+        if (fMatrixProc == ClampX_ClampY_filter_persp) {
+            fMatrixProc = ClampX_ClampY_filter_persp_SSE2;
+        } else if (fMatrixProc == ClampX_ClampY_nofilter_persp) {
+            fMatrixProc = ClampX_ClampY_nofilter_persp_SSE2;
+        }
+
+        if (fMatrixProc == RepeatX_RepeatY_filter_scale) {
+            fMatrixProc = RepeatX_RepeatY_filter_scale_SSE2;
+        } else if (fMatrixProc == RepeatX_RepeatY_nofilter_scale) {
+            fMatrixProc = RepeatX_RepeatY_nofilter_scale_SSE2;
+        }
+
+        if (SkShader::kMirror_TileMode == fTileModeX &&
+                SkShader::kMirror_TileMode == fTileModeY) {
+            if (fMatrixProc == GeneralXY_filter_scale) {
+                fMatrixProc = MirrorX_MirrorY_filter_scale_SSE2;
+            } else if (fMatrixProc == GeneralXY_nofilter_scale) {
+                fMatrixProc = MirrorX_MirrorY_nofilter_scale_SSE2;
+            }
+        }
     }
 }
 
+SkMipMap::Downsample32Proc SkMipMap::PlatformDownsample32Proc() {
+    if (cachedHasSSE2()) {
+        return Downsample32_SSE2;
+    }
+    return NULL;
+}
+
 static SkBlitRow::Proc32 platform_32_procs[] = {
     NULL,                               // S32_Opaque,
     S32_Blend_BlitRow32_SSE2,           // S32_Blend,
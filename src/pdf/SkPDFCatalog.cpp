@@ -7,16 +7,19 @@
  */
 
 
+#include "SkFlate.h"
 #include "SkPDFCatalog.h"
 #include "SkPDFTypes.h"
 #include "SkStream.h"
 #include "SkTypes.h"
 
 SkPDFCatalog::SkPDFCatalog(SkPDFDocument::Flags flags)
-    : fFirstPageCount(0),
+    : fIndexHashCount(0),
+      fFirstPageCount(0),
       fNextObjNum(1),
       fNextFirstPageObjNum(0),
-      fDocumentFlags(flags) {
+      fDocumentFlags(flags),
+      fCompressionLevel(SkFlate::kDefault_CompressionLevel) {
 }
 
 SkPDFCatalog::~SkPDFCatalog() {
@@ -28,23 +31,57 @@ SkPDFObject* SkPDFCatalog::addObject(SkPDFObject* obj, bool onFirstPage) {
     if (findObjectIndex(obj) != -1) {  // object already added
         return obj;
     }
-    SkASSERT(fNextFirstPageObjNum == 0);
+    // Objects may only be added after numbering has started if none of them
+    // are on the first page (i.e. when the document is streamed).
+    SkASSERT(fNextFirstPageObjNum == 0 ||
+             (fFirstPageCount == 0 && !onFirstPage));
     if (onFirstPage) {
         fFirstPageCount++;
     }
 
     struct Rec newEntry(obj, onFirstPage);
     fCatalog.append(1, &newEntry);
+    setObjectIndex(obj, fCatalog.count() - 1);
     return obj;
 }
 
 size_t SkPDFCatalog::setFileOffset(SkPDFObject* obj, off_t offset) {
+    recordFileOffset(obj, offset);
+    return getSubstituteObject(obj)->getOutputSize(this, true);
+}
+
+void SkPDFCatalog::recordFileOffset(SkPDFObject* obj, off_t offset) {
     int objIndex = assignObjNum(obj) - 1;
     SkASSERT(fCatalog[objIndex].fObjNumAssigned);
     SkASSERT(fCatalog[objIndex].fFileOffset == 0);
     fCatalog[objIndex].fFileOffset = offset;
+}
 
-    return getSubstituteObject(obj)->getOutputSize(this, true);
+void SkPDFCatalog::forgetObject(SkPDFObject* obj) {
+    int objIndex = findObjectIndex(obj);
+    SkASSERT(objIndex >= 0);
+    SkASSERT(fCatalog[objIndex].fObjNumAssigned);
+    SkASSERT(fCatalog[objIndex].fFileOffset > 0);
+    removeObjectIndex(obj);
+    fCatalog[objIndex].fObject = NULL;
+}
+
+void SkPDFCatalog::setAlias(SkPDFObject* alias, SkPDFObject* object) {
+    SkASSERT(alias != object);
+    SkASSERT(findObjectIndex(alias) == -1);
+    setObjectIndex(alias, -1);
+    fIndexHash[findIndexSlot(alias)].fAliasOf = object;
+}
+
+void SkPDFCatalog::removeAlias(SkPDFObject* alias) {
+    SkASSERT(fIndexHashCount > 0 &&
+             fIndexHash[findIndexSlot(alias)].fAliasOf != NULL);
+    removeObjectIndex(alias);
+}
+
+bool SkPDFCatalog::hasFileOffset(SkPDFObject* obj) const {
+    int objIndex = findObjectIndex(obj);
+    return objIndex >= 0 && fCatalog[objIndex].fFileOffset > 0;
 }
 
 void SkPDFCatalog::emitObjectNumber(SkWStream* stream, SkPDFObject* obj) {
@@ -58,10 +95,79 @@ size_t SkPDFCatalog::getObjectNumberSize(SkPDFObject* obj) {
     return buffer.getOffset();
 }
 
+static uint32_t hash_object(const SkPDFObject* obj) {
+    // Mix the pointer bits, since the low ones are always the same.
+    uint32_t hash = (uint32_t)(uintptr_t)obj;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+int SkPDFCatalog::findIndexSlot(SkPDFObject* obj) const {
+    int mask = fIndexHash.count() - 1;
+    int slot = hash_object(obj) & mask;
+    while (fIndexHash[slot].fObject != NULL &&
+           fIndexHash[slot].fObject != obj) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void SkPDFCatalog::setObjectIndex(SkPDFObject* obj, int index) {
+    SkASSERT(obj);
+    // Keep the table at most three quarters full.
+    if (4 * (fIndexHashCount + 1) > 3 * fIndexHash.count()) {
+        SkTDArray<IndexSlot> oldHash;
+        oldHash.swap(fIndexHash);
+        fIndexHash.setCount(SkMax32(64, 2 * oldHash.count()));
+        sk_bzero(fIndexHash.begin(), fIndexHash.count() * sizeof(IndexSlot));
+        for (int i = 0; i < oldHash.count(); i++) {
+            if (oldHash[i].fObject) {
+                fIndexHash[findIndexSlot(oldHash[i].fObject)] = oldHash[i];
+            }
+        }
+    }
+    int slot = findIndexSlot(obj);
+    if (NULL == fIndexHash[slot].fObject) {
+        fIndexHash[slot].fObject = obj;
+        fIndexHash[slot].fAliasOf = NULL;
+        fIndexHashCount++;
+    }
+    SkASSERT(NULL == fIndexHash[slot].fAliasOf);
+    fIndexHash[slot].fIndex = index;
+}
+
+void SkPDFCatalog::removeObjectIndex(SkPDFObject* obj) {
+    int mask = fIndexHash.count() - 1;
+    int empty = findIndexSlot(obj);
+    SkASSERT(fIndexHash[empty].fObject == obj);
+    fIndexHash[empty].fObject = NULL;
+    fIndexHashCount--;
+    // Move back any following entry that can no longer be reached because
+    // its probe sequence passes through the emptied slot.
+    for (int slot = (empty + 1) & mask;
+         fIndexHash[slot].fObject != NULL;
+         slot = (slot + 1) & mask) {
+        int home = hash_object(fIndexHash[slot].fObject) & mask;
+        bool reachable = empty <= slot ? (empty < home && home <= slot)
+                                       : (empty < home || home <= slot);
+        if (!reachable) {
+            fIndexHash[empty] = fIndexHash[slot];
+            fIndexHash[slot].fObject = NULL;
+            empty = slot;
+        }
+    }
+}
+
 int SkPDFCatalog::findObjectIndex(SkPDFObject* obj) const {
-    for (int i = 0; i < fCatalog.count(); i++) {
-        if (fCatalog[i].fObject == obj) {
-            return i;
+    if (fIndexHashCount > 0) {
+        int slot = findIndexSlot(obj);
+        if (fIndexHash[slot].fObject == obj) {
+            if (fIndexHash[slot].fAliasOf) {
+                return findObjectIndex(fIndexHash[slot].fAliasOf);
+            }
+            return fIndexHash[slot].fIndex;
         }
     }
     // If it's not in the main array, check if it's a substitute object.
@@ -102,6 +208,10 @@ int SkPDFCatalog::assignObjNum(SkPDFObject* obj) {
     SkASSERT(!fCatalog[objNum - 1].fObjNumAssigned);
     if (objNum - 1 != currentIndex) {
         SkTSwap(fCatalog[objNum - 1], fCatalog[currentIndex]);
+        if (fCatalog[currentIndex].fObject) {
+            setObjectIndex(fCatalog[currentIndex].fObject, currentIndex);
+        }
+        setObjectIndex(fCatalog[objNum - 1].fObject, objNum - 1);
     }
     fCatalog[objNum - 1].fObjNumAssigned = true;
     return objNum;
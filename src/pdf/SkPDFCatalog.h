@@ -44,6 +44,36 @@ public:
      */
     size_t setFileOffset(SkPDFObject* obj, off_t offset);
 
+    /** Inform the catalog of the object's position in the output stream,
+     *  without computing its size. For callers that are about to emit the
+     *  object at that position.
+     *  @param obj         The object to add.
+     *  @param offset      The byte offset in the output stream of this object.
+     */
+    void recordFileOffset(SkPDFObject* obj, off_t offset);
+
+    /** Return true if the passed object is in the catalog and has been
+     *  given a file offset, i.e. it has been (or is being) emitted.
+     */
+    bool hasFileOffset(SkPDFObject* obj) const;
+
+    /** Stop tracking the passed object, which has already been numbered
+     *  and emitted. Its cross reference entry is kept, but the object may be
+     *  freed, and if the same pointer is added again, it is treated as a new
+     *  object.
+     */
+    void forgetObject(SkPDFObject* obj);
+
+    /** Make references to alias refer to object instead, so that alias
+     *  itself is never written.  object must be in the catalog by the time
+     *  alias is referred to; alias must not be in the catalog.
+     */
+    void setAlias(SkPDFObject* alias, SkPDFObject* object);
+
+    /** Undo setAlias(), e.g. because alias is about to be freed.
+     */
+    void removeAlias(SkPDFObject* alias);
+
     /** Output the object number for the passed object.
      *  @param obj         The object of interest.
      *  @param stream      The writable output stream to send the output to.
@@ -60,6 +90,12 @@ public:
      */
     SkPDFDocument::Flags getDocumentFlags() const { return fDocumentFlags; }
 
+    /** Set and return the flate compression level used for streams in this
+     *  catalog/document (see SkFlate).
+     */
+    void setCompressionLevel(int level) { fCompressionLevel = level; }
+    int getCompressionLevel() const { return fCompressionLevel; }
+
     /** Output the cross reference table for objects in the catalog.
      *  Returns the total number of objects.
      *  @param stream      The writable output stream to send the output to.
@@ -110,9 +146,21 @@ private:
         SkPDFObject* fSubstitute;
     };
 
-    // TODO(vandebo): Make this a hash if it's a performance problem.
     SkTDArray<struct Rec> fCatalog;
 
+    // Maps each object in fCatalog to its index, so that finding an object
+    // doesn't take time proportional to the size of the catalog (which only
+    // grows while a document is streamed).  Open addressing with linear
+    // probing; a NULL fObject marks an empty slot.  Aliases (setAlias())
+    // are kept here too, with the object they stand for instead of an index.
+    struct IndexSlot {
+        SkPDFObject* fObject;
+        int fIndex;
+        SkPDFObject* fAliasOf;
+    };
+    SkTDArray<IndexSlot> fIndexHash;
+    int fIndexHashCount;
+
     // TODO(arthurhsu): Make this a hash if it's a performance problem.
     SkTDArray<SubstituteMapping> fSubstituteMap;
     SkTDArray<SkPDFObject*> fSubstituteResourcesFirstPage;
@@ -126,9 +174,16 @@ private:
     uint32_t fNextFirstPageObjNum;
 
     SkPDFDocument::Flags fDocumentFlags;
+    int fCompressionLevel;
 
     int findObjectIndex(SkPDFObject* obj) const;
 
+    // Return the slot of fIndexHash holding obj, or the empty slot where it
+    // would go.  fIndexHash must not be empty.
+    int findIndexSlot(SkPDFObject* obj) const;
+    void setObjectIndex(SkPDFObject* obj, int index);
+    void removeObjectIndex(SkPDFObject* obj);
+
     int assignObjNum(SkPDFObject* obj);
 
     SkTDArray<SkPDFObject*>* getSubstituteList(bool firstPage);
@@ -157,12 +157,31 @@ GraphicStateEntry::GraphicStateEntry() : fColor(SK_ColorBLACK),
     fMatrix.reset();
 }
 
+// SkClipStack::operator== also compares the save count of each clip, which
+// doesn't change the clip.  Comparing that would make every save()/restore()
+// pair around a draw look like a clip change, and we'd pop the graphic state
+// stack and reemit the whole clip for it.
+static bool clip_stacks_equal(const SkClipStack& a, const SkClipStack& b) {
+    SkClipStack::B2TIter aIter(a);
+    SkClipStack::B2TIter bIter(b);
+    const SkClipStack::B2TIter::Clip* aClip = aIter.next();
+    const SkClipStack::B2TIter::Clip* bClip = bIter.next();
+    while (aClip && bClip) {
+        if (*aClip != *bClip) {
+            return false;
+        }
+        aClip = aIter.next();
+        bClip = bIter.next();
+    }
+    return aClip == NULL && bClip == NULL;
+}
+
 bool GraphicStateEntry::compareInitialState(const GraphicStateEntry& b) {
     return fColor == b.fColor &&
            fShaderIndex == b.fShaderIndex &&
            fGraphicStateIndex == b.fGraphicStateIndex &&
            fMatrix == b.fMatrix &&
-           fClipStack == b.fClipStack &&
+           clip_stacks_equal(fClipStack, b.fClipStack) &&
                (fTextScaleX == 0 ||
                 b.fTextScaleX == 0 ||
                 (fTextScaleX == b.fTextScaleX && fTextFill == b.fTextFill));
@@ -274,19 +293,100 @@ static void emit_clip(SkPath* clipPath, SkRect* clipRect,
     }
 }
 
-// TODO(vandebo): Take advantage of SkClipStack::getSaveCount(), the PDF
-// graphic state stack, and the fact that we can know all the clips used
-// on the page to optimize this.
+// Emit the remaining (intersect) clips of iter, translated into content
+// coordinates.
+static void emit_intersect_clips(SkClipStack::Iter* iter,
+                                 const SkPoint& translation,
+                                 SkWStream* contentStream) {
+    SkMatrix transform;
+    transform.setTranslate(translation.fX, translation.fY);
+    const SkClipStack::B2TIter::Clip* clipEntry;
+    for (clipEntry = iter->next(); clipEntry; clipEntry = iter->next()) {
+        SkASSERT(clipEntry->fOp == SkRegion::kIntersect_Op);
+        if (clipEntry->fRect) {
+            SkRect translatedClip;
+            transform.mapRect(&translatedClip, *clipEntry->fRect);
+            emit_clip(NULL, &translatedClip, contentStream);
+        } else if (clipEntry->fPath) {
+            SkPath translatedPath;
+            clipEntry->fPath->transform(transform, &translatedPath);
+            emit_clip(&translatedPath, NULL, contentStream);
+        } else {
+            SkASSERT(false);
+        }
+    }
+}
+
+// If stack is prefix followed by one or more clips that only intersect it,
+// position iter after prefix and return true.  Unlike skip_clip_stack_prefix,
+// prefix must match exactly.
+static bool skip_clip_stack_extension(const SkClipStack& prefix,
+                                      const SkClipStack& stack,
+                                      SkClipStack::Iter* iter) {
+    SkClipStack::B2TIter prefixIter(prefix);
+    SkClipStack::B2TIter stackIter(stack);
+    int prefixCount = 0;
+    const SkClipStack::B2TIter::Clip* prefixEntry;
+    const SkClipStack::B2TIter::Clip* stackEntry;
+    for (prefixEntry = prefixIter.next(); prefixEntry;
+            prefixEntry = prefixIter.next()) {
+        stackEntry = stackIter.next();
+        if (!stackEntry || *stackEntry != *prefixEntry) {
+            return false;
+        }
+        prefixCount++;
+    }
+
+    bool extended = false;
+    for (stackEntry = stackIter.next(); stackEntry;
+            stackEntry = stackIter.next()) {
+        if (stackEntry->fOp != SkRegion::kIntersect_Op ||
+                (!stackEntry->fRect && !stackEntry->fPath) ||
+                (stackEntry->fPath && stackEntry->fPath->isInverseFillType())) {
+            return false;
+        }
+        extended = true;
+    }
+    if (!extended) {
+        return false;
+    }
+
+    iter->reset(stack, SkClipStack::Iter::kBottom_IterStart);
+    for (int i = 0; i < prefixCount; i++) {
+        iter->next();
+    }
+    return true;
+}
+
+// TODO(vandebo): Take advantage of the fact that we can know all the clips
+// used on the page to optimize this.
 void GraphicStackState::updateClip(const SkClipStack& clipStack,
                                    const SkRegion& clipRegion,
                                    const SkPoint& translation) {
-    if (clipStack == currentEntry()->fClipStack) {
+    if (clip_stacks_equal(clipStack, currentEntry()->fClipStack)) {
         return;
     }
 
-    while (fStackDepth > 0) {
+    // Find the innermost entry whose clip is the new clip or a prefix of it.
+    // Clips are emitted in device space, so we can only add to the clip of an
+    // entry that doesn't have a matrix.  Leave room for updateMatrix's push.
+    for (;;) {
+        SkClipStack::Iter iter;
+        if (currentEntry()->fMatrix.getType() == SkMatrix::kIdentity_Mask &&
+                fStackDepth + 1 < kMaxStackDepth &&
+                skip_clip_stack_extension(currentEntry()->fClipStack,
+                                          clipStack, &iter)) {
+            push();
+            emit_intersect_clips(&iter, translation, fContentStream);
+            currentEntry()->fClipStack = clipStack;
+            currentEntry()->fClipRegion = clipRegion;
+            return;
+        }
+        if (fStackDepth == 0) {
+            break;
+        }
         pop();
-        if (clipStack == currentEntry()->fClipStack) {
+        if (clip_stacks_equal(clipStack, currentEntry()->fClipStack)) {
             return;
         }
     }
@@ -321,23 +421,7 @@ void GraphicStackState::updateClip(const SkClipStack& clipStack,
         emit_clip(&clipPath, NULL, fContentStream);
     } else {
         skip_clip_stack_prefix(fEntries[0].fClipStack, clipStack, &iter);
-        SkMatrix transform;
-        transform.setTranslate(translation.fX, translation.fY);
-        const SkClipStack::B2TIter::Clip* clipEntry;
-        for (clipEntry = iter.next(); clipEntry; clipEntry = iter.next()) {
-            SkASSERT(clipEntry->fOp == SkRegion::kIntersect_Op);
-            if (clipEntry->fRect) {
-                SkRect translatedClip;
-                transform.mapRect(&translatedClip, *clipEntry->fRect);
-                emit_clip(NULL, &translatedClip, fContentStream);
-            } else if (clipEntry->fPath) {
-                SkPath translatedPath;
-                clipEntry->fPath->transform(transform, &translatedPath);
-                emit_clip(&translatedPath, NULL, fContentStream);
-            } else {
-                SkASSERT(false);
-            }
-        }
+        emit_intersect_clips(&iter, translation, fContentStream);
     }
     currentEntry()->fClipStack = clipStack;
     currentEntry()->fClipRegion = clipRegion;
@@ -557,13 +641,14 @@ void SkPDFDevice::init() {
     }
 }
 
-void SkPDFDevice::cleanUp(bool clearFontUsage) {
+void SkPDFDevice::cleanUp(bool clearUsage) {
     fGraphicStateResources.unrefAll();
     fXObjectResources.unrefAll();
     fFontResources.unrefAll();
     fShaderResources.unrefAll();
-    if (clearFontUsage) {
+    if (clearUsage) {
         fFontGlyphUsage->reset();
+        fImageResources.unrefAll();
     }
 }
 
@@ -947,8 +1032,15 @@ void SkPDFDevice::drawDevice(const SkDraw& d, SkDevice* device, int x, int y,
     SkPDFUtils::DrawFormXObject(fXObjectResources.count() - 1,
                                 &content.entry()->fContent);
 
-    // Merge glyph sets from the drawn device.
+    // Merge glyph sets and images from the drawn device.
     fFontGlyphUsage->merge(pdfDevice->getFontGlyphUsage());
+    const SkTDArray<SkPDFImage*>& images = pdfDevice->getImageResources();
+    for (int i = 0; i < images.count(); i++) {
+        if (fImageResources.find(images[i]) < 0) {
+            images[i]->ref();
+            fImageResources.push(images[i]);
+        }
+    }
 }
 
 void SkPDFDevice::onAttachToCanvas(SkCanvas* canvas) {
@@ -1133,6 +1225,12 @@ void SkPDFDevice::copyContentEntriesToData(ContentEntry* entry,
     // right thing to pass here.
     GraphicStackState gsState(fExistingClipStack, fExistingClipRegion, data);
     while (entry != NULL) {
+        // An entry can end up empty, e.g. if nothing was drawn after it was
+        // set up; don't change the state just to draw nothing.
+        if (entry->fContent.getOffset() == 0) {
+            entry = entry->fNext.get();
+            continue;
+        }
         SkPoint translation;
         translation.iset(this->getOrigin());
         translation.negate();
@@ -1232,8 +1330,8 @@ void SkPDFDevice::createFormXObjectFromDevice(
     *xobject = new SkPDFFormXObject(this);
     (*xobject)->unref();  // SkRefPtr and new both took a reference.
     // We always draw the form xobjects that we create back into the device, so
-    // we simply preserve the font usage instead of pulling it out and merging
-    // it back in later.
+    // we simply preserve the font usage (and images) instead of pulling it out
+    // and merging it back in later.
     cleanUp(false);  // Reset this device to have no content.
     init();
 }
@@ -1610,14 +1708,29 @@ void SkPDFDevice::internalDrawBitmap(const SkMatrix& matrix,
         return;
     }
 
-    SkPDFImage* image = SkPDFImage::CreateImage(bitmap, subset, paint);
+    // The same pixels may already have been drawn on this device.
+    SkPDFImage* image = NULL;
+    for (int i = 0; i < fImageResources.count(); i++) {
+        if (fImageResources[i]->isImageOf(bitmap, subset)) {
+            image = fImageResources[i];
+            break;
+        }
+    }
     if (!image) {
-        return;
+        image = SkPDFImage::CreateImage(bitmap, subset, paint);
+        if (!image) {
+            return;
+        }
+        fImageResources.push(image);  // Transfer reference.
     }
 
-    fXObjectResources.push(image);  // Transfer reference.
-    SkPDFUtils::DrawFormXObject(fXObjectResources.count() - 1,
-                                &content.entry()->fContent);
+    int xObjectIndex = fXObjectResources.find(image);
+    if (xObjectIndex < 0) {
+        xObjectIndex = fXObjectResources.count();
+        image->ref();
+        fXObjectResources.push(image);
+    }
+    SkPDFUtils::DrawFormXObject(xObjectIndex, &content.entry()->fContent);
 }
 
 bool SkPDFDevice::onReadPixels(const SkBitmap& bitmap, int x, int y,
@@ -7,13 +7,21 @@
  */
 
 
+#include "SkCanvas.h"
+#include "SkFlate.h"
 #include "SkPDFCatalog.h"
 #include "SkPDFDevice.h"
 #include "SkPDFDocument.h"
 #include "SkPDFFont.h"
+#include "SkPDFImage.h"
 #include "SkPDFPage.h"
+#include "SkPDFStream.h"
 #include "SkPDFTypes.h"
+#include "SkPicture.h"
+#include "SkRunnable.h"
 #include "SkStream.h"
+#include "SkThreadPool.h"
+#include "SkTypeface.h"
 
 // Add the resources, starting at firstIndex to the catalog, removing any dupes.
 // A hash table would be really nice here.
@@ -33,15 +41,11 @@ static void addResourcesToCatalog(int firstIndex, bool firstPage,
 }
 
 static void perform_font_subsetting(SkPDFCatalog* catalog,
-                                    const SkTDArray<SkPDFPage*>& pages,
+                                    const SkPDFGlyphSetMap& usage,
                                     SkTDArray<SkPDFObject*>* substitutes) {
     SkASSERT(catalog);
     SkASSERT(substitutes);
 
-    SkPDFGlyphSetMap usage;
-    for (int i = 0; i < pages.count(); ++i) {
-        usage.merge(pages[i]->getFontGlyphUsage());
-    }
     SkPDFGlyphSetMap::F2BIter iterator(usage);
     SkPDFGlyphSetMap::FontGlyphSetPair* entry = iterator.next();
     while (entry) {
@@ -55,9 +59,128 @@ static void perform_font_subsetting(SkPDFCatalog* catalog,
     }
 }
 
+static void perform_font_subsetting(SkPDFCatalog* catalog,
+                                    const SkTDArray<SkPDFPage*>& pages,
+                                    SkTDArray<SkPDFObject*>* substitutes) {
+    SkPDFGlyphSetMap usage;
+    for (int i = 0; i < pages.count(); ++i) {
+        usage.merge(pages[i]->getFontGlyphUsage());
+    }
+    perform_font_subsetting(catalog, usage, substitutes);
+}
+
+class SkPDFPrepareJob : public SkRunnable {
+public:
+    SkPDFPrepareJob() : fObject(NULL), fCatalog(NULL) {}
+
+    virtual void run() SK_OVERRIDE {
+        fObject->prepareToEmit(fCatalog);
+    }
+
+    SkPDFObject* fObject;
+    SkPDFCatalog* fCatalog;
+};
+
+// Do the expensive part of emitting the passed objects (i.e. compress the
+// streams) on up to threadCount threads.  The objects must be unique.  This
+// doesn't change the output; otherwise the work is done as each object is
+// emitted, on the calling thread.
+static void prepare_objects(const SkTDArray<SkPDFObject*>& objects,
+                            SkPDFCatalog* catalog, int threadCount) {
+    if (threadCount <= 1 || objects.count() <= 1) {
+        return;
+    }
+    SkAutoTArray<SkPDFPrepareJob> jobs(objects.count());
+    SkThreadPool pool(threadCount);
+    for (int i = 0; i < objects.count(); i++) {
+        jobs[i].fObject = objects[i];
+        jobs[i].fCatalog = catalog;
+        pool.add(&jobs[i]);
+    }
+    pool.wait();
+}
+
+class SkPDFDrawPictureJob : public SkRunnable {
+public:
+    SkPDFDrawPictureJob() : fPicture(NULL), fDevice(NULL) {}
+
+    virtual void run() SK_OVERRIDE {
+        SkCanvas canvas(fDevice);
+        fPicture->draw(&canvas);
+    }
+
+    SkPicture* fPicture;
+    SkPDFDevice* fDevice;
+};
+
+// Forwards everything to another stream, keeping track of how much has been
+// written, since the catalog needs the file offset of each object.
+class SkPDFOffsetWStream : public SkWStream {
+public:
+    explicit SkPDFOffsetWStream(SkWStream* stream)
+        : fStream(stream),
+          fOffset(0) {
+    }
+
+    virtual bool write(const void* buffer, size_t size) SK_OVERRIDE {
+        fOffset += size;
+        return fStream->write(buffer, size);
+    }
+
+    virtual void flush() SK_OVERRIDE {
+        fStream->flush();
+    }
+
+    off_t getOffset() const { return fOffset; }
+
+private:
+    SkWStream* fStream;
+    off_t fOffset;
+};
+
+struct SkPDFDocument::StreamState {
+    explicit StreamState(SkWStream* stream)
+        : fStream(stream),
+          fPageCount(0),
+          fEnded(false) {
+        fPageTreeRoot = new SkPDFDict("Pages");
+        fPageTreeRoot->unref();  // SkRefPtr and new both took a reference.
+        fKids = new SkPDFArray;
+        fKids->unref();  // SkRefPtr and new both took a reference.
+        fPageTreeRoot->insert("Kids", fKids.get());
+    }
+
+    ~StreamState() {
+        fFontResources.safeUnrefAll();
+        fWrittenResources.safeUnrefAll();
+    }
+
+    SkPDFOffsetWStream fStream;
+
+    // All pages are direct children of a single page tree node, which
+    // doesn't need to be written until the page count is known.
+    SkRefPtr<SkPDFDict> fPageTreeRoot;
+    SkRefPtr<SkPDFArray> fKids;
+    int fPageCount;
+
+    // The fonts used so far, and the glyphs used from them.  The fonts and
+    // their resources (fFontResources) are written by endStream().
+    SkPDFGlyphSetMap fGlyphUsage;
+    SkTDArray<SkPDFFont*> fFonts;
+    SkTDArray<SkPDFObject*> fFontResources;
+
+    // The other resources written so far.  They are kept, with their object
+    // numbers, so that later pages using the same (canonical) graphic states,
+    // images and shaders refer to the objects already written.
+    SkTDArray<SkPDFObject*> fWrittenResources;
+
+    bool fEnded;
+};
+
 SkPDFDocument::SkPDFDocument(Flags flags)
         : fXRefFileOffset(0),
-          fSecondPageFirstResourceIndex(0) {
+          fSecondPageFirstResourceIndex(0),
+          fThreadCount(1) {
     fCatalog.reset(new SkPDFCatalog(flags));
     fDocCatalog = new SkPDFDict("Catalog");
     fDocCatalog->unref();  // SkRefPtr and new both took a reference.
@@ -66,6 +189,7 @@ SkPDFDocument::SkPDFDocument(Flags flags)
 
 SkPDFDocument::~SkPDFDocument() {
     fPages.safeUnrefAll();
+    fStreamState.reset();
 
     // The page tree has both child and parent pointers, so it creates a
     // reference cycle.  We must clear that cycle to properly reclaim memory.
@@ -75,10 +199,11 @@ SkPDFDocument::~SkPDFDocument() {
     fPageTree.safeUnrefAll();
     fPageResources.safeUnrefAll();
     fSubstitutes.safeUnrefAll();
+    fImages.unrefAll();
 }
 
 bool SkPDFDocument::emitPDF(SkWStream* stream) {
-    if (fPages.isEmpty()) {
+    if (fPages.isEmpty() || fStreamState.get()) {
         return false;
     }
     for (int i = 0; i < fPages.count(); i++) {
@@ -109,7 +234,11 @@ bool SkPDFDocument::emitPDF(SkWStream* stream) {
         bool firstPage = true;
         for (int i = 0; i < fPages.count(); i++) {
             int resourceCount = fPageResources.count();
-            fPages[i]->finalizePage(fCatalog.get(), firstPage, &fPageResources);
+            SkTDArray<SkPDFObject*> resources;
+            SkTDArray<SkPDFImage*> aliases;
+            fPages[i]->finalizePage(fCatalog.get(), firstPage, &resources);
+            canonicalizeImages(fPages[i], &resources, &aliases);
+            fPageResources.append(resources.count(), resources.begin());
             addResourcesToCatalog(resourceCount, firstPage, &fPageResources,
                                   fCatalog.get());
             if (i == 0) {
@@ -118,6 +247,13 @@ bool SkPDFDocument::emitPDF(SkWStream* stream) {
             }
         }
 
+        SkTDArray<SkPDFObject*> objects;
+        objects.append(fPageResources.count(), fPageResources.begin());
+        for (int i = 0; i < fPages.count(); i++) {
+            objects.push(fPages[i]->getContentStream());
+        }
+        prepare_objects(objects, fCatalog.get(), fThreadCount);
+
         // Build font subsetting info before proceeding.
         perform_font_subsetting(fCatalog.get(), fPages, &fSubstitutes);
 
@@ -193,7 +329,7 @@ bool SkPDFDocument::emitPDF(SkWStream* stream) {
 }
 
 bool SkPDFDocument::setPage(int pageNumber, SkPDFDevice* pdfDevice) {
-    if (!fPageTree.isEmpty()) {
+    if (!fPageTree.isEmpty() || fStreamState.get()) {
         return false;
     }
 
@@ -219,22 +355,296 @@ bool SkPDFDocument::appendPage(SkPDFDevice* pdfDevice) {
         return false;
     }
 
+    if (fStreamState.get()) {
+        if (fStreamState->fEnded) {
+            return false;
+        }
+        SkRefPtr<SkPDFPage> page = new SkPDFPage(pdfDevice);
+        page->unref();  // SkRefPtr and new both took a reference.
+        streamPage(page.get());
+        return true;
+    }
+
     SkPDFPage* page = new SkPDFPage(pdfDevice);
     fPages.push(page);  // Reference from new passed to fPages.
     return true;
 }
 
+bool SkPDFDocument::appendPictures(SkPicture* const pictures[], int count) {
+    if (!fPageTree.isEmpty() ||
+            (fStreamState.get() && fStreamState->fEnded)) {
+        return false;
+    }
+
+    // The pages are drawn a batch at a time, so that no more than a few
+    // pages are held in memory (in addition to the document's own pages) and
+    // a streamed document is written as it goes.  Appending the pages in
+    // order, on this thread, means that resources are numbered and written
+    // exactly as they are when pages are drawn one at a time.
+    const int batchSize = fThreadCount > 1 ? 2 * fThreadCount : 1;
+    SkAutoTArray<SkPDFDrawPictureJob> jobs(batchSize);
+    for (int first = 0; first < count; first += batchSize) {
+        int last = SkMin32(first + batchSize, count);
+        SkTDArray<SkPicture*> clones;
+        for (int i = first; i < last; i++) {
+            SkPicture* picture = pictures[i];
+            // Playback isn't thread safe, so a picture that appears more
+            // than once in a batch gets a copy for each extra use.
+            bool seen = false;
+            for (int j = first; j < i; j++) {
+                seen |= pictures[j] == picture;
+            }
+            if (seen) {
+                picture = picture->clone();
+                *clones.append() = picture;
+            } else {
+                picture->endRecording();
+            }
+            SkISize size = SkISize::Make(picture->width(), picture->height());
+            SkPDFDrawPictureJob& job = jobs[i - first];
+            job.fPicture = picture;
+            job.fDevice = SkNEW_ARGS(SkPDFDevice, (size, size, SkMatrix::I()));
+        }
+
+        if (last - first > 1) {
+            SkThreadPool pool(SkMin32(fThreadCount, last - first));
+            for (int i = first; i < last; i++) {
+                pool.add(&jobs[i - first]);
+            }
+            pool.wait();
+        } else {
+            jobs[0].run();
+        }
+
+        bool success = true;
+        for (int i = first; i < last; i++) {
+            SkPDFDevice* device = jobs[i - first].fDevice;
+            success = success && this->appendPage(device);
+            device->unref();
+        }
+        clones.unrefAll();
+        if (!success) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SkPDFDocument::beginStream(SkWStream* stream) {
+    if (!fPages.isEmpty() || !fPageTree.isEmpty() || fStreamState.get()) {
+        return false;
+    }
+
+    // Nothing is on the first page when streaming; objects are numbered in
+    // the order they are written.
+    int compressionLevel = fCatalog->getCompressionLevel();
+    fCatalog.reset(new SkPDFCatalog(fCatalog->getDocumentFlags()));
+    fCatalog->setCompressionLevel(compressionLevel);
+    fCatalog->addObject(fDocCatalog.get(), false);
+
+    fStreamState.reset(new StreamState(stream));
+    fCatalog->addObject(fStreamState->fPageTreeRoot.get(), false);
+    emitHeader(&fStreamState->fStream);
+    return true;
+}
+
+void SkPDFDocument::streamPage(SkPDFPage* page) {
+    StreamState* state = fStreamState.get();
+    SkPDFCatalog* catalog = fCatalog.get();
+
+    SkTDArray<SkPDFObject*> resources;
+    SkTDArray<SkPDFImage*> aliases;
+    page->finalizePage(catalog, false, &resources);
+    canonicalizeImages(page, &resources, &aliases);
+    page->insert("Parent",
+                 new SkPDFObjRef(state->fPageTreeRoot.get()))->unref();
+    state->fKids->append(new SkPDFObjRef(page))->unref();
+    catalog->addObject(page, false);
+    state->fPageCount++;
+
+    // Fonts can't be written until the glyphs used by the whole document
+    // are known, so keep them (and everything they reference) until the end.
+    const SkPDFGlyphSetMap& usage = page->getFontGlyphUsage();
+    state->fGlyphUsage.merge(usage);
+    SkTDArray<SkPDFFont*> fonts;
+    fonts.append(page->getFontResources().count(),
+                 page->getFontResources().begin());
+    SkPDFGlyphSetMap::F2BIter iterator(usage);
+    for (SkPDFGlyphSetMap::FontGlyphSetPair* entry = iterator.next();
+         entry;
+         entry = iterator.next()) {
+        fonts.push(entry->fFont);
+    }
+    for (int i = 0; i < fonts.count(); i++) {
+        if (state->fFonts.find(fonts[i]) != -1) {
+            continue;
+        }
+        state->fFonts.push(fonts[i]);
+        int resourceCount = state->fFontResources.count();
+        fonts[i]->ref();
+        state->fFontResources.push(fonts[i]);
+        fonts[i]->getResources(&state->fFontResources);
+        for (int j = resourceCount; j < state->fFontResources.count(); j++) {
+            SkPDFObject* resource = state->fFontResources[j];
+            if (state->fFontResources.find(resource) != j) {
+                resource->unref();
+                state->fFontResources.removeShuffle(j);
+                j--;
+            } else {
+                catalog->addObject(resource, false);
+            }
+        }
+    }
+
+    // Everything else the page uses is written now, unless an earlier page
+    // already wrote it.
+    for (int i = 0; i < resources.count(); i++) {
+        if (state->fFontResources.find(resources[i]) != -1 ||
+                catalog->hasFileOffset(resources[i])) {
+            resources[i]->unref();
+            resources.removeShuffle(i);
+            i--;
+        }
+    }
+    addResourcesToCatalog(0, false, &resources, catalog);
+
+    SkPDFStream* content = page->getContentStream();
+    resources.push(content);
+    prepare_objects(resources, catalog, fThreadCount);
+    resources.pop();
+
+    SkPDFOffsetWStream* stream = &state->fStream;
+    catalog->recordFileOffset(page, stream->getOffset());
+    page->emit(stream, catalog, true);
+    catalog->recordFileOffset(content, stream->getOffset());
+    content->emit(stream, catalog, true);
+    for (int i = 0; i < resources.count(); i++) {
+        catalog->recordFileOffset(resources[i], stream->getOffset());
+        resources[i]->emit(stream, catalog, true);
+    }
+
+    catalog->forgetObject(content);
+    // The page's duplicate images go away with its content.
+    for (int i = 0; i < aliases.count(); i++) {
+        catalog->removeAlias(aliases[i]);
+    }
+    // Transfer the references to fWrittenResources.
+    state->fWrittenResources.append(resources.count(), resources.begin());
+    // The page itself stays in the catalog, so the page tree can refer to it.
+    page->releaseContent();
+}
+
+void SkPDFDocument::canonicalizeImages(SkPDFPage* page,
+                                       SkTDArray<SkPDFObject*>* resourceList,
+                                       SkTDArray<SkPDFImage*>* aliases) {
+    const SkTDArray<SkPDFImage*>& images = page->getImageResources();
+    SkTDArray<SkPDFObject*> unused;
+    for (int i = 0; i < images.count(); i++) {
+        SkPDFImage* image = images[i];
+        // Skip images that were drawn into content that was then dropped.
+        if (fImages.find(image) >= 0 || aliases->find(image) >= 0 ||
+                resourceList->find(image) < 0) {
+            continue;
+        }
+        SkPDFImage* canonical = NULL;
+        for (int j = 0; j < fImages.count(); j++) {
+            if (fImages[j]->matches(image)) {
+                canonical = fImages[j];
+                break;
+            }
+        }
+        if (NULL == canonical) {
+            image->ref();
+            fImages.push(image);
+            continue;
+        }
+        fCatalog->setAlias(image, canonical);
+        aliases->push(image);
+        unused.push(image);
+        image->ref();
+        image->getResources(&unused);
+    }
+
+    for (int i = 0; i < resourceList->count(); i++) {
+        if (unused.find((*resourceList)[i]) >= 0) {
+            (*resourceList)[i]->unref();
+            resourceList->removeShuffle(i);
+            i--;
+        }
+    }
+    unused.unrefAll();
+}
+
+bool SkPDFDocument::endStream() {
+    StreamState* state = fStreamState.get();
+    if (NULL == state || state->fEnded || 0 == state->fPageCount) {
+        return false;
+    }
+    state->fEnded = true;
+    SkPDFCatalog* catalog = fCatalog.get();
+
+    prepare_objects(state->fFontResources, catalog, fThreadCount);
+    perform_font_subsetting(catalog, state->fGlyphUsage, &fSubstitutes);
+
+    state->fPageTreeRoot->insertInt("Count", state->fPageCount);
+    fDocCatalog->insert("Pages",
+            new SkPDFObjRef(state->fPageTreeRoot.get()))->unref();
+
+    SkPDFOffsetWStream* stream = &state->fStream;
+    catalog->recordFileOffset(state->fPageTreeRoot.get(), stream->getOffset());
+    state->fPageTreeRoot->emit(stream, catalog, true);
+    catalog->recordFileOffset(fDocCatalog.get(), stream->getOffset());
+    fDocCatalog->emit(stream, catalog, true);
+    for (int i = 0; i < state->fFontResources.count(); i++) {
+        catalog->recordFileOffset(state->fFontResources[i],
+                                  stream->getOffset());
+        state->fFontResources[i]->emit(stream, catalog, true);
+    }
+    catalog->setSubstituteResourcesOffsets(stream->getOffset(), false);
+    catalog->emitSubstituteResources(stream, false);
+
+    fXRefFileOffset = stream->getOffset();
+    int64_t objCount = catalog->emitXrefTable(stream, false);
+    emitFooter(stream, objCount);
+    stream->flush();
+    return true;
+}
+
+void SkPDFDocument::setCompressionLevel(int level) {
+    SkASSERT(level >= SkFlate::kDefault_CompressionLevel &&
+             level <= SkFlate::kMax_CompressionLevel);
+    fCatalog->setCompressionLevel(level);
+}
+
+void SkPDFDocument::setThreadCount(int count) {
+    fThreadCount = SkMax32(count, 1);
+}
+
 void SkPDFDocument::getCountOfFontTypes(
         int counts[SkAdvancedTypefaceMetrics::kNotEmbeddable_Font + 1]) const {
     sk_bzero(counts, sizeof(int) *
                      (SkAdvancedTypefaceMetrics::kNotEmbeddable_Font + 1));
     SkTDArray<SkFontID> seenFonts;
 
+    if (fStreamState.get()) {
+        // The pages have already been released.
+        const SkTDArray<SkPDFFont*>& fonts = fStreamState->fFonts;
+        for (int font = 0; font < fonts.count(); font++) {
+            SkFontID fontID = SkTypeface::UniqueID(fonts[font]->typeface());
+            if (seenFonts.find(fontID) == -1) {
+                counts[fonts[font]->getType()]++;
+                seenFonts.push(fontID);
+            }
+        }
+        return;
+    }
+
     for (int pageNumber = 0; pageNumber < fPages.count(); pageNumber++) {
         const SkTDArray<SkPDFFont*>& fontResources =
                 fPages[pageNumber]->getFontResources();
         for (int font = 0; font < fontResources.count(); font++) {
-            SkFontID fontID = fontResources[font]->typeface()->uniqueID();
+            SkFontID fontID =
+                    SkTypeface::UniqueID(fontResources[font]->typeface());
             if (seenFonts.find(fontID) == -1) {
                 counts[fontResources[font]->getType()]++;
                 seenFonts.push(fontID);
@@ -17,6 +17,7 @@
 #include "SkPDFDevice.h"
 #include "SkPDFFont.h"
 #include "SkPDFFontImpl.h"
+#include "SkPDFFontSubsetter.h"
 #include "SkPDFStream.h"
 #include "SkPDFTypes.h"
 #include "SkPDFUtils.h"
@@ -547,6 +548,16 @@ static int get_subset_font_stream(const char* fontName,
                                   const SkTypeface* typeface,
                                   const SkTDArray<uint32_t>& subset,
                                   SkPDFStream** fontStream) {
+    SkData* subsetData = SkPDFFontSubsetter::GetSubset(
+            SkTypeface::UniqueID(typeface),
+            SkPDFFontSubsetter::kTrueType_Format,
+            subset);
+    if (subsetData) {
+        SkAutoDataUnref aud(subsetData);
+        *fontStream = new SkPDFStream(subsetData);
+        return subsetData->size();
+    }
+
     SkRefPtr<SkStream> fontData =
             SkFontHost::OpenStream(SkTypeface::UniqueID(typeface));
     fontData->unref();  // SkRefPtr and OpenStream both took a ref.
@@ -1071,10 +1082,24 @@ bool SkPDFCIDFont::addFontDescriptor(int16_t defaultWidth,
         }
         case SkAdvancedTypefaceMetrics::kCFF_Font:
         case SkAdvancedTypefaceMetrics::kType1CID_Font: {
-            SkRefPtr<SkStream> fontData =
-                SkFontHost::OpenStream(SkTypeface::UniqueID(typeface()));
-            fontData->unref();  // SkRefPtr and OpenStream both took a ref.
-            SkRefPtr<SkPDFStream> fontStream = new SkPDFStream(fontData.get());
+            SkRefPtr<SkPDFStream> fontStream;
+            SkData* subsetData = NULL;
+            if (subset) {
+                subsetData = SkPDFFontSubsetter::GetSubset(
+                        SkTypeface::UniqueID(typeface()),
+                        SkPDFFontSubsetter::kCFF_Format,
+                        *subset);
+            }
+            if (subsetData) {
+                SkAutoDataUnref aud(subsetData);
+                fontStream = new SkPDFStream(subsetData);
+            } else {
+                // Fail over: just embed the whole font.
+                SkRefPtr<SkStream> fontData =
+                    SkFontHost::OpenStream(SkTypeface::UniqueID(typeface()));
+                fontData->unref();  // SkRefPtr and OpenStream both took a ref.
+                fontStream = new SkPDFStream(fontData.get());
+            }
             // SkRefPtr and new both ref()'d fontStream, pass one.
             addResource(fontStream.get());
 
@@ -1124,8 +1149,12 @@ bool SkPDFCIDFont::populate(const SkPDFGlyphSet* subset) {
         SkSafeUnref(fontMetrics.get());  // SkRefPtr and Get both took a ref
         setFontInfo(fontMetrics.get());
         addFontDescriptor(0, &glyphIDs);
-    } else {
+    } else if (subset) {
         // Other CID fonts
+        SkTDArray<uint32_t> glyphIDs;
+        subset->exportTo(&glyphIDs);
+        addFontDescriptor(0, &glyphIDs);
+    } else {
         addFontDescriptor(0, NULL);
     }
 
@@ -0,0 +1,1155 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+
+#include "SkPDFFontSubsetter.h"
+
+#include "SkBitSet.h"
+#include "SkChecksum.h"
+#include "SkData.h"
+#include "SkStream.h"
+#include "SkTDLinkedList.h"
+#include "SkThread.h"
+
+#ifndef SK_DEFAULT_PDF_FONT_SUBSET_CACHE_LIMIT
+    #define SK_DEFAULT_PDF_FONT_SUBSET_CACHE_LIMIT  (8 * 1024 * 1024)
+#endif
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// Big endian helpers
+///////////////////////////////////////////////////////////////////////////////
+
+uint16_t read_u16(const uint8_t* p) {
+    return (p[0] << 8) | p[1];
+}
+
+uint32_t read_u32(const uint8_t* p) {
+    return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+void write_u32(uint8_t* p, uint32_t value) {
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+void append_u16(SkTDArray<uint8_t>* dst, uint16_t value) {
+    uint8_t* p = dst->append(2);
+    p[0] = value >> 8;
+    p[1] = value;
+}
+
+void append_u32(SkTDArray<uint8_t>* dst, uint32_t value) {
+    write_u32(dst->append(4), value);
+}
+
+void append_bytes(SkTDArray<uint8_t>* dst, const uint8_t* src, size_t len) {
+    dst->append(len, src);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// sfnt
+///////////////////////////////////////////////////////////////////////////////
+
+const uint32_t kOpenTypeCFF_Version = SkSetFourByteTag('O', 'T', 'T', 'O');
+const uint32_t kMacTrueType_Version = SkSetFourByteTag('t', 'r', 'u', 'e');
+const uint32_t kWindowsTrueType_Version = 0x00010000;
+
+const uint32_t kCFF_Tag = SkSetFourByteTag('C', 'F', 'F', ' ');
+const uint32_t kGlyf_Tag = SkSetFourByteTag('g', 'l', 'y', 'f');
+const uint32_t kHead_Tag = SkSetFourByteTag('h', 'e', 'a', 'd');
+const uint32_t kLoca_Tag = SkSetFourByteTag('l', 'o', 'c', 'a');
+const uint32_t kMaxp_Tag = SkSetFourByteTag('m', 'a', 'x', 'p');
+
+// The tables a PDF viewer uses from an embedded TrueType font (PDF 1.4
+// section 5.8), plus cmap and OS/2, which some viewers check for.
+const uint32_t gTrueTypeTablesToKeep[] = {
+    SkSetFourByteTag('O', 'S', '/', '2'),
+    SkSetFourByteTag('c', 'm', 'a', 'p'),
+    SkSetFourByteTag('c', 'v', 't', ' '),
+    SkSetFourByteTag('f', 'p', 'g', 'm'),
+    kGlyf_Tag,
+    kHead_Tag,
+    SkSetFourByteTag('h', 'h', 'e', 'a'),
+    SkSetFourByteTag('h', 'm', 't', 'x'),
+    kLoca_Tag,
+    kMaxp_Tag,
+    SkSetFourByteTag('p', 'r', 'e', 'p'),
+};
+
+// Offsets into the head table.
+const size_t kHeadCheckSumAdjustment_Offset = 8;
+const size_t kHeadIndexToLocFormat_Offset = 50;
+const size_t kHeadMinLength = 54;
+const uint32_t kSfntChecksumMagic = 0xB1B0AFBA;
+
+// Offsets into the maxp table.
+const size_t kMaxpNumGlyphs_Offset = 4;
+const size_t kMaxpMinLength = 6;
+
+// Composite glyph flags.
+const uint16_t kArgsAreWords_CompositeFlag = 0x0001;
+const uint16_t kHaveScale_CompositeFlag = 0x0008;
+const uint16_t kMoreComponents_CompositeFlag = 0x0020;
+const uint16_t kHaveXYScale_CompositeFlag = 0x0040;
+const uint16_t kHaveTwoByTwo_CompositeFlag = 0x0080;
+
+const size_t kGlyphHeaderLength = 10;
+
+struct SfntTable {
+    uint32_t        fTag;
+    const uint8_t*  fData;
+    size_t          fLength;
+};
+
+bool read_sfnt_tables(const uint8_t* data, size_t size,
+                      SkTDArray<SfntTable>* tables) {
+    if (size < 12) {
+        return false;
+    }
+    int numTables = read_u16(data + 4);
+    if (12 + 16 * (size_t)numTables > size) {
+        return false;
+    }
+    for (int i = 0; i < numTables; i++) {
+        const uint8_t* entry = data + 12 + 16 * i;
+        uint32_t offset = read_u32(entry + 8);
+        uint32_t length = read_u32(entry + 12);
+        if (offset > size || length > size - offset) {
+            return false;
+        }
+        SfntTable* table = tables->append();
+        table->fTag = read_u32(entry);
+        table->fData = data + offset;
+        table->fLength = length;
+    }
+    return true;
+}
+
+const SfntTable* find_table(const SkTDArray<SfntTable>& tables, uint32_t tag) {
+    for (int i = 0; i < tables.count(); i++) {
+        if (tables[i].fTag == tag) {
+            return &tables[i];
+        }
+    }
+    return NULL;
+}
+
+uint32_t sfnt_checksum(const uint8_t* data, size_t length) {
+    SkASSERT(SkIsAlign4(length));
+    uint32_t sum = 0;
+    for (size_t i = 0; i < length; i += 4) {
+        sum += read_u32(data + i);
+    }
+    return sum;
+}
+
+// Assemble an sfnt font from tables, which are in tag order, and compute its
+// checksums.
+SkData* write_sfnt(uint32_t version, const SkTDArray<SfntTable>& tables) {
+    int numTables = tables.count();
+    int entrySelector = 0;
+    while ((2 << entrySelector) <= numTables) {
+        entrySelector++;
+    }
+    int searchRange = (1 << entrySelector) * 16;
+
+    size_t size = 12 + 16 * numTables;
+    for (int i = 0; i < numTables; i++) {
+        size += SkAlign4(tables[i].fLength);
+    }
+    uint8_t* data = (uint8_t*)sk_malloc_throw(size);
+    memset(data, 0, size);
+
+    write_u32(data, version);
+    data[4] = numTables >> 8;
+    data[5] = numTables;
+    data[6] = searchRange >> 8;
+    data[7] = searchRange;
+    data[8] = entrySelector >> 8;
+    data[9] = entrySelector;
+    data[10] = (numTables * 16 - searchRange) >> 8;
+    data[11] = (numTables * 16 - searchRange);
+
+    uint8_t* head = NULL;
+    size_t offset = 12 + 16 * numTables;
+    for (int i = 0; i < numTables; i++) {
+        const SfntTable& table = tables[i];
+        uint8_t* dst = data + offset;
+        memcpy(dst, table.fData, table.fLength);
+        if (kHead_Tag == table.fTag) {
+            head = dst;
+            write_u32(head + kHeadCheckSumAdjustment_Offset, 0);
+        }
+
+        uint8_t* entry = data + 12 + 16 * i;
+        write_u32(entry, table.fTag);
+        write_u32(entry + 4, sfnt_checksum(dst, SkAlign4(table.fLength)));
+        write_u32(entry + 8, offset);
+        write_u32(entry + 12, table.fLength);
+        offset += SkAlign4(table.fLength);
+    }
+    SkASSERT(offset == size);
+
+    if (head) {
+        write_u32(head + kHeadCheckSumAdjustment_Offset,
+                  kSfntChecksumMagic - sfnt_checksum(data, size));
+    }
+    return SkData::NewFromMalloc(data, size);
+}
+
+// Add the glyphs that the composite glyph at data is built from to used and
+// pending.
+void add_components(const uint8_t* data, size_t length, int numGlyphs,
+                    SkBitSet* used, SkTDArray<int>* pending) {
+    if (length < kGlyphHeaderLength || (int16_t)read_u16(data) >= 0) {
+        return;  // Not a composite glyph.
+    }
+    const uint8_t* p = data + kGlyphHeaderLength;
+    const uint8_t* end = data + length;
+    while (p + 4 <= end) {
+        uint16_t flags = read_u16(p);
+        int component = read_u16(p + 2);
+        p += 4;
+        p += (flags & kArgsAreWords_CompositeFlag) ? 4 : 2;
+        if (flags & kHaveScale_CompositeFlag) {
+            p += 2;
+        } else if (flags & kHaveXYScale_CompositeFlag) {
+            p += 4;
+        } else if (flags & kHaveTwoByTwo_CompositeFlag) {
+            p += 8;
+        }
+        if (component < numGlyphs && !used->isBitSet(component)) {
+            used->setBit(component, true);
+            *pending->append() = component;
+        }
+        if (!(flags & kMoreComponents_CompositeFlag)) {
+            break;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CFF
+///////////////////////////////////////////////////////////////////////////////
+
+// Two byte DICT operators are stored as kEscape_CFFOp + the second byte.
+const int kEscape_CFFOp = 1200;
+const int kCharset_CFFOp = 15;
+const int kEncoding_CFFOp = 16;
+const int kCharStrings_CFFOp = 17;
+const int kPrivate_CFFOp = 18;
+const int kSubrs_CFFOp = 19;
+const int kCharstringType_CFFOp = kEscape_CFFOp + 6;
+const int kFDArray_CFFOp = kEscape_CFFOp + 36;
+const int kFDSelect_CFFOp = kEscape_CFFOp + 37;
+
+const uint8_t kEndChar_Type2Op = 14;
+
+struct CFFIndex {
+    int     fCount;
+    int     fOffSize;
+    size_t  fOffsets;   // where the offset array starts
+    size_t  fData;      // offsets are relative to the byte before this
+    size_t  fEnd;
+};
+
+uint32_t read_cff_offset(const uint8_t* p, int offSize) {
+    uint32_t value = 0;
+    for (int i = 0; i < offSize; i++) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+bool parse_cff_index(const uint8_t* data, size_t size, size_t start,
+                     CFFIndex* index) {
+    if (start > size || size - start < 2) {
+        return false;
+    }
+    index->fCount = read_u16(data + start);
+    if (0 == index->fCount) {
+        index->fOffSize = 0;
+        index->fOffsets = index->fData = index->fEnd = start + 2;
+        return true;
+    }
+    if (size - start < 3) {
+        return false;
+    }
+    index->fOffSize = data[start + 2];
+    if (index->fOffSize < 1 || index->fOffSize > 4) {
+        return false;
+    }
+    index->fOffsets = start + 3;
+    size_t offsetsLength = (index->fCount + 1) * index->fOffSize;
+    if (offsetsLength > size - index->fOffsets) {
+        return false;
+    }
+    index->fData = index->fOffsets + offsetsLength;
+    uint32_t last = read_cff_offset(data + index->fOffsets +
+                                    index->fCount * index->fOffSize,
+                                    index->fOffSize);
+    if (last < 1 || last - 1 > size - index->fData) {
+        return false;
+    }
+    index->fEnd = index->fData + last - 1;
+    return true;
+}
+
+bool get_cff_index_item(const uint8_t* data, const CFFIndex& index, int i,
+                        size_t* start, size_t* end) {
+    SkASSERT(i < index.fCount);
+    const uint8_t* offsets = data + index.fOffsets + i * index.fOffSize;
+    uint32_t first = read_cff_offset(offsets, index.fOffSize);
+    uint32_t next = read_cff_offset(offsets + index.fOffSize, index.fOffSize);
+    if (first < 1 || first > next || index.fData + next - 1 > index.fEnd) {
+        return false;
+    }
+    *start = index.fData + first - 1;
+    *end = index.fData + next - 1;
+    return true;
+}
+
+// Append an INDEX whose items are the ranges of payload ending at itemEnds.
+void append_cff_index(const SkTDArray<uint8_t>& payload,
+                      const SkTDArray<uint32_t>& itemEnds,
+                      SkTDArray<uint8_t>* dst) {
+    int count = itemEnds.count();
+    append_u16(dst, count);
+    if (0 == count) {
+        return;
+    }
+    uint32_t last = payload.count() + 1;
+    int offSize = last <= 0xFF ? 1 : last <= 0xFFFF ? 2 : last <= 0xFFFFFF ? 3
+                                                                          : 4;
+    *dst->append() = offSize;
+    uint8_t* offsets = dst->append((count + 1) * offSize);
+    for (int i = 0; i <= count; i++) {
+        uint32_t offset = (i == 0) ? 1 : itemEnds[i - 1] + 1;
+        for (int j = offSize - 1; j >= 0; j--) {
+            *offsets++ = offset >> (8 * j);
+        }
+    }
+    dst->append(payload.count(), payload.begin());
+}
+
+struct CFFDictEntry {
+    int         fOp;
+    size_t      fStart;         // of the operands
+    size_t      fEnd;           // after the operator
+    int         fOperandCount;
+    int32_t     fOperands[2];   // only the first two (integer) operands
+};
+
+bool parse_cff_dict(const uint8_t* data, size_t start, size_t end,
+                    SkTDArray<CFFDictEntry>* entries) {
+    size_t p = start;
+    size_t entryStart = start;
+    int operandCount = 0;
+    int32_t operands[2] = { 0, 0 };
+    while (p < end) {
+        uint8_t b0 = data[p];
+        int32_t value = 0;
+        if (b0 <= 21) {
+            int op = b0;
+            p++;
+            if (12 == b0) {
+                if (p >= end) {
+                    return false;
+                }
+                op = kEscape_CFFOp + data[p++];
+            }
+            CFFDictEntry* entry = entries->append();
+            entry->fOp = op;
+            entry->fStart = entryStart;
+            entry->fEnd = p;
+            entry->fOperandCount = operandCount;
+            entry->fOperands[0] = operands[0];
+            entry->fOperands[1] = operands[1];
+            entryStart = p;
+            operandCount = 0;
+            continue;
+        } else if (28 == b0) {
+            if (end - p < 3) {
+                return false;
+            }
+            value = (int16_t)read_u16(data + p + 1);
+            p += 3;
+        } else if (29 == b0) {
+            if (end - p < 5) {
+                return false;
+            }
+            value = (int32_t)read_u32(data + p + 1);
+            p += 5;
+        } else if (30 == b0) {
+            // Real numbers aren't needed; skip nibbles up to the end marker.
+            for (p++; p < end; p++) {
+                if ((data[p] >> 4) == 0xF || (data[p] & 0xF) == 0xF) {
+                    p++;
+                    break;
+                }
+            }
+        } else if (b0 >= 32 && b0 <= 246) {
+            value = b0 - 139;
+            p++;
+        } else if (b0 >= 247 && b0 <= 254) {
+            if (end - p < 2) {
+                return false;
+            }
+            if (b0 <= 250) {
+                value = (b0 - 247) * 256 + data[p + 1] + 108;
+            } else {
+                value = -(b0 - 251) * 256 - data[p + 1] - 108;
+            }
+            p += 2;
+        } else {
+            return false;
+        }
+        if (operandCount < 2) {
+            operands[operandCount] = value;
+        }
+        operandCount++;
+    }
+    return entryStart == end;
+}
+
+const CFFDictEntry* find_cff_op(const SkTDArray<CFFDictEntry>& entries,
+                                int op) {
+    for (int i = 0; i < entries.count(); i++) {
+        if (entries[i].fOp == op) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+struct CFFOffsetOp {
+    int     fOp;
+    int     fCount;
+    int32_t fValues[2];
+};
+
+// Append a DICT, replacing the operands of the given operators.  The new
+// operands are always five byte integers, so the size of the DICT doesn't
+// depend on their values.
+void append_cff_dict(const uint8_t* data,
+                     const SkTDArray<CFFDictEntry>& entries,
+                     const SkTDArray<CFFOffsetOp>& replacements,
+                     SkTDArray<uint8_t>* dst) {
+    for (int i = 0; i < entries.count(); i++) {
+        const CFFDictEntry& entry = entries[i];
+        const CFFOffsetOp* replacement = NULL;
+        for (int j = 0; j < replacements.count(); j++) {
+            if (replacements[j].fOp == entry.fOp) {
+                replacement = &replacements[j];
+                break;
+            }
+        }
+        if (NULL == replacement) {
+            append_bytes(dst, data + entry.fStart, entry.fEnd - entry.fStart);
+            continue;
+        }
+        for (int j = 0; j < replacement->fCount; j++) {
+            *dst->append() = 29;
+            append_u32(dst, replacement->fValues[j]);
+        }
+        if (entry.fOp >= kEscape_CFFOp) {
+            *dst->append() = 12;
+            *dst->append() = entry.fOp - kEscape_CFFOp;
+        } else {
+            *dst->append() = entry.fOp;
+        }
+    }
+}
+
+// The number of bytes used by a custom charset, encoding or FDSelect.
+bool get_charset_length(const uint8_t* data, size_t size, size_t offset,
+                        int numGlyphs, size_t* length) {
+    if (offset >= size) {
+        return false;
+    }
+    uint8_t format = data[offset];
+    size_t p = offset + 1;
+    if (0 == format) {
+        p += 2 * (numGlyphs - 1);
+    } else if (1 == format || 2 == format) {
+        size_t rangeLength = (1 == format) ? 3 : 4;
+        for (int covered = 1; covered < numGlyphs;) {
+            if (p + rangeLength > size) {
+                return false;
+            }
+            int left = (1 == format) ? data[p + 2] : read_u16(data + p + 2);
+            covered += left + 1;
+            p += rangeLength;
+        }
+    } else {
+        return false;
+    }
+    *length = p - offset;
+    return p <= size;
+}
+
+bool get_encoding_length(const uint8_t* data, size_t size, size_t offset,
+                         size_t* length) {
+    if (offset + 2 > size) {
+        return false;
+    }
+    uint8_t format = data[offset];
+    size_t p = offset + 2;
+    if (0 == (format & 0x7F)) {
+        p += data[offset + 1];
+    } else if (1 == (format & 0x7F)) {
+        p += 2 * data[offset + 1];
+    } else {
+        return false;
+    }
+    if (format & 0x80) {  // supplements
+        if (p >= size) {
+            return false;
+        }
+        p += 1 + 3 * data[p];
+    }
+    *length = p - offset;
+    return p <= size;
+}
+
+bool get_fdselect_length(const uint8_t* data, size_t size, size_t offset,
+                         int numGlyphs, size_t* length) {
+    if (offset >= size) {
+        return false;
+    }
+    uint8_t format = data[offset];
+    size_t p = offset + 1;
+    if (0 == format) {
+        p += numGlyphs;
+    } else if (3 == format) {
+        if (p + 2 > size) {
+            return false;
+        }
+        p += 2 + 3 * read_u16(data + p) + 2;
+    } else {
+        return false;
+    }
+    *length = p - offset;
+    return p <= size;
+}
+
+// A Private DICT and the local subroutines it refers to, which are copied
+// together since the Subrs offset is relative to the Private DICT.
+struct CFFPrivate {
+    size_t  fStart;
+    size_t  fLength;
+    size_t  fDictLength;
+};
+
+bool get_cff_private(const uint8_t* data, size_t size,
+                     const CFFDictEntry* entry, CFFPrivate* priv) {
+    if (NULL == entry || entry->fOperandCount != 2 ||
+            entry->fOperands[0] < 0 || entry->fOperands[1] < 0) {
+        return false;
+    }
+    priv->fStart = entry->fOperands[1];
+    priv->fDictLength = entry->fOperands[0];
+    if (priv->fStart > size || priv->fDictLength > size - priv->fStart) {
+        return false;
+    }
+    priv->fLength = priv->fDictLength;
+
+    SkTDArray<CFFDictEntry> entries;
+    if (!parse_cff_dict(data, priv->fStart, priv->fStart + priv->fDictLength,
+                        &entries)) {
+        return false;
+    }
+    const CFFDictEntry* subrs = find_cff_op(entries, kSubrs_CFFOp);
+    if (subrs && subrs->fOperandCount == 1) {
+        CFFIndex subrsIndex;
+        if (subrs->fOperands[0] <= 0 ||
+                !parse_cff_index(data, size, priv->fStart + subrs->fOperands[0],
+                                 &subrsIndex)) {
+            return false;
+        }
+        if (subrsIndex.fEnd - priv->fStart > priv->fLength) {
+            priv->fLength = subrsIndex.fEnd - priv->fStart;
+        }
+    }
+    return true;
+}
+
+CFFOffsetOp* add_offset_op(SkTDArray<CFFOffsetOp>* ops, int op, int count,
+                           int32_t value0, int32_t value1) {
+    CFFOffsetOp* offsetOp = ops->append();
+    offsetOp->fOp = op;
+    offsetOp->fCount = count;
+    offsetOp->fValues[0] = value0;
+    offsetOp->fValues[1] = value1;
+    return offsetOp;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Subset cache
+///////////////////////////////////////////////////////////////////////////////
+
+class SubsetCacheEntry {
+public:
+    SubsetCacheEntry(SkFontID fontID, SkPDFFontSubsetter::Format format,
+                     uint32_t checksum, const SkTDArray<uint32_t>& glyphIDs,
+                     SkData* data)
+        : fFontID(fontID),
+          fFormat(format),
+          fChecksum(checksum),
+          fGlyphIDs(glyphIDs),
+          fData(SkRef(data)) {
+    }
+
+    ~SubsetCacheEntry() {
+        fData->unref();
+    }
+
+    bool matches(SkFontID fontID, SkPDFFontSubsetter::Format format,
+                 uint32_t checksum, const SkTDArray<uint32_t>& glyphIDs) const {
+        return fFontID == fontID && fFormat == format &&
+               fChecksum == checksum && fGlyphIDs == glyphIDs;
+    }
+
+    size_t bytes() const {
+        return fData->size() + fGlyphIDs.count() * sizeof(uint32_t);
+    }
+
+    SkData* data() const { return fData; }
+
+private:
+    SkFontID                    fFontID;
+    SkPDFFontSubsetter::Format  fFormat;
+    uint32_t                    fChecksum;
+    SkTDArray<uint32_t>         fGlyphIDs;
+    SkData*                     fData;
+
+    SK_DEFINE_DLINKEDLIST_INTERFACE(SubsetCacheEntry);
+};
+
+struct SubsetCache {
+    SubsetCache()
+        : fBytesUsed(0),
+          fLimit(SK_DEFAULT_PDF_FONT_SUBSET_CACHE_LIMIT) {
+    }
+
+    SkTDLinkedList<SubsetCacheEntry>    fEntries;   // most recent first
+    size_t                              fBytesUsed;
+    size_t                              fLimit;
+};
+
+SK_DECLARE_STATIC_MUTEX(gSubsetCacheMutex);
+
+// Only call while holding gSubsetCacheMutex.
+SubsetCache& subset_cache() {
+    static SubsetCache gSubsetCache;
+    return gSubsetCache;
+}
+
+// Only call while holding gSubsetCacheMutex.
+void purge_subset_cache(SubsetCache* cache, size_t limit) {
+    while (cache->fBytesUsed > limit) {
+        SubsetCacheEntry* entry = cache->fEntries.tail();
+        SkASSERT(entry);
+        cache->fEntries.remove(entry);
+        cache->fBytesUsed -= entry->bytes();
+        SkDELETE(entry);
+    }
+}
+
+// Only call while holding gSubsetCacheMutex.  Returns a ref to the cached
+// subset, or NULL.
+SkData* find_subset(SubsetCache* cache, SkFontID fontID,
+                    SkPDFFontSubsetter::Format format, uint32_t checksum,
+                    const SkTDArray<uint32_t>& glyphIDs) {
+    SkTDLinkedList<SubsetCacheEntry>::Iter iter;
+    SubsetCacheEntry* entry = iter.init(cache->fEntries,
+            SkTDLinkedList<SubsetCacheEntry>::Iter::kHead_IterStart);
+    for (; entry; entry = iter.next()) {
+        if (entry->matches(fontID, format, checksum, glyphIDs)) {
+            cache->fEntries.remove(entry);
+            cache->fEntries.addToHead(entry);
+            return SkRef(entry->data());
+        }
+    }
+    return NULL;
+}
+
+SkData* read_font_data(SkFontID fontID) {
+    SkStream* stream = SkFontHost::OpenStream(fontID);
+    if (NULL == stream) {
+        return NULL;
+    }
+    SkAutoUnref aur(stream);
+    // Some font hosts hand out the same stream each time.
+    if (!stream->rewind()) {
+        return NULL;
+    }
+    size_t length = stream->getLength();
+    if (0 == length) {
+        return NULL;
+    }
+    void* data = sk_malloc_throw(length);
+    bool success = stream->read(data, length) == length;
+    // Leave it as we found it, for the next user.
+    stream->rewind();
+    if (!success) {
+        sk_free(data);
+        return NULL;
+    }
+    return SkData::NewFromMalloc(data, length);
+}
+
+}  // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// class SkPDFFontSubsetter
+///////////////////////////////////////////////////////////////////////////////
+
+// static
+SkData* SkPDFFontSubsetter::SubsetTrueType(const SkData* font,
+                                           const SkTDArray<uint32_t>& glyphIDs) {
+    const uint8_t* data = font->bytes();
+    SkTDArray<SfntTable> tables;
+    if (!read_sfnt_tables(data, font->size(), &tables)) {
+        return NULL;
+    }
+    uint32_t version = read_u32(data);
+    if (version != kWindowsTrueType_Version &&
+            version != kMacTrueType_Version) {
+        return NULL;
+    }
+    const SfntTable* head = find_table(tables, kHead_Tag);
+    const SfntTable* maxp = find_table(tables, kMaxp_Tag);
+    const SfntTable* loca = find_table(tables, kLoca_Tag);
+    const SfntTable* glyf = find_table(tables, kGlyf_Tag);
+    if (NULL == head || NULL == maxp || NULL == loca || NULL == glyf ||
+            head->fLength < kHeadMinLength || maxp->fLength < kMaxpMinLength) {
+        return NULL;
+    }
+
+    int numGlyphs = read_u16(maxp->fData + kMaxpNumGlyphs_Offset);
+    bool longLoca = 0 != read_u16(head->fData + kHeadIndexToLocFormat_Offset);
+    size_t locaEntryLength = longLoca ? 4 : 2;
+    if (0 == numGlyphs || loca->fLength < (numGlyphs + 1) * locaEntryLength) {
+        return NULL;
+    }
+    SkTDArray<uint32_t> offsets;
+    offsets.setCount(numGlyphs + 1);
+    for (int i = 0; i <= numGlyphs; i++) {
+        const uint8_t* entry = loca->fData + i * locaEntryLength;
+        offsets[i] = longLoca ? read_u32(entry) : read_u16(entry) * 2;
+        if (offsets[i] > glyf->fLength || (i > 0 && offsets[i] < offsets[i - 1])) {
+            return NULL;
+        }
+    }
+
+    // Find the glyphs that are used, directly or as part of a composite.
+    SkBitSet used(numGlyphs);
+    SkTDArray<int> pending;
+    used.setBit(0, true);
+    *pending.append() = 0;
+    for (int i = 0; i < glyphIDs.count(); i++) {
+        int glyphID = glyphIDs[i];
+        if (glyphID < numGlyphs && !used.isBitSet(glyphID)) {
+            used.setBit(glyphID, true);
+            *pending.append() = glyphID;
+        }
+    }
+    while (pending.count()) {
+        int glyphID;
+        pending.pop(&glyphID);
+        add_components(glyf->fData + offsets[glyphID],
+                       offsets[glyphID + 1] - offsets[glyphID], numGlyphs,
+                       &used, &pending);
+    }
+
+    // Rewrite glyf and loca, leaving the unused glyphs empty.
+    SkTDArray<uint8_t> newGlyf;
+    SkTDArray<uint8_t> newLoca;
+    for (int i = 0; i <= numGlyphs; i++) {
+        uint32_t offset = newGlyf.count();
+        if (longLoca) {
+            append_u32(&newLoca, offset);
+        } else {
+            if (offset / 2 > SK_MaxU16) {
+                return NULL;
+            }
+            append_u16(&newLoca, offset / 2);
+        }
+        if (i < numGlyphs && used.isBitSet(i)) {
+            append_bytes(&newGlyf, glyf->fData + offsets[i],
+                         offsets[i + 1] - offsets[i]);
+            if (newGlyf.count() & 1) {
+                *newGlyf.append() = 0;
+            }
+        }
+    }
+    // The table must not be empty.
+    if (0 == newGlyf.count()) {
+        append_u16(&newGlyf, 0);
+    }
+
+    SkTDArray<SfntTable> newTables;
+    for (int i = 0; i < tables.count(); i++) {
+        bool keep = false;
+        for (size_t j = 0; j < SK_ARRAY_COUNT(gTrueTypeTablesToKeep); j++) {
+            keep |= tables[i].fTag == gTrueTypeTablesToKeep[j];
+        }
+        if (!keep) {
+            continue;
+        }
+        SfntTable* table = newTables.append();
+        *table = tables[i];
+        if (kGlyf_Tag == table->fTag) {
+            table->fData = newGlyf.begin();
+            table->fLength = newGlyf.count();
+        } else if (kLoca_Tag == table->fTag) {
+            table->fData = newLoca.begin();
+            table->fLength = newLoca.count();
+        }
+    }
+    return write_sfnt(version, newTables);
+}
+
+// static
+SkData* SkPDFFontSubsetter::SubsetCFF(const SkData* font,
+                                      const SkTDArray<uint32_t>& glyphIDs) {
+    const uint8_t* data = font->bytes();
+    size_t size = font->size();
+    if (size >= 4 && read_u32(data) == kOpenTypeCFF_Version) {
+        SkTDArray<SfntTable> tables;
+        if (!read_sfnt_tables(data, size, &tables)) {
+            return NULL;
+        }
+        const SfntTable* cff = find_table(tables, kCFF_Tag);
+        if (NULL == cff) {
+            return NULL;
+        }
+        data = cff->fData;
+        size = cff->fLength;
+    }
+
+    // Header, Name INDEX, Top DICT INDEX, String INDEX, Global Subr INDEX.
+    if (size < 4 || data[0] != 1 || data[2] < 4) {
+        return NULL;
+    }
+    size_t headerSize = data[2];
+    CFFIndex names, topDicts, strings, globalSubrs;
+    if (!parse_cff_index(data, size, headerSize, &names) ||
+            !parse_cff_index(data, size, names.fEnd, &topDicts) ||
+            !parse_cff_index(data, size, topDicts.fEnd, &strings) ||
+            !parse_cff_index(data, size, strings.fEnd, &globalSubrs) ||
+            names.fCount != 1 || topDicts.fCount != 1) {
+        return NULL;
+    }
+
+    size_t topStart, topEnd;
+    SkTDArray<CFFDictEntry> top;
+    if (!get_cff_index_item(data, topDicts, 0, &topStart, &topEnd) ||
+            !parse_cff_dict(data, topStart, topEnd, &top)) {
+        return NULL;
+    }
+    const CFFDictEntry* charStringsOp = find_cff_op(top, kCharStrings_CFFOp);
+    const CFFDictEntry* charstringType = find_cff_op(top, kCharstringType_CFFOp);
+    CFFIndex charStrings;
+    if (NULL == charStringsOp || charStringsOp->fOperandCount != 1 ||
+            (charstringType && charstringType->fOperands[0] != 2) ||
+            !parse_cff_index(data, size, charStringsOp->fOperands[0],
+                             &charStrings) ||
+            0 == charStrings.fCount) {
+        return NULL;
+    }
+    int numGlyphs = charStrings.fCount;
+
+    // The sections that are copied as is.  Offsets of 0, 1 and 2 refer to the
+    // predefined charsets and encodings.
+    const CFFDictEntry* charsetOp = find_cff_op(top, kCharset_CFFOp);
+    size_t charsetLength = 0;
+    if (charsetOp && charsetOp->fOperands[0] > 2 &&
+            !get_charset_length(data, size, charsetOp->fOperands[0], numGlyphs,
+                                &charsetLength)) {
+        return NULL;
+    }
+    const CFFDictEntry* encodingOp = find_cff_op(top, kEncoding_CFFOp);
+    size_t encodingLength = 0;
+    if (encodingOp && encodingOp->fOperands[0] > 1 &&
+            !get_encoding_length(data, size, encodingOp->fOperands[0],
+                                 &encodingLength)) {
+        return NULL;
+    }
+    const CFFDictEntry* fdSelectOp = find_cff_op(top, kFDSelect_CFFOp);
+    size_t fdSelectLength = 0;
+    if (fdSelectOp && !get_fdselect_length(data, size,
+                                           fdSelectOp->fOperands[0],
+                                           numGlyphs, &fdSelectLength)) {
+        return NULL;
+    }
+    const CFFDictEntry* privateOp = find_cff_op(top, kPrivate_CFFOp);
+    CFFPrivate topPrivate;
+    if (privateOp && !get_cff_private(data, size, privateOp, &topPrivate)) {
+        return NULL;
+    }
+
+    // CID-keyed fonts have a Font DICT (and Private DICT) per group of glyphs.
+    const CFFDictEntry* fdArrayOp = find_cff_op(top, kFDArray_CFFOp);
+    CFFIndex fdArray;
+    SkTDArray<SkTDArray<CFFDictEntry>*> fontDicts;
+    SkTDArray<CFFPrivate> fontPrivates;
+    if (fdArrayOp) {
+        if (!parse_cff_index(data, size, fdArrayOp->fOperands[0], &fdArray)) {
+            return NULL;
+        }
+        fontPrivates.setCount(fdArray.fCount);
+    }
+    // Deletes the Font DICTs on the way out.
+    struct AutoDeleteDicts {
+        explicit AutoDeleteDicts(SkTDArray<SkTDArray<CFFDictEntry>*>* dicts)
+            : fDicts(dicts) {}
+        ~AutoDeleteDicts() { fDicts->deleteAll(); }
+        SkTDArray<SkTDArray<CFFDictEntry>*>* fDicts;
+    } autoDelete(&fontDicts);
+    for (int i = 0; i < fontPrivates.count(); i++) {
+        SkTDArray<CFFDictEntry>* dict = SkNEW(SkTDArray<CFFDictEntry>);
+        *fontDicts.append() = dict;
+        size_t start, end;
+        if (!get_cff_index_item(data, fdArray, i, &start, &end) ||
+                !parse_cff_dict(data, start, end, dict) ||
+                !get_cff_private(data, size, find_cff_op(*dict, kPrivate_CFFOp),
+                                 &fontPrivates[i])) {
+            return NULL;
+        }
+    }
+
+    // Replace the charstrings of unused glyphs with endchar.
+    SkBitSet used(numGlyphs);
+    used.setBit(0, true);
+    for (int i = 0; i < glyphIDs.count(); i++) {
+        if (glyphIDs[i] < (uint32_t)numGlyphs) {
+            used.setBit(glyphIDs[i], true);
+        }
+    }
+    SkTDArray<uint8_t> charStringData;
+    SkTDArray<uint32_t> charStringEnds;
+    for (int i = 0; i < numGlyphs; i++) {
+        size_t start, end;
+        if (!get_cff_index_item(data, charStrings, i, &start, &end)) {
+            return NULL;
+        }
+        if (used.isBitSet(i)) {
+            append_bytes(&charStringData, data + start, end - start);
+        } else {
+            *charStringData.append() = kEndChar_Type2Op;
+        }
+        *charStringEnds.append() = charStringData.count();
+    }
+    SkTDArray<uint8_t> newCharStrings;
+    append_cff_index(charStringData, charStringEnds, &newCharStrings);
+
+    // Lay out the new font: the header and the INDEXes that don't move, then
+    // the Top DICT INDEX, the sections it points to and the Private DICTs.
+    // The offsets in DICTs are fixed size, so the layout can be computed
+    // before the offsets are known.
+    SkTDArray<CFFOffsetOp> topOps;
+    CFFOffsetOp* charsetReplacement = NULL;
+    CFFOffsetOp* encodingReplacement = NULL;
+    CFFOffsetOp* fdSelectReplacement = NULL;
+    CFFOffsetOp* privateReplacement = NULL;
+    CFFOffsetOp* fdArrayReplacement = NULL;
+    topOps.setReserve(6);  // so the pointers above stay valid
+    if (charsetLength) {
+        charsetReplacement = add_offset_op(&topOps, kCharset_CFFOp, 1, 0, 0);
+    }
+    if (encodingLength) {
+        encodingReplacement = add_offset_op(&topOps, kEncoding_CFFOp, 1, 0, 0);
+    }
+    if (fdSelectOp) {
+        fdSelectReplacement = add_offset_op(&topOps, kFDSelect_CFFOp, 1, 0, 0);
+    }
+    if (privateOp) {
+        privateReplacement = add_offset_op(&topOps, kPrivate_CFFOp, 2,
+                                           topPrivate.fDictLength, 0);
+    }
+    if (fdArrayOp) {
+        fdArrayReplacement = add_offset_op(&topOps, kFDArray_CFFOp, 1, 0, 0);
+    }
+    CFFOffsetOp* charStringsReplacement =
+        add_offset_op(&topOps, kCharStrings_CFFOp, 1, 0, 0);
+
+    SkTDArray<uint8_t> topDict;
+    SkTDArray<uint32_t> topDictEnds;
+    append_cff_dict(data, top, topOps, &topDict);
+    *topDictEnds.append() = topDict.count();
+    SkTDArray<uint8_t> newTopDicts;
+    append_cff_index(topDict, topDictEnds, &newTopDicts);
+
+    size_t position = names.fEnd + newTopDicts.count() +
+                      (globalSubrs.fEnd - topDicts.fEnd);
+    if (charsetReplacement) {
+        charsetReplacement->fValues[0] = position;
+        position += charsetLength;
+    }
+    if (encodingReplacement) {
+        encodingReplacement->fValues[0] = position;
+        position += encodingLength;
+    }
+    if (fdSelectReplacement) {
+        fdSelectReplacement->fValues[0] = position;
+        position += fdSelectLength;
+    }
+    charStringsReplacement->fValues[0] = position;
+    position += newCharStrings.count();
+
+    SkTDArray<CFFOffsetOp> fontOps;
+    add_offset_op(&fontOps, kPrivate_CFFOp, 2, 0, 0);
+    SkTDArray<uint8_t> fontDictData;
+    SkTDArray<uint32_t> fontDictEnds;
+    for (int i = 0; i < fontDicts.count(); i++) {
+        append_cff_dict(data, *fontDicts[i], fontOps, &fontDictData);
+        *fontDictEnds.append() = fontDictData.count();
+    }
+    SkTDArray<uint8_t> newFDArray;
+    if (fdArrayReplacement) {
+        append_cff_index(fontDictData, fontDictEnds, &newFDArray);
+        fdArrayReplacement->fValues[0] = position;
+        position += newFDArray.count();
+    }
+    if (privateReplacement) {
+        privateReplacement->fValues[1] = position;
+        position += topPrivate.fLength;
+    }
+    fontDictData.rewind();
+    fontDictEnds.rewind();
+    for (int i = 0; i < fontDicts.count(); i++) {
+        fontOps[0].fValues[0] = fontPrivates[i].fDictLength;
+        fontOps[0].fValues[1] = position;
+        position += fontPrivates[i].fLength;
+        append_cff_dict(data, *fontDicts[i], fontOps, &fontDictData);
+        *fontDictEnds.append() = fontDictData.count();
+    }
+
+    // Now write it all out.
+    SkTDArray<uint8_t> out;
+    out.setReserve(position);
+    append_bytes(&out, data, names.fEnd);
+    topDict.rewind();
+    append_cff_dict(data, top, topOps, &topDict);
+    SkASSERT(topDict.count() == (int)topDictEnds[0]);
+    append_cff_index(topDict, topDictEnds, &out);
+    append_bytes(&out, data + topDicts.fEnd, globalSubrs.fEnd - topDicts.fEnd);
+    if (charsetReplacement) {
+        SkASSERT(out.count() == charsetReplacement->fValues[0]);
+        append_bytes(&out, data + charsetOp->fOperands[0], charsetLength);
+    }
+    if (encodingReplacement) {
+        append_bytes(&out, data + encodingOp->fOperands[0], encodingLength);
+    }
+    if (fdSelectReplacement) {
+        append_bytes(&out, data + fdSelectOp->fOperands[0], fdSelectLength);
+    }
+    SkASSERT(out.count() == charStringsReplacement->fValues[0]);
+    append_bytes(&out, newCharStrings.begin(), newCharStrings.count());
+    if (fdArrayReplacement) {
+        append_cff_index(fontDictData, fontDictEnds, &out);
+    }
+    if (privateReplacement) {
+        SkASSERT(out.count() == privateReplacement->fValues[1]);
+        append_bytes(&out, data + topPrivate.fStart, topPrivate.fLength);
+    }
+    for (int i = 0; i < fontPrivates.count(); i++) {
+        append_bytes(&out, data + fontPrivates[i].fStart,
+                     fontPrivates[i].fLength);
+    }
+    SkASSERT(out.count() == (int)position);
+    return SkData::NewWithCopy(out.begin(), out.count());
+}
+
+// static
+SkData* SkPDFFontSubsetter::GetSubset(SkFontID fontID, Format format,
+                                      const SkTDArray<uint32_t>& glyphIDs) {
+    // Sort and remove duplicates, so the same set of glyphs always has the
+    // same key.
+    SkBitSet glyphSet(SK_MaxU16 + 1);
+    glyphSet.setBit(0, true);
+    for (int i = 0; i < glyphIDs.count(); i++) {
+        if (glyphIDs[i] <= SK_MaxU16) {
+            glyphSet.setBit(glyphIDs[i], true);
+        }
+    }
+    SkTDArray<uint32_t> glyphs;
+    glyphSet.exportTo(&glyphs);
+    uint32_t checksum = SkChecksum::Compute(glyphs.begin(),
+                                            glyphs.count() * sizeof(uint32_t));
+
+    {
+        SkAutoMutexAcquire lock(gSubsetCacheMutex);
+        SkData* subset = find_subset(&subset_cache(), fontID, format, checksum,
+                                     glyphs);
+        if (subset) {
+            return subset;
+        }
+    }
+
+    SkData* font = read_font_data(fontID);
+    if (NULL == font) {
+        return NULL;
+    }
+    SkAutoUnref aur(font);
+    SkData* subset = (kTrueType_Format == format) ? SubsetTrueType(font, glyphs)
+                                                  : SubsetCFF(font, glyphs);
+    if (NULL == subset) {
+        return NULL;
+    }
+
+    SkAutoMutexAcquire lock(gSubsetCacheMutex);
+    SubsetCache& cache = subset_cache();
+    // Another thread may have made the same subset in the mean time.
+    SkData* existing = find_subset(&cache, fontID, format, checksum, glyphs);
+    if (existing) {
+        subset->unref();
+        return existing;
+    }
+    SubsetCacheEntry* entry = SkNEW_ARGS(SubsetCacheEntry,
+                                         (fontID, format, checksum, glyphs,
+                                          subset));
+    cache.fEntries.addToHead(entry);
+    cache.fBytesUsed += entry->bytes();
+    purge_subset_cache(&cache, cache.fLimit);
+    return subset;
+}
+
+// static
+size_t SkPDFFontSubsetter::GetCacheLimit() {
+    SkAutoMutexAcquire lock(gSubsetCacheMutex);
+    return subset_cache().fLimit;
+}
+
+// static
+size_t SkPDFFontSubsetter::SetCacheLimit(size_t bytes) {
+    SkAutoMutexAcquire lock(gSubsetCacheMutex);
+    SubsetCache& cache = subset_cache();
+    size_t prevLimit = cache.fLimit;
+    cache.fLimit = bytes;
+    purge_subset_cache(&cache, bytes);
+    return prevLimit;
+}
+
+// static
+size_t SkPDFFontSubsetter::GetCacheUsed() {
+    SkAutoMutexAcquire lock(gSubsetCacheMutex);
+    return subset_cache().fBytesUsed;
+}
+
+// static
+void SkPDFFontSubsetter::PurgeCache() {
+    SkAutoMutexAcquire lock(gSubsetCacheMutex);
+    purge_subset_cache(&subset_cache(), 0);
+}
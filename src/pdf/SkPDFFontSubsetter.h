@@ -0,0 +1,75 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+
+#ifndef SkPDFFontSubsetter_DEFINED
+#define SkPDFFontSubsetter_DEFINED
+
+#include "SkFontHost.h"
+#include "SkTDArray.h"
+
+class SkData;
+
+/** \class SkPDFFontSubsetter
+
+    Reduces TrueType and CFF fonts to the glyphs used by a document.  Glyph
+    IDs are preserved (unused glyphs are left empty rather than removed), so
+    the subset can be used with an Identity CIDToGIDMap and the widths and
+    ToUnicode tables of the original font.
+
+    Subsetting a large font is expensive, so the results are kept in a
+    process wide, least recently used cache, keyed by the font ID and the
+    set of glyphs.  Exporting several documents that use the same glyphs of
+    a font only subsets it once.
+*/
+class SkPDFFontSubsetter {
+public:
+    enum Format {
+        kTrueType_Format,
+        kCFF_Format,
+    };
+
+    /** Return the subset of the font with the given ID that contains glyphIDs
+     *  (glyph 0 is always included), using the cache if possible.  Returns
+     *  NULL if the font data isn't in the given format.  The caller owns the
+     *  returned reference.
+     */
+    static SkData* GetSubset(SkFontID fontID, Format format,
+                             const SkTDArray<uint32_t>& glyphIDs);
+
+    /** Return a copy of an sfnt font with TrueType outlines, in which only
+     *  glyphIDs and the glyphs they are composed of have outlines.  Tables
+     *  that a PDF viewer doesn't need (layout, kerning, signatures, ...) are
+     *  dropped.  Returns NULL if the font can't be parsed.
+     */
+    static SkData* SubsetTrueType(const SkData* font,
+                                  const SkTDArray<uint32_t>& glyphIDs);
+
+    /** Return a bare CFF font (suitable for FontFile3) in which only glyphIDs
+     *  have charstrings.  font may be a bare CFF font or an OpenType font
+     *  with a 'CFF ' table.  Returns NULL if the font can't be parsed.
+     */
+    static SkData* SubsetCFF(const SkData* font,
+                             const SkTDArray<uint32_t>& glyphIDs);
+
+    /** Return the max number of bytes the subset cache may use. */
+    static size_t GetCacheLimit();
+
+    /** Set the max number of bytes the subset cache may use, purging the least
+     *  recently used subsets if needed.  Returns the previous limit.
+     */
+    static size_t SetCacheLimit(size_t bytes);
+
+    /** Return the number of bytes currently used by the subset cache. */
+    static size_t GetCacheUsed();
+
+    /** Remove every subset from the cache. */
+    static void PurgeCache();
+};
+
+#endif
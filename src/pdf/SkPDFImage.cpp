@@ -10,11 +10,14 @@
 #include "SkPDFImage.h"
 
 #include "SkBitmap.h"
+#include "SkChecksum.h"
 #include "SkColor.h"
 #include "SkColorPriv.h"
+#include "SkData.h"
 #include "SkPaint.h"
 #include "SkPackBits.h"
 #include "SkPDFCatalog.h"
+#include "SkPixelRef.h"
 #include "SkRect.h"
 #include "SkStream.h"
 #include "SkString.h"
@@ -248,6 +251,103 @@ SkPDFArray* makeIndexedColorSpace(SkColorTable* table) {
 
 };  // namespace
 
+// Pixels can be compared (and checksummed) a row at a time for these configs.
+static bool can_compare_pixels(const SkBitmap& bitmap) {
+    switch (bitmap.getConfig()) {
+        case SkBitmap::kA8_Config:
+        case SkBitmap::kRGB_565_Config:
+        case SkBitmap::kARGB_4444_Config:
+        case SkBitmap::kARGB_8888_Config:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static uint32_t compute_checksum(const SkBitmap& bitmap,
+                                 const SkIRect& srcRect) {
+    SkAutoLockPixels lock(bitmap);
+    if (NULL == bitmap.getPixels()) {
+        return 0;
+    }
+    // SkChecksum wants whole words, so pad each row with zeros.
+    size_t rowBytes = srcRect.width() * bitmap.bytesPerPixel();
+    size_t paddedBytes = SkAlign4(rowBytes);
+    SkAutoMalloc storage(paddedBytes);
+    uint32_t* row = (uint32_t*)storage.get();
+    uint32_t checksum = 0;
+    for (int y = srcRect.fTop; y < srcRect.fBottom; y++) {
+        row[paddedBytes / 4 - 1] = 0;
+        memcpy(row, bitmap.getAddr(srcRect.fLeft, y), rowBytes);
+        checksum = ((checksum << 7) | (checksum >> 25)) ^
+                   SkChecksum::Compute(row, paddedBytes);
+    }
+    return checksum;
+}
+
+static bool same_pixels(const SkBitmap& a, const SkIRect& aRect,
+                        const SkBitmap& b, const SkIRect& bRect) {
+    SkASSERT(a.getConfig() == b.getConfig());
+    SkASSERT(aRect.width() == bRect.width() &&
+             aRect.height() == bRect.height());
+    SkAutoLockPixels lockA(a);
+    SkAutoLockPixels lockB(b);
+    if (NULL == a.getPixels() || NULL == b.getPixels()) {
+        return false;
+    }
+    size_t rowBytes = aRect.width() * a.bytesPerPixel();
+    for (int y = 0; y < aRect.height(); y++) {
+        if (memcmp(a.getAddr(aRect.fLeft, aRect.fTop + y),
+                   b.getAddr(bRect.fLeft, bRect.fTop + y), rowBytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Read the dimensions and number of components from the frame header of a
+// baseline or progressive JPEG.  Other kinds (e.g. lossless or arithmetic
+// coded) are rejected, since PDF readers don't support them.
+static bool get_jpeg_info(const SkData* data, int* width, int* height,
+                          int* components) {
+    const uint8_t* bytes = data->bytes();
+    size_t size = data->size();
+    if (size < 4 || bytes[0] != 0xFF || bytes[1] != 0xD8) {
+        return false;
+    }
+    size_t offset = 2;
+    while (offset + 4 <= size) {
+        if (bytes[offset] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = bytes[offset + 1];
+        if (0xFF == marker) {  // fill byte
+            offset++;
+            continue;
+        }
+        size_t length = (bytes[offset + 2] << 8) | bytes[offset + 3];
+        if (0xC0 == marker || 0xC1 == marker || 0xC2 == marker) {
+            if (length < 8 || offset + 2 + length > size) {
+                return false;
+            }
+            const uint8_t* frame = bytes + offset + 4;
+            *height = (frame[1] << 8) | frame[2];
+            *width = (frame[3] << 8) | frame[4];
+            *components = frame[5];
+            // 8 bits per sample
+            return 8 == frame[0] && *width > 0 && *height > 0;
+        }
+        bool otherFrame = marker >= 0xC3 && marker <= 0xCF &&
+                          0xC4 != marker && 0xC8 != marker && 0xCC != marker;
+        // start of scan or end of image before the frame header
+        if (otherFrame || 0xDA == marker || 0xD9 == marker) {
+            return false;
+        }
+        offset += 2 + length;
+    }
+    return false;
+}
+
 // static
 SkPDFImage* SkPDFImage::CreateImage(const SkBitmap& bitmap,
                                     const SkIRect& srcRect,
@@ -255,6 +355,75 @@ SkPDFImage* SkPDFImage::CreateImage(const SkBitmap& bitmap,
     if (bitmap.getConfig() == SkBitmap::kNo_Config) {
         return NULL;
     }
+    SkPDFImage* image = CreateUniqueImage(bitmap, srcRect, paint);
+    if (NULL == image) {
+        return NULL;
+    }
+    image->fHasSource = true;
+    image->fBitmap = bitmap;
+    image->fGenerationID = bitmap.getGenerationID();
+    image->fSrcRect = srcRect;
+    // JPEG data is only used in place of all of a bitmap's pixels, so
+    // images written from it are only matched by their source.
+    if (!image->fIsJPEG && can_compare_pixels(bitmap)) {
+        image->fHasChecksum = true;
+        image->fChecksum = compute_checksum(bitmap, srcRect);
+    }
+    return image;
+}
+
+bool SkPDFImage::isImageOf(const SkBitmap& bitmap,
+                           const SkIRect& srcRect) const {
+    uint32_t generationID = bitmap.getGenerationID();
+    return fHasSource && generationID != 0 &&
+           generationID == fGenerationID &&
+           bitmap.getConfig() == fBitmap.getConfig() &&
+           bitmap.pixelRefOffset() == fBitmap.pixelRefOffset() &&
+           bitmap.rowBytes() == fBitmap.rowBytes() &&
+           srcRect == fSrcRect;
+}
+
+bool SkPDFImage::matches(const SkPDFImage* other) const {
+    if (this == other) {
+        return true;
+    }
+    if (!fHasSource || !other->fHasSource ||
+            fBitmap.getConfig() != other->fBitmap.getConfig() ||
+            fSrcRect.width() != other->fSrcRect.width() ||
+            fSrcRect.height() != other->fSrcRect.height()) {
+        return false;
+    }
+    // Whether an image is written from JPEG data depends only on its source,
+    // so images of the same source are written the same.
+    if (other->isImageOf(fBitmap, fSrcRect)) {
+        return fIsJPEG == other->fIsJPEG;
+    }
+    return fHasChecksum && other->fHasChecksum &&
+           fChecksum == other->fChecksum &&
+           // The pixels may have changed since the images were made.
+           fBitmap.getGenerationID() == fGenerationID &&
+           other->fBitmap.getGenerationID() == other->fGenerationID &&
+           same_pixels(fBitmap, fSrcRect, other->fBitmap, other->fSrcRect);
+}
+
+// static
+SkPDFImage* SkPDFImage::CreateUniqueImage(const SkBitmap& bitmap,
+                                          const SkIRect& srcRect,
+                                          const SkPaint& paint) {
+    // Pass JPEGs through, if we're using all of the decoded pixels.
+    SkPixelRef* pixelRef = bitmap.pixelRef();
+    if (pixelRef && 0 == bitmap.pixelRefOffset() &&
+            srcRect == SkIRect::MakeWH(bitmap.width(), bitmap.height())) {
+        SkAutoDataUnref encoded(pixelRef->refEncodedData());
+        int width, height, components;
+        if (encoded.get() &&
+                get_jpeg_info(encoded.get(), &width, &height, &components) &&
+                (1 == components || 3 == components) &&
+                width == bitmap.width() && height == bitmap.height()) {
+            return new SkPDFImage(encoded.get(), width, height,
+                                  1 == components);
+        }
+    }
 
     SkStream* imageData = NULL;
     SkStream* alphaData = NULL;
@@ -293,7 +462,13 @@ void SkPDFImage::getResources(SkTDArray<SkPDFObject*>* resourceList) {
 
 SkPDFImage::SkPDFImage(SkStream* imageData, const SkBitmap& bitmap,
                        const SkIRect& srcRect, bool doingAlpha,
-                       const SkPaint& paint) {
+                       const SkPaint& paint)
+    : fHasSource(false),
+      fGenerationID(0),
+      fHasChecksum(false),
+      fChecksum(0),
+      fIsJPEG(false) {
+    fSrcRect.setEmpty();
     this->setData(imageData);
     SkBitmap::Config config = bitmap.getConfig();
     bool alphaOnly = (config == SkBitmap::kA1_Config ||
@@ -355,3 +530,21 @@ SkPDFImage::SkPDFImage(SkStream* imageData, const SkBitmap& bitmap,
         insert("Decode", decodeValue.get());
     }
 }
+
+SkPDFImage::SkPDFImage(SkData* jpegData, int width, int height,
+                       bool grayscale)
+    : fHasSource(false),
+      fGenerationID(0),
+      fHasChecksum(false),
+      fChecksum(0),
+      fIsJPEG(true) {
+    fSrcRect.setEmpty();
+    insertName("Type", "XObject");
+    insertName("Subtype", "Image");
+    insertInt("Width", width);
+    insertInt("Height", height);
+    insertName("ColorSpace", grayscale ? "DeviceGray" : "DeviceRGB");
+    insertInt("BitsPerComponent", 8);
+    insertName("Filter", "DCTDecode");
+    this->setEncodedData(jpegData);
+}
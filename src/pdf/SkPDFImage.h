@@ -10,26 +10,30 @@
 #ifndef SkPDFImage_DEFINED
 #define SkPDFImage_DEFINED
 
+#include "SkBitmap.h"
 #include "SkPDFStream.h"
 #include "SkPDFTypes.h"
+#include "SkRect.h"
 #include "SkRefCnt.h"
 
-class SkBitmap;
+class SkData;
 class SkPaint;
 class SkPDFCatalog;
-struct SkIRect;
 
 /** \class SkPDFImage
 
-    An image XObject.
+    An image XObject.  Images made by CreateImage() remember where their
+    pixels came from and a checksum of them, so that a document can write
+    the same pixels drawn on several pages (even from different bitmaps) as
+    a single XObject; see matches().
 */
-
-// We could play the same trick here as is done in SkPDFGraphicState, storing
-// a copy of the Bitmap object (not the pixels), the pixel generation number,
-// and settings used from the paint to canonicalize image objects.
 class SkPDFImage : public SkPDFStream {
 public:
-    /** Create a new Image XObject to represent the passed bitmap.
+    /** Create a new Image XObject to represent the passed bitmap.  If the
+     *  bitmap was decoded from a JPEG that is still available and all of it
+     *  is drawn, the JPEG data is used directly, instead of the pixels.  The
+     *  reference count of the object is incremented and it is the caller's
+     *  responsibility to unreference it when done.
      *  @param bitmap   The image to encode.
      *  @param srcRect  The rectangle to cut out of bitmap.
      *  @param paint    Used to calculate alpha, masks, etc.
@@ -40,6 +44,18 @@ public:
                                    const SkIRect& srcRect,
                                    const SkPaint& paint);
 
+    /** Return true if this image was made by CreateImage() from the passed
+     *  part of the bitmap's current pixels.
+     */
+    bool isImageOf(const SkBitmap& bitmap, const SkIRect& srcRect) const;
+
+    /** Return true if this image and other, both made by CreateImage(),
+     *  would be written the same, so one can be used in place of the other:
+     *  they were made from the same pixels, or from pixels with the same
+     *  contents that neither was written from JPEG data.
+     */
+    bool matches(const SkPDFImage* other) const;
+
     virtual ~SkPDFImage();
 
     /** Add a Soft Mask (alpha or shape channel) to the image.  Refs mask.
@@ -54,6 +70,25 @@ public:
 private:
     SkTDArray<SkPDFObject*> fResources;
 
+    // For images made by CreateImage(): a copy of the bitmap (not the
+    // pixels), so the pixels can be compared, the generation ID they had
+    // when the image was made, the part of the bitmap used, a checksum of
+    // those pixels (if they can be compared), and whether the image was
+    // written from JPEG data instead.
+    bool fHasSource;
+    SkBitmap fBitmap;
+    uint32_t fGenerationID;
+    SkIRect fSrcRect;
+    bool fHasChecksum;
+    uint32_t fChecksum;
+    bool fIsJPEG;
+
+    /** Create a new image XObject for the passed bitmap.
+     */
+    static SkPDFImage* CreateUniqueImage(const SkBitmap& bitmap,
+                                         const SkIRect& srcRect,
+                                         const SkPaint& paint);
+
     /** Create a PDF image XObject. Entries for the image properties are
      *  automatically added to the stream dictionary.
      *  @param imageData  The final raw bits representing the image.
@@ -65,6 +100,14 @@ private:
      */
     SkPDFImage(SkStream* imageData, const SkBitmap& bitmap,
                const SkIRect& srcRect, bool alpha, const SkPaint& paint);
+
+    /** Create a PDF image XObject that embeds JPEG data as is.
+     *  @param jpegData   The JPEG file.
+     *  @param width      The width of the JPEG image.
+     *  @param height     The height of the JPEG image.
+     *  @param grayscale  True if the JPEG has one component, false for three.
+     */
+    SkPDFImage(SkData* jpegData, int width, int height, bool grayscale);
 };
 
 #endif
@@ -53,6 +53,12 @@ void SkPDFPage::emitPage(SkWStream* stream, SkPDFCatalog* catalog) {
     fContentStream->emitObject(stream, catalog, true);
 }
 
+void SkPDFPage::releaseContent() {
+    this->clear();
+    fContentStream = NULL;
+    fDevice = NULL;
+}
+
 // static
 void SkPDFPage::GeneratePageTree(const SkTDArray<SkPDFPage*>& pages,
                                  SkPDFCatalog* catalog,
@@ -143,6 +149,10 @@ const SkTDArray<SkPDFFont*>& SkPDFPage::getFontResources() const {
     return fDevice->getFontResources();
 }
 
+const SkTDArray<SkPDFImage*>& SkPDFPage::getImageResources() const {
+    return fDevice->getImageResources();
+}
+
 const SkPDFGlyphSetMap& SkPDFPage::getFontGlyphUsage() const {
     return fDevice->getFontGlyphUsage();
 }
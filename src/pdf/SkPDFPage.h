@@ -17,6 +17,7 @@
 
 class SkPDFCatalog;
 class SkPDFDevice;
+class SkPDFImage;
 class SkWStream;
 
 /** \class SkPDFPage
@@ -63,6 +64,17 @@ public:
      */
     void emitPage(SkWStream* stream, SkPDFCatalog* catalog);
 
+    /** Return the page's content stream, or NULL if the page has not been
+     *  finalized.
+     */
+    SkPDFStream* getContentStream() const { return fContentStream.get(); }
+
+    /** Release the page content, the device and all of the page's entries,
+     *  once they have been emitted. Only the (now empty) page object is kept,
+     *  so it can still be referred to by the page tree.
+     */
+    void releaseContent();
+
     /** Generate a page tree for the passed vector of pages.  New objects are
      *  added to the catalog.  The pageTree vector is populated with all of
      *  the 'Pages' dictionaries as well as the 'Page' objects.  Page trees
@@ -84,6 +96,10 @@ public:
      */
     const SkTDArray<SkPDFFont*>& getFontResources() const;
 
+    /** Get the images used on this page.
+     */
+    const SkTDArray<SkPDFImage*>& getImageResources() const;
+
     /** Returns a SkPDFGlyphSetMap which represents glyph usage of every font
      *  that shows on this page.
      */
@@ -81,18 +81,34 @@ size_t SkPDFStream::getOutputSize(SkPDFCatalog* catalog, bool indirect) {
         strlen(" stream\n\nendstream") + fData->getLength();
 }
 
+void SkPDFStream::prepareToEmit(SkPDFCatalog* catalog) {
+    if (fState == kUnused_State) {
+        this->populate(catalog);
+    }
+}
+
 SkPDFStream::SkPDFStream() : fState(kUnused_State) {}
 
 void SkPDFStream::setData(SkStream* stream) {
     fData = stream;
 }
 
+void SkPDFStream::setEncodedData(SkData* data) {
+    SkMemoryStream* stream = new SkMemoryStream;
+    stream->setData(data);
+    fData = stream;
+    fData->unref();  // SkRefPtr and new both took a reference.
+    fState = kCompressed_State;
+    insertInt("Length", fData->getLength());
+}
+
 bool SkPDFStream::populate(SkPDFCatalog* catalog) {
     if (fState == kUnused_State) {
         if (!skip_compression(catalog) && SkFlate::HaveFlate()) {
             SkDynamicMemoryWStream compressedData;
 
-            SkAssertResult(SkFlate::Deflate(fData.get(), &compressedData));
+            SkAssertResult(SkFlate::Deflate(fData.get(), &compressedData,
+                                            catalog->getCompressionLevel()));
             if (compressedData.getOffset() < fData->getLength()) {
                 SkMemoryStream* stream = new SkMemoryStream;
                 stream->setData(compressedData.copyToData())->unref();
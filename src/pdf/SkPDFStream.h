@@ -42,6 +42,7 @@ public:
     virtual void emitObject(SkWStream* stream, SkPDFCatalog* catalog,
                             bool indirect);
     virtual size_t getOutputSize(SkPDFCatalog* catalog, bool indirect);
+    virtual void prepareToEmit(SkPDFCatalog* catalog);
 
 protected:
     /* Create a PDF stream with no data.  The setData method must be called to
@@ -51,6 +52,11 @@ protected:
 
     void setData(SkStream* stream);
 
+    /* Set data that is already encoded (e.g. a JPEG).  It won't be
+     * compressed, and the subclass must add the matching Filter entry.
+     */
+    void setEncodedData(SkData* data);
+
 private:
     enum State {
         kUnused_State,         //!< The stream hasn't been requested yet.
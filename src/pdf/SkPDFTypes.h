@@ -46,6 +46,14 @@ public:
      */
     virtual void getResources(SkTDArray<SkPDFObject*>* resourceList);
 
+    /** Do the expensive work needed to emit this object (e.g. compressing a
+     *  stream) ahead of time.  This may be called on several objects from
+     *  different threads at once, so it must only modify this object and
+     *  only read the catalog's settings.  The default does nothing.
+     *  @param catalog  The object catalog to use.
+     */
+    virtual void prepareToEmit(SkPDFCatalog* catalog) {}
+
     /** Emit this object unless the catalog has a substitute object, in which
      *  case emit that.
      *  @see emitObject
@@ -8,6 +8,7 @@
 
 #include "SkBitmap.h"
 #include "SkCanvas.h"
+#include "SkChecksum.h"
 #include "SkColorPriv.h"
 #include "SkDescriptor.h"
 #include "SkFDot6.h"
@@ -21,6 +22,7 @@
 #include "SkScalerContext.h"
 #include "SkStream.h"
 #include "SkString.h"
+#include "SkTDArray.h"
 #include "SkTemplates.h"
 #include "SkThread.h"
 
@@ -85,6 +87,8 @@ static SkFaceRec*   gFaceRecHead;
 static bool         gLCDSupportValid;  // true iff |gLCDSupport| has been set.
 static bool         gLCDSupport;  // true iff LCD is supported by the runtime.
 static int          gLCDExtra;  // number of extra pixels for filtering.
+static bool         gFaceLocking;  // true iff each face has its own mutex.
+static uint32_t     gScalerID;  // see SkFontHost::GetScalerID().
 
 // FT_Library_SetLcdFilterWeights was introduced in FreeType 2.4.0.
 // The following platforms provide FreeType of at least 2.4.0.
@@ -95,6 +99,16 @@ static int          gLCDExtra;  // number of extra pixels for filtering.
 // Android >= Gingerbread (good)
 typedef FT_Error (*FT_Library_SetLcdFilterWeightsProc)(FT_Library, unsigned char*);
 
+// Since FreeType 2.5.6, different faces of one library may be used on different
+// threads at the same time (only opening and closing faces must be serialized).
+// With those versions each face gets its own mutex. A font whose face is
+// contended may then get a few more faces, so that its strikes can be generated
+// in parallel, but only if the font is in memory: faces opened on an SkStream
+// share that stream's read position. Older versions keep rasterizer and
+// interpreter state in the library, so all faces share gFTMutex.
+static const int kFaceLockingVersion = 0x020506;
+static const int kMaxFacesPerFont = 4;
+
 /////////////////////////////////////////////////////////////////////////
 
 static bool InitFreetype() {
@@ -104,6 +118,7 @@ static bool InitFreetype() {
     }
 
     // Setup LCD filtering. This reduces color fringes for LCD smoothed glyphs.
+    bool lcdWeights = false;
 #ifdef FT_LCD_FILTER_H
     //Use light as default, as FT_LCD_FILTER_DEFAULT adds up to 0x110.
     err = FT_Library_SetLcdFilter(gFTLibrary, FT_LCD_FILTER_LIGHT);
@@ -117,6 +132,7 @@ static bool InitFreetype() {
 #if defined(SK_FONTHOST_FREETYPE_RUNTIME_VERSION) && \
             SK_FONTHOST_FREETYPE_RUNTIME_VERSION > 0x020400
         err = FT_Library_SetLcdFilterWeights(gFTLibrary, gaussianLikeWeights);
+        lcdWeights = (0 == err);
 #elif defined(SK_CAN_USE_DLOPEN) && SK_CAN_USE_DLOPEN == 1
         //The FreeType library is already loaded, so symbols are available in process.
         void* self = dlopen(NULL, RTLD_LAZY);
@@ -128,6 +144,7 @@ static bool InitFreetype() {
 
             if (NULL != setLcdFilterWeights) {
                 err = setLcdFilterWeights(gFTLibrary, gaussianLikeWeights);
+                lcdWeights = (0 == err);
             }
         }
 #endif
@@ -137,6 +154,27 @@ static bool InitFreetype() {
 #endif
     gLCDSupportValid = true;
 
+    FT_Int major, minor, patch;
+    FT_Library_Version(gFTLibrary, &major, &minor, &patch);
+    int version = (major << 16) | (minor << 8) | patch;
+    gFaceLocking = version >= kFaceLockingVersion;
+
+    // Everything decided at runtime that changes the glyphs we generate.
+    uint32_t scaler[] = {
+        (uint32_t)version,
+        gLCDSupport,
+        (uint32_t)gLCDExtra,
+        lcdWeights,
+#ifdef SK_GAMMA_APPLY_TO_A8
+        1,
+#else
+        0,
+#endif
+    };
+    gScalerID = SkChecksum::Compute(scaler, sizeof(scaler));
+    // 0 means the scaler can't be identified
+    gScalerID = gScalerID ? gScalerID : 1;
+
     return true;
 }
 
@@ -184,6 +222,13 @@ private:
 
 #include "SkStream.h"
 
+// An FT_Size, shared by the scaler contexts of a face with the same scale.
+struct SkFaceSizeRec {
+    FT_Size         fSize;
+    SkFixed         fScaleX, fScaleY;
+    uint32_t        fRefCnt;
+};
+
 struct SkFaceRec {
     SkFaceRec*      fNext;
     FT_Face         fFace;
@@ -191,6 +236,12 @@ struct SkFaceRec {
     SkStream*       fSkStream;
     uint32_t        fRefCnt;
     uint32_t        fFontID;
+    SkTDArray<SkFaceSizeRec> fSizes;
+    // Held while fFace or its sizes are used, if gFaceLocking.
+    SkMutex         fMutex;
+    // Threads holding or waiting for fMutex, and how often one had to wait.
+    int32_t         fLockers;
+    int32_t         fContention;
 
     // assumes ownership of the stream, will call unref() when its done
     SkFaceRec(SkStream* strm, uint32_t fontID);
@@ -231,7 +282,8 @@ extern "C" {
 }
 
 SkFaceRec::SkFaceRec(SkStream* strm, uint32_t fontID)
-        : fNext(NULL), fSkStream(strm), fRefCnt(1), fFontID(fontID) {
+        : fNext(NULL), fSkStream(strm), fRefCnt(1), fFontID(fontID)
+        , fLockers(0), fContention(0) {
 //    SkDEBUGF(("SkFaceRec: opening %s (%p)\n", key.c_str(), strm));
 
     sk_bzero(&fFTStream, sizeof(fFTStream));
@@ -241,17 +293,53 @@ SkFaceRec::SkFaceRec(SkStream* strm, uint32_t fontID)
     fFTStream.close = sk_stream_close;
 }
 
-// Will return 0 on failure
-static SkFaceRec* ref_ft_face(uint32_t fontID) {
+static bool has_size(const SkFaceRec* rec, SkFixed scaleX, SkFixed scaleY) {
+    for (int i = 0; i < rec->fSizes.count(); i++) {
+        if (rec->fSizes[i].fScaleX == scaleX &&
+                rec->fSizes[i].fScaleY == scaleY) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Another face may be opened for the font only if each of its faces is in
+// memory and has made a thread wait for its mutex.
+static bool can_add_face(const SkFaceRec* rec) {
+    return gFaceLocking &&
+           rec->fContention > 0 &&
+           NULL != rec->fSkStream->getMemoryBase();
+}
+
+// Will return 0 on failure. Prefers a face that already has a size for
+// scaleX, scaleY. Otherwise it uses the least used face of the font, unless
+// can_add_face() allows another one, up to kMaxFacesPerFont. Callers that
+// don't need a size pass 0 for the scale, and get any face of the font.
+static SkFaceRec* ref_ft_face(uint32_t fontID, SkFixed scaleX = 0,
+                              SkFixed scaleY = 0) {
+    SkFaceRec* leastUsed = NULL;
+    int faceCount = 0;
+    bool addFace = true;
     SkFaceRec* rec = gFaceRecHead;
     while (rec) {
         if (rec->fFontID == fontID) {
             SkASSERT(rec->fFace);
-            rec->fRefCnt += 1;
-            return rec;
+            if (0 == scaleX || has_size(rec, scaleX, scaleY)) {
+                rec->fRefCnt += 1;
+                return rec;
+            }
+            if (NULL == leastUsed || rec->fRefCnt < leastUsed->fRefCnt) {
+                leastUsed = rec;
+            }
+            faceCount += 1;
+            addFace = addFace && can_add_face(rec);
         }
         rec = rec->fNext;
     }
+    if (leastUsed && (!addFace || faceCount >= kMaxFacesPerFont)) {
+        leastUsed->fRefCnt += 1;
+        return leastUsed;
+    }
 
     SkStream* strm = SkFontHost::OpenStream(fontID);
     if (NULL == strm) {
@@ -295,6 +383,91 @@ static SkFaceRec* ref_ft_face(uint32_t fontID) {
     }
 }
 
+// Returns the face's size for scaleX, scaleY, creating it if needed, or NULL if
+// that fails. Call with the face locked.
+static FT_Size ref_ft_size(SkFaceRec* rec, SkFixed scaleX, SkFixed scaleY) {
+    for (int i = 0; i < rec->fSizes.count(); i++) {
+        SkFaceSizeRec& sizeRec = rec->fSizes[i];
+        if (sizeRec.fScaleX == scaleX && sizeRec.fScaleY == scaleY) {
+            sizeRec.fRefCnt += 1;
+            return sizeRec.fSize;
+        }
+    }
+
+    FT_Size size;
+    FT_Error err = FT_New_Size(rec->fFace, &size);
+    if (err != 0) {
+        SkDEBUGF(("FT_New_Size(%x, 0x%x, 0x%x) returned 0x%x\n",
+                  rec->fFontID, scaleX, scaleY, err));
+        return NULL;
+    }
+    err = FT_Activate_Size(size);
+    if (0 == err) {
+        err = FT_Set_Char_Size(rec->fFace, SkFixedToFDot6(scaleX),
+                               SkFixedToFDot6(scaleY), 72, 72);
+    }
+    if (err != 0) {
+        SkDEBUGF(("FT_Set_Char_Size(%x, 0x%x, 0x%x) returned 0x%x\n",
+                  rec->fFontID, scaleX, scaleY, err));
+        FT_Done_Size(size);
+        return NULL;
+    }
+
+    SkFaceSizeRec* sizeRec = rec->fSizes.append();
+    sizeRec->fSize = size;
+    sizeRec->fScaleX = scaleX;
+    sizeRec->fScaleY = scaleY;
+    sizeRec->fRefCnt = 1;
+    return size;
+}
+
+// Call with the face locked.
+static void unref_ft_size(SkFaceRec* rec, FT_Size size) {
+    for (int i = 0; i < rec->fSizes.count(); i++) {
+        if (rec->fSizes[i].fSize == size) {
+            if (--rec->fSizes[i].fRefCnt == 0) {
+                FT_Done_Size(size);
+                rec->fSizes.removeShuffle(i);
+            }
+            return;
+        }
+    }
+    SkDEBUGFAIL("shouldn't get here, size not in face");
+}
+
+// Holds the face's mutex, or gFTMutex without gFaceLocking, while the face is
+// used and gFTMutex isn't held. Counts the times a thread had to wait.
+class SkAutoFaceLock : SkNoncopyable {
+public:
+    explicit SkAutoFaceLock(SkFaceRec* rec) : fRec(rec) {
+        if (gFaceLocking) {
+            if (sk_atomic_inc(&fRec->fLockers) > 0) {
+                sk_atomic_inc(&fRec->fContention);
+            }
+            fRec->fMutex.acquire();
+        } else {
+            gFTMutex.acquire();
+        }
+    }
+
+    ~SkAutoFaceLock() {
+        if (gFaceLocking) {
+            fRec->fMutex.release();
+            sk_atomic_dec(&fRec->fLockers);
+        } else {
+            gFTMutex.release();
+        }
+    }
+
+private:
+    SkFaceRec* fRec;
+};
+
+// Returns the mutex to hold, on top of gFTMutex, while using the face.
+static SkBaseMutex* extra_face_mutex(SkFaceRec* rec) {
+    return gFaceLocking ? &rec->fMutex : NULL;
+}
+
 static void unref_ft_face(FT_Face face) {
     SkFaceRec*  rec = gFaceRecHead;
     SkFaceRec*  prev = NULL;
@@ -449,6 +622,7 @@ SkAdvancedTypefaceMetrics* SkFontHost::GetAdvancedTypefaceMetrics(
     if (NULL == rec)
         return NULL;
     FT_Face face = rec->fFace;
+    SkAutoMutexAcquire faceLock(extra_face_mutex(rec));
 
     SkAdvancedTypefaceMetrics* info = new SkAdvancedTypefaceMetrics;
     info->fFontName.set(FT_Get_Postscript_Name(face));
@@ -613,6 +787,7 @@ SkAdvancedTypefaceMetrics* SkFontHost::GetAdvancedTypefaceMetrics(
     if (!canEmbed(face))
         info->fType = SkAdvancedTypefaceMetrics::kNotEmbeddable_Font;
 
+    faceLock.release();
     unref_ft_face(face);
     return info;
 #endif
@@ -679,6 +854,14 @@ void SkFontHost::FilterRec(SkScalerContext::Rec* rec) {
 #endif
 }
 
+uint32_t SkFontHost::GetScalerID() {
+    SkAutoMutexAcquire ac(gFTMutex);
+    if (!gLCDSupportValid && InitFreetype()) {
+        FT_Done_FreeType(gFTLibrary);
+    }
+    return gScalerID;
+}
+
 #ifdef SK_BUILD_FOR_ANDROID
 uint32_t SkFontHost::GetUnitsPerEm(SkFontID fontID) {
     SkAutoMutexAcquire ac(gFTMutex);
@@ -705,14 +888,9 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(const SkDescriptor* desc)
     }
     ++gFTCount;
 
-    // load the font file
     fFTSize = NULL;
     fFace = NULL;
-    fFaceRec = ref_ft_face(fRec.fFontID);
-    if (NULL == fFaceRec) {
-        return;
-    }
-    fFace = fFaceRec->fFace;
+    fFaceRec = NULL;
 
     // compute our factors from the record
 
@@ -817,49 +995,29 @@ SkScalerContext_FreeType::SkScalerContext_FreeType(const SkDescriptor* desc)
         fDoLinearMetrics = linearMetrics;
     }
 
-    // now create the FT_Size
-
-    {
-        FT_Error    err;
-
-        err = FT_New_Size(fFace, &fFTSize);
-        if (err != 0) {
-            SkDEBUGF(("SkScalerContext_FreeType::FT_New_Size(%x): FT_Set_Char_Size(0x%x, 0x%x) returned 0x%x\n",
-                        fFaceRec->fFontID, fScaleX, fScaleY, err));
-            fFace = NULL;
-            return;
-        }
-
-        err = FT_Activate_Size(fFTSize);
-        if (err != 0) {
-            SkDEBUGF(("SkScalerContext_FreeType::FT_Activate_Size(%x, 0x%x, 0x%x) returned 0x%x\n",
-                        fFaceRec->fFontID, fScaleX, fScaleY, err));
-            fFTSize = NULL;
-        }
-
-        err = FT_Set_Char_Size( fFace,
-                                SkFixedToFDot6(fScaleX), SkFixedToFDot6(fScaleY),
-                                72, 72);
-        if (err != 0) {
-            SkDEBUGF(("SkScalerContext_FreeType::FT_Set_Char_Size(%x, 0x%x, 0x%x) returned 0x%x\n",
-                        fFaceRec->fFontID, fScaleX, fScaleY, err));
-            fFace = NULL;
-            return;
-        }
-
-        FT_Set_Transform( fFace, &fMatrix22, NULL);
+    // load the font file, and get the shared FT_Size for our scale
+    fFaceRec = ref_ft_face(fRec.fFontID, fScaleX, fScaleY);
+    if (NULL == fFaceRec) {
+        return;
     }
+    SkAutoMutexAcquire faceLock(extra_face_mutex(fFaceRec));
+    fFTSize = ref_ft_size(fFaceRec, fScaleX, fScaleY);
+    if (NULL == fFTSize) {
+        return;
+    }
+    fFace = fFaceRec->fFace;
+    FT_Set_Transform( fFace, &fMatrix22, NULL);
 }
 
 SkScalerContext_FreeType::~SkScalerContext_FreeType() {
-    if (fFTSize != NULL) {
-        FT_Done_Size(fFTSize);
-    }
-
     SkAutoMutexAcquire  ac(gFTMutex);
 
-    if (fFace != NULL) {
-        unref_ft_face(fFace);
+    if (fFaceRec != NULL) {
+        if (fFTSize != NULL) {
+            SkAutoMutexAcquire faceLock(extra_face_mutex(fFaceRec));
+            unref_ft_size(fFaceRec, fFTSize);
+        }
+        unref_ft_face(fFaceRec->fFace);
     }
     if (--gFTCount == 0) {
 //        SkDEBUGF(("FT_Done_FreeType\n"));
@@ -869,7 +1027,7 @@ SkScalerContext_FreeType::~SkScalerContext_FreeType() {
 }
 
 /*  We call this before each use of the fFace, since we may be sharing
-    this face with other context (at different sizes).
+    this face with other context (at different sizes or matrices).
 */
 FT_Error SkScalerContext_FreeType::setupSize() {
     FT_Error    err = FT_Activate_Size(fFTSize);
@@ -877,7 +1035,6 @@ FT_Error SkScalerContext_FreeType::setupSize() {
     if (err != 0) {
         SkDEBUGF(("SkScalerContext_FreeType::FT_Activate_Size(%x, 0x%x, 0x%x) returned 0x%x\n",
                     fFaceRec->fFontID, fScaleX, fScaleY, err));
-        fFTSize = NULL;
     } else {
         // seems we need to reset this every time (not sure why, but without it
         // I get random italics from some other fFTSize)
@@ -891,10 +1048,13 @@ unsigned SkScalerContext_FreeType::generateGlyphCount() {
 }
 
 uint16_t SkScalerContext_FreeType::generateCharToGlyph(SkUnichar uni) {
+    SkAutoFaceLock  ac(fFaceRec);
     return SkToU16(FT_Get_Char_Index( fFace, uni ));
 }
 
 SkUnichar SkScalerContext_FreeType::generateGlyphToChar(uint16_t glyph) {
+    SkAutoFaceLock  ac(fFaceRec);
+
     // iterate through each cmap entry, looking for matching glyph indices
     FT_UInt glyphIndex;
     SkUnichar charCode = FT_Get_First_Char( fFace, &glyphIndex );
@@ -915,7 +1075,7 @@ void SkScalerContext_FreeType::generateAdvance(SkGlyph* glyph) {
     * which are very cheap to compute with some font formats...
     */
     if (fDoLinearMetrics) {
-        SkAutoMutexAcquire  ac(gFTMutex);
+        SkAutoFaceLock  ac(fFaceRec);
 
         if (this->setupSize()) {
             glyph->zeroMetrics();
@@ -989,7 +1149,7 @@ void SkScalerContext_FreeType::updateGlyphPosIfLCD(SkGlyph* glyph) {
 }
 
 void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph) {
-    SkAutoMutexAcquire  ac(gFTMutex);
+    SkAutoFaceLock  ac(fFaceRec);
 
     glyph->fRsbDelta = 0;
     glyph->fLsbDelta = 0;
@@ -1137,7 +1297,7 @@ void SkScalerContext_FreeType::generateMetrics(SkGlyph* glyph) {
 
 
 void SkScalerContext_FreeType::generateImage(const SkGlyph& glyph, SkMaskGamma::PreBlend* maskPreBlend) {
-    SkAutoMutexAcquire  ac(gFTMutex);
+    SkAutoFaceLock  ac(fFaceRec);
 
     FT_Error    err;
 
@@ -1160,7 +1320,7 @@ void SkScalerContext_FreeType::generateImage(const SkGlyph& glyph, SkMaskGamma::
 
 void SkScalerContext_FreeType::generatePath(const SkGlyph& glyph,
                                             SkPath* path) {
-    SkAutoMutexAcquire  ac(gFTMutex);
+    SkAutoFaceLock  ac(fFaceRec);
 
     SkASSERT(&glyph && path);
 
@@ -1191,7 +1351,7 @@ void SkScalerContext_FreeType::generateFontMetrics(SkPaint::FontMetrics* mx,
         return;
     }
 
-    SkAutoMutexAcquire  ac(gFTMutex);
+    SkAutoFaceLock  ac(fFaceRec);
 
     if (this->setupSize()) {
         ERROR:
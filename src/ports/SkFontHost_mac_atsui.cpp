@@ -114,6 +114,11 @@ void SkFontHost::FilterRec(SkScalerContext::Rec* rec) {
     }
 }
 
+uint32_t SkFontHost::GetScalerID() {
+    // The system rasterizer's version isn't known, so glyphs aren't saved.
+    return 0;
+}
+
 SkScalerContext_Mac::SkScalerContext_Mac(const SkDescriptor* desc)
     : SkScalerContext(desc), fLayout(0), fStyle(0)
 {
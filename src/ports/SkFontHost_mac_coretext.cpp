@@ -1840,6 +1840,11 @@ void SkFontHost::FilterRec(SkScalerContext::Rec* rec) {
     }
 }
 
+uint32_t SkFontHost::GetScalerID() {
+    // The system rasterizer's version isn't known, so glyphs aren't saved.
+    return 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 
 int SkFontHost::CountTables(SkFontID fontID) {
@@ -39,6 +39,10 @@ SkAdvancedTypefaceMetrics* SkFontHost::GetAdvancedTypefaceMetrics(
 void SkFontHost::FilterRec(SkScalerContext::Rec* rec) {
 }
 
+uint32_t SkFontHost::GetScalerID() {
+    return 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 SkStream* SkFontHost::OpenStream(uint32_t uniqueID) {
@@ -1714,3 +1714,8 @@ void SkFontHost::FilterRec(SkScalerContext::Rec* rec) {
     }
 #endif
 }
+
+uint32_t SkFontHost::GetScalerID() {
+    // The system rasterizer's version isn't known, so glyphs aren't saved.
+    return 0;
+}
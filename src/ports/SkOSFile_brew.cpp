@@ -9,6 +9,7 @@
 
 
 #include "SkOSFile.h"
+#include "SkThread.h"
 
 #ifdef SK_BUILD_FOR_BREW
 
@@ -87,4 +88,11 @@ void sk_fclose(SkFILE* f)
     IFILE_Release((IFile*)f);
 }
 
+void sk_make_temp_path(const char path[], SkString* tmpPath)
+{
+    // BREW applets don't share files with other processes.
+    static int32_t gTempCount;
+    tmpPath->printf("%s.%d.tmp", path, sk_atomic_inc(&gTempCount));
+}
+
 #endif
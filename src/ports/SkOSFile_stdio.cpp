@@ -8,10 +8,19 @@
 
 
 #include "SkOSFile.h"
+#include "SkThread.h"
 
 #include <stdio.h>
 #include <errno.h>
 
+#ifdef SK_BUILD_FOR_WIN
+    #include <process.h>
+    #define sk_getpid   _getpid
+#else
+    #include <unistd.h>
+    #define sk_getpid   getpid
+#endif
+
 SkFILE* sk_fopen(const char path[], SkFILE_Flags flags)
 {
     char    perm[4];
@@ -98,3 +107,9 @@ void sk_fclose(SkFILE* f)
     ::fclose((FILE*)f);
 }
 
+void sk_make_temp_path(const char path[], SkString* tmpPath)
+{
+    static int32_t gTempCount;
+    tmpPath->printf("%s.%d.%d.tmp", path, (int)sk_getpid(),
+                    sk_atomic_inc(&gTempCount));
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkThreadPool.h"
+#include "SkRunnable.h"
+#include "SkThread.h"
+#include "SkThreadUtils.h"
+
+#if defined(SK_BUILD_FOR_WIN32)
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+SkThreadPool::SkThreadPool(int count) : fNext(0), fThreadCount(count) {
+}
+
+SkThreadPool::~SkThreadPool() {
+    this->wait();
+}
+
+void SkThreadPool::add(SkRunnable* r) {
+    SkASSERT(r);
+    *fQueue.append() = r;
+}
+
+// Each thread (including the caller's) claims jobs until there are none left
+void SkThreadPool::Loop(void* arg) {
+    SkThreadPool* pool = static_cast<SkThreadPool*>(arg);
+    const int32_t count = pool->fQueue.count();
+    for (;;) {
+        int32_t index = sk_atomic_inc(&pool->fNext);
+        if (index >= count) {
+            break;
+        }
+        pool->fQueue[index]->run();
+    }
+}
+
+void SkThreadPool::wait() {
+    const int count = fQueue.count();
+    if (0 == count) {
+        return;
+    }
+
+    fNext = 0;
+    // the calling thread works too, so we need one fewer helper
+    const int helperCount = SkMin32(fThreadCount, count) - 1;
+    SkTDArray<SkThread*> threads;
+    for (int i = 0; i < helperCount; ++i) {
+        SkThread* thread = SkNEW_ARGS(SkThread, (SkThreadPool::Loop, this));
+        if (!thread->start()) {
+            // the remaining threads (or just the caller) pick up the slack
+            SkDELETE(thread);
+            break;
+        }
+        *threads.append() = thread;
+    }
+
+    SkThreadPool::Loop(this);
+
+    for (int i = 0; i < threads.count(); ++i) {
+        threads[i]->join();
+        SkDELETE(threads[i]);
+    }
+    fQueue.rewind();
+}
+
+int SkThreadPool::NumCores() {
+#if defined(SK_BUILD_FOR_WIN32)
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return SkMax32(1, sysinfo.dwNumberOfProcessors);
+#elif defined(_SC_NPROCESSORS_ONLN)
+    return SkMax32(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+#else
+    return 1;
+#endif
+}
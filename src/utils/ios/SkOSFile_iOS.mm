@@ -8,6 +8,9 @@
 #include <Foundation/Foundation.h>
 #include "SkOSFile.h"
 #include "SkString.h"
+#include "SkThread.h"
+
+#include <unistd.h>
 
 struct SkFILE {
     NSData* fData;
@@ -96,3 +99,8 @@ void sk_fclose(SkFILE* rec) {
     delete rec;
 }
 
+void sk_make_temp_path(const char path[], SkString* tmpPath) {
+    static int32_t gTempCount;
+    tmpPath->printf("%s.%d.%d.tmp", path, (int)getpid(),
+                    sk_atomic_inc(&gTempCount));
+}
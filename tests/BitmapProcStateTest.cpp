@@ -0,0 +1,247 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkShader.h"
+#include "SkUtils.h"
+#include "SkXfermode.h"
+
+static const int W = 40;
+static const int H = 30;
+static const int DEV_SIZE = 64;
+
+// Each texel encodes its own coordinates, so we can tell which one was picked
+static void make_coord_bitmap(SkBitmap* bm) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, W, H);
+    bm->allocPixels();
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            *bm->getAddr32(x, y) = SkPackARGB32(0xFF, x, y, 0x80);
+        }
+    }
+}
+
+static void make_dev(SkBitmap* dev) {
+    dev->setConfig(SkBitmap::kARGB_8888_Config, DEV_SIZE, DEV_SIZE);
+    dev->allocPixels();
+    dev->eraseColor(0);
+}
+
+static void draw_with_shader(SkBitmap* dev, const SkBitmap& bm,
+                             SkShader::TileMode tx, SkShader::TileMode ty,
+                             const SkMatrix& matrix, SkPaint* paint) {
+    SkShader* s = SkShader::CreateBitmapShader(bm, tx, ty);
+    s->setLocalMatrix(matrix);
+    paint->setShader(s)->unref();
+
+    SkCanvas canvas(*dev);
+    canvas.drawPaint(*paint);
+}
+
+static float tile_float(float v, int n, SkShader::TileMode mode) {
+    switch (mode) {
+        case SkShader::kClamp_TileMode:
+            if (v < 0) {
+                return 0;
+            }
+            return v < n ? v : n - 1;
+        case SkShader::kRepeat_TileMode:
+            v = fmodf(v, (float)n);
+            return v < 0 ? v + n : v;
+        default: {
+            v = fmodf(v, (float)(2 * n));
+            if (v < 0) {
+                v += 2 * n;
+            }
+            return v < n ? v : 2 * n - v;
+        }
+    }
+}
+
+// the fixed point matrix procs may round differently than float, so allow
+// the neighboring texel (wrapping around for repeat)
+static bool close_enough(int actual, float expected, int n,
+                         SkShader::TileMode mode) {
+    int d = SkAbs32(actual - (int)expected);
+    if (SkShader::kRepeat_TileMode == mode) {
+        d = SkMin32(d, n - d);
+    }
+    return d <= 1;
+}
+
+static void test_nofilter(skiatest::Reporter* reporter,
+                          SkShader::TileMode tx, SkShader::TileMode ty,
+                          const SkMatrix& matrix) {
+    SkBitmap bm, dev;
+    make_coord_bitmap(&bm);
+    make_dev(&dev);
+
+    SkPaint paint;
+    draw_with_shader(&dev, bm, tx, ty, matrix, &paint);
+
+    SkMatrix inv;
+    REPORTER_ASSERT(reporter, matrix.invert(&inv));
+    for (int y = 0; y < DEV_SIZE; ++y) {
+        for (int x = 0; x < DEV_SIZE; ++x) {
+            SkPoint pt;
+            inv.mapXY(SkIntToScalar(x) + SK_ScalarHalf,
+                      SkIntToScalar(y) + SK_ScalarHalf, &pt);
+            float ex = tile_float(SkScalarToFloat(pt.fX), W, tx);
+            float ey = tile_float(SkScalarToFloat(pt.fY), H, ty);
+
+            SkPMColor c = *dev.getAddr32(x, y);
+            if (!close_enough(SkGetPackedR32(c), ex, W, tx) ||
+                    !close_enough(SkGetPackedG32(c), ey, H, ty)) {
+                SkString str;
+                str.printf("tile(%d,%d) at (%d,%d): got texel (%d,%d) "
+                           "expected (%g,%g)", tx, ty, x, y,
+                           SkGetPackedR32(c), SkGetPackedG32(c), ex, ey);
+                reporter->reportFailed(str);
+                return;
+            }
+        }
+    }
+}
+
+static void test_matrix_procs(skiatest::Reporter* reporter) {
+    static const SkShader::TileMode gModes[] = {
+        SkShader::kClamp_TileMode,
+        SkShader::kRepeat_TileMode,
+        SkShader::kMirror_TileMode,
+    };
+
+    SkMatrix up, down, persp;
+    up.setScale(SkFloatToScalar(1.7f), SkFloatToScalar(1.3f));
+    up.postTranslate(SkFloatToScalar(-5.25f), SkFloatToScalar(3.5f));
+    down.setScale(SkFloatToScalar(0.6f), SkFloatToScalar(0.45f));
+    down.postTranslate(SkFloatToScalar(7.5f), SkFloatToScalar(-2.75f));
+    persp.setAll(SK_Scalar1, SkFloatToScalar(0.2f), SkIntToScalar(-4),
+                 SkFloatToScalar(0.1f), SK_Scalar1, SkIntToScalar(3),
+                 SkFloatToScalar(0.004f), SkFloatToScalar(0.002f),
+                 SK_Scalar1);
+
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gModes); ++i) {
+        test_nofilter(reporter, gModes[i], gModes[i], up);
+        test_nofilter(reporter, gModes[i], gModes[i], down);
+    }
+    test_nofilter(reporter, SkShader::kClamp_TileMode,
+                  SkShader::kClamp_TileMode, persp);
+}
+
+// A constant bitmap should come out constant, whatever the filter and tiling
+static void test_constant(skiatest::Reporter* reporter, bool highQuality,
+                          SkShader::TileMode mode, const SkMatrix& matrix) {
+    const SkPMColor color = SkPackARGB32(0x80, 0x40, 0x20, 0x10);
+
+    SkBitmap bm, dev;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, W, H);
+    bm.allocPixels();
+    sk_memset32(bm.getAddr32(0, 0), color, W * H);
+    make_dev(&dev);
+
+    SkPaint paint;
+    paint.setXfermodeMode(SkXfermode::kSrc_Mode);
+    paint.setFilterBitmap(true);
+    paint.setHighQualityFilterBitmap(highQuality);
+    draw_with_shader(&dev, bm, mode, mode, matrix, &paint);
+
+    for (int y = 0; y < DEV_SIZE; ++y) {
+        for (int x = 0; x < DEV_SIZE; ++x) {
+            SkPMColor c = *dev.getAddr32(x, y);
+            bool ok = SkAbs32(SkGetPackedA32(c) - SkGetPackedA32(color)) <= 1 &&
+                      SkAbs32(SkGetPackedR32(c) - SkGetPackedR32(color)) <= 1 &&
+                      SkAbs32(SkGetPackedG32(c) - SkGetPackedG32(color)) <= 1 &&
+                      SkAbs32(SkGetPackedB32(c) - SkGetPackedB32(color)) <= 1;
+            if (!ok) {
+                SkString str;
+                str.printf("constant hq=%d tile=%d at (%d,%d): got %08x",
+                           highQuality, mode, x, y, c);
+                reporter->reportFailed(str);
+                return;
+            }
+        }
+    }
+}
+
+// Minifying a high contrast checkerboard exercises the negative lobes of the
+// bicubic kernel, which must not produce invalid premultiplied colors.
+static void test_bicubic_checker(skiatest::Reporter* reporter) {
+    SkBitmap bm, dev;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, W, H);
+    bm.allocPixels();
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            *bm.getAddr32(x, y) = ((x ^ y) & 1) ? SkPackARGB32(0xFF, 0, 0, 0) :
+                                                  SkPackARGB32(0, 0, 0, 0);
+        }
+    }
+    make_dev(&dev);
+
+    SkMatrix matrix;
+    matrix.setScale(SkFloatToScalar(0.7f), SkFloatToScalar(0.55f));
+
+    SkPaint paint;
+    paint.setXfermodeMode(SkXfermode::kSrc_Mode);
+    paint.setHighQualityFilterBitmap(true);
+    draw_with_shader(&dev, bm, SkShader::kRepeat_TileMode,
+                     SkShader::kMirror_TileMode, matrix, &paint);
+
+    int sum = 0;
+    for (int y = 0; y < DEV_SIZE; ++y) {
+        for (int x = 0; x < DEV_SIZE; ++x) {
+            SkPMColor c = *dev.getAddr32(x, y);
+            unsigned a = SkGetPackedA32(c);
+            if (SkGetPackedR32(c) > a || SkGetPackedG32(c) > a ||
+                    SkGetPackedB32(c) > a) {
+                reporter->reportFailed(SkString("bicubic produced non-premul"));
+                return;
+            }
+            sum += a;
+        }
+    }
+    // half the texels are opaque, so the average should be close to half
+    int average = sum / (DEV_SIZE * DEV_SIZE);
+    REPORTER_ASSERT(reporter, SkAbs32(average - 0x80) < 8);
+}
+
+static void test_filters(skiatest::Reporter* reporter) {
+    static const SkShader::TileMode gModes[] = {
+        SkShader::kClamp_TileMode,
+        SkShader::kRepeat_TileMode,
+        SkShader::kMirror_TileMode,
+    };
+
+    SkMatrix matrices[4];
+    matrices[0].setScale(SkFloatToScalar(2.5f), SkFloatToScalar(1.5f));
+    matrices[1].setScale(SkFloatToScalar(0.3f), SkFloatToScalar(0.6f));
+    matrices[2].setRotate(SkIntToScalar(30));
+    matrices[3].setAll(SK_Scalar1, 0, 0,
+                       0, SK_Scalar1, 0,
+                       SkFloatToScalar(0.003f), SkFloatToScalar(0.001f),
+                       SK_Scalar1);
+
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gModes); ++i) {
+        for (size_t j = 0; j < SK_ARRAY_COUNT(matrices); ++j) {
+            test_constant(reporter, false, gModes[i], matrices[j]);
+            test_constant(reporter, true, gModes[i], matrices[j]);
+        }
+    }
+    test_bicubic_checker(reporter);
+}
+
+static void TestBitmapProcState(skiatest::Reporter* reporter) {
+#ifdef SK_SCALAR_IS_FLOAT
+    test_matrix_procs(reporter);
+    test_filters(reporter);
+#endif
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("BitmapProcState", BitmapProcStateTestClass, TestBitmapProcState)
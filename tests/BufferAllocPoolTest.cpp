@@ -0,0 +1,170 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+
+// This is a GPU-backend specific test
+#if SK_SUPPORT_GPU
+#include "DebugGLCanvas.h"
+#include "GrDrawTarget.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "../../src/gpu/GrBufferAllocPool.h"
+
+static const size_t kBufferSize = 1 << 12;
+static const int kBufferCount = 2;
+// positions only
+static const GrVertexLayout kLayout = 0;
+static const int kBufferVertices = kBufferSize / sizeof(GrPoint);
+
+static bool make_space(GrVertexBufferAllocPool* pool, int vertexCount,
+                       const GrVertexBuffer** buffer, int* startVertex) {
+    return NULL != pool->makeSpace(kLayout, vertexCount, buffer, startVertex);
+}
+
+// In ring mode each reset carries on in the buffer used last, and only the
+// vertices added since the last unlock are written.
+static void test_ring_mode(skiatest::Reporter* reporter, GrGpu* gpu) {
+    GrVertexBufferAllocPool pool(gpu, false, kBufferSize, kBufferCount);
+    pool.setRingMode(true);
+    pool.resetCounts();
+
+    const GrVertexBuffer* first = NULL;
+    const GrVertexBuffer* buffer;
+    int start;
+    int frames = kBufferVertices / 100;
+    for (int i = 0; i < frames; ++i) {
+        REPORTER_ASSERT(reporter, make_space(&pool, 100, &buffer, &start));
+        if (0 == i) {
+            first = buffer;
+        }
+        REPORTER_ASSERT(reporter, first == buffer);
+        REPORTER_ASSERT(reporter, 100 * i == start);
+        pool.unlock();
+        pool.reset();
+    }
+    REPORTER_ASSERT(reporter, frames * 100 * (int) sizeof(GrPoint) ==
+                              pool.bytesUploaded());
+
+    // the next frame doesn't fit, so it moves on to the other buffer
+    REPORTER_ASSERT(reporter, make_space(&pool, 100, &buffer, &start));
+    const GrVertexBuffer* second = buffer;
+    REPORTER_ASSERT(reporter, first != second);
+    REPORTER_ASSERT(reporter, 0 == start);
+    pool.unlock();
+
+    // unlocking doesn't end the block
+    REPORTER_ASSERT(reporter, make_space(&pool, 10, &buffer, &start));
+    REPORTER_ASSERT(reporter, second == buffer);
+    REPORTER_ASSERT(reporter, 100 == start);
+    pool.resetCounts();
+    pool.unlock();
+    REPORTER_ASSERT(reporter, 10 * (int) sizeof(GrPoint) ==
+                              pool.bytesUploaded());
+    pool.reset();
+
+    // the ring wraps around to the first buffer, but never to a buffer that
+    // was used since the last reset
+    REPORTER_ASSERT(reporter, make_space(&pool, kBufferVertices - 200,
+                                         &buffer, &start));
+    REPORTER_ASSERT(reporter, second == buffer);
+    REPORTER_ASSERT(reporter, make_space(&pool, 200, &buffer, &start));
+    REPORTER_ASSERT(reporter, first == buffer);
+    REPORTER_ASSERT(reporter, 0 == start);
+    REPORTER_ASSERT(reporter, make_space(&pool, kBufferVertices - 100,
+                                         &buffer, &start));
+    REPORTER_ASSERT(reporter, first != buffer && second != buffer);
+    pool.unlock();
+    pool.reset();
+
+    // vertices put back after they were written aren't written over, as a
+    // draw may have read them
+    REPORTER_ASSERT(reporter, make_space(&pool, 10, &buffer, &start));
+    int written = start;
+    pool.unlock();
+    pool.putBack(10 * sizeof(GrPoint));
+    pool.reset();
+    REPORTER_ASSERT(reporter, make_space(&pool, 10, &buffer, &start));
+    REPORTER_ASSERT(reporter, written + 10 == start);
+    pool.unlock();
+
+    // the same holds for part of a block, while what wasn't written is
+    // given back
+    written = start;
+    REPORTER_ASSERT(reporter, make_space(&pool, 10, &buffer, &start));
+    pool.putBack(15 * sizeof(GrPoint));
+    REPORTER_ASSERT(reporter, make_space(&pool, 10, &buffer, &start));
+    REPORTER_ASSERT(reporter, written + 10 == start);
+    pool.reset();
+
+    REPORTER_ASSERT(reporter, 1 == pool.buffersCreated());
+    REPORTER_ASSERT(reporter, 0 == pool.lockCount());
+}
+
+// Otherwise each reset starts a preallocated buffer over.
+static void test_default_mode(skiatest::Reporter* reporter, GrGpu* gpu) {
+    GrVertexBufferAllocPool pool(gpu, false, kBufferSize, kBufferCount);
+    pool.setRingMode(false);
+
+    const GrVertexBuffer* prev = NULL;
+    const GrVertexBuffer* buffer;
+    int start;
+    for (int i = 0; i < 4; ++i) {
+        REPORTER_ASSERT(reporter, make_space(&pool, 100, &buffer, &start));
+        REPORTER_ASSERT(reporter, prev != buffer);
+        REPORTER_ASSERT(reporter, 0 == start);
+        prev = buffer;
+        pool.unlock();
+        pool.reset();
+    }
+}
+
+// The context reports what its pools did.
+static void test_draw_stats(skiatest::Reporter* reporter,
+                            skiatest::DebugGLCanvas* target) {
+    GrContext* context = target->context();
+    SkCanvas* canvas = target->canvas();
+    REPORTER_ASSERT(reporter, !context->getGeometryRingBuffers());
+
+    SkPath path;
+    path.moveTo(0, 0);
+    path.quadTo(SkIntToScalar(40), 0, SkIntToScalar(40), SkIntToScalar(40));
+    path.lineTo(0, SkIntToScalar(40));
+    path.close();
+    SkPaint paint;
+
+    context->flush();
+    context->resetDrawStats();
+    canvas->drawPath(path, paint);
+    context->flush();
+    GrContext::DrawStats stats;
+    context->getDrawStats(&stats);
+    REPORTER_ASSERT(reporter, stats.fGeometryBytesUploaded > 0);
+
+    context->setGeometryRingBuffers(true);
+    REPORTER_ASSERT(reporter, context->getGeometryRingBuffers());
+    canvas->drawPath(path, paint);
+    context->flush();
+    context->setGeometryRingBuffers(false);
+}
+
+static void test_buffer_alloc_pool(skiatest::Reporter* reporter) {
+    skiatest::DebugGLCanvas target(64, 64);
+    if (!target.isValid()) {
+        return;
+    }
+    GrGpu* gpu = target.context()->getGpu();
+    test_ring_mode(reporter, gpu);
+    test_default_mode(reporter, gpu);
+    test_draw_stats(reporter, &target);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("BufferAllocPool", BufferAllocPoolTestClass,
+                 test_buffer_alloc_pool)
+
+#endif
@@ -9,6 +9,7 @@
 #include "Test.h"
 // This is a GR test
 #if SK_SUPPORT_GPU
+#include "SkCanvas.h"
 #include "SkGpuDevice.h"
 #include "../../src/gpu/GrClipMaskManager.h"
 
@@ -216,10 +217,173 @@ static void test_cache(skiatest::Reporter* reporter, GrContext* context) {
     REPORTER_ASSERT(reporter, 1 == texture2->getRefCnt());
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// masks acquired for clips that come back can be found again while the texture
+// cache keeps them
+static void test_find_mask(skiatest::Reporter* reporter, GrContext* context) {
+
+    GrClipMaskCache cache;
+
+    cache.setContext(context);
+
+    GrIRect bound;
+    bound.set(0, 0, X_SIZE, Y_SIZE);
+    SkPath path;
+    path.addCircle(6, 6, 5);
+    SkClipStack clip1;
+    clip1.clipDevPath(path, SkRegion::kReplace_Op, true);
+    path.reset();
+    path.addRoundRect(SkRect::MakeWH(10, 10), 3, 3);
+    SkClipStack clip2;
+    clip2.clipDevPath(path, SkRegion::kReplace_Op, true);
+    SkIPoint origin = { 0, 0 };
+
+    GrTextureDesc desc;
+    desc.fFlags = kRenderTarget_GrTextureFlagBit|kNoStencil_GrTextureFlagBit;
+    desc.fWidth = X_SIZE;
+    desc.fHeight = Y_SIZE;
+    desc.fConfig = kAlpha_8_GrPixelConfig;
+
+    GrContext::ResourceCacheStats scratchStats, contentStats;
+    context->getResourceCacheStats(kContentTexture_GrResourceCategory,
+                                   &contentStats);
+    int contentCount = contentStats.fCount;
+
+    REPORTER_ASSERT(reporter, !cache.findMask(clip1, origin, bound));
+
+    // the first mask of a clip is drawn into a scratch texture, which isn't
+    // found again
+    cache.acquireMask(clip1, origin, desc, bound);
+    GrTexture* scratch = cache.getLastMask();
+    REPORTER_ASSERT(reporter, scratch);
+    if (NULL == scratch) {
+        return;
+    }
+    cache.acquireMask(clip2, origin, desc, bound);
+    cache.reset();
+    REPORTER_ASSERT(reporter, !cache.findMask(clip1, origin, bound));
+
+    // once the clip comes back its mask gets a texture of its own
+    cache.acquireMask(clip1, origin, desc, bound);
+    GrTexture* texture1 = cache.getLastMask();
+    REPORTER_ASSERT(reporter, texture1);
+    if (NULL == texture1) {
+        return;
+    }
+    REPORTER_ASSERT(reporter, X_SIZE == texture1->width() &&
+                              Y_SIZE == texture1->height());
+    REPORTER_ASSERT(reporter, !cache.findMask(clip2, origin, bound));
+    cache.acquireMask(clip2, origin, desc, bound);
+    GrTexture* texture2 = cache.getLastMask();
+    REPORTER_ASSERT(reporter, texture2 && texture2 != texture1);
+    cache.reset();
+
+    // which is budgeted as a scratch texture, not as content
+    context->getResourceCacheStats(kContentTexture_GrResourceCategory,
+                                   &contentStats);
+    REPORTER_ASSERT(reporter, contentCount == contentStats.fCount);
+    context->getResourceCacheStats(kScratchTexture_GrResourceCategory,
+                                   &scratchStats);
+    REPORTER_ASSERT(reporter, scratchStats.fCount >= 3);
+
+    // alternating between the clips finds their masks
+    for (int i = 0; i < 2; ++i) {
+        REPORTER_ASSERT(reporter, cache.findMask(clip1, origin, bound));
+        check_state(reporter, cache, clip1, texture1, bound);
+        REPORTER_ASSERT(reporter, cache.findMask(clip2, origin, bound));
+        check_state(reporter, cache, clip2, texture2, bound);
+    }
+
+    // as does a copy of a clip, from another level of the stack
+    SkClipStack copy(clip1);
+    cache.push();
+    REPORTER_ASSERT(reporter, cache.findMask(copy, origin, bound));
+    check_state(reporter, cache, clip1, texture1, bound);
+    cache.pop();
+
+    // but not for the clip drawn elsewhere
+    SkIPoint otherOrigin = { 1, 0 };
+    REPORTER_ASSERT(reporter, !cache.findMask(clip1, otherOrigin, bound));
+    GrIRect otherBound(bound);
+    otherBound.outset(1, 1);
+    REPORTER_ASSERT(reporter, !cache.findMask(clip1, origin, otherBound));
+
+    // a mask that wasn't drawn after all isn't found
+    REPORTER_ASSERT(reporter, cache.findMask(clip2, origin, bound));
+    cache.forgetLastMask();
+    SkClipStack emptyClip;
+    check_state(reporter, cache, emptyClip, NULL, GrIRect::MakeEmpty());
+    REPORTER_ASSERT(reporter, !cache.findMask(clip2, origin, bound));
+
+    // nor one purged from the texture cache
+    REPORTER_ASSERT(reporter, cache.findMask(clip1, origin, bound));
+    cache.reset();
+    context->freeGpuResources();
+    REPORTER_ASSERT(reporter, !cache.findMask(clip1, origin, bound));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+static int clip_masks_rendered(GrContext* context) {
+    context->flush();
+    GrContext::DrawStats stats;
+    context->getDrawStats(&stats);
+    return stats.fClipMasksRendered;
+}
+
+static void draw_clipped(SkCanvas* canvas, const SkPath& clip) {
+    canvas->save();
+    canvas->clipPath(clip);
+    canvas->drawColor(SK_ColorBLUE);
+    canvas->restore();
+}
+
+// the context counts the clip masks it renders
+static void test_mask_counts(skiatest::Reporter* reporter,
+                             GrContext* context) {
+
+    GrTextureDesc desc;
+    desc.fFlags     = kRenderTarget_GrTextureFlagBit;
+    desc.fConfig    = kSkia8888_PM_GrPixelConfig;
+    desc.fWidth     = 64;
+    desc.fHeight    = 64;
+
+    GrTexture* texture = context->createUncachedTexture(desc, NULL, 0);
+    if (!texture) {
+        return;
+    }
+    GrAutoUnref au(texture);
+
+    SkCanvas canvas;
+    canvas.setDevice(new SkGpuDevice(context,
+                                     texture->asRenderTarget()))->unref();
+
+    SkPath circle;
+    circle.addCircle(20, 20, 15);
+    SkPath roundRect;
+    roundRect.addRoundRect(SkRect::MakeXYWH(30, 30, 30, 30), 5, 5);
+
+    context->flush();
+    context->resetDrawStats();
+
+    // drawing under the same clip again reuses its mask
+    draw_clipped(&canvas, circle);
+    REPORTER_ASSERT(reporter, 1 == clip_masks_rendered(context));
+    draw_clipped(&canvas, circle);
+    REPORTER_ASSERT(reporter, 1 == clip_masks_rendered(context));
+
+    draw_clipped(&canvas, roundRect);
+    REPORTER_ASSERT(reporter, 2 == clip_masks_rendered(context));
+
+    context->resetDrawStats();
+    REPORTER_ASSERT(reporter, 0 == clip_masks_rendered(context));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 static void TestClipCache(skiatest::Reporter* reporter, GrContext* context) {
 
     test_cache(reporter, context);
+    test_find_mask(reporter, context);
+    test_mask_counts(reporter, context);
     test_clip_bounds(reporter, context);
 }
 
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "SkTypes.h"
+
+#if SK_SUPPORT_GPU
+#include "DebugGLCanvas.h"
+#include "SkGpuDevice.h"
+
+using namespace skiatest;
+
+DebugGLCanvas::DebugGLCanvas(int width, int height) {
+    fContext = fFactory.get(GrContextFactory::kDebug_GLContextType);
+    if (NULL == fContext) {
+        return;
+    }
+    GrTextureDesc desc;
+    desc.fFlags = kRenderTarget_GrTextureFlagBit;
+    desc.fConfig = kSkia8888_PM_GrPixelConfig;
+    desc.fWidth = width;
+    desc.fHeight = height;
+    fTexture.reset(fContext->createUncachedTexture(desc, NULL, 0));
+    if (NULL == fTexture.get()) {
+        return;
+    }
+    SkGpuDevice* device = SkNEW_ARGS(SkGpuDevice,
+                                     (fContext, fTexture->asRenderTarget()));
+    fCanvas.setDevice(device)->unref();
+}
+
+#endif
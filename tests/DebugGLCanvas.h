@@ -0,0 +1,42 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#ifndef skiatest_DebugGLCanvas_DEFINED
+#define skiatest_DebugGLCanvas_DEFINED
+
+#include "GrContextFactory.h"
+#include "GrTexture.h"
+#include "SkCanvas.h"
+
+namespace skiatest {
+
+    /**
+     *  A canvas drawing to a render target texture of a debug GL context, for
+     *  tests of what the GPU backend does. The context and texture live as
+     *  long as the canvas.
+     */
+    class DebugGLCanvas : SkNoncopyable {
+    public:
+        DebugGLCanvas(int width, int height);
+
+        // false if the context or its texture couldn't be made, in which
+        // case the test should return without drawing
+        bool isValid() const { return NULL != fTexture.get(); }
+
+        GrContext* context() const { return fContext; }
+        GrTexture* texture() const { return fTexture.get(); }
+        SkCanvas* canvas() { return &fCanvas; }
+
+    private:
+        // declared in this order so the canvas is destroyed first
+        GrContextFactory        fFactory;
+        GrContext*              fContext;
+        SkAutoTUnref<GrTexture> fTexture;
+        SkCanvas                fCanvas;
+    };
+}
+
+#endif
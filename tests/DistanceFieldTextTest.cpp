@@ -0,0 +1,96 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkDistanceField.h"
+#include "SkPaint.h"
+
+// A filled square's field is above the outline value inside it, below it
+// outside, and grows with the distance from the edge.
+static void test_field(skiatest::Reporter* reporter) {
+    const int kSize = 24;
+    const int kInset = 8;
+    uint8_t image[kSize * kSize];
+    for (int y = 0; y < kSize; y++) {
+        for (int x = 0; x < kSize; x++) {
+            bool inside = x >= kInset && x < kSize - kInset &&
+                          y >= kInset && y < kSize - kInset;
+            image[y * kSize + x] = inside ? 0xFF : 0;
+        }
+    }
+    SkGenerateDistanceFieldFromA8(image, kSize, kSize, kSize);
+
+    const int y = kSize / 2;
+    const uint8_t* row = image + y * kSize;
+    REPORTER_ASSERT(reporter, row[kInset] > SK_DistanceFieldOutline);
+    REPORTER_ASSERT(reporter, row[kInset - 1] < SK_DistanceFieldOutline);
+    for (int x = 1; x <= kInset; x++) {
+        REPORTER_ASSERT(reporter, row[x - 1] <= row[x]);
+    }
+    REPORTER_ASSERT(reporter, row[kInset + 2] > row[kInset]);
+    REPORTER_ASSERT(reporter, 0 == row[0]);
+}
+
+static void draw_text(SkBitmap* bm, const SkPaint& paint, SkScalar degrees) {
+    static const char gText[] = "Distance fields";
+    bm->eraseColor(SK_ColorWHITE);
+    SkCanvas canvas(*bm);
+    canvas.rotate(degrees);
+    canvas.drawText(gText, sizeof(gText) - 1, SkIntToScalar(20),
+                    paint.getTextSize() * 2, paint);
+}
+
+// Text drawn from distance fields covers about the same pixels as text drawn
+// from an antialiased, subpixel positioned strike of the same size.
+static void test_text(skiatest::Reporter* reporter, SkScalar size,
+                      SkScalar degrees) {
+    SkBitmap aa, df;
+    aa.setConfig(SkBitmap::kARGB_8888_Config, 640, 240);
+    aa.allocPixels();
+    df.setConfig(SkBitmap::kARGB_8888_Config, 640, 240);
+    df.allocPixels();
+
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setSubpixelText(true);
+    paint.setLinearText(true);
+    paint.setTextSize(size);
+    draw_text(&aa, paint, degrees);
+    paint.setDistanceFieldText(true);
+    draw_text(&df, paint, degrees);
+
+    SkAutoLockPixels aaLock(aa);
+    SkAutoLockPixels dfLock(df);
+    int inked = 0;
+    int diffSum = 0;
+    for (int y = 0; y < aa.height(); y++) {
+        for (int x = 0; x < aa.width(); x++) {
+            int a = SkColorGetG(*aa.getAddr32(x, y));
+            int d = SkColorGetG(*df.getAddr32(x, y));
+            if (a != 0xFF || d != 0xFF) {
+                inked += 1;
+                diffSum += SkAbs32(a - d);
+            }
+        }
+    }
+    REPORTER_ASSERT(reporter, inked > 0);
+    REPORTER_ASSERT(reporter, diffSum < 16 * inked);
+}
+
+static void TestDistanceFieldText(skiatest::Reporter* reporter) {
+    test_field(reporter);
+    test_text(reporter, SkIntToScalar(16), 0);
+    test_text(reporter, SkIntToScalar(48), 0);
+    test_text(reporter, SkIntToScalar(48), SkIntToScalar(20));
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("DistanceFieldText", DistanceFieldTextTestClass,
+                 TestDistanceFieldText)
@@ -85,8 +85,44 @@ static void TestFlate(skiatest::Reporter* reporter, SkMemoryStream* testStream,
                                      testData.getLength()) == 0);
 }
 
+static void TestFlateLevels(skiatest::Reporter* reporter) {
+    static const size_t kDataSize = 10240;
+    SkAutoMalloc storage(kDataSize);
+    uint8_t* data = (uint8_t*)storage.get();
+    for (size_t i = 0; i < kDataSize; i++) {
+        data[i] = (i * i / 64) & 0xFF;  // Compressible, but not trivially.
+    }
+
+    size_t lastSize = 0;
+    for (int level = SkFlate::kMin_CompressionLevel;
+         level <= SkFlate::kMax_CompressionLevel;
+         level += SkFlate::kMax_CompressionLevel) {
+        SkDynamicMemoryWStream compressed;
+        REPORTER_ASSERT(reporter,
+                        SkFlate::Deflate(data, kDataSize, &compressed, level));
+        // Level 0 stores the data; 9 should do better.
+        if (0 == level) {
+            REPORTER_ASSERT(reporter, compressed.getOffset() > kDataSize);
+        } else {
+            REPORTER_ASSERT(reporter, compressed.getOffset() < lastSize);
+        }
+        lastSize = compressed.getOffset();
+
+        SkAutoDataUnref compressedData(compressed.copyToData());
+        SkMemoryStream stream(compressedData->data(), compressedData->size());
+        SkDynamicMemoryWStream uncompressed;
+        REPORTER_ASSERT(reporter, SkFlate::Inflate(&stream, &uncompressed));
+        SkAutoDataUnref uncompressedData(uncompressed.copyToData());
+        REPORTER_ASSERT(reporter, uncompressedData->size() == kDataSize &&
+                        0 == memcmp(uncompressedData->data(), data, kDataSize));
+    }
+}
+
 static void TestFlateCompression(skiatest::Reporter* reporter) {
     TestFlate(reporter, NULL, 0);
+    if (SkFlate::HaveFlate()) {
+        TestFlateLevels(reporter);
+    }
 #if defined(SK_ZLIB_INCLUDE) && !defined(SK_DEBUG)
     REPORTER_ASSERT(reporter, SkFlate::HaveFlate());
 
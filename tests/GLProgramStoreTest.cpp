@@ -0,0 +1,289 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+
+// This is a GPU-backend specific test
+#if SK_SUPPORT_GPU
+#include "GrContext.h"
+#include "GrContextFactory.h"
+#include "GrRenderTarget.h"
+#include "GrTexture.h"
+#include "gl/GrGLInterface.h"
+#include "gl/GrGLProgramStore.h"
+#include "gl/GrGpuGL.h"
+#include "SkData.h"
+#include "SkStream.h"
+
+#include <stdio.h>
+
+static const char gStorePath[] = "GLProgramStoreTest.grps";
+
+static void make_source(GrGLProgramStore::Source* source, const char color[]) {
+    source->fVertexShader = "attribute vec2 aPosition;\n"
+                            "void main() {\n"
+                            "\tgl_Position = vec4(aPosition, 0, 1);\n"
+                            "}\n";
+    source->fFragmentShader.printf("void main() {\n"
+                                   "\tgl_FragColor = vec4(%s);\n"
+                                   "}\n", color);
+    source->fAttribNames.push_back().set("aPosition");
+    source->fAttribNames.push_back();
+    source->fAttribNames.push_back().set("aColor");
+}
+
+// The debug GL interface expects every program to have been used.
+static void delete_program(const GrGLContextInfo& gl, GrGLuint programID) {
+    GR_GL_CALL(gl.interface(), UseProgram(programID));
+    GR_GL_CALL(gl.interface(), UseProgram(0));
+    GR_GL_CALL(gl.interface(), DeleteProgram(programID));
+}
+
+static void corrupt_store() {
+    SkAutoTUnref<SkData> data;
+    {
+        SkFILEStream stream(gStorePath);
+        size_t length = stream.getLength();
+        SkAutoMalloc storage(length);
+        stream.read(storage.get(), length);
+        ((uint8_t*)storage.get())[length / 2] ^= 0x10;
+        data.reset(SkData::NewWithCopy(storage.get(), length));
+    }
+    SkFILEWStream stream(gStorePath);
+    stream.write(data->data(), data->size());
+}
+
+// Programs created through one store are linked from the file by the next,
+// from their binaries where the driver has them.
+static void test_store(skiatest::Reporter* reporter,
+                       const GrGLInterface* interface) {
+    GrGLContextInfo gl(interface);
+    if (!gl.isInitialized()) {
+        return;
+    }
+    bool binaries = gl.caps().programBinarySupport();
+
+    GrGLProgramStore::Source red, green;
+    make_source(&red, "1, 0, 0, 1");
+    make_source(&green, "0, 1, 0, 1");
+    REPORTER_ASSERT(reporter, red == red);
+    REPORTER_ASSERT(reporter, !(red == green));
+
+    remove(gStorePath);
+    {
+        GrGLProgramStore store(gl, gStorePath);
+        REPORTER_ASSERT(reporter, 0 == store.count());
+        REPORTER_ASSERT(reporter, 0 == store.stats().fLoaded);
+        GrGLuint programID = store.createProgram(red);
+        REPORTER_ASSERT(reporter, 0 != programID);
+        REPORTER_ASSERT(reporter, 1 == store.stats().fMisses);
+        delete_program(gl, programID);
+
+        // Asking again relinks the binary, if there is one.
+        programID = store.createProgram(red);
+        REPORTER_ASSERT(reporter, 0 != programID);
+        REPORTER_ASSERT(reporter, (binaries ? 1 : 0) == store.stats().fHits);
+        delete_program(gl, programID);
+        REPORTER_ASSERT(reporter, 1 == store.count());
+        REPORTER_ASSERT(reporter, store.flush());
+    }
+    {
+        GrGLProgramStore store(gl, gStorePath);
+        REPORTER_ASSERT(reporter, 1 == store.stats().fLoaded);
+        REPORTER_ASSERT(reporter, 1 == store.stats().fPrewarmed);
+        REPORTER_ASSERT(reporter,
+                        (binaries ? 1 : 0) == store.stats().fBinaryLinks);
+        GrGLuint programID = store.createProgram(red);
+        REPORTER_ASSERT(reporter, 0 != programID);
+        REPORTER_ASSERT(reporter, 1 == store.stats().fHits);
+        REPORTER_ASSERT(reporter, 0 == store.stats().fMisses);
+        delete_program(gl, programID);
+
+        programID = store.createProgram(green);
+        REPORTER_ASSERT(reporter, 1 == store.stats().fMisses);
+        delete_program(gl, programID);
+        REPORTER_ASSERT(reporter, 2 == store.count());
+        REPORTER_ASSERT(reporter, store.flush());
+    }
+    {
+        GrGLProgramStore store(gl, gStorePath);
+        REPORTER_ASSERT(reporter, 2 == store.stats().fPrewarmed);
+        delete_program(gl, store.createProgram(red));
+        delete_program(gl, store.createProgram(green));
+        REPORTER_ASSERT(reporter, 2 == store.stats().fHits);
+    }
+
+    corrupt_store();
+    {
+        GrGLProgramStore store(gl, gStorePath);
+        REPORTER_ASSERT(reporter, 0 == store.stats().fLoaded);
+        REPORTER_ASSERT(reporter, 0 == store.count());
+    }
+    remove(gStorePath);
+}
+
+// Past kMaxEntries the least recently used program is forgotten.
+static void test_eviction(skiatest::Reporter* reporter,
+                          const GrGLInterface* interface) {
+    GrGLContextInfo gl(interface);
+    if (!gl.isInitialized()) {
+        return;
+    }
+    static const int kCount = GrGLProgramStore::kMaxEntries + 1;
+    SkTArray<GrGLProgramStore::Source> sources(kCount);
+    for (int i = 0; i < kCount; ++i) {
+        SkString color;
+        color.printf("%d.0, 0, 0, 1", i);
+        make_source(&sources.push_back(), color.c_str());
+    }
+
+    remove(gStorePath);
+    {
+        GrGLProgramStore store(gl, gStorePath);
+        for (int i = 0; i < kCount - 1; ++i) {
+            delete_program(gl, store.createProgram(sources[i]));
+        }
+        delete_program(gl, store.createProgram(sources[0]));
+        delete_program(gl, store.createProgram(sources[kCount - 1]));
+        REPORTER_ASSERT(reporter,
+                        GrGLProgramStore::kMaxEntries == store.count());
+        REPORTER_ASSERT(reporter, store.flush());
+    }
+    {
+        GrGLProgramStore store(gl, gStorePath);
+        REPORTER_ASSERT(reporter,
+                        GrGLProgramStore::kMaxEntries == store.stats().fLoaded);
+        delete_program(gl, store.createProgram(sources[0]));
+        REPORTER_ASSERT(reporter, 1 == store.stats().fHits);
+        delete_program(gl, store.createProgram(sources[1]));
+        REPORTER_ASSERT(reporter, 1 == store.stats().fMisses);
+    }
+    remove(gStorePath);
+}
+
+// flush() doesn't write to a temporary file another process could be using.
+static void test_temp_file(skiatest::Reporter* reporter,
+                           const GrGLInterface* interface) {
+    GrGLContextInfo gl(interface);
+    if (!gl.isInitialized()) {
+        return;
+    }
+    SkString oldTmpPath(gStorePath);
+    oldTmpPath.append(".tmp");
+    static const char gOther[] = "another writer";
+    {
+        SkFILEWStream other(oldTmpPath.c_str());
+        other.write(gOther, sizeof(gOther));
+    }
+    {
+        GrGLProgramStore store(gl, gStorePath);
+        REPORTER_ASSERT(reporter, store.flush());
+    }
+    SkFILEStream other(oldTmpPath.c_str());
+    REPORTER_ASSERT(reporter, sizeof(gOther) == other.getLength());
+    remove(oldTmpPath.c_str());
+    remove(gStorePath);
+}
+
+// Programs stored for one driver aren't loaded for another.
+static void test_driver(skiatest::Reporter* reporter,
+                        const GrGLInterface* writer,
+                        const GrGLInterface* reader) {
+    GrGLContextInfo writerGL(writer);
+    GrGLContextInfo readerGL(reader);
+    if (!writerGL.isInitialized() || !readerGL.isInitialized()) {
+        return;
+    }
+    GrGLProgramStore::Source source;
+    make_source(&source, "0, 0, 1, 1");
+
+    remove(gStorePath);
+    {
+        GrGLProgramStore store(writerGL, gStorePath);
+        delete_program(writerGL, store.createProgram(source));
+        REPORTER_ASSERT(reporter, store.flush());
+    }
+    {
+        GrGLProgramStore store(readerGL, gStorePath);
+        REPORTER_ASSERT(reporter, 0 == store.stats().fLoaded);
+    }
+    remove(gStorePath);
+}
+
+static GrGLProgramStore::Stats draw(skiatest::Reporter* reporter) {
+    GrGLProgramStore::Stats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    GrContextFactory factory;
+    GrContext* context = factory.get(GrContextFactory::kDebug_GLContextType);
+    if (NULL == context) {
+        return stats;
+    }
+    GrTextureDesc desc;
+    desc.fFlags = kRenderTarget_GrTextureFlagBit;
+    desc.fConfig = kSkia8888_PM_GrPixelConfig;
+    desc.fWidth = 16;
+    desc.fHeight = 16;
+    SkAutoTUnref<GrTexture> texture(context->createUncachedTexture(desc,
+                                                                   NULL, 0));
+    if (NULL == texture.get()) {
+        return stats;
+    }
+    context->setRenderTarget(texture->asRenderTarget());
+    GrPaint paint;
+    paint.reset();
+    paint.fColor = 0xFF00FF00;
+    context->drawRect(paint, GrRect::MakeWH(SkIntToScalar(8),
+                                            SkIntToScalar(8)));
+    context->flush();
+    REPORTER_ASSERT(reporter, context->flushProgramCache());
+    context->setRenderTarget(NULL);
+
+    const GrGpuGL* gpu = static_cast<const GrGpuGL*>(context->getGpu());
+    REPORTER_ASSERT(reporter, NULL != gpu->programStore());
+    if (NULL != gpu->programStore()) {
+        stats = gpu->programStore()->stats();
+    }
+    return stats;
+}
+
+// Contexts share programs through the file set with SetProgramCachePath().
+static void test_context(skiatest::Reporter* reporter) {
+    remove(gStorePath);
+    GrContext::SetProgramCachePath(gStorePath);
+
+    GrGLProgramStore::Stats first = draw(reporter);
+    REPORTER_ASSERT(reporter, 0 == first.fLoaded);
+    REPORTER_ASSERT(reporter, first.fMisses > 0);
+
+    GrGLProgramStore::Stats second = draw(reporter);
+    REPORTER_ASSERT(reporter, second.fLoaded == first.fMisses);
+    REPORTER_ASSERT(reporter, second.fPrewarmed == second.fLoaded);
+    REPORTER_ASSERT(reporter, second.fHits > 0);
+    REPORTER_ASSERT(reporter, 0 == second.fMisses);
+
+    GrContext::SetProgramCachePath(NULL);
+    remove(gStorePath);
+}
+
+static void TestGLProgramStore(skiatest::Reporter* reporter) {
+    SkAutoTUnref<const GrGLInterface> debug(GrGLCreateDebugInterface());
+    test_store(reporter, debug);
+    test_temp_file(reporter, debug);
+    SkAutoTUnref<const GrGLInterface> null(GrGLCreateNullInterface());
+    test_store(reporter, null);
+    // The debug interface would object to the programs linked from the file
+    // and never used.
+    test_eviction(reporter, null);
+    test_driver(reporter, debug, null);
+    test_context(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("GLProgramStore", GLProgramStoreTestClass, TestGLProgramStore)
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+
+// This is a GPU-backend specific test
+#if SK_SUPPORT_GPU
+#include "DebugGLCanvas.h"
+#include "SkColorMatrixFilter.h"
+#include "SkGradientShader.h"
+#include "SkPaint.h"
+#include "gl/debug/GrDebugGL.h"
+
+static const int kSize = 64;
+
+static void draw_frame(SkCanvas* canvas, const SkPaint& gradient,
+                       const SkPaint& colorMatrix) {
+    for (int i = 0; i < 4; ++i) {
+        SkRect rect = SkRect::MakeXYWH(SkIntToScalar(i * 8), 0,
+                                       SkIntToScalar(8), SkIntToScalar(8));
+        canvas->drawRect(rect, (i & 1) ? gradient : colorMatrix);
+    }
+}
+
+// Drawing a frame again sets no uniform to the value it already has, and
+// changes no more state than drawing it the first time.
+static void test_gl_state(skiatest::Reporter* reporter) {
+    skiatest::DebugGLCanvas target(kSize, kSize);
+    if (!target.isValid()) {
+        return;
+    }
+    GrContext* context = target.context();
+    SkCanvas* canvas = target.canvas();
+
+    SkPaint gradient;
+    SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(kSize), 0 } };
+    SkColor colors[] = { SK_ColorRED, SK_ColorBLUE };
+    gradient.setShader(SkGradientShader::CreateLinear(pts, colors, NULL, 2,
+                                            SkShader::kClamp_TileMode))->unref();
+    SkPaint colorMatrix;
+    SkScalar matrix[20];
+    memset(matrix, 0, sizeof(matrix));
+    matrix[2] = matrix[5] = matrix[11] = matrix[18] = SK_Scalar1;
+    colorMatrix.setColor(SK_ColorGREEN);
+    colorMatrix.setColorFilter(SkNEW_ARGS(SkColorMatrixFilter,
+                                          (matrix)))->unref();
+
+    GrDebugGL* debugGL = GrDebugGL::getInstance();
+    draw_frame(canvas, gradient, colorMatrix);
+    context->flush();
+
+    debugGL->resetCallCounts();
+    draw_frame(canvas, gradient, colorMatrix);
+    context->flush();
+    int stateCalls = debugGL->getStateCallCount();
+    REPORTER_ASSERT(reporter, 0 == debugGL->getUniformCallCount());
+
+    debugGL->resetCallCounts();
+    draw_frame(canvas, gradient, colorMatrix);
+    context->flush();
+    REPORTER_ASSERT(reporter, 0 == debugGL->getUniformCallCount());
+    REPORTER_ASSERT(reporter, stateCalls == debugGL->getStateCallCount());
+
+    // a new value is still uploaded
+    matrix[4] = SK_Scalar1;
+    colorMatrix.setColorFilter(SkNEW_ARGS(SkColorMatrixFilter,
+                                          (matrix)))->unref();
+    debugGL->resetCallCounts();
+    draw_frame(canvas, gradient, colorMatrix);
+    context->flush();
+    REPORTER_ASSERT(reporter, debugGL->getUniformCallCount() > 0);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("GLState", GLStateTestClass, test_gl_state)
+
+#endif
@@ -0,0 +1,235 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkData.h"
+#include "SkGlyphCache.h"
+#include "SkGlyphStore.h"
+#include "SkGraphics.h"
+#include "SkOSFile.h"
+#include "SkPaint.h"
+#include "SkStream.h"
+
+#include <stdio.h>
+
+static const char gText[] = "Stored glyphs";
+static const char gStorePath[] = "GlyphStoreTest.skgs";
+
+static int text_to_glyphs(const SkPaint& paint, uint16_t glyphIDs[]) {
+    return paint.textToGlyphs(gText, sizeof(gText) - 1, glyphIDs);
+}
+
+// Returns the glyphs of gText, with their images.
+static int get_glyphs(SkGlyphCache* cache, const SkPaint& paint,
+                      const SkGlyph* glyphs[]) {
+    uint16_t glyphIDs[sizeof(gText)];
+    int count = text_to_glyphs(paint, glyphIDs);
+    for (int i = 0; i < count; i++) {
+        glyphs[i] = &cache->getGlyphIDMetrics(glyphIDs[i]);
+        cache->findImage(*glyphs[i]);
+    }
+    return count;
+}
+
+static SkData* write_store(const SkGlyphStoreWriter& writer) {
+    SkDynamicMemoryWStream stream;
+    writer.write(&stream);
+    return stream.copyToData();
+}
+
+static int count_strikes(SkData* data) {
+    SkMemoryStream stream(data->data(), data->size());
+    SkGlyphStore store(&stream);
+    return store.countStrikes();
+}
+
+// Glyphs read back from a store are the ones that were written.
+static void test_round_trip(skiatest::Reporter* reporter,
+                            const SkPaint& paint) {
+    SkAutoGlyphCache autoCache(paint, NULL);
+    SkGlyphCache* cache = autoCache.getCache();
+    SkGlyphStore::Key key;
+    REPORTER_ASSERT(reporter, SkGlyphStore::MakeKey(cache->getDescriptor(),
+                                                    &key));
+
+    const SkGlyph* glyphs[sizeof(gText)];
+    int count = get_glyphs(cache, paint, glyphs);
+    SkGlyphStoreWriter writer;
+    writer.addGlyphs(key, glyphs, count);
+    SkAutoDataUnref data(write_store(writer));
+
+    SkMemoryStream stream(data->data(), data->size());
+    SkGlyphStore store(&stream);
+    REPORTER_ASSERT(reporter, 1 == store.countStrikes());
+    const SkGlyphStore::Strike* strike = store.findStrike(key);
+    REPORTER_ASSERT(reporter, strike);
+    if (NULL == strike) {
+        return;
+    }
+
+    SkAutoSMalloc<1024> image;
+    for (int i = 0; i < count; i++) {
+        const SkGlyph& glyph = *glyphs[i];
+        SkGlyph stored;
+        stored.init(glyph.fID);
+        REPORTER_ASSERT(reporter, strike->getMetrics(&stored));
+        REPORTER_ASSERT(reporter, stored.fAdvanceX == glyph.fAdvanceX &&
+                                  stored.fAdvanceY == glyph.fAdvanceY &&
+                                  stored.fWidth == glyph.fWidth &&
+                                  stored.fHeight == glyph.fHeight &&
+                                  stored.fTop == glyph.fTop &&
+                                  stored.fLeft == glyph.fLeft &&
+                                  stored.fMaskFormat == glyph.fMaskFormat);
+        if (glyph.fImage) {
+            size_t size = glyph.computeImageSize();
+            stored.fImage = image.reset(size);
+            REPORTER_ASSERT(reporter, strike->getImage(stored));
+            REPORTER_ASSERT(reporter, 0 == memcmp(stored.fImage, glyph.fImage,
+                                                  size));
+        }
+    }
+
+    // A glyph that wasn't written isn't found.
+    SkGlyph missing;
+    missing.init(SkGlyph::MakeID(0xFFFF));
+    REPORTER_ASSERT(reporter, !strike->getMetrics(&missing));
+}
+
+// A store that has been changed in any way reads as empty.
+static void test_corrupt(skiatest::Reporter* reporter, const SkPaint& paint) {
+    SkAutoGlyphCache autoCache(paint, NULL);
+    SkGlyphCache* cache = autoCache.getCache();
+    SkGlyphStore::Key key;
+    SkGlyphStore::MakeKey(cache->getDescriptor(), &key);
+    const SkGlyph* glyphs[sizeof(gText)];
+    int count = get_glyphs(cache, paint, glyphs);
+    SkGlyphStoreWriter writer;
+    writer.addGlyphs(key, glyphs, count);
+    SkAutoDataUnref data(write_store(writer));
+    REPORTER_ASSERT(reporter, 1 == count_strikes(data));
+
+    const size_t kOffsets[] = { 0, 4, data->size() / 2, data->size() - 1 };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(kOffsets); i++) {
+        SkAutoDataUnref copy(SkData::NewWithCopy(data->data(), data->size()));
+        ((uint8_t*)copy->data())[kOffsets[i]] ^= 0x10;
+        REPORTER_ASSERT(reporter, 0 == count_strikes(copy));
+    }
+    SkAutoDataUnref truncated(SkData::NewWithCopy(data->data(),
+                                                  data->size() - 4));
+    REPORTER_ASSERT(reporter, 0 == count_strikes(truncated));
+
+    // The scaler ID follows the magic and version. Glyphs from a different
+    // scaler are stale, even though the file itself is intact.
+    const size_t kScalerIDOffset = 8;
+    SkAutoDataUnref otherScaler(SkData::NewWithCopy(data->data(),
+                                                    data->size()));
+    ((uint8_t*)otherScaler->data())[kScalerIDOffset] ^= 0x10;
+    REPORTER_ASSERT(reporter, 0 == count_strikes(otherScaler));
+}
+
+// Writing a store doesn't touch the temporary file of another writer.
+static void test_temp_file(skiatest::Reporter* reporter) {
+    SkString tmpPath, otherTmpPath;
+    sk_make_temp_path(gStorePath, &tmpPath);
+    sk_make_temp_path(gStorePath, &otherTmpPath);
+    REPORTER_ASSERT(reporter, !tmpPath.equals(otherTmpPath));
+
+    SkString oldTmpPath(gStorePath);
+    oldTmpPath.append(".tmp");
+    static const char gOther[] = "another writer";
+    {
+        SkFILEWStream other(oldTmpPath.c_str());
+        other.write(gOther, sizeof(gOther));
+    }
+    SkGlyphStoreWriter writer;
+    REPORTER_ASSERT(reporter, writer.write(gStorePath));
+    SkFILEStream other(oldTmpPath.c_str());
+    REPORTER_ASSERT(reporter, sizeof(gOther) == other.getLength());
+    remove(oldTmpPath.c_str());
+    remove(gStorePath);
+}
+
+// SkGraphics' store is consulted before the scaler, and flushing it keeps the
+// glyphs already in it.
+static void test_graphics(skiatest::Reporter* reporter, const SkPaint& paint) {
+    remove(gStorePath);
+    REPORTER_ASSERT(reporter, !SkGraphics::FlushGlyphStore());
+    REPORTER_ASSERT(reporter, !SkGraphics::SetGlyphStorePath(gStorePath));
+    // Strikes created before the store was set aren't stored.
+    SkGraphics::PurgeFontCache();
+
+    SkScalar width = paint.measureText(gText, sizeof(gText) - 1);
+    REPORTER_ASSERT(reporter, SkGraphics::FlushGlyphStore());
+    SkGraphics::PurgeFontCache();
+    REPORTER_ASSERT(reporter, SkGraphics::SetGlyphStorePath(gStorePath));
+    REPORTER_ASSERT(reporter,
+                    paint.measureText(gText, sizeof(gText) - 1) == width);
+
+    // Store a different advance for the first glyph, which measureText should
+    // then use.
+    SkGlyphStore::Key key;
+    uint16_t glyphIDs[sizeof(gText)];
+    text_to_glyphs(paint, glyphIDs);
+    SkGlyph glyph;
+    {
+        SkAutoGlyphCache autoCache(paint, NULL);
+        SkGlyphCache* cache = autoCache.getCache();
+        REPORTER_ASSERT(reporter,
+                SkGlyphStore::MakeKey(cache->getDescriptor(), &key));
+        glyph = cache->getGlyphIDMetrics(glyphIDs[0]);
+    }
+    glyph.fImage = NULL;
+    glyph.fAdvanceX += SK_Fixed1 * 10;
+    const SkGlyph* glyphPtr = &glyph;
+    SkGlyphStoreWriter writer;
+    writer.addGlyphs(key, &glyphPtr, 1);
+    REPORTER_ASSERT(reporter, writer.write(gStorePath));
+
+    SkGraphics::PurgeFontCache();
+    REPORTER_ASSERT(reporter, SkGraphics::SetGlyphStorePath(gStorePath));
+    SkScalar adjusted = paint.measureText(gText, sizeof(gText) - 1);
+    REPORTER_ASSERT(reporter,
+                    SkScalarRoundToInt(adjusted - width) == 10);
+
+    // A flush keeps that glyph, and adds the rest back.
+    REPORTER_ASSERT(reporter, SkGraphics::FlushGlyphStore());
+    SkGraphics::PurgeFontCache();
+    REPORTER_ASSERT(reporter, SkGraphics::SetGlyphStorePath(gStorePath));
+    REPORTER_ASSERT(reporter,
+                    paint.measureText(gText, sizeof(gText) - 1) == adjusted);
+
+    SkGraphics::SetGlyphStorePath(NULL);
+    SkGraphics::PurgeFontCache();
+    remove(gStorePath);
+}
+
+static void TestGlyphStore(skiatest::Reporter* reporter) {
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setTextSize(SkIntToScalar(19));
+
+    // Stores only hold sfnt fonts.
+    SkAutoGlyphCache autoCache(paint, NULL);
+    SkGlyphStore::Key key;
+    if (!SkGlyphStore::MakeKey(autoCache.getCache()->getDescriptor(), &key)) {
+        return;
+    }
+    autoCache.release();
+
+    test_round_trip(reporter, paint);
+    test_corrupt(reporter, paint);
+    test_temp_file(reporter);
+    test_graphics(reporter, paint);
+
+    paint.setAntiAlias(false);
+    paint.setTextSize(SkIntToScalar(40));
+    test_round_trip(reporter, paint);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("GlyphStore", GlyphStoreTestClass, TestGlyphStore)
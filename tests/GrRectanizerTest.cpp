@@ -0,0 +1,111 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+// This is a GPU-backend specific test
+#if SK_SUPPORT_GPU
+#include "GrRectanizer.h"
+#include "GrRectanizer_skyline.h"
+#include "SkRandom.h"
+#include "SkTDArray.h"
+#include "SkTScopedPtr.h"
+
+static const int kWidth = 256;
+static const int kHeight = 256;
+
+// Adds random glyph-sized rects until one doesn't fit, checking that every
+// rect lands inside the rectanizer without overlapping another. Returns how
+// full the rectanizer got.
+static float fill(skiatest::Reporter* reporter, GrRectanizer* rectanizer,
+                  int minSize, int maxSize) {
+    SkRandom rand;
+    SkTDArray<uint8_t> used;
+    used.setCount(kWidth * kHeight);
+    memset(used.begin(), 0, used.count());
+
+    int32_t area = 0;
+    for (;;) {
+        int w = rand.nextRangeU(minSize, maxSize);
+        int h = rand.nextRangeU(minSize, maxSize);
+        GrIPoint16 loc;
+        if (!rectanizer->addRect(w, h, &loc)) {
+            break;
+        }
+        REPORTER_ASSERT(reporter, loc.fX >= 0 && loc.fX + w <= kWidth);
+        REPORTER_ASSERT(reporter, loc.fY >= 0 && loc.fY + h <= kHeight);
+        if (loc.fX < 0 || loc.fX + w > kWidth ||
+            loc.fY < 0 || loc.fY + h > kHeight) {
+            break;
+        }
+        bool overlap = false;
+        for (int y = loc.fY; y < loc.fY + h; ++y) {
+            for (int x = loc.fX; x < loc.fX + w; ++x) {
+                overlap |= (0 != used[y * kWidth + x]);
+                used[y * kWidth + x] = 1;
+            }
+        }
+        REPORTER_ASSERT(reporter, !overlap);
+        area += w * h;
+    }
+
+    float percentFull = rectanizer->percentFull();
+    REPORTER_ASSERT(reporter,
+                    area == (int32_t)(percentFull * kWidth * kHeight + 0.5f));
+    return percentFull;
+}
+
+static void test_rectanizer(skiatest::Reporter* reporter) {
+    GrIPoint16 loc;
+
+    // too big, or empty
+    SkTScopedPtr<GrRectanizer> skyline(GrRectanizer::Factory(
+        kWidth, kHeight, GrRectanizer::kSkyline_Type));
+    REPORTER_ASSERT(reporter, !skyline->addRect(kWidth + 1, 1, &loc));
+    REPORTER_ASSERT(reporter, !skyline->addRect(1, kHeight + 1, &loc));
+    REPORTER_ASSERT(reporter, 0 == skyline->percentFull());
+
+    // one rect the size of the whole area
+    REPORTER_ASSERT(reporter, skyline->addRect(kWidth, kHeight, &loc));
+    REPORTER_ASSERT(reporter, 0 == loc.fX && 0 == loc.fY);
+    REPORTER_ASSERT(reporter, 1 == skyline->percentFull());
+    REPORTER_ASSERT(reporter, !skyline->addRect(1, 1, &loc));
+
+    // a rect straddling a step in the skyline wastes the space under it
+    skyline.reset(GrRectanizer::Factory(kWidth, kHeight,
+                                        GrRectanizer::kSkyline_Type));
+    GrRectanizerSkyline* impl = static_cast<GrRectanizerSkyline*>(skyline.get());
+    REPORTER_ASSERT(reporter, skyline->addRect(kWidth / 2, 10, &loc));
+    REPORTER_ASSERT(reporter, 0 == impl->percentWasted());
+    REPORTER_ASSERT(reporter, skyline->addRect(kWidth / 2, 20, &loc));
+    REPORTER_ASSERT(reporter, kWidth / 2 == loc.fX && 0 == loc.fY);
+    REPORTER_ASSERT(reporter, skyline->addRect(kWidth, 5, &loc));
+    REPORTER_ASSERT(reporter, 0 == loc.fX && 20 == loc.fY);
+    REPORTER_ASSERT(reporter,
+                    10 * kWidth / 2 == impl->percentWasted() * kWidth * kHeight);
+
+    // mixed glyph sizes pack tighter along a skyline than in pow2 rows
+    static const int gSizes[][2] = { { 4, 32 }, { 8, 24 }, { 12, 40 } };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gSizes); ++i) {
+        SkTScopedPtr<GrRectanizer> pow2(GrRectanizer::Factory(
+            kWidth, kHeight, GrRectanizer::kPow2_Type));
+        skyline.reset(GrRectanizer::Factory(kWidth, kHeight,
+                                            GrRectanizer::kSkyline_Type));
+        float pow2Full = fill(reporter, pow2.get(),
+                              gSizes[i][0], gSizes[i][1]);
+        float skylineFull = fill(reporter, skyline.get(),
+                                 gSizes[i][0], gSizes[i][1]);
+        REPORTER_ASSERT(reporter, skylineFull > pow2Full);
+
+        impl = static_cast<GrRectanizerSkyline*>(skyline.get());
+        REPORTER_ASSERT(reporter, skylineFull + impl->percentWasted() <= 1);
+    }
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("GrRectanizer", GrRectanizerClass, test_rectanizer)
+
+#endif
@@ -6,6 +6,7 @@
  * found in the LICENSE file.
  */
 #include "Test.h"
+#include "SkCanvas.h"
 #include "SkTemplates.h"
 #include "SkShader.h"
 #include "SkColorShader.h"
@@ -126,6 +127,71 @@ static void conical_gradproc(skiatest::Reporter* reporter, const GradRec& rec) {
     REPORTER_ASSERT(reporter, !memcmp(info.fRadius, rec.fRadius, 2 * sizeof(SkScalar)));
 }
 
+static void draw_gradient(SkBitmap::Config config, const SkPoint pts[2],
+                          const SkColor colors[], int count, U8CPU alpha) {
+    SkBitmap bm;
+    bm.setConfig(config, 16, 16);
+    bm.allocPixels();
+    SkCanvas canvas(bm);
+
+    SkPaint paint;
+    paint.setAlpha(alpha);
+    paint.setShader(SkGradientShader::CreateLinear(pts, colors, NULL, count,
+                                                   SkShader::kClamp_TileMode))->unref();
+    canvas.drawPaint(paint);
+}
+
+static void test_gradient_cache(skiatest::Reporter* reporter) {
+    static const SkColor gColors[] = { SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE };
+    static const SkPoint gPts0[] = { { 0, 0 }, { SkIntToScalar(16), 0 } };
+    static const SkPoint gPts1[] = { { 0, 0 }, { 0, SkIntToScalar(8) } };
+    const int count = SK_ARRAY_COUNT(gColors);
+
+    SkGradientShader::PurgeCache();
+
+    SkGradientShader::CacheStats before, after;
+    SkGradientShader::GetCacheStats(&before);
+    REPORTER_ASSERT(reporter, 0 == before.fEntryCount);
+    REPORTER_ASSERT(reporter, 0 == before.fBytesUsed);
+
+    // same colors, different geometry: the second draw shares the first's table
+    draw_gradient(SkBitmap::kARGB_8888_Config, gPts0, gColors, count, 0xFF);
+    draw_gradient(SkBitmap::kARGB_8888_Config, gPts1, gColors, count, 0xFF);
+    SkGradientShader::GetCacheStats(&after);
+    REPORTER_ASSERT(reporter, 1 == after.fEntryCount);
+    REPORTER_ASSERT(reporter, after.fMissCount - before.fMissCount == 1);
+    REPORTER_ASSERT(reporter, after.fHitCount - before.fHitCount == 1);
+    REPORTER_ASSERT(reporter, after.fBytesUsed > 0);
+    REPORTER_ASSERT(reporter, after.fBytesUsed <= after.fByteLimit);
+
+    // a different paint alpha needs its own 32bit table...
+    draw_gradient(SkBitmap::kARGB_8888_Config, gPts0, gColors, count, 0x80);
+    SkGradientShader::GetCacheStats(&after);
+    REPORTER_ASSERT(reporter, 2 == after.fEntryCount);
+
+    // ...and 565 uses a separate 16bit table
+    draw_gradient(SkBitmap::kRGB_565_Config, gPts0, gColors, count, 0xFF);
+    draw_gradient(SkBitmap::kRGB_565_Config, gPts1, gColors, count, 0xFF);
+    SkGradientShader::GetCacheStats(&after);
+    REPORTER_ASSERT(reporter, 3 == after.fEntryCount);
+    REPORTER_ASSERT(reporter, after.fHitCount - before.fHitCount == 2);
+
+    // shrinking the limit purges, and a zero limit disables sharing
+    size_t oldLimit = SkGradientShader::SetCacheLimit(0);
+    REPORTER_ASSERT(reporter, 0 == SkGradientShader::GetCacheLimit());
+    SkGradientShader::GetCacheStats(&after);
+    REPORTER_ASSERT(reporter, 0 == after.fEntryCount);
+    REPORTER_ASSERT(reporter, 0 == after.fBytesUsed);
+    REPORTER_ASSERT(reporter, after.fPurgeCount - before.fPurgeCount == 3);
+
+    draw_gradient(SkBitmap::kARGB_8888_Config, gPts0, gColors, count, 0xFF);
+    SkGradientShader::GetCacheStats(&after);
+    REPORTER_ASSERT(reporter, 0 == after.fEntryCount);
+
+    SkGradientShader::SetCacheLimit(oldLimit);
+    REPORTER_ASSERT(reporter, oldLimit == SkGradientShader::GetCacheLimit());
+}
+
 typedef void (*GradProc)(skiatest::Reporter* reporter, const GradRec&);
 
 static void TestGradients(skiatest::Reporter* reporter) {
@@ -158,6 +224,8 @@ static void TestGradients(skiatest::Reporter* reporter) {
     for (size_t i = 0; i < SK_ARRAY_COUNT(gProcs); ++i) {
         gProcs[i](reporter, rec);
     }
+
+    test_gradient_cache(reporter);
 }
 
 #include "TestClassDef.h"
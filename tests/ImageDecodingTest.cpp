@@ -0,0 +1,181 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkColorPriv.h"
+#include "SkData.h"
+#include "SkImageDecoder.h"
+#include "SkImageEncoder.h"
+#include "SkStream.h"
+
+static const int W = 67;
+static const int H = 53;
+
+// smooth enough that jpeg round trips it with small errors
+static void make_bitmap(SkBitmap* bm, bool opaque) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, W, H);
+    bm->allocPixels();
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            unsigned a = opaque ? 0xFF : 0x80 + x;
+            *bm->getAddr32(x, y) = SkPreMultiplyARGB(a, x * 3, y * 4,
+                                                     (x + y) * 2);
+        }
+    }
+    bm->setIsOpaque(opaque);
+}
+
+static bool encode(const SkBitmap& bm, SkImageEncoder::Type type,
+                   SkDynamicMemoryWStream* stream) {
+    SkImageEncoder* encoder = SkImageEncoder::Create(type);
+    if (NULL == encoder) {
+        return false;
+    }
+    SkAutoTDelete<SkImageEncoder> ad(encoder);
+    return encoder->encodeStream(stream, bm, 100);
+}
+
+class RecordingRowListener : public SkImageDecoder::RowListener {
+public:
+    RecordingRowListener() : fNextY(0), fInOrder(true) {}
+
+    virtual bool onRowsDecoded(const SkBitmap& bitmap, int startY,
+                               int count) SK_OVERRIDE {
+        fInOrder &= (startY == fNextY);
+        fNextY = startY + count;
+        return true;
+    }
+
+    int     fNextY;
+    bool    fInOrder;
+};
+
+class StopListener : public SkImageDecoder::RowListener {
+public:
+    virtual bool onRowsDecoded(const SkBitmap&, int, int) SK_OVERRIDE {
+        return false;
+    }
+};
+
+static bool colors_match(SkPMColor a, SkPMColor b, int tolerance) {
+    return SkAbs32(SkGetPackedA32(a) - SkGetPackedA32(b)) <= tolerance &&
+           SkAbs32(SkGetPackedR32(a) - SkGetPackedR32(b)) <= tolerance &&
+           SkAbs32(SkGetPackedG32(a) - SkGetPackedG32(b)) <= tolerance &&
+           SkAbs32(SkGetPackedB32(a) - SkGetPackedB32(b)) <= tolerance;
+}
+
+static void test_region(skiatest::Reporter* reporter, SkImageDecoder* codec,
+                        SkStream* stream, const SkBitmap& full,
+                        const SkIRect& rect, int tolerance) {
+    int width, height;
+    REPORTER_ASSERT(reporter, codec->buildTileIndex(stream, &width, &height));
+    REPORTER_ASSERT(reporter, W == width && H == height);
+
+    SkBitmap region;
+    if (!codec->decodeRegion(&region, rect, SkBitmap::kARGB_8888_Config)) {
+        reporter->reportFailed(SkString("decodeRegion failed"));
+        return;
+    }
+    REPORTER_ASSERT(reporter, region.width() == rect.width() &&
+                              region.height() == rect.height());
+
+    SkAutoLockPixels alpRegion(region);
+    SkAutoLockPixels alpFull(full);
+    for (int y = 0; y < region.height(); ++y) {
+        for (int x = 0; x < region.width(); ++x) {
+            SkPMColor expected = *full.getAddr32(rect.fLeft + x, rect.fTop + y);
+            SkPMColor actual = *region.getAddr32(x, y);
+            if (!colors_match(actual, expected, tolerance)) {
+                SkString str;
+                str.printf("region (%d,%d) at (%d,%d): got %08x expected %08x",
+                           rect.fLeft, rect.fTop, x, y, actual, expected);
+                reporter->reportFailed(str);
+                return;
+            }
+        }
+    }
+}
+
+static void test_format(skiatest::Reporter* reporter, SkImageEncoder::Type type,
+                        bool opaque) {
+    SkBitmap src;
+    make_bitmap(&src, opaque);
+
+    SkDynamicMemoryWStream wStream;
+    if (!encode(src, type, &wStream)) {
+        reporter->reportFailed(SkString("failed to encode"));
+        return;
+    }
+    SkAutoDataUnref data(wStream.copyToData());
+    SkMemoryStream stream(data->data(), data->size());
+
+    SkImageDecoder* codec = SkImageDecoder::Factory(&stream);
+    REPORTER_ASSERT(reporter, codec);
+    if (NULL == codec) {
+        return;
+    }
+    SkAutoTDelete<SkImageDecoder> ad(codec);
+
+    // the full decode streams every row, in order
+    RecordingRowListener* listener = SkNEW(RecordingRowListener);
+    SkAutoUnref aur(listener);
+    codec->setRowListener(listener);
+
+    SkBitmap full;
+    REPORTER_ASSERT(reporter, stream.rewind());
+    REPORTER_ASSERT(reporter, codec->decode(&stream, &full,
+                                            SkBitmap::kARGB_8888_Config,
+                                            SkImageDecoder::kDecodePixels_Mode));
+    REPORTER_ASSERT(reporter, listener->fInOrder);
+    REPORTER_ASSERT(reporter, H == listener->fNextY);
+    codec->setRowListener(NULL);
+
+    // jpeg can't reproduce the full decode exactly, since the region doesn't
+    // start on the same block (and upsampling) boundaries
+    const int tolerance = SkImageEncoder::kJPEG_Type == type ? 8 : 0;
+
+    static const SkIRect gRects[] = {
+        { 0, 0, W, H },
+        { 0, 0, 16, 16 },
+        { 13, 7, 45, 38 },
+        { W - 10, H - 3, W, H },
+        { 5, 20, 6, 21 },
+    };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gRects); ++i) {
+        test_region(reporter, codec, &stream, full, gRects[i], tolerance);
+    }
+
+    // regions are clipped to the image
+    SkBitmap clipped;
+    REPORTER_ASSERT(reporter, codec->decodeRegion(&clipped,
+                                    SkIRect::MakeXYWH(W - 4, H - 4, 10, 10),
+                                    SkBitmap::kARGB_8888_Config));
+    REPORTER_ASSERT(reporter, 4 == clipped.width() && 4 == clipped.height());
+    REPORTER_ASSERT(reporter, !codec->decodeRegion(&clipped,
+                                    SkIRect::MakeXYWH(W, 0, 10, 10),
+                                    SkBitmap::kARGB_8888_Config));
+
+    // returning false from the listener stops the decode
+    StopListener* stop = SkNEW(StopListener);
+    SkAutoUnref aurStop(stop);
+    codec->setRowListener(stop);
+    SkBitmap stopped;
+    REPORTER_ASSERT(reporter, !codec->decodeRegion(&stopped,
+                                    SkIRect::MakeWH(10, 10),
+                                    SkBitmap::kARGB_8888_Config));
+    codec->setRowListener(NULL);
+}
+
+static void TestImageDecoding(skiatest::Reporter* reporter) {
+    test_format(reporter, SkImageEncoder::kPNG_Type, false);
+    test_format(reporter, SkImageEncoder::kPNG_Type, true);
+    test_format(reporter, SkImageEncoder::kJPEG_Type, true);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("ImageDecoding", ImageDecodingTestClass, TestImageDecoding)
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkColorPriv.h"
+#include "SkData.h"
+#include "SkImageDecoder.h"
+#include "SkImageEncoder.h"
+#include "SkRandom.h"
+#include "SkStream.h"
+
+// tall enough to be split into several bands/strips, and not a multiple of
+// the jpeg MCU size in either direction
+static const int W = 203;
+static const int H = 517;
+
+static void make_bitmap(SkBitmap* bm, SkBitmap::Config config, bool opaque) {
+    SkBitmap src;
+    src.setConfig(SkBitmap::kARGB_8888_Config, W, H);
+    src.allocPixels();
+    SkRandom rand;
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            // mostly smooth, with some noise so the png filters differ
+            unsigned a = opaque ? 0xFF : (x + y) & 0xFF;
+            unsigned noise = rand.nextU() & 7;
+            *src.getAddr32(x, y) = SkPreMultiplyARGB(a, x + noise, y & 0xFF,
+                                                     (x * y) & 0xFF);
+        }
+    }
+    src.setIsOpaque(opaque);
+    if (SkBitmap::kARGB_8888_Config == config) {
+        bm->swap(src);
+    } else {
+        src.copyTo(bm, config);
+    }
+}
+
+static SkData* encode(const SkBitmap& bm, SkImageEncoder::Type type,
+                      int threadCount) {
+    SkImageEncoder* encoder = SkImageEncoder::Create(type);
+    if (NULL == encoder) {
+        return NULL;
+    }
+    SkAutoTDelete<SkImageEncoder> ad(encoder);
+    encoder->setThreadCount(threadCount);
+
+    SkDynamicMemoryWStream stream;
+    if (!encoder->encodeStream(&stream, bm, 90)) {
+        return NULL;
+    }
+    return stream.copyToData();
+}
+
+static bool decode(SkData* data, SkBitmap* bm) {
+    return SkImageDecoder::DecodeMemory(data->data(), data->size(), bm,
+                                        SkBitmap::kARGB_8888_Config,
+                                        SkImageDecoder::kDecodePixels_Mode);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    if (a.width() != b.width() || a.height() != b.height()) {
+        return false;
+    }
+    SkAutoLockPixels alpA(a);
+    SkAutoLockPixels alpB(b);
+    for (int y = 0; y < a.height(); ++y) {
+        if (memcmp(a.getAddr32(0, y), b.getAddr32(0, y), a.width() * 4)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A multi-threaded encode must decode to exactly what the single threaded
+// encode does (the png is lossless, and the jpeg only adds restart markers).
+static void test_parallel(skiatest::Reporter* reporter,
+                          SkImageEncoder::Type type, SkBitmap::Config config,
+                          bool opaque) {
+    SkBitmap src;
+    make_bitmap(&src, config, opaque);
+
+    SkAutoDataUnref serialData(encode(src, type, 1));
+    REPORTER_ASSERT(reporter, serialData.get());
+    if (NULL == serialData.get()) {
+        return;
+    }
+    SkBitmap serial;
+    REPORTER_ASSERT(reporter, decode(serialData, &serial));
+
+    static const int gThreadCounts[] = { 2, 3, 8, 1000 };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gThreadCounts); ++i) {
+        SkAutoDataUnref data(encode(src, type, gThreadCounts[i]));
+        REPORTER_ASSERT(reporter, data.get());
+        if (NULL == data.get()) {
+            continue;
+        }
+        SkBitmap parallel;
+        if (!decode(data, &parallel)) {
+            SkString str;
+            str.printf("type %d config %d threads %d: failed to decode",
+                       type, config, gThreadCounts[i]);
+            reporter->reportFailed(str);
+            continue;
+        }
+        if (!same_pixels(serial, parallel)) {
+            SkString str;
+            str.printf("type %d config %d threads %d: pixels differ",
+                       type, config, gThreadCounts[i]);
+            reporter->reportFailed(str);
+        }
+    }
+}
+
+// Images too small to split still encode on the calling thread.
+static void test_small(skiatest::Reporter* reporter,
+                       SkImageEncoder::Type type) {
+    SkBitmap src;
+    src.setConfig(SkBitmap::kARGB_8888_Config, 5, 3);
+    src.allocPixels();
+    src.eraseColor(SK_ColorBLUE);
+
+    SkAutoDataUnref data(encode(src, type, 4));
+    REPORTER_ASSERT(reporter, data.get());
+    SkBitmap dst;
+    if (data.get()) {
+        REPORTER_ASSERT(reporter, decode(data, &dst));
+        REPORTER_ASSERT(reporter, 5 == dst.width() && 3 == dst.height());
+    }
+}
+
+static void TestImageEncoder(skiatest::Reporter* reporter) {
+    test_parallel(reporter, SkImageEncoder::kPNG_Type,
+                  SkBitmap::kARGB_8888_Config, false);
+    test_parallel(reporter, SkImageEncoder::kPNG_Type,
+                  SkBitmap::kARGB_8888_Config, true);
+    test_parallel(reporter, SkImageEncoder::kPNG_Type,
+                  SkBitmap::kRGB_565_Config, true);
+    test_parallel(reporter, SkImageEncoder::kPNG_Type,
+                  SkBitmap::kARGB_4444_Config, false);
+    test_parallel(reporter, SkImageEncoder::kJPEG_Type,
+                  SkBitmap::kARGB_8888_Config, true);
+    test_parallel(reporter, SkImageEncoder::kJPEG_Type,
+                  SkBitmap::kRGB_565_Config, true);
+    test_small(reporter, SkImageEncoder::kPNG_Type);
+    test_small(reporter, SkImageEncoder::kJPEG_Type);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("ImageEncoder", ImageEncoderTestClass, TestImageEncoder)
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+
+// This is a GPU-backend specific test
+#if SK_SUPPORT_GPU
+#include "GrContext.h"
+#include "GrContextFactory.h"
+#include "GrRenderTarget.h"
+#include "GrTexture.h"
+
+static const int kSize = 256;
+static const int kDrawCount = 64;
+
+static GrTexture* create_target(GrContext* context) {
+    GrTextureDesc desc;
+    desc.fFlags = kRenderTarget_GrTextureFlagBit;
+    desc.fConfig = kSkia8888_PM_GrPixelConfig;
+    desc.fWidth = kSize;
+    desc.fHeight = kSize;
+    return context->createUncachedTexture(desc, NULL, 0);
+}
+
+static GrRect rect_at(int i) {
+    GrRect rect;
+    rect.setXYWH(SkIntToScalar(i % 16 * 16), SkIntToScalar(i / 16 * 16),
+                 SkIntToScalar(10), SkIntToScalar(10));
+    return rect;
+}
+
+static void begin(GrContext* context) {
+    context->flush();
+    context->resetDrawStats();
+}
+
+static void check_stats(skiatest::Reporter* reporter, GrContext* context,
+                        int recorded, int merged, int issued) {
+    context->flush();
+    GrContext::DrawStats stats;
+    context->getDrawStats(&stats);
+    REPORTER_ASSERT(reporter, recorded == stats.fRecordedDraws);
+    REPORTER_ASSERT(reporter, merged == stats.fMergedDraws);
+    REPORTER_ASSERT(reporter, issued == stats.fIssuedDraws);
+}
+
+// Rects drawn with the same paint are issued as a single draw.
+static void test_rects(skiatest::Reporter* reporter, GrContext* context) {
+    GrPaint paint;
+    paint.reset();
+    paint.fColor = 0xFF0000FF;
+
+    begin(context);
+    for (int i = 0; i < kDrawCount; ++i) {
+        context->drawRect(paint, rect_at(i));
+    }
+    check_stats(reporter, context, kDrawCount, kDrawCount - 1, 1);
+
+    // Changing the color between rects changes the draw state, so each rect
+    // is its own draw.
+    begin(context);
+    for (int i = 0; i < kDrawCount; ++i) {
+        paint.fColor = (i & 1) ? 0xFF0000FF : 0xFF00FF00;
+        context->drawRect(paint, rect_at(i));
+    }
+    check_stats(reporter, context, kDrawCount, 0, kDrawCount);
+    GrContext::DrawStats stats;
+    context->getDrawStats(&stats);
+    REPORTER_ASSERT(reporter, stats.fStateChanges >= kDrawCount);
+}
+
+// Lists of triangles are merged, but strips aren't.
+static void test_vertices(skiatest::Reporter* reporter, GrContext* context) {
+    GrPaint paint;
+    paint.reset();
+
+    GrPoint pts[4];
+    begin(context);
+    for (int i = 0; i < kDrawCount; ++i) {
+        rect_at(i).toQuad(pts);
+        context->drawVertices(paint, kTriangles_GrPrimitiveType, 3, pts,
+                              NULL, NULL, NULL, 0);
+    }
+    check_stats(reporter, context, kDrawCount, kDrawCount - 1, 1);
+
+    begin(context);
+    for (int i = 0; i < kDrawCount; ++i) {
+        rect_at(i).toQuad(pts);
+        context->drawVertices(paint, kTriangleFan_GrPrimitiveType, 4, pts,
+                              NULL, NULL, NULL, 0);
+    }
+    check_stats(reporter, context, kDrawCount, 0, kDrawCount);
+
+    // Indices are relative to each draw's vertices, so indexed draws with
+    // their own indices aren't merged.
+    static const uint16_t kIndices[] = { 0, 1, 2, 0, 2, 3 };
+    begin(context);
+    for (int i = 0; i < kDrawCount; ++i) {
+        rect_at(i).toQuad(pts);
+        context->drawVertices(paint, kTriangles_GrPrimitiveType, 4, pts,
+                              NULL, NULL, kIndices, SK_ARRAY_COUNT(kIndices));
+    }
+    check_stats(reporter, context, kDrawCount, 0, kDrawCount);
+}
+
+// Runs on the debug GL interface, so it doesn't need a GPU.
+static void test_draw_buffer(skiatest::Reporter* reporter) {
+    GrContextFactory factory;
+    GrContext* context = factory.get(GrContextFactory::kDebug_GLContextType);
+    if (NULL == context) {
+        return;
+    }
+    SkAutoTUnref<GrTexture> texture(create_target(context));
+    if (NULL == texture.get()) {
+        return;
+    }
+    GrContext::AutoRenderTarget art(context, texture->asRenderTarget());
+    GrContext::AutoMatrix am(context, GrContext::AutoMatrix::kIdentity_InitialMatrix);
+    GrContext::AutoClip ac(context, GrContext::AutoClip::kWideOpen_InitialClip);
+
+    test_rects(reporter, context);
+    test_vertices(reporter, context);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("InOrderDrawBuffer", InOrderDrawBufferTestClass,
+                 test_draw_buffer)
+
+#endif
@@ -0,0 +1,220 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkGraphics.h"
+#include "SkMipMap.h"
+#include "SkPixelRef.h"
+#include "SkRandom.h"
+#include "SkShader.h"
+
+static void make_random_bitmap(SkBitmap* bm, int w, int h, SkRandom* rand) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, w, h);
+    bm->allocPixels();
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            unsigned a = rand->nextU() & 0xFF;
+            *bm->getAddr32(x, y) = SkPackARGB32(a, rand->nextULessThan(a + 1),
+                                                rand->nextULessThan(a + 1),
+                                                rand->nextULessThan(a + 1));
+        }
+    }
+}
+
+static void make_checker(SkBitmap* bm, int w, int h) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, w, h);
+    bm->allocPixels();
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            *bm->getAddr32(x, y) = ((x ^ y) & 1) ? SK_ColorWHITE :
+                                                   SK_ColorBLACK;
+        }
+    }
+}
+
+static void test_build(skiatest::Reporter* reporter) {
+    SkRandom rand;
+    SkBitmap bm;
+    make_random_bitmap(&bm, 37, 20, &rand);
+
+    SkAutoTUnref<SkMipMap> mip(SkMipMap::Build(bm));
+    REPORTER_ASSERT(reporter, mip.get());
+    if (NULL == mip.get()) {
+        return;
+    }
+    // 18x10, 9x5, 4x2, 2x1
+    REPORTER_ASSERT(reporter, 4 == mip->levelCount());
+
+    SkMipMap::Level level;
+    REPORTER_ASSERT(reporter, !mip->extractLevel(SK_Scalar1, false, &level));
+    REPORTER_ASSERT(reporter, !mip->extractLevel(SkFloatToScalar(1.9f), true,
+                                                 &level));
+
+    REPORTER_ASSERT(reporter, mip->extractLevel(SkFloatToScalar(1.9f), false,
+                                                &level));
+    REPORTER_ASSERT(reporter, 18 == level.fWidth && 10 == level.fHeight);
+
+    // every pixel of the first level is the box average of the original
+    bool ok = true;
+    for (int y = 0; y < 10 && ok; ++y) {
+        const SkPMColor* row = (const SkPMColor*)((const char*)level.fPixels +
+                                                  y * level.fRowBytes);
+        for (int x = 0; x < 18 && ok; ++x) {
+            SkPMColor c0 = *bm.getAddr32(2 * x, 2 * y);
+            SkPMColor c1 = *bm.getAddr32(2 * x + 1, 2 * y);
+            SkPMColor c2 = *bm.getAddr32(2 * x, 2 * y + 1);
+            SkPMColor c3 = *bm.getAddr32(2 * x + 1, 2 * y + 1);
+            for (int shift = 0; shift < 32; shift += 8) {
+                unsigned sum = ((c0 >> shift) & 0xFF) + ((c1 >> shift) & 0xFF) +
+                               ((c2 >> shift) & 0xFF) + ((c3 >> shift) & 0xFF);
+                ok &= ((row[x] >> shift) & 0xFF) == (sum >> 2);
+            }
+        }
+    }
+    REPORTER_ASSERT(reporter, ok);
+
+    // huge scales pick the smallest level
+    REPORTER_ASSERT(reporter, mip->extractLevel(SkIntToScalar(1000), true,
+                                                &level));
+    REPORTER_ASSERT(reporter, 2 == level.fWidth && 1 == level.fHeight);
+
+    // too small to have any levels
+    SkBitmap tiny;
+    make_random_bitmap(&tiny, 1, 20, &rand);
+    REPORTER_ASSERT(reporter, NULL == SkMipMap::Build(tiny));
+}
+
+// the platform's downsampler must match the portable one exactly
+static void test_platform_proc(skiatest::Reporter* reporter) {
+    SkMipMap::Downsample32Proc proc = SkMipMap::PlatformDownsample32Proc();
+    if (NULL == proc) {
+        return;
+    }
+
+    SkRandom rand;
+    uint32_t src0[2 * 19], src1[2 * 19], dst[19];
+    for (int i = 0; i < 2 * 19; ++i) {
+        src0[i] = rand.nextU();
+        src1[i] = rand.nextU();
+    }
+    for (int count = 1; count <= 19; ++count) {
+        proc(dst, src0, src1, count);
+        for (int i = 0; i < count; ++i) {
+            uint32_t expected = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                unsigned sum = ((src0[2 * i] >> shift) & 0xFF) +
+                               ((src0[2 * i + 1] >> shift) & 0xFF) +
+                               ((src1[2 * i] >> shift) & 0xFF) +
+                               ((src1[2 * i + 1] >> shift) & 0xFF);
+                expected |= (sum >> 2) << shift;
+            }
+            if (dst[i] != expected) {
+                SkString str;
+                str.printf("downsample count=%d [%d] got %08x expected %08x",
+                           count, i, dst[i], expected);
+                reporter->reportFailed(str);
+                return;
+            }
+        }
+    }
+}
+
+static void test_cache(skiatest::Reporter* reporter) {
+    SkRandom rand;
+    SkBitmap bm;
+    make_random_bitmap(&bm, 64, 64, &rand);
+
+    SkGraphics::PurgeMipMapCache();
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetMipMapCacheUsed());
+
+    SkAutoTUnref<SkMipMap> mip0(SkMipMap::FindOrBuildAndRef(bm));
+    SkAutoTUnref<SkMipMap> mip1(SkMipMap::FindOrBuildAndRef(bm));
+    REPORTER_ASSERT(reporter, mip0.get() && mip0.get() == mip1.get());
+    REPORTER_ASSERT(reporter, mip0->getSize() ==
+                              SkGraphics::GetMipMapCacheUsed());
+
+    // a subset is a different bitmap
+    SkBitmap subset;
+    SkIRect r = SkIRect::MakeXYWH(8, 8, 32, 32);
+    REPORTER_ASSERT(reporter, bm.extractSubset(&subset, r));
+    SkAutoTUnref<SkMipMap> mip2(SkMipMap::FindOrBuildAndRef(subset));
+    REPORTER_ASSERT(reporter, mip2.get() && mip2.get() != mip0.get());
+
+    // changing the pixels changes the generation ID, and so the mipmap
+    bm.notifyPixelsChanged();
+    SkAutoTUnref<SkMipMap> mip3(SkMipMap::FindOrBuildAndRef(bm));
+    REPORTER_ASSERT(reporter, mip3.get() && mip3.get() != mip0.get());
+
+    // nothing is cached beyond the limit
+    size_t prevLimit = SkGraphics::SetMipMapCacheLimit(mip0->getSize() - 1);
+    REPORTER_ASSERT(reporter, SkGraphics::GetMipMapCacheUsed() <
+                              mip0->getSize());
+    bm.notifyPixelsChanged();
+    REPORTER_ASSERT(reporter, NULL == SkMipMap::FindOrBuildAndRef(bm));
+
+    SkGraphics::SetMipMapCacheLimit(prevLimit);
+    REPORTER_ASSERT(reporter, prevLimit == SkGraphics::GetMipMapCacheLimit());
+    SkGraphics::PurgeMipMapCache();
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetMipMapCacheUsed());
+}
+
+// Minifying a 1 pixel checkerboard should come out a uniform gray, which
+// bilinear filtering of the full sized bitmap can't do.
+static void test_draw(skiatest::Reporter* reporter) {
+    SkBitmap bm, dev;
+    make_checker(&bm, 256, 256);
+    dev.setConfig(SkBitmap::kARGB_8888_Config, 32, 32);
+    dev.allocPixels();
+    dev.eraseColor(0);
+
+    SkGraphics::PurgeMipMapCache();
+
+    SkPaint paint;
+    paint.setFilterBitmap(true);
+    SkCanvas canvas(dev);
+    canvas.scale(SkFloatToScalar(0.1f), SkFloatToScalar(0.1f));
+    canvas.drawBitmap(bm, 0, 0, &paint);
+
+    REPORTER_ASSERT(reporter, SkGraphics::GetMipMapCacheUsed() > 0);
+
+    bool ok = true;
+    for (int y = 0; y < 25 && ok; ++y) {
+        for (int x = 0; x < 25 && ok; ++x) {
+            SkPMColor c = *dev.getAddr32(x, y);
+            ok = SkGetPackedA32(c) == 0xFF &&
+                 SkAbs32(SkGetPackedR32(c) - 0x80) <= 2 &&
+                 SkAbs32(SkGetPackedG32(c) - 0x80) <= 2 &&
+                 SkAbs32(SkGetPackedB32(c) - 0x80) <= 2;
+            if (!ok) {
+                SkString str;
+                str.printf("minified checker at (%d,%d): got %08x", x, y, c);
+                reporter->reportFailed(str);
+            }
+        }
+    }
+
+    // volatile bitmaps are not worth caching
+    SkGraphics::PurgeMipMapCache();
+    bm.setIsVolatile(true);
+    canvas.drawBitmap(bm, 0, 0, &paint);
+    REPORTER_ASSERT(reporter, 0 == SkGraphics::GetMipMapCacheUsed());
+}
+
+static void TestMipMap(skiatest::Reporter* reporter) {
+    test_build(reporter);
+    test_platform_proc(reporter);
+    test_cache(reporter);
+#ifdef SK_SCALAR_IS_FLOAT
+    test_draw(reporter);
+#endif
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("MipMap", MipMapTestClass, TestMipMap)
@@ -0,0 +1,101 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkData.h"
+#include "SkFlate.h"
+#include "SkPDFDevice.h"
+#include "SkPDFDocument.h"
+#include "SkStream.h"
+
+static const int kPageCount = 5;
+
+static void draw_page(SkPDFDevice* dev, int pageIndex) {
+    SkCanvas canvas(dev);
+    SkBitmap bm;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, 64, 64);
+    bm.allocPixels();
+    for (int y = 0; y < bm.height(); y++) {
+        for (int x = 0; x < bm.width(); x++) {
+            *bm.getAddr32(x, y) = SkPackARGB32(0xFF, x * 4, y * 4,
+                                               (x * y + pageIndex) & 0xFF);
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        canvas.drawBitmap(bm, SkIntToScalar(i * 70), SkIntToScalar(i * 20));
+    }
+
+    SkPaint paint;
+    paint.setColor(SK_ColorBLUE);
+    for (int i = 0; i < 50; i++) {
+        canvas.drawRectCoords(SkIntToScalar(i), SkIntToScalar(i * 3),
+                              SkIntToScalar(i + 10), SkIntToScalar(i * 3 + 2),
+                              paint);
+    }
+}
+
+static void add_page(SkPDFDocument* doc, int pageIndex) {
+    SkISize size = SkISize::Make(300, 300);
+    SkPDFDevice* dev = SkNEW_ARGS(SkPDFDevice, (size, size, SkMatrix::I()));
+    SkAutoUnref aur(dev);
+    draw_page(dev, pageIndex);
+    doc->appendPage(dev);
+}
+
+static SkData* make_pdf(int threadCount, int level, bool streaming) {
+    SkPDFDocument doc;
+    doc.setThreadCount(threadCount);
+    doc.setCompressionLevel(level);
+
+    SkDynamicMemoryWStream stream;
+    if (streaming) {
+        doc.beginStream(&stream);
+    }
+    for (int i = 0; i < kPageCount; i++) {
+        add_page(&doc, i);
+    }
+    if (streaming) {
+        doc.endStream();
+    } else {
+        doc.emitPDF(&stream);
+    }
+    return stream.copyToData();
+}
+
+static bool data_equals(const SkData* a, const SkData* b) {
+    return a->size() == b->size() && 0 == memcmp(a->data(), b->data(),
+                                                 a->size());
+}
+
+static void TestPDFCompression(skiatest::Reporter* reporter) {
+    for (int streaming = 0; streaming < 2; streaming++) {
+        SkAutoDataUnref serial(make_pdf(1, SkFlate::kDefault_CompressionLevel,
+                                        SkToBool(streaming)));
+        SkAutoDataUnref parallel(make_pdf(4,
+                                          SkFlate::kDefault_CompressionLevel,
+                                          SkToBool(streaming)));
+        // Compressing on several threads doesn't change the output.
+        REPORTER_ASSERT(reporter, data_equals(serial, parallel));
+
+        if (SkFlate::HaveFlate()) {
+            SkAutoDataUnref stored(make_pdf(4, SkFlate::kMin_CompressionLevel,
+                                            SkToBool(streaming)));
+            SkAutoDataUnref best(make_pdf(4, SkFlate::kMax_CompressionLevel,
+                                          SkToBool(streaming)));
+            REPORTER_ASSERT(reporter, stored->size() > serial->size());
+            REPORTER_ASSERT(reporter, best->size() <= serial->size());
+        }
+    }
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("PDFCompression", PDFCompressionTestClass,
+                 TestPDFCompression)
@@ -0,0 +1,151 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkData.h"
+#include "SkPDFDevice.h"
+
+static SkData* content_of(SkPDFDevice* dev) {
+    return dev->copyContentToData();
+}
+
+static int count_lines(const SkData* data, const char line[]) {
+    size_t len = strlen(line);
+    const char* bytes = (const char*)data->data();
+    int count = 0;
+    for (size_t i = 0; i + len <= data->size(); i++) {
+        if ((i == 0 || bytes[i - 1] == '\n') &&
+                0 == memcmp(bytes + i, line, len)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static SkPDFDevice* new_device() {
+    SkISize size = SkISize::Make(200, 200);
+    return SkNEW_ARGS(SkPDFDevice, (size, size, SkMatrix::I()));
+}
+
+// save()/restore() without a clip change doesn't change the clip.
+static void test_save_restore(skiatest::Reporter* reporter) {
+    SkPDFDevice* dev = new_device();
+    SkAutoUnref aur(dev);
+    SkCanvas canvas(dev);
+    SkPaint paint;
+    canvas.clipRect(SkRect::MakeWH(100, 100));
+    for (int i = 0; i < 5; i++) {
+        canvas.save();
+        canvas.translate(SkIntToScalar(i + 1), 0);
+        canvas.drawRectCoords(0, 0, 50, 50, paint);
+        canvas.restore();
+        canvas.drawRectCoords(SkIntToScalar(i), 50, 50, 100, paint);
+    }
+    SkAutoDataUnref content(content_of(dev));
+    // One push for the clip and one per translate.
+    REPORTER_ASSERT(reporter, count_lines(content, "q\n") == 6);
+    REPORTER_ASSERT(reporter, count_lines(content, "W n\n") == 1);
+    REPORTER_ASSERT(reporter, count_lines(content, "f\n") == 10);
+}
+
+// A clip added to the current one is applied without reapplying the outer
+// clip, and going back to the outer clip only pops the inner one.
+static void test_nested_clip(skiatest::Reporter* reporter) {
+    SkPDFDevice* dev = new_device();
+    SkAutoUnref aur(dev);
+    SkCanvas canvas(dev);
+    SkPaint paint;
+    canvas.clipRect(SkRect::MakeWH(150, 150));
+    canvas.drawRectCoords(0, 0, 50, 50, paint);
+    for (int i = 0; i < 3; i++) {
+        canvas.save();
+        SkPath path;
+        path.addCircle(SkIntToScalar(40 + i), 40, 30);
+        canvas.clipPath(path);
+        paint.setColor(SK_ColorRED);
+        canvas.drawRectCoords(0, 0, 80, 80, paint);
+        canvas.restore();
+        paint.setColor(SK_ColorBLACK);
+        canvas.drawRectCoords(SkIntToScalar(i), 0, 60, 60, paint);
+    }
+    SkAutoDataUnref content(content_of(dev));
+    // One push for the outer clip and one per inner clip.
+    REPORTER_ASSERT(reporter, count_lines(content, "q\n") == 4);
+    REPORTER_ASSERT(reporter, count_lines(content, "Q\n") == 4);
+    // The outer rect clip is only emitted once.
+    REPORTER_ASSERT(reporter, count_lines(content, "0 0 150 150 re\n") == 1);
+    REPORTER_ASSERT(reporter, count_lines(content, "W n\n") == 4);
+}
+
+// Deeply nested clips don't go over the PDF limit on the save depth.
+static void test_deep_clips(skiatest::Reporter* reporter) {
+    SkPDFDevice* dev = new_device();
+    SkAutoUnref aur(dev);
+    SkCanvas canvas(dev);
+    SkPaint paint;
+    for (int i = 0; i < 20; i++) {
+        canvas.save();
+        SkPath path;
+        path.addCircle(100, 100, SkIntToScalar(100 - i * 4));
+        canvas.clipPath(path);
+        canvas.translate(1, 0);
+        canvas.drawRectCoords(0, 0, 200, 200, paint);
+    }
+    SkAutoDataUnref content(content_of(dev));
+    const char* bytes = (const char*)content->data();
+    int depth = 0;
+    int maxDepth = 0;
+    for (size_t i = 0; i + 1 < content->size(); i++) {
+        if (i > 0 && bytes[i - 1] != '\n') {
+            continue;
+        }
+        if (bytes[i] == 'q' && bytes[i + 1] == '\n') {
+            depth++;
+            maxDepth = depth > maxDepth ? depth : maxDepth;
+        } else if (bytes[i] == 'Q' && bytes[i + 1] == '\n') {
+            depth--;
+        }
+    }
+    REPORTER_ASSERT(reporter, 0 == depth);
+    REPORTER_ASSERT(reporter, maxDepth <= 12);
+    REPORTER_ASSERT(reporter, count_lines(content, "f\n") == 20);
+}
+
+// Setting up a content entry that isn't drawn to doesn't emit its state.
+static void test_empty_entry(skiatest::Reporter* reporter) {
+    SkPDFDevice* dev = new_device();
+    SkAutoUnref aur(dev);
+    SkCanvas canvas(dev);
+    SkPaint paint;
+    canvas.drawRectCoords(0, 0, 50, 50, paint);
+
+    // The bitmap has no pixels, so nothing is drawn.
+    SkBitmap bm;
+    bm.setConfig(SkBitmap::kNo_Config, 10, 10);
+    canvas.translate(10, 10);
+    paint.setColor(SK_ColorRED);
+    canvas.drawBitmap(bm, 0, 0, &paint);
+
+    SkAutoDataUnref content(content_of(dev));
+    REPORTER_ASSERT(reporter, count_lines(content, "q\n") == 0);
+    REPORTER_ASSERT(reporter, count_lines(content, "1 0 0 RG") == 0);
+    REPORTER_ASSERT(reporter, count_lines(content, "f\n") == 1);
+}
+
+static void TestPDFContentStream(skiatest::Reporter* reporter) {
+    test_save_restore(reporter);
+    test_nested_clip(reporter);
+    test_deep_clips(reporter);
+    test_empty_entry(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("PDFContentStream", PDFContentStreamTestClass,
+                 TestPDFContentStream)
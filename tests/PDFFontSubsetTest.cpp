@@ -0,0 +1,464 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkData.h"
+#include "SkPDFFontSubsetter.h"
+#include "SkStream.h"
+#include "SkTypeface.h"
+
+static void append_u16(SkTDArray<uint8_t>* dst, uint16_t value) {
+    *dst->append() = value >> 8;
+    *dst->append() = value & 0xFF;
+}
+
+static void append_u32(SkTDArray<uint8_t>* dst, uint32_t value) {
+    append_u16(dst, value >> 16);
+    append_u16(dst, value & 0xFFFF);
+}
+
+static uint16_t read_u16(const uint8_t* p) {
+    return (p[0] << 8) | p[1];
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+    return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+struct Table {
+    uint32_t            fTag;
+    SkTDArray<uint8_t>  fData;
+};
+
+// Tables must be in tag order; checksums are left zero.
+static SkData* make_sfnt(uint32_t version, Table tables[], int count) {
+    SkTDArray<uint8_t> font;
+    append_u32(&font, version);
+    append_u16(&font, count);
+    append_u16(&font, 0);
+    append_u16(&font, 0);
+    append_u16(&font, 0);
+    uint32_t offset = 12 + 16 * count;
+    for (int i = 0; i < count; i++) {
+        append_u32(&font, tables[i].fTag);
+        append_u32(&font, 0);
+        append_u32(&font, offset);
+        append_u32(&font, tables[i].fData.count());
+        offset += SkAlign4(tables[i].fData.count());
+    }
+    for (int i = 0; i < count; i++) {
+        font.append(tables[i].fData.count(), tables[i].fData.begin());
+        while (font.count() & 3) {
+            *font.append() = 0;
+        }
+    }
+    return SkData::NewWithCopy(font.begin(), font.count());
+}
+
+static bool find_table(const SkData* font, uint32_t tag, const uint8_t** data,
+                       size_t* length) {
+    const uint8_t* bytes = font->bytes();
+    int count = read_u16(bytes + 4);
+    for (int i = 0; i < count; i++) {
+        const uint8_t* entry = bytes + 12 + 16 * i;
+        if (read_u32(entry) == tag) {
+            *data = bytes + read_u32(entry + 8);
+            *length = read_u32(entry + 12);
+            return true;
+        }
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static const int kGlyphCount = 5;
+static const int kCompositeGlyph = 4;
+
+// A unit square at x.
+static void append_simple_glyph(SkTDArray<uint8_t>* glyf, int x) {
+    append_u16(glyf, 1);             // numberOfContours
+    append_u16(glyf, x);             // bounds
+    append_u16(glyf, 0);
+    append_u16(glyf, x + 1);
+    append_u16(glyf, 1);
+    append_u16(glyf, 3);             // endPtsOfContours
+    append_u16(glyf, 0);             // instructionLength
+    for (int i = 0; i < 4; i++) {
+        *glyf->append() = 0x01;      // on curve, short vectors
+    }
+    static const int dx[] = { 0, 1, 0, -1 };
+    static const int dy[] = { 0, 0, 1, 0 };
+    append_u16(glyf, x);
+    for (int i = 1; i < 4; i++) {
+        append_u16(glyf, dx[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        append_u16(glyf, dy[i]);
+    }
+}
+
+// Glyphs 0 to 3 are simple, the last glyph is glyph 2 moved over.
+static SkData* make_truetype_font() {
+    Table tables[7];
+    int i = 0;
+
+    Table& glyfTable = tables[i++];
+    glyfTable.fTag = SkSetFourByteTag('g', 'l', 'y', 'f');
+    SkTDArray<uint16_t> offsets;
+    SkTDArray<uint8_t>* glyf = &glyfTable.fData;
+    for (int glyph = 0; glyph < kCompositeGlyph; glyph++) {
+        *offsets.append() = glyf->count();
+        append_simple_glyph(glyf, glyph * 2);
+    }
+    *offsets.append() = glyf->count();
+    append_u16(glyf, 0xFFFF);        // numberOfContours
+    append_u16(glyf, 10);            // bounds
+    append_u16(glyf, 0);
+    append_u16(glyf, 11);
+    append_u16(glyf, 1);
+    append_u16(glyf, 0x0002);        // ARGS_ARE_XY_VALUES
+    append_u16(glyf, 2);
+    *glyf->append() = 6;
+    *glyf->append() = 0;
+    *offsets.append() = glyf->count();
+
+    Table& head = tables[i++];
+    head.fTag = SkSetFourByteTag('h', 'e', 'a', 'd');
+    append_u32(&head.fData, 0x00010000);    // version
+    append_u32(&head.fData, 0x00010000);    // fontRevision
+    append_u32(&head.fData, 0);             // checkSumAdjustment
+    append_u32(&head.fData, 0x5F0F3CF5);    // magicNumber
+    append_u16(&head.fData, 0);             // flags
+    append_u16(&head.fData, 16);            // unitsPerEm
+    for (int j = 0; j < 4; j++) {
+        append_u32(&head.fData, 0);         // created, modified
+    }
+    append_u16(&head.fData, 0);             // bounds
+    append_u16(&head.fData, 0);
+    append_u16(&head.fData, 12);
+    append_u16(&head.fData, 1);
+    append_u16(&head.fData, 0);             // macStyle
+    append_u16(&head.fData, 8);             // lowestRecPPEM
+    append_u16(&head.fData, 2);             // fontDirectionHint
+    append_u16(&head.fData, 0);             // indexToLocFormat
+    append_u16(&head.fData, 0);             // glyphDataFormat
+
+    Table& hhea = tables[i++];
+    hhea.fTag = SkSetFourByteTag('h', 'h', 'e', 'a');
+    append_u32(&hhea.fData, 0x00010000);
+    append_u16(&hhea.fData, 1);             // ascender
+    append_u16(&hhea.fData, 0);             // descender
+    for (int j = 0; j < 13; j++) {
+        append_u16(&hhea.fData, 0);
+    }
+    append_u16(&hhea.fData, kGlyphCount);   // numberOfHMetrics
+
+    Table& hmtx = tables[i++];
+    hmtx.fTag = SkSetFourByteTag('h', 'm', 't', 'x');
+    for (int j = 0; j < kGlyphCount; j++) {
+        append_u16(&hmtx.fData, 2);
+        append_u16(&hmtx.fData, 0);
+    }
+
+    // A table that a PDF viewer doesn't need.
+    Table& kern = tables[i++];
+    kern.fTag = SkSetFourByteTag('k', 'e', 'r', 'n');
+    append_u32(&kern.fData, 0);
+
+    Table& loca = tables[i++];
+    loca.fTag = SkSetFourByteTag('l', 'o', 'c', 'a');
+    for (int j = 0; j < offsets.count(); j++) {
+        append_u16(&loca.fData, offsets[j] / 2);
+    }
+
+    Table& maxp = tables[i++];
+    maxp.fTag = SkSetFourByteTag('m', 'a', 'x', 'p');
+    append_u32(&maxp.fData, 0x00005000);
+    append_u16(&maxp.fData, kGlyphCount);
+
+    SkASSERT(i == SK_ARRAY_COUNT(tables));
+    return make_sfnt(0x00010000, tables, i);
+}
+
+static void get_glyph(const SkData* font, int glyph, const uint8_t** data,
+                      size_t* length) {
+    const uint8_t* loca;
+    const uint8_t* glyf;
+    size_t locaLength, glyfLength;
+    find_table(font, SkSetFourByteTag('l', 'o', 'c', 'a'), &loca, &locaLength);
+    find_table(font, SkSetFourByteTag('g', 'l', 'y', 'f'), &glyf, &glyfLength);
+    *data = glyf + read_u16(loca + glyph * 2) * 2;
+    *length = (read_u16(loca + glyph * 2 + 2) - read_u16(loca + glyph * 2)) * 2;
+}
+
+static bool same_glyph(const SkData* a, const SkData* b, int glyph) {
+    const uint8_t* aData;
+    const uint8_t* bData;
+    size_t aLength, bLength;
+    get_glyph(a, glyph, &aData, &aLength);
+    get_glyph(b, glyph, &bData, &bLength);
+    return aLength == bLength && 0 == memcmp(aData, bData, aLength);
+}
+
+static bool is_empty_glyph(const SkData* font, int glyph) {
+    const uint8_t* data;
+    size_t length;
+    get_glyph(font, glyph, &data, &length);
+    return 0 == length;
+}
+
+static void test_truetype(skiatest::Reporter* reporter) {
+    SkAutoDataUnref font(make_truetype_font());
+    SkTDArray<uint32_t> glyphs;
+    *glyphs.append() = 1;
+    *glyphs.append() = kCompositeGlyph;
+    *glyphs.append() = 100;  // out of range glyphs are ignored
+
+    SkData* subset = SkPDFFontSubsetter::SubsetTrueType(font, glyphs);
+    REPORTER_ASSERT(reporter, subset);
+    if (NULL == subset) {
+        return;
+    }
+    SkAutoDataUnref aud(subset);
+
+    // Glyph 0 is always kept, glyph 2 is part of the composite glyph.
+    REPORTER_ASSERT(reporter, same_glyph(font, subset, 0));
+    REPORTER_ASSERT(reporter, same_glyph(font, subset, 1));
+    REPORTER_ASSERT(reporter, same_glyph(font, subset, 2));
+    REPORTER_ASSERT(reporter, is_empty_glyph(subset, 3));
+    REPORTER_ASSERT(reporter, same_glyph(font, subset, kCompositeGlyph));
+    REPORTER_ASSERT(reporter, subset->size() < font->size());
+
+    const uint8_t* table;
+    size_t length;
+    REPORTER_ASSERT(reporter, !find_table(subset,
+                                          SkSetFourByteTag('k', 'e', 'r', 'n'),
+                                          &table, &length));
+    REPORTER_ASSERT(reporter, find_table(subset,
+                                         SkSetFourByteTag('h', 'm', 't', 'x'),
+                                         &table, &length));
+
+    // The whole font sums to the magic number.
+    uint32_t sum = 0;
+    for (size_t i = 0; i < subset->size(); i += 4) {
+        sum += read_u32(subset->bytes() + i);
+    }
+    REPORTER_ASSERT(reporter, 0xB1B0AFBA == sum);
+
+    // Not a TrueType font.
+    SkAutoDataUnref junk(SkData::NewWithCopy("junk", 4));
+    REPORTER_ASSERT(reporter,
+                    NULL == SkPDFFontSubsetter::SubsetTrueType(junk, glyphs));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void append_index(SkTDArray<uint8_t>* dst, const char* items[],
+                         int count) {
+    append_u16(dst, count);
+    *dst->append() = 1;             // offSize
+    int offset = 1;
+    *dst->append() = offset;
+    for (int i = 0; i < count; i++) {
+        offset += strlen(items[i]);
+        *dst->append() = offset;
+    }
+    for (int i = 0; i < count; i++) {
+        dst->append(strlen(items[i]), (const uint8_t*)items[i]);
+    }
+}
+
+static void append_int5(SkTDArray<uint8_t>* dst, int32_t value) {
+    *dst->append() = 29;
+    append_u32(dst, value);
+}
+
+// Each glyph is a horizontal line of a different length.
+static const char* gCharStrings[] = {
+    "\x8B\x8B\x15\xA0\x8B\x05\x0E",
+    "\x8B\x8B\x15\xA1\x8B\x05\x0E",
+    "\x8B\x8B\x15\xA2\x8B\x05\x0E",
+};
+
+static const int kCFFTopDictSize = 2 * 5 + 1 + 5 + 1;
+
+// A bare CFF font with a Private DICT and local subroutines.
+static SkData* make_cff_font() {
+    const char* names[] = { "Test" };
+    const char* subrs[] = { "\x0B" };  // return
+
+    SkTDArray<uint8_t> font;
+    *font.append() = 1;             // major
+    *font.append() = 0;             // minor
+    *font.append() = 4;             // hdrSize
+    *font.append() = 4;             // offSize
+    append_index(&font, names, 1);
+
+    // The Top DICT INDEX, String INDEX and Global Subr INDEX come next.
+    size_t charStrings = font.count() + 2 + 1 + 2 + kCFFTopDictSize + 2 + 2;
+    SkTDArray<uint8_t> charStringsIndex;
+    append_index(&charStringsIndex, gCharStrings,
+                 SK_ARRAY_COUNT(gCharStrings));
+    size_t privateDict = charStrings + charStringsIndex.count();
+
+    append_u16(&font, 1);
+    *font.append() = 1;
+    *font.append() = 1;
+    *font.append() = 1 + kCFFTopDictSize;
+    append_int5(&font, 6);          // Private size
+    append_int5(&font, privateDict);
+    *font.append() = 18;            // Private
+    append_int5(&font, charStrings);
+    *font.append() = 17;            // CharStrings
+    append_u16(&font, 0);           // String INDEX
+    append_u16(&font, 0);           // Global Subr INDEX
+    SkASSERT((size_t)font.count() == charStrings);
+    font.append(charStringsIndex.count(), charStringsIndex.begin());
+
+    append_int5(&font, 6);          // Subrs, relative to the Private DICT
+    *font.append() = 19;
+    append_index(&font, subrs, 1);
+    return SkData::NewWithCopy(font.begin(), font.count());
+}
+
+// Finds the offset operand of op in a DICT written by make_cff_font or the
+// subsetter (which both use five byte integers for offsets).
+static int32_t find_dict_offset(const uint8_t* dict, size_t length, int op) {
+    for (size_t i = 0; i + 5 < length; i++) {
+        if (29 == dict[i] && op == dict[i + 5]) {
+            return (int32_t)read_u32(dict + i + 1);
+        }
+    }
+    return -1;
+}
+
+static size_t get_index_item(const uint8_t* data, size_t index, int i,
+                             const uint8_t** item) {
+    int offSize = data[index + 2];
+    SkASSERT(1 == offSize || 2 == offSize);
+    int count = read_u16(data + index);
+    const uint8_t* offsets = data + index + 3;
+    const uint8_t* items = offsets + (count + 1) * offSize - 1;
+    int start = (1 == offSize) ? offsets[i] : read_u16(offsets + i * 2);
+    int end = (1 == offSize) ? offsets[i + 1] : read_u16(offsets + i * 2 + 2);
+    *item = items + start;
+    return end - start;
+}
+
+static void test_cff(skiatest::Reporter* reporter) {
+    SkAutoDataUnref font(make_cff_font());
+    SkTDArray<uint32_t> glyphs;
+    *glyphs.append() = 2;
+
+    SkData* subset = SkPDFFontSubsetter::SubsetCFF(font, glyphs);
+    REPORTER_ASSERT(reporter, subset);
+    if (NULL == subset) {
+        return;
+    }
+    SkAutoDataUnref aud(subset);
+    const uint8_t* data = subset->bytes();
+
+    // Header, Name INDEX ("Test"), then the Top DICT INDEX.
+    REPORTER_ASSERT(reporter, 0 == memcmp(data, font->data(), 4 + 3 + 2 + 4));
+    const uint8_t* topDict;
+    size_t topDictLength = get_index_item(data, 4 + 3 + 2 + 4, 0, &topDict);
+    int32_t charStrings = find_dict_offset(topDict, topDictLength, 17);
+    int32_t privateDict = find_dict_offset(topDict, topDictLength, 18);
+    REPORTER_ASSERT(reporter, charStrings > 0 && privateDict > 0);
+    if (charStrings <= 0 || privateDict <= 0) {
+        return;
+    }
+
+    REPORTER_ASSERT(reporter, SK_ARRAY_COUNT(gCharStrings) ==
+                              read_u16(data + charStrings));
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gCharStrings); i++) {
+        const uint8_t* charString;
+        size_t length = get_index_item(data, charStrings, i, &charString);
+        if (1 == i) {
+            // unused, so just endchar
+            REPORTER_ASSERT(reporter, 1 == length && 0x0E == charString[0]);
+        } else {
+            REPORTER_ASSERT(reporter, strlen(gCharStrings[i]) == length &&
+                                      0 == memcmp(charString, gCharStrings[i],
+                                                  length));
+        }
+    }
+
+    // The local subroutines are still found from the Private DICT.
+    int32_t subrs = find_dict_offset(data + privateDict, 6, 19);
+    REPORTER_ASSERT(reporter, 6 == subrs);
+    REPORTER_ASSERT(reporter, 1 == read_u16(data + privateDict + subrs));
+
+    // The CFF table of an OpenType font is subset the same way.
+    Table table;
+    table.fTag = SkSetFourByteTag('C', 'F', 'F', ' ');
+    table.fData.append(font->size(), font->bytes());
+    SkAutoDataUnref openType(make_sfnt(SkSetFourByteTag('O', 'T', 'T', 'O'),
+                                       &table, 1));
+    SkAutoDataUnref openTypeSubset(SkPDFFontSubsetter::SubsetCFF(openType,
+                                                                 glyphs));
+    REPORTER_ASSERT(reporter, openTypeSubset.get() &&
+                              openTypeSubset->equals(subset));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void test_cache(skiatest::Reporter* reporter) {
+    SkAutoDataUnref font(make_truetype_font());
+    SkMemoryStream* stream = SkNEW_ARGS(SkMemoryStream, (font->data(),
+                                                         font->size(), true));
+    SkTypeface* typeface = SkTypeface::CreateFromStream(stream);
+    stream->unref();
+    if (NULL == typeface) {
+        return;  // This font host can't load the font.
+    }
+    SkAutoUnref aur(typeface);
+    SkFontID fontID = SkTypeface::UniqueID(typeface);
+
+    SkTDArray<uint32_t> glyphs;
+    *glyphs.append() = 1;
+    SkTDArray<uint32_t> sameGlyphs;
+    *sameGlyphs.append() = 1;
+    *sameGlyphs.append() = 0;
+    *sameGlyphs.append() = 1;
+    SkTDArray<uint32_t> otherGlyphs;
+    *otherGlyphs.append() = 3;
+
+    SkAutoDataUnref first(SkPDFFontSubsetter::GetSubset(
+            fontID, SkPDFFontSubsetter::kTrueType_Format, glyphs));
+    REPORTER_ASSERT(reporter, first.get());
+    REPORTER_ASSERT(reporter, SkPDFFontSubsetter::GetCacheUsed() > 0);
+    SkAutoDataUnref second(SkPDFFontSubsetter::GetSubset(
+            fontID, SkPDFFontSubsetter::kTrueType_Format, sameGlyphs));
+    REPORTER_ASSERT(reporter, first.get() == second.get());
+    SkAutoDataUnref other(SkPDFFontSubsetter::GetSubset(
+            fontID, SkPDFFontSubsetter::kTrueType_Format, otherGlyphs));
+    REPORTER_ASSERT(reporter, other.get() && other.get() != first.get());
+
+    // Not a CFF font.
+    REPORTER_ASSERT(reporter, NULL == SkPDFFontSubsetter::GetSubset(
+            fontID, SkPDFFontSubsetter::kCFF_Format, glyphs));
+
+    size_t limit = SkPDFFontSubsetter::SetCacheLimit(0);
+    REPORTER_ASSERT(reporter, 0 == SkPDFFontSubsetter::GetCacheUsed());
+    SkPDFFontSubsetter::SetCacheLimit(limit);
+    SkAutoDataUnref third(SkPDFFontSubsetter::GetSubset(
+            fontID, SkPDFFontSubsetter::kTrueType_Format, glyphs));
+    REPORTER_ASSERT(reporter, third.get() && third.get() != first.get() &&
+                              third->equals(first));
+}
+
+static void TestPDFFontSubset(skiatest::Reporter* reporter) {
+    test_truetype(reporter);
+    test_cff(reporter);
+    test_cache(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("PDFFontSubset", PDFFontSubsetTestClass, TestPDFFontSubset)
@@ -0,0 +1,251 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkData.h"
+#include "SkImageEncoder.h"
+#include "SkImageRef_GlobalPool.h"
+#include "SkPaint.h"
+#include "SkPDFCatalog.h"
+#include "SkPDFDevice.h"
+#include "SkPDFDocument.h"
+#include "SkPDFImage.h"
+#include "SkStream.h"
+
+static const int W = 40;
+static const int H = 30;
+
+static void make_bitmap(SkBitmap* bm, int seed) {
+    bm->setConfig(SkBitmap::kARGB_8888_Config, W, H);
+    bm->allocPixels();
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            *bm->getAddr32(x, y) = SkPackARGB32(0xFF, x * 6, y * 8,
+                                                (seed + x + y) & 0xFF);
+        }
+    }
+    bm->setIsOpaque(true);
+}
+
+static SkData* emit(SkPDFObject* obj) {
+    SkPDFCatalog catalog(SkPDFDocument::kNoCompression_Flags);
+    SkDynamicMemoryWStream stream;
+    obj->emit(&stream, &catalog, false);
+    return stream.copyToData();
+}
+
+static bool contains(const SkData* data, const void* str, size_t len) {
+    for (size_t i = 0; i + len <= data->size(); i++) {
+        if (0 == memcmp(data->bytes() + i, str, len)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool contains(const SkData* data, const char str[]) {
+    return contains(data, str, strlen(str));
+}
+
+static int count_occurrences(const SkData* data, const char str[]) {
+    size_t len = strlen(str);
+    int count = 0;
+    for (size_t i = 0; i + len <= data->size(); i++) {
+        if (0 == memcmp(data->bytes() + i, str, len)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Emit a document with a page for each bitmap, streamed or not.
+static SkData* emit_pages(const SkBitmap* const bitmaps[], int count,
+                          bool stream) {
+    SkISize size = SkISize::Make(W, H);
+    SkPDFDocument doc(SkPDFDocument::kNoCompression_Flags);
+    SkDynamicMemoryWStream output;
+    if (stream) {
+        doc.beginStream(&output);
+    }
+    for (int i = 0; i < count; i++) {
+        SkAutoTUnref<SkPDFDevice> device(
+            SkNEW_ARGS(SkPDFDevice, (size, size, SkMatrix::I())));
+        SkCanvas canvas(device.get());
+        canvas.drawBitmap(*bitmaps[i], 0, 0);
+        doc.appendPage(device.get());
+    }
+    if (stream) {
+        doc.endStream();
+    } else {
+        doc.emitPDF(&output);
+    }
+    return output.copyToData();
+}
+
+static void test_canonical(skiatest::Reporter* reporter) {
+    SkPaint paint;
+    SkIRect bounds = SkIRect::MakeWH(W, H);
+
+    SkBitmap a, b, other;
+    make_bitmap(&a, 0);
+    make_bitmap(&b, 0);  // the same pixels in a different pixelref
+    make_bitmap(&other, 1);
+
+    SkPDFImage* imageA = SkPDFImage::CreateImage(a, bounds, paint);
+    SkAutoUnref aurA(imageA);
+    SkPDFImage* imageA2 = SkPDFImage::CreateImage(a, bounds, paint);
+    SkAutoUnref aurA2(imageA2);
+    SkPDFImage* imageB = SkPDFImage::CreateImage(b, bounds, paint);
+    SkAutoUnref aurB(imageB);
+    SkPDFImage* imageOther = SkPDFImage::CreateImage(other, bounds, paint);
+    SkAutoUnref aurOther(imageOther);
+    REPORTER_ASSERT(reporter, imageA && imageA2 && imageB && imageOther);
+    if (!imageA || !imageA2 || !imageB || !imageOther) {
+        return;
+    }
+    REPORTER_ASSERT(reporter, imageA->isImageOf(a, bounds));
+    REPORTER_ASSERT(reporter, !imageA->isImageOf(b, bounds));
+    REPORTER_ASSERT(reporter, imageA->matches(imageA2));
+    REPORTER_ASSERT(reporter, imageA->matches(imageB));
+    REPORTER_ASSERT(reporter, imageB->matches(imageA));
+    REPORTER_ASSERT(reporter, !imageA->matches(imageOther));
+
+    // different parts of the same bitmap are different images
+    SkPDFImage* subset = SkPDFImage::CreateImage(a, SkIRect::MakeWH(W / 2, H),
+                                                 paint);
+    SkAutoUnref aurSubset(subset);
+    REPORTER_ASSERT(reporter, subset && !subset->matches(imageA));
+
+    // once the pixels change, it's a new image
+    *b.getAddr32(0, 0) = SK_ColorWHITE;
+    b.notifyPixelsChanged();
+    SkPDFImage* changed = SkPDFImage::CreateImage(b, bounds, paint);
+    SkAutoUnref aurChanged(changed);
+    REPORTER_ASSERT(reporter, changed && !changed->matches(imageA));
+    REPORTER_ASSERT(reporter, !imageB->isImageOf(b, bounds));
+
+    // and the old image doesn't match the new contents of a either
+    *a.getAddr32(0, 0) = SK_ColorWHITE;
+    a.notifyPixelsChanged();
+    SkPDFImage* changedA = SkPDFImage::CreateImage(a, bounds, paint);
+    SkAutoUnref aurChangedA(changedA);
+    REPORTER_ASSERT(reporter, changedA && changed &&
+                              changedA->matches(changed));
+    REPORTER_ASSERT(reporter, changedA && !changedA->matches(imageA));
+}
+
+// The same pixels drawn on several pages are written once, whether or not
+// the document is streamed.
+static void test_document(skiatest::Reporter* reporter) {
+    SkBitmap a, b, other;
+    make_bitmap(&a, 0);
+    make_bitmap(&b, 0);
+    make_bitmap(&other, 1);
+    const SkBitmap* bitmaps[] = { &a, &b, &other, &a };
+    for (int stream = 0; stream < 2; stream++) {
+        SkAutoDataUnref output(emit_pages(bitmaps, SK_ARRAY_COUNT(bitmaps),
+                                          SkToBool(stream)));
+        REPORTER_ASSERT(reporter,
+                        2 == count_occurrences(output, "/Subtype /Image"));
+        REPORTER_ASSERT(reporter,
+                        4 == count_occurrences(output, "/Type /Page\n"));
+    }
+}
+
+static void test_jpeg_passthrough(skiatest::Reporter* reporter) {
+    SkBitmap src;
+    make_bitmap(&src, 2);
+    SkDynamicMemoryWStream encoded;
+    if (!SkImageEncoder::EncodeStream(&encoded, src,
+                                      SkImageEncoder::kJPEG_Type, 90)) {
+        return;  // no jpeg support
+    }
+    SkAutoDataUnref jpeg(encoded.copyToData());
+
+    SkMemoryStream* stream = SkNEW_ARGS(SkMemoryStream, (jpeg->data(),
+                                                       jpeg->size(), true));
+    SkAutoUnref aurStream(stream);
+    SkImageRef* pixelRef =
+        SkNEW_ARGS(SkImageRef_GlobalPool,
+                   (stream, SkBitmap::kARGB_8888_Config));
+    SkAutoUnref aurPixelRef(pixelRef);
+
+    SkBitmap decoded;
+    decoded.setConfig(SkBitmap::kARGB_8888_Config, W, H);
+    decoded.setPixelRef(pixelRef);
+
+    SkPaint paint;
+    SkPDFImage* image = SkPDFImage::CreateImage(
+        decoded, SkIRect::MakeWH(W, H), paint);
+    SkAutoUnref aurImage(image);
+    REPORTER_ASSERT(reporter, image);
+    if (image) {
+        SkAutoDataUnref output(emit(image));
+        REPORTER_ASSERT(reporter, contains(output, "/Filter /DCTDecode"));
+        REPORTER_ASSERT(reporter, contains(output, jpeg->data(),
+                                           jpeg->size()));
+    }
+
+    // only part of the image is drawn, so the pixels are used
+    SkPDFImage* part = SkPDFImage::CreateImage(
+        decoded, SkIRect::MakeWH(W / 2, H / 2), paint);
+    SkAutoUnref aurPart(part);
+    REPORTER_ASSERT(reporter, part);
+    if (part) {
+        SkAutoDataUnref output(emit(part));
+        REPORTER_ASSERT(reporter, !contains(output, "DCTDecode"));
+    }
+
+    // The same source is written from the JPEG again, but the same pixels
+    // in a bitmap that isn't a JPEG are not, so which image a document
+    // writes doesn't depend on which bitmap was drawn first.
+    SkPDFImage* again = SkPDFImage::CreateImage(
+        decoded, SkIRect::MakeWH(W, H), paint);
+    SkAutoUnref aurAgain(again);
+    // (copyTo() would keep the generation ID, i.e. the source.)
+    SkBitmap raw;
+    raw.setConfig(SkBitmap::kARGB_8888_Config, W, H);
+    raw.allocPixels();
+    {
+        SkAutoLockPixels lock(decoded);
+        REPORTER_ASSERT(reporter, decoded.getPixels());
+        if (decoded.getPixels()) {
+            memcpy(raw.getPixels(), decoded.getPixels(), raw.getSize());
+        }
+    }
+    SkPDFImage* rawImage = SkPDFImage::CreateImage(
+        raw, SkIRect::MakeWH(W, H), paint);
+    SkAutoUnref aurRawImage(rawImage);
+    REPORTER_ASSERT(reporter, image && again && rawImage);
+    if (image && again && rawImage) {
+        REPORTER_ASSERT(reporter, image->matches(again));
+        REPORTER_ASSERT(reporter, !image->matches(rawImage));
+        REPORTER_ASSERT(reporter, !rawImage->matches(image));
+    }
+
+    const SkBitmap* jpegFirst[] = { &decoded, &raw };
+    const SkBitmap* rawFirst[] = { &raw, &decoded };
+    SkAutoDataUnref jpegFirstOutput(emit_pages(jpegFirst, 2, false));
+    SkAutoDataUnref rawFirstOutput(emit_pages(rawFirst, 2, false));
+    REPORTER_ASSERT(reporter,
+                    1 == count_occurrences(jpegFirstOutput, "DCTDecode"));
+    REPORTER_ASSERT(reporter,
+                    1 == count_occurrences(rawFirstOutput, "DCTDecode"));
+}
+
+static void TestPDFImage(skiatest::Reporter* reporter) {
+    test_canonical(reporter);
+    test_document(reporter);
+    test_jpeg_passthrough(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("PDFImage", PDFImageTestClass, TestPDFImage)
@@ -0,0 +1,127 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkData.h"
+#include "SkGradientShader.h"
+#include "SkPDFDevice.h"
+#include "SkPDFDocument.h"
+#include "SkPicture.h"
+#include "SkStream.h"
+
+static const int kPictureCount = 9;
+
+static void draw_page(SkCanvas* canvas, int pageIndex) {
+    SkPaint paint;
+    paint.setAntiAlias(true);
+
+    SkPoint pts[] = { { 0, 0 }, { 100, SkIntToScalar(pageIndex * 10) } };
+    SkColor colors[] = { SK_ColorRED, SK_ColorBLUE };
+    paint.setShader(SkGradientShader::CreateLinear(pts, colors, NULL, 2,
+                                        SkShader::kClamp_TileMode))->unref();
+    canvas->drawRectCoords(0, 0, 100, 100, paint);
+    paint.setShader(NULL);
+
+    // Every other page uses the same bitmap contents.
+    SkBitmap bm;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, 16, 16);
+    bm.allocPixels();
+    for (int y = 0; y < 16; y++) {
+        for (int x = 0; x < 16; x++) {
+            *bm.getAddr32(x, y) = SkPackARGB32(0xFF, x * 16, y * 16,
+                                               (pageIndex & 1) * 0xFF);
+        }
+    }
+    canvas->drawBitmap(bm, 110, 10);
+
+    SkPath path;
+    path.moveTo(10, 110);
+    path.quadTo(SkIntToScalar(50 + pageIndex), 150, 90, 110);
+    paint.setStyle(SkPaint::kStroke_Style);
+    paint.setStrokeWidth(SkIntToScalar(pageIndex + 1));
+    paint.setAlpha(0x80 + pageIndex);
+    canvas->drawPath(path, paint);
+
+    SkString text;
+    text.printf("Page %d", pageIndex + 1);
+    paint.setStyle(SkPaint::kFill_Style);
+    paint.setColor(SK_ColorBLACK);
+    paint.setTextSize(SkIntToScalar(12 + pageIndex));
+    canvas->drawText(text.c_str(), text.size(), 10, 190, paint);
+}
+
+static SkData* make_pdf(SkPicture* const pictures[], int count,
+                        int threadCount, bool usePictures, bool streaming) {
+    SkPDFDocument doc;
+    doc.setThreadCount(threadCount);
+    SkDynamicMemoryWStream stream;
+    if (streaming) {
+        doc.beginStream(&stream);
+    }
+    if (usePictures) {
+        doc.appendPictures(pictures, count);
+    } else {
+        for (int i = 0; i < count; i++) {
+            SkISize size = SkISize::Make(pictures[i]->width(),
+                                         pictures[i]->height());
+            SkPDFDevice* dev = SkNEW_ARGS(SkPDFDevice, (size, size,
+                                                        SkMatrix::I()));
+            SkAutoUnref aur(dev);
+            SkCanvas canvas(dev);
+            pictures[i]->draw(&canvas);
+            doc.appendPage(dev);
+        }
+    }
+    if (streaming) {
+        doc.endStream();
+    } else {
+        doc.emitPDF(&stream);
+    }
+    return stream.copyToData();
+}
+
+static void TestPDFPictures(skiatest::Reporter* reporter) {
+    SkPicture pictures[kPictureCount];
+    for (int i = 0; i < kPictureCount; i++) {
+        SkCanvas* canvas = pictures[i].beginRecording(200 + i, 200);
+        draw_page(canvas, i);
+        pictures[i].endRecording();
+    }
+    // The last pages repeat the first ones.
+    SkPicture* pages[kPictureCount + 4];
+    for (size_t i = 0; i < SK_ARRAY_COUNT(pages); i++) {
+        pages[i] = &pictures[i % kPictureCount];
+    }
+    // and two pages in a row are the same.
+    pages[1] = pages[0];
+
+    for (int streaming = 0; streaming < 2; streaming++) {
+        SkAutoDataUnref serial(make_pdf(pages, SK_ARRAY_COUNT(pages), 1, false,
+                                        SkToBool(streaming)));
+        static const int gThreadCounts[] = { 1, 2, 4 };
+        for (size_t i = 0; i < SK_ARRAY_COUNT(gThreadCounts); i++) {
+            SkAutoDataUnref parallel(make_pdf(pages, SK_ARRAY_COUNT(pages),
+                                              gThreadCounts[i], true,
+                                              SkToBool(streaming)));
+            REPORTER_ASSERT(reporter, parallel->equals(serial));
+        }
+    }
+
+    // Appending after the document is emitted fails.
+    SkPDFDocument doc;
+    REPORTER_ASSERT(reporter, doc.appendPictures(pages, 1));
+    SkDynamicMemoryWStream stream;
+    REPORTER_ASSERT(reporter, doc.emitPDF(&stream));
+    REPORTER_ASSERT(reporter, !doc.appendPictures(pages, 1));
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("PDFPictures", PDFPicturesTestClass, TestPDFPictures)
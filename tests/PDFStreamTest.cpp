@@ -0,0 +1,193 @@
+
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkData.h"
+#include "SkPDFDevice.h"
+#include "SkPDFDocument.h"
+#include "SkStream.h"
+
+static const int kPageCount = 11;
+
+// Drawn on every page.
+static const SkBitmap& shared_bitmap() {
+    static SkBitmap gBitmap;
+    if (gBitmap.isNull()) {
+        gBitmap.setConfig(SkBitmap::kARGB_8888_Config, 8, 8);
+        gBitmap.allocPixels();
+        gBitmap.eraseARGB(0xFF, 0x10, 0x20, 0x30);
+    }
+    return gBitmap;
+}
+
+static void draw_page(SkPDFDevice* dev, int pageIndex) {
+    SkCanvas canvas(dev);
+    canvas.drawBitmap(shared_bitmap(), 150, 150);
+
+    SkPaint paint;
+    paint.setColor(SK_ColorRED);
+    canvas.drawRectCoords(10, 10, SkIntToScalar(100 + pageIndex), 50, paint);
+
+    SkBitmap bm;
+    bm.setConfig(SkBitmap::kARGB_8888_Config, 16, 16);
+    bm.allocPixels();
+    bm.eraseARGB(0xFF, pageIndex * 20, 0x80, 0x40);
+    canvas.drawBitmap(bm, 20, 60);
+
+    SkString text;
+    text.printf("Page %d", pageIndex + 1);
+    paint.setColor(SK_ColorBLACK);
+    paint.setTextSize(24);
+    canvas.drawText(text.c_str(), text.size(), 20, 120, paint);
+}
+
+static SkPDFDevice* new_page(int pageIndex) {
+    SkISize size = SkISize::Make(200, 200);
+    SkPDFDevice* dev = SkNEW_ARGS(SkPDFDevice, (size, size, SkMatrix::I()));
+    draw_page(dev, pageIndex);
+    return dev;
+}
+
+static bool append_page(SkPDFDocument* doc, int pageIndex) {
+    SkPDFDevice* dev = new_page(pageIndex);
+    SkAutoUnref aur(dev);
+    return doc->appendPage(dev);
+}
+
+static bool starts_with(const SkData* data, size_t offset, const char str[]) {
+    size_t len = strlen(str);
+    return offset + len <= data->size() &&
+           0 == memcmp(data->bytes() + offset, str, len);
+}
+
+// Returns the offset of the last occurence of str in data, or -1.
+static int find_last(const SkData* data, const char str[]) {
+    size_t len = strlen(str);
+    for (int i = (int)data->size() - (int)len; i >= 0; i--) {
+        if (starts_with(data, i, str)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int count_occurrences(const SkData* data, const char str[]) {
+    size_t len = strlen(str);
+    int count = 0;
+    for (size_t i = 0; i + len <= data->size(); i++) {
+        if (starts_with(data, i, str)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Check that the cross reference table points at each object, in order.
+static void check_xref(skiatest::Reporter* reporter, const SkData* data) {
+    REPORTER_ASSERT(reporter, starts_with(data, 0, "%PDF-1.4\n"));
+
+    int startxref = find_last(data, "startxref\n");
+    REPORTER_ASSERT(reporter, startxref > 0);
+    if (startxref <= 0) {
+        return;
+    }
+    const char* str = (const char*)data->bytes();
+    long xrefOffset = atol(str + startxref + strlen("startxref\n"));
+    REPORTER_ASSERT(reporter, starts_with(data, xrefOffset, "xref\n0 "));
+    if (!starts_with(data, xrefOffset, "xref\n0 ")) {
+        return;
+    }
+
+    const char* entry = str + xrefOffset + strlen("xref\n0 ");
+    int entries = atoi(entry);
+    REPORTER_ASSERT(reporter, entries > kPageCount * 2);
+    entry = strchr(entry, '\n') + 1;
+    // Skip the free entry for object 0; each entry is 20 bytes.
+    entry += 20;
+    for (int i = 1; i < entries; i++, entry += 20) {
+        long offset = atol(entry);
+        SkString expected;
+        expected.printf("%d 0 obj\n", i);
+        if (!starts_with(data, offset, expected.c_str())) {
+            SkString msg;
+            msg.printf("xref entry for object %d is wrong", i);
+            reporter->reportFailed(msg);
+            return;
+        }
+    }
+
+    SkString size;
+    size.printf("/Size %d", entries);
+    REPORTER_ASSERT(reporter, -1 != find_last(data, size.c_str()));
+    REPORTER_ASSERT(reporter, starts_with(data, data->size() - 5, "%%EOF"));
+}
+
+static void TestPDFStream(skiatest::Reporter* reporter) {
+    SkDynamicMemoryWStream streamed;
+    SkPDFDocument streamDoc(SkPDFDocument::kNoCompression_Flags);
+
+    // Nothing to stream to yet.
+    REPORTER_ASSERT(reporter, !streamDoc.endStream());
+    REPORTER_ASSERT(reporter, streamDoc.beginStream(&streamed));
+    REPORTER_ASSERT(reporter, !streamDoc.beginStream(&streamed));
+    REPORTER_ASSERT(reporter, !streamDoc.endStream());
+
+    SkDynamicMemoryWStream buffered;
+    SkPDFDocument bufferDoc(SkPDFDocument::kNoCompression_Flags);
+
+    size_t lastOffset = streamed.getOffset();
+    for (int i = 0; i < kPageCount; i++) {
+        REPORTER_ASSERT(reporter, append_page(&streamDoc, i));
+        REPORTER_ASSERT(reporter, append_page(&bufferDoc, i));
+        // Each page is written as soon as it is appended.
+        REPORTER_ASSERT(reporter, streamed.getOffset() > lastOffset);
+        lastOffset = streamed.getOffset();
+    }
+
+    // Pages can only be appended in order while streaming.
+    SkPDFDevice* dev = new_page(0);
+    SkAutoUnref aur(dev);
+    REPORTER_ASSERT(reporter, !streamDoc.setPage(1, dev));
+    REPORTER_ASSERT(reporter, !streamDoc.emitPDF(&buffered));
+
+    REPORTER_ASSERT(reporter, streamDoc.endStream());
+    REPORTER_ASSERT(reporter, !streamDoc.endStream());
+    REPORTER_ASSERT(reporter, !streamDoc.appendPage(dev));
+    REPORTER_ASSERT(reporter, bufferDoc.emitPDF(&buffered));
+
+    SkAutoDataUnref streamData(streamed.copyToData());
+    SkAutoDataUnref bufferData(buffered.copyToData());
+    check_xref(reporter, streamData);
+    check_xref(reporter, bufferData);
+
+    SkString count;
+    count.printf("/Count %d", kPageCount);
+    REPORTER_ASSERT(reporter, -1 != find_last(streamData, count.c_str()));
+    REPORTER_ASSERT(reporter, kPageCount ==
+                              count_occurrences(streamData, "/Type /Page\n"));
+    REPORTER_ASSERT(reporter, count_occurrences(streamData, "/Type /Font\n") ==
+                              count_occurrences(bufferData, "/Type /Font\n"));
+    // Resources shared between pages are written once.
+    REPORTER_ASSERT(reporter, kPageCount + 1 ==
+                              count_occurrences(streamData, "/Subtype /Image"));
+    REPORTER_ASSERT(reporter,
+                    count_occurrences(streamData, "/Type /ExtGState") ==
+                    count_occurrences(bufferData, "/Type /ExtGState"));
+
+    int streamFonts[SkAdvancedTypefaceMetrics::kNotEmbeddable_Font + 1];
+    int bufferFonts[SkAdvancedTypefaceMetrics::kNotEmbeddable_Font + 1];
+    streamDoc.getCountOfFontTypes(streamFonts);
+    bufferDoc.getCountOfFontTypes(bufferFonts);
+    REPORTER_ASSERT(reporter, 0 == memcmp(streamFonts, bufferFonts,
+                                          sizeof(streamFonts)));
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("PDFStream", PDFStreamTestClass, TestPDFStream)
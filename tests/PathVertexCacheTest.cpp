@@ -0,0 +1,167 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+
+// This is a GPU-backend specific test
+#if SK_SUPPORT_GPU
+#include "GrContext.h"
+#include "GrContextFactory.h"
+#include "GrPathVertexCache.h"
+#include "GrTexture.h"
+
+static void make_key(GrPathVertexCache::Key* key, uint32_t tag) {
+    memset(key, 0, sizeof(*key));
+    key->fTag = tag;
+}
+
+static void test_cache(skiatest::Reporter* reporter) {
+    GrPathVertexCache cache(64 * 1024);
+
+    SkPath circle;
+    circle.addCircle(10, 10, 5);
+    SkPath oval;
+    oval.addOval(SkRect::MakeWH(20, 10));
+
+    GrPathVertexCache::Key key;
+    make_key(&key, 1);
+    REPORTER_ASSERT(reporter, NULL == cache.find(circle, key));
+    REPORTER_ASSERT(reporter, 1 == cache.stats().fMisses);
+
+    GrPoint verts[100];
+    for (int i = 0; i < 100; ++i) {
+        verts[i].set(SkIntToScalar(i), SkIntToScalar(-i));
+    }
+    uint16_t indices[30];
+    for (int i = 0; i < 30; ++i) {
+        indices[i] = i;
+    }
+    GrVec origin = { 3, 4 };
+    cache.add(circle, key, kTriangles_GrPrimitiveType,
+              verts, sizeof(GrPoint), 100, indices, 30, origin);
+    REPORTER_ASSERT(reporter, 1 == cache.stats().fCount);
+
+    // a copy of the path finds the geometry, as it was added
+    SkPath copy(circle);
+    const GrPathVertexCache::Geometry* geom = cache.find(copy, key);
+    REPORTER_ASSERT(reporter, NULL != geom);
+    if (NULL != geom) {
+        REPORTER_ASSERT(reporter,
+                        kTriangles_GrPrimitiveType == geom->fPrimitiveType);
+        REPORTER_ASSERT(reporter, 100 == geom->fVertexCount);
+        REPORTER_ASSERT(reporter, 30 == geom->fIndexCount);
+        REPORTER_ASSERT(reporter, 3 == geom->fOrigin.fX);
+        REPORTER_ASSERT(reporter, 0 == memcmp(verts, geom->vertices(),
+                                              sizeof(verts)));
+        REPORTER_ASSERT(reporter, 0 == memcmp(indices, geom->indices(),
+                                              sizeof(indices)));
+    }
+    REPORTER_ASSERT(reporter, 1 == cache.stats().fHits);
+
+    // other paths and keys don't
+    REPORTER_ASSERT(reporter, NULL == cache.find(oval, key));
+    copy.offset(1, 0);
+    REPORTER_ASSERT(reporter, NULL == cache.find(copy, key));
+    GrPathVertexCache::Key otherKey;
+    make_key(&otherKey, 2);
+    REPORTER_ASSERT(reporter, NULL == cache.find(circle, otherKey));
+    otherKey = key;
+    otherKey.fMatrix[0] = 2;
+    REPORTER_ASSERT(reporter, NULL == cache.find(circle, otherKey));
+
+    // adding again replaces
+    cache.add(circle, key, kTriangleFan_GrPrimitiveType,
+              verts, sizeof(GrPoint), 50, NULL, 0, origin);
+    REPORTER_ASSERT(reporter, 1 == cache.stats().fCount);
+    geom = cache.find(circle, key);
+    REPORTER_ASSERT(reporter, NULL != geom && 50 == geom->fVertexCount);
+
+    // the least recently used geometry is purged to stay within budget
+    cache.add(oval, key, kTriangles_GrPrimitiveType,
+              verts, sizeof(GrPoint), 100, NULL, 0, origin);
+    REPORTER_ASSERT(reporter, 2 == cache.stats().fCount);
+    cache.setMaxBytes(cache.stats().fBytes - 1);
+    REPORTER_ASSERT(reporter, 1 == cache.stats().fCount);
+    REPORTER_ASSERT(reporter, 1 == cache.stats().fPurges);
+    REPORTER_ASSERT(reporter, NULL == cache.find(circle, key));
+    REPORTER_ASSERT(reporter, NULL != cache.find(oval, key));
+
+    // geometry too big for the budget isn't kept
+    cache.purgeAll();
+    cache.setMaxBytes(1024);
+    cache.add(circle, key, kTriangles_GrPrimitiveType,
+              verts, sizeof(GrPoint), 100, NULL, 0, origin);
+    REPORTER_ASSERT(reporter, 0 == cache.stats().fCount);
+    REPORTER_ASSERT(reporter, 0 == cache.stats().fBytes);
+}
+
+// A path drawn again, translated, reuses its vertices.
+static void test_context(skiatest::Reporter* reporter) {
+    GrContextFactory factory;
+    GrContext* context = factory.get(GrContextFactory::kDebug_GLContextType);
+    if (NULL == context) {
+        return;
+    }
+    GrTextureDesc desc;
+    desc.fFlags = kRenderTarget_GrTextureFlagBit;
+    desc.fConfig = kSkia8888_PM_GrPixelConfig;
+    desc.fWidth = 64;
+    desc.fHeight = 64;
+    SkAutoTUnref<GrTexture> texture(context->createUncachedTexture(desc,
+                                                                   NULL, 0));
+    if (NULL == texture.get()) {
+        return;
+    }
+    context->setRenderTarget(texture->asRenderTarget());
+
+    // (GrContext draws ovals without a path renderer)
+    SkPath path;
+    path.moveTo(10, 10);
+    path.quadTo(30, 0, 40, 20);
+    path.cubicTo(30, 40, 20, 20, 10, 30);
+    path.close();
+    GrPaint paint;
+    paint.reset();
+
+    GrContext::ResourceCacheStats stats;
+    context->getPathVertexCacheStats(&stats);
+    int hits = stats.fHits;
+
+    context->drawPath(paint, path, kWinding_GrPathFill);
+    GrPoint translate = { 5, 7 };
+    context->drawPath(paint, path, kWinding_GrPathFill, &translate);
+    context->drawPath(paint, path, kHairLine_GrPathFill);
+    context->flush();
+
+    context->getPathVertexCacheStats(&stats);
+    REPORTER_ASSERT(reporter, hits + 1 == stats.fHits);
+    REPORTER_ASSERT(reporter, 2 == stats.fCount);
+    REPORTER_ASSERT(reporter, stats.fBytes > 0);
+
+    // paths with no curves aren't worth keeping
+    SkPath rect;
+    rect.addRect(SkRect::MakeWH(10, 10));
+    context->drawPath(paint, rect, kEvenOdd_GrPathFill);
+    context->getPathVertexCacheStats(&stats);
+    REPORTER_ASSERT(reporter, 2 == stats.fCount);
+
+    context->freeGpuResources();
+    context->getPathVertexCacheStats(&stats);
+    REPORTER_ASSERT(reporter, 0 == stats.fCount);
+    context->setRenderTarget(NULL);
+}
+
+static void TestPathVertexCache(skiatest::Reporter* reporter) {
+    test_cache(reporter);
+    test_context(reporter);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("PathVertexCache", PathVertexCacheTestClass,
+                 TestPathVertexCache)
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+
+// This is a GPU-backend specific test
+#if SK_SUPPORT_GPU
+#include "GrContext.h"
+#include "GrContextFactory.h"
+#include "GrTexture.h"
+
+static void make_desc(GrTextureDesc* desc, int width) {
+    desc->fFlags = kNone_GrTextureFlags;
+    desc->fConfig = kSkia8888_PM_GrPixelConfig;
+    desc->fWidth = width;
+    desc->fHeight = 16;
+}
+
+// By default the scratch texture budget is half of the texture cache's bytes,
+// whatever the texture cache limits are set to, until it is set itself.
+static void test_default_scratch_budget(skiatest::Reporter* reporter,
+                                        GrContext* context) {
+    int maxTextures;
+    size_t maxTextureBytes;
+    context->getTextureCacheLimits(&maxTextures, &maxTextureBytes);
+
+    int maxScratch;
+    size_t maxScratchBytes;
+    context->getResourceCacheCategoryLimits(kScratchTexture_GrResourceCategory,
+                                            &maxScratch, &maxScratchBytes);
+    REPORTER_ASSERT(reporter, maxTextures == maxScratch);
+    REPORTER_ASSERT(reporter, maxTextureBytes / 2 == maxScratchBytes);
+
+    context->setTextureCacheLimits(2 * maxTextures, 4 * maxTextureBytes);
+    context->getResourceCacheCategoryLimits(kScratchTexture_GrResourceCategory,
+                                            &maxScratch, &maxScratchBytes);
+    REPORTER_ASSERT(reporter, 2 * maxTextures == maxScratch);
+    REPORTER_ASSERT(reporter, 2 * maxTextureBytes == maxScratchBytes);
+
+    context->setResourceCacheCategoryLimits(kScratchTexture_GrResourceCategory,
+                                            3, 1024);
+    context->setTextureCacheLimits(maxTextures, maxTextureBytes);
+    context->getResourceCacheCategoryLimits(kScratchTexture_GrResourceCategory,
+                                            &maxScratch, &maxScratchBytes);
+    REPORTER_ASSERT(reporter, 3 == maxScratch);
+    REPORTER_ASSERT(reporter, 1024 == maxScratchBytes);
+}
+
+// A category over its own budget gives up its resources, not other
+// categories'.
+static void test_category_budget(skiatest::Reporter* reporter,
+                                 GrContext* context) {
+    static const int kContentCount = 4;
+    for (int i = 0; i < kContentCount; ++i) {
+        GrTextureDesc desc;
+        make_desc(&desc, 16);
+        GrTexture* texture = context->createAndLockTexture(NULL, desc,
+                                                           GrCacheData(i),
+                                                           NULL, 0);
+        REPORTER_ASSERT(reporter, NULL != texture);
+        if (NULL != texture) {
+            context->unlockTexture(texture);
+        }
+    }
+
+    context->setResourceCacheCategoryLimits(kScratchTexture_GrResourceCategory,
+                                            2, (size_t) -1);
+
+    // Widths that bin to different sizes, so each is a new texture.
+    static const int kScratchCount = 4;
+    GrTexture* scratch[kScratchCount];
+    for (int i = 0; i < kScratchCount; ++i) {
+        GrTextureDesc desc;
+        make_desc(&desc, 32 << i);
+        scratch[i] = context->lockScratchTexture(desc,
+                                                 GrContext::kExact_ScratchTexMatch);
+        REPORTER_ASSERT(reporter, NULL != scratch[i]);
+    }
+    for (int i = 0; i < kScratchCount; ++i) {
+        if (NULL != scratch[i]) {
+            context->unlockTexture(scratch[i]);
+        }
+    }
+
+    GrContext::ResourceCacheStats stats;
+    context->getResourceCacheStats(kScratchTexture_GrResourceCategory, &stats);
+    REPORTER_ASSERT(reporter, 2 == stats.fCount);
+    REPORTER_ASSERT(reporter, kScratchCount - 2 == stats.fPurges);
+
+    context->getResourceCacheStats(kContentTexture_GrResourceCategory, &stats);
+    REPORTER_ASSERT(reporter, kContentCount == stats.fCount);
+    REPORTER_ASSERT(reporter, 0 == stats.fPurges);
+
+    int hits = stats.fHits;
+    int misses = stats.fMisses;
+    GrTextureDesc desc;
+    make_desc(&desc, 16);
+    GrTexture* texture = context->findAndLockTexture(desc, GrCacheData(0),
+                                                     NULL);
+    REPORTER_ASSERT(reporter, NULL != texture);
+    if (NULL != texture) {
+        context->unlockTexture(texture);
+    }
+    REPORTER_ASSERT(reporter, NULL == context->findAndLockTexture(
+                                          desc, GrCacheData(kContentCount),
+                                          NULL));
+    context->getResourceCacheStats(kContentTexture_GrResourceCategory, &stats);
+    REPORTER_ASSERT(reporter, hits + 1 == stats.fHits);
+    REPORTER_ASSERT(reporter, misses + 1 == stats.fMisses);
+
+    context->freeGpuResources();
+    context->getResourceCacheStats(kContentTexture_GrResourceCategory, &stats);
+    REPORTER_ASSERT(reporter, 0 == stats.fCount);
+    REPORTER_ASSERT(reporter, 0 == stats.fBytes);
+}
+
+static void TestResourceCache(skiatest::Reporter* reporter) {
+    GrContextFactory factory;
+    GrContext* context = factory.get(GrContextFactory::kDebug_GLContextType);
+    if (NULL == context) {
+        return;
+    }
+    test_default_scratch_budget(reporter, context);
+    test_category_budget(reporter, context);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("ResourceCache", ResourceCacheTestClass, TestResourceCache)
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+
+// This is a GPU-backend specific test
+#if SK_SUPPORT_GPU
+#include "DebugGLCanvas.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+
+static const int kSize = 256;
+
+static void make_star(SkPath* path, SkScalar radius) {
+    // concave, so only the software path renderer draws it anti-aliased
+    path->moveTo(radius, 0);
+    for (int i = 1; i < 5; ++i) {
+        SkScalar angle = SkIntToScalar(i * 4) * SK_ScalarPI / 5;
+        path->lineTo(radius + SkScalarMul(radius, SkScalarCos(angle)),
+                     radius + SkScalarMul(radius, SkScalarSin(angle)));
+    }
+    path->quadTo(radius, radius, radius, 0);
+    path->close();
+}
+
+static void get_counts(GrContext* context, int* rendered, int* found) {
+    context->flush();
+    GrContext::DrawStats stats;
+    context->getDrawStats(&stats);
+    *rendered = stats.fPathMasksRendered;
+    *found = stats.fPathMasksFound;
+}
+
+static void draw(SkCanvas* canvas, const SkPath& path,
+                 SkScalar dx, SkScalar dy) {
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    canvas->save();
+    canvas->translate(dx, dy);
+    canvas->drawPath(path, paint);
+    canvas->restore();
+}
+
+// Masks are found again for the same path, wherever it's drawn to the pixel.
+static void test_mask_cache(skiatest::Reporter* reporter) {
+    skiatest::DebugGLCanvas target(kSize, kSize);
+    if (!target.isValid()) {
+        return;
+    }
+    GrContext* context = target.context();
+    SkCanvas* canvas = target.canvas();
+
+    SkPath star;
+    make_star(&star, SkIntToScalar(20));
+    SkPath bigStar;
+    make_star(&bigStar, SkIntToScalar(200));
+
+    context->flush();
+    context->resetDrawStats();
+    int rendered, found;
+
+    draw(canvas, star, SkIntToScalar(10), SkIntToScalar(10));
+    get_counts(context, &rendered, &found);
+    REPORTER_ASSERT(reporter, 1 == rendered && 0 == found);
+
+    // the mask is kept the second time the path is drawn, and found after
+    // that, in the same frame and in the next
+    draw(canvas, star, SkIntToScalar(50), SkIntToScalar(10));
+    draw(canvas, star, SkIntToScalar(90), SkIntToScalar(90));
+    get_counts(context, &rendered, &found);
+    REPORTER_ASSERT(reporter, 2 == rendered && 1 == found);
+    draw(canvas, star, SkIntToScalar(10), SkIntToScalar(10));
+    get_counts(context, &rendered, &found);
+    REPORTER_ASSERT(reporter, 2 == rendered && 2 == found);
+
+    // but not at another subpixel offset, or scale
+    draw(canvas, star, SK_ScalarHalf, 0);
+    draw(canvas, star, SK_ScalarHalf, 0);
+    get_counts(context, &rendered, &found);
+    REPORTER_ASSERT(reporter, 4 == rendered && 2 == found);
+    canvas->save();
+    canvas->scale(2, 2);
+    draw(canvas, star, 0, 0);
+    canvas->restore();
+    get_counts(context, &rendered, &found);
+    REPORTER_ASSERT(reporter, 5 == rendered && 2 == found);
+
+    // big masks aren't kept
+    draw(canvas, bigStar, 0, 0);
+    draw(canvas, bigStar, 0, 0);
+    draw(canvas, bigStar, 0, 0);
+    get_counts(context, &rendered, &found);
+    REPORTER_ASSERT(reporter, 8 == rendered && 2 == found);
+
+    // nor masks purged from the texture cache
+    context->freeGpuResources();
+    context->resetDrawStats();
+    draw(canvas, star, SkIntToScalar(10), SkIntToScalar(10));
+    draw(canvas, star, SkIntToScalar(10), SkIntToScalar(10));
+    get_counts(context, &rendered, &found);
+    REPORTER_ASSERT(reporter, 2 == rendered && 0 == found);
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("SoftwarePathRenderer", SoftwarePathRendererTestClass,
+                 test_mask_cache)
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2012 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Test.h"
+
+// This is a GPU-backend specific test
+#if SK_SUPPORT_GPU
+#include "DebugGLCanvas.h"
+#include "SkPaint.h"
+
+static const int kSize = 256;
+static const int kDrawCount = 16;
+static const char kText[] = "Hamburgefons";
+
+static void begin(GrContext* context) {
+    context->flush();
+    context->resetDrawStats();
+}
+
+static int recorded_draws(GrContext* context) {
+    context->flush();
+    GrContext::DrawStats stats;
+    context->getDrawStats(&stats);
+    return stats.fRecordedDraws;
+}
+
+static void draw_text(SkCanvas* canvas, int i, const SkPaint& paint) {
+    canvas->drawText(kText, sizeof(kText) - 1, SkIntToScalar(10),
+                     SkIntToScalar(16 + i * 14), paint);
+}
+
+// Consecutive text draws with the same paint are drawn together.
+static void test_text_batch(skiatest::Reporter* reporter) {
+    skiatest::DebugGLCanvas target(kSize, kSize);
+    if (!target.isValid()) {
+        return;
+    }
+    GrContext* context = target.context();
+    SkCanvas* canvas = target.canvas();
+
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setTextSize(SkIntToScalar(12));
+
+    // put the glyphs in the atlas
+    draw_text(canvas, 0, paint);
+
+    begin(context);
+    for (int i = 0; i < kDrawCount; ++i) {
+        draw_text(canvas, i, paint);
+    }
+    REPORTER_ASSERT(reporter, 1 == recorded_draws(context));
+
+    // positions are in device space, so moving the canvas doesn't matter
+    begin(context);
+    for (int i = 0; i < kDrawCount; ++i) {
+        canvas->save();
+        canvas->translate(SkIntToScalar(i), 0);
+        draw_text(canvas, i, paint);
+        canvas->restore();
+    }
+    REPORTER_ASSERT(reporter, 1 == recorded_draws(context));
+
+    // other draws come between the text they were made between
+    begin(context);
+    draw_text(canvas, 0, paint);
+    canvas->drawRect(SkRect::MakeWH(10, 10), paint);
+    draw_text(canvas, 1, paint);
+    REPORTER_ASSERT(reporter, 3 == recorded_draws(context));
+
+    // as does a change of color or clip
+    begin(context);
+    for (int i = 0; i < kDrawCount; ++i) {
+        paint.setColor((i & 1) ? SK_ColorBLACK : SK_ColorBLUE);
+        draw_text(canvas, i, paint);
+    }
+    REPORTER_ASSERT(reporter, kDrawCount == recorded_draws(context));
+
+    paint.setColor(SK_ColorBLACK);
+    begin(context);
+    draw_text(canvas, 0, paint);
+    canvas->save();
+    canvas->clipRect(SkRect::MakeWH(100, 100));
+    draw_text(canvas, 1, paint);
+    canvas->restore();
+    REPORTER_ASSERT(reporter, 2 == recorded_draws(context));
+}
+
+#include "TestClassDef.h"
+DEFINE_TESTCLASS("TextBatch", TextBatchTestClass, test_text_batch)
+
+#endif